@@ -73,6 +73,31 @@ buddy_parameter_t default_buddy_parameter = {
 
 char *buddy_error_file = "/tmp/ganesha.buddy_malloc.log";
 
+/* Size classes for small blocks, served by per-thread slab caches
+ * instead of splitting/merging buddy blocks (multiples of 8 bytes).
+ */
+#define BUDDY_SLAB_NB_CLASSES  12
+#define BUDDY_SLAB_MAX_SIZE    1024
+
+static const size_t SlabClassSize[BUDDY_SLAB_NB_CLASSES] = {
+  16, 32, 48, 64, 96, 128, 192, 256, 384, 512, 768, 1024
+};
+
+/* A slab is a buddy block of (at most) 2^BUDDY_SLAB_LOG2_SIZE bytes */
+#define BUDDY_SLAB_LOG2_SIZE   15
+
+/* Don't use slabs for a size class if they can't hold this many objects */
+#define BUDDY_SLAB_MIN_OBJECTS 8
+
+/* Number of empty slabs kept for each size class */
+#define BUDDY_SLAB_KEEP_EMPTY  1
+
+/* Number of freed objects a thread keeps for each size class */
+#define BUDDY_MAGAZINE_SIZE    32
+
+/* Number of objects released for another thread before handing them back */
+#define BUDDY_REMOTE_BATCH     32
+
 /* ------------------------------------------*
  * Internal datatypes for memory management.
  * ------------------------------------------*/
@@ -81,7 +106,8 @@ char *buddy_error_file = "/tmp/ganesha.buddy_malloc.log";
 typedef enum BuddyBlockStatus_t
 {
   FREE_BLOCK,
-  RESERVED_BLOCK
+  RESERVED_BLOCK,
+  SLAB_BLOCK                    /* reserved object inside a slab */
 } BuddyBlockStatus_t;
 
 typedef struct StdBlockInfo_t
@@ -100,6 +126,14 @@ typedef struct StdBlockInfo_t
 
 } StdBlockInfo_t;
 
+typedef struct SlabBlockInfo_t
+{
+
+  /* slab this object was carved from */
+  struct BuddySlab_t *Slab;
+
+} SlabBlockInfo_t;
+
 /** Pointer to a buddy block descriptor. */
 typedef struct BuddyBlock_t *BuddyBlockPtr_t;
 
@@ -140,6 +174,7 @@ typedef struct BuddyHeader_t
   {
     StdBlockInfo_t StdInfo;
     size_t ExtraInfo;
+    SlabBlockInfo_t SlabInfo;
   } BlockInfo;
 
   /* Indicate the status for this block. */
@@ -150,6 +185,7 @@ typedef struct BuddyHeader_t
 /* aliases */
 #define StdInfo BlockInfo.StdInfo
 #define ExtraInfo BlockInfo.ExtraInfo
+#define SlabInfo BlockInfo.SlabInfo
 
 /** Content of a free buddy block (without header)  */
 typedef struct BuddyFreeBlockInfo_t
@@ -184,6 +220,59 @@ typedef struct BuddyBlock_t
 #define BUDDY_MAX_LOG2_SIZE  64
 /* allowed buddyMalloc sizes are from 2^0 to 2^63 */
 
+/**
+ * Slab descriptor.
+ * A slab is a standard buddy block whose user space starts with
+ * this descriptor, followed by objects of a single size class.
+ * Each object keeps a buddy header, so that BuddyFree, BuddyCheck
+ * and debug labels handle them like any other block.
+ */
+typedef struct BuddySlab_t
+{
+
+  /* buddy block that holds this slab */
+  BuddyBlock_t *Block;
+
+  /* size class of the objects */
+  unsigned int SizeClass;
+
+  /* objects out of the slab (used, or in the thread's magazine) */
+  unsigned int NbUsed;
+
+  /* objects carved so far, the next ones have never been used */
+  unsigned int NbCarved;
+
+  /* objects given back to this slab */
+  BuddyBlock_t *FreeList;
+
+  /* list of the slabs that have free objects */
+  struct BuddySlab_t *Next;
+  struct BuddySlab_t *Prev;
+
+} BuddySlab_t;
+
+/** Per-thread cache for a size class */
+typedef struct BuddySlabCache_t
+{
+
+  /* magazine: objects recently freed by this thread (LIFO) */
+  BuddyBlock_t *Magazine[BUDDY_MAGAZINE_SIZE];
+  unsigned int NbMagazine;
+
+  /* slabs that have free objects */
+  BuddySlab_t *Partial;
+
+  /* number of empty slabs in the partial list */
+  unsigned int NbEmpty;
+
+  /* size of an object, including its header */
+  size_t Stride;
+
+  /* objects per slab (0 if this class is not served by slabs) */
+  unsigned int ObjPerSlab;
+
+} BuddySlabCache_t;
+
 /** Thread context */
 typedef struct BuddyThreadContext_t
 {
@@ -206,10 +295,21 @@ typedef struct BuddyThreadContext_t
   /* Error code for this thread */
   int Errno;
 
+  /* Slab caches for small blocks (slabs are 2^SlabLog2 blocks) */
+  unsigned int SlabLog2;
+  BuddySlabCache_t SlabCache[BUDDY_SLAB_NB_CLASSES];
+
 #ifndef _MONOTHREAD_MEMALLOC
   pthread_mutex_t ToBeFreed_mutex;
   BuddyBlock_t *ToBeFreed_list;
   int destroy_pending; /* protected by the same mutex */
+
+  /* slab objects this thread released for another one,
+   * handed back to their owner by batches */
+  struct BuddyThreadContext_t *Remote_owner;
+  BuddyBlock_t *Remote_head;
+  BuddyBlock_t *Remote_tail;
+  unsigned int Remote_count;
 #endif
 
 #ifdef _DEBUG_MEMLEAKS
@@ -755,6 +855,42 @@ static void UpdateStats_RemoveExtraPage(BuddyThreadContext_t * context, size_t a
 
 }
 
+/**
+ * UpdateStats_UseSlabSpace:
+ * update statistics to remember that a slab object has been
+ * given to a client.
+ */
+static void UpdateStats_UseSlabSpace(BuddyThreadContext_t * context, size_t amount)
+{
+
+  if(!context)
+    return;
+
+  context->Stats.SlabUsedSpace += amount;
+
+  if(context->Stats.SlabUsedSpace > context->Stats.WM_SlabUsedSpace)
+    context->Stats.WM_SlabUsedSpace = context->Stats.SlabUsedSpace;
+
+  return;
+
+}
+
+/**
+ * UpdateStats_FreeSlabSpace:
+ * update statistics to remember that a slab object has been freed.
+ */
+static void UpdateStats_FreeSlabSpace(BuddyThreadContext_t * context, size_t amount)
+{
+
+  if(!context)
+    return;
+
+  context->Stats.SlabUsedSpace -= amount;
+
+  return;
+
+}
+
 /**
  *  NewStdPage :
  *  Adds a new page (with standard size) to the pool.
@@ -937,6 +1073,528 @@ void FreeLargeBlock(BuddyThreadContext_t * context, BuddyBlock_t * p_block)
 
 }
 
+/* Macro used to determine if it is an object inside a slab */
+#define IS_SLAB_BLOCK( _p_block_ ) ( (_p_block_)->Header.status == SLAB_BLOCK )
+
+/**
+ * AllocStdBlock:
+ * Reserves a block of size 2^sizelog2 in the standard pages,
+ * splitting larger free blocks if needed.
+ * Debug labels are left to the caller.
+ */
+static BuddyBlock_t *AllocStdBlock(BuddyThreadContext_t * context,
+                                   unsigned int sizelog2, size_t Size,
+                                   int do_exit_on_error)
+{
+
+  unsigned int i;
+  BuddyBlock_t *p_block;
+
+  i = sizelog2;
+
+  LogFullDebug(COMPONENT_MEMALLOC, "We have to alloc 2^%u\n", i);
+
+  /* It is a standard block, we look for a large enough block 
+   * in the block pool.
+   */
+
+  while((i < BUDDY_MAX_LOG2_SIZE) && (!context->MemDesc[i]))
+    {
+      i++;
+    }
+
+  LogFullDebug(COMPONENT_MEMALLOC, "i=%u\n", i);
+
+  if(i < BUDDY_MAX_LOG2_SIZE)
+    {
+      /* 1st case : a block is available */
+      p_block = context->MemDesc[i];
+    }
+  else if(context->Config.on_demand_alloc)
+    {
+      /* 2nd case :
+       * No memory block available.
+       * If the on_demand_alloc option has been set,
+       * We can allocate a new page.
+       */
+
+      /* add a new page */
+      p_block = NewStdPage(context);
+
+      if(!p_block)
+        {
+          context->Errno = BUDDY_ERR_MALLOC;
+
+          LogEvent(COMPONENT_MEMALLOC,
+                   "BuddyMalloc: NOT ENOUGH MEMORY !!!\n");
+
+          if(do_exit_on_error)
+            exit(1);
+
+          return NULL;
+        }
+
+    }
+  else
+    {
+      /* Out of memory */
+      LogFullDebug(COMPONENT_MEMALLOC, "%p:BuddyMalloc(%llu) => BUDDY_ERR_OUTOFMEM (on_demand_alloc disabled).\n",
+                   (BUDDY_ADDR_T) pthread_self(), (unsigned long long)Size);
+
+      if(do_exit_on_error)
+        exit(1);
+
+      context->Errno = BUDDY_ERR_OUTOFMEM;
+      return NULL;
+
+    }
+
+  /* removes the selected block from the pool of free blocks. */
+
+  Remove_FreeBlock(context, p_block);
+
+  /* If it was a whole page, we notice that it becomes used */
+
+  if((p_block->Header.Base_ptr == (BUDDY_ADDR_T) p_block)
+     && (p_block->Header.StdInfo.Base_kSize == p_block->Header.StdInfo.k_size))
+    {
+
+      UpdateStats_UseStdPage(context);
+
+    }
+
+  /* Iteratively splits the block. */
+
+  while(p_block->Header.StdInfo.k_size > sizelog2)
+    {
+
+      BuddyBlock_t *p_buddy;
+
+      /* divides the main block into 2 smaller blocks */
+      p_block->Header.StdInfo.k_size--;
+
+      p_buddy = Get_BuddyBlock(context, p_block);
+
+      /* herits from the same parent */
+
+      p_buddy->Header.Base_ptr = p_block->Header.Base_ptr;
+      p_buddy->Header.StdInfo.Base_kSize = p_block->Header.StdInfo.Base_kSize;
+
+      /* new block is free */
+      p_buddy->Header.status = FREE_BLOCK;
+      p_buddy->Header.MagicNumber = MAGIC_NUMBER_FREE;
+
+      p_buddy->Header.StdInfo.k_size = p_block->Header.StdInfo.k_size;
+
+      /* insert block into the free list */
+      Insert_FreeBlock(context, p_buddy);
+
+    }
+
+  /* Finally, we have the block to be reserved  */
+  p_block->Header.status = RESERVED_BLOCK;
+
+  p_block->Header.MagicNumber = MAGIC_NUMBER_USED;
+  p_block->Header.OwnerThread = pthread_self();
+
+#ifndef _MONOTHREAD_MEMALLOC
+  p_block->Header.OwnerThreadContext = context;
+#endif
+
+  /* update stats to remember we use this amount of memory */
+  UpdateStats_UseStdMemSpace(context, 1 << sizelog2);
+
+  return p_block;
+
+}                               /* AllocStdBlock */
+
+/**
+ * ReleaseStdBlock:
+ * Gives a block back to the standard pages,
+ * merging it with its free buddies.
+ */
+static void ReleaseStdBlock(BuddyThreadContext_t * context, BuddyBlock_t * p_block)
+{
+  BuddyBlock_t *p_block_tmp;
+
+  /* mark it free */
+
+  p_block->Header.status = FREE_BLOCK;
+  p_block->Header.MagicNumber = MAGIC_NUMBER_FREE;
+
+  UpdateStats_FreeStdMemSpace(context, 1 << p_block->Header.StdInfo.k_size);
+
+  /* merge free blocks. */
+
+  for(p_block_tmp = p_block;
+      p_block_tmp->Header.StdInfo.k_size < p_block_tmp->Header.StdInfo.Base_kSize;
+      p_block_tmp->Header.StdInfo.k_size++)
+    {
+
+      BuddyBlock_t *p_buddy;
+
+      p_buddy = Get_BuddyBlock(context, p_block_tmp);
+
+      LogFullDebug(COMPONENT_MEMALLOC, "%p:Buddy( %p,%u ) = ( %p ,%u )=>%s\n", (BUDDY_ADDR_T) pthread_self(),
+                   p_block_tmp, p_block_tmp->Header.StdInfo.k_size, p_buddy,
+                   p_buddy->Header.StdInfo.k_size,
+                   (p_buddy->Header.status ? "RESERV" : " FREE "));
+
+      if((p_buddy->Header.status == RESERVED_BLOCK) ||
+         (p_buddy->Header.StdInfo.k_size != p_block_tmp->Header.StdInfo.k_size))
+        /* stop merging */
+        break;
+
+      /* The buddy can be merged */
+      Remove_FreeBlock(context, p_buddy);
+
+      LogFullDebug(COMPONENT_MEMALLOC, "%p:Merging %p with %p (sizes 2^%.2u)\n", (BUDDY_ADDR_T) pthread_self(),
+                   p_buddy, p_block_tmp, p_block_tmp->Header.StdInfo.k_size);
+
+      /* the address of the merged blockset is the smallest
+       * of its components addresses.
+       */
+      if(p_buddy < p_block_tmp)
+        {
+          p_block_tmp = p_buddy;
+        }
+
+    }
+
+  /* Add the merged bloc to the free list */
+
+  Insert_FreeBlock(context, p_block_tmp);
+
+  /* update stats */
+
+  if((p_block_tmp->Header.Base_ptr == (BUDDY_ADDR_T) p_block_tmp)
+     && (p_block_tmp->Header.StdInfo.Base_kSize == p_block_tmp->Header.StdInfo.k_size))
+    {
+
+      UpdateStats_FreeStdPage(context);
+
+      /* if garbage collection is enabled, run it */
+
+      if(context->Config.free_areas)
+        {
+          Garbage_StdPages(context, p_block_tmp);
+        }
+
+    }
+
+  return;
+
+}                               /* ReleaseStdBlock */
+
+/* ------------------------------------------*
+ *        Slab caches for small blocks.
+ * ------------------------------------------*/
+
+/* size of the slab descriptor, so that objects are aligned on 64 bits */
+#define size_slab64  ( (sizeof(BuddySlab_t) + 7) & ~7 )
+
+/**
+ * SlabSizeClass:
+ * returns the smallest size class that can hold Size bytes,
+ * or -1 if this size is not handled by slabs.
+ */
+static int SlabSizeClass(size_t Size)
+{
+  int i;
+
+  for(i = 0; i < BUDDY_SLAB_NB_CLASSES; i++)
+    if(Size <= SlabClassSize[i])
+      return i;
+
+  return -1;
+
+}                               /* SlabSizeClass */
+
+/**
+ * SlabCacheInit:
+ * computes the slab geometry for each size class of a thread.
+ */
+static void SlabCacheInit(BuddyThreadContext_t * context)
+{
+  unsigned int i;
+  size_t space;
+
+  /* a slab must fit in a standard page */
+  context->SlabLog2 =
+      (context->k_size < BUDDY_SLAB_LOG2_SIZE) ? context->k_size : BUDDY_SLAB_LOG2_SIZE;
+
+  if((1 << context->SlabLog2) > size_header64 + size_slab64)
+    space = (1 << context->SlabLog2) - size_header64 - size_slab64;
+  else
+    space = 0;
+
+  for(i = 0; i < BUDDY_SLAB_NB_CLASSES; i++)
+    {
+      BuddySlabCache_t *cache = &context->SlabCache[i];
+
+      cache->NbMagazine = 0;
+      cache->Partial = NULL;
+      cache->NbEmpty = 0;
+      cache->Stride = size_header64 + SlabClassSize[i];
+      cache->ObjPerSlab = space / cache->Stride;
+
+      /* too few objects per slab: use buddy blocks */
+      if(cache->ObjPerSlab < BUDDY_SLAB_MIN_OBJECTS)
+        cache->ObjPerSlab = 0;
+    }
+
+}                               /* SlabCacheInit */
+
+/* insert a slab into the list of slabs with free objects */
+static void SlabLink(BuddySlabCache_t * cache, BuddySlab_t * slab)
+{
+  slab->Prev = NULL;
+  slab->Next = cache->Partial;
+
+  if(cache->Partial)
+    cache->Partial->Prev = slab;
+
+  cache->Partial = slab;
+}
+
+/* remove a slab from the list of slabs with free objects */
+static void SlabUnlink(BuddySlabCache_t * cache, BuddySlab_t * slab)
+{
+  if(slab->Prev)
+    slab->Prev->Next = slab->Next;
+  else
+    cache->Partial = slab->Next;
+
+  if(slab->Next)
+    slab->Next->Prev = slab->Prev;
+
+  slab->Next = NULL;
+  slab->Prev = NULL;
+}
+
+/**
+ * NewSlab:
+ * Reserves a buddy block and turns it into an empty slab.
+ */
+static BuddySlab_t *NewSlab(BuddyThreadContext_t * context, unsigned int size_class)
+{
+  BuddyBlock_t *p_block;
+  BuddySlab_t *slab;
+
+  p_block = AllocStdBlock(context, context->SlabLog2,
+                          (1 << context->SlabLog2) - size_header64, FALSE);
+
+  if(!p_block)
+    return NULL;
+
+  slab = (BuddySlab_t *) ((BUDDY_PTRDIFF_T) p_block + (BUDDY_PTRDIFF_T) size_header64);
+
+  slab->Block = p_block;
+  slab->SizeClass = size_class;
+  slab->NbUsed = 0;
+  slab->NbCarved = 0;
+  slab->FreeList = NULL;
+
+  SlabLink(&context->SlabCache[size_class], slab);
+  context->SlabCache[size_class].NbEmpty++;
+
+  context->Stats.NbSlabs++;
+
+  LogFullDebug(COMPONENT_MEMALLOC, "%p: new slab %p for objects of %llu bytes\n",
+               (BUDDY_ADDR_T) pthread_self(), slab,
+               (unsigned long long)SlabClassSize[size_class]);
+
+  return slab;
+
+}                               /* NewSlab */
+
+/**
+ * ReleaseSlab:
+ * Gives an empty slab back to the standard pages.
+ */
+static void ReleaseSlab(BuddyThreadContext_t * context, BuddySlab_t * slab)
+{
+  BuddySlabCache_t *cache = &context->SlabCache[slab->SizeClass];
+
+  SlabUnlink(cache, slab);
+  cache->NbEmpty--;
+
+  context->Stats.NbSlabs--;
+
+  ReleaseStdBlock(context, slab->Block);
+
+}                               /* ReleaseSlab */
+
+/**
+ * SlabAlloc:
+ * Takes an object from the thread's magazine, or from its slabs.
+ * Returns NULL if Size is not served by slabs, or if no slab
+ * could be allocated (the caller then falls back to buddy blocks).
+ */
+static BuddyBlock_t *SlabAlloc(BuddyThreadContext_t * context, size_t Size)
+{
+  int size_class;
+  BuddySlabCache_t *cache;
+  BuddySlab_t *slab;
+  BuddyBlock_t *p_block;
+
+  if((size_class = SlabSizeClass(Size)) < 0)
+    return NULL;
+
+  cache = &context->SlabCache[size_class];
+
+  if(cache->ObjPerSlab == 0)
+    return NULL;
+
+  if(cache->NbMagazine > 0)
+    {
+      /* last freed object is the hottest one */
+      p_block = cache->Magazine[--cache->NbMagazine];
+    }
+  else
+    {
+      slab = cache->Partial;
+
+      if(!slab && !(slab = NewSlab(context, size_class)))
+        return NULL;
+
+      if(slab->FreeList)
+        {
+          p_block = slab->FreeList;
+          slab->FreeList = p_block->Content.FreeBlockInfo.NextBlock;
+        }
+      else
+        {
+          /* carve a new object at the end of the slab */
+          p_block = (BuddyBlock_t *) ((BUDDY_PTRDIFF_T) slab
+                                      + (BUDDY_PTRDIFF_T) size_slab64
+                                      + (BUDDY_PTRDIFF_T) (slab->NbCarved * cache->Stride));
+          slab->NbCarved++;
+
+          /* never NULL, so that it is not taken for an extra block */
+          p_block->Header.Base_ptr = (BUDDY_ADDR_T) slab->Block;
+          p_block->Header.SlabInfo.Slab = slab;
+        }
+
+      if(slab->NbUsed++ == 0)
+        cache->NbEmpty--;
+
+      /* the slab is full */
+      if(!slab->FreeList && slab->NbCarved == cache->ObjPerSlab)
+        SlabUnlink(cache, slab);
+    }
+
+  p_block->Header.status = SLAB_BLOCK;
+  p_block->Header.MagicNumber = MAGIC_NUMBER_USED;
+  p_block->Header.OwnerThread = pthread_self();
+
+#ifndef _MONOTHREAD_MEMALLOC
+  p_block->Header.OwnerThreadContext = context;
+#endif
+
+  UpdateStats_UseSlabSpace(context, cache->Stride);
+
+  return p_block;
+
+}                               /* SlabAlloc */
+
+/**
+ * SlabReturn:
+ * Gives an object back to its slab.
+ * The slab is released when it becomes empty, unless
+ * it is one of the empty slabs we keep for this size class.
+ */
+static void SlabReturn(BuddyThreadContext_t * context, BuddySlabCache_t * cache,
+                       BuddyBlock_t * p_block)
+{
+  BuddySlab_t *slab = p_block->Header.SlabInfo.Slab;
+
+  /* the slab was full, it has a free object again */
+  if(!slab->FreeList && slab->NbCarved == cache->ObjPerSlab)
+    SlabLink(cache, slab);
+
+  p_block->Content.FreeBlockInfo.NextBlock = slab->FreeList;
+  slab->FreeList = p_block;
+
+  if(--slab->NbUsed == 0)
+    {
+      cache->NbEmpty++;
+
+      if(cache->NbEmpty > BUDDY_SLAB_KEEP_EMPTY)
+        ReleaseSlab(context, slab);
+    }
+
+}                               /* SlabReturn */
+
+/**
+ * SlabFlushMagazine:
+ * Gives the 'count' oldest objects of a magazine back to their slabs.
+ */
+static void SlabFlushMagazine(BuddyThreadContext_t * context, BuddySlabCache_t * cache,
+                              unsigned int count)
+{
+  unsigned int i;
+
+  for(i = 0; i < count; i++)
+    SlabReturn(context, cache, cache->Magazine[i]);
+
+  memmove(cache->Magazine, cache->Magazine + count,
+          (cache->NbMagazine - count) * sizeof(BuddyBlock_t *));
+
+  cache->NbMagazine -= count;
+
+}                               /* SlabFlushMagazine */
+
+/**
+ * SlabFree:
+ * Puts an object into the thread's magazine.
+ * /!\ must be called by the owner thread (or for a context
+ * in 'destroy_pending' state).
+ */
+static void SlabFree(BuddyThreadContext_t * context, BuddyBlock_t * p_block)
+{
+  BuddySlabCache_t *cache = &context->SlabCache[p_block->Header.SlabInfo.Slab->SizeClass];
+
+  p_block->Header.status = FREE_BLOCK;
+  p_block->Header.MagicNumber = MAGIC_NUMBER_FREE;
+
+  UpdateStats_FreeSlabSpace(context, cache->Stride);
+
+  /* magazine is full: give back its oldest half to the slabs */
+  if(cache->NbMagazine == BUDDY_MAGAZINE_SIZE)
+    SlabFlushMagazine(context, cache, BUDDY_MAGAZINE_SIZE / 2);
+
+  cache->Magazine[cache->NbMagazine++] = p_block;
+
+}                               /* SlabFree */
+
+/**
+ * SlabCacheRelease:
+ * Empties the magazines and releases every empty slab.
+ */
+static void SlabCacheRelease(BuddyThreadContext_t * context)
+{
+  unsigned int i;
+  BuddySlab_t *slab;
+  BuddySlab_t *next;
+
+  for(i = 0; i < BUDDY_SLAB_NB_CLASSES; i++)
+    {
+      BuddySlabCache_t *cache = &context->SlabCache[i];
+
+      SlabFlushMagazine(context, cache, cache->NbMagazine);
+
+      for(slab = cache->Partial; slab != NULL; slab = next)
+        {
+          next = slab->Next;
+
+          if(slab->NbUsed == 0)
+            ReleaseSlab(context, slab);
+        }
+    }
+
+}                               /* SlabCacheRelease */
+
 #ifndef _MONOTHREAD_MEMALLOC
 
 static void __BuddyFree(BuddyThreadContext_t * context, BuddyBlock_t * p_block);
@@ -945,34 +1603,78 @@ static void __BuddyFree(BuddyThreadContext_t * context, BuddyBlock_t * p_block);
 static void CheckBlocksToBeFreed(BuddyThreadContext_t * context, int do_lock)
 {
   BuddyBlock_t *p_block_to_free;
+  BuddyBlock_t *p_next_block;
 
-  /* take a block in the list a long as there is one */
+  /* Most of the time, there is nothing to be freed: don't take the lock.
+   * A block pushed in the meantime will be freed at next call.
+   */
+  if(context->ToBeFreed_list == NULL)
+    return;
 
-  do
-    {
+  /* take the whole list at once */
 
-      if (do_lock)
-        P(context->ToBeFreed_mutex);
+  if (do_lock)
+    P(context->ToBeFreed_mutex);
 
-      p_block_to_free = context->ToBeFreed_list;
-      if(p_block_to_free)
-        context->ToBeFreed_list = p_block_to_free->Content.NextToBeFreed;
+  p_block_to_free = context->ToBeFreed_list;
+  context->ToBeFreed_list = NULL;
 
-      if (do_lock)
-          V(context->ToBeFreed_mutex);
+  if (do_lock)
+    V(context->ToBeFreed_mutex);
 
-      if(p_block_to_free == NULL)
-        break;
+  for(; p_block_to_free != NULL; p_block_to_free = p_next_block)
+    {
+      p_next_block = p_block_to_free->Content.NextToBeFreed;
 
       LogFullDebug(COMPONENT_MEMALLOC, "blocks %p has been released by foreign thread\n",
                    p_block_to_free);
 
       __BuddyFree(context, p_block_to_free);
     }
-  while(1);
 
 }
 
+static int TryContextCleanup(BuddyThreadContext_t * context);
+
+/**
+ * FlushRemoteFrees:
+ * Hands the slab objects this thread released for another thread
+ * back to their owner, taking the owner's lock once for the batch.
+ */
+static void FlushRemoteFrees(BuddyThreadContext_t * context)
+{
+  BuddyThreadContext_t *owner_context = context->Remote_owner;
+  BuddyBlock_t *p_head = context->Remote_head;
+  BuddyBlock_t *p_tail = context->Remote_tail;
+
+  if(!owner_context)
+    return;
+
+  context->Remote_owner = NULL;
+  context->Remote_head = NULL;
+  context->Remote_tail = NULL;
+  context->Remote_count = 0;
+
+  P(owner_context->ToBeFreed_mutex);
+
+  p_tail->Content.NextToBeFreed = owner_context->ToBeFreed_list;
+  owner_context->ToBeFreed_list = p_head;
+
+  /* same as in BuddyFree: the owner may be waiting for those blocks
+   * to complete its cleanup */
+  if (owner_context->destroy_pending &&
+      (TryContextCleanup(owner_context) == BUDDY_SUCCESS ))
+    {
+      /* don't release the mutex if it has been destroyed */
+      LogDebug(COMPONENT_MEMALLOC,
+               "thread %#lx successfully released resources of "
+               "context %p\n", pthread_self(), owner_context );
+    }
+  else
+    V(owner_context->ToBeFreed_mutex);
+
+}                               /* FlushRemoteFrees */
+
 #endif
 
 /** Try to cleanup a context in 'destroy_pending' state.
@@ -989,6 +1691,9 @@ static int TryContextCleanup(BuddyThreadContext_t * context)
         CheckBlocksToBeFreed(context, FALSE);
 #endif
 
+        /* give the cached slab objects back to the standard pages */
+        SlabCacheRelease(context);
+
         /* free pages that has the size of a memory page */
         while ( (p_block = context->MemDesc[context->k_size]) != NULL )
         {
@@ -1146,11 +1851,24 @@ int BuddyInit(buddy_parameter_t * p_buddy_init_info)
   context->Stats.NbExtraPages = 0;
   context->Stats.WM_NbExtraPages = 0;
 
+  context->Stats.NbSlabs = 0;
+  context->Stats.SlabUsedSpace = 0;
+  context->Stats.WM_SlabUsedSpace = 0;
+
+  /* Init slab caches */
+
+  SlabCacheInit(context);
+
 #ifndef _MONOTHREAD_MEMALLOC
   if(pthread_mutex_init(&context->ToBeFreed_mutex, NULL) != 0)
     return BUDDY_ERR_EINVAL;
   context->ToBeFreed_list = NULL;
   context->destroy_pending = FALSE;
+
+  context->Remote_owner = NULL;
+  context->Remote_head = NULL;
+  context->Remote_tail = NULL;
+  context->Remote_count = 0;
 #endif
 
   /* structure is initialized */
@@ -1218,7 +1936,7 @@ unsigned int BuddyPreferedPoolCount(unsigned int min_count, size_t type_size)
 static BUDDY_ADDR_T __BuddyMalloc(size_t Size, int do_exit_on_error)
 {
 
-  unsigned int sizelog2, i;
+  unsigned int sizelog2;
   BuddyBlock_t *p_block;
   BuddyThreadContext_t *context;
   size_t allocation;
@@ -1246,152 +1964,77 @@ static BUDDY_ADDR_T __BuddyMalloc(size_t Size, int do_exit_on_error)
   if(Size == 0)
     return NULL;
 
-  if(Size < MIN_ALLOC_SIZE)
-    sizelog2 = Log2Ceil(MIN_ALLOC_SIZE + size_header64);
-  else
-    sizelog2 = Log2Ceil(Size + size_header64);
-
-  i = sizelog2;
-  allocation = 1 << sizelog2;
-
-  /* If it is a non-standard block (largest than page size),
-   * We handle the request using AllocLargeBlock( context, size ).
+  /* Small blocks are served by the slab caches.
+   * If no slab can be allocated, we still try a buddy block.
    */
 
-  if(allocation > (1ULL << context->k_size))
+  if(Size <= BUDDY_SLAB_MAX_SIZE)
+    p_block = SlabAlloc(context, Size);
+  else
+    p_block = NULL;
+
+  if(!p_block)
     {
 
-      if(context->Config.extra_alloc)
-        {
-          /* extra block are allowed */
-          return AllocLargeBlock(context, Size);
-        }
+      if(Size < MIN_ALLOC_SIZE)
+        sizelog2 = Log2Ceil(MIN_ALLOC_SIZE + size_header64);
       else
-        {
-          /* Extra blocks are not allowed */
-
-          LogFullDebug(COMPONENT_MEMALLOC, "%p:BuddyMalloc(%llu) => BUDDY_ERR_OUTOFMEM (extra_alloc disabled).\n",
-                       (BUDDY_ADDR_T) pthread_self(), (unsigned long long)Size);
-
-          context->Errno = BUDDY_ERR_OUTOFMEM;
-
-          if(do_exit_on_error)
-            exit(1);
-
-          return NULL;
-
-        }
-
-    }
-  LogFullDebug(COMPONENT_MEMALLOC, "We have to alloc 2^%u\n", i);
-
-  /* It is a standard block, we look for a large enough block 
-   * in the block pool.
-   */
-
-  while((i < BUDDY_MAX_LOG2_SIZE) && (!context->MemDesc[i]))
-    {
-      i++;
-    }
+        sizelog2 = Log2Ceil(Size + size_header64);
 
-  LogFullDebug(COMPONENT_MEMALLOC, "i=%u\n", i);
+      allocation = 1 << sizelog2;
 
-  if(i < BUDDY_MAX_LOG2_SIZE)
-    {
-      /* 1st case : a block is available */
-      p_block = context->MemDesc[i];
-    }
-  else if(context->Config.on_demand_alloc)
-    {
-      /* 2nd case :
-       * No memory block available.
-       * If the on_demand_alloc option has been set,
-       * We can allocate a new page.
+      /* If it is a non-standard block (largest than page size),
+       * We handle the request using AllocLargeBlock( context, size ).
        */
 
-      /* add a new page */
-      p_block = NewStdPage(context);
-
-      if(!p_block)
+      if(allocation > (1ULL << context->k_size))
         {
-          context->Errno = BUDDY_ERR_MALLOC;
-
-          LogEvent(COMPONENT_MEMALLOC,
-                   "BuddyMalloc: NOT ENOUGH MEMORY !!!\n");
-
-          if(do_exit_on_error)
-            exit(1);
-
-          return NULL;
-        }
-
-    }
-  else
-    {
-      /* Out of memory */
-      LogFullDebug(COMPONENT_MEMALLOC, "%p:BuddyMalloc(%llu) => BUDDY_ERR_OUTOFMEM (on_demand_alloc disabled).\n",
-                   (BUDDY_ADDR_T) pthread_self(), (unsigned long long)Size);
-
-      if(do_exit_on_error)
-        exit(1);
-
-      context->Errno = BUDDY_ERR_OUTOFMEM;
-      return NULL;
-
-    }
-
-  /* removes the selected block from the pool of free blocks. */
-
-  Remove_FreeBlock(context, p_block);
-
-  /* If it was a whole page, we notice that it becomes used */
 
-  if((p_block->Header.Base_ptr == (BUDDY_ADDR_T) p_block)
-     && (p_block->Header.StdInfo.Base_kSize == p_block->Header.StdInfo.k_size))
-    {
+          if(context->Config.extra_alloc)
+            {
+              /* extra block are allowed */
+              return AllocLargeBlock(context, Size);
+            }
+          else
+            {
+              /* Extra blocks are not allowed */
 
-      UpdateStats_UseStdPage(context);
+              LogFullDebug(COMPONENT_MEMALLOC, "%p:BuddyMalloc(%llu) => BUDDY_ERR_OUTOFMEM (extra_alloc disabled).\n",
+                           (BUDDY_ADDR_T) pthread_self(), (unsigned long long)Size);
 
-    }
+              context->Errno = BUDDY_ERR_OUTOFMEM;
 
-  /* Iteratively splits the block. */
+              if(do_exit_on_error)
+                exit(1);
 
-  while(p_block->Header.StdInfo.k_size > sizelog2)
-    {
+              return NULL;
 
-      BuddyBlock_t *p_buddy;
+            }
 
-      /* divides the main block into 2 smaller blocks */
-      p_block->Header.StdInfo.k_size--;
+        }
 
-      p_buddy = Get_BuddyBlock(context, p_block);
+      /* It is a standard block */
 
-      /* herits from the same parent */
+      p_block = AllocStdBlock(context, sizelog2, Size, FALSE);
 
-      p_buddy->Header.Base_ptr = p_block->Header.Base_ptr;
-      p_buddy->Header.StdInfo.Base_kSize = p_block->Header.StdInfo.Base_kSize;
+      if(!p_block)
+        {
+          /* objects cached in slabs may prevent buddy blocks
+           * from merging: give them back and try again */
+          SlabCacheRelease(context);
 
-      /* new block is free */
-      p_buddy->Header.status = FREE_BLOCK;
-      p_buddy->Header.MagicNumber = MAGIC_NUMBER_FREE;
+          p_block = AllocStdBlock(context, sizelog2, Size, do_exit_on_error);
 
-      p_buddy->Header.StdInfo.k_size = p_block->Header.StdInfo.k_size;
+          if(!p_block)
+            return NULL;
+        }
 
-      /* insert block into the free list */
-      Insert_FreeBlock(context, p_buddy);
+#ifdef _DEBUG_MEMLEAKS
+      p_block->Header.StdInfo.user_size = Size + size_header64;
+#endif
 
     }
 
-  /* Finally, we have the block to be reserved  */
-  p_block->Header.status = RESERVED_BLOCK;
-
-  p_block->Header.MagicNumber = MAGIC_NUMBER_USED;
-  p_block->Header.OwnerThread = pthread_self();
-
-#ifndef _MONOTHREAD_MEMALLOC
-  p_block->Header.OwnerThreadContext = context;
-#endif
-
 #ifdef _DEBUG_MEMLEAKS
   /* sets the label for debugging */
   p_block->Header.label_user_defined = context->label_user_defined;
@@ -1399,16 +2042,11 @@ static BUDDY_ADDR_T __BuddyMalloc(size_t Size, int do_exit_on_error)
   p_block->Header.label_func = context->label_func;
   p_block->Header.label_line = context->label_line;
 
-  p_block->Header.StdInfo.user_size = Size + size_header64;
-
   /* add it to the list of allocated blocks */
   add_allocated_block(context, p_block);
 
 #endif
 
-  /* update stats to remember we use this amount of memory */
-  UpdateStats_UseStdMemSpace(context, allocation);
-
   LogFullDebug(COMPONENT_MEMALLOC, "%p:BuddyMalloc(%llu) => %p\n", (BUDDY_ADDR_T) pthread_self(),
                (unsigned long long)Size, p_block->Content.UserSpace);
 
@@ -1433,7 +2071,6 @@ BUDDY_ADDR_T BuddyMallocExit(size_t Size)
  */
 static void __BuddyFree(BuddyThreadContext_t * context, BuddyBlock_t * p_block)
 {
-  BuddyBlock_t *p_block_tmp;
 
 #ifdef _DEBUG_MEMLEAKS
   /* remove from allocated blocks */
@@ -1447,6 +2084,13 @@ static void __BuddyFree(BuddyThreadContext_t * context, BuddyBlock_t * p_block)
       return;
     }
 
+  /* Objects of slabs go to the thread's magazine */
+  if(IS_SLAB_BLOCK(p_block))
+    {
+      SlabFree(context, p_block);
+      return;
+    }
+
   /* Sanity checks for std blocks */
   if(((BUDDY_ADDR_T) p_block < p_block->Header.Base_ptr) ||
      ((BUDDY_ADDR_T) p_block > p_block->Header.Base_ptr +
@@ -1456,70 +2100,7 @@ static void __BuddyFree(BuddyThreadContext_t * context, BuddyBlock_t * p_block)
       return;
     }
 
-  /* mark it free */
-
-  p_block->Header.status = FREE_BLOCK;
-  p_block->Header.MagicNumber = MAGIC_NUMBER_FREE;
-
-  UpdateStats_FreeStdMemSpace(context, 1 << p_block->Header.StdInfo.k_size);
-
-  /* merge free blocks. */
-
-  for(p_block_tmp = p_block;
-      p_block_tmp->Header.StdInfo.k_size < p_block_tmp->Header.StdInfo.Base_kSize;
-      p_block_tmp->Header.StdInfo.k_size++)
-    {
-
-      BuddyBlock_t *p_buddy;
-
-      p_buddy = Get_BuddyBlock(context, p_block_tmp);
-
-      LogFullDebug(COMPONENT_MEMALLOC, "%p:Buddy( %p,%u ) = ( %p ,%u )=>%s\n", (BUDDY_ADDR_T) pthread_self(),
-                   p_block_tmp, p_block_tmp->Header.StdInfo.k_size, p_buddy,
-                   p_buddy->Header.StdInfo.k_size,
-                   (p_buddy->Header.status ? "RESERV" : " FREE "));
-
-      if((p_buddy->Header.status == RESERVED_BLOCK) ||
-         (p_buddy->Header.StdInfo.k_size != p_block_tmp->Header.StdInfo.k_size))
-        /* stop merging */
-        break;
-
-      /* The buddy can be merged */
-      Remove_FreeBlock(context, p_buddy);
-
-      LogFullDebug(COMPONENT_MEMALLOC, "%p:Merging %p with %p (sizes 2^%.2u)\n", (BUDDY_ADDR_T) pthread_self(),
-                   p_buddy, p_block_tmp, p_block_tmp->Header.StdInfo.k_size);
-
-      /* the address of the merged blockset is the smallest
-       * of its components addresses.
-       */
-      if(p_buddy < p_block_tmp)
-        {
-          p_block_tmp = p_buddy;
-        }
-
-    }
-
-  /* Add the merged bloc to the free list */
-
-  Insert_FreeBlock(context, p_block_tmp);
-
-  /* update stats */
-
-  if((p_block_tmp->Header.Base_ptr == (BUDDY_ADDR_T) p_block_tmp)
-     && (p_block_tmp->Header.StdInfo.Base_kSize == p_block_tmp->Header.StdInfo.k_size))
-    {
-
-      UpdateStats_FreeStdPage(context);
-
-      /* if garbage collection is enabled, run it */
-
-      if(context->Config.free_areas)
-        {
-          Garbage_StdPages(context, p_block_tmp);
-        }
-
-    }
+  ReleaseStdBlock(context, p_block);
 
   return;
 
@@ -1598,6 +2179,7 @@ void BuddyFree(BUDDY_ADDR_T ptr)
       break;
 
     case RESERVED_BLOCK:
+    case SLAB_BLOCK:
       /* check for magic number */
       if(p_block->Header.MagicNumber != MAGIC_NUMBER_USED)
         {
@@ -1662,6 +2244,26 @@ void BuddyFree(BUDDY_ADDR_T ptr)
                    "This block (%p) belongs to another thread (%p), I put it in its release list\n",
                    p_block, (BUDDY_ADDR_T) p_block->Header.OwnerThread);
 
+      /* Small objects are handed back to their owner by batches,
+       * so that the owner's lock is taken once per batch.
+       */
+      if(IS_SLAB_BLOCK(p_block))
+        {
+          if(context->Remote_owner != owner_context)
+            FlushRemoteFrees(context);
+
+          p_block->Content.NextToBeFreed = context->Remote_head;
+          if(!context->Remote_head)
+            context->Remote_tail = p_block;
+          context->Remote_head = p_block;
+          context->Remote_owner = owner_context;
+
+          if(++context->Remote_count >= BUDDY_REMOTE_BATCH)
+            FlushRemoteFrees(context);
+
+          return;
+        }
+
       /* put the block into the ToBeFreed_list of the owner thread */
       P(owner_context->ToBeFreed_mutex);
       p_block->Content.NextToBeFreed = owner_context->ToBeFreed_list;
@@ -1723,6 +2325,7 @@ BUDDY_ADDR_T BuddyRealloc(BUDDY_ADDR_T ptr, size_t Size)
   BUDDY_ADDR_T new_ptr;
   BuddyBlock_t *p_block;
   BuddyThreadContext_t *context;
+  size_t old_size;
 
   LogFullDebug(COMPONENT_MEMALLOC, "%p:BuddyRealloc(%p,%llu)\n", (BUDDY_ADDR_T) pthread_self(), ptr,
                (unsigned long long)Size);
@@ -1758,7 +2361,7 @@ BUDDY_ADDR_T BuddyRealloc(BUDDY_ADDR_T ptr, size_t Size)
   p_block = (BuddyBlock_t *) (ptr - size_header64);
 
   /* it should not be free */
-  if(p_block->Header.status != RESERVED_BLOCK)
+  if((p_block->Header.status != RESERVED_BLOCK) && !IS_SLAB_BLOCK(p_block))
     {
       context->Errno = BUDDY_ERR_EINVAL;
       return NULL;
@@ -1775,25 +2378,20 @@ BUDDY_ADDR_T BuddyRealloc(BUDDY_ADDR_T ptr, size_t Size)
   /* size of user space = total size of block - size of header */
 
   if(IS_EXTRA_BLOCK(p_block))
-    {
-
-      LogFullDebug(COMPONENT_MEMALLOC, "%p:Copying %d bytes from @%p to @%p->@%p\n", (BUDDY_ADDR_T) pthread_self(),
-                   p_block->Header.ExtraInfo - size_header64, ptr, new_ptr,
-                   new_ptr + p_block->Header.ExtraInfo - size_header64);
-
-      memcpy(new_ptr, ptr, p_block->Header.ExtraInfo - size_header64);
-
-    }
+    old_size = p_block->Header.ExtraInfo - size_header64;
+  else if(IS_SLAB_BLOCK(p_block))
+    old_size = SlabClassSize[p_block->Header.SlabInfo.Slab->SizeClass];
   else
-    {
+    old_size = (1 << p_block->Header.StdInfo.k_size) - size_header64;
 
-      LogFullDebug(COMPONENT_MEMALLOC, "%p:Copying %d bytes from @%p to @%p->@%p\n", (BUDDY_ADDR_T) pthread_self(),
-                   (1 << p_block->Header.StdInfo.k_size) - size_header64, ptr, new_ptr,
-                   new_ptr + (1 << p_block->Header.StdInfo.k_size) - size_header64);
+  /* the new area may be smaller */
+  if(old_size > Size)
+    old_size = Size;
 
-      memcpy(new_ptr, ptr, (1 << p_block->Header.StdInfo.k_size) - size_header64);
+  LogFullDebug(COMPONENT_MEMALLOC, "%p:Copying %llu bytes from @%p to @%p->@%p\n", (BUDDY_ADDR_T) pthread_self(),
+               (unsigned long long)old_size, ptr, new_ptr, new_ptr + old_size);
 
-    }
+  memcpy(new_ptr, ptr, old_size);
 
   /* freeing the old memory area */
   BuddyFree(ptr);
@@ -1848,6 +2446,9 @@ int BuddyDestroy()
     return BUDDY_ERR_NOTINIT;
 
 #ifndef _MONOTHREAD_MEMALLOC
+        /* give back the objects we released for other threads */
+        FlushRemoteFrees(context);
+
         /* Destroying thread resources must be done
          * under the protection of a mutex,
          * to prevent from concurrent thread that would
@@ -1985,6 +2586,18 @@ void BuddyDumpMem(FILE * output)
   fprintf(output, "%p:       Max Page Size Watermark:  %lu\n",
           (BUDDY_ADDR_T) pthread_self(), (unsigned long)context->Stats.MaxExtraPageSize);
 
+  /* stats about slabs */
+
+  fprintf(output, "\n");
+
+  fprintf(output, "%p: Nb Slabs:     %u   (Size of Slabs: %lu)\n",
+          (BUDDY_ADDR_T) pthread_self(), context->Stats.NbSlabs,
+          (unsigned long)(1 << context->SlabLog2));
+
+  fprintf(output, "%p:       Space Used inside Slabs: %lu  (Watermark: %lu)\n",
+          (BUDDY_ADDR_T) pthread_self(), (unsigned long)context->Stats.SlabUsedSpace,
+          (unsigned long)context->Stats.WM_SlabUsedSpace);
+
 #ifdef _DEBUG_MEMLEAKS
 
   fprintf(output, "\n");
@@ -2010,6 +2623,17 @@ void BuddyDumpMem(FILE * output)
                     p_curr_block->Header.label_func, p_curr_block->Header.label_line,
                     p_curr_block->Header.label_user_defined);
           }
+        else if(IS_SLAB_BLOCK(p_curr_block))
+          {
+            fprintf(output,
+                    "%p: type=SLAB_BLOCK  | size=%lu | status=RESERV | block_addr=%8p | base_ptr=%8p | label=%s:%s:%u:%s\n",
+                    (BUDDY_ADDR_T) pthread_self(),
+                    (unsigned long)SlabClassSize[p_curr_block->Header.SlabInfo.Slab->SizeClass],
+                    p_curr_block, p_curr_block->Header.Base_ptr,
+                    p_curr_block->Header.label_file,
+                    p_curr_block->Header.label_func, p_curr_block->Header.label_line,
+                    p_curr_block->Header.label_user_defined);
+          }
         else
           {
             fprintf(output,
@@ -2422,6 +3046,15 @@ void DisplayMemoryMap(FILE *output)
           continue;
         }
 
+      /* nor slab objects */
+      if(IS_SLAB_BLOCK(p_curr_block))
+        {
+          fprintf(output, "Slab block: [ size=%lu ]\n",
+                    (unsigned long)SlabClassSize[p_curr_block->Header.SlabInfo.Slab->SizeClass]);
+          is_first = TRUE;
+          continue;
+        }
+
       /* is it the first block of the page ? */
       if(is_first)
         {
@@ -2566,6 +3199,7 @@ int BuddyCheck(BUDDY_ADDR_T ptr)
       break;
 
     case RESERVED_BLOCK:
+    case SLAB_BLOCK:
       /* check for magic number */
       if(p_block->Header.MagicNumber != MAGIC_NUMBER_USED)
         {
@@ -2662,6 +3296,21 @@ int BuddyCheck(BUDDY_ADDR_T ptr)
   if(IS_EXTRA_BLOCK(p_block))
     return 1;
 
+  /* Slab objects must be inside their slab */
+  if(IS_SLAB_BLOCK(p_block))
+    {
+      BuddySlab_t *slab = p_block->Header.SlabInfo.Slab;
+
+      if(((BUDDY_ADDR_T) p_block < (BUDDY_ADDR_T) slab) ||
+         ((BUDDY_ADDR_T) p_block >= (BUDDY_ADDR_T) slab->Block +
+          (1 << slab->Block->Header.StdInfo.k_size)))
+        {
+          context->Errno = BUDDY_ERR_EINVAL;
+          return 0;
+        }
+      return 1;
+    }
+
   /* Std blocks sanity checks */
   if(((BUDDY_ADDR_T) p_block < p_block->Header.Base_ptr) ||
      ((BUDDY_ADDR_T) p_block > p_block->Header.Base_ptr +
@@ -1227,6 +1227,165 @@ void *TESTB(void *arg)
 
 }
 
+#define NB_LOOPC   2000
+#define NB_ITEMC   64
+#define MAX_SIZEC  512
+
+/* blocks sent by a thread to its neighbour, for being freed there */
+typedef struct mailbox_testC
+{
+  pthread_mutex_t mutex;
+  caddr_t items[NB_ITEMC];
+  unsigned int count;
+} mailbox_testC_t;
+
+mailbox_testC_t mailbox_testC[NB_THREADS];
+int nb_threads_testC = 1;
+
+pthread_mutex_t testC_mutex = PTHREAD_MUTEX_INITIALIZER;
+pthread_cond_t testC_cond = PTHREAD_COND_INITIALIZER;
+int testC_arrived = 0;
+
+/* wait for all threads to complete their loop */
+static void testC_rendezvous()
+{
+  P(testC_mutex);
+  testC_arrived++;
+  if(testC_arrived == nb_threads_testC)
+    pthread_cond_broadcast(&testC_cond);
+  else
+    while(testC_arrived < nb_threads_testC)
+      pthread_cond_wait(&testC_cond, &testC_mutex);
+  V(testC_mutex);
+}
+
+/* free the blocks our neighbour sent us */
+static unsigned int testC_free_mailbox(int th)
+{
+  caddr_t items[NB_ITEMC];
+  unsigned int i, count;
+  int prev = (th + nb_threads_testC - 1) % nb_threads_testC;
+
+  /* single thread test: no mailbox */
+  if(prev == th)
+    return 0;
+
+  P(mailbox_testC[th].mutex);
+  count = mailbox_testC[th].count;
+  memcpy(items, mailbox_testC[th].items, count * sizeof(caddr_t));
+  mailbox_testC[th].count = 0;
+  V(mailbox_testC[th].mutex);
+
+  for(i = 0; i < count; i++)
+    {
+      if(items[i][0] != (char)prev)
+        {
+          LogTest("%d:************ INTEGRITY ERROR !!! ************", th);
+          exit(1);
+        }
+      BuddyFree(items[i]);
+    }
+
+  return count;
+}
+
+/* TESTC:
+ * throughput of small blocks alloc/free.
+ * In multithreaded mode, each thread has half of its blocks
+ * freed by its neighbour.
+ */
+void *TESTC(void *arg)
+{
+
+  int th = (long)arg;
+  int next = (th + 1) % nb_threads_testC;
+  int i, j, rc;
+  unsigned int nb_remote = 0;
+  caddr_t items[NB_ITEMC];
+  struct timeval tv1, tv2, tv3;
+  buddy_stats_t stats;
+
+  LogTest("%d:BuddyInit(%llu)=%d", th, MEM_SIZE, rc = BuddyInit(&parameter_realloc));
+
+  if(rc)
+    exit(1);
+
+  gettimeofday(&tv1, NULL);
+
+  for(i = 0; i < NB_LOOPC; i++)
+    {
+      for(j = 0; j < NB_ITEMC; j++)
+        {
+          size_t len = (unsigned long)my_rand() % MAX_SIZEC + 1;
+
+          items[j] = BuddyMalloc(len);
+
+          if(!items[j])
+            {
+              LogTest("%d:**** NOT ENOUGH MEMORY TO ALLOCATE %llu : %d *****", th,
+                     (unsigned long long)len, BuddyErrno);
+              exit(1);
+            }
+
+          /* remember who allocated it */
+          memset(items[j], th, len);
+        }
+
+      /* free one half ourselves, in reverse order */
+      for(j = NB_ITEMC - 1; j >= NB_ITEMC / 2; j--)
+        BuddyFree(items[j]);
+
+      /* the other half is freed by our neighbour, if there is room in its mailbox */
+      j = 0;
+
+      if(next != th)
+        {
+          P(mailbox_testC[next].mutex);
+          for(; (j < NB_ITEMC / 2) && (mailbox_testC[next].count < NB_ITEMC); j++)
+            mailbox_testC[next].items[mailbox_testC[next].count++] = items[j];
+          V(mailbox_testC[next].mutex);
+        }
+
+      for(; j < NB_ITEMC / 2; j++)
+        BuddyFree(items[j]);
+
+      nb_remote += testC_free_mailbox(th);
+    }
+
+  gettimeofday(&tv2, NULL);
+
+  tv3 = time_diff(tv1, tv2);
+
+  LogTest("%d: %d Malloc/Free of small blocks in %lu.%.6lu s (%.0f/s), %u freed for another thread",
+         th, NB_LOOPC * NB_ITEMC, tv3.tv_sec, tv3.tv_usec,
+         (NB_LOOPC * NB_ITEMC) / (tv3.tv_sec + tv3.tv_usec / 1000000.0), nb_remote);
+
+  /* no more blocks will be sent after this point */
+  testC_rendezvous();
+  testC_free_mailbox(th);
+
+  BuddyGetStats(&stats);
+
+  LogTest("%d: Nb slabs=%u, space used in slabs=%lu (watermark=%lu), std pages=%u",
+         th, stats.NbSlabs, (unsigned long)stats.SlabUsedSpace,
+         (unsigned long)stats.WM_SlabUsedSpace, stats.NbStdPages);
+
+  LogTest("BUDDY_ERRNO=%d", BuddyErrno);
+
+  /* destroy thread resources:
+   * our neighbour may not have released our blocks yet */
+  rc = BuddyDestroy();
+  if(rc == BUDDY_ERR_INUSE)
+    LogTest("%d: resources will be released by another thread", th);
+  else if(rc)
+    LogTest("ERROR in BuddyDestroy: %d", rc);
+  else
+    LogTest("All resources released successfully");
+
+  return NULL;
+
+}
+
 static char usage[] =
     "Usage :\n"
     "\ttest_buddy <test_name>\n\n"
@@ -1241,7 +1400,8 @@ static char usage[] =
     "\t\t8[mt] : garbage collection stats (mt: multithreaded test)\n"
     "\t\t9[mt] : debug labels (mt: multithreaded test)\n"
     "\t\tA     : multithreaded alloc/free on shared memory segments\n"
-    "\t\tB[mt] : memory corruption tests\n";
+    "\t\tB[mt] : memory corruption tests\n"
+    "\t\tC[mt] : throughput for small blocks (mt: with frees from other threads)\n";
 
 /* Multithread launch macro */
 #define LAUNCH_THREADS( _function_ , _nb_threads_ ) do {\
@@ -1312,6 +1472,9 @@ int main(int argc, char **argv)
   else if(!strcmp(argv[1], "B"))
     TESTB(0);
 
+  else if(!strcmp(argv[1], "C"))
+    TESTC(0);
+
   else if(!strcmp(argv[1], "1mt"))
     LAUNCH_THREADS(TEST1, NB_THREADS);
 
@@ -1352,6 +1515,20 @@ int main(int argc, char **argv)
   else if(!strcmp(argv[1], "Bmt"))
     LAUNCH_THREADS(TESTB, NB_THREADS);
 
+  else if(!strcmp(argv[1], "Cmt"))
+    {
+      int i;
+      /* initialization of the test */
+      for(i = 0; i < NB_THREADS; i++)
+        {
+          pthread_mutex_init(&mailbox_testC[i].mutex, NULL);
+          mailbox_testC[i].count = 0;
+        }
+      nb_threads_testC = NB_THREADS;
+
+      LAUNCH_THREADS(TESTC, NB_THREADS);
+    }
+
   else
     {
       LogTest("***** Unknown test: \"%s\" ******", argv[1]);
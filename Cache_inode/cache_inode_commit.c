@@ -58,27 +58,814 @@
 #include <time.h>
 #include <pthread.h>
 
+/* Memory used by the pending unstable data of all the entries, and list of the
+ * entries holding pending data, oldest first. Both are protected by the mutex. */
+static fsal_size_t unstable_total = 0;
+static cache_entry_t *unstable_first = NULL;
+static cache_entry_t *unstable_last = NULL;
+static pthread_mutex_t unstable_total_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+static int unstable_flusher_started = FALSE;
+static pthread_cond_t unstable_flusher_cond = PTHREAD_COND_INITIALIZER;    /* too much data pending    */
+static pthread_cond_t unstable_flushed_cond = PTHREAD_COND_INITIALIZER;    /* the flusher left an entry */
+
+/*
+ * Links an entry at the end of the list of the entries holding pending data, if it
+ * is not in it yet. Must be called with unstable_total_mutex.
+ */
+static void cache_inode_unstable_link(cache_entry_t * pentry)
+{
+  cache_inode_unstable_data_t *udata = &pentry->object.file.unstable_data;
+
+  if(udata->prev_dirty != NULL || unstable_first == pentry)
+    return;
+
+  udata->oldest = time(NULL);
+  udata->next_dirty = NULL;
+  udata->prev_dirty = unstable_last;
+
+  if(unstable_last == NULL)
+    unstable_first = pentry;
+  else
+    unstable_last->object.file.unstable_data.next_dirty = pentry;
+
+  unstable_last = pentry;
+}                               /* cache_inode_unstable_link */
+
+/*
+ * Removes an entry from the list of the entries holding pending data, if it is in it.
+ * Must be called with unstable_total_mutex.
+ */
+static void cache_inode_unstable_unlink(cache_entry_t * pentry)
+{
+  cache_inode_unstable_data_t *udata = &pentry->object.file.unstable_data;
+
+  if(udata->prev_dirty == NULL && unstable_first != pentry)
+    return;
+
+  if(udata->prev_dirty == NULL)
+    unstable_first = udata->next_dirty;
+  else
+    udata->prev_dirty->object.file.unstable_data.next_dirty = udata->next_dirty;
+
+  if(udata->next_dirty == NULL)
+    unstable_last = udata->prev_dirty;
+  else
+    udata->next_dirty->object.file.unstable_data.prev_dirty = udata->prev_dirty;
+
+  udata->next_dirty = NULL;
+  udata->prev_dirty = NULL;
+  udata->oldest = 0;
+}                               /* cache_inode_unstable_unlink */
+
+/*
+ * Removes an entry that does not hold pending data anymore from the list.
+ */
+static void cache_inode_unstable_clean(cache_entry_t * pentry)
+{
+  if(pentry->object.file.unstable_data.extents != NULL)
+    return;
+
+  P(unstable_total_mutex);
+  cache_inode_unstable_unlink(pentry);
+  V(unstable_total_mutex);
+}                               /* cache_inode_unstable_clean */
+
+/*
+ * Accounts for buffers allocated (delta > 0) or released (delta < 0) for the
+ * unstable data of an entry. Returns the memory used by all the entries.
+ */
+static fsal_size_t cache_inode_unstable_account(cache_entry_t * pentry, long long delta)
+{
+  fsal_size_t total;
+
+  pentry->object.file.unstable_data.size += delta;
+
+  P(unstable_total_mutex);
+  unstable_total += delta;
+  total = unstable_total;
+  V(unstable_total_mutex);
+
+  return total;
+}                               /* cache_inode_unstable_account */
+
+static void cache_inode_unstable_free_extent(cache_entry_t * pentry,
+                                             cache_inode_unstable_extent_t * pextent)
+{
+  cache_inode_unstable_account(pentry, -(long long)pextent->size);
+  pentry->object.file.unstable_data.nb_extents -= 1;
+
+  Mem_Free(pextent->buffer);
+  Mem_Free(pextent);
+}                               /* cache_inode_unstable_free_extent */
+
+/**
+ *
+ * cache_inode_unstable_add: keeps the data of an UNSTABLE write in memory.
+ *
+ * The data are merged with the pending extents they overlap or follow, the
+ * newest data winning. The entry must be write locked.
+ *
+ * @param pentry [INOUT] entry the data are written to.
+ * @param offset [IN] offset of the data in the file.
+ * @param size [IN] size of the data.
+ * @param buffer [IN] the data.
+ * @param pcontext [IN] fsal context of the write, whose credentials are used by the flusher thread.
+ * @param pflush_needed [OUT] set to TRUE if the pending data must now be flushed.
+ *
+ * @return CACHE_INODE_SUCCESS if successful, CACHE_INODE_MALLOC_ERROR if the data
+ * could not be kept (nothing is changed then).
+ *
+ */
+cache_inode_status_t cache_inode_unstable_add(cache_entry_t * pentry,
+                                              uint64_t offset,
+                                              fsal_size_t size,
+                                              caddr_t buffer,
+                                              fsal_op_context_t * pcontext,
+                                              int *pflush_needed)
+{
+  cache_inode_unstable_data_t *udata = &pentry->object.file.unstable_data;
+  cache_inode_unstable_extent_t **pprev;
+  cache_inode_unstable_extent_t *pextent;
+  cache_inode_unstable_extent_t *pnext;
+  uint64_t start = offset;
+  uint64_t end = offset + size;
+  fsal_size_t newsize;
+  caddr_t newbuffer;
+  fsal_size_t total;
+
+  *pflush_needed = FALSE;
+
+  /* First extent that ends at or after the new data */
+  for(pprev = &udata->extents; *pprev != NULL; pprev = &(*pprev)->next)
+    if((*pprev)->offset + (*pprev)->length >= start)
+      break;
+
+  pextent = *pprev;
+
+  if(pextent == NULL || pextent->offset > end)
+    {
+      /* Nothing to merge with, a new extent is inserted here */
+      if((pextent = (cache_inode_unstable_extent_t *)
+          Mem_Alloc(sizeof(cache_inode_unstable_extent_t))) == NULL)
+        return CACHE_INODE_MALLOC_ERROR;
+
+      if((pextent->buffer = Mem_Alloc(size)) == NULL)
+        {
+          Mem_Free(pextent);
+          return CACHE_INODE_MALLOC_ERROR;
+        }
+
+      pextent->offset = offset;
+      pextent->length = size;
+      pextent->size = size;
+      memcpy(pextent->buffer, buffer, size);
+
+      pextent->next = *pprev;
+      *pprev = pextent;
+
+      udata->nb_extents += 1;
+      total = cache_inode_unstable_account(pentry, size);
+
+      if(udata->nb_extents == 1)
+        {
+          /* The entry did not hold any pending data */
+          P(unstable_total_mutex);
+          cache_inode_unstable_link(pentry);
+          V(unstable_total_mutex);
+        }
+    }
+  else
+    {
+      /* Range covered by the new data and all the extents it touches */
+      if(pextent->offset < start)
+        start = pextent->offset;
+
+      for(pnext = pextent; pnext != NULL && pnext->offset <= end; pnext = pnext->next)
+        if(pnext->offset + pnext->length > end)
+          end = pnext->offset + pnext->length;
+
+      if(start == pextent->offset && end - start <= pextent->size)
+        {
+          /* The data fit in the buffer of the first extent */
+          newbuffer = pextent->buffer;
+          newsize = pextent->size;
+        }
+      else
+        {
+          /* Double the buffer, so that a sequential stream is copied a few times only */
+          newsize = 2 * pextent->size;
+          if(newsize < end - start)
+            newsize = end - start;
+
+          if((newbuffer = Mem_Alloc(newsize)) == NULL)
+            return CACHE_INODE_MALLOC_ERROR;
+
+          memcpy(newbuffer + (pextent->offset - start), pextent->buffer, pextent->length);
+        }
+
+      /* Absorb the following extents, then put the new data over the older ones */
+      while((pnext = pextent->next) != NULL && pnext->offset <= end)
+        {
+          memcpy(newbuffer + (pnext->offset - start), pnext->buffer, pnext->length);
+
+          pextent->next = pnext->next;
+          cache_inode_unstable_free_extent(pentry, pnext);
+        }
+
+      memcpy(newbuffer + (offset - start), buffer, size);
+
+      if(newbuffer != pextent->buffer)
+        {
+          Mem_Free(pextent->buffer);
+          cache_inode_unstable_account(pentry, (long long)newsize - (long long)pextent->size);
+          pextent->buffer = newbuffer;
+          pextent->size = newsize;
+        }
+
+      pextent->offset = start;
+      pextent->length = end - start;
+
+      P(unstable_total_mutex);
+      total = unstable_total;
+      V(unstable_total_mutex);
+    }
+
+  /* The flusher thread writes the data with the credentials of the last write */
+  udata->export_context = FSAL_GET_EXP_CTX(pcontext);
+  udata->uid = FSAL_OP_CONTEXT_TO_UID(pcontext);
+  udata->gid = FSAL_OP_CONTEXT_TO_GID(pcontext);
+
+  if(udata->size > CACHE_INODE_UNSTABLE_BUFFERSIZE
+     || udata->nb_extents > CACHE_INODE_UNSTABLE_MAX_EXTENTS)
+    *pflush_needed = TRUE;
+  else if(total > (fsal_size_t) CACHE_INODE_UNSTABLE_TOTALSIZE
+          || time(NULL) - udata->oldest > CACHE_INODE_UNSTABLE_DELAY)
+    {
+      /* The flusher thread chooses the files to flush among all of them */
+      if(unstable_flusher_started)
+        {
+          P(unstable_total_mutex);
+          pthread_cond_signal(&unstable_flusher_cond);
+          V(unstable_total_mutex);
+        }
+      else
+        *pflush_needed = TRUE;
+    }
+
+  return CACHE_INODE_SUCCESS;
+}                               /* cache_inode_unstable_add */
+
+/**
+ *
+ * cache_inode_unstable_forget: drops the pending unstable data in a range.
+ *
+ * Used when the range is overwritten by a stable write or truncated, so that
+ * older data are never flushed over it. The entry must be write locked.
+ *
+ * @param pentry [INOUT] entry whose data are dropped.
+ * @param offset [IN] start of the range.
+ * @param size [IN] size of the range, 0 means up to the end of the file.
+ *
+ * @return CACHE_INODE_SUCCESS if successful, CACHE_INODE_MALLOC_ERROR if an
+ * extent could not be split.
+ *
+ */
+cache_inode_status_t cache_inode_unstable_forget(cache_entry_t * pentry,
+                                                 uint64_t offset, fsal_size_t size)
+{
+  cache_inode_unstable_extent_t **pprev;
+  cache_inode_unstable_extent_t *pextent;
+  cache_inode_unstable_extent_t *ptail;
+  uint64_t end = (size == 0) ? (uint64_t) - 1 : offset + size;
+  uint64_t extent_end;
+
+  pprev = &pentry->object.file.unstable_data.extents;
+
+  while((pextent = *pprev) != NULL && pextent->offset < end)
+    {
+      extent_end = pextent->offset + pextent->length;
+
+      if(extent_end <= offset)
+        {
+          pprev = &pextent->next;
+          continue;
+        }
+
+      if(pextent->offset >= offset && extent_end <= end)
+        {
+          /* The whole extent is dropped */
+          *pprev = pextent->next;
+          cache_inode_unstable_free_extent(pentry, pextent);
+          continue;
+        }
+
+      if(pextent->offset < offset && extent_end > end)
+        {
+          /* The range is in the middle of the extent, its tail becomes a new extent */
+          if((ptail = (cache_inode_unstable_extent_t *)
+              Mem_Alloc(sizeof(cache_inode_unstable_extent_t))) == NULL)
+            return CACHE_INODE_MALLOC_ERROR;
+
+          ptail->length = extent_end - end;
+          if((ptail->buffer = Mem_Alloc(ptail->length)) == NULL)
+            {
+              Mem_Free(ptail);
+              return CACHE_INODE_MALLOC_ERROR;
+            }
+
+          memcpy(ptail->buffer, pextent->buffer + (end - pextent->offset), ptail->length);
+          ptail->offset = end;
+          ptail->size = ptail->length;
+          ptail->next = pextent->next;
+
+          pextent->next = ptail;
+          pentry->object.file.unstable_data.nb_extents += 1;
+          cache_inode_unstable_account(pentry, ptail->size);
+
+          pextent->length = offset - pextent->offset;
+          break;
+        }
+
+      if(pextent->offset < offset)
+        {
+          /* The range covers the end of the extent */
+          pextent->length = offset - pextent->offset;
+          pprev = &pextent->next;
+        }
+      else
+        {
+          /* The range covers the beginning of the extent */
+          memmove(pextent->buffer, pextent->buffer + (end - pextent->offset),
+                  extent_end - end);
+          pextent->length = extent_end - end;
+          pextent->offset = end;
+          break;
+        }
+    }
+
+  cache_inode_unstable_clean(pentry);
+
+  return CACHE_INODE_SUCCESS;
+}                               /* cache_inode_unstable_forget */
+
+/**
+ *
+ * cache_inode_unstable_read: puts the pending unstable data over the result of a read.
+ *
+ * The bytes between the end of the data read from the FSAL and pending data
+ * located after them are a hole, they are zeroed. The entry must be locked.
+ *
+ * @param pentry [IN] entry read.
+ * @param offset [IN] offset of the read.
+ * @param io_size [IN] size asked by the read.
+ * @param pio_size [INOUT] size read from the FSAL, then size including the pending data.
+ * @param buffer [INOUT] the data read.
+ *
+ * @return TRUE if pending data were found after the data read from the FSAL.
+ *
+ */
+int cache_inode_unstable_read(cache_entry_t * pentry,
+                              uint64_t offset,
+                              fsal_size_t io_size, fsal_size_t * pio_size, caddr_t buffer)
+{
+  cache_inode_unstable_extent_t *pextent;
+  uint64_t end = offset + io_size;
+  uint64_t data_end = offset + *pio_size;
+  uint64_t pending_end;
+  uint64_t from;
+  uint64_t to;
+
+  if(pentry->object.file.unstable_data.extents == NULL)
+    return FALSE;
+
+  /* The FSAL data stop before the pending data: what lies between them is a hole */
+  pending_end = cache_inode_unstable_end(pentry);
+  if(pending_end > end)
+    pending_end = end;
+
+  if(pending_end > data_end)
+    {
+      memset(buffer + (data_end - offset), 0, pending_end - data_end);
+      data_end = pending_end;
+    }
+
+  for(pextent = pentry->object.file.unstable_data.extents;
+      pextent != NULL && pextent->offset < end; pextent = pextent->next)
+    {
+      if(pextent->offset + pextent->length <= offset)
+        continue;
+
+      from = (pextent->offset > offset) ? pextent->offset : offset;
+      to = pextent->offset + pextent->length;
+      if(to > end)
+        to = end;
+
+      memcpy(buffer + (from - offset), pextent->buffer + (from - pextent->offset), to - from);
+    }
+
+  if(data_end == offset + *pio_size)
+    return FALSE;
+
+  *pio_size = data_end - offset;
+  return TRUE;
+}                               /* cache_inode_unstable_read */
+
+/**
+ *
+ * cache_inode_unstable_end: returns the end of the pending unstable data of an entry
+ * (0 if there is none). The entry must be locked.
+ *
+ */
+uint64_t cache_inode_unstable_end(cache_entry_t * pentry)
+{
+  cache_inode_unstable_extent_t *pextent;
+
+  if((pextent = pentry->object.file.unstable_data.extents) == NULL)
+    return 0;
+
+  while(pextent->next != NULL)
+    pextent = pextent->next;
+
+  return pextent->offset + pextent->length;
+}                               /* cache_inode_unstable_end */
+
+/**
+ *
+ * cache_inode_unstable_filesize: extends the cached size of an entry up to the end of
+ * its pending unstable data, after the size was read from the FSAL. The entry must be
+ * write locked.
+ *
+ */
+void cache_inode_unstable_filesize(cache_entry_t * pentry)
+{
+  uint64_t end = cache_inode_unstable_end(pentry);
+
+  if(end > pentry->object.file.attributes.filesize)
+    pentry->object.file.attributes.filesize = end;
+}                               /* cache_inode_unstable_filesize */
+
+/**
+ *
+ * cache_inode_unstable_release: drops all the pending unstable data of an entry
+ * that is removed from the cache.
+ *
+ * Waits for the flusher thread to be done with the entry, if it is flushing it.
+ *
+ */
+void cache_inode_unstable_release(cache_entry_t * pentry)
+{
+  cache_inode_unstable_extent_t *pextent;
+
+  P(unstable_total_mutex);
+
+  while(pentry->object.file.unstable_data.flushing)
+    pthread_cond_wait(&unstable_flushed_cond, &unstable_total_mutex);
+
+  cache_inode_unstable_unlink(pentry);
+
+  V(unstable_total_mutex);
+
+  while((pextent = pentry->object.file.unstable_data.extents) != NULL)
+    {
+      pentry->object.file.unstable_data.extents = pextent->next;
+      cache_inode_unstable_free_extent(pentry, pextent);
+    }
+}                               /* cache_inode_unstable_release */
+
+/*
+ * Writes an extent to the FSAL (or the data cache) in IOs of CACHE_INODE_UNSTABLE_FLUSHSIZE
+ * bytes aligned on this size.
+ */
+static cache_inode_status_t cache_inode_unstable_write_extent(cache_entry_t * pentry,
+                                                              cache_inode_unstable_extent_t *
+                                                              pextent,
+                                                              cache_inode_client_t * pclient,
+                                                              fsal_op_context_t * pcontext)
+{
+  fsal_status_t fsal_status;
+  cache_content_status_t cache_content_status;
+  fsal_seek_t seek_descriptor;
+  fsal_size_t io_size;
+  fsal_size_t size_io_done;
+  fsal_boolean_t eof;
+  struct stat buffstat;
+  uint64_t pos = pextent->offset;
+  uint64_t end = pextent->offset + pextent->length;
+  uint64_t chunk_end;
+
+  seek_descriptor.whence = FSAL_SEEK_SET;
+
+  while(pos < end)
+    {
+      chunk_end = (pos / CACHE_INODE_UNSTABLE_FLUSHSIZE + 1) * CACHE_INODE_UNSTABLE_FLUSHSIZE;
+      if(chunk_end > end)
+        chunk_end = end;
+
+      seek_descriptor.offset = pos;
+      io_size = chunk_end - pos;
+      size_io_done = 0;
+
+      if(pentry->object.file.pentry_content != NULL)
+        {
+          cache_content_rdwr(pentry->object.file.pentry_content,
+                             CACHE_CONTENT_WRITE,
+                             &seek_descriptor,
+                             &io_size,
+                             &size_io_done,
+                             pextent->buffer + (pos - pextent->offset),
+                             &eof,
+                             &buffstat,
+                             (cache_content_client_t *) pclient->pcontent_client,
+                             pcontext, &cache_content_status);
+
+          if(cache_content_status != CACHE_CONTENT_SUCCESS)
+            return cache_content_error_convert(cache_content_status);
+
+          pentry->object.file.attributes.filesize = buffstat.st_size;
+          pentry->object.file.attributes.spaceused =
+              buffstat.st_blksize * buffstat.st_blocks;
+          cache_inode_unstable_filesize(pentry);
+        }
+      else
+        {
+#ifdef _USE_MFSL
+          fsal_status = MFSL_write(&(pentry->object.file.open_fd.fd),
+                                   &seek_descriptor,
+                                   io_size,
+                                   pextent->buffer + (pos - pextent->offset),
+                                   &size_io_done, &pclient->mfsl_context);
+#else
+          fsal_status = FSAL_write(&(pentry->object.file.open_fd.fd),
+                                   &seek_descriptor,
+                                   io_size,
+                                   pextent->buffer + (pos - pextent->offset), &size_io_done);
+#endif
+
+          if(FSAL_IS_ERROR(fsal_status))
+            return cache_inode_error_convert(fsal_status);
+        }
+
+      if(size_io_done != io_size)
+        return CACHE_INODE_IO_ERROR;
+
+      pos = chunk_end;
+    }
+
+  return CACHE_INODE_SUCCESS;
+}                               /* cache_inode_unstable_write_extent */
+
+/**
+ *
+ * cache_inode_unstable_flush: writes pending unstable data to the FSAL.
+ *
+ * The entry must be write locked: no read can miss the data being flushed and
+ * no stable write can be overwritten by older data. The extents that could not
+ * be written are kept.
+ *
+ * @param pentry [INOUT] entry whose data are flushed.
+ * @param offset [IN] start of the range to flush.
+ * @param count [IN] size of the range to flush, 0 means the whole file.
+ * @param pclient [IN]  ressource allocated by the client for the nfs management.
+ * @param pcontext [IN] fsal context for the operation.
+ * @param pstatus [OUT] returned status.
+ *
+ * @return CACHE_INODE_SUCCESS if successful.
+ *
+ */
+cache_inode_status_t cache_inode_unstable_flush(cache_entry_t * pentry,
+                                                uint64_t offset,
+                                                fsal_size_t count,
+                                                cache_inode_client_t * pclient,
+                                                fsal_op_context_t * pcontext,
+                                                cache_inode_status_t * pstatus)
+{
+  cache_inode_unstable_data_t *udata = &pentry->object.file.unstable_data;
+  cache_inode_unstable_extent_t **pprev;
+  cache_inode_unstable_extent_t *pextent;
+  fsal_attrib_list_t post_write_attr;
+  fsal_status_t fsal_status;
+
+  *pstatus = CACHE_INODE_SUCCESS;
+
+  if(udata->extents == NULL)
+    return *pstatus;
+
+  if(pentry->object.file.pentry_content == NULL)
+    {
+      if(cache_inode_open(pentry, pclient, FSAL_O_WRONLY, pcontext, pstatus) !=
+         CACHE_INODE_SUCCESS)
+        return *pstatus;
+    }
+
+  pprev = &udata->extents;
+  while((pextent = *pprev) != NULL)
+    {
+      if(count != 0 &&
+         (pextent->offset >= offset + count || pextent->offset + pextent->length <= offset))
+        {
+          pprev = &pextent->next;
+          continue;
+        }
+
+      if((*pstatus = cache_inode_unstable_write_extent(pentry, pextent, pclient, pcontext))
+         != CACHE_INODE_SUCCESS)
+        {
+          LogMajor(COMPONENT_CACHE_INODE,
+                   "cache_inode_unstable_flush: entry %p, could not write %llu bytes at offset %llu, status=%d",
+                   pentry, (unsigned long long)pextent->length,
+                   (unsigned long long)pextent->offset, *pstatus);
+          break;
+        }
+
+      *pprev = pextent->next;
+      cache_inode_unstable_free_extent(pentry, pextent);
+    }
+
+  cache_inode_unstable_clean(pentry);
+
+  /* Data read ahead before the flush are obsolete */
+  cache_inode_readahead_invalidate(pentry);
+
+  if(pentry->object.file.pentry_content != NULL)
+    return *pstatus;
+
+  if(*pstatus != CACHE_INODE_SUCCESS)
+    {
+      /* As in cache_inode_rdwr, the fd is not reused after a failed IO */
+#ifdef _USE_MFSL
+      MFSL_close(&(pentry->object.file.open_fd.fd), &pclient->mfsl_context);
+#else
+      FSAL_close(&(pentry->object.file.open_fd.fd));
+#endif
+      pentry->object.file.open_fd.last_op = 0;
+      pentry->object.file.open_fd.fileno = 0;
+
+      return *pstatus;
+    }
+
+  if(cache_inode_close(pentry, pclient, pstatus) != CACHE_INODE_SUCCESS)
+    return *pstatus;
+
+  /* Update the size from the FSAL, after the close (see cache_inode_rdwr) */
+  post_write_attr.asked_attributes = FSAL_ATTR_SIZE | FSAL_ATTR_SPACEUSED;
+  fsal_status = FSAL_getattrs(&(pentry->object.file.handle), pcontext, &post_write_attr);
+
+  if(FSAL_IS_ERROR(fsal_status))
+    {
+      *pstatus = cache_inode_error_convert(fsal_status);
+      return *pstatus;
+    }
+
+  pentry->object.file.attributes.filesize = post_write_attr.filesize;
+  pentry->object.file.attributes.spaceused = post_write_attr.spaceused;
+  cache_inode_unstable_filesize(pentry);
+
+  return *pstatus;
+}                               /* cache_inode_unstable_flush */
+
+/*
+ * Chooses the next entry to be flushed by the flusher thread: the largest one while
+ * the entries hold too much data, else the oldest one if its data have been pending
+ * for too long. The entries locked by other threads are skipped. The entry is returned
+ * write locked, and marked as being flushed. Must be called with unstable_total_mutex.
+ */
+static cache_entry_t *cache_inode_unstable_victim()
+{
+  cache_entry_t *pentry;
+  cache_entry_t *pvictim = NULL;
+  time_t now = time(NULL);
+
+  if(unstable_total > (fsal_size_t) CACHE_INODE_UNSTABLE_TOTALSIZE)
+    {
+      for(pentry = unstable_first; pentry != NULL;
+          pentry = pentry->object.file.unstable_data.next_dirty)
+        {
+          if(pvictim != NULL &&
+             pentry->object.file.unstable_data.size <= pvictim->object.file.unstable_data.size)
+            continue;
+
+          if(rw_lock_try_w(&pentry->lock) != 0)
+            continue;
+
+          if(pvictim != NULL)
+            V_w(&pvictim->lock);
+
+          pvictim = pentry;
+        }
+    }
+  else
+    {
+      for(pentry = unstable_first;
+          pentry != NULL
+          && now - pentry->object.file.unstable_data.oldest > CACHE_INODE_UNSTABLE_DELAY;
+          pentry = pentry->object.file.unstable_data.next_dirty)
+        if(rw_lock_try_w(&pentry->lock) == 0)
+          {
+            pvictim = pentry;
+            break;
+          }
+    }
+
+  if(pvictim != NULL)
+    pvictim->object.file.unstable_data.flushing = TRUE;
+
+  return pvictim;
+}                               /* cache_inode_unstable_victim */
+
+/**
+ *
+ * cache_inode_unstable_flusher: flushes the pending unstable data of the idle files.
+ *
+ * Main loop of the flusher thread. Every CACHE_INODE_UNSTABLE_FLUSHER_PERIOD seconds, or
+ * as soon as the entries hold more than CACHE_INODE_UNSTABLE_TOTALSIZE bytes, the data
+ * pending for more than CACHE_INODE_UNSTABLE_DELAY seconds are flushed, oldest first,
+ * then the largest entries are flushed until the memory used is below the limit. Once
+ * the thread is started, the writes leave these two triggers to it. An error is kept
+ * to be returned by the next COMMIT, and the entry is retried later.
+ *
+ * @param pclient [IN] ressource allocated by the thread for the cache inode management.
+ * @param pcontext [IN] fsal context of the thread, the credentials of the writes are set to it.
+ *
+ * @return never returns.
+ *
+ */
+void cache_inode_unstable_flusher(cache_inode_client_t * pclient,
+                                  fsal_op_context_t * pcontext)
+{
+  cache_inode_unstable_data_t *udata;
+  cache_entry_t *pentry;
+  cache_inode_status_t status;
+  fsal_status_t fsal_status;
+  struct timespec timeout;
+
+  P(unstable_total_mutex);
+
+  unstable_flusher_started = TRUE;
+
+  for(;;)
+    {
+      if((pentry = cache_inode_unstable_victim()) == NULL)
+        {
+          timeout.tv_sec = time(NULL) + CACHE_INODE_UNSTABLE_FLUSHER_PERIOD;
+          timeout.tv_nsec = 0;
+          pthread_cond_timedwait(&unstable_flusher_cond, &unstable_total_mutex, &timeout);
+          continue;
+        }
+
+      V(unstable_total_mutex);
+
+      udata = &pentry->object.file.unstable_data;
+
+      LogFullDebug(COMPONENT_CACHE_INODE,
+                   "cache_inode_unstable_flusher: flushing %u extents of entry %p",
+                   udata->nb_extents, pentry);
+
+      fsal_status = FSAL_GetClientContext(pcontext, udata->export_context,
+                                          udata->uid, udata->gid, NULL, 0);
+
+      if(FSAL_IS_ERROR(fsal_status))
+        status = cache_inode_error_convert(fsal_status);
+      else
+        cache_inode_unstable_flush(pentry, 0, 0, pclient, pcontext, &status);
+
+      P(unstable_total_mutex);
+
+      if(status != CACHE_INODE_SUCCESS)
+        {
+          udata->flush_status = status;
+
+          /* Retry it after the other ones */
+          cache_inode_unstable_unlink(pentry);
+          if(udata->extents != NULL)
+            cache_inode_unstable_link(pentry);
+        }
+
+      V_w(&pentry->lock);
+
+      /* The entry may be released from now on */
+      udata->flushing = FALSE;
+      pthread_cond_broadcast(&unstable_flushed_cond);
+    }
+}                               /* cache_inode_unstable_flusher */
+
 /**
  *
  * cache_inode_commit: commits a write operation on unstable storage
  *
- * Reads/Writes through the cache layer.
+ * Flushes the pending unstable data of the range to the FSAL. An error met by
+ * a flush made earlier on memory pressure is reported here.
  *
- * @param pentry [IN] entry in cache inode layer whose content is to be accessed.
- * @param read_or_write [IN] a flag of type cache_content_io_direction_t to tell if a read or write is to be done.
- * @param seek_descriptor [IN] absolute position (in the FSAL file) where the IO will be done.
- * @param buffer_size [IN] size of the buffer pointed by parameter 'buffer'.
- * @param pio_size [OUT] the size of the io that was successfully made.
+ * @param pentry [IN] entry in cache inode layer whose content is to be committed.
+ * @param offset [IN] start of the range to commit.
+ * @param count [IN] size of the range to commit, 0 means the whole file.
  * @param pfsal_attr [OUT] the FSAL attributes after the operation.
- * @param buffer write:[IN] read:[OUT] the buffer for the data.
  * @param ht [INOUT] the hashtable used for managing the cache.
  * @param pclient [IN]  ressource allocated by the client for the nfs management.
  * @param pcontext [IN] fsal context for the operation.
  * @pstatus [OUT] returned status.
  *
- * @return CACHE_CONTENT_SUCCESS is successful .
- *
- * @todo: BUGAZEOMEU; gestion de la taille du fichier a prendre en compte.
+ * @return CACHE_INODE_SUCCESS is successful .
  *
  */
 
@@ -92,62 +879,35 @@ cache_inode_commit(cache_entry_t * pentry,
                    fsal_op_context_t * pcontext,
                    cache_inode_status_t * pstatus)
 {
-    cache_inode_status_t status;
-    fsal_seek_t seek_descriptor;
-    fsal_size_t size_io_done;
-    fsal_boolean_t eof;
-    cache_inode_unstable_data_t *udata;
+  cache_inode_unstable_data_t *udata;
 
-    udata = &pentry->object.file.unstable_data;
-    if(udata->buffer == NULL)
-        {
-            *pstatus = CACHE_INODE_SUCCESS;
-            return *pstatus;
-        }
-    if(count == 0 || count == 0xFFFFFFFFL)
-        {
-            /* Count = 0 means "flush all data to permanent storage */
-            seek_descriptor.offset = udata->offset;
-            seek_descriptor.whence = FSAL_SEEK_SET;
+  *pstatus = CACHE_INODE_SUCCESS;
 
-            status = cache_inode_rdwr(pentry,
-                                      CACHE_INODE_WRITE,
-                                      &seek_descriptor, udata->length,
-                                      &size_io_done, pfsal_attr,
-                                      udata->buffer, &eof, ht,
-                                      pclient, pcontext, TRUE, pstatus);
-            if (status != CACHE_INODE_SUCCESS)
-                return *pstatus;
+  P_w(&pentry->lock);
 
-            P_w(&pentry->lock);
+  if(pentry->internal_md.type != REGULAR_FILE)
+    {
+      *pstatus = CACHE_INODE_BAD_TYPE;
+      V_w(&pentry->lock);
+      return *pstatus;
+    }
 
-            Mem_Free(udata->buffer);
-            udata->buffer = NULL;
+  udata = &pentry->object.file.unstable_data;
 
-            V_w(&pentry->lock);
-        }
-    else
-        {
-            if(offset < udata->offset)
-                {
-                    *pstatus = CACHE_INODE_INVALID_ARGUMENT;
-                    return *pstatus;
-                }
+  /* Count = 0 means "flush all data to permanent storage" */
+  if(count == 0xFFFFFFFFL)
+    count = 0;
 
-            seek_descriptor.offset = offset;
-            seek_descriptor.whence = FSAL_SEEK_SET;
+  cache_inode_unstable_flush(pentry, offset, count, pclient, pcontext, pstatus);
+
+  if(*pstatus == CACHE_INODE_SUCCESS && udata->flush_status != CACHE_INODE_SUCCESS)
+    *pstatus = udata->flush_status;
+  udata->flush_status = CACHE_INODE_SUCCESS;
+
+  if(pfsal_attr != NULL)
+    *pfsal_attr = pentry->object.file.attributes;
+
+  V_w(&pentry->lock);
 
-            return cache_inode_rdwr(pentry,
-                                    CACHE_INODE_WRITE,
-                                    &seek_descriptor,
-                                    count,
-                                    &size_io_done,
-                                    pfsal_attr,
-                                    (char *)(udata->buffer + offset - udata->offset),
-                                    &eof, ht, pclient,
-                                    pcontext, TRUE, pstatus);
-    }
-  /* Regulat exit */
-  *pstatus = CACHE_INODE_SUCCESS;
   return *pstatus;
-}
+}                               /* cache_inode_commit */
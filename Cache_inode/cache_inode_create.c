@@ -312,6 +312,9 @@ cache_inode_create(cache_entry_t * pentry_parent,
             break;
         }
 
+    /* Even if it fails later (or with EEXIST), the name may exist now */
+    cache_inode_negative_dirent_forget(pentry_parent, pname);
+
     /* Check for the result */
     if(FSAL_IS_ERROR(fsal_status))
         {
@@ -186,9 +186,16 @@ static int cache_inode_gc_clean_entry(cache_entry_t * pentry,
 
   LogFullDebug(COMPONENT_CACHE_INODE_GC, "++++> parent directory sent back to pool\n");
 
+  /* The data read ahead for a file go back with it */
+  if(pentry->internal_md.type == REGULAR_FILE)
+    cache_inode_readahead_invalidate(pentry);
+
   /* If entry is a DIR_CONTINUE or a DIR_BEGINNING, release pdir_data */
   if(pentry->internal_md.type == DIR_BEGINNING)
     {
+      cache_inode_dirent_index_release(pentry);
+      cache_inode_negative_dirent_release(pentry);
+
       /* Put the pentry back to the pool */
       RELEASE_PREALLOC(pentry->object.dir_begin.pdir_data,
                        pgcparam->pclient->pool_dir_data, next_alloc);
@@ -196,6 +203,8 @@ static int cache_inode_gc_clean_entry(cache_entry_t * pentry,
 
   if(pentry->internal_md.type == DIR_CONTINUE)
     {
+      cache_inode_dirent_index_forget_dircont(pentry);
+
       /* Put the pentry back to the pool */
       RELEASE_PREALLOC(pentry->object.dir_cont.pdir_data,
                        pgcparam->pclient->pool_dir_data, next_alloc);
@@ -328,6 +337,14 @@ int cache_inode_gc_suppress_file(cache_entry_t * pentry,
 {
   P_w(&pentry->lock);
 
+  /* Pending unstable data are kept until they are committed */
+  if(pentry->internal_md.type == REGULAR_FILE
+     && pentry->object.file.unstable_data.extents != NULL)
+    {
+      V_w(&pentry->lock);
+      return LRU_LIST_DO_NOT_SET_INVALID;
+    }
+
   LogFullDebug(COMPONENT_CACHE_INODE_GC,
                     "Entry %p (REGULAR_FILE/SYMBOLIC_LINK) will be garbaged");
 
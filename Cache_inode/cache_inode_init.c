@@ -112,6 +112,7 @@ int cache_inode_client_init(cache_inode_client_t * pclient,
   pclient->grace_period_attr = param.grace_period_attr;
   pclient->grace_period_link = param.grace_period_link;
   pclient->grace_period_dirent = param.grace_period_dirent;
+  pclient->grace_period_negative = param.grace_period_negative;
   pclient->use_test_access = param.use_test_access;
   pclient->getattr_dir_invalidation = param.getattr_dir_invalidation;
   pclient->pworker = pworker_data;
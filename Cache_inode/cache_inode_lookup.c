@@ -83,7 +83,6 @@ cache_entry_t *cache_inode_lookup_sw(cache_entry_t * pentry_parent,
                                      fsal_op_context_t * pcontext,
                                      cache_inode_status_t * pstatus, int use_mutex)
 {
-  cache_entry_t *pdir_chain = NULL;
   cache_entry_t *pentry = NULL;
   fsal_status_t fsal_status;
 #ifdef _USE_MFSL
@@ -98,7 +97,6 @@ cache_entry_t *cache_inode_lookup_sw(cache_entry_t * pentry_parent,
   cache_inode_status_t cache_status;
 
   cache_inode_fsal_data_t new_entry_fsdata;
-  int i = 0;
 
   /* Set the return default to CACHE_INODE_SUCCESS */
   *pstatus = CACHE_INODE_SUCCESS;
@@ -157,79 +155,36 @@ cache_entry_t *cache_inode_lookup_sw(cache_entry_t * pentry_parent,
           return NULL;
         }
 
-      /* Try to look into the dir and its dir_cont. At this point, it must be said than lock on dir_cont are
-       *  taken when a lock is previously acquired on the related dir_begin */
-      pdir_chain = pentry_parent;
+      /* Look for the name in the index of the dir and its dir_cont. At this point, it must be said than
+       * lock on dir_cont are taken when a lock is previously acquired on the related dir_begin */
+      if((pentry = cache_inode_dirent_index_lookup(pentry_parent, pname, NULL, NULL)) != NULL)
+        LogFullDebug(COMPONENT_CACHE_INODE, "Cache Hit detected");
 
-      do
+      /* The name may be known not to exist, the FSAL doesn't need to be asked again */
+      if(pentry == NULL && cache_inode_negative_dirent_lookup(pentry_parent, pname, pclient))
         {
-          /* Is this entry known ? */
-          if(pdir_chain->internal_md.type == DIR_BEGINNING)
-            {
-              for(i = 0; i < CHILDREN_ARRAY_SIZE; i++)
-                {
-                  if(pdir_chain->object.dir_begin.pdir_data->dir_entries[i].active ==
-                     VALID)
-                    if(!FSAL_namecmp
-                       (pname,
-                        &(pentry_parent->object.dir_begin.pdir_data->dir_entries[i].
-                          name)))
-                      {
-                        /* Entry was found */
-                        pentry =
-                            pentry_parent->object.dir_begin.pdir_data->dir_entries[i].
-                            pentry;
-                        LogDebug(COMPONENT_CACHE_INODE, "Cache Hit detected (dir_begin)");
-                        break;
-                      }
-                }
+          LogFullDebug(COMPONENT_CACHE_INODE, "Negative Cache Hit detected");
 
-              /* Do we have to go on browsing the cache_inode ? */
-              if(pdir_chain->object.dir_begin.end_of_dir == END_OF_DIR)
-                {
-                  break;
-                }
+          *pstatus = CACHE_INODE_NOT_FOUND;
 
-              /* Next step */
-              pdir_chain = pdir_chain->object.dir_begin.pdir_cont;
-            }
-          else
-            {
-              /* The element in the dir_chain is a DIR_CONTINUE */
-              for(i = 0; i < CHILDREN_ARRAY_SIZE; i++)
-                {
-                  if(pdir_chain->object.dir_cont.pdir_data->dir_entries[i].active ==
-                     VALID)
-                    if(!FSAL_namecmp
-                       (pname,
-                        &(pdir_chain->object.dir_cont.pdir_data->dir_entries[i].name)))
-                      {
-                        /* Entry was found */
-                        pentry =
-                            pdir_chain->object.dir_cont.pdir_data->dir_entries[i].pentry;
-                        LogFullDebug(COMPONENT_CACHE_INODE, "Cache Hit detected (dir_cont)");
-                        break;
-                      }
-                }
+          if(use_mutex == TRUE)
+            V_r(&pentry_parent->lock);
 
-              /* Do we have to go on browsing the cache_inode ? */
-              if(pdir_chain->object.dir_cont.end_of_dir == END_OF_DIR)
-                {
-                  break;
-                }
-
-              /* Next step */
-              pdir_chain = pdir_chain->object.dir_cont.pdir_cont;
-            }
+          /* stats */
+          pclient->stat.nb_negative_hit += 1;
+          pclient->stat.func_stats.nb_err_unrecover[CACHE_INODE_LOOKUP] += 1;
 
+          return NULL;
         }
-      while(pentry == NULL);
 
       /* At this point, if pentry == NULL, we are not looking for a known son, query fsal for lookup */
       if(pentry == NULL)
         {
           LogFullDebug(COMPONENT_CACHE_INODE, "Cache Miss detected");
 
+          /* stats */
+          pclient->stat.nb_negative_miss += 1;
+
           if(pentry_parent->internal_md.type == DIR_BEGINNING)
             dir_handle = pentry_parent->object.dir_begin.handle;
 
@@ -282,6 +237,10 @@ cache_entry_t *cache_inode_lookup_sw(cache_entry_t * pentry_parent,
             {
               *pstatus = cache_inode_error_convert(fsal_status);
 
+              /* Remember the name is missing, until something is created with it */
+              if(fsal_status.major == ERR_FSAL_NOENT)
+                cache_inode_negative_dirent_add(pentry_parent, pname, pclient);
+
               if(use_mutex == TRUE)
                 V_r(&pentry_parent->lock);
 
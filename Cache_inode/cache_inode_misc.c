@@ -407,6 +407,7 @@ cache_entry_t *cache_inode_new_entry(cache_inode_fsal_data_t * pfsdata,
       memset(&(pentry->object.file.open_fd.fd), 0, sizeof(fsal_file_t));
       memset(&(pentry->object.file.unstable_data), 0,
              sizeof(cache_inode_unstable_data_t));
+      memset(&(pentry->object.file.readahead), 0, sizeof(cache_inode_readahead_t));
 #ifdef _USE_PROXY
       pentry->object.file.pname = NULL;
       pentry->object.file.pentry_parent_open = NULL;
@@ -435,6 +436,8 @@ cache_entry_t *cache_inode_new_entry(cache_inode_fsal_data_t * pfsdata,
       pentry->object.dir_begin.nbactive = 0;
       pentry->object.dir_begin.nbdircont = 0;
       pentry->object.dir_begin.referral = NULL;
+      cache_inode_dirent_index_init(pentry);
+      cache_inode_negative_dirent_init(pentry);
 
       for(i = 0; i < CHILDREN_ARRAY_SIZE; i++)
         {
@@ -1608,11 +1611,25 @@ cache_inode_status_t cache_inode_kill_entry(cache_entry_t * pentry,
             &cache_content_status) != CACHE_CONTENT_SUCCESS)
           LogCrit(COMPONENT_CACHE_INODE,
                             "Could not removed datacached entry for pentry %p", pentry);
+
+      /* The file is stale: its pending unstable data cannot be written anymore */
+      if(pentry->object.file.unstable_data.extents != NULL)
+        LogMajor(COMPONENT_CACHE_INODE,
+                 "cache_inode_kill_entry: entry %p, dropping %u extents of unstable data",
+                 pentry, pentry->object.file.unstable_data.nb_extents);
+
+      cache_inode_unstable_release(pentry);
+
+      /* The data read ahead for the file go back with it */
+      cache_inode_readahead_invalidate(pentry);
     }
 
   /* If entry is a DIR_CONTINUE or a DIR_BEGINNING, release pdir_data */
   if(pentry->internal_md.type == DIR_BEGINNING)
     {
+      cache_inode_dirent_index_release(pentry);
+      cache_inode_negative_dirent_release(pentry);
+
       for(i = 0; i < CHILDREN_ARRAY_SIZE; i++)
         {
           pentry->object.dir_begin.pdir_data->dir_entries[i].active = INVALID;
@@ -1625,6 +1642,9 @@ cache_inode_status_t cache_inode_kill_entry(cache_entry_t * pentry,
 
   if(pentry->internal_md.type == DIR_CONTINUE)
     {
+      /* The DIR_BEGINNING may stay in the cache, it must not index this entry anymore */
+      cache_inode_dirent_index_forget_dircont(pentry);
+
       for(i = 0; i < CHILDREN_ARRAY_SIZE; i++)
         {
           pentry->object.dir_cont.pdir_data->dir_entries[i].active = INVALID;
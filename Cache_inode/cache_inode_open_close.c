@@ -141,6 +141,9 @@ cache_inode_status_t cache_inode_open(cache_entry_t * pentry,
           return *pstatus;
         }
 
+      /* The size returned by the FSAL does not include the pending unstable data */
+      cache_inode_unstable_filesize(pentry);
+
       pentry->object.file.open_fd.fileno = FSAL_FILENO(&(pentry->object.file.open_fd.fd));
       pentry->object.file.open_fd.openflags = openflags;
 
@@ -302,6 +305,9 @@ cache_inode_status_t cache_inode_open_by_name(cache_entry_t * pentry_dir,
           pentry_file->object.file.attributes.mtime = save_mtime;
         }
 
+      /* The size returned by the FSAL does not include the pending unstable data */
+      cache_inode_unstable_filesize(pentry_file);
+
       pentry_file->object.file.open_fd.fileno =
           (int)FSAL_FILENO(&(pentry_file->object.file.open_fd.fd));
       pentry_file->object.file.open_fd.last_op = time(NULL);
@@ -59,6 +59,387 @@
 #include <time.h>
 #include <pthread.h>
 
+/* Byte-range locks held during the IOs made directly through the FSAL.
+ * Ranges are queued per stripe of a global table (selected from the pentry),
+ * a range waits for the conflicting ranges queued before it: reads only
+ * conflict with overlapping writes, writes with any overlapping IO. */
+
+#define CACHE_INODE_RANGE_LOCK_STRIPES 64
+
+typedef struct cache_inode_range__
+{
+  cache_entry_t *pentry;
+  fsal_off_t offset;
+  fsal_size_t length;
+  int exclusive;
+  struct cache_inode_range__ *next;
+} cache_inode_range_t;
+
+typedef struct cache_inode_range_stripe__
+{
+  pthread_mutex_t mutex;
+  pthread_cond_t cond;
+  cache_inode_range_t *head;
+} cache_inode_range_stripe_t;
+
+static cache_inode_range_stripe_t range_stripes[CACHE_INODE_RANGE_LOCK_STRIPES];
+static pthread_once_t range_stripes_once = PTHREAD_ONCE_INIT;
+
+static void cache_inode_range_stripes_init(void)
+{
+  int i;
+
+  for(i = 0; i < CACHE_INODE_RANGE_LOCK_STRIPES; i++)
+    {
+      pthread_mutex_init(&range_stripes[i].mutex, NULL);
+      pthread_cond_init(&range_stripes[i].cond, NULL);
+      range_stripes[i].head = NULL;
+    }
+}                               /* cache_inode_range_stripes_init */
+
+static cache_inode_range_stripe_t *cache_inode_range_stripe(cache_entry_t * pentry)
+{
+  return &range_stripes[((unsigned long)pentry / sizeof(cache_entry_t)) %
+                        CACHE_INODE_RANGE_LOCK_STRIPES];
+}                               /* cache_inode_range_stripe */
+
+/* Is there a range queued before prange that conflicts with it ? */
+static int cache_inode_range_conflict(cache_inode_range_stripe_t * pstripe,
+                                      cache_inode_range_t * prange)
+{
+  cache_inode_range_t *piter;
+
+  for(piter = pstripe->head; piter != prange; piter = piter->next)
+    if(piter->pentry == prange->pentry
+       && (piter->exclusive || prange->exclusive)
+       && piter->offset < prange->offset + prange->length
+       && prange->offset < piter->offset + piter->length)
+      return TRUE;
+
+  return FALSE;
+}                               /* cache_inode_range_conflict */
+
+/*
+ * Locks [offset, offset+length[ in pentry, shared for a read and exclusive for a write.
+ * prange is provided by the caller and must stay valid until cache_inode_range_unlock.
+ */
+static void cache_inode_range_lock(cache_inode_range_t * prange,
+                                   cache_entry_t * pentry,
+                                   fsal_off_t offset, fsal_size_t length, int exclusive)
+{
+  cache_inode_range_stripe_t *pstripe;
+  cache_inode_range_t **ppiter;
+
+  pthread_once(&range_stripes_once, cache_inode_range_stripes_init);
+  pstripe = cache_inode_range_stripe(pentry);
+
+  prange->pentry = pentry;
+  prange->offset = offset;
+  prange->length = length;
+  prange->exclusive = exclusive;
+  prange->next = NULL;
+
+  P(pstripe->mutex);
+
+  /* Queue at the tail, so that waiting writes are not starved by new reads */
+  for(ppiter = &pstripe->head; *ppiter != NULL; ppiter = &(*ppiter)->next) ;
+  *ppiter = prange;
+
+  while(cache_inode_range_conflict(pstripe, prange))
+    pthread_cond_wait(&pstripe->cond, &pstripe->mutex);
+
+  V(pstripe->mutex);
+}                               /* cache_inode_range_lock */
+
+static void cache_inode_range_unlock(cache_inode_range_t * prange)
+{
+  cache_inode_range_stripe_t *pstripe = cache_inode_range_stripe(prange->pentry);
+  cache_inode_range_t **ppiter;
+
+  P(pstripe->mutex);
+
+  for(ppiter = &pstripe->head; *ppiter != NULL; ppiter = &(*ppiter)->next)
+    if(*ppiter == prange)
+      {
+        *ppiter = prange->next;
+        break;
+      }
+
+  pthread_cond_broadcast(&pstripe->cond);
+
+  V(pstripe->mutex);
+}                               /* cache_inode_range_unlock */
+
+/*
+ * Calls FSAL_read or FSAL_write (or their MFSL counterpart) on the fd opened in pentry,
+ * while holding a byte-range lock on the accessed bytes.
+ */
+static fsal_status_t cache_inode_rdwr_fsal(cache_entry_t * pentry,
+                                           cache_inode_io_direction_t read_or_write,
+                                           fsal_seek_t * seek_descriptor,
+                                           fsal_size_t io_size,
+                                           fsal_size_t * pio_size,
+                                           caddr_t buffer,
+                                           fsal_boolean_t * p_fsal_eof,
+                                           cache_inode_client_t * pclient)
+{
+  fsal_status_t fsal_status;
+  cache_inode_range_t range;
+
+  cache_inode_range_lock(&range, pentry, seek_descriptor->offset, io_size,
+                         (read_or_write == CACHE_INODE_WRITE));
+
+  switch (read_or_write)
+    {
+    case CACHE_INODE_READ:
+#ifdef _USE_MFSL
+      fsal_status = MFSL_read(&(pentry->object.file.open_fd.fd),
+                              seek_descriptor,
+                              io_size,
+                              buffer, pio_size, p_fsal_eof, &pclient->mfsl_context);
+#else
+      fsal_status = FSAL_read(&(pentry->object.file.open_fd.fd),
+                              seek_descriptor, io_size, buffer, pio_size, p_fsal_eof);
+#endif
+      break;
+
+    case CACHE_INODE_WRITE:
+#ifdef _USE_MFSL
+      fsal_status = MFSL_write(&(pentry->object.file.open_fd.fd),
+                               seek_descriptor,
+                               io_size, buffer, pio_size, &pclient->mfsl_context);
+#else
+      fsal_status = FSAL_write(&(pentry->object.file.open_fd.fd),
+                               seek_descriptor, io_size, buffer, pio_size);
+#endif
+      break;
+    }
+
+  cache_inode_range_unlock(&range);
+
+  return fsal_status;
+}                               /* cache_inode_rdwr_fsal */
+
+/*
+ * Reads from the FSAL like cache_inode_rdwr_fsal, unless the data were read ahead, then
+ * lets the readahead follow the access pattern of the entry, which must be locked.
+ */
+static fsal_status_t cache_inode_rdwr_read(cache_entry_t * pentry,
+                                           fsal_seek_t * seek_descriptor,
+                                           fsal_size_t io_size,
+                                           fsal_size_t * pio_size,
+                                           caddr_t buffer,
+                                           fsal_boolean_t * p_fsal_eof,
+                                           cache_inode_client_t * pclient,
+                                           fsal_op_context_t * pcontext)
+{
+  fsal_status_t fsal_status;
+  int hit;
+
+  hit = cache_inode_readahead_get(pentry, seek_descriptor->offset, io_size, pio_size,
+                                  buffer, p_fsal_eof);
+
+  if(hit)
+    {
+      fsal_status.major = ERR_FSAL_NO_ERROR;
+      fsal_status.minor = 0;
+    }
+  else
+    fsal_status = cache_inode_rdwr_fsal(pentry, CACHE_INODE_READ, seek_descriptor, io_size,
+                                        pio_size, buffer, p_fsal_eof, pclient);
+
+  if(!FSAL_IS_ERROR(fsal_status))
+    cache_inode_readahead_track(pentry, seek_descriptor->offset, *pio_size, *p_fsal_eof,
+                                hit, pcontext);
+
+  return fsal_status;
+}                               /* cache_inode_rdwr_read */
+
+/*
+ * Completes the eof returned by FSAL_read with the file size cached in the entry, which
+ * must be locked. Only when the size is not cached, the byte following the data is read
+ * from the FSAL to know if the file goes on.
+ */
+static void cache_inode_rdwr_eof(cache_entry_t * pentry,
+                                 fsal_seek_t * seek_descriptor,
+                                 fsal_size_t read_size,
+                                 fsal_boolean_t * p_fsal_eof,
+                                 cache_inode_client_t * pclient)
+{
+  fsal_status_t fsal_status;
+  fsal_seek_t probe_descriptor;
+  fsal_size_t probe_size = 0;
+  fsal_boolean_t probe_eof = FALSE;
+  char c;
+
+  if(*p_fsal_eof == TRUE)
+    return;
+
+  if(FSAL_TEST_MASK(pentry->object.file.attributes.asked_attributes, FSAL_ATTR_SIZE))
+    {
+      *p_fsal_eof =
+          (seek_descriptor->offset + read_size >= pentry->object.file.attributes.filesize);
+      return;
+    }
+
+  probe_descriptor.whence = FSAL_SEEK_SET;
+  probe_descriptor.offset = seek_descriptor->offset + read_size;
+
+  fsal_status = cache_inode_rdwr_fsal(pentry, CACHE_INODE_READ, &probe_descriptor, 1,
+                                      &probe_size, (caddr_t) & c, &probe_eof, pclient);
+
+  *p_fsal_eof = (!FSAL_IS_ERROR(fsal_status) && probe_size == 0);
+}                               /* cache_inode_rdwr_eof */
+
+#ifdef _USE_SHARED_FSAL_IO
+/*
+ * Fast path of cache_inode_rdwr for a stable IO made directly through the FSAL on an
+ * already opened fd. The entry is only read locked during the IO, so that reads and
+ * non-overlapping writes on the same file run concurrently. The entry is then write
+ * locked to update its attributes, its position in the LRU and the fd's time of last
+ * use. The lock is released in between, so the fd may have been closed meanwhile.
+ *
+ * Returns FALSE, with nothing done, if the IO has to go through the regular path
+ * (entry is data cached, fd is not opened with the right flags, write over pending
+ * unstable data, IO failed...).
+ */
+static int cache_inode_rdwr_shared(cache_entry_t * pentry,
+                                   cache_inode_io_direction_t read_or_write,
+                                   fsal_openflags_t openflags,
+                                   fsal_seek_t * seek_descriptor,
+                                   fsal_size_t io_size,
+                                   fsal_size_t * pio_size,
+                                   fsal_attrib_list_t * pfsal_attr,
+                                   caddr_t buffer,
+                                   fsal_boolean_t * p_fsal_eof,
+                                   cache_inode_client_t * pclient,
+                                   fsal_op_context_t * pcontext,
+                                   cache_inode_status_t * pstatus)
+{
+  fsal_status_t fsal_status;
+  fsal_attrib_list_t post_write_attr;
+
+  P_r(&pentry->lock);
+
+  /* The fd must be usable as is: opening or closing it needs the write lock */
+  if(pentry->internal_md.type != REGULAR_FILE
+     || pentry->object.file.pentry_content != NULL
+     || pentry->object.file.open_fd.fileno == 0
+     || pentry->object.file.open_fd.last_op == 0
+     || pentry->object.file.open_fd.openflags != openflags
+     || pclient->use_cache == 0
+     || pentry->object.file.open_fd.fileno > (int)(pclient->max_fd_per_thread)
+     || (read_or_write == CACHE_INODE_WRITE
+         && pentry->object.file.unstable_data.extents != NULL)
+#ifdef _USE_PROXY
+     || pentry->object.file.pname != NULL
+     /* Without the pipelined client, the fd uses the CLIENT of the thread that opened it */
+     || pentry->object.file.open_fd.fd.pcontext->rpc_client != NULL
+#endif
+    )
+    {
+      V_r(&pentry->lock);
+      return FALSE;
+    }
+
+  if(read_or_write == CACHE_INODE_READ)
+    fsal_status = cache_inode_rdwr_read(pentry, seek_descriptor, io_size, pio_size, buffer,
+                                        p_fsal_eof, pclient, pcontext);
+  else
+    fsal_status = cache_inode_rdwr_fsal(pentry, read_or_write, seek_descriptor, io_size,
+                                        pio_size, buffer, p_fsal_eof, pclient);
+
+  LogFullDebug(COMPONENT_FSAL,
+               "FSAL IO operation returned %d, asked_size=%llu, effective_size=%llu",
+               fsal_status.major, (unsigned long long)io_size,
+               (unsigned long long)*pio_size);
+
+  /* Errors are managed by the regular path, which closes the fd */
+  if(FSAL_IS_ERROR(fsal_status))
+    {
+      V_r(&pentry->lock);
+      return FALSE;
+    }
+
+  if(read_or_write == CACHE_INODE_READ)
+    {
+      if(cache_inode_unstable_read(pentry, seek_descriptor->offset, io_size, pio_size,
+                                   buffer))
+        *p_fsal_eof = FALSE;
+
+      cache_inode_rdwr_eof(pentry, seek_descriptor, *pio_size, p_fsal_eof, pclient);
+    }
+
+  V_r(&pentry->lock);
+  P_w(&pentry->lock);
+
+  if(pentry->object.file.open_fd.last_op != 0)
+    pentry->object.file.open_fd.last_op = time(NULL);
+
+  if(read_or_write == CACHE_INODE_READ)
+    {
+      /* Set the atime */
+      pentry->object.file.attributes.atime.seconds = time(NULL);
+      pentry->object.file.attributes.atime.nseconds = 0;
+
+      if(pfsal_attr != NULL)
+        *pfsal_attr = pentry->object.file.attributes;
+
+      *pstatus = cache_inode_valid(pentry, CACHE_INODE_OP_GET, pclient);
+
+      V_w(&pentry->lock);
+
+      if(*pstatus != CACHE_INODE_SUCCESS)
+        pclient->stat.func_stats.nb_err_unrecover[CACHE_INODE_READ] += 1;
+      else
+        pclient->stat.func_stats.nb_success[CACHE_INODE_READ] += 1;
+
+      return TRUE;
+    }
+
+  /* Data read ahead may be older than the written ones */
+  cache_inode_readahead_invalidate(pentry);
+
+  /* Do a getattr in order to have update information on filesize, as in cache_inode_rdwr */
+  post_write_attr.asked_attributes = FSAL_ATTR_SIZE | FSAL_ATTR_SPACEUSED;
+  fsal_status = FSAL_getattrs(&(pentry->object.file.handle), pcontext, &post_write_attr);
+
+  if(FSAL_IS_ERROR(fsal_status))
+    {
+      *pstatus = cache_inode_error_convert(fsal_status);
+      V_w(&pentry->lock);
+
+      pclient->stat.func_stats.nb_err_unrecover[CACHE_INODE_WRITE_DATA] += 1;
+      return TRUE;
+    }
+
+  pentry->object.file.attributes.filesize = post_write_attr.filesize;
+  pentry->object.file.attributes.spaceused = post_write_attr.spaceused;
+  cache_inode_unstable_filesize(pentry);
+
+  /* Set mtime and ctime */
+  pentry->object.file.attributes.mtime.seconds = time(NULL);
+  pentry->object.file.attributes.mtime.nseconds = 0;
+
+  /* BUGAZOMEU : write operation must NOT modify file's ctime */
+  pentry->object.file.attributes.ctime = pentry->object.file.attributes.mtime;
+
+  if(pfsal_attr != NULL)
+    *pfsal_attr = pentry->object.file.attributes;
+
+  *pstatus = cache_inode_valid(pentry, CACHE_INODE_OP_SET, pclient);
+
+  V_w(&pentry->lock);
+
+  if(*pstatus != CACHE_INODE_SUCCESS)
+    pclient->stat.func_stats.nb_err_unrecover[CACHE_INODE_WRITE] += 1;
+  else
+    pclient->stat.func_stats.nb_success[CACHE_INODE_WRITE] += 1;
+
+  return TRUE;
+}                               /* cache_inode_rdwr_shared */
+#endif                          /* _USE_SHARED_FSAL_IO */
+
 /**
  *
  * cache_inode_rdwr: Reads/Writes through the cache layer.
@@ -75,7 +456,8 @@
  * @param ht [INOUT] the hashtable used for managing the cache. 
  * @param pclient [IN]  ressource allocated by the client for the nfs management.
  * @param pcontext [IN] fsal context for the operation.
- * @param stable[IN] if FALSE, data will be written to unstable storage (for implementing write/commit)
+ * @param stable[IN] if FALSE, data will be written to unstable storage (for implementing write/commit):
+ *                   they are kept in memory until a COMMIT or until too much data are pending.
  * @pstatus [OUT] returned status.
  *
  * @return CACHE_CONTENT_SUCCESS is successful .
@@ -107,6 +489,7 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
   fsal_status_t fsal_status_getattr;
   struct stat buffstat;
   bool_t stable_flag = stable;
+  int flush_needed = FALSE;
 
   /* Set the return default to CACHE_INODE_SUCCESS */
   *pstatus = CACHE_INODE_SUCCESS;
@@ -134,6 +517,9 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
       io_direction = CACHE_CONTENT_READ;
       openflags = FSAL_O_RDONLY;
       pclient->stat.func_stats.nb_call[CACHE_INODE_READ_DATA] += 1;
+
+      /* The FSAL only sets the eof when it met it */
+      *p_fsal_eof = FALSE;
     }
   else
     {
@@ -143,6 +529,15 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
       pclient->stat.func_stats.nb_call[CACHE_INODE_WRITE_DATA] += 1;
     }
 
+#ifdef _USE_SHARED_FSAL_IO
+  /* Stable IOs on an already opened file only need the entry to be read locked */
+  if(stable_flag == TRUE &&
+     cache_inode_rdwr_shared(pentry, read_or_write, openflags, seek_descriptor, io_size,
+                             pio_size, pfsal_attr, buffer, p_fsal_eof, pclient, pcontext,
+                             pstatus))
+    return *pstatus;
+#endif
+
   P_w(&pentry->lock);
 
   /* IO are done only on REGULAR_FILEs */
@@ -172,27 +567,13 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
   /* Do we use stable or unstable storage ? */
   if(stable_flag == FALSE)
     {
-      /* Data will be stored in memory and not flush to FSAL */
-
-      /* If the unstable_data buffer allocated ? */
-      if(pentry->object.file.unstable_data.buffer == NULL)
+      /* Data are kept in memory, gathered with the other pending writes of the file,
+       * and will be flushed to FSAL by a COMMIT or when too much data are pending */
+      if(cache_inode_unstable_add(pentry, seek_descriptor->offset, buffer_size, buffer,
+                                  pcontext, &flush_needed) == CACHE_INODE_SUCCESS)
         {
-          if((pentry->object.file.unstable_data.buffer =
-              Mem_Alloc(CACHE_INODE_UNSTABLE_BUFFERSIZE)) == NULL)
-            {
-              *pstatus = CACHE_INODE_MALLOC_ERROR;
-              V_w(&pentry->lock);
-
-              /* stats */
-              pclient->stat.func_stats.nb_err_unrecover[statindex] += 1;
-
-              return *pstatus;
-            }
-
-          pentry->object.file.unstable_data.offset = seek_descriptor->offset;
-          pentry->object.file.unstable_data.length = buffer_size;
-
-          memcpy(pentry->object.file.unstable_data.buffer, buffer, buffer_size);
+          if(seek_descriptor->offset + buffer_size > pentry->object.file.attributes.filesize)
+            pentry->object.file.attributes.filesize = seek_descriptor->offset + buffer_size;
 
           /* Set mtime and ctime */
           pentry->object.file.attributes.mtime.seconds = time(NULL);
@@ -202,37 +583,31 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
           pentry->object.file.attributes.ctime = pentry->object.file.attributes.mtime;
 
           *pio_size = buffer_size;
-        }                       /* if( pentry->object.file.unstable_data.buffer == NULL ) */
+        }
       else
         {
-          if((pentry->object.file.unstable_data.offset < seek_descriptor->offset) &&
-             (buffer_size + seek_descriptor->offset < CACHE_INODE_UNSTABLE_BUFFERSIZE))
-            {
-              pentry->object.file.unstable_data.length =
-                  buffer_size + seek_descriptor->offset;
-              memcpy((char *)(pentry->object.file.unstable_data.buffer +
-                              seek_descriptor->offset), buffer, buffer_size);
-
-              /* Set mtime and ctime */
-              pentry->object.file.attributes.mtime.seconds = time(NULL);
-              pentry->object.file.attributes.mtime.nseconds = 0;
-
-              /* BUGAZOMEU : write operation must NOT modify file's ctime */
-              pentry->object.file.attributes.ctime = pentry->object.file.attributes.mtime;
-
-              *pio_size = buffer_size;
-            }
-          else
-            {
-              /* Go back to regular situation */
-              stable_flag = TRUE;
-            }
+          /* Not enough memory to keep the data: go back to regular situation */
+          stable_flag = TRUE;
         }
 
     }
   /* if( stable_flag == FALSE ) */
   if(stable_flag == TRUE)
     {
+      /* Older pending unstable data must not be flushed over the written data */
+      if(read_or_write == CACHE_INODE_WRITE &&
+         cache_inode_unstable_forget(pentry, seek_descriptor->offset,
+                                     io_size) != CACHE_INODE_SUCCESS)
+        {
+          *pstatus = CACHE_INODE_MALLOC_ERROR;
+          V_w(&pentry->lock);
+
+          /* stats */
+          pclient->stat.func_stats.nb_err_unrecover[statindex] += 1;
+
+          return *pstatus;
+        }
+
       /* Calls file content cache to operate on the cache */
       if(pentry->object.file.pentry_content != NULL)
         {
@@ -317,6 +692,15 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
           pentry->object.file.attributes.filesize = buffstat.st_size;
           pentry->object.file.attributes.spaceused =
               buffstat.st_blksize * buffstat.st_blocks;
+          cache_inode_unstable_filesize(pentry);
+
+          if(read_or_write == CACHE_INODE_READ &&
+             cache_inode_unstable_read(pentry, seek_descriptor->offset, io_size, pio_size,
+                                       buffer))
+            {
+              *p_fsal_eof = FALSE;
+              cache_inode_rdwr_eof(pentry, seek_descriptor, *pio_size, p_fsal_eof, pclient);
+            }
 
         }
       else
@@ -342,37 +726,20 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
           rw_lock_downgrade(&pentry->lock);
 
           /* Call FSAL_read or FSAL_write */
+          if(read_or_write == CACHE_INODE_READ)
+            fsal_status = cache_inode_rdwr_read(pentry, seek_descriptor, io_size, pio_size,
+                                                buffer, p_fsal_eof, pclient, pcontext);
+          else
+            fsal_status = cache_inode_rdwr_fsal(pentry, read_or_write, seek_descriptor,
+                                                io_size, pio_size, buffer, p_fsal_eof,
+                                                pclient);
 
-          switch (read_or_write)
-            {
-            case CACHE_INODE_READ:
-#ifdef _USE_MFSL
-              fsal_status = MFSL_read(&(pentry->object.file.open_fd.fd),
-                                      seek_descriptor,
-                                      io_size,
-                                      buffer,
-                                      pio_size, p_fsal_eof, &pclient->mfsl_context);
-#else
-              fsal_status = FSAL_read(&(pentry->object.file.open_fd.fd),
-                                      seek_descriptor,
-                                      io_size, buffer, pio_size, p_fsal_eof);
-#endif
-              break;
-
-            case CACHE_INODE_WRITE:
-#ifdef _USE_MFSL
-              fsal_status = MFSL_write(&(pentry->object.file.open_fd.fd),
-                                       seek_descriptor,
-                                       io_size, buffer, pio_size, &pclient->mfsl_context);
-#else
-              fsal_status = FSAL_write(&(pentry->object.file.open_fd.fd),
-                                       seek_descriptor, io_size, buffer, pio_size);
-
-
-#endif
-
-              break;
-            }
+          /* Pending unstable data are read under the same lock as the FSAL data, so that
+           * a concurrent flush cannot hide them */
+          if(read_or_write == CACHE_INODE_READ && !FSAL_IS_ERROR(fsal_status) &&
+             cache_inode_unstable_read(pentry, seek_descriptor->offset, io_size, pio_size,
+                                       buffer))
+            *p_fsal_eof = FALSE;
 
           V_r(&pentry->lock);
           LogFullDebug(COMPONENT_FSAL,
@@ -426,6 +793,9 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
               return *pstatus;
             }
 
+          if(read_or_write == CACHE_INODE_READ)
+            cache_inode_rdwr_eof(pentry, seek_descriptor, *pio_size, p_fsal_eof, pclient);
+
           LogFullDebug(COMPONENT_CACHE_INODE,
                             "inode/direct: io_size=%llu, pio_size=%llu, eof=%d, seek=%d.%llu",
                             io_size, *pio_size, *p_fsal_eof, seek_descriptor->whence,
@@ -467,6 +837,7 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
                   /* Update Cache Inode attributes */
                   pentry->object.file.attributes.filesize = post_write_attr.filesize;
                   pentry->object.file.attributes.spaceused = post_write_attr.spaceused;
+                  cache_inode_unstable_filesize(pentry);
                 }
             }
 
@@ -490,11 +861,25 @@ cache_inode_status_t cache_inode_rdwr(cache_entry_t * pentry,
           /* BUGAZOMEU : write operation must NOT modify file's ctime */
           pentry->object.file.attributes.ctime = pentry->object.file.attributes.mtime;
 
+          /* Data read ahead may be older than the written ones */
+          cache_inode_readahead_invalidate(pentry);
+
           break;
         }
     }
 
   /* if(stable_flag == TRUE ) */
+  /* Too much unstable data are pending: flush them now. An error is kept to be
+   * returned by the next COMMIT, the write itself succeeded */
+  if(flush_needed == TRUE)
+    {
+      cache_inode_status_t flush_status;
+
+      if(cache_inode_unstable_flush(pentry, 0, 0, pclient, pcontext, &flush_status) !=
+         CACHE_INODE_SUCCESS)
+        pentry->object.file.unstable_data.flush_status = flush_status;
+    }
+
   /* Return attributes to caller */
   if(pfsal_attr != NULL)
     *pfsal_attr = pentry->object.file.attributes;
@@ -57,6 +57,7 @@
 #include <time.h>
 #include <pthread.h>
 #include <string.h>
+#include <stdlib.h>
 
 /**
  *
@@ -126,6 +127,13 @@ cache_inode_status_t cache_inode_read_conf_hash_parameter(config_file_t in_confi
         {
           pparam->hparam.nb_node_prealloc = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Concurrent_Mode"))
+        {
+          if(StrToBoolean(key_value))
+            pparam->hparam.flags |= HASHTABLE_FLAG_CONCURRENT;
+          else
+            pparam->hparam.flags &= ~HASHTABLE_FLAG_CONCURRENT;
+        }
       else
         {
           LogCrit(COMPONENT_CONFIG,
@@ -233,6 +241,10 @@ cache_inode_status_t cache_inode_read_conf_client_parameter(config_file_t in_con
         {
           pparam->grace_period_dirent = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Negative_Expiration_Time"))
+        {
+          pparam->grace_period_negative = atoi(key_value);
+        }
       else if(!strcasecmp(key_name, "Use_Getattr_Directory_Invalidation"))
         {
           pparam->getattr_dir_invalidation = StrToBoolean(key_value);
@@ -435,6 +447,8 @@ void cache_inode_print_conf_client_parameter(FILE * output,
           (int)param.grace_period_link);
   fprintf(output, "CacheInode Client: Directory_Expiration_Time    = %d\n",
           (int)param.grace_period_dirent);
+  fprintf(output, "CacheInode Client: Negative_Expiration_Time     = %d\n",
+          (int)param.grace_period_negative);
   fprintf(output, "CacheInode Client: Use_Test_Access              = %d\n",
           param.use_test_access);
 }                               /* cache_inode_print_conf_client_parameter */
@@ -465,3 +479,119 @@ void cache_inode_print_conf_gc_policy(FILE * output, cache_inode_gc_policy_t gcp
           gcpolicy.nb_call_before_gc);
   fprintf(output, "Garbage Policy: Runtime_Interval    = %d\n", gcpolicy.run_interval);
 }                               /* cache_inode_print_gc_pol */
+
+/**
+ *
+ * cache_inode_read_conf_readahead_parameter: read the readahead parameters in configuration file.
+ *
+ * Reads the readahead parameters in configuration file.
+ *
+ * @param in_config [IN] configuration file handle
+ * @param pparam [OUT] read parameters
+ *
+ * @return CACHE_INODE_SUCCESS if ok, CACHE_INODE_NOT_FOUND is stanza is not there, CACHE_INODE_INVALID_ARGUMENT otherwise.
+ *
+ */
+cache_inode_status_t cache_inode_read_conf_readahead_parameter(config_file_t in_config,
+                                                               cache_inode_readahead_param_t *
+                                                               pparam)
+{
+  int var_max;
+  int var_index;
+  int err;
+  char *key_name;
+  char *key_value;
+  config_item_t block;
+
+  /* Is the config tree initialized ? */
+  if(in_config == NULL || pparam == NULL)
+    return CACHE_INODE_INVALID_ARGUMENT;
+
+  /* Get the config BLOCK */
+  if((block = config_FindItemByName(in_config, CONF_LABEL_CACHE_INODE_READAHEAD)) == NULL)
+    {
+      return CACHE_INODE_NOT_FOUND;
+    }
+  else if(config_ItemType(block) != CONFIG_ITEM_BLOCK)
+    {
+      /* Expected to be a block */
+      return CACHE_INODE_INVALID_ARGUMENT;
+    }
+
+  var_max = config_GetNbItems(block);
+
+  for(var_index = 0; var_index < var_max; var_index++)
+    {
+      config_item_t item;
+
+      item = config_GetItemByIndex(block, var_index);
+
+      /* Get key's name */
+      if((err = config_GetKeyValue(item, &key_name, &key_value)) != 0)
+        {
+          LogCrit(COMPONENT_CONFIG,
+                  "Error reading key[%d] from section \"%s\" of configuration file.",
+                  var_index, CONF_LABEL_CACHE_INODE_READAHEAD);
+          return CACHE_INODE_INVALID_ARGUMENT;
+        }
+
+      if(!strcasecmp(key_name, "Nb_Threads"))
+        {
+          pparam->nb_threads = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Max_Memory"))
+        {
+          pparam->max_memory = strtoull(key_value, NULL, 10);
+        }
+      else if(!strcasecmp(key_name, "Min_Window"))
+        {
+          pparam->min_window = strtoull(key_value, NULL, 10);
+        }
+      else if(!strcasecmp(key_name, "Max_Window"))
+        {
+          pparam->max_window = strtoull(key_value, NULL, 10);
+        }
+      else
+        {
+          LogCrit(COMPONENT_CONFIG,
+                  "Unknown or unsettable key: %s (item %s)",
+                  key_name, CONF_LABEL_CACHE_INODE_READAHEAD);
+          return CACHE_INODE_INVALID_ARGUMENT;
+        }
+
+    }
+
+  if(pparam->min_window > pparam->max_window)
+    {
+      LogCrit(COMPONENT_CONFIG,
+              "Min_Window is greater than Max_Window (item %s)",
+              CONF_LABEL_CACHE_INODE_READAHEAD);
+      return CACHE_INODE_INVALID_ARGUMENT;
+    }
+
+  return CACHE_INODE_SUCCESS;
+}                               /* cache_inode_read_conf_readahead_parameter */
+
+/**
+ *
+ * cache_inode_print_conf_readahead_parameter: prints the readahead parameters.
+ *
+ * Prints the readahead parameters.
+ *
+ * @param output [IN] a descriptor to the IO for printing the data.
+ * @param param [IN] structure to be printed.
+ *
+ * @return nothing (void function).
+ *
+ */
+void cache_inode_print_conf_readahead_parameter(FILE * output,
+                                                cache_inode_readahead_param_t param)
+{
+  fprintf(output, "CacheInode Readahead: Nb_Threads = %u\n", param.nb_threads);
+  fprintf(output, "CacheInode Readahead: Max_Memory = %llu\n",
+          (unsigned long long)param.max_memory);
+  fprintf(output, "CacheInode Readahead: Min_Window = %llu\n",
+          (unsigned long long)param.min_window);
+  fprintf(output, "CacheInode Readahead: Max_Window = %llu\n",
+          (unsigned long long)param.max_window);
+}                               /* cache_inode_print_conf_readahead_parameter */
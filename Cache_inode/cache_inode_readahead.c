@@ -0,0 +1,634 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    cache_inode_readahead.c
+ * \brief   Readahead of the files read sequentially.
+ *
+ * cache_inode_readahead.c : Readahead of the files read sequentially.
+ *
+ * The reads made directly through the FSAL are tracked per entry. Once a file
+ * is read sequentially, the data following the last read are queued to a pool
+ * of readahead threads, that read them from the FSAL into buffers. The next
+ * reads are served from these buffers (waiting for the one being read if
+ * needed). The size of the data read ahead (the window) doubles each time a
+ * read is served from the buffers, up to Max_Window, and is halved when
+ * buffers are dropped without having been used.
+ *
+ * The buffers of a sequential stream are all read by the thread that takes the
+ * first of them, through a file descriptor it opens once for the stream (some
+ * FSALs tie a descriptor to the context of the thread that opened it). The
+ * stream is retired when its entry drops its buffers or meets the end of file,
+ * and its owner closes the descriptor once the buffers are gone.
+ *
+ * The buffers of all the entries and the queue are protected by a single
+ * mutex. The buffer list of an entry is only changed with the entry locked
+ * (read or write), so that a thread holding the write lock of an entry can
+ * look at its list without taking the mutex.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif                          /* _SOLARIS */
+
+#include "fsal.h"
+
+#include "LRU_List.h"
+#include "log_macros.h"
+#include "HashData.h"
+#include "HashTable.h"
+#include "cache_inode.h"
+#include "stuff_alloc.h"
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/param.h>
+#include <time.h>
+#include <pthread.h>
+#include <string.h>
+#include <errno.h>
+
+static cache_inode_readahead_param_t readahead_param;
+static int readahead_started = FALSE;
+
+static pthread_mutex_t readahead_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t readahead_queue_cond = PTHREAD_COND_INITIALIZER;      /* a buffer was queued */
+static pthread_cond_t readahead_done_cond = PTHREAD_COND_INITIALIZER;       /* a buffer was read   */
+
+static cache_inode_readahead_buffer_t *readahead_queue_head = NULL;
+static cache_inode_readahead_buffer_t *readahead_queue_tail = NULL;
+
+/* Memory accounted for the buffers queued, being read or read */
+static fsal_size_t readahead_memory = 0;
+
+/* For each thread, the streams whose file descriptor it must close */
+static cache_inode_readahead_stream_t **readahead_closed = NULL;
+
+/*
+ * Releases a reference to a stream. The last one hands its file descriptor to the
+ * thread that opened it. Must be called with readahead_mutex.
+ */
+static void cache_inode_readahead_release(cache_inode_readahead_stream_t * pstream)
+{
+  if(--pstream->refcount > 0)
+    return;
+
+  if(pstream->opened)
+    {
+      pstream->next_closed = readahead_closed[pstream->owner];
+      readahead_closed[pstream->owner] = pstream;
+      pthread_cond_broadcast(&readahead_queue_cond);
+    }
+  else
+    Mem_Free(pstream);
+}                               /* cache_inode_readahead_release */
+
+/* Removes a buffer from the queue. Must be called with readahead_mutex. */
+static void cache_inode_readahead_unqueue(cache_inode_readahead_buffer_t * pbuffer)
+{
+  cache_inode_readahead_buffer_t **pprev;
+
+  for(pprev = &readahead_queue_head; *pprev != pbuffer; pprev = &(*pprev)->next_queued) ;
+
+  *pprev = pbuffer->next_queued;
+
+  if(readahead_queue_tail == pbuffer)
+    for(readahead_queue_tail = readahead_queue_head;
+        readahead_queue_tail != NULL && readahead_queue_tail->next_queued != NULL;
+        readahead_queue_tail = readahead_queue_tail->next_queued) ;
+}                               /* cache_inode_readahead_unqueue */
+
+/*
+ * Frees a buffer unlinked from its entry. A buffer being read is only marked, the
+ * readahead thread frees it once the read is over. Must be called with readahead_mutex.
+ */
+static void cache_inode_readahead_free(cache_inode_readahead_buffer_t * pbuffer)
+{
+  switch (pbuffer->state)
+    {
+    case CACHE_INODE_READAHEAD_INPROGRESS:
+      pbuffer->state = CACHE_INODE_READAHEAD_CANCELLED;
+      return;
+
+    case CACHE_INODE_READAHEAD_QUEUED:
+      cache_inode_readahead_unqueue(pbuffer);
+      break;
+    }
+
+  readahead_memory -= pbuffer->length;
+  cache_inode_readahead_release(pbuffer->stream);
+
+  if(pbuffer->data != NULL)
+    Mem_Free(pbuffer->data);
+  Mem_Free(pbuffer);
+}                               /* cache_inode_readahead_free */
+
+/*
+ * Drops all the buffers of an entry and retires its stream, and returns the number
+ * of buffers that were dropped before being used. Must be called with readahead_mutex.
+ */
+static unsigned int cache_inode_readahead_drop(cache_entry_t * pentry)
+{
+  cache_inode_readahead_buffer_t *pbuffer;
+  unsigned int nb_unused = 0;
+
+  while((pbuffer = pentry->object.file.readahead.buffers) != NULL)
+    {
+      pentry->object.file.readahead.buffers = pbuffer->next;
+
+      if(pbuffer->state != CACHE_INODE_READAHEAD_FAILED)
+        nb_unused += 1;
+
+      cache_inode_readahead_free(pbuffer);
+    }
+
+  pentry->object.file.readahead.ahead_offset = 0;
+
+  if(pentry->object.file.readahead.stream != NULL)
+    {
+      cache_inode_readahead_release(pentry->object.file.readahead.stream);
+      pentry->object.file.readahead.stream = NULL;
+    }
+
+  return nb_unused;
+}                               /* cache_inode_readahead_drop */
+
+/*
+ * Reads a buffer from the FSAL, with the credentials of the client that caused the readahead.
+ * The file descriptor of the stream is opened by the first read, and only used by this thread.
+ * Returns TRUE if successful.
+ */
+static int cache_inode_readahead_read(cache_inode_readahead_buffer_t * pbuffer,
+                                       fsal_op_context_t * pcontext)
+{
+  cache_inode_readahead_stream_t *pstream = pbuffer->stream;
+  fsal_status_t fsal_status;
+  fsal_seek_t seek_descriptor;
+
+  fsal_status = FSAL_GetClientContext(pcontext, pbuffer->export_context,
+                                      pbuffer->uid, pbuffer->gid, NULL, 0);
+  if(FSAL_IS_ERROR(fsal_status))
+    return FALSE;
+
+  if((pbuffer->data = Mem_Alloc(pbuffer->length)) == NULL)
+    return FALSE;
+
+  if(!pstream->opened)
+    {
+      fsal_status = FSAL_open(&pbuffer->handle, pcontext, FSAL_O_RDONLY, &pstream->fd,
+                              NULL);
+      if(FSAL_IS_ERROR(fsal_status))
+        return FALSE;
+
+      pstream->opened = TRUE;
+    }
+
+  seek_descriptor.whence = FSAL_SEEK_SET;
+  seek_descriptor.offset = pbuffer->offset;
+
+  fsal_status = FSAL_read(&pstream->fd, &seek_descriptor, pbuffer->length, pbuffer->data,
+                          &pbuffer->read_size, &pbuffer->eof);
+
+  if(FSAL_IS_ERROR(fsal_status))
+    {
+      /* The next buffer of the stream reopens the file */
+      FSAL_close(&pstream->fd);
+      pstream->opened = FALSE;
+      return FALSE;
+    }
+
+  return TRUE;
+}                               /* cache_inode_readahead_read */
+
+/*
+ * Returns the first queued buffer a thread may read: the one of a stream it owns, or
+ * of a stream not read yet. Must be called with readahead_mutex.
+ */
+static cache_inode_readahead_buffer_t *cache_inode_readahead_next(int index)
+{
+  cache_inode_readahead_buffer_t *pbuffer;
+
+  for(pbuffer = readahead_queue_head; pbuffer != NULL; pbuffer = pbuffer->next_queued)
+    if(pbuffer->stream->owner == -1 || pbuffer->stream->owner == index)
+      break;
+
+  return pbuffer;
+}                               /* cache_inode_readahead_next */
+
+static void *cache_inode_readahead_thread(void *arg)
+{
+  fsal_op_context_t context;
+  cache_inode_readahead_buffer_t *pbuffer;
+  cache_inode_readahead_stream_t *pstream;
+  cache_inode_readahead_stream_t *pnext;
+  int index = (int)(unsigned long)arg;
+  char function_name[MAXNAMLEN];
+  int success;
+#ifndef _NO_BUDDY_SYSTEM
+  int rc;
+#endif
+
+  snprintf(function_name, MAXNAMLEN, "cache_inode_readahead_thread #%lu",
+           (unsigned long)arg);
+  SetNameFunction(function_name);
+
+#ifndef _NO_BUDDY_SYSTEM
+  if((rc = BuddyInit(NULL)) != BUDDY_SUCCESS)
+    {
+      LogCrit(COMPONENT_CACHE_INODE,
+              "%s: Memory manager could not be initialized, exiting...", function_name);
+      return NULL;
+    }
+#endif
+
+  /* Each thread has its own context: some FSALs keep a connection in it */
+  if(FSAL_IS_ERROR(FSAL_InitClientContext(&context)))
+    {
+      LogCrit(COMPONENT_CACHE_INODE, "%s: Error initializing thread's credential, exiting...",
+              function_name);
+      return NULL;
+    }
+
+  LogDebug(COMPONENT_CACHE_INODE, "%s: Starting", function_name);
+
+  for(;;)
+    {
+      P(readahead_mutex);
+
+      while(readahead_closed[index] == NULL &&
+            (pbuffer = cache_inode_readahead_next(index)) == NULL)
+        pthread_cond_wait(&readahead_queue_cond, &readahead_mutex);
+
+      if((pstream = readahead_closed[index]) != NULL)
+        {
+          /* Close the descriptors of the streams retired */
+          readahead_closed[index] = NULL;
+
+          V(readahead_mutex);
+
+          for(; pstream != NULL; pstream = pnext)
+            {
+              pnext = pstream->next_closed;
+              FSAL_close(&pstream->fd);
+              Mem_Free(pstream);
+            }
+
+          continue;
+        }
+
+      cache_inode_readahead_unqueue(pbuffer);
+
+      pbuffer->state = CACHE_INODE_READAHEAD_INPROGRESS;
+      pbuffer->stream->owner = index;
+
+      V(readahead_mutex);
+
+      success = cache_inode_readahead_read(pbuffer, &context);
+
+      P(readahead_mutex);
+
+      if(pbuffer->state == CACHE_INODE_READAHEAD_CANCELLED)
+        {
+          /* The entry dropped it while it was read */
+          readahead_memory -= pbuffer->length;
+          cache_inode_readahead_release(pbuffer->stream);
+          if(pbuffer->data != NULL)
+            Mem_Free(pbuffer->data);
+          Mem_Free(pbuffer);
+        }
+      else
+        {
+          pbuffer->state = success ? CACHE_INODE_READAHEAD_READY : CACHE_INODE_READAHEAD_FAILED;
+
+          pthread_cond_broadcast(&readahead_done_cond);
+        }
+
+      V(readahead_mutex);
+    }
+
+  return NULL;
+}                               /* cache_inode_readahead_thread */
+
+/**
+ *
+ * cache_inode_readahead_init: starts the readahead threads.
+ *
+ * @param param [IN] readahead parameters.
+ *
+ * @return 0 if successful, the error of pthread_create otherwise.
+ *
+ */
+int cache_inode_readahead_init(cache_inode_readahead_param_t param)
+{
+  pthread_attr_t attr_thr;
+  pthread_t thrid;
+  unsigned long i;
+  int rc;
+
+  readahead_param = param;
+
+  if(param.nb_threads == 0)
+    return 0;
+
+  if((readahead_closed = (cache_inode_readahead_stream_t **)
+      Mem_Alloc(param.nb_threads * sizeof(cache_inode_readahead_stream_t *))) == NULL)
+    return ENOMEM;
+
+  memset(readahead_closed, 0, param.nb_threads * sizeof(cache_inode_readahead_stream_t *));
+
+  pthread_attr_init(&attr_thr);
+  pthread_attr_setscope(&attr_thr, PTHREAD_SCOPE_SYSTEM);
+  pthread_attr_setdetachstate(&attr_thr, PTHREAD_CREATE_DETACHED);
+
+  for(i = 0; i < param.nb_threads; i++)
+    {
+      if((rc = pthread_create(&thrid, &attr_thr, cache_inode_readahead_thread,
+                              (void *)i)) != 0)
+        return rc;
+    }
+
+  readahead_started = TRUE;
+
+  return 0;
+}                               /* cache_inode_readahead_init */
+
+/**
+ *
+ * cache_inode_readahead_get: serves a read from the data read ahead.
+ *
+ * Waits for the data being read, if any. The entry must be locked.
+ *
+ * @param pentry [IN] entry read.
+ * @param offset [IN] offset of the read.
+ * @param io_size [IN] size of the read.
+ * @param pio_size [OUT] size of the data returned.
+ * @param buffer [OUT] the data.
+ * @param p_fsal_eof [OUT] TRUE if the end of file was met.
+ *
+ * @return TRUE if the read was served, FALSE if it must be made through the FSAL.
+ *
+ */
+int cache_inode_readahead_get(cache_entry_t * pentry,
+                              uint64_t offset,
+                              fsal_size_t io_size,
+                              fsal_size_t * pio_size,
+                              caddr_t buffer, fsal_boolean_t * p_fsal_eof)
+{
+  cache_inode_readahead_buffer_t *pbuffer;
+  fsal_size_t done = 0;
+  fsal_size_t size;
+  uint64_t pos;
+  int served = FALSE;
+
+  if(readahead_started == FALSE || pentry->object.file.readahead.buffers == NULL)
+    return FALSE;
+
+  P(readahead_mutex);
+
+  for(;;)
+    {
+      pos = offset + done;
+
+      for(pbuffer = pentry->object.file.readahead.buffers; pbuffer != NULL;
+          pbuffer = pbuffer->next)
+        if(pbuffer->offset <= pos && pos < pbuffer->offset + pbuffer->length)
+          break;
+
+      if(pbuffer == NULL)
+        break;
+
+      if(pbuffer->state == CACHE_INODE_READAHEAD_INPROGRESS)
+        {
+          pthread_cond_wait(&readahead_done_cond, &readahead_mutex);
+          continue;
+        }
+
+      if(pbuffer->state != CACHE_INODE_READAHEAD_READY)
+        break;
+
+      if(pos < pbuffer->offset + pbuffer->read_size)
+        {
+          size = pbuffer->offset + pbuffer->read_size - pos;
+          if(size > io_size - done)
+            size = io_size - done;
+
+          memcpy(buffer + done, pbuffer->data + (pos - pbuffer->offset), size);
+          done += size;
+        }
+
+      if(done == io_size || pbuffer->read_size < pbuffer->length)
+        {
+          /* A short read means the end of file */
+          served = (done == io_size || pbuffer->eof);
+          *p_fsal_eof = pbuffer->eof && (offset + done == pbuffer->offset + pbuffer->read_size);
+          break;
+        }
+    }
+
+  if(served)
+    {
+      /* The buffers used up by this read are not needed by the stream anymore */
+      while((pbuffer = pentry->object.file.readahead.buffers) != NULL &&
+            pbuffer->state == CACHE_INODE_READAHEAD_READY &&
+            pbuffer->offset + pbuffer->length <= offset + done)
+        {
+          pentry->object.file.readahead.buffers = pbuffer->next;
+          cache_inode_readahead_free(pbuffer);
+        }
+
+      *pio_size = done;
+    }
+
+  V(readahead_mutex);
+
+  return served;
+}                               /* cache_inode_readahead_get */
+
+/**
+ *
+ * cache_inode_readahead_track: follows the access pattern of an entry after a read,
+ * and queues the data to be read ahead on a sequential stream.
+ *
+ * The entry must be locked.
+ *
+ * @param pentry [IN] entry read.
+ * @param offset [IN] offset of the read.
+ * @param read_size [IN] size of the data read.
+ * @param eof [IN] TRUE if the read met the end of file.
+ * @param hit [IN] TRUE if the read was served by cache_inode_readahead_get.
+ * @param pcontext [IN] fsal context of the read, whose credentials are used to read ahead.
+ *
+ * @return nothing (void function).
+ *
+ */
+void cache_inode_readahead_track(cache_entry_t * pentry,
+                                 uint64_t offset,
+                                 fsal_size_t read_size,
+                                 fsal_boolean_t eof, int hit, fsal_op_context_t * pcontext)
+{
+  cache_inode_readahead_t *pra = &pentry->object.file.readahead;
+  cache_inode_readahead_buffer_t *pbuffer;
+  cache_inode_readahead_buffer_t **plast;
+  uint64_t limit;
+
+  if(readahead_started == FALSE || read_size == 0)
+    return;
+
+  P(readahead_mutex);
+
+  if(offset == pra->next_offset)
+    pra->nb_sequential += 1;
+  else
+    {
+      /* Not part of the current stream: a new one may start here */
+      cache_inode_readahead_drop(pentry);
+
+      pra->nb_sequential = 1;
+      pra->window = 0;
+    }
+
+  pra->next_offset = offset + read_size;
+
+  /* The stream is over: nothing is left to read ahead */
+  if(eof)
+    cache_inode_readahead_drop(pentry);
+
+  if(eof || pra->nb_sequential < CACHE_INODE_READAHEAD_TRIGGER)
+    {
+      V(readahead_mutex);
+      return;
+    }
+
+  /* Adapt the window: grow it while the reads are served from the buffers */
+  if(pra->window == 0)
+    pra->window = readahead_param.min_window;
+  else if(hit && pra->window < readahead_param.max_window)
+    {
+      pra->window *= 2;
+      if(pra->window > readahead_param.max_window)
+        pra->window = readahead_param.max_window;
+    }
+
+  if(pra->ahead_offset < pra->next_offset)
+    pra->ahead_offset = pra->next_offset;
+
+  limit = pra->next_offset + ((pra->window > read_size) ? pra->window : read_size);
+  if(FSAL_TEST_MASK(pentry->object.file.attributes.asked_attributes, FSAL_ATTR_SIZE) &&
+     limit > pentry->object.file.attributes.filesize)
+    limit = pentry->object.file.attributes.filesize;
+
+  for(plast = &pra->buffers; *plast != NULL; plast = &(*plast)->next) ;
+
+  if(pra->stream == NULL && pra->ahead_offset < limit)
+    {
+      if((pra->stream = (cache_inode_readahead_stream_t *)
+          Mem_Alloc(sizeof(cache_inode_readahead_stream_t))) == NULL)
+        {
+          V(readahead_mutex);
+          return;
+        }
+
+      pra->stream->opened = FALSE;
+      pra->stream->owner = -1;
+      pra->stream->refcount = 1;
+      pra->stream->next_closed = NULL;
+    }
+
+  /* Buffers have the size of the client reads, so that each read uses a single one */
+  while(pra->ahead_offset < limit &&
+        readahead_memory + read_size <= readahead_param.max_memory)
+    {
+      if((pbuffer = (cache_inode_readahead_buffer_t *)
+          Mem_Alloc(sizeof(cache_inode_readahead_buffer_t))) == NULL)
+        break;
+
+      pbuffer->stream = pra->stream;
+      pra->stream->refcount += 1;
+      pbuffer->handle = pentry->object.file.handle;
+      pbuffer->export_context = FSAL_GET_EXP_CTX(pcontext);
+      pbuffer->uid = FSAL_OP_CONTEXT_TO_UID(pcontext);
+      pbuffer->gid = FSAL_OP_CONTEXT_TO_GID(pcontext);
+      pbuffer->offset = pra->ahead_offset;
+      pbuffer->length = read_size;
+      pbuffer->read_size = 0;
+      pbuffer->eof = FALSE;
+      pbuffer->state = CACHE_INODE_READAHEAD_QUEUED;
+      pbuffer->data = NULL;
+      pbuffer->next = NULL;
+      pbuffer->next_queued = NULL;
+
+      *plast = pbuffer;
+      plast = &pbuffer->next;
+
+      if(readahead_queue_tail == NULL)
+        readahead_queue_head = pbuffer;
+      else
+        readahead_queue_tail->next_queued = pbuffer;
+      readahead_queue_tail = pbuffer;
+
+      readahead_memory += read_size;
+      pra->ahead_offset += read_size;
+
+      pthread_cond_signal(&readahead_queue_cond);
+    }
+
+  V(readahead_mutex);
+}                               /* cache_inode_readahead_track */
+
+/**
+ *
+ * cache_inode_readahead_invalidate: drops the data read ahead for an entry.
+ *
+ * Called when the entry is written, truncated or removed from the cache. The
+ * next reads rebuild the buffers with a smaller window.
+ *
+ * @param pentry [INOUT] entry whose buffers are dropped.
+ *
+ * @return nothing (void function).
+ *
+ */
+void cache_inode_readahead_invalidate(cache_entry_t * pentry)
+{
+  cache_inode_readahead_t *pra = &pentry->object.file.readahead;
+
+  if(readahead_started == FALSE)
+    return;
+
+  P(readahead_mutex);
+
+  /* Data were read for nothing: read less ahead */
+  if(cache_inode_readahead_drop(pentry) > 0 && pra->window > readahead_param.min_window)
+    {
+      pra->window /= 2;
+      if(pra->window < readahead_param.min_window)
+        pra->window = readahead_param.min_window;
+    }
+
+  V(readahead_mutex);
+}                               /* cache_inode_readahead_invalidate */
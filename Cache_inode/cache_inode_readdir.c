@@ -55,6 +55,510 @@
 #include <sys/param.h>
 #include <time.h>
 #include <pthread.h>
+#include <string.h>
+
+#define CACHE_INODE_DIRENT_INDEX_MIN_SIZE 16    /* Initial number of buckets of a name index */
+#define CACHE_INODE_NEGATIVE_NB_MUTEX     64    /* Locks protecting the negative dirents     */
+
+/* Negative dirents are added by lookups, that only hold a read lock on the
+ * directory, so they have their own locks, shared by several directories. */
+static pthread_mutex_t negative_mutex[CACHE_INODE_NEGATIVE_NB_MUTEX];
+static pthread_once_t negative_once = PTHREAD_ONCE_INIT;
+
+static void cache_inode_negative_init_mutex(void)
+{
+  unsigned int i;
+
+  for(i = 0; i < CACHE_INODE_NEGATIVE_NB_MUTEX; i++)
+    pthread_mutex_init(&negative_mutex[i], NULL);
+}                               /* cache_inode_negative_init_mutex */
+
+/*
+ * Returns the DIR_BEGINNING whose name index covers a dir_chain member.
+ */
+static cache_entry_t *cache_inode_dirent_index_owner(cache_entry_t * pdir_chain)
+{
+  if(pdir_chain->internal_md.type == DIR_BEGINNING)
+    return pdir_chain;
+  else
+    return pdir_chain->object.dir_cont.pdir_begin;
+}                               /* cache_inode_dirent_index_owner */
+
+/*
+ * Returns the slot-th dirent of a DIR_BEGINNING or a DIR_CONTINUE.
+ */
+static cache_inode_dir_entry_t *cache_inode_dirent_slot(cache_entry_t * pdir_chain,
+                                                        unsigned int slot)
+{
+  if(pdir_chain->internal_md.type == DIR_BEGINNING)
+    return &pdir_chain->object.dir_begin.pdir_data->dir_entries[slot];
+  else
+    return &pdir_chain->object.dir_cont.pdir_data->dir_entries[slot];
+}                               /* cache_inode_dirent_slot */
+
+/*
+ * Hashes a name the same way FSAL_namecmp compares it (up to the first '\0').
+ */
+static unsigned int cache_inode_dirent_index_hash(fsal_name_t * pname)
+{
+  unsigned int hashval = 2166136261U;
+  int i;
+
+  for(i = 0; i < FSAL_MAX_NAME_LEN && pname->name[i] != '\0'; i++)
+    {
+      hashval ^= (unsigned char)pname->name[i];
+      hashval *= 16777619U;
+    }
+
+  return hashval;
+}                               /* cache_inode_dirent_index_hash */
+
+/**
+ *
+ * cache_inode_dirent_index_init: Sets the name index of a DIR_BEGINNING empty.
+ *
+ * @param pdir_begin [INOUT] the directory whose index is initialized.
+ *
+ */
+void cache_inode_dirent_index_init(cache_entry_t * pdir_begin)
+{
+  pdir_begin->object.dir_begin.name_index.buckets = NULL;
+  pdir_begin->object.dir_begin.name_index.size = 0;
+  pdir_begin->object.dir_begin.name_index.nb_entries = 0;
+}                               /* cache_inode_dirent_index_init */
+
+/**
+ *
+ * cache_inode_dirent_index_release: Frees the name index of a DIR_BEGINNING.
+ *
+ * The index is left empty and usable. No MT safety managed here !!
+ *
+ * @param pdir_begin [INOUT] the directory whose index is released.
+ *
+ */
+void cache_inode_dirent_index_release(cache_entry_t * pdir_begin)
+{
+  cache_inode_dirent_index_t *pindex = &pdir_begin->object.dir_begin.name_index;
+  cache_inode_dirent_index_node_t *pnode;
+  cache_inode_dirent_index_node_t *pnext;
+  unsigned int i;
+
+  for(i = 0; i < pindex->size; i++)
+    for(pnode = pindex->buckets[i]; pnode != NULL; pnode = pnext)
+      {
+        pnext = pnode->next;
+        Mem_Free(pnode);
+      }
+
+  if(pindex->buckets != NULL)
+    Mem_Free(pindex->buckets);
+
+  cache_inode_dirent_index_init(pdir_begin);
+}                               /* cache_inode_dirent_index_release */
+
+/*
+ * Doubles the number of buckets of an index. Returns 0 if successfull.
+ */
+static int cache_inode_dirent_index_grow(cache_inode_dirent_index_t * pindex)
+{
+  cache_inode_dirent_index_node_t **new_buckets;
+  cache_inode_dirent_index_node_t *pnode;
+  cache_inode_dirent_index_node_t *pnext;
+  unsigned int new_size;
+  unsigned int i;
+
+  new_size = (pindex->size == 0) ? CACHE_INODE_DIRENT_INDEX_MIN_SIZE : pindex->size * 2;
+
+  if((new_buckets = (cache_inode_dirent_index_node_t **)
+      Mem_Alloc(new_size * sizeof(cache_inode_dirent_index_node_t *))) == NULL)
+    return 1;
+
+  memset(new_buckets, 0, new_size * sizeof(cache_inode_dirent_index_node_t *));
+
+  for(i = 0; i < pindex->size; i++)
+    for(pnode = pindex->buckets[i]; pnode != NULL; pnode = pnext)
+      {
+        pnext = pnode->next;
+        pnode->next = new_buckets[pnode->hashval & (new_size - 1)];
+        new_buckets[pnode->hashval & (new_size - 1)] = pnode;
+      }
+
+  if(pindex->buckets != NULL)
+    Mem_Free(pindex->buckets);
+
+  pindex->buckets = new_buckets;
+  pindex->size = new_size;
+
+  return 0;
+}                               /* cache_inode_dirent_index_grow */
+
+/*
+ * Adds the slot-th dirent of pdir_chain to the name index, under its current name.
+ */
+static cache_inode_status_t cache_inode_dirent_index_add(cache_entry_t * pdir_chain,
+                                                         unsigned int slot)
+{
+  cache_inode_dirent_index_t *pindex =
+      &cache_inode_dirent_index_owner(pdir_chain)->object.dir_begin.name_index;
+  cache_inode_dirent_index_node_t *pnode;
+
+  /* Keep the buckets short. If the index can't grow, it just gets slower */
+  if(pindex->nb_entries >= pindex->size * 2)
+    if(cache_inode_dirent_index_grow(pindex) != 0 && pindex->size == 0)
+      return CACHE_INODE_MALLOC_ERROR;
+
+  if((pnode = (cache_inode_dirent_index_node_t *)
+      Mem_Alloc(sizeof(cache_inode_dirent_index_node_t))) == NULL)
+    return CACHE_INODE_MALLOC_ERROR;
+
+  pnode->hashval =
+      cache_inode_dirent_index_hash(&cache_inode_dirent_slot(pdir_chain, slot)->name);
+  pnode->slot = slot;
+  pnode->pdir_chain = pdir_chain;
+  pnode->next = pindex->buckets[pnode->hashval & (pindex->size - 1)];
+  pindex->buckets[pnode->hashval & (pindex->size - 1)] = pnode;
+  pindex->nb_entries += 1;
+
+  return CACHE_INODE_SUCCESS;
+}                               /* cache_inode_dirent_index_add */
+
+/*
+ * Removes the node of the slot-th dirent of pdir_chain from the name index.
+ * The dirent must still have the name it was indexed with.
+ */
+static void cache_inode_dirent_index_del(cache_entry_t * pdir_chain, unsigned int slot)
+{
+  cache_inode_dirent_index_t *pindex =
+      &cache_inode_dirent_index_owner(pdir_chain)->object.dir_begin.name_index;
+  cache_inode_dirent_index_node_t **ppnode;
+  cache_inode_dirent_index_node_t *pnode;
+  unsigned int hashval;
+
+  if(pindex->size == 0)
+    return;
+
+  hashval = cache_inode_dirent_index_hash(&cache_inode_dirent_slot(pdir_chain, slot)->name);
+
+  for(ppnode = &pindex->buckets[hashval & (pindex->size - 1)]; *ppnode != NULL;
+      ppnode = &(*ppnode)->next)
+    {
+      pnode = *ppnode;
+
+      if(pnode->pdir_chain == pdir_chain && pnode->slot == slot)
+        {
+          *ppnode = pnode->next;
+          Mem_Free(pnode);
+          pindex->nb_entries -= 1;
+          return;
+        }
+    }
+}                               /* cache_inode_dirent_index_del */
+
+/**
+ *
+ * cache_inode_dirent_index_forget_dircont: Removes all the dirents of a DIR_CONTINUE from the name index.
+ *
+ * Must be called before a DIR_CONTINUE is released while its DIR_BEGINNING stays in the cache.
+ *
+ * @param pdir_cont [IN] the DIR_CONTINUE to be released.
+ *
+ */
+void cache_inode_dirent_index_forget_dircont(cache_entry_t * pdir_cont)
+{
+  unsigned int i;
+
+  for(i = 0; i < CHILDREN_ARRAY_SIZE; i++)
+    cache_inode_dirent_index_del(pdir_cont, i);
+}                               /* cache_inode_dirent_index_forget_dircont */
+
+/**
+ *
+ * cache_inode_dirent_index_lookup: looks up for a name in the name index of a directory.
+ *
+ * Looks up for a name in the name index of the dir_chain pentry_parent belongs to. Only an
+ * active dirent with exactly this name is returned, index nodes pointing to a dirent invalidated
+ * by other means (garbage collection for example) are ignored.
+ *
+ * @param pentry_parent [IN]  DIR_BEGINNING or DIR_CONTINUE of the directory to be looked.
+ * @param pname         [IN]  name for the searched entry.
+ * @param ppdir_chain   [OUT] if not NULL, the DIR_BEGINNING or DIR_CONTINUE containing the dirent.
+ * @param pslot         [OUT] if not NULL, the position of the dirent in its dir_entries array.
+ *
+ * @return the found entry if it is in the dirent arrays, NULL otherwise.
+ *
+ */
+cache_entry_t *cache_inode_dirent_index_lookup(cache_entry_t * pentry_parent,
+                                               fsal_name_t * pname,
+                                               cache_entry_t ** ppdir_chain,
+                                               unsigned int *pslot)
+{
+  cache_inode_dirent_index_t *pindex =
+      &cache_inode_dirent_index_owner(pentry_parent)->object.dir_begin.name_index;
+  cache_inode_dirent_index_node_t *pnode;
+  cache_inode_dir_entry_t *pdirent;
+  unsigned int hashval;
+
+  if(pindex->size == 0)
+    return NULL;
+
+  hashval = cache_inode_dirent_index_hash(pname);
+
+  for(pnode = pindex->buckets[hashval & (pindex->size - 1)]; pnode != NULL;
+      pnode = pnode->next)
+    {
+      if(pnode->hashval != hashval)
+        continue;
+
+      pdirent = cache_inode_dirent_slot(pnode->pdir_chain, pnode->slot);
+
+      if(pdirent->active == VALID && pdirent->pentry != NULL
+         && !FSAL_namecmp(pname, &pdirent->name))
+        {
+          if(ppdir_chain != NULL)
+            *ppdir_chain = pnode->pdir_chain;
+          if(pslot != NULL)
+            *pslot = pnode->slot;
+
+          return pdirent->pentry;
+        }
+    }
+
+  return NULL;
+}                               /* cache_inode_dirent_index_lookup */
+
+/*
+ * Returns the lock protecting the negative dirents of a DIR_BEGINNING.
+ */
+static pthread_mutex_t *cache_inode_negative_mutex(cache_entry_t * pdir_begin)
+{
+  pthread_once(&negative_once, cache_inode_negative_init_mutex);
+
+  return &negative_mutex[((unsigned long)pdir_begin / sizeof(cache_entry_t)) %
+                         CACHE_INODE_NEGATIVE_NB_MUTEX];
+}                               /* cache_inode_negative_mutex */
+
+/**
+ *
+ * cache_inode_negative_dirent_init: Sets the negative dirents of a DIR_BEGINNING empty.
+ *
+ * @param pdir_begin [INOUT] the directory whose negative dirents are initialized.
+ *
+ */
+void cache_inode_negative_dirent_init(cache_entry_t * pdir_begin)
+{
+  pdir_begin->object.dir_begin.negative = NULL;
+  pdir_begin->object.dir_begin.nbnegative = 0;
+}                               /* cache_inode_negative_dirent_init */
+
+/**
+ *
+ * cache_inode_negative_dirent_release: Forgets all the negative dirents of a DIR_BEGINNING.
+ *
+ * This is used when the content of the directory may have changed behind our back.
+ *
+ * @param pdir_begin [INOUT] the directory whose negative dirents are released.
+ *
+ */
+void cache_inode_negative_dirent_release(cache_entry_t * pdir_begin)
+{
+  pthread_mutex_t *pmutex = cache_inode_negative_mutex(pdir_begin);
+  cache_inode_negative_dirent_t *pnegative;
+  cache_inode_negative_dirent_t *pnext;
+
+  P(*pmutex);
+
+  for(pnegative = pdir_begin->object.dir_begin.negative; pnegative != NULL;
+      pnegative = pnext)
+    {
+      pnext = pnegative->next;
+      Mem_Free(pnegative);
+    }
+
+  cache_inode_negative_dirent_init(pdir_begin);
+
+  V(*pmutex);
+}                               /* cache_inode_negative_dirent_release */
+
+/*
+ * Unchains and returns the negative dirent for a name, expired ones met on the
+ * way are freed. Must be called with the negative mutex of the directory held.
+ */
+static cache_inode_negative_dirent_t *cache_inode_negative_dirent_take(cache_entry_t *
+                                                                       pdir_begin,
+                                                                       fsal_name_t * pname,
+                                                                       time_t now)
+{
+  cache_inode_negative_dirent_t **ppnegative;
+  cache_inode_negative_dirent_t *pnegative;
+  unsigned int hashval = cache_inode_dirent_index_hash(pname);
+
+  ppnegative = &pdir_begin->object.dir_begin.negative;
+
+  while((pnegative = *ppnegative) != NULL)
+    {
+      if(pnegative->expire <= now)
+        {
+          *ppnegative = pnegative->next;
+          pdir_begin->object.dir_begin.nbnegative -= 1;
+          Mem_Free(pnegative);
+          continue;
+        }
+
+      if(pnegative->hashval == hashval && !FSAL_namecmp(pname, &pnegative->name))
+        {
+          *ppnegative = pnegative->next;
+          pdir_begin->object.dir_begin.nbnegative -= 1;
+          return pnegative;
+        }
+
+      ppnegative = &pnegative->next;
+    }
+
+  return NULL;
+}                               /* cache_inode_negative_dirent_take */
+
+/*
+ * Chains a negative dirent first in the list of its directory. Must be called
+ * with the negative mutex of the directory held.
+ */
+static void cache_inode_negative_dirent_put(cache_entry_t * pdir_begin,
+                                            cache_inode_negative_dirent_t * pnegative)
+{
+  pnegative->next = pdir_begin->object.dir_begin.negative;
+  pdir_begin->object.dir_begin.negative = pnegative;
+  pdir_begin->object.dir_begin.nbnegative += 1;
+}                               /* cache_inode_negative_dirent_put */
+
+/**
+ *
+ * cache_inode_negative_dirent_lookup: checks if a name is known not to exist in a directory.
+ *
+ * @param pentry_parent [IN]    DIR_BEGINNING or DIR_CONTINUE of the directory to be looked.
+ * @param pname         [IN]    name for the searched entry.
+ * @param pclient       [INOUT] ressource allocated by the client for the nfs management.
+ *
+ * @return TRUE if a valid negative dirent exists for this name, FALSE otherwise.
+ *
+ */
+int cache_inode_negative_dirent_lookup(cache_entry_t * pentry_parent,
+                                       fsal_name_t * pname,
+                                       cache_inode_client_t * pclient)
+{
+  cache_entry_t *pdir_begin = cache_inode_dirent_index_owner(pentry_parent);
+  pthread_mutex_t *pmutex;
+  cache_inode_negative_dirent_t *pnegative;
+
+  if(pclient->grace_period_negative == 0)
+    return FALSE;
+
+  pmutex = cache_inode_negative_mutex(pdir_begin);
+
+  P(*pmutex);
+
+  /* A hit moves the dirent first, so that the least used ones are evicted */
+  if((pnegative = cache_inode_negative_dirent_take(pdir_begin, pname, time(NULL))) != NULL)
+    cache_inode_negative_dirent_put(pdir_begin, pnegative);
+
+  V(*pmutex);
+
+  return (pnegative != NULL) ? TRUE : FALSE;
+}                               /* cache_inode_negative_dirent_lookup */
+
+/**
+ *
+ * cache_inode_negative_dirent_add: remembers that a name does not exist in a directory.
+ *
+ * The negative dirent is trusted for pclient->grace_period_negative seconds. When the directory
+ * has too many of them, the least recently used one is replaced.
+ *
+ * @param pentry_parent [INOUT] DIR_BEGINNING or DIR_CONTINUE of the directory.
+ * @param pname         [IN]    the missing name.
+ * @param pclient       [INOUT] ressource allocated by the client for the nfs management.
+ *
+ */
+void cache_inode_negative_dirent_add(cache_entry_t * pentry_parent,
+                                     fsal_name_t * pname,
+                                     cache_inode_client_t * pclient)
+{
+  cache_entry_t *pdir_begin = cache_inode_dirent_index_owner(pentry_parent);
+  pthread_mutex_t *pmutex;
+  cache_inode_negative_dirent_t **ppnegative;
+  cache_inode_negative_dirent_t *pnegative;
+  time_t now;
+
+  if(pclient->grace_period_negative == 0)
+    return;
+
+  now = time(NULL);
+  pmutex = cache_inode_negative_mutex(pdir_begin);
+
+  P(*pmutex);
+
+  if((pnegative = cache_inode_negative_dirent_take(pdir_begin, pname, now)) == NULL)
+    {
+      if(pdir_begin->object.dir_begin.nbnegative >= CACHE_INODE_NEGATIVE_MAX_PER_DIR)
+        {
+          /* Reuse the last one */
+          for(ppnegative = &pdir_begin->object.dir_begin.negative;
+              (*ppnegative)->next != NULL; ppnegative = &(*ppnegative)->next) ;
+
+          pnegative = *ppnegative;
+          *ppnegative = NULL;
+          pdir_begin->object.dir_begin.nbnegative -= 1;
+        }
+      else if((pnegative = (cache_inode_negative_dirent_t *)
+               Mem_Alloc(sizeof(cache_inode_negative_dirent_t))) == NULL)
+        {
+          V(*pmutex);
+          return;
+        }
+
+      pnegative->hashval = cache_inode_dirent_index_hash(pname);
+
+      if(FSAL_IS_ERROR(FSAL_namecpy(&pnegative->name, pname)))
+        {
+          Mem_Free(pnegative);
+          V(*pmutex);
+          return;
+        }
+    }
+
+  pnegative->expire = now + pclient->grace_period_negative;
+  cache_inode_negative_dirent_put(pdir_begin, pnegative);
+
+  V(*pmutex);
+}                               /* cache_inode_negative_dirent_add */
+
+/**
+ *
+ * cache_inode_negative_dirent_forget: removes the negative dirent of a name, if any.
+ *
+ * @param pentry_parent [INOUT] DIR_BEGINNING or DIR_CONTINUE of the directory.
+ * @param pname         [IN]    the name that now exists.
+ *
+ */
+void cache_inode_negative_dirent_forget(cache_entry_t * pentry_parent,
+                                        fsal_name_t * pname)
+{
+  cache_entry_t *pdir_begin = cache_inode_dirent_index_owner(pentry_parent);
+  pthread_mutex_t *pmutex;
+  cache_inode_negative_dirent_t *pnegative;
+
+  /* Cheap test first: most directories have no negative dirent */
+  if(pdir_begin->object.dir_begin.negative == NULL)
+    return;
+
+  pmutex = cache_inode_negative_mutex(pdir_begin);
+
+  P(*pmutex);
+
+  pnegative = cache_inode_negative_dirent_take(pdir_begin, pname, time(NULL));
+
+  V(*pmutex);
+
+  if(pnegative != NULL)
+    Mem_Free(pnegative);
+}                               /* cache_inode_negative_dirent_forget */
 
 /**
  *
@@ -82,7 +586,7 @@ cache_entry_t *cache_inode_operate_cached_dirent(cache_entry_t * pentry_parent,
   cache_entry_t *pdir_chain = NULL;
   cache_entry_t *pentry = NULL;
   fsal_status_t fsal_status;
-  int i = 0;
+  unsigned int i = 0;
 
   /* Set the return default to CACHE_INODE_SUCCESS */
   *pstatus = CACHE_INODE_SUCCESS;
@@ -96,95 +600,15 @@ cache_entry_t *cache_inode_operate_cached_dirent(cache_entry_t * pentry_parent,
       return NULL;
     }
 
-  /* Try to look into the dir and its dir_cont. At this point, it must be said than lock on dir_cont are
-   *  taken when a lock is previously acquired on the related dir_begin */
-  pdir_chain = pentry_parent;
-
-  do
-    {
-      /* Is this entry known ? */
-      if(pdir_chain->internal_md.type == DIR_BEGINNING)
-        {
-          for(i = 0; i < CHILDREN_ARRAY_SIZE; i++)
-            {
-
-              LogFullDebug(COMPONENT_CACHE_INODE, "DIR_BEGINNING %d | %d | %s | %s\n",
-                     pdir_chain->object.dir_begin.pdir_data->dir_entries[i].active,
-                     pdir_chain->object.dir_begin.pdir_data->dir_entries[i].pentry->
-                     internal_md.valid_state, pname->name,
-                     pdir_chain->object.dir_begin.pdir_data->dir_entries[i].name.name);
-
-              if(pdir_chain->object.dir_begin.pdir_data->dir_entries[i].active == VALID
-                 && pdir_chain->object.dir_begin.pdir_data->dir_entries[i].pentry->
-                 internal_md.valid_state == VALID
-                 && !FSAL_namecmp(pname,
-                                  &(pdir_chain->object.dir_begin.pdir_data->
-                                    dir_entries[i].name)))
-                {
-                  /* Entry was found */
-                  pentry = pdir_chain->object.dir_begin.pdir_data->dir_entries[i].pentry;
-                  *pstatus = CACHE_INODE_SUCCESS;
-                  break;
-                }
-            }
-
-          if(pentry != NULL)
-            break;              /* Exit the do...while loop */
+  /* Look for the name in the index of the dir and its dir_cont. At this point, it must be said than lock
+   * on dir_cont are taken when a lock is previously acquired on the related dir_begin */
+  pentry = cache_inode_dirent_index_lookup(pentry_parent, pname, &pdir_chain, &i);
 
-          /* Do we have to go on browsing the cache_inode ? */
-          /* We have to check if eod is reached and no pentry found */
-          if(pdir_chain->object.dir_begin.end_of_dir == END_OF_DIR)
-            {
-              pentry = NULL;
-              *pstatus = CACHE_INODE_NOT_FOUND;
-              break;
-            }
+  if(pentry != NULL && pentry->internal_md.valid_state != VALID)
+    pentry = NULL;
 
-          /* Next step, release the lock and acquire a new one */
-          pdir_chain = pdir_chain->object.dir_begin.pdir_cont;
-        }
-      else
-        {
-          /* Entry is no DIR_BEGINNING, it is of type DIR_CONTINUE */
-          for(i = 0; i < CHILDREN_ARRAY_SIZE; i++)
-            {
-              /*
-                 printf( "DIR_CONTINUE %d | %d | %s | %s\n", 
-                 pdir_chain->object.dir_cont.pdir_data->dir_entries[i].active, 
-                 pdir_chain->object.dir_cont.pdir_data->dir_entries[i].pentry->internal_md.valid_state, 
-                 name.name, 
-                 pdir_chain->object.dir_cont.pdir_data->dir_entries[i].name.name ) ; */
-
-              if(pdir_chain->object.dir_cont.pdir_data->dir_entries[i].active == VALID &&
-                 pdir_chain->object.dir_cont.pdir_data->dir_entries[i].pentry->
-                 internal_md.valid_state == VALID
-                 && !FSAL_namecmp(pname,
-                                  &(pdir_chain->object.dir_cont.pdir_data->
-                                    dir_entries[i].name)))
-                {
-                  /* Entry was found */
-                  pentry = pdir_chain->object.dir_cont.pdir_data->dir_entries[i].pentry;
-                  *pstatus = CACHE_INODE_SUCCESS;
-                  break;
-                }
-            }
-
-          if(pentry != NULL)
-            break;              /* Exit the do...while loop */
-
-          /* Do we have to go on browsing the cache_inode ? */
-          if(pdir_chain->object.dir_cont.end_of_dir == END_OF_DIR)
-            {
-              pentry = NULL;
-              *pstatus = CACHE_INODE_NOT_FOUND;
-              break;
-            }
-          /* Next step */
-          pdir_chain = pdir_chain->object.dir_cont.pdir_cont;
-        }
-
-    }
-  while(pentry == NULL);
+  if(pentry == NULL)
+    *pstatus = CACHE_INODE_NOT_FOUND;
 
   /* Did we find something */
   if(pentry != NULL)
@@ -210,10 +634,16 @@ cache_entry_t *cache_inode_operate_cached_dirent(cache_entry_t * pentry_parent,
             }
           else
             *pstatus = CACHE_INODE_INVALID_ARGUMENT;
+
+          /* The dirent still has its name, use it to remove it from the index */
+          if(*pstatus == CACHE_INODE_SUCCESS)
+            cache_inode_dirent_index_del(pdir_chain, i);
           break;
 
         case CACHE_INODE_DIRENT_OP_RENAME:
-          /* Entry to rename is the i-th in pdir_chain */
+          /* Entry to rename is the i-th in pdir_chain, it is indexed again with its new name */
+          cache_inode_dirent_index_del(pdir_chain, i);
+
           if(pdir_chain->internal_md.type == DIR_BEGINNING)
             {
               fsal_status =
@@ -237,6 +667,17 @@ cache_entry_t *cache_inode_operate_cached_dirent(cache_entry_t * pentry_parent,
             {
               *pstatus = CACHE_INODE_SUCCESS;
             }
+
+          if(cache_inode_dirent_index_add(pdir_chain, i) != CACHE_INODE_SUCCESS)
+            {
+              /* A dirent that can't be found must not stay active */
+              cache_inode_dirent_slot(pdir_chain, i)->active = INVALID;
+              if(pdir_chain->internal_md.type == DIR_BEGINNING)
+                pdir_chain->object.dir_begin.nbactive -= 1;
+              else
+                pdir_chain->object.dir_cont.nbactive -= 1;
+              *pstatus = CACHE_INODE_MALLOC_ERROR;
+            }
           break;
 
         default:
@@ -339,6 +780,9 @@ cache_inode_status_t cache_inode_add_cached_dirent(cache_entry_t * pentry_parent
       return *pstatus;
     }
 
+  /* The name exists now, whatever happens next */
+  cache_inode_negative_dirent_forget(pentry_parent, pname);
+
   /* We don't known where to write, we have to seek for an empty place */
   /* Search loop. We look for an empty slot in a dirent array */
   pdir_chain = pentry_parent;
@@ -513,6 +957,9 @@ cache_inode_status_t cache_inode_add_cached_dirent(cache_entry_t * pentry_parent
   next_parent_entry->parent = NULL;
   next_parent_entry->next_parent = NULL;
 
+  /* The slot may be reused, its former name must not stay in the index */
+  cache_inode_dirent_index_del(pentry, slot_index);
+
   if(pentry->internal_md.type == DIR_BEGINNING)
     {
       pentry->object.dir_begin.nbactive += 1;
@@ -552,6 +999,17 @@ cache_inode_status_t cache_inode_add_cached_dirent(cache_entry_t * pentry_parent
 
     }
 
+  if((*pstatus = cache_inode_dirent_index_add(pentry, slot_index)) != CACHE_INODE_SUCCESS)
+    {
+      cache_inode_dirent_slot(pentry, slot_index)->active = INVALID;
+      if(pentry->internal_md.type == DIR_BEGINNING)
+        pentry->object.dir_begin.nbactive -= 1;
+      else
+        pentry->object.dir_cont.nbactive -= 1;
+      RELEASE_PREALLOC(next_parent_entry, pclient->pool_parent, next_alloc);
+      return *pstatus;
+    }
+
   /* link with the parent entry (insert as first entry) */
   next_parent_entry->subdirpos = slot_index;
   next_parent_entry->parent = pentry;
@@ -618,6 +1076,10 @@ cache_inode_status_t cache_inode_invalidate_all_cached_dirent(cache_entry_t * pe
       pentry = pentry->object.dir_cont.pdir_cont;
     }
 
+  /* No more active dirent, the name index is emptied */
+  cache_inode_dirent_index_release(pentry_dir);
+  cache_inode_negative_dirent_release(pentry_dir);
+
   /* Reinit the fields */
   pentry_dir->object.dir_begin.has_been_readdir = CACHE_INODE_NO;
   pentry_dir->object.dir_begin.end_of_dir = END_OF_DIR;
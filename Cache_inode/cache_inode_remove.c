@@ -208,9 +208,19 @@ cache_inode_status_t cache_inode_clean_internal(cache_entry_t * to_remove_entry,
       parent_iter = parent_iter_next;
     }
 
+  /* Pending unstable data of a removed file are dropped */
+  if(to_remove_entry->internal_md.type == REGULAR_FILE)
+    {
+      cache_inode_unstable_release(to_remove_entry);
+      cache_inode_readahead_invalidate(to_remove_entry);
+    }
+
   /* If entry is a DIR_CONTINUE or a DIR_BEGINNING, release pdir_data */
   if(to_remove_entry->internal_md.type == DIR_BEGINNING)
     {
+      cache_inode_dirent_index_release(to_remove_entry);
+      cache_inode_negative_dirent_release(to_remove_entry);
+
       /* Put the pentry back to the pool */
       RELEASE_PREALLOC(to_remove_entry->object.dir_begin.pdir_data,
                        pclient->pool_dir_data, next_alloc);
@@ -218,6 +228,8 @@ cache_inode_status_t cache_inode_clean_internal(cache_entry_t * to_remove_entry,
 
   if(to_remove_entry->internal_md.type == DIR_CONTINUE)
     {
+      cache_inode_dirent_index_forget_dircont(to_remove_entry);
+
       /* Put the pentry back to the pool */
       RELEASE_PREALLOC(to_remove_entry->object.dir_cont.pdir_data,
                        pclient->pool_dir_data, next_alloc);
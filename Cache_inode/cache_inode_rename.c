@@ -91,6 +91,9 @@ cache_inode_status_t cache_inode_rename_cached_dirent(cache_entry_t * pentry_par
       return *pstatus;
     }
 
+  /* The new name exists now, even if the old one was not cached */
+  cache_inode_negative_dirent_forget(pentry_parent, newname);
+
   /* BUGAZOMEU: Ne pas oublier de jarter un dir_cont dont toutes les entrees sont inactives */
   if((removed_pentry = cache_inode_operate_cached_dirent(pentry_parent,
                                                          oldname,
@@ -174,6 +174,9 @@ cache_inode_status_t cache_inode_renew_entry(cache_entry_t * pentry,
           /* Next call to cache_inode_readdir will repopulate the dirent array */
           pentry->object.dir_begin.has_been_readdir = CACHE_INODE_RENEW_NEEDED;
 
+          /* Names missing before may have been created since */
+          cache_inode_negative_dirent_release(pentry);
+
           /* Set the refresh time for the cache entry */
           pentry->internal_md.refresh_time = time(NULL);
 
@@ -309,6 +312,11 @@ cache_inode_status_t cache_inode_renew_entry(cache_entry_t * pentry,
           return *pstatus;
         }
 
+      /* Names missing before may have been created since */
+      if(pentry->object.dir_begin.attributes.mtime.seconds !=
+         object_attributes.mtime.seconds)
+        cache_inode_negative_dirent_release(pentry);
+
       pentry->object.dir_begin.attributes = object_attributes;
 
       /* Return the attributes as set */
@@ -392,6 +400,7 @@ cache_inode_status_t cache_inode_renew_entry(cache_entry_t * pentry,
         {
         case REGULAR_FILE:
           pentry->object.file.attributes = object_attributes;
+          cache_inode_unstable_filesize(pentry);
           break;
 
         case SYMBOLIC_LINK:
@@ -204,6 +204,12 @@ cache_inode_status_t cache_inode_setattr(cache_entry_t * pentry, fsal_attrib_lis
           return *pstatus;
         }
 
+      /* The data beyond the new size, pending or read ahead, are obsolete */
+      if(pentry->internal_md.type == REGULAR_FILE)
+        {
+          cache_inode_unstable_forget(pentry, pattr->filesize, 0);
+          cache_inode_readahead_invalidate(pentry);
+        }
     }
 
   /* Keep the new attribute in cache */
@@ -110,6 +110,11 @@ cache_inode_status_t cache_inode_truncate_sw(cache_entry_t * pentry,
       return *pstatus;
     }
 
+  /* Pending unstable data beyond the new size must not be flushed later (this never
+   * splits an extent, so it cannot fail) */
+  cache_inode_unstable_forget(pentry, length, 0);
+  cache_inode_readahead_invalidate(pentry);
+
   /* Calls file content cache to operate on the cache */
   if(pentry->object.file.pentry_content != NULL)
     {
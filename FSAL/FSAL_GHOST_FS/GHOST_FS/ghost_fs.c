@@ -40,6 +40,8 @@
 #include "stuff_alloc.h"
 #include <string.h>
 #include <sys/time.h>
+#include <unistd.h>
+#include <pthread.h>
 
 #define TRUE  1
 #define FALSE 0
@@ -52,6 +54,10 @@ static GHOSTFS_stats_t stats;
 /* configuration parameters */
 static GHOSTFS_parameter_t config;
 
+/* amount of file data in memory */
+static GHOSTFS_size_t data_used = 0;
+static pthread_mutex_t data_used_lock = PTHREAD_MUTEX_INITIALIZER;
+
 /* computes a validator based on inode number an current time */
 static unsigned int mk_magic(GHOSTFS_inode_t inode)
 {
@@ -344,6 +350,114 @@ static void fill_attributes(GHOSTFS_item_t * p_entry, GHOSTFS_Attrs_t * p_out_at
 
 }
 
+/* waits for the configured latency of a data operation */
+static void data_op_latency(void)
+{
+  if(config.op_latency)
+    usleep(config.op_latency);
+}
+
+/* accounts nb_extents new extents,
+ * checking that max_data_size is not exceeded.
+ */
+static int reserve_extents(unsigned int nb_extents)
+{
+  GHOSTFS_size_t size = (GHOSTFS_size_t) nb_extents * GHOSTFS_EXTENT_SIZE;
+  int rc = ERR_GHOSTFS_NO_ERROR;
+
+  pthread_mutex_lock(&data_used_lock);
+
+  if(config.max_data_size && (data_used + size > config.max_data_size))
+    rc = ERR_GHOSTFS_NOSPC;
+  else
+    data_used += size;
+
+  pthread_mutex_unlock(&data_used_lock);
+
+  return rc;
+}
+
+static void release_extents(unsigned int nb_extents)
+{
+  pthread_mutex_lock(&data_used_lock);
+  data_used -= (GHOSTFS_size_t) nb_extents * GHOSTFS_EXTENT_SIZE;
+  pthread_mutex_unlock(&data_used_lock);
+}
+
+/* returns the index of the first extent of a file
+ * whose offset is greater or equal to 'offset'.
+ */
+static unsigned int find_extent(GHOSTFS_file_t * p_file, GHOSTFS_size_t offset)
+{
+  unsigned int low = 0;
+  unsigned int high = p_file->nb_extents;
+  unsigned int mid;
+
+  while(low < high)
+    {
+      mid = (low + high) / 2;
+
+      if(p_file->extents[mid].offset < offset)
+        low = mid + 1;
+      else
+        high = mid;
+    }
+
+  return low;
+}
+
+/* frees the extents of a file located at or after 'offset'.
+ * The file must be locked for modification.
+ */
+static void free_extents_from(GHOSTFS_file_t * p_file, GHOSTFS_size_t offset)
+{
+  unsigned int first, i;
+
+  first = find_extent(p_file, offset);
+
+  for(i = first; i < p_file->nb_extents; i++)
+    Mem_Free(p_file->extents[i].data);
+
+  release_extents(p_file->nb_extents - first);
+  p_file->nb_extents = first;
+
+  if(p_file->nb_extents == 0 && p_file->extents != NULL)
+    {
+      Mem_Free(p_file->extents);
+      p_file->extents = NULL;
+      p_file->max_extents = 0;
+    }
+}
+
+/* changes the size of a file.
+ * The file must be locked for modification.
+ */
+static void set_file_size(GHOSTFS_item_t * p_item, GHOSTFS_size_t size)
+{
+  GHOSTFS_file_t *p_file = &p_item->ITEM_FILE;
+  GHOSTFS_size_t in_ext = size % GHOSTFS_EXTENT_SIZE;
+  unsigned int i;
+
+  if(size < p_item->attributes.size)
+    {
+      /* free the extents beyond the new end of file */
+      free_extents_from(p_file, size - in_ext + (in_ext ? GHOSTFS_EXTENT_SIZE : 0));
+
+      /* clear the end of the last extent,
+       * so that it reads as zeros if the file grows again.
+       */
+      if(in_ext)
+        {
+          i = find_extent(p_file, size - in_ext);
+
+          if(i < p_file->nb_extents && p_file->extents[i].offset == size - in_ext)
+            memset(p_file->extents[i].data + in_ext, 0, GHOSTFS_EXTENT_SIZE - in_ext);
+        }
+    }
+
+  p_item->attributes.size = size;
+}
+
 /*------------------------ Library functions -------------------*/
 
 /* Initialise the filesystem and creates the root entry.
@@ -824,6 +938,9 @@ int GHOSTFS_SetAttrs(GHOSTFS_handle_t handle,
   if(setattr_mask & SETATTR_UID)
     p_item->attributes.uid = attrs_values.uid;
 
+  if(setattr_mask & SETATTR_SIZE)
+    set_file_size(p_item, attrs_values.size);
+
   V_w(&p_item->entry_lock);
   return ERR_GHOSTFS_NO_ERROR;
 
@@ -1392,7 +1509,10 @@ int GHOSTFS_Unlink(GHOSTFS_handle_t parent_handle,      /* IN */
 
       if(p_object->linkcount == 0)
         {
-          /* destroy the entry */
+          /* destroy the entry and its data */
+          if(p_object->type == GHOSTFS_FILE)
+            free_extents_from(&p_object->ITEM_FILE, 0);
+
           rw_lock_destroy(&p_object->entry_lock);
           Mem_Free(p_object);
         }
@@ -1654,7 +1774,10 @@ int GHOSTFS_Rename(GHOSTFS_handle_t src_dir_handle,
 
           if(p_object2->linkcount == 0)
             {
-              /* destroy the entry */
+              /* destroy the entry and its data */
+              if(p_object2->type == GHOSTFS_FILE)
+                free_extents_from(&p_object2->ITEM_FILE, 0);
+
               rw_lock_destroy(&p_object2->entry_lock);
               Mem_Free(p_object2);
             }
@@ -1804,3 +1927,289 @@ int GHOSTFS_Rename(GHOSTFS_handle_t src_dir_handle,
   return ERR_GHOSTFS_NO_ERROR;
 
 }
+
+/** Reads file data at a given offset.
+ *  Holes read as zeros. Atime is not updated.
+ */
+int GHOSTFS_Read(GHOSTFS_handle_t handle,
+                 GHOSTFS_size_t offset,
+                 GHOSTFS_size_t length,
+                 caddr_t buffer, GHOSTFS_size_t * p_read_amount, int *p_eof)
+{
+  GHOSTFS_item_t *p_item;
+  GHOSTFS_file_t *p_file;
+  GHOSTFS_size_t cur, end, in_ext, len;
+  unsigned int i;
+
+  /* checks whether the FS has been loaded. */
+  if(!p_root)
+    return ERR_GHOSTFS_NOTINIT;
+
+  /* checks args. */
+  if(!buffer || !p_read_amount || !p_eof)
+    return ERR_GHOSTFS_ARGS;
+
+  p_item = GetEntry_From_Handle(handle);
+  if(p_item == NULL)
+    return ERR_GHOSTFS_STALE;
+
+  data_op_latency();
+
+  /* locks the entry for reading */
+  P_r(&p_item->entry_lock);
+
+  /* check type */
+  if(p_item->type != GHOSTFS_FILE)
+    {
+      V_r(&p_item->entry_lock);
+      return (p_item->type == GHOSTFS_DIR ? ERR_GHOSTFS_ISDIR : ERR_GHOSTFS_ARGS);
+    }
+
+  p_file = &p_item->ITEM_FILE;
+
+  if(offset >= p_item->attributes.size)
+    {
+      V_r(&p_item->entry_lock);
+      *p_read_amount = 0;
+      *p_eof = TRUE;
+      return ERR_GHOSTFS_NO_ERROR;
+    }
+
+  if(length > p_item->attributes.size - offset)
+    length = p_item->attributes.size - offset;
+
+  end = offset + length;
+
+  i = find_extent(p_file, offset - offset % GHOSTFS_EXTENT_SIZE);
+
+  for(cur = offset; cur < end; cur += len)
+    {
+      in_ext = cur % GHOSTFS_EXTENT_SIZE;
+      len = GHOSTFS_EXTENT_SIZE - in_ext;
+      if(len > end - cur)
+        len = end - cur;
+
+      if(i < p_file->nb_extents && p_file->extents[i].offset == cur - in_ext)
+        {
+          memcpy(buffer + (cur - offset), p_file->extents[i].data + in_ext, len);
+          i++;
+        }
+      else
+        memset(buffer + (cur - offset), 0, len);
+    }
+
+  *p_read_amount = length;
+  *p_eof = (end >= p_item->attributes.size);
+
+  V_r(&p_item->entry_lock);
+  return ERR_GHOSTFS_NO_ERROR;
+
+}                               /* GHOSTFS_Read */
+
+/** Writes file data at a given offset, or at the end of the file.
+ *  The extents that are needed are allocated (and accounted)
+ *  before anything is written.
+ */
+int GHOSTFS_Write(GHOSTFS_handle_t handle,
+                  GHOSTFS_size_t offset,
+                  int append,
+                  GHOSTFS_size_t length,
+                  caddr_t buffer,
+                  GHOSTFS_size_t * p_write_amount, GHOSTFS_size_t * p_end_offset)
+{
+  GHOSTFS_item_t *p_item;
+  GHOSTFS_file_t *p_file;
+  GHOSTFS_extent_t *new_extents;
+  GHOSTFS_size_t first, last, cur, end, in_ext, len;
+  unsigned int i, nb_new, new_max;
+  caddr_t data;
+  int rc = ERR_GHOSTFS_NO_ERROR;
+
+  /* checks whether the FS has been loaded. */
+  if(!p_root)
+    return ERR_GHOSTFS_NOTINIT;
+
+  /* checks args. */
+  if(!buffer || !p_write_amount || !p_end_offset)
+    return ERR_GHOSTFS_ARGS;
+
+  p_item = GetEntry_From_Handle(handle);
+  if(p_item == NULL)
+    return ERR_GHOSTFS_STALE;
+
+  data_op_latency();
+
+  /* locks the entry for modification */
+  P_w(&p_item->entry_lock);
+
+  /* check type */
+  if(p_item->type != GHOSTFS_FILE)
+    {
+      V_w(&p_item->entry_lock);
+      return (p_item->type == GHOSTFS_DIR ? ERR_GHOSTFS_ISDIR : ERR_GHOSTFS_ARGS);
+    }
+
+  p_file = &p_item->ITEM_FILE;
+
+  if(append)
+    offset = p_item->attributes.size;
+
+  if(length == 0)
+    {
+      V_w(&p_item->entry_lock);
+      *p_write_amount = 0;
+      *p_end_offset = offset;
+      return ERR_GHOSTFS_NO_ERROR;
+    }
+
+  end = offset + length;
+
+  /* offsets of the first and the last extents to be written */
+  first = offset - offset % GHOSTFS_EXTENT_SIZE;
+  last = (end - 1) - (end - 1) % GHOSTFS_EXTENT_SIZE;
+
+  /* number of extents that do not exist yet */
+  nb_new = (last - first) / GHOSTFS_EXTENT_SIZE + 1
+      - (find_extent(p_file, last + 1) - find_extent(p_file, first));
+
+  if(nb_new > 0)
+    {
+      if((rc = reserve_extents(nb_new)))
+        {
+          V_w(&p_item->entry_lock);
+          return rc;
+        }
+
+      /* make room for them in the extent array */
+      if(p_file->nb_extents + nb_new > p_file->max_extents)
+        {
+          new_max = (p_file->max_extents ? p_file->max_extents : 4);
+          while(new_max < p_file->nb_extents + nb_new)
+            new_max *= 2;
+
+          new_extents = (GHOSTFS_extent_t *) Mem_Realloc(p_file->extents,
+                                                         new_max *
+                                                         sizeof(GHOSTFS_extent_t));
+          if(new_extents == NULL)
+            {
+              release_extents(nb_new);
+              V_w(&p_item->entry_lock);
+              return ERR_GHOSTFS_MALLOC;
+            }
+
+          p_file->extents = new_extents;
+          p_file->max_extents = new_max;
+        }
+    }
+
+  i = find_extent(p_file, first);
+
+  for(cur = offset; cur < end; cur += len)
+    {
+      in_ext = cur % GHOSTFS_EXTENT_SIZE;
+      len = GHOSTFS_EXTENT_SIZE - in_ext;
+      if(len > end - cur)
+        len = end - cur;
+
+      if(i >= p_file->nb_extents || p_file->extents[i].offset != cur - in_ext)
+        {
+          /* allocate the extent, clearing what is not written */
+          data = (caddr_t) Mem_Alloc(GHOSTFS_EXTENT_SIZE);
+
+          if(data == NULL)
+            {
+              rc = ERR_GHOSTFS_MALLOC;
+              break;
+            }
+
+          memset(data, 0, in_ext);
+          memset(data + in_ext + len, 0, GHOSTFS_EXTENT_SIZE - in_ext - len);
+
+          memmove(&p_file->extents[i + 1], &p_file->extents[i],
+                  (p_file->nb_extents - i) * sizeof(GHOSTFS_extent_t));
+
+          p_file->extents[i].offset = cur - in_ext;
+          p_file->extents[i].data = data;
+          p_file->nb_extents++;
+          nb_new--;
+        }
+
+      memcpy(p_file->extents[i].data + in_ext, buffer + (cur - offset), len);
+      i++;
+    }
+
+  /* release the extents that could not be allocated */
+  if(nb_new > 0)
+    release_extents(nb_new);
+
+  /* what has been written is kept, even on error */
+  if(cur > p_item->attributes.size)
+    p_item->attributes.size = cur;
+
+  p_item->attributes.mtime = p_item->attributes.ctime = time(NULL);
+
+  *p_write_amount = cur - offset;
+  *p_end_offset = cur;
+
+  V_w(&p_item->entry_lock);
+  return rc;
+
+}                               /* GHOSTFS_Write */
+
+/** Changes the size of a file.
+ *  Extending a file creates a hole.
+ */
+int GHOSTFS_Truncate(GHOSTFS_handle_t handle,
+                     GHOSTFS_size_t length, GHOSTFS_Attrs_t * p_file_attrs)
+{
+  GHOSTFS_item_t *p_item;
+
+  /* checks whether the FS has been loaded. */
+  if(!p_root)
+    return ERR_GHOSTFS_NOTINIT;
+
+  p_item = GetEntry_From_Handle(handle);
+  if(p_item == NULL)
+    return ERR_GHOSTFS_STALE;
+
+  /* locks the entry for modification */
+  P_w(&p_item->entry_lock);
+
+  /* check type */
+  if(p_item->type != GHOSTFS_FILE)
+    {
+      V_w(&p_item->entry_lock);
+      return (p_item->type == GHOSTFS_DIR ? ERR_GHOSTFS_ISDIR : ERR_GHOSTFS_ARGS);
+    }
+
+  set_file_size(p_item, length);
+
+  p_item->attributes.mtime = p_item->attributes.ctime = time(NULL);
+
+  if(p_file_attrs != NULL)
+    fill_attributes(p_item, p_file_attrs);
+
+  V_w(&p_item->entry_lock);
+  return ERR_GHOSTFS_NO_ERROR;
+
+}                               /* GHOSTFS_Truncate */
+
+/** Gets the amount of file data in memory and its limit (0=unlimited) */
+int GHOSTFS_GetDataUsage(GHOSTFS_size_t * p_used, GHOSTFS_size_t * p_max)
+{
+  /* checks whether the FS has been loaded. */
+  if(!p_root)
+    return ERR_GHOSTFS_NOTINIT;
+
+  /* checks args. */
+  if(!p_used || !p_max)
+    return ERR_GHOSTFS_ARGS;
+
+  pthread_mutex_lock(&data_used_lock);
+  *p_used = data_used;
+  pthread_mutex_unlock(&data_used_lock);
+
+  *p_max = config.max_data_size;
+
+  return ERR_GHOSTFS_NO_ERROR;
+}
@@ -306,6 +306,8 @@ void usage(char *cmd)
   fprintf(stderr, "         test access on a file for a given couple (uid,gid).\n");
   fprintf(stderr, "  %s -mkdir <dir_name> <owner> <group>\n", cmd);
   fprintf(stderr, "         create a directory with the specified owner.\n");
+  fprintf(stderr, "  %s -rw <file_name>\n", cmd);
+  fprintf(stderr, "         test reads, writes and truncates on a new file.\n");
 
 }
 
@@ -433,12 +435,140 @@ void launch_mkdir(char *name, int uid, int gid)
 
 }
 
+/* checks the amount of file data in memory */
+void check_usage(GHOSTFS_size_t expected)
+{
+  GHOSTFS_size_t used, max;
+  int rc;
+
+  if(rc = GHOSTFS_GetDataUsage(&used, &max))
+    Exit(rc, "GHOSTFS_GetDataUsage");
+
+  printf("Data usage: %llu/%llu bytes\n", used, max);
+
+  if(used != expected)
+    Exit(ERR_GHOSTFS_INTERNAL, "unexpected data usage");
+}
+
+static char buffer[5 * GHOSTFS_EXTENT_SIZE];
+
+/* checks a part of the file content:
+ * 'expected' is read at position 'pos', the rest is zeros.
+ */
+void check_read(GHOSTFS_handle_t handle, GHOSTFS_size_t offset, GHOSTFS_size_t length,
+                GHOSTFS_size_t expected_amount, int expected_eof,
+                GHOSTFS_size_t pos, char *expected)
+{
+  GHOSTFS_size_t amount, i;
+  int rc, eof;
+
+  if(rc = GHOSTFS_Read(handle, offset, length, buffer, &amount, &eof))
+    Exit(rc, "GHOSTFS_Read");
+
+  printf("GHOSTFS_Read(%llu, %llu) = %llu bytes, eof=%d\n", offset, length, amount, eof);
+
+  if(amount != expected_amount || eof != expected_eof)
+    Exit(ERR_GHOSTFS_INTERNAL, "unexpected read amount or eof");
+
+  for(i = 0; i < amount; i++)
+    {
+      char c = 0;
+
+      if(expected && i >= pos && i < pos + strlen(expected))
+        c = expected[i - pos];
+
+      if(buffer[i] != c)
+        Exit(ERR_GHOSTFS_INTERNAL, "unexpected file content");
+    }
+}
+
+void launch_rw(char *name)
+{
+  GHOSTFS_handle_t root_handle, file_handle;
+  GHOSTFS_size_t amount, end_offset;
+  GHOSTFS_Attrs_t attrs;
+  int rc;
+
+  if(rc = GHOSTFS_GetRoot(&root_handle))
+    Exit(rc, "GHOSTFS_GetRoot");
+
+  if(rc = GHOSTFS_Create(root_handle, name, 0, 0, 0644, &file_handle, NULL))
+    Exit(rc, "GHOSTFS_Create");
+
+  /* a write across two extents, after a hole */
+  printf("\nWriting 'hello' at the end of the third extent :\n");
+
+  if(rc = GHOSTFS_Write(file_handle, 3 * GHOSTFS_EXTENT_SIZE - 2, FALSE, 5, "hello",
+                        &amount, &end_offset))
+    Exit(rc, "GHOSTFS_Write");
+
+  if(amount != 5 || end_offset != 3 * GHOSTFS_EXTENT_SIZE + 3)
+    Exit(ERR_GHOSTFS_INTERNAL, "unexpected write amount");
+
+  check_usage(2 * GHOSTFS_EXTENT_SIZE);
+  check_read(file_handle, 0, 4 * GHOSTFS_EXTENT_SIZE, 3 * GHOSTFS_EXTENT_SIZE + 3, TRUE,
+             3 * GHOSTFS_EXTENT_SIZE - 2, "hello");
+  check_read(file_handle, 3 * GHOSTFS_EXTENT_SIZE + 3, 10, 0, TRUE, 0, NULL);
+
+  printf("\nAppending 'world' :\n");
+
+  if(rc = GHOSTFS_Write(file_handle, 0, TRUE, 5, "world", &amount, &end_offset))
+    Exit(rc, "GHOSTFS_Write");
+
+  if(amount != 5 || end_offset != 3 * GHOSTFS_EXTENT_SIZE + 8)
+    Exit(ERR_GHOSTFS_INTERNAL, "unexpected write amount");
+
+  check_read(file_handle, 3 * GHOSTFS_EXTENT_SIZE - 10, 10, 10, FALSE, 8, "he");
+  check_read(file_handle, 3 * GHOSTFS_EXTENT_SIZE - 2, 100, 10, TRUE, 0, "helloworld");
+
+  /* shrink then extend: the removed data must not come back */
+  printf("\nTruncating to %d then extending the file :\n", 3 * GHOSTFS_EXTENT_SIZE - 1);
+
+  if(rc = GHOSTFS_Truncate(file_handle, 3 * GHOSTFS_EXTENT_SIZE - 1, &attrs))
+    Exit(rc, "GHOSTFS_Truncate");
+
+  if(attrs.size != 3 * GHOSTFS_EXTENT_SIZE - 1)
+    Exit(ERR_GHOSTFS_INTERNAL, "unexpected size after truncate");
+
+  check_usage(GHOSTFS_EXTENT_SIZE);
+
+  if(rc = GHOSTFS_Truncate(file_handle, 3 * GHOSTFS_EXTENT_SIZE + 10, NULL))
+    Exit(rc, "GHOSTFS_Truncate");
+
+  check_read(file_handle, 3 * GHOSTFS_EXTENT_SIZE - 2, 12, 12, TRUE, 0, "h");
+  check_read(file_handle, 3 * GHOSTFS_EXTENT_SIZE - 2, 1, 1, FALSE, 0, "h");
+
+  /* the configured limit is 4 extents */
+  printf("\nWriting beyond the data size limit :\n");
+
+  rc = GHOSTFS_Write(file_handle, 0, FALSE, 5 * GHOSTFS_EXTENT_SIZE, buffer,
+                     &amount, &end_offset);
+  printf("GHOSTFS_Write returned %d\n", rc);
+
+  if(rc != ERR_GHOSTFS_NOSPC)
+    Exit(ERR_GHOSTFS_INTERNAL, "ERR_GHOSTFS_NOSPC expected");
+
+  check_usage(GHOSTFS_EXTENT_SIZE);
+
+  printf("\nRemoving the file :\n");
+
+  if(rc = GHOSTFS_Unlink(root_handle, name, NULL))
+    Exit(rc, "GHOSTFS_Unlink");
+
+  check_usage(0);
+
+  printf("\nRead/write tests OK\n");
+
+}
+
 static GHOSTFS_parameter_t config_ghostfs = {
   .root_mode = 0755,
   .root_owner = 0,
   .root_group = 0,
   .dot_dot_root_eq_root = 1,
-  .root_access = 1
+  .root_access = 1,
+  .max_data_size = 4 * GHOSTFS_EXTENT_SIZE,
+  .op_latency = 0
 };
 
 int main(int argc, char **argv)
@@ -449,7 +579,8 @@ int main(int argc, char **argv)
     ACTION_NULL,
     ACTION_LS,
     ACTION_ACCES,
-    ACTION_MKDIR
+    ACTION_MKDIR,
+    ACTION_RW
   } action_t;
 
   action_t action = ACTION_NULL;
@@ -473,6 +604,8 @@ int main(int argc, char **argv)
         action = ACTION_LS;
       else if(!strcmp(argv[1], "-mkdir"))
         action = ACTION_MKDIR;
+      else if(!strcmp(argv[1], "-rw"))
+        action = ACTION_RW;
     }
 
   if((action == ACTION_ACCES || action == ACTION_MKDIR) && (argc == 5))
@@ -503,6 +636,12 @@ int main(int argc, char **argv)
       output1 = argv[2];
       output2 = argv[3];
 
+    }
+  else if((action == ACTION_RW) && (argc == 3))
+    {
+
+      lookup_path = argv[2];
+
     }
   else
     {
@@ -532,6 +671,10 @@ int main(int argc, char **argv)
     case ACTION_MKDIR:
       launch_mkdir(lookup_path, uid, gid);
       break;
+
+    case ACTION_RW:
+      launch_rw(lookup_path);
+      break;
     }
 
   exit(0);
@@ -56,7 +56,7 @@
  *        - ERR_FSAL_IO           (corrupted FS)
  *        - ERR_FSAL_SERVERFAULT  (unexpected error)
  */
-fsal_status_t FSAL_access(fsal_handle_t * object_handle,        /* IN */
+fsal_status_t GHOSTFSAL_access(fsal_handle_t * object_handle,        /* IN */
                           fsal_op_context_t * p_context,        /* IN */
                           fsal_accessflags_t access_type,       /* IN */
                           fsal_attrib_list_t * object_attributes        /* [ IN/OUT ] */
@@ -92,7 +92,7 @@ fsal_status_t FSAL_access(fsal_handle_t * object_handle,        /* IN */
     {
       fsal_status_t status;
 
-      switch ((status = FSAL_getattrs(object_handle, p_context, object_attributes)).major)
+      switch ((status = GHOSTFSAL_getattrs(object_handle, p_context, object_attributes)).major)
         {
           /* change the FAULT error to appears as an internal error.
            * indeed, parameters should be null. */
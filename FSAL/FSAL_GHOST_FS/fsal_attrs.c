@@ -32,7 +32,7 @@
  *        - ERR_FSAL_NOT_INIT     (ghostfs not initialize)
  *        - ERR_FSAL_SERVERFAULT  (unexpected error)
  */
-fsal_status_t FSAL_getattrs(fsal_handle_t * filehandle, /* IN */
+fsal_status_t GHOSTFSAL_getattrs(fsal_handle_t * filehandle, /* IN */
                             fsal_op_context_t * p_context,      /* IN */
                             fsal_attrib_list_t * object_attributes      /* IN/OUT */
     )
@@ -84,7 +84,7 @@ fsal_status_t FSAL_getattrs(fsal_handle_t * filehandle, /* IN */
 
 }
 
-fsal_status_t FSAL_setattrs(fsal_handle_t * filehandle, /* IN */
+fsal_status_t GHOSTFSAL_setattrs(fsal_handle_t * filehandle, /* IN */
                             fsal_op_context_t * p_context,      /* IN */
                             fsal_attrib_list_t * attrib_set,    /* IN */
                             fsal_attrib_list_t * object_attributes      /* [ IN/OUT ] */
@@ -174,7 +174,7 @@ fsal_status_t FSAL_setattrs(fsal_handle_t * filehandle, /* IN */
 
   if(object_attributes)
     {
-      fsal_status_t status = FSAL_getattrs(filehandle, p_context, object_attributes);
+      fsal_status_t status = GHOSTFSAL_getattrs(filehandle, p_context, object_attributes);
 
       /* on error, we set a special bit in the mask. */
       if(FSAL_IS_ERROR(status))
@@ -207,7 +207,7 @@ fsal_status_t FSAL_setattrs(fsal_handle_t * filehandle, /* IN */
  *        - ERR_FSAL_NO_ERROR     (no error)
  *        - Another error code if an error occured.
  */
-fsal_status_t FSAL_getextattrs(fsal_handle_t * p_filehandle, /* IN */
+fsal_status_t GHOSTFSAL_getextattrs(fsal_handle_t * p_filehandle, /* IN */
                                fsal_op_context_t * p_context,        /* IN */
                                fsal_extattrib_list_t * p_object_attributes /* OUT */
     )
@@ -19,7 +19,7 @@
 #include "fsal_internal.h"
 #include "fsal_convertions.h"
 
-fsal_status_t FSAL_create(fsal_handle_t * parent_directory_handle,      /* IN */
+fsal_status_t GHOSTFSAL_create(fsal_handle_t * parent_directory_handle,      /* IN */
                           fsal_name_t * p_filename,     /* IN */
                           fsal_op_context_t * p_context,        /* IN */
                           fsal_accessmode_t accessmode, /* IN */
@@ -72,7 +72,7 @@ fsal_status_t FSAL_create(fsal_handle_t * parent_directory_handle,      /* IN */
   Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_create);
 }
 
-fsal_status_t FSAL_mkdir(fsal_handle_t * parent_directory_handle,       /* IN */
+fsal_status_t GHOSTFSAL_mkdir(fsal_handle_t * parent_directory_handle,       /* IN */
                          fsal_name_t * p_dirname,       /* IN */
                          fsal_op_context_t * p_context, /* IN */
                          fsal_accessmode_t accessmode,  /* IN */
@@ -126,7 +126,7 @@ fsal_status_t FSAL_mkdir(fsal_handle_t * parent_directory_handle,       /* IN */
 
 }
 
-fsal_status_t FSAL_link(fsal_handle_t * target_handle,  /* IN */
+fsal_status_t GHOSTFSAL_link(fsal_handle_t * target_handle,  /* IN */
                         fsal_handle_t * dir_handle,     /* IN */
                         fsal_name_t * p_link_name,      /* IN */
                         fsal_op_context_t * p_context,  /* IN */
@@ -172,7 +172,7 @@ fsal_status_t FSAL_link(fsal_handle_t * target_handle,  /* IN */
 
 }
 
-fsal_status_t FSAL_mknode(fsal_handle_t * parentdir_handle,     /* IN */
+fsal_status_t GHOSTFSAL_mknode(fsal_handle_t * parentdir_handle,     /* IN */
                           fsal_name_t * p_node_name,    /* IN */
                           fsal_op_context_t * p_context,        /* IN */
                           fsal_accessmode_t accessmode, /* IN */
@@ -37,7 +37,7 @@
  *         May be NULL.
  * 
  */
-fsal_status_t FSAL_opendir(fsal_handle_t * dir_handle,  /* IN */
+fsal_status_t GHOSTFSAL_opendir(fsal_handle_t * dir_handle,  /* IN */
                            fsal_op_context_t * p_context,       /* IN */
                            fsal_dir_t * dir_descriptor, /* OUT */
                            fsal_attrib_list_t * dir_attributes  /* [ IN/OUT ] */
@@ -83,7 +83,7 @@ fsal_status_t FSAL_opendir(fsal_handle_t * dir_handle,  /* IN */
 
       fsal_status_t status;
 
-      switch ((status = FSAL_getattrs(dir_handle, p_context, dir_attributes)).major)
+      switch ((status = GHOSTFSAL_getattrs(dir_handle, p_context, dir_attributes)).major)
         {
           /* change the FAULT error to appears as an internal error.
            * indeed, parameters should be null. */
@@ -103,7 +103,7 @@ fsal_status_t FSAL_opendir(fsal_handle_t * dir_handle,  /* IN */
 
 }
 
-fsal_status_t FSAL_readdir(fsal_dir_t * dir_descriptor, /* IN */
+fsal_status_t GHOSTFSAL_readdir(fsal_dir_t * dir_descriptor, /* IN */
                            fsal_cookie_t start_position,        /* IN */
                            fsal_attrib_mask_t get_attr_mask,    /* IN */
                            fsal_mdsize_t buffersize,    /* IN */
@@ -182,7 +182,7 @@ fsal_status_t FSAL_readdir(fsal_dir_t * dir_descriptor, /* IN */
        */
 
       curr_ent->attributes.asked_attributes = get_attr_mask;
-      switch ((status = FSAL_getattrs(&curr_ent->handle,
+      switch ((status = GHOSTFSAL_getattrs(&curr_ent->handle,
                                       &dir_descriptor->context,
                                       &curr_ent->attributes)).major)
         {
@@ -212,7 +212,7 @@ fsal_status_t FSAL_readdir(fsal_dir_t * dir_descriptor, /* IN */
 
 }
 
-fsal_status_t FSAL_closedir(fsal_dir_t * dir_descriptor /* IN */
+fsal_status_t GHOSTFSAL_closedir(fsal_dir_t * dir_descriptor /* IN */
     )
 {
 
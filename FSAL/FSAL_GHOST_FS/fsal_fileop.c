@@ -17,6 +17,8 @@
 
 #include "fsal.h"
 #include "fsal_internal.h"
+#include "fsal_convertions.h"
+#include <string.h>
 
 /**
  * FSAL_open_byname:
@@ -57,7 +59,7 @@
  *        ERR_FSAL_IO, ...
  */
 
-fsal_status_t FSAL_open_by_name(fsal_handle_t * dirhandle,      /* IN */
+fsal_status_t GHOSTFSAL_open_by_name(fsal_handle_t * dirhandle,      /* IN */
                                 fsal_name_t * filename, /* IN */
                                 fsal_op_context_t * p_context,  /* IN */
                                 fsal_openflags_t openflags,     /* IN */
@@ -70,14 +72,14 @@ fsal_status_t FSAL_open_by_name(fsal_handle_t * dirhandle,      /* IN */
   if(!dirhandle || !filename || !p_context || !file_descriptor)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_open_by_name);
 
-  fsal_status = FSAL_lookup(dirhandle, filename, p_context, &filehandle, file_attributes);
+  fsal_status = GHOSTFSAL_lookup(dirhandle, filename, p_context, &filehandle, file_attributes);
   if(FSAL_IS_ERROR(fsal_status))
     return fsal_status;
 
-  return FSAL_open(&filehandle, p_context, openflags, file_descriptor, file_attributes);
+  return GHOSTFSAL_open(&filehandle, p_context, openflags, file_descriptor, file_attributes);
 }
 
-fsal_status_t FSAL_rcp_by_fileid(fsal_handle_t * filehandle,    /* IN */
+fsal_status_t GHOSTFSAL_rcp_by_fileid(fsal_handle_t * filehandle,    /* IN */
                                  fsal_u64_t fileid,     /* IN */
                                  fsal_op_context_t * p_context, /* IN */
                                  fsal_path_t * p_local_path,    /* IN */
@@ -86,7 +88,50 @@ fsal_status_t FSAL_rcp_by_fileid(fsal_handle_t * filehandle,    /* IN */
   Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_open_by_fileid);
 }
 
-fsal_status_t FSAL_open(fsal_handle_t * filehandle,     /* IN */
+/* computes the offset of a read/write operation,
+ * and checks that it is valid.
+ */
+static int seek_offset(fsal_file_t * file_descriptor,
+                       fsal_seek_t * seek_descriptor, fsal_off_t * p_offset)
+{
+  GHOSTFS_Attrs_t ghost_attrs;
+  int rc;
+
+  if(!seek_descriptor)
+    {
+      *p_offset = file_descriptor->offset;
+      return ERR_FSAL_NO_ERROR;
+    }
+
+  switch (seek_descriptor->whence)
+    {
+    case FSAL_SEEK_SET:
+      *p_offset = seek_descriptor->offset;
+      break;
+
+    case FSAL_SEEK_CUR:
+      *p_offset = file_descriptor->offset + seek_descriptor->offset;
+      break;
+
+    case FSAL_SEEK_END:
+      rc = GHOSTFS_GetAttrs(file_descriptor->handle, &ghost_attrs);
+      if(rc)
+        return ghost2fsal_error(rc);
+
+      *p_offset = ghost_attrs.size + seek_descriptor->offset;
+      break;
+
+    default:
+      return ERR_FSAL_INVAL;
+    }
+
+  if(*p_offset < 0)
+    return ERR_FSAL_INVAL;
+
+  return ERR_FSAL_NO_ERROR;
+}
+
+fsal_status_t GHOSTFSAL_open(fsal_handle_t * filehandle,     /* IN */
                         fsal_op_context_t * p_context,  /* IN */
                         fsal_openflags_t openflags,     /* IN */
                         fsal_file_t * file_descriptor,  /* OUT */
@@ -94,6 +139,11 @@ fsal_status_t FSAL_open(fsal_handle_t * filehandle,     /* IN */
     )
 {
 
+  int rc, cpt;
+  fsal_status_t status;
+  GHOSTFS_Attrs_t ghost_attrs;
+  GHOSTFS_testperm_t test;
+
   /* For logging */
   SetFuncID(INDEX_FSAL_open);
 
@@ -103,11 +153,80 @@ fsal_status_t FSAL_open(fsal_handle_t * filehandle,     /* IN */
   if(!filehandle || !p_context || !file_descriptor)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_open);
 
-  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_open);
+  /* check flags compatibility */
+
+  if(openflags &
+     ~(FSAL_O_RDONLY | FSAL_O_RDWR | FSAL_O_WRONLY | FSAL_O_APPEND | FSAL_O_TRUNC))
+    Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_open);
+
+  cpt = 0;
+  if(openflags & FSAL_O_RDONLY)
+    cpt++;
+  if(openflags & FSAL_O_RDWR)
+    cpt++;
+  if(openflags & FSAL_O_WRONLY)
+    cpt++;
+
+  if((cpt > 1)
+     || ((openflags & FSAL_O_APPEND) && (openflags & FSAL_O_TRUNC))
+     || ((openflags & FSAL_O_TRUNC) && !(openflags & (FSAL_O_WRONLY | FSAL_O_RDWR))))
+    {
+      LogEvent(COMPONENT_FSAL, "Invalid/conflicting flags : %#X", openflags);
+      Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_open);
+    }
+
+  /* only regular files can be opened */
+
+  rc = GHOSTFS_GetAttrs((GHOSTFS_handle_t) (*filehandle), &ghost_attrs);
+
+  if(rc)
+    Return(ghost2fsal_error(rc), rc, INDEX_FSAL_open);
+
+  if(ghost_attrs.type != GHOSTFS_FILE)
+    Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_open);
+
+  /* check access rights */
+
+  test = (openflags & FSAL_O_RDONLY ? GHOSTFS_TEST_READ : GHOSTFS_TEST_WRITE);
+
+  rc = GHOSTFS_Access((GHOSTFS_handle_t) (*filehandle), test,
+                      p_context->credential.user, p_context->credential.group);
+
+  if(rc)
+    Return(ghost2fsal_error(rc), rc, INDEX_FSAL_open);
+
+  if(openflags & FSAL_O_TRUNC)
+    {
+      rc = GHOSTFS_Truncate((GHOSTFS_handle_t) (*filehandle), 0, NULL);
+
+      if(rc)
+        Return(ghost2fsal_error(rc), rc, INDEX_FSAL_open);
+    }
+
+  /* data is in memory, there is nothing else to open */
+
+  file_descriptor->handle = (GHOSTFS_handle_t) (*filehandle);
+  file_descriptor->offset = 0;
+  file_descriptor->ro = openflags & FSAL_O_RDONLY;
+  file_descriptor->append = openflags & FSAL_O_APPEND;
+
+  /* output attributes */
+  if(file_attributes)
+    {
+      status = GHOSTFSAL_getattrs(filehandle, p_context, file_attributes);
+
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(file_attributes->asked_attributes);
+          FSAL_SET_MASK(file_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+    }
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_open);
 
 }
 
-fsal_status_t FSAL_read(fsal_file_t * file_descriptor,  /* IN */
+fsal_status_t GHOSTFSAL_read(fsal_file_t * file_descriptor,  /* IN */
                         fsal_seek_t * seek_descriptor,  /* IN */
                         fsal_size_t buffer_size,        /* IN */
                         caddr_t buffer, /* OUT */
@@ -119,15 +238,33 @@ fsal_status_t FSAL_read(fsal_file_t * file_descriptor,  /* IN */
   /* For logging */
   SetFuncID(INDEX_FSAL_read);
 
+  fsal_off_t offset;
+  GHOSTFS_size_t nb_read;
+  int eof, rc;
+
   /* sanity checks. */
-  if(!file_descriptor || !seek_descriptor || !buffer || !read_amount || !end_of_file)
+  if(!file_descriptor || !buffer || !read_amount || !end_of_file)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_read);
 
-  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_read);
+  if((rc = seek_offset(file_descriptor, seek_descriptor, &offset)))
+    Return(rc, 0, INDEX_FSAL_read);
+
+  rc = GHOSTFS_Read(file_descriptor->handle, (GHOSTFS_size_t) offset,
+                    (GHOSTFS_size_t) buffer_size, buffer, &nb_read, &eof);
+
+  if(rc)
+    Return(ghost2fsal_error(rc), rc, INDEX_FSAL_read);
+
+  file_descriptor->offset = offset + nb_read;
+
+  *read_amount = nb_read;
+  *end_of_file = (eof ? TRUE : FALSE);
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_read);
 
 }
 
-fsal_status_t FSAL_write(fsal_file_t * file_descriptor, /* IN */
+fsal_status_t GHOSTFSAL_write(fsal_file_t * file_descriptor, /* IN */
                          fsal_seek_t * seek_descriptor, /* IN */
                          fsal_size_t buffer_size,       /* IN */
                          caddr_t buffer,        /* IN */
@@ -138,14 +275,39 @@ fsal_status_t FSAL_write(fsal_file_t * file_descriptor, /* IN */
   /* For logging */
   SetFuncID(INDEX_FSAL_write);
 
+  fsal_off_t offset;
+  GHOSTFS_size_t nb_written, end_offset;
+  int rc;
+
   /* sanity checks. */
-  if(!file_descriptor || !seek_descriptor || !buffer || !write_amount)
+  if(!file_descriptor || !buffer || !write_amount)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_write);
 
-  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_write);
+  if(file_descriptor->ro)
+    Return(ERR_FSAL_NOT_OPENED, 0, INDEX_FSAL_write);
+
+  if((rc = seek_offset(file_descriptor, seek_descriptor, &offset)))
+    Return(rc, 0, INDEX_FSAL_write);
+
+  /* in append mode, ghostfs computes the offset
+   * while the file is locked.
+   */
+  rc = GHOSTFS_Write(file_descriptor->handle, (GHOSTFS_size_t) offset,
+                     file_descriptor->append, (GHOSTFS_size_t) buffer_size,
+                     buffer, &nb_written, &end_offset);
+
+  /* on error, what has been written is kept */
+  *write_amount = nb_written;
+
+  if(rc)
+    Return(ghost2fsal_error(rc), rc, INDEX_FSAL_write);
+
+  file_descriptor->offset = end_offset;
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_write);
 }
 
-fsal_status_t FSAL_close(fsal_file_t * file_descriptor  /* IN */
+fsal_status_t GHOSTFSAL_close(fsal_file_t * file_descriptor  /* IN */
     )
 {
 
@@ -156,11 +318,14 @@ fsal_status_t FSAL_close(fsal_file_t * file_descriptor  /* IN */
   if(!file_descriptor)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_close);
 
-  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_close);
+  /* nothing to release, the data stays in memory */
+  memset(file_descriptor, 0, sizeof(fsal_file_t));
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_close);
 }
 
 /* Some unsupported calls used in FSAL_PROXY, just for permit the ganeshell to compile */
-fsal_status_t FSAL_open_by_fileid(fsal_handle_t * filehandle,   /* IN */
+fsal_status_t GHOSTFSAL_open_by_fileid(fsal_handle_t * filehandle,   /* IN */
                                   fsal_u64_t fileid,    /* IN */
                                   fsal_op_context_t * p_context,        /* IN */
                                   fsal_openflags_t openflags,   /* IN */
@@ -170,13 +335,13 @@ fsal_status_t FSAL_open_by_fileid(fsal_handle_t * filehandle,   /* IN */
   Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_open_by_fileid);
 }
 
-fsal_status_t FSAL_close_by_fileid(fsal_file_t * file_descriptor /* IN */ ,
+fsal_status_t GHOSTFSAL_close_by_fileid(fsal_file_t * file_descriptor /* IN */ ,
                                    fsal_u64_t fileid)
 {
   Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_open_by_fileid);
 }
 
-unsigned int FSAL_GetFileno(fsal_file_t * pfile)
+unsigned int GHOSTFSAL_GetFileno(fsal_file_t * pfile)
 {
   return 1;
 }
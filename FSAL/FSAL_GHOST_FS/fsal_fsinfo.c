@@ -17,8 +17,10 @@
 
 #include "fsal.h"
 #include "fsal_internal.h"
+#include "fsal_convertions.h"
+#include <unistd.h>
 
-fsal_status_t FSAL_static_fsinfo(fsal_handle_t * filehandle,    /* IN */
+fsal_status_t GHOSTFSAL_static_fsinfo(fsal_handle_t * filehandle,    /* IN */
                                  fsal_op_context_t * p_context, /* IN */
                                  fsal_staticfsinfo_t * staticinfo       /* OUT */
     )
@@ -38,12 +40,15 @@ fsal_status_t FSAL_static_fsinfo(fsal_handle_t * filehandle,    /* IN */
 
 }
 
-fsal_status_t FSAL_dynamic_fsinfo(fsal_handle_t * filehandle,   /* IN */
+fsal_status_t GHOSTFSAL_dynamic_fsinfo(fsal_handle_t * filehandle,   /* IN */
                                   fsal_op_context_t * p_context,        /* IN */
                                   fsal_dynamicfsinfo_t * dynamicinfo    /* OUT */
     )
 {
 
+  GHOSTFS_size_t used, max;
+  int rc;
+
   /* For logging */
   SetFuncID(INDEX_FSAL_dynamic_fsinfo);
 
@@ -51,9 +56,18 @@ fsal_status_t FSAL_dynamic_fsinfo(fsal_handle_t * filehandle,   /* IN */
   if(!filehandle || !dynamicinfo || !p_context)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_dynamic_fsinfo);
 
-  dynamicinfo->total_bytes = 0;
-  dynamicinfo->free_bytes = 0;
-  dynamicinfo->avail_bytes = 0;
+  rc = GHOSTFS_GetDataUsage(&used, &max);
+
+  if(rc)
+    Return(ghost2fsal_error(rc), rc, INDEX_FSAL_dynamic_fsinfo);
+
+  /* without a limit, file data can fill the free memory */
+  if(max == 0)
+    max = used + (GHOSTFS_size_t) sysconf(_SC_AVPHYS_PAGES) * sysconf(_SC_PAGESIZE);
+
+  dynamicinfo->total_bytes = max;
+  dynamicinfo->free_bytes = (max > used ? max - used : 0);
+  dynamicinfo->avail_bytes = dynamicinfo->free_bytes;
   dynamicinfo->total_files = 0;
   dynamicinfo->free_files = 0;
   dynamicinfo->avail_files = 0;
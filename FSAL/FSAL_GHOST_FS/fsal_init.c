@@ -92,7 +92,7 @@ static int CreateInitDir(ghostfs_dir_def_t * p_dir)
  *                                minor error code gives the reason
  *                                for this error.)
  */
-fsal_status_t FSAL_Init(fsal_parameter_t * init_info    /* IN */
+fsal_status_t GHOSTFSAL_Init(fsal_parameter_t * init_info    /* IN */
     )
 {
 
@@ -115,6 +115,8 @@ fsal_status_t FSAL_Init(fsal_parameter_t * init_info    /* IN */
   param.root_group = init_info->fs_specific_info.root_group;
   param.dot_dot_root_eq_root = init_info->fs_specific_info.dot_dot_root_eq_root;
   param.root_access = init_info->fs_specific_info.root_access;
+  param.max_data_size = init_info->fs_specific_info.max_data_size;
+  param.op_latency = init_info->fs_specific_info.op_latency;
 
   LogFullDebug(COMPONENT_FSAL, "init_info->fs_specific_info.root_owner = %d\n",
          init_info->fs_specific_info.root_owner);
@@ -159,7 +161,7 @@ fsal_status_t FSAL_Init(fsal_parameter_t * init_info    /* IN */
 }
 
 /* To be called before exiting */
-fsal_status_t FSAL_terminate()
+fsal_status_t GHOSTFSAL_terminate()
 {
   ReturnCode(ERR_FSAL_NO_ERROR, 0);
 }
@@ -49,3 +49,352 @@ void fsal_internal_getstats(fsal_statistics_t * output_stats);
 /* automaticaly sets the function name, from the function index. */
 /*#define SetFuncID(_f_) SetNameFunction(fsal_function_names[_f_])*/
 #define SetFuncID(_f_)
+
+/* All the call to FSAL to be wrapped */
+fsal_status_t GHOSTFSAL_access(ghostfsal_handle_t * p_object_handle,    /* IN */
+                               ghostfsal_op_context_t * p_context,      /* IN */
+                               fsal_accessflags_t access_type,  /* IN */
+                               fsal_attrib_list_t *
+                               p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_getattrs(ghostfsal_handle_t * p_filehandle,     /* IN */
+                                 ghostfsal_op_context_t * p_context,    /* IN */
+                                 fsal_attrib_list_t * p_object_attributes /* IN/OUT */ );
+
+fsal_status_t GHOSTFSAL_setattrs(ghostfsal_handle_t * p_filehandle,     /* IN */
+                                 ghostfsal_op_context_t * p_context,    /* IN */
+                                 fsal_attrib_list_t * p_attrib_set,     /* IN */
+                                 fsal_attrib_list_t *
+                                 p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_BuildExportContext(ghostfsal_export_context_t * p_export_context,       /* OUT */
+                                           fsal_path_t * p_export_path, /* IN */
+                                           char *fs_specific_options /* IN */ );
+
+fsal_status_t GHOSTFSAL_CleanUpExportContext(ghostfsal_export_context_t * p_export_context);
+
+fsal_status_t GHOSTFSAL_InitClientContext(ghostfsal_op_context_t * p_thr_context);
+
+fsal_status_t GHOSTFSAL_GetClientContext(ghostfsal_op_context_t * p_thr_context,        /* IN/OUT  */
+                                         ghostfsal_export_context_t * p_export_context, /* IN */
+                                         fsal_uid_t uid,        /* IN */
+                                         fsal_gid_t gid,        /* IN */
+                                         fsal_gid_t * alt_groups,       /* IN */
+                                         fsal_count_t nb_alt_groups /* IN */ );
+
+fsal_status_t GHOSTFSAL_create(ghostfsal_handle_t * p_parent_directory_handle,  /* IN */
+                               fsal_name_t * p_filename,        /* IN */
+                               ghostfsal_op_context_t * p_context,      /* IN */
+                               fsal_accessmode_t accessmode,    /* IN */
+                               ghostfsal_handle_t * p_object_handle,    /* OUT */
+                               fsal_attrib_list_t *
+                               p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_mkdir(ghostfsal_handle_t * p_parent_directory_handle,   /* IN */
+                              fsal_name_t * p_dirname,  /* IN */
+                              ghostfsal_op_context_t * p_context,       /* IN */
+                              fsal_accessmode_t accessmode,     /* IN */
+                              ghostfsal_handle_t * p_object_handle,     /* OUT */
+                              fsal_attrib_list_t * p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_link(ghostfsal_handle_t * p_target_handle,      /* IN */
+                             ghostfsal_handle_t * p_dir_handle, /* IN */
+                             fsal_name_t * p_link_name, /* IN */
+                             ghostfsal_op_context_t * p_context,        /* IN */
+                             fsal_attrib_list_t * p_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_mknode(ghostfsal_handle_t * parentdir_handle,   /* IN */
+                               fsal_name_t * p_node_name,       /* IN */
+                               ghostfsal_op_context_t * p_context,      /* IN */
+                               fsal_accessmode_t accessmode,    /* IN */
+                               fsal_nodetype_t nodetype,        /* IN */
+                               fsal_dev_t * dev,        /* IN */
+                               ghostfsal_handle_t * p_object_handle,    /* OUT (handle to the created node) */
+                               fsal_attrib_list_t * node_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_opendir(ghostfsal_handle_t * p_dir_handle,      /* IN */
+                                ghostfsal_op_context_t * p_context,     /* IN */
+                                ghostfsal_dir_t * p_dir_descriptor,     /* OUT */
+                                fsal_attrib_list_t * p_dir_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_readdir(ghostfsal_dir_t * p_dir_descriptor,     /* IN */
+                                ghostfsal_cookie_t start_position,      /* IN */
+                                fsal_attrib_mask_t get_attr_mask,       /* IN */
+                                fsal_mdsize_t buffersize,       /* IN */
+                                fsal_dirent_t * p_pdirent,      /* OUT */
+                                ghostfsal_cookie_t * p_end_position,    /* OUT */
+                                fsal_count_t * p_nb_entries,    /* OUT */
+                                fsal_boolean_t * p_end_of_dir /* OUT */ );
+
+fsal_status_t GHOSTFSAL_closedir(ghostfsal_dir_t * p_dir_descriptor /* IN */ );
+
+fsal_status_t GHOSTFSAL_open_by_name(ghostfsal_handle_t * dirhandle,    /* IN */
+                                     fsal_name_t * filename,    /* IN */
+                                     ghostfsal_op_context_t * p_context,        /* IN */
+                                     fsal_openflags_t openflags,        /* IN */
+                                     ghostfsal_file_t * file_descriptor,        /* OUT */
+                                     fsal_attrib_list_t *
+                                     file_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_open(ghostfsal_handle_t * p_filehandle, /* IN */
+                             ghostfsal_op_context_t * p_context,        /* IN */
+                             fsal_openflags_t openflags,        /* IN */
+                             ghostfsal_file_t * p_file_descriptor,      /* OUT */
+                             fsal_attrib_list_t * p_file_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_read(ghostfsal_file_t * p_file_descriptor,      /* IN */
+                             fsal_seek_t * p_seek_descriptor,   /* [IN] */
+                             fsal_size_t buffer_size,   /* IN */
+                             caddr_t buffer,    /* OUT */
+                             fsal_size_t * p_read_amount,       /* OUT */
+                             fsal_boolean_t * p_end_of_file /* OUT */ );
+
+fsal_status_t GHOSTFSAL_write(ghostfsal_file_t * p_file_descriptor,     /* IN */
+                              fsal_seek_t * p_seek_descriptor,  /* IN */
+                              fsal_size_t buffer_size,  /* IN */
+                              caddr_t buffer,   /* IN */
+                              fsal_size_t * p_write_amount /* OUT */ );
+
+fsal_status_t GHOSTFSAL_close(ghostfsal_file_t * p_file_descriptor /* IN */ );
+
+fsal_status_t GHOSTFSAL_open_by_fileid(ghostfsal_handle_t * filehandle, /* IN */
+                                       fsal_u64_t fileid,       /* IN */
+                                       ghostfsal_op_context_t * p_context,      /* IN */
+                                       fsal_openflags_t openflags,      /* IN */
+                                       ghostfsal_file_t * file_descriptor,      /* OUT */
+                                       fsal_attrib_list_t *
+                                       file_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_close_by_fileid(ghostfsal_file_t * file_descriptor /* IN */ ,
+                                        fsal_u64_t fileid);
+
+fsal_status_t GHOSTFSAL_static_fsinfo(ghostfsal_handle_t * p_filehandle,        /* IN */
+                                      ghostfsal_op_context_t * p_context,       /* IN */
+                                      fsal_staticfsinfo_t * p_staticinfo /* OUT */ );
+
+fsal_status_t GHOSTFSAL_dynamic_fsinfo(ghostfsal_handle_t * p_filehandle,       /* IN */
+                                       ghostfsal_op_context_t * p_context,      /* IN */
+                                       fsal_dynamicfsinfo_t * p_dynamicinfo /* OUT */ );
+
+fsal_status_t GHOSTFSAL_Init(fsal_parameter_t * init_info /* IN */ );
+
+fsal_status_t GHOSTFSAL_terminate();
+
+fsal_status_t GHOSTFSAL_test_access(ghostfsal_op_context_t * p_context, /* IN */
+                                    fsal_accessflags_t access_type,     /* IN */
+                                    fsal_attrib_list_t * p_object_attributes /* IN */ );
+
+fsal_status_t GHOSTFSAL_setattr_access(ghostfsal_op_context_t * p_context,      /* IN */
+                                       fsal_attrib_list_t * candidate_attributes,       /* IN */
+                                       fsal_attrib_list_t * object_attributes /* IN */ );
+
+fsal_status_t GHOSTFSAL_rename_access(ghostfsal_op_context_t * pcontext,        /* IN */
+                                      fsal_attrib_list_t * pattrsrc,    /* IN */
+                                      fsal_attrib_list_t * pattrdest) /* IN */ ;
+
+fsal_status_t GHOSTFSAL_create_access(ghostfsal_op_context_t * pcontext,        /* IN */
+                                      fsal_attrib_list_t * pattr) /* IN */ ;
+
+fsal_status_t GHOSTFSAL_unlink_access(ghostfsal_op_context_t * pcontext,        /* IN */
+                                      fsal_attrib_list_t * pattr) /* IN */ ;
+
+fsal_status_t GHOSTFSAL_link_access(ghostfsal_op_context_t * pcontext,  /* IN */
+                                    fsal_attrib_list_t * pattr) /* IN */ ;
+
+fsal_status_t GHOSTFSAL_merge_attrs(fsal_attrib_list_t * pinit_attr,
+                                    fsal_attrib_list_t * pnew_attr,
+                                    fsal_attrib_list_t * presult_attr);
+
+fsal_status_t GHOSTFSAL_lookup(ghostfsal_handle_t * p_parent_directory_handle,  /* IN */
+                               fsal_name_t * p_filename,        /* IN */
+                               ghostfsal_op_context_t * p_context,      /* IN */
+                               ghostfsal_handle_t * p_object_handle,    /* OUT */
+                               fsal_attrib_list_t *
+                               p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_lookupPath(fsal_path_t * p_path,        /* IN */
+                                   ghostfsal_op_context_t * p_context,  /* IN */
+                                   ghostfsal_handle_t * object_handle,  /* OUT */
+                                   fsal_attrib_list_t *
+                                   p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_lookupJunction(ghostfsal_handle_t * p_junction_handle,  /* IN */
+                                       ghostfsal_op_context_t * p_context,      /* IN */
+                                       ghostfsal_handle_t * p_fsoot_handle,     /* OUT */
+                                       fsal_attrib_list_t *
+                                       p_fsroot_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_lock(ghostfsal_file_t * obj_handle,
+                             ghostfsal_lockdesc_t * ldesc, fsal_boolean_t blocking);
+
+fsal_status_t GHOSTFSAL_changelock(ghostfsal_lockdesc_t * lock_descriptor,      /* IN / OUT */
+                                   fsal_lockparam_t * lock_info /* IN */ );
+
+fsal_status_t GHOSTFSAL_unlock(ghostfsal_file_t * obj_handle,
+                               ghostfsal_lockdesc_t * ldesc);
+
+fsal_status_t GHOSTFSAL_getlock(ghostfsal_file_t * obj_handle,
+                                ghostfsal_lockdesc_t * ldesc);
+
+fsal_status_t GHOSTFSAL_CleanObjectResources(ghostfsal_handle_t * in_fsal_handle);
+
+fsal_status_t GHOSTFSAL_set_quota(fsal_path_t * pfsal_path,     /* IN */
+                                  int quota_type,       /* IN */
+                                  fsal_uid_t fsal_uid,  /* IN */
+                                  fsal_quota_t * pquota,        /* IN */
+                                  fsal_quota_t * presquota);    /* OUT */
+
+fsal_status_t GHOSTFSAL_get_quota(fsal_path_t * pfsal_path,     /* IN */
+                                  int quota_type,       /* IN */
+                                  fsal_uid_t fsal_uid,  /* IN */
+                                  fsal_quota_t * pquota);       /* OUT */
+
+fsal_status_t GHOSTFSAL_rcp(ghostfsal_handle_t * filehandle,    /* IN */
+                            ghostfsal_op_context_t * p_context, /* IN */
+                            fsal_path_t * p_local_path, /* IN */
+                            fsal_rcpflag_t transfer_opt /* IN */ );
+
+fsal_status_t GHOSTFSAL_rcp_by_fileid(ghostfsal_handle_t * filehandle,  /* IN */
+                                      fsal_u64_t fileid,        /* IN */
+                                      ghostfsal_op_context_t * p_context,       /* IN */
+                                      fsal_path_t * p_local_path,       /* IN */
+                                      fsal_rcpflag_t transfer_opt /* IN */ );
+
+fsal_status_t GHOSTFSAL_rename(ghostfsal_handle_t * p_old_parentdir_handle,     /* IN */
+                               fsal_name_t * p_old_name,        /* IN */
+                               ghostfsal_handle_t * p_new_parentdir_handle,     /* IN */
+                               fsal_name_t * p_new_name,        /* IN */
+                               ghostfsal_op_context_t * p_context,      /* IN */
+                               fsal_attrib_list_t * p_src_dir_attributes,       /* [ IN/OUT ] */
+                               fsal_attrib_list_t *
+                               p_tgt_dir_attributes /* [ IN/OUT ] */ );
+
+void GHOSTFSAL_get_stats(fsal_statistics_t * stats,     /* OUT */
+                         fsal_boolean_t reset /* IN */ );
+
+fsal_status_t GHOSTFSAL_readlink(ghostfsal_handle_t * p_linkhandle,     /* IN */
+                                 ghostfsal_op_context_t * p_context,    /* IN */
+                                 fsal_path_t * p_link_content,  /* OUT */
+                                 fsal_attrib_list_t *
+                                 p_link_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_symlink(ghostfsal_handle_t * p_parent_directory_handle, /* IN */
+                                fsal_name_t * p_linkname,       /* IN */
+                                fsal_path_t * p_linkcontent,    /* IN */
+                                ghostfsal_op_context_t * p_context,     /* IN */
+                                fsal_accessmode_t accessmode,   /* IN (ignored) */
+                                ghostfsal_handle_t * p_link_handle,     /* OUT */
+                                fsal_attrib_list_t * p_link_attributes /* [ IN/OUT ] */ );
+
+int GHOSTFSAL_handlecmp(ghostfsal_handle_t * handle1, ghostfsal_handle_t * handle2,
+                        fsal_status_t * status);
+
+unsigned int GHOSTFSAL_Handle_to_HashIndex(ghostfsal_handle_t * p_handle,
+                                           unsigned int cookie,
+                                           unsigned int alphabet_len,
+                                           unsigned int index_size);
+
+unsigned int GHOSTFSAL_Handle_to_RBTIndex(ghostfsal_handle_t * p_handle,
+                                          unsigned int cookie);
+
+fsal_status_t GHOSTFSAL_DigestHandle(ghostfsal_export_context_t * p_expcontext, /* IN */
+                                     fsal_digesttype_t output_type,     /* IN */
+                                     ghostfsal_handle_t * p_in_fsal_handle,     /* IN */
+                                     caddr_t out_buff /* OUT */ );
+
+fsal_status_t GHOSTFSAL_ExpandHandle(ghostfsal_export_context_t * p_expcontext, /* IN */
+                                     fsal_digesttype_t in_type, /* IN */
+                                     caddr_t in_buff,   /* IN */
+                                     ghostfsal_handle_t * p_out_fsal_handle /* OUT */ );
+
+fsal_status_t GHOSTFSAL_SetDefault_FSAL_parameter(fsal_parameter_t * out_parameter);
+
+fsal_status_t GHOSTFSAL_SetDefault_FS_common_parameter(fsal_parameter_t * out_parameter);
+
+fsal_status_t GHOSTFSAL_SetDefault_FS_specific_parameter(fsal_parameter_t *
+                                                         out_parameter);
+
+fsal_status_t GHOSTFSAL_load_FSAL_parameter_from_conf(config_file_t in_config,
+                                                      fsal_parameter_t * out_parameter);
+
+fsal_status_t GHOSTFSAL_load_FS_common_parameter_from_conf(config_file_t in_config,
+                                                           fsal_parameter_t *
+                                                           out_parameter);
+
+fsal_status_t GHOSTFSAL_load_FS_specific_parameter_from_conf(config_file_t in_config,
+                                                             fsal_parameter_t *
+                                                             out_parameter);
+
+fsal_status_t GHOSTFSAL_truncate(ghostfsal_handle_t * p_filehandle,     /* IN */
+                                 ghostfsal_op_context_t * p_context,    /* IN */
+                                 fsal_size_t length,    /* IN */
+                                 ghostfsal_file_t * file_descriptor,    /* Unused in this FSAL */
+                                 fsal_attrib_list_t *
+                                 p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t GHOSTFSAL_unlink(ghostfsal_handle_t * p_parent_directory_handle,  /* IN */
+                               fsal_name_t * p_object_name,     /* IN */
+                               ghostfsal_op_context_t * p_context,      /* IN */
+                               fsal_attrib_list_t *
+                               p_parent_directory_attributes /* [IN/OUT ] */ );
+
+char *GHOSTFSAL_GetFSName();
+
+fsal_status_t GHOSTFSAL_GetXAttrAttrs(ghostfsal_handle_t * p_objecthandle,      /* IN */
+                                      ghostfsal_op_context_t * p_context,       /* IN */
+                                      unsigned int xattr_id,    /* IN */
+                                      fsal_attrib_list_t * p_attrs);
+
+fsal_status_t GHOSTFSAL_ListXAttrs(ghostfsal_handle_t * p_objecthandle, /* IN */
+                                   unsigned int cookie, /* IN */
+                                   ghostfsal_op_context_t * p_context,  /* IN */
+                                   fsal_xattrent_t * xattrs_tab,        /* IN/OUT */
+                                   unsigned int xattrs_tabsize, /* IN */
+                                   unsigned int *p_nb_returned, /* OUT */
+                                   int *end_of_list /* OUT */ );
+
+fsal_status_t GHOSTFSAL_GetXAttrValueById(ghostfsal_handle_t * p_objecthandle,  /* IN */
+                                          unsigned int xattr_id,        /* IN */
+                                          ghostfsal_op_context_t * p_context,   /* IN */
+                                          caddr_t buffer_addr,  /* IN/OUT */
+                                          size_t buffer_size,   /* IN */
+                                          size_t * p_output_size /* OUT */ );
+
+fsal_status_t GHOSTFSAL_GetXAttrIdByName(ghostfsal_handle_t * p_objecthandle,   /* IN */
+                                         const fsal_name_t * xattr_name,        /* IN */
+                                         ghostfsal_op_context_t * p_context,    /* IN */
+                                         unsigned int *pxattr_id /* OUT */ );
+
+fsal_status_t GHOSTFSAL_GetXAttrValueByName(ghostfsal_handle_t * p_objecthandle,        /* IN */
+                                            const fsal_name_t * xattr_name,     /* IN */
+                                            ghostfsal_op_context_t * p_context, /* IN */
+                                            caddr_t buffer_addr,        /* IN/OUT */
+                                            size_t buffer_size, /* IN */
+                                            size_t * p_output_size /* OUT */ );
+
+fsal_status_t GHOSTFSAL_SetXAttrValue(ghostfsal_handle_t * p_objecthandle,      /* IN */
+                                      const fsal_name_t * xattr_name,   /* IN */
+                                      ghostfsal_op_context_t * p_context,       /* IN */
+                                      caddr_t buffer_addr,      /* IN */
+                                      size_t buffer_size,       /* IN */
+                                      int create /* IN */ );
+
+fsal_status_t GHOSTFSAL_SetXAttrValueById(ghostfsal_handle_t * p_objecthandle,  /* IN */
+                                          unsigned int xattr_id,        /* IN */
+                                          ghostfsal_op_context_t * p_context,   /* IN */
+                                          caddr_t buffer_addr,  /* IN */
+                                          size_t buffer_size /* IN */ );
+
+fsal_status_t GHOSTFSAL_RemoveXAttrById(ghostfsal_handle_t * p_objecthandle,    /* IN */
+                                        ghostfsal_op_context_t * p_context,     /* IN */
+                                        unsigned int xattr_id) /* IN */ ;
+
+fsal_status_t GHOSTFSAL_RemoveXAttrByName(ghostfsal_handle_t * p_objecthandle,  /* IN */
+                                          ghostfsal_op_context_t * p_context,   /* IN */
+                                          const fsal_name_t * xattr_name) /* IN */ ;
+
+unsigned int GHOSTFSAL_GetFileno(fsal_file_t * pfile);
+
+fsal_status_t GHOSTFSAL_getextattrs(fsal_handle_t * p_filehandle, /* IN */
+                                    fsal_op_context_t * p_context,        /* IN */
+                                    fsal_extattrib_list_t * p_object_attributes /* OUT */) ;
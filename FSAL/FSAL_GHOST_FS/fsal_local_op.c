@@ -68,7 +68,7 @@
  *        - ERR_FSAL_SERVERFAULT  (unexpected error)
  */
 
-fsal_status_t FSAL_test_access(fsal_op_context_t * p_context,   /* IN */
+fsal_status_t GHOSTFSAL_test_access(fsal_op_context_t * p_context,   /* IN */
                                fsal_accessflags_t access_type,  /* IN */
                                fsal_attrib_list_t * object_attributes   /* IN */
     )
@@ -184,7 +184,7 @@ fsal_status_t FSAL_test_access(fsal_op_context_t * p_context,   /* IN */
  *        - ERR_FSAL_INVAL        (missing attributes : mode, group, user,...)
  *        - ERR_FSAL_SERVERFAULT  (unexpected error)
  */
-fsal_status_t FSAL_setattr_access(fsal_op_context_t * p_context,        /* IN */
+fsal_status_t GHOSTFSAL_setattr_access(fsal_op_context_t * p_context,        /* IN */
                                   fsal_attrib_list_t * candidate_attributes,    /* IN */
                                   fsal_attrib_list_t * object_attributes        /* IN */
     )
@@ -209,7 +209,7 @@ fsal_status_t FSAL_setattr_access(fsal_op_context_t * p_context,        /* IN */
  *        - ERR_FSAL_SERVERFAULT  (unexpected error)
  */
 
-fsal_status_t FSAL_rename_access(fsal_op_context_t * pcontext,  /* IN */
+fsal_status_t GHOSTFSAL_rename_access(fsal_op_context_t * pcontext,  /* IN */
                                  fsal_attrib_list_t * pattrsrc, /* IN */
                                  fsal_attrib_list_t * pattrdest)        /* IN */
 {
@@ -230,12 +230,12 @@ fsal_status_t FSAL_rename_access(fsal_op_context_t * pcontext,  /* IN */
  *        - ERR_FSAL_INVAL        (missing attributes : mode, group, user,...)
  *        - ERR_FSAL_SERVERFAULT  (unexpected error)
  */
-fsal_status_t FSAL_create_access(fsal_op_context_t * pcontext,  /* IN */
+fsal_status_t GHOSTFSAL_create_access(fsal_op_context_t * pcontext,  /* IN */
                                  fsal_attrib_list_t * pattr)    /* IN */
 {
   fsal_status_t fsal_status;
 
-  fsal_status = FSAL_test_access(pcontext, FSAL_W_OK, pattr);
+  fsal_status = GHOSTFSAL_test_access(pcontext, FSAL_W_OK, pattr);
   if(FSAL_IS_ERROR(fsal_status))
     Return(fsal_status.major, fsal_status.minor, INDEX_FSAL_create_access);
 
@@ -257,12 +257,12 @@ fsal_status_t FSAL_create_access(fsal_op_context_t * pcontext,  /* IN */
  *        - ERR_FSAL_INVAL        (missing attributes : mode, group, user,...)
  *        - ERR_FSAL_SERVERFAULT  (unexpected error)
  */
-fsal_status_t FSAL_unlink_access(fsal_op_context_t * pcontext,  /* IN */
+fsal_status_t GHOSTFSAL_unlink_access(fsal_op_context_t * pcontext,  /* IN */
                                  fsal_attrib_list_t * pattr)    /* IN */
 {
   fsal_status_t fsal_status;
 
-  fsal_status = FSAL_test_access(pcontext, FSAL_W_OK, pattr);
+  fsal_status = GHOSTFSAL_test_access(pcontext, FSAL_W_OK, pattr);
   if(FSAL_IS_ERROR(fsal_status))
     Return(fsal_status.major, fsal_status.minor, INDEX_FSAL_unlink_access);
 
@@ -271,6 +271,34 @@ fsal_status_t FSAL_unlink_access(fsal_op_context_t * pcontext,  /* IN */
 
 }                               /* FSAL_unlink_access */
 
+/**
+ * FSAL_link_access :
+ * test if a client identified by cred can link to a directory knowing its attributes
+ *
+ * \param pcontext (in fsal_cred_t *) user's context.
+ * \param pattr      destination directory attributes
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - ERR_FSAL_ACCESS       (Permission denied)
+ *        - ERR_FSAL_FAULT        (null pointer parameter)
+ *        - ERR_FSAL_INVAL        (missing attributes : mode, group, user,...)
+ *        - ERR_FSAL_SERVERFAULT  (unexpected error)
+ */
+fsal_status_t GHOSTFSAL_link_access(fsal_op_context_t * pcontext,    /* IN */
+                                    fsal_attrib_list_t * pattr) /* IN */
+{
+  fsal_status_t fsal_status;
+
+  fsal_status = GHOSTFSAL_test_access(pcontext, FSAL_W_OK, pattr);
+  if(FSAL_IS_ERROR(fsal_status))
+    Return(fsal_status.major, fsal_status.minor, INDEX_FSAL_link_access);
+
+  /* If this point is reached, then access is granted */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_link_access);
+
+}                               /* FSAL_link_access */
+
 /**
  * FSAL_merge_attrs: merge to attributes structure.
  *
@@ -286,7 +314,7 @@ fsal_status_t FSAL_unlink_access(fsal_op_context_t * pcontext,  /* IN */
  *        - ERR_FSAL_INVAL        Invalid argument(s)
  */
 
-fsal_status_t FSAL_merge_attrs(fsal_attrib_list_t * pinit_attr,
+fsal_status_t GHOSTFSAL_merge_attrs(fsal_attrib_list_t * pinit_attr,
                                fsal_attrib_list_t * pnew_attr,
                                fsal_attrib_list_t * presult_attr)
 {
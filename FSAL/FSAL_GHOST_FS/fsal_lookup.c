@@ -19,7 +19,7 @@
 #include "fsal_internal.h"
 #include "fsal_convertions.h"
 
-fsal_status_t FSAL_lookupJunction(fsal_handle_t * p_junction_handle,    /* IN */
+fsal_status_t GHOSTFSAL_lookupJunction(fsal_handle_t * p_junction_handle,    /* IN */
                                   fsal_op_context_t * p_context,        /* IN */
                                   fsal_handle_t * p_fsoot_handle,       /* OUT */
                                   fsal_attrib_list_t * p_fsroot_attributes      /* [ IN/OUT ] */
@@ -56,7 +56,7 @@ fsal_status_t FSAL_lookupJunction(fsal_handle_t * p_junction_handle,    /* IN */
  *          
  */
 
-fsal_status_t FSAL_lookup(fsal_handle_t * parent_directory_handle,      /* IN */
+fsal_status_t GHOSTFSAL_lookup(fsal_handle_t * parent_directory_handle,      /* IN */
                           fsal_name_t * p_filename,     /* IN */
                           fsal_op_context_t * p_context,        /* IN */
                           fsal_handle_t * object_handle,        /* OUT */
@@ -128,7 +128,7 @@ fsal_status_t FSAL_lookup(fsal_handle_t * parent_directory_handle,      /* IN */
   if(object_attributes)
     {
 
-      switch ((status = FSAL_getattrs(&handle, p_context, object_attributes)).major)
+      switch ((status = GHOSTFSAL_getattrs(&handle, p_context, object_attributes)).major)
         {
           /* change the FAULT error to appears as an internal error.
            * indeed, parameters should be null. */
@@ -170,7 +170,7 @@ fsal_status_t FSAL_lookup(fsal_handle_t * parent_directory_handle,      /* IN */
  *        It can be NULL (increases performances).
  */
 
-fsal_status_t FSAL_lookupPath(fsal_path_t * p_path,     /* IN */
+fsal_status_t GHOSTFSAL_lookupPath(fsal_path_t * p_path,     /* IN */
                               fsal_op_context_t * p_context,    /* IN */
                               fsal_handle_t * object_handle,    /* OUT */
                               fsal_attrib_list_t * object_attributes    /* [ IN/OUT ] */
@@ -209,7 +209,7 @@ fsal_status_t FSAL_lookupPath(fsal_path_t * p_path,     /* IN */
 
   /* retrieves root directory */
 
-  if(FSAL_IS_ERROR(status = FSAL_lookup(NULL,   /* looking up for root */
+  if(FSAL_IS_ERROR(status = GHOSTFSAL_lookup(NULL,   /* looking up for root */
                                         NULL,   /* NULL to get root handle */
                                         p_context,      /* user's credentials */
                                         &out_hdl,       /* output root handle */
@@ -257,7 +257,7 @@ fsal_status_t FSAL_lookupPath(fsal_path_t * p_path,     /* IN */
         b_is_last = TRUE;
 
       /*call to FSAL_lookup */
-      if(FSAL_IS_ERROR(status = FSAL_lookup(&in_hdl,    /* parent directory handle */
+      if(FSAL_IS_ERROR(status = GHOSTFSAL_lookup(&in_hdl,    /* parent directory handle */
                                             &obj_name,  /* object name */
                                             p_context,  /* user's credentials */
                                             &out_hdl,   /* output root handle */
@@ -19,7 +19,7 @@
 #include "fsal_internal.h"
 #include "fsal_convertions.h"
 
-fsal_status_t FSAL_rename(fsal_handle_t * old_parentdir_handle, /* IN */
+fsal_status_t GHOSTFSAL_rename(fsal_handle_t * old_parentdir_handle, /* IN */
                           fsal_name_t * p_old_name,     /* IN */
                           fsal_handle_t * new_parentdir_handle, /* IN */
                           fsal_name_t * p_new_name,     /* IN */
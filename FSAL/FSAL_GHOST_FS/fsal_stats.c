@@ -17,7 +17,7 @@
 #include "fsal.h"
 #include "fsal_internal.h"
 
-void FSAL_get_stats(fsal_statistics_t * stats,  /* OUT */
+void GHOSTFSAL_get_stats(fsal_statistics_t * stats,  /* OUT */
                     fsal_boolean_t reset        /* IN */
     )
 {
@@ -20,7 +20,7 @@
 #include "fsal_convertions.h"
 #include <string.h>
 
-fsal_status_t FSAL_readlink(fsal_handle_t * linkhandle, /* IN */
+fsal_status_t GHOSTFSAL_readlink(fsal_handle_t * linkhandle, /* IN */
                             fsal_op_context_t * p_context,      /* IN */
                             fsal_path_t * p_link_content,       /* OUT */
                             fsal_attrib_list_t * link_attributes        /* [ IN/OUT ] */
@@ -49,7 +49,7 @@ fsal_status_t FSAL_readlink(fsal_handle_t * linkhandle, /* IN */
 
       fsal_status_t status;
 
-      switch ((status = FSAL_getattrs(linkhandle, p_context, link_attributes)).major)
+      switch ((status = GHOSTFSAL_getattrs(linkhandle, p_context, link_attributes)).major)
         {
           /* change the FAULT error to appears as an internal error.
            * indeed, parameters should be null. */
@@ -69,7 +69,7 @@ fsal_status_t FSAL_readlink(fsal_handle_t * linkhandle, /* IN */
 
 }
 
-fsal_status_t FSAL_symlink(fsal_handle_t * parent_directory_handle,     /* IN */
+fsal_status_t GHOSTFSAL_symlink(fsal_handle_t * parent_directory_handle,     /* IN */
                            fsal_name_t * p_linkname,    /* IN */
                            fsal_path_t * p_linkcontent, /* IN */
                            fsal_op_context_t * p_context,       /* IN */
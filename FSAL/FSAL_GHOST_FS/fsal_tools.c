@@ -23,7 +23,7 @@
 
 #define STRCMP  strcasecmp
 
-char *FSAL_GetFSName()
+char *GHOSTFSAL_GetFSName()
 {
   return "GHOSTFS";
 }
@@ -32,7 +32,7 @@ char *FSAL_GetFSName()
  *  \return - 0 if handle are the same
  *          - A non null value else.
  */
-int FSAL_handlecmp(fsal_handle_t * handle1, fsal_handle_t * handle2,
+int GHOSTFSAL_handlecmp(fsal_handle_t * handle1, fsal_handle_t * handle2,
                    fsal_status_t * status)
 {
 
@@ -71,7 +71,7 @@ int FSAL_handlecmp(fsal_handle_t * handle1, fsal_handle_t * handle2,
  * \return The hash value
  */
 
-unsigned int FSAL_Handle_to_HashIndex(fsal_handle_t * p_handle,
+unsigned int GHOSTFSAL_Handle_to_HashIndex(fsal_handle_t * p_handle,
                                       unsigned int cookie,
                                       unsigned int alphabet_len, unsigned int index_size)
 {
@@ -93,7 +93,7 @@ unsigned int FSAL_Handle_to_HashIndex(fsal_handle_t * p_handle,
  * \return The hash value
  */
 
-unsigned int FSAL_Handle_to_RBTIndex(fsal_handle_t * p_handle, unsigned int cookie)
+unsigned int GHOSTFSAL_Handle_to_RBTIndex(fsal_handle_t * p_handle, unsigned int cookie)
 {
   return (cookie + (unsigned int)p_handle->inode ^ (unsigned int)p_handle->magic);
 }
@@ -103,7 +103,7 @@ unsigned int FSAL_Handle_to_RBTIndex(fsal_handle_t * p_handle, unsigned int cook
  *  to be included into NFS handles,
  *  or another digest.
  */
-fsal_status_t FSAL_DigestHandle(fsal_export_context_t * p_expcontext,   /* IN */
+fsal_status_t GHOSTFSAL_DigestHandle(fsal_export_context_t * p_expcontext,   /* IN */
                                 fsal_digesttype_t output_type,  /* IN */
                                 fsal_handle_t * in_fsal_handle, /* IN */
                                 caddr_t out_buff        /* OUT */
@@ -178,7 +178,7 @@ fsal_status_t FSAL_DigestHandle(fsal_export_context_t * p_expcontext,   /* IN */
  *  convert a buffer extracted from NFS handles
  *  to an FSAL handle.
  */
-fsal_status_t FSAL_ExpandHandle(fsal_export_context_t * p_expcontext,   /* IN */
+fsal_status_t GHOSTFSAL_ExpandHandle(fsal_export_context_t * p_expcontext,   /* IN */
                                 fsal_digesttype_t in_type,      /* IN */
                                 caddr_t in_buff,        /* IN */
                                 fsal_handle_t * out_fsal_handle /* OUT */
@@ -215,7 +215,7 @@ fsal_status_t FSAL_ExpandHandle(fsal_export_context_t * p_expcontext,   /* IN */
  *         ERR_FSAL_FAULT (null pointer given as parameter),
  *         ERR_FSAL_SERVERFAULT (unexpected error)
  */
-fsal_status_t FSAL_SetDefault_FSAL_parameter(fsal_parameter_t * out_parameter)
+fsal_status_t GHOSTFSAL_SetDefault_FSAL_parameter(fsal_parameter_t * out_parameter)
 {
   /* defensive programming... */
   if(out_parameter == NULL)
@@ -228,7 +228,7 @@ fsal_status_t FSAL_SetDefault_FSAL_parameter(fsal_parameter_t * out_parameter)
 
 }
 
-fsal_status_t FSAL_SetDefault_FS_common_parameter(fsal_parameter_t * out_parameter)
+fsal_status_t GHOSTFSAL_SetDefault_FS_common_parameter(fsal_parameter_t * out_parameter)
 {
   /* defensive programming... */
   if(out_parameter == NULL)
@@ -264,7 +264,7 @@ fsal_status_t FSAL_SetDefault_FS_common_parameter(fsal_parameter_t * out_paramet
 
 }
 
-fsal_status_t FSAL_SetDefault_FS_specific_parameter(fsal_parameter_t * out_parameter)
+fsal_status_t GHOSTFSAL_SetDefault_FS_specific_parameter(fsal_parameter_t * out_parameter)
 {
   /* defensive programming... */
   if(out_parameter == NULL)
@@ -277,6 +277,8 @@ fsal_status_t FSAL_SetDefault_FS_specific_parameter(fsal_parameter_t * out_param
   out_parameter->fs_specific_info.root_group = 0;
   out_parameter->fs_specific_info.dot_dot_root_eq_root = TRUE;
   out_parameter->fs_specific_info.root_access = TRUE;
+  out_parameter->fs_specific_info.max_data_size = 0;
+  out_parameter->fs_specific_info.op_latency = 0;
 
   out_parameter->fs_specific_info.dir_list = NULL;
 
@@ -307,7 +309,7 @@ fsal_status_t FSAL_SetDefault_FS_specific_parameter(fsal_parameter_t * out_param
 
 /* load FSAL init info */
 
-fsal_status_t FSAL_load_FSAL_parameter_from_conf(config_file_t in_config,
+fsal_status_t GHOSTFSAL_load_FSAL_parameter_from_conf(config_file_t in_config,
                                                  fsal_parameter_t * out_parameter)
 {
   int err;
@@ -412,7 +414,7 @@ fsal_status_t FSAL_load_FSAL_parameter_from_conf(config_file_t in_config,
 
 /* load general filesystem configuration options */
 
-fsal_status_t FSAL_load_FS_common_parameter_from_conf(config_file_t in_config,
+fsal_status_t GHOSTFSAL_load_FS_common_parameter_from_conf(config_file_t in_config,
                                                       fsal_parameter_t * out_parameter)
 {
   int err;
@@ -683,7 +685,7 @@ static int ParseGhostFsDirDef(char *string, ghostfs_dir_def_t * p_dir)
 
 /* load specific filesystem configuration options */
 
-fsal_status_t FSAL_load_FS_specific_parameter_from_conf(config_file_t in_config,
+fsal_status_t GHOSTFSAL_load_FS_specific_parameter_from_conf(config_file_t in_config,
                                                         fsal_parameter_t * out_parameter)
 {
   int err;
@@ -790,6 +792,37 @@ fsal_status_t FSAL_load_FS_specific_parameter_from_conf(config_file_t in_config,
 
           out_parameter->fs_specific_info.dot_dot_root_eq_root = bool;
 
+        }
+      else if(!STRCMP(key_name, "max_data_size"))
+        {
+          fsal_u64_t size;
+
+          if(s_read_int64(key_value, &size))
+            {
+              LogCrit(COMPONENT_CONFIG,
+                   "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: null or positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          out_parameter->fs_specific_info.max_data_size = size;
+
+        }
+      else if(!STRCMP(key_name, "op_latency"))
+        {
+
+          int latency = s_read_int(key_value);
+
+          if(latency < 0)
+            {
+              LogCrit(COMPONENT_CONFIG,
+                   "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: null or positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          out_parameter->fs_specific_info.op_latency = latency;
+
         }
       else if(!STRCMP(key_name, "predefined_dir"))
         {
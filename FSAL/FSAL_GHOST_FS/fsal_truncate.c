@@ -17,8 +17,9 @@
 
 #include "fsal.h"
 #include "fsal_internal.h"
+#include "fsal_convertions.h"
 
-fsal_status_t FSAL_truncate(fsal_handle_t * filehandle, /* IN */
+fsal_status_t GHOSTFSAL_truncate(fsal_handle_t * filehandle, /* IN */
                             fsal_op_context_t * p_context,      /* IN */
                             fsal_size_t length, /* IN */
                             fsal_file_t * file_descriptor,      /* Unused in this FSAL */
@@ -26,6 +27,9 @@ fsal_status_t FSAL_truncate(fsal_handle_t * filehandle, /* IN */
     )
 {
 
+  int rc;
+  fsal_status_t status;
+
   /* for logging */
   SetFuncID(INDEX_FSAL_truncate);
 
@@ -35,7 +39,23 @@ fsal_status_t FSAL_truncate(fsal_handle_t * filehandle, /* IN */
   if(!filehandle || !p_context)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_truncate);
 
-  /* GHOSTFS is read only */
-  Return(ERR_FSAL_ROFS, 0, INDEX_FSAL_truncate);
+  rc = GHOSTFS_Truncate((GHOSTFS_handle_t) (*filehandle), (GHOSTFS_size_t) length, NULL);
+
+  if(rc)
+    Return(ghost2fsal_error(rc), rc, INDEX_FSAL_truncate);
+
+  /* optionnaly retrieve attributes */
+  if(object_attributes)
+    {
+      status = GHOSTFSAL_getattrs(filehandle, p_context, object_attributes);
+
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(object_attributes->asked_attributes);
+          FSAL_SET_MASK(object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+    }
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_truncate);
 
 }
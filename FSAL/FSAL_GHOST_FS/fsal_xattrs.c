@@ -232,7 +232,7 @@ static int file_attributes_to_xattr_attrs(fsal_attrib_list_t * file_attrs,
  * \param xattr_cookie xattr's cookie (as returned by listxattrs).
  * \param p_attrs xattr's attributes.
  */
-fsal_status_t FSAL_GetXAttrAttrs(fsal_handle_t * p_objecthandle,        /* IN */
+fsal_status_t GHOSTFSAL_GetXAttrAttrs(fsal_handle_t * p_objecthandle,        /* IN */
                                  fsal_op_context_t * p_context, /* IN */
                                  unsigned int xattr_id, /* IN */
                                  fsal_attrib_list_t * p_attrs
@@ -243,14 +243,20 @@ fsal_status_t FSAL_GetXAttrAttrs(fsal_handle_t * p_objecthandle,        /* IN */
   char buff[MAXNAMLEN];
   fsal_status_t st;
   fsal_attrib_list_t file_attrs;
+  GHOSTFS_Attrs_t attrs;
 
   /* sanity checks */
   if(!p_objecthandle || !p_context || !p_attrs)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_GetXAttrAttrs);
 
+  /* get object type */
+  rc = GHOSTFS_GetAttrs((GHOSTFS_handle_t) (*p_objecthandle), &attrs);
+  if(rc)
+    Return(ghost2fsal_error(rc), rc, INDEX_FSAL_GetXAttrAttrs);
+
   /* check that this index match the type of entry */
   if(xattr_id >= XATTR_COUNT
-     || !do_match_type(xattr_list[xattr_id].flags, p_objecthandle->obj_type))
+     || !do_match_type(xattr_list[xattr_id].flags, ghost2fsal_type(attrs.type)))
     {
       Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_GetXAttrAttrs);
     }
@@ -264,7 +270,7 @@ fsal_status_t FSAL_GetXAttrAttrs(fsal_handle_t * p_objecthandle,        /* IN */
 
   file_attrs.asked_attributes &= p_attrs->asked_attributes;
 
-  st = FSAL_getattrs(p_objecthandle, p_context, &file_attrs);
+  st = GHOSTFSAL_getattrs(p_objecthandle, p_context, &file_attrs);
 
   if(FSAL_IS_ERROR(st))
     Return(st.major, st.minor, INDEX_FSAL_GetXAttrAttrs);
@@ -290,7 +296,7 @@ fsal_status_t FSAL_GetXAttrAttrs(fsal_handle_t * p_objecthandle,        /* IN */
  * \param p_nb_returned the number of xattr entries actually stored in xattrs_tab.
  * \param end_of_list this boolean indicates that the end of xattrs list has been reached.
  */
-fsal_status_t FSAL_ListXAttrs(fsal_handle_t * p_objecthandle,   /* IN */
+fsal_status_t GHOSTFSAL_ListXAttrs(fsal_handle_t * p_objecthandle,   /* IN */
                               unsigned int cookie,      /* IN */
                               fsal_op_context_t * p_context,    /* IN */
                               fsal_xattrent_t * xattrs_tab,     /* IN/OUT */
@@ -326,7 +332,7 @@ fsal_status_t FSAL_ListXAttrs(fsal_handle_t * p_objecthandle,   /* IN */
   /* don't retrieve unsuipported attributes */
   file_attrs.asked_attributes &= global_fs_info.supported_attrs;
 
-  st = FSAL_getattrs(p_objecthandle, p_context, &file_attrs);
+  st = GHOSTFSAL_getattrs(p_objecthandle, p_context, &file_attrs);
 
   if(FSAL_IS_ERROR(st))
     Return(st.major, st.minor, INDEX_FSAL_ListXAttrs);
@@ -375,7 +381,7 @@ fsal_status_t FSAL_ListXAttrs(fsal_handle_t * p_objecthandle,   /* IN */
  * \param buffer_size size of the buffer where the xattr value is to be stored.
  * \param p_output_size size of the data actually stored into the buffer.
  */
-fsal_status_t FSAL_GetXAttrValueById(fsal_handle_t * p_objecthandle,    /* IN */
+fsal_status_t GHOSTFSAL_GetXAttrValueById(fsal_handle_t * p_objecthandle,    /* IN */
                                      unsigned int xattr_id,     /* IN */
                                      fsal_op_context_t * p_context,     /* IN */
                                      caddr_t buffer_addr,       /* IN/OUT */
@@ -421,19 +427,29 @@ fsal_status_t FSAL_GetXAttrValueById(fsal_handle_t * p_objecthandle,    /* IN */
  *   
  *  \return ERR_FSAL_NO_ERROR if xattr_name exists, ERR_FSAL_NOENT otherwise
  */
-fsal_status_t FSAL_GetXAttrIdByName(fsal_handle_t * p_objecthandle,     /* IN */
+fsal_status_t GHOSTFSAL_GetXAttrIdByName(fsal_handle_t * p_objecthandle,     /* IN */
                                     const fsal_name_t * xattr_name,     /* IN */
                                     fsal_op_context_t * p_context,      /* IN */
                                     unsigned int *pxattr_id     /* OUT */
     )
 {
+  int rc;
   unsigned int index;
   int found = FALSE;
+  GHOSTFS_Attrs_t attrs;
+  fsal_nodetype_t objtype;
 
   /* sanity checks */
   if(!p_objecthandle || !xattr_name)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_GetXAttrValue);
 
+  /* get object type */
+  rc = GHOSTFS_GetAttrs((GHOSTFS_handle_t) (*p_objecthandle), &attrs);
+  if(rc)
+    Return(ghost2fsal_error(rc), rc, INDEX_FSAL_GetXAttrValue);
+
+  objtype = ghost2fsal_type(attrs.type);
+
   for(index = 0; index < XATTR_COUNT; index++)
     {
       if(do_match_type(xattr_list[index].flags, objtype)
@@ -463,7 +479,7 @@ fsal_status_t FSAL_GetXAttrIdByName(fsal_handle_t * p_objecthandle,     /* IN */
  * \param buffer_size size of the buffer where the xattr value is to be stored.
  * \param p_output_size size of the data actually stored into the buffer.
  */
-fsal_status_t FSAL_GetXAttrValueByName(fsal_handle_t * p_objecthandle,  /* IN */
+fsal_status_t GHOSTFSAL_GetXAttrValueByName(fsal_handle_t * p_objecthandle,  /* IN */
                                        const fsal_name_t * xattr_name,  /* IN */
                                        fsal_op_context_t * p_context,   /* IN */
                                        caddr_t buffer_addr,     /* IN/OUT */
@@ -495,7 +511,7 @@ fsal_status_t FSAL_GetXAttrValueByName(fsal_handle_t * p_objecthandle,  /* IN */
          && !strcmp(xattr_list[index].xattr_name, xattr_name->name))
         {
 
-          return FSAL_GetXAttrValueById(p_objecthandle, index, p_context, buffer_addr,
+          return GHOSTFSAL_GetXAttrValueById(p_objecthandle, index, p_context, buffer_addr,
                                         buffer_size, p_output_size);
 
         }
@@ -506,7 +522,7 @@ fsal_status_t FSAL_GetXAttrValueByName(fsal_handle_t * p_objecthandle,  /* IN */
 
 }
 
-fsal_status_t FSAL_SetXAttrValue(fsal_handle_t * p_objecthandle,        /* IN */
+fsal_status_t GHOSTFSAL_SetXAttrValue(fsal_handle_t * p_objecthandle,        /* IN */
                                  const fsal_name_t * xattr_name,        /* IN */
                                  fsal_op_context_t * p_context, /* IN */
                                  caddr_t buffer_addr,   /* IN */
@@ -517,7 +533,7 @@ fsal_status_t FSAL_SetXAttrValue(fsal_handle_t * p_objecthandle,        /* IN */
   Return(ERR_FSAL_PERM, 0, INDEX_FSAL_SetXAttrValue);
 }
 
-fsal_status_t FSAL_SetXAttrValueById(fsal_handle_t * p_objecthandle,    /* IN */
+fsal_status_t GHOSTFSAL_SetXAttrValueById(fsal_handle_t * p_objecthandle,    /* IN */
                                      unsigned int xattr_id,     /* IN */
                                      fsal_op_context_t * p_context,     /* IN */
                                      caddr_t buffer_addr,       /* IN */
@@ -534,7 +550,7 @@ fsal_status_t FSAL_SetXAttrValueById(fsal_handle_t * p_objecthandle,    /* IN */
  * \param p_context pointer to the current security context.
  * \param xattr_id xattr's id
  */
-fsal_status_t FSAL_RemoveXAttrById(fsal_handle_t * p_objecthandle,      /* IN */
+fsal_status_t GHOSTFSAL_RemoveXAttrById(fsal_handle_t * p_objecthandle,      /* IN */
                                    fsal_op_context_t * p_context,       /* IN */
                                    unsigned int xattr_id)       /* IN */
 {
@@ -548,7 +564,7 @@ fsal_status_t FSAL_RemoveXAttrById(fsal_handle_t * p_objecthandle,      /* IN */
  * \param p_context pointer to the current security context.
  * \param xattr_name xattr's name
  */
-fsal_status_t FSAL_RemoveXAttrByName(fsal_handle_t * p_objecthandle,    /* IN */
+fsal_status_t GHOSTFSAL_RemoveXAttrByName(fsal_handle_t * p_objecthandle,    /* IN */
                                      fsal_op_context_t * p_context,     /* IN */
                                      const fsal_name_t * xattr_name)    /* IN */
 {
@@ -202,6 +202,10 @@ int main(int argc, char **argv)
   AddFamilyError(ERR_FSAL, "FSAL related Errors", tab_errstatus_FSAL);
   AddFamilyError(ERR_GHOSTFS, "GhostFS Errors", tab_errstatus_GHOSTFS);
 
+  /* Get the FSAL functions and consts */
+  FSAL_LoadFunctions();
+  FSAL_LoadConsts();
+
   /* prepare fsal_init */
 
   /* 1 - fs specific info */
@@ -0,0 +1,1641 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ */
+
+/**
+ * \file    objstore_cache.c
+ * \brief   Local write-back cache of the file chunks.
+ *
+ * Each cached chunk is a file "<inode>.<index>.<seq>" in the cache directory,
+ * where <seq> tells apart the successive copies of a chunk.
+ * A modified chunk also has a marker file "<inode>.<index>.<seq>.dirty",
+ * so that the chunks that were not uploaded before a crash are uploaded
+ * at the next start.
+ *
+ * - Reads that start inside a chunk that is not cached get their range
+ *   directly from the store; the others load the whole chunk in the cache.
+ * - Writes only load the chunks they partially overwrite.
+ * - The chunks of a request are transferred in parallel by the I/O threads.
+ * - A flusher thread uploads the chunks that have been modified for more
+ *   than Flush_Delay seconds, then stores the modified index objects.
+ * - Clean chunks are evicted in LRU order when the cache is full.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "FSAL/FSAL_OBJSTORE/objstore.h"
+#include "stuff_alloc.h"
+#include "log_macros.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+#include <unistd.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+
+/* number of buckets of the chunk table */
+#define OBJSTORE_CHUNK_HASH   1021
+
+/* max number of chunks uploaded by a flusher pass, per I/O thread */
+#define OBJSTORE_FLUSH_BATCH  4
+
+/* room left after the cache directory for the name of a chunk file,
+ * i.e. "/<inode>.<index>.<seq>.dirty" */
+#define OBJSTORE_CHUNK_NAME_MAX  64
+
+/** A cached chunk */
+typedef struct objstore_chunk__
+{
+  objstore_inode_t *p_inode;    /* referenced while the chunk is cached */
+  fsal_u64_t index;
+  unsigned int seq;
+
+  int fd;                       /* cache file */
+
+  int loading;                  /* the cache file is being created */
+  int load_rc;
+  int hashed;                   /* still in the cache */
+  int dirty;                    /* modified since the last upload */
+  int uploading;
+  int unsynced;                 /* modified since the last fsync */
+  int marker;                   /* the dirty marker file exists */
+  unsigned int pins;            /* users of the cache file */
+  time_t dirty_time;
+
+  struct objstore_chunk__ *hash_next;
+  struct objstore_chunk__ *lru_prev;
+  struct objstore_chunk__ *lru_next;
+  struct objstore_chunk__ *dirty_prev;
+  struct objstore_chunk__ *dirty_next;
+
+} objstore_chunk_t;
+
+/** Requests waited for together */
+typedef struct objstore_batch__
+{
+  unsigned int pending;
+  int rc;
+} objstore_batch_t;
+
+/** A chunk transfer */
+typedef struct objstore_job__
+{
+  int (*run) (struct objstore_job__ *);
+
+  objstore_chunk_t *p_chunk;
+  objstore_inode_t *p_inode;
+  fsal_u64_t index;
+
+  /* direct reads */
+  fsal_off_t offset;
+  size_t length;
+  char *buffer;
+
+  int fetch;                    /* loads: read the chunk from the store */
+
+  objstore_batch_t *p_batch;
+  struct objstore_job__ *next;
+
+} objstore_job_t;
+
+static objstorefs_specific_initinfo_t cache_info;
+static fsal_size_t chunk_size;
+
+/* cached chunks, protected by cache_mutex */
+static objstore_chunk_t *chunk_table[OBJSTORE_CHUNK_HASH];
+static objstore_chunk_t lru_list;       /* least recently used first */
+static objstore_chunk_t dirty_list;     /* oldest modifications first */
+static unsigned int nb_chunks = 0;
+static unsigned int nb_dirty = 0;
+static unsigned int chunk_seq = 0;
+static int terminating = FALSE;
+
+static pthread_mutex_t cache_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t cache_cond = PTHREAD_COND_INITIALIZER;    /* chunk state changes */
+static pthread_cond_t flusher_cond = PTHREAD_COND_INITIALIZER;
+
+/* I/O threads */
+static objstore_job_t *job_head = NULL;
+static objstore_job_t *job_tail = NULL;
+static pthread_mutex_t job_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t job_cond = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t batch_cond = PTHREAD_COND_INITIALIZER;
+
+static pthread_t *io_thrids = NULL;
+static pthread_t flusher_thrid;
+
+/* ---------------- I/O threads ---------------- */
+
+static void *objstore_io_thread(void *arg)
+{
+  objstore_job_t *p_job;
+  int rc;
+
+#ifndef _NO_BUDDY_SYSTEM
+  if((rc = BuddyInit(NULL)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_FSAL, "ERROR: Could not initialize memory manager");
+      exit(rc);
+    }
+#endif
+
+  while(1)
+    {
+      P(job_mutex);
+      while(job_head == NULL)
+        pthread_cond_wait(&job_cond, &job_mutex);
+
+      p_job = job_head;
+      if((job_head = p_job->next) == NULL)
+        job_tail = NULL;
+      V(job_mutex);
+
+      /* no job is submitted after termination */
+      if(p_job->run == NULL)
+        return NULL;
+
+      rc = p_job->run(p_job);
+
+      P(job_mutex);
+      if(rc != 0 && p_job->p_batch->rc == 0)
+        p_job->p_batch->rc = rc;
+      if(--p_job->p_batch->pending == 0)
+        pthread_cond_broadcast(&batch_cond);
+      V(job_mutex);
+    }
+
+  return NULL;
+}
+
+/**
+ * Runs a set of jobs in parallel, and waits for them.
+ * The last one is run by the calling thread.
+ * Jobs for the readers are served before the uploads.
+ */
+static int objstore_run_jobs(objstore_job_t * jobs, unsigned int nb_jobs, int urgent)
+{
+  objstore_batch_t batch;
+  unsigned int i;
+  int rc;
+
+  if(nb_jobs == 0)
+    return 0;
+
+  batch.pending = nb_jobs - 1;
+  batch.rc = 0;
+
+  if(nb_jobs > 1)
+    {
+      P(job_mutex);
+
+      for(i = 0; i < nb_jobs - 1; i++)
+        {
+          jobs[i].p_batch = &batch;
+          jobs[i].next = (i < nb_jobs - 2 ? &jobs[i + 1] : NULL);
+        }
+
+      if(urgent)
+        {
+          jobs[nb_jobs - 2].next = job_head;
+          job_head = &jobs[0];
+          if(job_tail == NULL)
+            job_tail = &jobs[nb_jobs - 2];
+        }
+      else
+        {
+          if(job_tail != NULL)
+            job_tail->next = &jobs[0];
+          else
+            job_head = &jobs[0];
+          job_tail = &jobs[nb_jobs - 2];
+        }
+
+      pthread_cond_broadcast(&job_cond);
+      V(job_mutex);
+    }
+
+  rc = jobs[nb_jobs - 1].run(&jobs[nb_jobs - 1]);
+
+  P(job_mutex);
+  while(batch.pending > 0)
+    pthread_cond_wait(&batch_cond, &job_mutex);
+  V(job_mutex);
+
+  return (rc != 0 ? rc : batch.rc);
+}                               /* objstore_run_jobs */
+
+/* ---------------- chunk table ---------------- */
+
+static void chunk_path(char *path, size_t size, objstore_chunk_t * p_chunk, int marker)
+{
+  /* the length of the cache directory is checked by objstore_cache_init:
+   * an empty path only makes the following open or unlink fail */
+  if(snprintf(path, size, "%s/%llu.%llu.%u%s", cache_info.cache_dir,
+              (unsigned long long)p_chunk->p_inode->inode,
+              (unsigned long long)p_chunk->index, p_chunk->seq,
+              (marker ? ".dirty" : "")) >= (int)size)
+    path[0] = '\0';
+}
+
+static void chunk_key(char *key, size_t size, fsal_u64_t inode, fsal_u64_t index)
+{
+  snprintf(key, size, "c/%llu/%llu", (unsigned long long)inode,
+           (unsigned long long)index);
+}
+
+static unsigned int chunk_hash(fsal_u64_t inode, fsal_u64_t index)
+{
+  return (unsigned int)((inode * 2654435761ULL + index) % OBJSTORE_CHUNK_HASH);
+}
+
+static void list_remove(objstore_chunk_t * p_chunk, int dirty)
+{
+  if(dirty)
+    {
+      p_chunk->dirty_prev->dirty_next = p_chunk->dirty_next;
+      p_chunk->dirty_next->dirty_prev = p_chunk->dirty_prev;
+      p_chunk->dirty_prev = p_chunk->dirty_next = NULL;
+    }
+  else
+    {
+      p_chunk->lru_prev->lru_next = p_chunk->lru_next;
+      p_chunk->lru_next->lru_prev = p_chunk->lru_prev;
+    }
+}
+
+static void list_append(objstore_chunk_t * p_chunk, int dirty)
+{
+  if(dirty)
+    {
+      p_chunk->dirty_prev = dirty_list.dirty_prev;
+      p_chunk->dirty_next = &dirty_list;
+      dirty_list.dirty_prev->dirty_next = p_chunk;
+      dirty_list.dirty_prev = p_chunk;
+    }
+  else
+    {
+      p_chunk->lru_prev = lru_list.lru_prev;
+      p_chunk->lru_next = &lru_list;
+      lru_list.lru_prev->lru_next = p_chunk;
+      lru_list.lru_prev = p_chunk;
+    }
+}
+
+/* called with cache_mutex held */
+static objstore_chunk_t *chunk_lookup(fsal_u64_t inode, fsal_u64_t index)
+{
+  objstore_chunk_t *p_chunk;
+
+  for(p_chunk = chunk_table[chunk_hash(inode, index)]; p_chunk != NULL;
+      p_chunk = p_chunk->hash_next)
+    {
+      if(p_chunk->p_inode->inode == inode && p_chunk->index == index)
+        return p_chunk;
+    }
+
+  return NULL;
+}
+
+/* creates a pinned chunk in loading state, called with cache_mutex held */
+static objstore_chunk_t *chunk_create(objstore_inode_t * p_inode, fsal_u64_t index)
+{
+  objstore_chunk_t *p_chunk;
+  unsigned int h = chunk_hash(p_inode->inode, index);
+
+  if((p_chunk = (objstore_chunk_t *) Mem_Alloc(sizeof(objstore_chunk_t))) == NULL)
+    return NULL;
+
+  memset(p_chunk, 0, sizeof(objstore_chunk_t));
+  p_chunk->p_inode = p_inode;
+  p_chunk->index = index;
+  p_chunk->seq = chunk_seq++;
+  p_chunk->fd = -1;
+  p_chunk->loading = TRUE;
+  p_chunk->hashed = TRUE;
+  p_chunk->pins = 1;
+
+  objstore_inode_ref(p_inode);
+
+  p_chunk->hash_next = chunk_table[h];
+  chunk_table[h] = p_chunk;
+  list_append(p_chunk, FALSE);
+  nb_chunks++;
+
+  return p_chunk;
+}
+
+/* removes a chunk from the cache, called with cache_mutex held.
+ * The chunk is freed by the last unpin. */
+static void chunk_unhash(objstore_chunk_t * p_chunk)
+{
+  objstore_chunk_t **pp_chunk;
+
+  pp_chunk = &chunk_table[chunk_hash(p_chunk->p_inode->inode, p_chunk->index)];
+  while(*pp_chunk != p_chunk)
+    pp_chunk = &(*pp_chunk)->hash_next;
+  *pp_chunk = p_chunk->hash_next;
+
+  list_remove(p_chunk, FALSE);
+  if(p_chunk->dirty)
+    {
+      list_remove(p_chunk, TRUE);
+      nb_dirty--;
+    }
+
+  p_chunk->hashed = FALSE;
+  p_chunk->dirty = FALSE;
+  nb_chunks--;
+}
+
+/* closes and removes the files of a chunk that is no longer cached */
+static void chunk_free(objstore_chunk_t * p_chunk)
+{
+  char path[MAXPATHLEN];
+
+  if(p_chunk->fd >= 0)
+    close(p_chunk->fd);
+
+  if(p_chunk->marker)
+    {
+      chunk_path(path, sizeof(path), p_chunk, TRUE);
+      unlink(path);
+    }
+
+  chunk_path(path, sizeof(path), p_chunk, FALSE);
+  unlink(path);
+
+  objstore_inode_put(p_chunk->p_inode);
+  Mem_Free(p_chunk);
+}
+
+/* called with cache_mutex held, returns TRUE if the chunk must be freed */
+static int chunk_unpin(objstore_chunk_t * p_chunk)
+{
+  return (--p_chunk->pins == 0 && !p_chunk->hashed);
+}
+
+static void chunk_release(objstore_chunk_t * p_chunk)
+{
+  int last;
+
+  P(cache_mutex);
+  last = chunk_unpin(p_chunk);
+  V(cache_mutex);
+
+  if(last)
+    chunk_free(p_chunk);
+}
+
+/* waits for a chunk to be loaded, called with cache_mutex held */
+static int chunk_wait_loaded(objstore_chunk_t * p_chunk)
+{
+  while(p_chunk->loading)
+    pthread_cond_wait(&cache_cond, &cache_mutex);
+
+  return p_chunk->load_rc;
+}
+
+/* marks a chunk as modified, called with cache_mutex held */
+static void chunk_set_dirty(objstore_chunk_t * p_chunk)
+{
+  p_chunk->unsynced = TRUE;
+
+  if(p_chunk->dirty || !p_chunk->hashed)
+    return;
+
+  p_chunk->dirty = TRUE;
+  p_chunk->dirty_time = time(NULL);
+  list_append(p_chunk, TRUE);
+  nb_dirty++;
+}
+
+/* creates the dirty marker of a chunk */
+static int chunk_mark(objstore_chunk_t * p_chunk)
+{
+  char path[MAXPATHLEN];
+  int fd;
+
+  if(p_chunk->marker)
+    return 0;
+
+  chunk_path(path, sizeof(path), p_chunk, TRUE);
+
+  if((fd = open(path, O_WRONLY | O_CREAT, 0600)) < 0)
+    return errno;
+  close(fd);
+
+  p_chunk->marker = TRUE;
+  return 0;
+}
+
+/* evicts clean chunks until the cache fits its size */
+static void objstore_cache_evict(void)
+{
+  objstore_chunk_t *p_chunk, *p_next;
+  objstore_chunk_t *evicted = NULL;
+
+  P(cache_mutex);
+
+  for(p_chunk = lru_list.lru_next;
+      p_chunk != &lru_list && (fsal_size_t) nb_chunks * chunk_size > cache_info.cache_size;
+      p_chunk = p_next)
+    {
+      p_next = p_chunk->lru_next;
+
+      if(p_chunk->pins > 0 || p_chunk->dirty || p_chunk->uploading)
+        continue;
+
+      chunk_unhash(p_chunk);
+      p_chunk->hash_next = evicted;
+      evicted = p_chunk;
+    }
+
+  V(cache_mutex);
+
+  while(evicted != NULL)
+    {
+      p_chunk = evicted;
+      evicted = p_chunk->hash_next;
+      chunk_free(p_chunk);
+    }
+}
+
+/* ---------------- transfers ---------------- */
+
+/* creates the cache file of a chunk, and reads its content from the store */
+static int job_load(objstore_job_t * p_job)
+{
+  objstore_chunk_t *p_chunk = p_job->p_chunk;
+  char path[MAXPATHLEN];
+  char key[64];
+  char *buffer = NULL;
+  size_t len = 0;
+  int rc = 0;
+
+  chunk_path(path, sizeof(path), p_chunk, FALSE);
+
+  if((p_chunk->fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0600)) < 0)
+    rc = errno;
+
+  if(rc == 0 && p_job->fetch)
+    {
+      chunk_key(key, sizeof(key), p_chunk->p_inode->inode, p_chunk->index);
+
+      if((buffer = Mem_Alloc(chunk_size)) == NULL)
+        rc = ENOMEM;
+      else if((rc = objstore_get(key, 0, chunk_size, buffer, &len)) == ENOENT)
+        rc = 0;                 /* hole */
+
+      if(rc == 0 && len > 0 && pwrite(p_chunk->fd, buffer, len, 0) != (ssize_t) len)
+        rc = (errno ? errno : EIO);
+
+      if(buffer != NULL)
+        Mem_Free(buffer);
+    }
+
+  P(cache_mutex);
+
+  p_chunk->loading = FALSE;
+  p_chunk->load_rc = rc;
+
+  /* the waiters will see the error */
+  if(rc != 0 && p_chunk->hashed)
+    chunk_unhash(p_chunk);
+
+  pthread_cond_broadcast(&cache_cond);
+  V(cache_mutex);
+
+  if(rc != 0)
+    LogMajor(COMPONENT_FSAL, "OBJSTORE: cannot load chunk %llu of inode %llu: %s",
+             (unsigned long long)p_chunk->index,
+             (unsigned long long)p_chunk->p_inode->inode, strerror(rc));
+
+  return rc;
+}
+
+/* reads a range of a chunk from the store, the missing data reads as zeros */
+static int job_read(objstore_job_t * p_job)
+{
+  char key[64];
+  size_t len = 0;
+  int rc;
+
+  chunk_key(key, sizeof(key), p_job->p_inode->inode, p_job->index);
+
+  rc = objstore_get(key, p_job->offset, p_job->length, p_job->buffer, &len);
+
+  if(rc == ENOENT)
+    rc = 0;
+
+  if(rc == 0 && len < p_job->length)
+    memset(p_job->buffer + len, 0, p_job->length - len);
+
+  return rc;
+}
+
+static int job_upload(objstore_job_t * p_job)
+{
+  objstore_chunk_t *p_chunk = p_job->p_chunk;
+  fsal_u64_t start = p_chunk->index * chunk_size;
+  fsal_size_t size;
+  char key[64];
+  char *buffer;
+  ssize_t len = 0;
+  int rc = 0;
+
+  P(p_chunk->p_inode->lock);
+  size = p_chunk->p_inode->size;
+  V(p_chunk->p_inode->lock);
+
+  /* only the data before the end of the file is uploaded */
+  if(size > start)
+    len = (size - start < chunk_size ? size - start : chunk_size);
+
+  if((buffer = Mem_Alloc(len > 0 ? len : 1)) == NULL)
+    return ENOMEM;
+
+  if(len > 0)
+    {
+      ssize_t rlen = pread(p_chunk->fd, buffer, len, 0);
+
+      if(rlen < 0)
+        rc = errno;
+      else if(rlen < len)
+        memset(buffer + rlen, 0, len - rlen);
+    }
+
+  if(rc == 0)
+    {
+      chunk_key(key, sizeof(key), p_chunk->p_inode->inode, p_chunk->index);
+      rc = objstore_put(key, buffer, len);
+    }
+
+  Mem_Free(buffer);
+  return rc;
+}
+
+static int job_delete(objstore_job_t * p_job)
+{
+  char key[64];
+
+  chunk_key(key, sizeof(key), p_job->p_inode->inode, p_job->index);
+
+  return objstore_delete(key);
+}
+
+/**
+ * Uploads a set of chunks, pinned and marked as uploading.
+ * They are marked as dirty again if the upload fails.
+ */
+static int objstore_upload_chunks(objstore_chunk_t ** chunks, unsigned int nb_chunks_up,
+                                  int urgent)
+{
+  objstore_job_t *jobs;
+  objstore_chunk_t *freed = NULL, *p_chunk;
+  unsigned int i;
+  int rc;
+
+  if(nb_chunks_up == 0)
+    return 0;
+
+  if((jobs = (objstore_job_t *) Mem_Alloc(nb_chunks_up * sizeof(objstore_job_t))) == NULL)
+    rc = ENOMEM;
+  else
+    {
+      memset(jobs, 0, nb_chunks_up * sizeof(objstore_job_t));
+      for(i = 0; i < nb_chunks_up; i++)
+        {
+          jobs[i].run = job_upload;
+          jobs[i].p_chunk = chunks[i];
+        }
+
+      rc = objstore_run_jobs(jobs, nb_chunks_up, urgent);
+      Mem_Free(jobs);
+    }
+
+  P(cache_mutex);
+
+  for(i = 0; i < nb_chunks_up; i++)
+    {
+      chunks[i]->uploading = FALSE;
+
+      /* failed uploads are retried by the flusher
+       * (the error of each chunk is not known) */
+      if(rc != 0)
+        chunk_set_dirty(chunks[i]);
+
+      if(chunk_unpin(chunks[i]))
+        {
+          chunks[i]->hash_next = freed;
+          freed = chunks[i];
+        }
+    }
+
+  pthread_cond_broadcast(&cache_cond);
+  V(cache_mutex);
+
+  while(freed != NULL)
+    {
+      p_chunk = freed;
+      freed = p_chunk->hash_next;
+      chunk_free(p_chunk);
+    }
+
+  if(rc != 0)
+    LogMajor(COMPONENT_FSAL, "OBJSTORE: chunk upload failed: %s", strerror(rc));
+
+  return rc;
+}                               /* objstore_upload_chunks */
+
+/* takes a dirty chunk for upload, called with cache_mutex held */
+static void chunk_take_for_upload(objstore_chunk_t * p_chunk)
+{
+  list_remove(p_chunk, TRUE);
+  nb_dirty--;
+  p_chunk->dirty = FALSE;
+  p_chunk->uploading = TRUE;
+  p_chunk->pins++;
+}
+
+static void *objstore_flusher_thread(void *arg)
+{
+  objstore_chunk_t **chunks;
+  objstore_chunk_t *p_chunk;
+  unsigned int max_chunks = OBJSTORE_FLUSH_BATCH * cache_info.io_threads;
+  unsigned int nb;
+  struct timespec timeout;
+  time_t now;
+  int force, rc;
+
+#ifndef _NO_BUDDY_SYSTEM
+  if((rc = BuddyInit(NULL)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_FSAL, "ERROR: Could not initialize memory manager");
+      exit(rc);
+    }
+#endif
+
+  if((chunks = (objstore_chunk_t **) Mem_Alloc(max_chunks * sizeof(objstore_chunk_t *))) == NULL)
+    {
+      LogCrit(COMPONENT_FSAL, "OBJSTORE: cannot allocate the flusher buffers");
+      exit(1);
+    }
+
+  while(1)
+    {
+      nb = 0;
+
+      P(cache_mutex);
+
+      while(1)
+        {
+          now = time(NULL);
+
+          /* upload without delay when the dirty chunks fill half of the cache */
+          force = terminating
+              || (fsal_size_t) nb_dirty * chunk_size * 2 > cache_info.cache_size;
+
+          for(p_chunk = dirty_list.dirty_next; p_chunk != &dirty_list && nb < max_chunks;)
+            {
+              objstore_chunk_t *p_next = p_chunk->dirty_next;
+
+              if(!force && p_chunk->dirty_time + cache_info.flush_delay > now)
+                break;
+
+              if(!p_chunk->uploading)
+                {
+                  chunk_take_for_upload(p_chunk);
+                  chunks[nb++] = p_chunk;
+                }
+
+              p_chunk = p_next;
+            }
+
+          if(nb > 0 || (terminating && nb_dirty == 0))
+            break;
+
+          /* wait for the oldest modification to be old enough */
+          timeout.tv_sec = now + 1;
+          if(dirty_list.dirty_next != &dirty_list && !force)
+            timeout.tv_sec = dirty_list.dirty_next->dirty_time + cache_info.flush_delay;
+          timeout.tv_nsec = 0;
+
+          pthread_cond_timedwait(&flusher_cond, &cache_mutex, &timeout);
+        }
+
+      V(cache_mutex);
+
+      if(nb == 0)
+        {
+          /* termination */
+          objstore_meta_flush();
+          break;
+        }
+
+      rc = objstore_upload_chunks(chunks, nb, FALSE);
+
+      /* the sizes of the uploaded chunks are now in the store */
+      objstore_meta_flush();
+
+      P(cache_mutex);
+      pthread_cond_broadcast(&cache_cond);
+      force = terminating;
+      V(cache_mutex);
+
+      /* the chunks that cannot be uploaded at exit are kept in the cache */
+      if(rc != 0 && force)
+        break;
+    }
+
+  Mem_Free(chunks);
+  return NULL;
+}                               /* objstore_flusher_thread */
+
+/* ---------------- init ---------------- */
+
+/* reloads the chunks that were not uploaded before the last stop */
+static int objstore_cache_recover(void)
+{
+  DIR *dir;
+  struct dirent *p_dirent;
+  struct stat st;
+  unsigned long long inode, index;
+  unsigned int seq;
+  char path[MAXPATHLEN];
+  char tail[16];
+  objstore_inode_t *p_inode;
+  objstore_chunk_t *p_chunk, *p_old;
+  unsigned int recovered = 0;
+  int rc;
+
+  if((dir = opendir(cache_info.cache_dir)) == NULL)
+    {
+      rc = errno;
+      LogCrit(COMPONENT_FSAL, "OBJSTORE: cannot open cache directory %s: %s",
+              cache_info.cache_dir, strerror(rc));
+      return rc;
+    }
+
+  /* the new copies must not reuse the names of the existing files */
+  while((p_dirent = readdir(dir)) != NULL)
+    {
+      if(sscanf(p_dirent->d_name, "%llu.%llu.%u", &inode, &index, &seq) == 3
+         && seq >= chunk_seq)
+        chunk_seq = seq + 1;
+    }
+
+  /* modified chunks */
+  rewinddir(dir);
+
+  while((p_dirent = readdir(dir)) != NULL)
+    {
+      if(sscanf(p_dirent->d_name, "%llu.%llu.%u.%15s", &inode, &index, &seq, tail) != 4
+         || strcmp(tail, "dirty"))
+        continue;
+
+      if(objstore_inode_get(inode, &p_inode) != 0)
+        continue;               /* the file was removed */
+
+      if((p_chunk = (objstore_chunk_t *) Mem_Alloc(sizeof(objstore_chunk_t))) == NULL)
+        {
+          objstore_inode_put(p_inode);
+          closedir(dir);
+          return ENOMEM;
+        }
+
+      memset(p_chunk, 0, sizeof(objstore_chunk_t));
+      p_chunk->p_inode = p_inode;
+      p_chunk->index = index;
+      p_chunk->seq = seq;
+      p_chunk->marker = TRUE;
+
+      chunk_path(path, sizeof(path), p_chunk, FALSE);
+
+      if((p_chunk->fd = open(path, O_RDWR)) < 0 || fstat(p_chunk->fd, &st))
+        {
+          /* a marker alone is left by a crash during the first write */
+          if(p_chunk->fd >= 0)
+            close(p_chunk->fd);
+          Mem_Free(p_chunk);
+          objstore_inode_put(p_inode);
+          continue;
+        }
+
+      P(cache_mutex);
+
+      /* only the last copy of a chunk is kept */
+      if((p_old = chunk_lookup(inode, index)) != NULL)
+        {
+          if(p_old->seq > seq)
+            {
+              V(cache_mutex);
+              close(p_chunk->fd);
+              Mem_Free(p_chunk);
+              objstore_inode_put(p_inode);
+              continue;
+            }
+          chunk_unhash(p_old);
+          recovered--;
+        }
+
+      /* the reference to the inode is kept by the chunk */
+      p_chunk->hashed = TRUE;
+      p_chunk->hash_next = chunk_table[chunk_hash(inode, index)];
+      chunk_table[chunk_hash(inode, index)] = p_chunk;
+      list_append(p_chunk, FALSE);
+      nb_chunks++;
+      chunk_set_dirty(p_chunk);
+      recovered++;
+
+      V(cache_mutex);
+
+      if(p_old != NULL)
+        chunk_free(p_old);
+
+      /* the size may not have been stored */
+      P(p_inode->lock);
+      if(p_inode->size < index * chunk_size + st.st_size)
+        {
+          p_inode->size = index * chunk_size + st.st_size;
+          p_inode->meta_dirty = TRUE;
+        }
+      V(p_inode->lock);
+    }
+
+  /* the other files may be incomplete or obsolete */
+  rewinddir(dir);
+
+  while((p_dirent = readdir(dir)) != NULL)
+    {
+      int found = FALSE;
+
+      if(sscanf(p_dirent->d_name, "%llu.%llu.%u", &inode, &index, &seq) != 3)
+        continue;
+
+      P(cache_mutex);
+      p_chunk = chunk_lookup(inode, index);
+      found = (p_chunk != NULL && p_chunk->seq == seq);
+      V(cache_mutex);
+
+      if(found)
+        continue;
+
+      if(snprintf(path, sizeof(path), "%s/%s", cache_info.cache_dir, p_dirent->d_name)
+         >= (int)sizeof(path))
+        continue;
+
+      unlink(path);
+    }
+
+  closedir(dir);
+
+  if(recovered > 0)
+    LogEvent(COMPONENT_FSAL, "OBJSTORE: %u modified chunks found in %s", recovered,
+             cache_info.cache_dir);
+
+  return 0;
+}                               /* objstore_cache_recover */
+
+int objstore_cache_init(objstorefs_specific_initinfo_t * p_info)
+{
+  unsigned int i;
+  int rc;
+
+  cache_info = *p_info;
+  chunk_size = objstore_chunk_size();
+
+  if(cache_info.io_threads == 0)
+    cache_info.io_threads = 1;
+
+  lru_list.lru_next = lru_list.lru_prev = &lru_list;
+  dirty_list.dirty_next = dirty_list.dirty_prev = &dirty_list;
+
+  if(strlen(cache_info.cache_dir) + OBJSTORE_CHUNK_NAME_MAX > MAXPATHLEN)
+    {
+      LogCrit(COMPONENT_FSAL, "OBJSTORE: cache directory path %s is too long",
+              cache_info.cache_dir);
+      return ENAMETOOLONG;
+    }
+
+  if(mkdir(cache_info.cache_dir, 0700) && errno != EEXIST)
+    {
+      rc = errno;
+      LogCrit(COMPONENT_FSAL, "OBJSTORE: cannot create cache directory %s: %s",
+              cache_info.cache_dir, strerror(rc));
+      return rc;
+    }
+
+  if((rc = objstore_cache_recover()) != 0)
+    return rc;
+
+  if((io_thrids = (pthread_t *) Mem_Alloc(cache_info.io_threads * sizeof(pthread_t))) == NULL)
+    return ENOMEM;
+
+  for(i = 0; i < cache_info.io_threads; i++)
+    {
+      if((rc = pthread_create(&io_thrids[i], NULL, objstore_io_thread, NULL)) != 0)
+        {
+          LogCrit(COMPONENT_FSAL, "OBJSTORE: cannot create I/O thread: %s",
+                  strerror(rc));
+          return rc;
+        }
+    }
+
+  if((rc = pthread_create(&flusher_thrid, NULL, objstore_flusher_thread, NULL)) != 0)
+    {
+      LogCrit(COMPONENT_FSAL, "OBJSTORE: cannot create flusher thread: %s",
+              strerror(rc));
+      return rc;
+    }
+
+  LogEvent(COMPONENT_FSAL,
+           "OBJSTORE: cache %s of %llu bytes, chunks of %llu bytes, %u I/O threads",
+           cache_info.cache_dir, (unsigned long long)cache_info.cache_size,
+           (unsigned long long)chunk_size, cache_info.io_threads);
+
+  return 0;
+}                               /* objstore_cache_init */
+
+/* ---------------- I/O ---------------- */
+
+/**
+ * Pins the chunks [first, last] of an inode, for a read or a write of
+ * [offset, offset+length[. Missing chunks are created, and the ones that
+ * must be read from the store are loaded in parallel.
+ *
+ * For reads, the missing chunks where the range starts in the middle
+ * of the chunk are not cached: they are read directly to 'buffer'
+ * and their entry in 'chunks' is NULL.
+ */
+static int objstore_chunks_get(objstore_inode_t * p_inode, fsal_off_t offset,
+                               size_t length, fsal_size_t size, char *buffer,
+                               objstore_chunk_t ** chunks)
+{
+  fsal_u64_t first = offset / chunk_size;
+  fsal_u64_t last = (offset + length - 1) / chunk_size;
+  unsigned int nb = last - first + 1;
+  objstore_job_t *jobs;
+  unsigned int nb_jobs = 0;
+  objstore_chunk_t *freed = NULL, *p_chunk;
+  unsigned int i;
+  int rc, alloc_rc = 0;
+
+  if((jobs = (objstore_job_t *) Mem_Alloc(nb * sizeof(objstore_job_t))) == NULL)
+    return ENOMEM;
+  memset(jobs, 0, nb * sizeof(objstore_job_t));
+
+  P(cache_mutex);
+
+  for(i = 0; i < nb; i++)
+    {
+      fsal_u64_t index = first + i;
+      fsal_off_t start = index * chunk_size;
+      fsal_off_t c_off = (offset > start ? offset - start : 0);
+      fsal_off_t c_end = (offset + length < start + chunk_size ?
+                          offset + length - start : chunk_size);
+      fsal_off_t existing = (size > start ? size - start : 0);
+
+      if(existing > chunk_size)
+        existing = chunk_size;
+
+      chunks[i] = NULL;
+
+      if((p_chunk = chunk_lookup(p_inode->inode, index)) != NULL)
+        {
+          p_chunk->pins++;
+          list_remove(p_chunk, FALSE);
+          list_append(p_chunk, FALSE);
+          chunks[i] = p_chunk;
+          continue;
+        }
+
+      if(buffer == NULL || c_off == 0)
+        p_chunk = chunk_create(p_inode, index);
+
+      if(p_chunk == NULL)
+        {
+          if(buffer == NULL)
+            {
+              alloc_rc = ENOMEM;
+              continue;
+            }
+
+          /* read of a range in the middle of a chunk */
+          jobs[nb_jobs].run = job_read;
+          jobs[nb_jobs].p_inode = p_inode;
+          jobs[nb_jobs].index = index;
+          jobs[nb_jobs].offset = c_off;
+          jobs[nb_jobs].length = c_end - c_off;
+          jobs[nb_jobs].buffer = buffer + (start + c_off - offset);
+          nb_jobs++;
+          continue;
+        }
+
+      chunks[i] = p_chunk;
+
+      jobs[nb_jobs].run = job_load;
+      jobs[nb_jobs].p_chunk = p_chunk;
+
+      /* a write that covers all the existing data of the chunk
+       * does not need to read it */
+      if(buffer != NULL)
+        jobs[nb_jobs].fetch = (existing > 0);
+      else
+        jobs[nb_jobs].fetch = (existing > 0 && (c_off > 0 || c_end < existing));
+      nb_jobs++;
+    }
+
+  V(cache_mutex);
+
+  rc = objstore_run_jobs(jobs, nb_jobs, TRUE);
+  if(rc == 0)
+    rc = alloc_rc;
+
+  Mem_Free(jobs);
+
+  /* wait for the chunks loaded by other threads */
+  P(cache_mutex);
+
+  for(i = 0; i < nb; i++)
+    {
+      int rc2;
+
+      if(chunks[i] == NULL)
+        continue;
+
+      if((rc2 = chunk_wait_loaded(chunks[i])) != 0 && rc == 0)
+        rc = rc2;
+    }
+
+  if(rc != 0)
+    {
+      for(i = 0; i < nb; i++)
+        {
+          if(chunks[i] != NULL && chunk_unpin(chunks[i]))
+            {
+              chunks[i]->hash_next = freed;
+              freed = chunks[i];
+            }
+          chunks[i] = NULL;
+        }
+    }
+
+  V(cache_mutex);
+
+  while(freed != NULL)
+    {
+      p_chunk = freed;
+      freed = p_chunk->hash_next;
+      chunk_free(p_chunk);
+    }
+
+  return rc;
+}                               /* objstore_chunks_get */
+
+static void objstore_chunks_release(objstore_chunk_t ** chunks, unsigned int nb)
+{
+  unsigned int i;
+
+  for(i = 0; i < nb; i++)
+    {
+      if(chunks[i] != NULL)
+        chunk_release(chunks[i]);
+    }
+}
+
+int objstore_cache_read(objstore_inode_t * p_inode, fsal_off_t offset,
+                        size_t length, char *buffer, size_t * p_read, int *p_eof)
+{
+  objstore_chunk_t **chunks;
+  fsal_size_t size;
+  fsal_u64_t first;
+  unsigned int nb, i;
+  int rc = 0;
+
+  *p_read = 0;
+  *p_eof = FALSE;
+
+  P_r(&p_inode->data_lock);
+
+  P(p_inode->lock);
+  size = p_inode->size;
+  V(p_inode->lock);
+
+  if(offset + length >= size)
+    {
+      *p_eof = TRUE;
+      length = (offset < size ? size - offset : 0);
+    }
+
+  if(length == 0)
+    {
+      V_r(&p_inode->data_lock);
+      return 0;
+    }
+
+  first = offset / chunk_size;
+  nb = (offset + length - 1) / chunk_size - first + 1;
+
+  if((chunks = (objstore_chunk_t **) Mem_Alloc(nb * sizeof(objstore_chunk_t *))) == NULL)
+    {
+      V_r(&p_inode->data_lock);
+      return ENOMEM;
+    }
+
+  if((rc = objstore_chunks_get(p_inode, offset, length, size, buffer, chunks)) == 0)
+    {
+      for(i = 0; i < nb && rc == 0; i++)
+        {
+          fsal_off_t start = (first + i) * chunk_size;
+          fsal_off_t c_off = (offset > start ? offset - start : 0);
+          fsal_off_t c_end = (offset + length < start + chunk_size ?
+                              offset + length - start : chunk_size);
+          char *dest = buffer + (start + c_off - offset);
+          ssize_t len;
+
+          /* read directly from the store */
+          if(chunks[i] == NULL)
+            continue;
+
+          if((len = pread(chunks[i]->fd, dest, c_end - c_off, c_off)) < 0)
+            rc = errno;
+          else if(len < c_end - c_off)
+            memset(dest + len, 0, c_end - c_off - len);
+        }
+
+      objstore_chunks_release(chunks, nb);
+    }
+
+  V_r(&p_inode->data_lock);
+
+  Mem_Free(chunks);
+
+  if(rc == 0)
+    {
+      *p_read = length;
+      objstore_cache_evict();
+    }
+
+  return rc;
+}                               /* objstore_cache_read */
+
+/* waits for the flusher when too much data is waiting for upload */
+static void objstore_cache_throttle(void)
+{
+  P(cache_mutex);
+
+  while(!terminating && (fsal_size_t) nb_dirty * chunk_size > cache_info.cache_size)
+    {
+      pthread_cond_signal(&flusher_cond);
+      pthread_cond_wait(&cache_cond, &cache_mutex);
+    }
+
+  V(cache_mutex);
+}
+
+int objstore_cache_write(objstore_inode_t * p_inode, fsal_off_t offset,
+                         size_t length, const char *buffer, size_t * p_written)
+{
+  objstore_chunk_t **chunks;
+  fsal_size_t size;
+  fsal_u64_t first;
+  unsigned int nb, i;
+  int rc = 0;
+
+  *p_written = 0;
+
+  if(length == 0)
+    return 0;
+
+  /* must not be done while holding the data lock, the flusher
+   * may be waiting for a truncate that waits for us */
+  objstore_cache_throttle();
+
+  first = offset / chunk_size;
+  nb = (offset + length - 1) / chunk_size - first + 1;
+
+  if((chunks = (objstore_chunk_t **) Mem_Alloc(nb * sizeof(objstore_chunk_t *))) == NULL)
+    return ENOMEM;
+
+  P_r(&p_inode->data_lock);
+
+  P(p_inode->lock);
+  size = p_inode->size;
+  rc = (p_inode->removed ? ESTALE : 0);
+  V(p_inode->lock);
+
+  if(rc == 0 && (rc = objstore_chunks_get(p_inode, offset, length, size, NULL,
+                                          chunks)) == 0)
+    {
+      for(i = 0; i < nb && rc == 0; i++)
+        {
+          fsal_off_t start = (first + i) * chunk_size;
+          fsal_off_t c_off = (offset > start ? offset - start : 0);
+          fsal_off_t c_end = (offset + length < start + chunk_size ?
+                              offset + length - start : chunk_size);
+          const char *src = buffer + (start + c_off - offset);
+
+          if(pwrite(chunks[i]->fd, src, c_end - c_off, c_off) != c_end - c_off)
+            rc = (errno ? errno : ENOSPC);
+          else
+            rc = chunk_mark(chunks[i]);
+
+          P(cache_mutex);
+          chunk_set_dirty(chunks[i]);
+          V(cache_mutex);
+        }
+
+      objstore_chunks_release(chunks, nb);
+    }
+
+  if(rc == 0)
+    {
+      P(p_inode->lock);
+      if(offset + length > p_inode->size)
+        p_inode->size = offset + length;
+      p_inode->mtime = p_inode->ctime = time(NULL);
+      p_inode->meta_dirty = TRUE;
+      V(p_inode->lock);
+
+      *p_written = length;
+    }
+
+  V_r(&p_inode->data_lock);
+
+  Mem_Free(chunks);
+
+  objstore_cache_evict();
+
+  return rc;
+}                               /* objstore_cache_write */
+
+/**
+ * Removes the cached chunks of an inode from 'from_index',
+ * after the end of their transfers.
+ * Returns the highest index of the removed chunks + 1.
+ * Called with the inode data lock taken for write.
+ */
+static fsal_u64_t objstore_cache_drop(objstore_inode_t * p_inode, fsal_u64_t from_index)
+{
+  objstore_chunk_t *p_chunk, *p_next;
+  objstore_chunk_t *freed = NULL;
+  fsal_u64_t end = from_index;
+  int busy;
+
+  P(cache_mutex);
+
+  do
+    {
+      busy = FALSE;
+
+      for(p_chunk = lru_list.lru_next; p_chunk != &lru_list; p_chunk = p_next)
+        {
+          p_next = p_chunk->lru_next;
+
+          if(p_chunk->p_inode != p_inode || p_chunk->index < from_index)
+            continue;
+
+          /* an upload would recreate the object */
+          if(p_chunk->uploading || p_chunk->loading)
+            {
+              busy = TRUE;
+              continue;
+            }
+
+          if(p_chunk->index >= end)
+            end = p_chunk->index + 1;
+
+          /* the chunks still pinned are freed by their last user */
+          chunk_unhash(p_chunk);
+          if(p_chunk->pins == 0)
+            {
+              p_chunk->hash_next = freed;
+              freed = p_chunk;
+            }
+        }
+
+      if(busy)
+        pthread_cond_wait(&cache_cond, &cache_mutex);
+    }
+  while(busy);
+
+  V(cache_mutex);
+
+  while(freed != NULL)
+    {
+      p_chunk = freed;
+      freed = p_chunk->hash_next;
+      chunk_free(p_chunk);
+    }
+
+  return end;
+}                               /* objstore_cache_drop */
+
+/* deletes the chunk objects [first, end[ of an inode */
+static int objstore_chunks_delete(objstore_inode_t * p_inode, fsal_u64_t first,
+                                  fsal_u64_t end)
+{
+  objstore_job_t *jobs;
+  fsal_u64_t index;
+  unsigned int max_jobs = 4 * cache_info.io_threads;
+  unsigned int nb_jobs;
+  int rc = 0, rc2;
+
+  if((jobs = (objstore_job_t *) Mem_Alloc(max_jobs * sizeof(objstore_job_t))) == NULL)
+    return ENOMEM;
+
+  for(index = first; index < end;)
+    {
+      memset(jobs, 0, max_jobs * sizeof(objstore_job_t));
+
+      for(nb_jobs = 0; nb_jobs < max_jobs && index < end; nb_jobs++, index++)
+        {
+          jobs[nb_jobs].run = job_delete;
+          jobs[nb_jobs].p_inode = p_inode;
+          jobs[nb_jobs].index = index;
+        }
+
+      if((rc2 = objstore_run_jobs(jobs, nb_jobs, TRUE)) != 0)
+        rc = rc2;
+    }
+
+  Mem_Free(jobs);
+  return rc;
+}
+
+int objstore_cache_truncate(objstore_inode_t * p_inode, fsal_size_t length)
+{
+  objstore_chunk_t *p_chunk = NULL;
+  fsal_size_t old_size;
+  fsal_u64_t first, end;
+  int rc = 0;
+
+  P_w(&p_inode->data_lock);
+
+  P(p_inode->lock);
+  old_size = p_inode->size;
+  V(p_inode->lock);
+
+  if(length < old_size)
+    {
+      /* chunks after the new end of file */
+      first = (length + chunk_size - 1) / chunk_size;
+      end = objstore_cache_drop(p_inode, first);
+      if(end < (old_size + chunk_size - 1) / chunk_size)
+        end = (old_size + chunk_size - 1) / chunk_size;
+
+      rc = objstore_chunks_delete(p_inode, first, end);
+
+      /* the end of the last chunk must read as zeros if the file grows again */
+      if(rc == 0 && length % chunk_size != 0)
+        {
+          if((rc = objstore_chunks_get(p_inode, length - 1, 1, old_size, NULL,
+                                       &p_chunk)) == 0)
+            {
+              if(ftruncate(p_chunk->fd, length % chunk_size))
+                rc = errno;
+              else
+                rc = chunk_mark(p_chunk);
+
+              P(cache_mutex);
+              chunk_set_dirty(p_chunk);
+              V(cache_mutex);
+
+              chunk_release(p_chunk);
+            }
+        }
+    }
+
+  if(rc == 0)
+    {
+      P(p_inode->lock);
+      p_inode->size = length;
+      p_inode->mtime = p_inode->ctime = time(NULL);
+      V(p_inode->lock);
+
+      rc = objstore_inode_store(p_inode);
+    }
+
+  V_w(&p_inode->data_lock);
+
+  return rc;
+}                               /* objstore_cache_truncate */
+
+int objstore_cache_remove(objstore_inode_t * p_inode)
+{
+  fsal_size_t size;
+  fsal_u64_t end;
+  int rc;
+
+  P_w(&p_inode->data_lock);
+
+  P(p_inode->lock);
+  size = p_inode->size;
+  V(p_inode->lock);
+
+  end = objstore_cache_drop(p_inode, 0);
+  if(end < (size + chunk_size - 1) / chunk_size)
+    end = (size + chunk_size - 1) / chunk_size;
+
+  rc = objstore_chunks_delete(p_inode, 0, end);
+
+  V_w(&p_inode->data_lock);
+
+  return rc;
+}
+
+int objstore_cache_sync(objstore_inode_t * p_inode, int upload)
+{
+  objstore_chunk_t **chunks = NULL;
+  objstore_chunk_t *p_chunk;
+  unsigned int nb = 0, max = 0, i;
+  int wait_upload;
+  int rc = 0, rc2;
+
+  /* fsync the modified cache files */
+  P(cache_mutex);
+
+  for(p_chunk = lru_list.lru_next; p_chunk != &lru_list; p_chunk = p_chunk->lru_next)
+    {
+      if(p_chunk->p_inode != p_inode || !p_chunk->unsynced)
+        continue;
+
+      if(nb == max)
+        {
+          objstore_chunk_t **chunks2;
+
+          max = (max ? 2 * max : 16);
+          if((chunks2 = (objstore_chunk_t **) Mem_Realloc(chunks, max * sizeof(*chunks))) == NULL)
+            {
+              rc = ENOMEM;
+              break;
+            }
+          chunks = chunks2;
+        }
+
+      p_chunk->unsynced = FALSE;
+      p_chunk->pins++;
+      chunks[nb++] = p_chunk;
+    }
+
+  V(cache_mutex);
+
+  for(i = 0; i < nb; i++)
+    {
+      if(fsync(chunks[i]->fd))
+        {
+          rc = errno;
+          P(cache_mutex);
+          chunks[i]->unsynced = TRUE;
+          V(cache_mutex);
+        }
+      chunk_release(chunks[i]);
+    }
+
+  if(rc == 0 && upload && max == 0)
+    {
+      max = 16;
+      if((chunks = (objstore_chunk_t **) Mem_Alloc(max * sizeof(*chunks))) == NULL)
+        rc = ENOMEM;
+    }
+
+  if(rc != 0 || !upload)
+    {
+      if(chunks != NULL)
+        Mem_Free(chunks);
+      return rc;
+    }
+
+  /* upload the dirty chunks, after the uploads in progress */
+  do
+    {
+      nb = 0;
+      wait_upload = FALSE;
+
+      P(cache_mutex);
+
+      for(p_chunk = dirty_list.dirty_next; p_chunk != &dirty_list;)
+        {
+          objstore_chunk_t *p_next = p_chunk->dirty_next;
+
+          if(p_chunk->p_inode == p_inode)
+            {
+              if(p_chunk->uploading)
+                wait_upload = TRUE;
+              else if(nb < max)
+                {
+                  chunk_take_for_upload(p_chunk);
+                  chunks[nb++] = p_chunk;
+                }
+              else
+                wait_upload = TRUE;
+            }
+
+          p_chunk = p_next;
+        }
+
+      if(nb == 0 && wait_upload)
+        pthread_cond_wait(&cache_cond, &cache_mutex);
+
+      V(cache_mutex);
+
+      if((rc2 = objstore_upload_chunks(chunks, nb, TRUE)) != 0)
+        {
+          rc = rc2;
+          break;
+        }
+    }
+  while(nb > 0 || wait_upload);
+
+  if(chunks != NULL)
+    Mem_Free(chunks);
+
+  if(rc == 0 && p_inode->meta_dirty)
+    rc = objstore_inode_store(p_inode);
+
+  return rc;
+}                               /* objstore_cache_sync */
+
+int objstore_cache_terminate(void)
+{
+  objstore_job_t *stop_jobs;
+  objstore_chunk_t *p_chunk, *p_next;
+  objstore_chunk_t *freed = NULL;
+  unsigned int i;
+  int rc = 0;
+
+  P(cache_mutex);
+  terminating = TRUE;
+  pthread_cond_broadcast(&flusher_cond);
+  pthread_cond_broadcast(&cache_cond);
+  V(cache_mutex);
+
+  /* the flusher exits when everything is uploaded */
+  pthread_join(flusher_thrid, NULL);
+
+  if((stop_jobs = (objstore_job_t *) Mem_Alloc(cache_info.io_threads * sizeof(objstore_job_t))) == NULL)
+    return ENOMEM;
+
+  /* one empty job stops an I/O thread */
+  P(job_mutex);
+  for(i = 0; i < cache_info.io_threads; i++)
+    {
+      memset(&stop_jobs[i], 0, sizeof(objstore_job_t));
+      if(job_tail != NULL)
+        job_tail->next = &stop_jobs[i];
+      else
+        job_head = &stop_jobs[i];
+      job_tail = &stop_jobs[i];
+    }
+  pthread_cond_broadcast(&job_cond);
+  V(job_mutex);
+
+  for(i = 0; i < cache_info.io_threads; i++)
+    pthread_join(io_thrids[i], NULL);
+
+  Mem_Free(stop_jobs);
+  Mem_Free(io_thrids);
+  io_thrids = NULL;
+
+  /* the cache content is not kept */
+  P(cache_mutex);
+
+  if(nb_dirty > 0)
+    {
+      LogCrit(COMPONENT_FSAL, "OBJSTORE: %u chunks could not be uploaded, kept in %s",
+              nb_dirty, cache_info.cache_dir);
+      rc = EIO;
+    }
+
+  for(p_chunk = lru_list.lru_next; p_chunk != &lru_list; p_chunk = p_next)
+    {
+      p_next = p_chunk->lru_next;
+
+      if(p_chunk->dirty || p_chunk->pins > 0)
+        continue;
+
+      chunk_unhash(p_chunk);
+      p_chunk->hash_next = freed;
+      freed = p_chunk;
+    }
+
+  V(cache_mutex);
+
+  while(freed != NULL)
+    {
+      p_chunk = freed;
+      freed = p_chunk->hash_next;
+      chunk_free(p_chunk);
+    }
+
+  return rc;
+}                               /* objstore_cache_terminate */
@@ -0,0 +1,715 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ */
+
+/**
+ * \file    objstore_client.c
+ * \brief   Minimal S3 client: PUT, ranged GET and DELETE of objects,
+ *          over HTTP/1.1 persistent connections.
+ *
+ * Requests are path-style ("/<bucket>/<key_prefix><key>"), and are signed
+ * with the AWS signature version 2 when an access key is configured.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "FSAL/FSAL_OBJSTORE/objstore.h"
+#include "stuff_alloc.h"
+#include "log_macros.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <strings.h>
+#include <errno.h>
+#include <unistd.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <time.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+#include <openssl/hmac.h>
+#include <openssl/evp.h>
+
+/* max size of the request and response headers */
+#define OBJSTORE_HEADER_SIZE   4096
+
+/* max number of idle connections kept open */
+#define OBJSTORE_MAX_IDLE      64
+
+/* max size of a key, with the bucket and the prefix */
+#define OBJSTORE_MAX_KEY       (3 * MAXNAMLEN + 64)
+
+static objstorefs_specific_initinfo_t client_info;
+
+static struct sockaddr_storage server_addr;
+static socklen_t server_addrlen;
+
+/* stack of idle connections */
+static int idle_socks[OBJSTORE_MAX_IDLE];
+static unsigned int nb_idle = 0;
+static pthread_mutex_t idle_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** connection with its receive buffer */
+typedef struct objstore_conn__
+{
+  int sock;
+  int reused;                   /* taken from the idle connections */
+  char buff[OBJSTORE_HEADER_SIZE];
+  size_t start;                 /* unread data is buff[start..end[ */
+  size_t end;
+} objstore_conn_t;
+
+/** where the body of a response goes */
+typedef struct objstore_sink__
+{
+  char *buffer;
+  size_t size;                  /* size of the buffer */
+  size_t skip;                  /* bytes to ignore first */
+  size_t full_skip;             /* bytes to ignore when the server sends
+                                 * the whole object instead of a range */
+  size_t length;                /* bytes stored */
+  int alloc;                    /* grow the buffer with Mem_Realloc */
+} objstore_sink_t;
+
+int objstore_client_init(objstorefs_specific_initinfo_t * p_info)
+{
+  struct addrinfo hints, *res;
+  char port[16];
+  int rc;
+
+  client_info = *p_info;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(port, sizeof(port), "%hu", p_info->port);
+
+  if((rc = getaddrinfo(p_info->host, port, &hints, &res)) != 0)
+    {
+      LogCrit(COMPONENT_FSAL, "OBJSTORE: cannot resolve %s: %s", p_info->host,
+              gai_strerror(rc));
+      return EHOSTUNREACH;
+    }
+
+  memcpy(&server_addr, res->ai_addr, res->ai_addrlen);
+  server_addrlen = res->ai_addrlen;
+  freeaddrinfo(res);
+
+  return 0;
+}                               /* objstore_client_init */
+
+static int objstore_connect(objstore_conn_t * p_conn)
+{
+  struct timeval tv;
+  int one = 1;
+
+  p_conn->start = p_conn->end = 0;
+  p_conn->reused = FALSE;
+
+  P(idle_mutex);
+  if(nb_idle > 0)
+    {
+      p_conn->sock = idle_socks[--nb_idle];
+      p_conn->reused = TRUE;
+    }
+  V(idle_mutex);
+
+  if(p_conn->reused)
+    return 0;
+
+  if((p_conn->sock = socket(server_addr.ss_family, SOCK_STREAM, 0)) < 0)
+    return errno;
+
+  setsockopt(p_conn->sock, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+  if(client_info.timeout > 0)
+    {
+      tv.tv_sec = client_info.timeout;
+      tv.tv_usec = 0;
+      setsockopt(p_conn->sock, SOL_SOCKET, SO_RCVTIMEO, &tv, sizeof(tv));
+      setsockopt(p_conn->sock, SOL_SOCKET, SO_SNDTIMEO, &tv, sizeof(tv));
+    }
+
+  if(connect(p_conn->sock, (struct sockaddr *)&server_addr, server_addrlen))
+    {
+      int rc = errno;
+
+      LogMajor(COMPONENT_FSAL, "OBJSTORE: cannot connect to %s:%hu: %s",
+               client_info.host, client_info.port, strerror(rc));
+      close(p_conn->sock);
+      return rc;
+    }
+
+  return 0;
+}                               /* objstore_connect */
+
+/* keeps the connection open for the next requests, or closes it */
+static void objstore_release(objstore_conn_t * p_conn, int keep)
+{
+  if(keep && p_conn->start == p_conn->end)
+    {
+      P(idle_mutex);
+      if(nb_idle < OBJSTORE_MAX_IDLE)
+        {
+          idle_socks[nb_idle++] = p_conn->sock;
+          p_conn->sock = -1;
+        }
+      V(idle_mutex);
+    }
+
+  if(p_conn->sock >= 0)
+    close(p_conn->sock);
+  p_conn->sock = -1;
+}
+
+/* receives more data into the connection buffer */
+static int objstore_fill(objstore_conn_t * p_conn)
+{
+  ssize_t rc;
+
+  if(p_conn->start > 0)
+    {
+      memmove(p_conn->buff, p_conn->buff + p_conn->start,
+              p_conn->end - p_conn->start);
+      p_conn->end -= p_conn->start;
+      p_conn->start = 0;
+    }
+
+  if(p_conn->end == sizeof(p_conn->buff))
+    return EMSGSIZE;
+
+  do
+    rc = recv(p_conn->sock, p_conn->buff + p_conn->end,
+              sizeof(p_conn->buff) - p_conn->end, 0);
+  while(rc < 0 && errno == EINTR);
+
+  if(rc < 0)
+    return errno;
+  if(rc == 0)
+    return ECONNRESET;
+
+  p_conn->end += rc;
+  return 0;
+}
+
+/* returns the next line (without CRLF), or NULL */
+static char *objstore_getline(objstore_conn_t * p_conn, int *p_rc)
+{
+  char *line, *eol;
+
+  while((eol = memchr(p_conn->buff + p_conn->start, '\n',
+                      p_conn->end - p_conn->start)) == NULL)
+    {
+      if((*p_rc = objstore_fill(p_conn)) != 0)
+        return NULL;
+    }
+
+  line = p_conn->buff + p_conn->start;
+  p_conn->start = eol + 1 - p_conn->buff;
+
+  *eol = '\0';
+  if(eol > line && eol[-1] == '\r')
+    eol[-1] = '\0';
+
+  *p_rc = 0;
+  return line;
+}
+
+static int objstore_sink_put(objstore_sink_t * p_sink, const char *data, size_t len)
+{
+  size_t skip;
+
+  if(p_sink == NULL)
+    return 0;
+
+  skip = (len < p_sink->skip ? len : p_sink->skip);
+  p_sink->skip -= skip;
+  data += skip;
+  len -= skip;
+
+  if(p_sink->alloc && p_sink->length + len > p_sink->size)
+    {
+      size_t size = 2 * (p_sink->length + len);
+      char *buffer = Mem_Realloc(p_sink->buffer, size);
+
+      if(buffer == NULL)
+        return ENOMEM;
+
+      p_sink->buffer = buffer;
+      p_sink->size = size;
+    }
+
+  /* extra data is ignored */
+  if(p_sink->length + len > p_sink->size)
+    len = p_sink->size - p_sink->length;
+
+  memcpy(p_sink->buffer + p_sink->length, data, len);
+  p_sink->length += len;
+
+  return 0;
+}
+
+/* reads 'len' bytes of body, or until the connection is closed if len < 0 */
+static int objstore_read_body(objstore_conn_t * p_conn, long long len,
+                              objstore_sink_t * p_sink)
+{
+  ssize_t rc;
+  size_t n;
+  char *direct;
+
+  while(len != 0)
+    {
+      if(p_conn->start == p_conn->end)
+        {
+          /* large bodies go straight to the sink buffer */
+          if(p_sink != NULL && !p_sink->alloc && p_sink->skip == 0
+             && p_sink->length < p_sink->size)
+            {
+              n = p_sink->size - p_sink->length;
+              if(len > 0 && (long long)n > len)
+                n = len;
+              direct = p_sink->buffer + p_sink->length;
+
+              do
+                rc = recv(p_conn->sock, direct, n, 0);
+              while(rc < 0 && errno == EINTR);
+
+              if(rc < 0)
+                return errno;
+              if(rc == 0)
+                return (len < 0 ? 0 : ECONNRESET);
+
+              p_sink->length += rc;
+              if(len > 0)
+                len -= rc;
+              continue;
+            }
+
+          if((rc = objstore_fill(p_conn)) != 0)
+            return (len < 0 && rc == ECONNRESET ? 0 : rc);
+        }
+
+      n = p_conn->end - p_conn->start;
+      if(len > 0 && (long long)n > len)
+        n = len;
+
+      if((rc = objstore_sink_put(p_sink, p_conn->buff + p_conn->start, n)) != 0)
+        return rc;
+
+      p_conn->start += n;
+      if(len > 0)
+        len -= n;
+    }
+
+  return 0;
+}
+
+static int objstore_read_chunked(objstore_conn_t * p_conn, objstore_sink_t * p_sink)
+{
+  char *line;
+  long long len;
+  int rc;
+
+  while(1)
+    {
+      if((line = objstore_getline(p_conn, &rc)) == NULL)
+        return rc;
+
+      len = strtoll(line, NULL, 16);
+
+      if(len == 0)
+        break;
+
+      if((rc = objstore_read_body(p_conn, len, p_sink)) != 0)
+        return rc;
+
+      /* CRLF after the chunk */
+      if((line = objstore_getline(p_conn, &rc)) == NULL)
+        return rc;
+    }
+
+  /* trailer */
+  do
+    {
+      if((line = objstore_getline(p_conn, &rc)) == NULL)
+        return rc;
+    }
+  while(line[0] != '\0');
+
+  return 0;
+}
+
+/* AWS signature version 2 of a request */
+static void objstore_sign(const char *verb, const char *content_type,
+                          const char *date, const char *resource, char *signature)
+{
+  char to_sign[OBJSTORE_MAX_KEY + 256];
+  unsigned char md[EVP_MAX_MD_SIZE];
+  unsigned int md_len = 0;
+  int len;
+
+  len = snprintf(to_sign, sizeof(to_sign), "%s\n\n%s\n%s\n%s", verb, content_type,
+                 date, resource);
+
+  HMAC(EVP_sha1(), client_info.secret_access_key,
+       strlen(client_info.secret_access_key), (unsigned char *)to_sign, len, md,
+       &md_len);
+
+  EVP_EncodeBlock((unsigned char *)signature, md, md_len);
+}
+
+/* appends an URL encoded string */
+static size_t objstore_urlencode(char *dest, size_t size, const char *src)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  size_t len = 0;
+
+  for(; *src != '\0' && len + 4 < size; src++)
+    {
+      unsigned char c = *src;
+
+      if((c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || (c >= '0' && c <= '9')
+         || c == '/' || c == '-' || c == '_' || c == '.' || c == '~')
+        dest[len++] = c;
+      else
+        {
+          dest[len++] = '%';
+          dest[len++] = hex[c >> 4];
+          dest[len++] = hex[c & 15];
+        }
+    }
+
+  dest[len] = '\0';
+  return len;
+}
+
+static int objstore_send(int sock, struct iovec *iov, int iovcnt)
+{
+  ssize_t rc;
+
+  while(iovcnt > 0)
+    {
+      struct msghdr msg;
+
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = iovcnt;
+
+      if((rc = sendmsg(sock, &msg, MSG_NOSIGNAL)) < 0)
+        {
+          if(errno == EINTR)
+            continue;
+          return errno;
+        }
+
+      while(iovcnt > 0 && (size_t) rc >= iov->iov_len)
+        {
+          rc -= iov->iov_len;
+          iov++;
+          iovcnt--;
+        }
+
+      if(iovcnt > 0)
+        {
+          iov->iov_base = (char *)iov->iov_base + rc;
+          iov->iov_len -= rc;
+        }
+    }
+
+  return 0;
+}
+
+/**
+ * Sends a request on a connection, and reads its response.
+ * The body of a successful response goes to p_sink.
+ * *p_status is the HTTP status, or 0 if no response was received.
+ */
+static int objstore_exchange(objstore_conn_t * p_conn, const char *verb,
+                             const char *key, const char *range,
+                             const char *body, size_t body_len,
+                             objstore_sink_t * p_sink, int *p_status, int *p_keep)
+{
+  char header[OBJSTORE_HEADER_SIZE];
+  char resource[OBJSTORE_MAX_KEY];
+  char date[64];
+  char signature[64];
+  const char *content_type = (body != NULL ? "application/octet-stream" : "");
+  struct iovec iov[2];
+  struct tm tm;
+  time_t now;
+  size_t len;
+  long long content_length = -1;
+  int chunked = FALSE;
+  char *line;
+  int rc;
+
+  *p_status = 0;
+  *p_keep = TRUE;
+
+  /* "/<bucket>/<prefix><key>" */
+  len = snprintf(resource, sizeof(resource), "/%s/", client_info.bucket);
+  len += objstore_urlencode(resource + len, sizeof(resource) - len,
+                            client_info.key_prefix);
+  objstore_urlencode(resource + len, sizeof(resource) - len, key);
+
+  now = time(NULL);
+  gmtime_r(&now, &tm);
+  strftime(date, sizeof(date), "%a, %d %b %Y %H:%M:%S GMT", &tm);
+
+  len = snprintf(header, sizeof(header),
+                 "%s %s HTTP/1.1\r\nHost: %s\r\nDate: %s\r\n", verb, resource,
+                 client_info.host, date);
+
+  if(client_info.access_key_id[0] != '\0')
+    {
+      objstore_sign(verb, content_type, date, resource, signature);
+      len += snprintf(header + len, sizeof(header) - len,
+                      "Authorization: AWS %s:%s\r\n", client_info.access_key_id,
+                      signature);
+    }
+
+  if(range != NULL)
+    len += snprintf(header + len, sizeof(header) - len, "Range: %s\r\n", range);
+
+  if(body != NULL)
+    len += snprintf(header + len, sizeof(header) - len,
+                    "Content-Type: %s\r\nContent-Length: %llu\r\n", content_type,
+                    (unsigned long long)body_len);
+
+  len += snprintf(header + len, sizeof(header) - len, "\r\n");
+
+  iov[0].iov_base = header;
+  iov[0].iov_len = len;
+  iov[1].iov_base = (char *)body;
+  iov[1].iov_len = body_len;
+
+  if((rc = objstore_send(p_conn->sock, iov, (body != NULL && body_len > 0) ? 2 : 1)))
+    return rc;
+
+  /* status line */
+  if((line = objstore_getline(p_conn, &rc)) == NULL)
+    return rc;
+
+  if(strncmp(line, "HTTP/1.", 7) || sscanf(line + 8, " %d", p_status) != 1)
+    {
+      *p_keep = FALSE;
+      return EPROTO;
+    }
+
+  if(!strncmp(line, "HTTP/1.0", 8))
+    *p_keep = FALSE;
+
+  /* headers */
+  while(1)
+    {
+      if((line = objstore_getline(p_conn, &rc)) == NULL)
+        return rc;
+
+      if(line[0] == '\0')
+        break;
+
+      if(!strncasecmp(line, "Content-Length:", 15))
+        content_length = strtoll(line + 15, NULL, 10);
+      else if(!strncasecmp(line, "Transfer-Encoding:", 18)
+              && strcasestr(line + 18, "chunked") != NULL)
+        chunked = TRUE;
+      else if(!strncasecmp(line, "Connection:", 11)
+              && strcasestr(line + 11, "close") != NULL)
+        *p_keep = FALSE;
+    }
+
+  /* error bodies are discarded */
+  if(*p_status < 200 || *p_status >= 300)
+    p_sink = NULL;
+  else if(p_sink != NULL)
+    p_sink->skip = (*p_status == 200 ? p_sink->full_skip : 0);
+
+  if(!strcmp(verb, "HEAD") || *p_status == 204 || *p_status == 304)
+    return 0;
+
+  if(chunked)
+    rc = objstore_read_chunked(p_conn, p_sink);
+  else
+    {
+      if(content_length < 0)
+        *p_keep = FALSE;
+      rc = objstore_read_body(p_conn, content_length, p_sink);
+    }
+
+  return rc;
+}                               /* objstore_exchange */
+
+static int objstore_request(const char *verb, const char *key, const char *range,
+                            const char *body, size_t body_len,
+                            objstore_sink_t * p_sink, int *p_status)
+{
+  objstore_conn_t *p_conn;
+  size_t sink_length = (p_sink != NULL ? p_sink->length : 0);
+  int keep, rc, retry;
+
+  if((p_conn = (objstore_conn_t *) Mem_Alloc(sizeof(objstore_conn_t))) == NULL)
+    return ENOMEM;
+
+  for(retry = 0; retry < 2; retry++)
+    {
+      if((rc = objstore_connect(p_conn)) != 0)
+        break;
+
+      rc = objstore_exchange(p_conn, verb, key, range, body, body_len, p_sink,
+                             p_status, &keep);
+
+      objstore_release(p_conn, (rc == 0 && keep));
+
+      /* an idle connection may have been closed by the server:
+       * try again on a new one if nothing was received */
+      if(rc == 0 || *p_status != 0 || !p_conn->reused)
+        break;
+
+      if(p_sink != NULL)
+        p_sink->length = sink_length;
+    }
+
+  Mem_Free(p_conn);
+
+  if(rc != 0)
+    {
+      LogMajor(COMPONENT_FSAL, "OBJSTORE: %s %s failed: %s", verb, key, strerror(rc));
+      return EIO;
+    }
+
+  return 0;
+}                               /* objstore_request */
+
+static int objstore_http2errno(int status)
+{
+  if(status >= 200 && status < 300)
+    return 0;
+
+  switch (status)
+    {
+    case 404:
+      return ENOENT;
+    case 401:
+    case 403:
+      return EACCES;
+    case 416:
+      return ERANGE;
+    case 507:
+      return ENOSPC;
+    default:
+      return EIO;
+    }
+}
+
+int objstore_put(const char *key, const char *buffer, size_t length)
+{
+  int status, rc;
+
+  /* an empty body still needs a Content-Length */
+  if((rc = objstore_request("PUT", key, NULL, (buffer != NULL ? buffer : ""), length,
+                            NULL, &status)) != 0)
+    return rc;
+
+  if((rc = objstore_http2errno(status)) != 0)
+    LogMajor(COMPONENT_FSAL, "OBJSTORE: PUT %s: HTTP status %d", key, status);
+
+  return rc;
+}
+
+int objstore_get(const char *key, fsal_off_t offset, size_t length,
+                 char *buffer, size_t * p_read)
+{
+  objstore_sink_t sink;
+  char range[64];
+  int status, rc;
+
+  *p_read = 0;
+
+  if(length == 0)
+    return 0;
+
+  snprintf(range, sizeof(range), "bytes=%llu-%llu", (unsigned long long)offset,
+           (unsigned long long)(offset + length - 1));
+
+  sink.buffer = buffer;
+  sink.size = length;
+  sink.skip = 0;
+  sink.full_skip = offset;
+  sink.length = 0;
+  sink.alloc = FALSE;
+
+  if((rc = objstore_request("GET", key, range, NULL, 0, &sink, &status)) != 0)
+    return rc;
+
+  /* the range starts after the end of the object */
+  if(status == 416)
+    return 0;
+
+  if((rc = objstore_http2errno(status)) != 0)
+    {
+      if(rc != ENOENT)
+        LogMajor(COMPONENT_FSAL, "OBJSTORE: GET %s: HTTP status %d", key, status);
+      return rc;
+    }
+
+  *p_read = sink.length;
+  return 0;
+}
+
+int objstore_get_object(const char *key, char **p_buffer, size_t * p_length)
+{
+  objstore_sink_t sink;
+  int status, rc;
+
+  sink.size = 4096;
+  if((sink.buffer = Mem_Alloc(sink.size)) == NULL)
+    return ENOMEM;
+  sink.skip = 0;
+  sink.full_skip = 0;
+  sink.length = 0;
+  sink.alloc = TRUE;
+
+  rc = objstore_request("GET", key, NULL, NULL, 0, &sink, &status);
+
+  if(rc == 0 && (rc = objstore_http2errno(status)) != 0 && rc != ENOENT)
+    LogMajor(COMPONENT_FSAL, "OBJSTORE: GET %s: HTTP status %d", key, status);
+
+  /* the object is returned as a string */
+  if(rc == 0)
+    rc = objstore_sink_put(&sink, "", 1);
+
+  if(rc != 0)
+    {
+      Mem_Free(sink.buffer);
+      return rc;
+    }
+
+  *p_buffer = sink.buffer;
+  sink.length--;
+  *p_length = sink.length;
+  return 0;
+}
+
+int objstore_delete(const char *key)
+{
+  int status, rc;
+
+  if((rc = objstore_request("DELETE", key, NULL, NULL, 0, NULL, &status)) != 0)
+    return rc;
+
+  /* deleting a missing object is not an error */
+  if(status == 404)
+    return 0;
+
+  if((rc = objstore_http2errno(status)) != 0)
+    LogMajor(COMPONENT_FSAL, "OBJSTORE: DELETE %s: HTTP status %d", key, status);
+
+  return rc;
+}
@@ -0,0 +1,808 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ */
+
+/**
+ * \file    objstore_meta.c
+ * \brief   Index objects of the object store FSAL.
+ *
+ * The index object of a filesystem object is a small text object:
+ *
+ *   OBJSTORE1
+ *   inode <n>
+ *   type file|dir|lnk
+ *   mode <octal>
+ *   uid <n>
+ *   gid <n>
+ *   nlink <n>
+ *   size <n>
+ *   atime <n>
+ *   mtime <n>
+ *   ctime <n>
+ *   parent <n>
+ *   link <length> <content>
+ *   entry <inode> <length> <name>
+ *   ...
+ *
+ * Loaded objects are kept in a table while they are referenced,
+ * or while their index object has to be stored.
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "FSAL/FSAL_OBJSTORE/objstore.h"
+#include "stuff_alloc.h"
+#include "log_macros.h"
+
+#include <string.h>
+#include <stdio.h>
+#include <stdarg.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <time.h>
+
+#define OBJSTORE_MAGIC        "OBJSTORE1"
+
+/* inode numbers are reserved in the superblock by batches */
+#define OBJSTORE_INODE_BATCH  1024
+
+/* number of buckets of the inode table */
+#define OBJSTORE_INODE_HASH   1021
+
+rw_lock_t objstore_ns_lock;
+
+static fsal_size_t meta_chunk_size;
+
+/* inode numbers */
+static fsal_u64_t next_inode;
+static fsal_u64_t reserved_inode;       /* first number not reserved */
+static pthread_mutex_t super_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/* loaded objects */
+static objstore_inode_t *inode_table[OBJSTORE_INODE_HASH];
+static pthread_mutex_t table_mutex = PTHREAD_MUTEX_INITIALIZER;
+
+/** growing text buffer */
+typedef struct objstore_buff__
+{
+  char *data;
+  size_t len;
+  size_t size;
+} objstore_buff_t;
+
+static int buff_append(objstore_buff_t * p_buff, const char *data, size_t len)
+{
+  if(p_buff->len + len + 1 > p_buff->size)
+    {
+      size_t size = 2 * (p_buff->len + len + 1);
+      char *data2 = Mem_Realloc(p_buff->data, size);
+
+      if(data2 == NULL)
+        return ENOMEM;
+
+      p_buff->data = data2;
+      p_buff->size = size;
+    }
+
+  memcpy(p_buff->data + p_buff->len, data, len);
+  p_buff->len += len;
+  p_buff->data[p_buff->len] = '\0';
+  return 0;
+}
+
+static int buff_printf(objstore_buff_t * p_buff, const char *format, ...)
+{
+  char line[128];
+  va_list args;
+  int len;
+
+  va_start(args, format);
+  len = vsnprintf(line, sizeof(line), format, args);
+  va_end(args);
+
+  return buff_append(p_buff, line, len);
+}
+
+/* "<length> <bytes>\n" */
+static int buff_string(objstore_buff_t * p_buff, const char *str)
+{
+  int rc;
+
+  if((rc = buff_printf(p_buff, "%u ", (unsigned int)strlen(str))) != 0
+     || (rc = buff_append(p_buff, str, strlen(str))) != 0)
+    return rc;
+
+  return buff_append(p_buff, "\n", 1);
+}
+
+static const char *type2str(fsal_nodetype_t type)
+{
+  switch (type)
+    {
+    case FSAL_TYPE_DIR:
+      return "dir";
+    case FSAL_TYPE_LNK:
+      return "lnk";
+    default:
+      return "file";
+    }
+}
+
+static fsal_nodetype_t str2type(const char *str)
+{
+  if(!strcmp(str, "dir"))
+    return FSAL_TYPE_DIR;
+  if(!strcmp(str, "lnk"))
+    return FSAL_TYPE_LNK;
+  return FSAL_TYPE_FILE;
+}
+
+static objstore_inode_t *inode_alloc(fsal_u64_t inode)
+{
+  objstore_inode_t *p_inode;
+
+  if((p_inode = (objstore_inode_t *) Mem_Alloc(sizeof(objstore_inode_t))) == NULL)
+    return NULL;
+
+  memset(p_inode, 0, sizeof(objstore_inode_t));
+  p_inode->inode = inode;
+
+  pthread_mutex_init(&p_inode->lock, NULL);
+  pthread_mutex_init(&p_inode->store_lock, NULL);
+  rw_lock_init(&p_inode->data_lock);
+
+  return p_inode;
+}
+
+static void inode_free(objstore_inode_t * p_inode)
+{
+  pthread_mutex_destroy(&p_inode->lock);
+  pthread_mutex_destroy(&p_inode->store_lock);
+  rw_lock_destroy(&p_inode->data_lock);
+
+  if(p_inode->link != NULL)
+    Mem_Free(p_inode->link);
+  if(p_inode->entries != NULL)
+    Mem_Free(p_inode->entries);
+
+  Mem_Free(p_inode);
+}
+
+/* builds the index object, called with the inode lock held */
+static int inode_serialize(objstore_inode_t * p_inode, objstore_buff_t * p_buff)
+{
+  unsigned int i;
+  int rc;
+
+  if((rc = buff_printf(p_buff, "%s\ninode %llu\ntype %s\nmode %o\n", OBJSTORE_MAGIC,
+                       (unsigned long long)p_inode->inode, type2str(p_inode->type),
+                       (unsigned int)p_inode->mode)) != 0
+     || (rc = buff_printf(p_buff, "uid %u\ngid %u\nnlink %u\nsize %llu\n",
+                          (unsigned int)p_inode->uid, (unsigned int)p_inode->gid,
+                          p_inode->nlink, (unsigned long long)p_inode->size)) != 0
+     || (rc = buff_printf(p_buff, "atime %ld\nmtime %ld\nctime %ld\nparent %llu\n",
+                          (long)p_inode->atime, (long)p_inode->mtime,
+                          (long)p_inode->ctime,
+                          (unsigned long long)p_inode->parent)) != 0)
+    return rc;
+
+  if(p_inode->link != NULL)
+    {
+      if((rc = buff_append(p_buff, "link ", 5)) != 0
+         || (rc = buff_string(p_buff, p_inode->link)) != 0)
+        return rc;
+    }
+
+  for(i = 0; i < p_inode->nb_entries; i++)
+    {
+      if((rc = buff_printf(p_buff, "entry %llu ",
+                           (unsigned long long)p_inode->entries[i].inode)) != 0
+         || (rc = buff_string(p_buff, p_inode->entries[i].name)) != 0)
+        return rc;
+    }
+
+  return 0;
+}
+
+/* reads "<length> <bytes>\n" into a string of max size 'size' */
+static char *parse_string(char *cur, char *end, char *str, size_t size)
+{
+  char *next;
+  unsigned long len = strtoul(cur, &next, 10);
+
+  if(next == cur || *next != ' ' || len >= size || next + 1 + len >= end
+     || next[1 + len] != '\n')
+    return NULL;
+
+  memcpy(str, next + 1, len);
+  str[len] = '\0';
+  return next + 2 + len;
+}
+
+static int inode_parse(objstore_inode_t * p_inode, char *data, size_t len)
+{
+  char *cur = data;
+  char *end = data + len;
+  char *eol;
+  char word[16];
+  char value[FSAL_MAX_PATH_LEN];
+  unsigned long long num;
+  unsigned int mode;
+
+  if(len < strlen(OBJSTORE_MAGIC) + 1 || strncmp(data, OBJSTORE_MAGIC "\n",
+                                                 strlen(OBJSTORE_MAGIC) + 1))
+    return EIO;
+
+  cur += strlen(OBJSTORE_MAGIC) + 1;
+
+  while(cur < end)
+    {
+      if((eol = memchr(cur, ' ', end - cur)) == NULL
+         || eol - cur >= (int)sizeof(word))
+        return EIO;
+
+      memcpy(word, cur, eol - cur);
+      word[eol - cur] = '\0';
+      cur = eol + 1;
+
+      if(!strcmp(word, "link"))
+        {
+          if((cur = parse_string(cur, end, value, sizeof(value))) == NULL)
+            return EIO;
+          if(p_inode->link != NULL)
+            Mem_Free(p_inode->link);
+          if((p_inode->link = Mem_Alloc(strlen(value) + 1)) == NULL)
+            return ENOMEM;
+          strcpy(p_inode->link, value);
+          continue;
+        }
+
+      if(!strcmp(word, "entry"))
+        {
+          objstore_dirent_t *p_entry;
+
+          num = strtoull(cur, &cur, 10);
+          if(*cur++ != ' ')
+            return EIO;
+
+          if(p_inode->nb_entries == p_inode->max_entries)
+            {
+              unsigned int max = (p_inode->max_entries ? 2 * p_inode->max_entries : 16);
+              objstore_dirent_t *entries =
+                  (objstore_dirent_t *) Mem_Realloc(p_inode->entries, max * sizeof(objstore_dirent_t));
+
+              if(entries == NULL)
+                return ENOMEM;
+              p_inode->entries = entries;
+              p_inode->max_entries = max;
+            }
+
+          p_entry = &p_inode->entries[p_inode->nb_entries];
+          p_entry->inode = num;
+          if((cur = parse_string(cur, end, p_entry->name, FSAL_MAX_NAME_LEN)) == NULL)
+            return EIO;
+          p_inode->nb_entries++;
+          continue;
+        }
+
+      if((eol = memchr(cur, '\n', end - cur)) == NULL
+         || eol - cur >= (int)sizeof(value))
+        return EIO;
+
+      memcpy(value, cur, eol - cur);
+      value[eol - cur] = '\0';
+      cur = eol + 1;
+
+      if(!strcmp(word, "inode"))
+        {
+          if(strtoull(value, NULL, 10) != p_inode->inode)
+            return EIO;
+        }
+      else if(!strcmp(word, "type"))
+        p_inode->type = str2type(value);
+      else if(!strcmp(word, "mode"))
+        {
+          sscanf(value, "%o", &mode);
+          p_inode->mode = mode;
+        }
+      else if(!strcmp(word, "uid"))
+        p_inode->uid = strtoul(value, NULL, 10);
+      else if(!strcmp(word, "gid"))
+        p_inode->gid = strtoul(value, NULL, 10);
+      else if(!strcmp(word, "nlink"))
+        p_inode->nlink = strtoul(value, NULL, 10);
+      else if(!strcmp(word, "size"))
+        p_inode->size = strtoull(value, NULL, 10);
+      else if(!strcmp(word, "atime"))
+        p_inode->atime = strtol(value, NULL, 10);
+      else if(!strcmp(word, "mtime"))
+        p_inode->mtime = strtol(value, NULL, 10);
+      else if(!strcmp(word, "ctime"))
+        p_inode->ctime = strtol(value, NULL, 10);
+      else if(!strcmp(word, "parent"))
+        p_inode->parent = strtoull(value, NULL, 10);
+      /* unknown keys are ignored */
+    }
+
+  return 0;
+}                               /* inode_parse */
+
+static int super_store(fsal_u64_t reserved)
+{
+  char super[128];
+  int len;
+
+  len = snprintf(super, sizeof(super), "%s\nnext_inode %llu\nchunk_size %llu\n",
+                 OBJSTORE_MAGIC, (unsigned long long)reserved,
+                 (unsigned long long)meta_chunk_size);
+
+  return objstore_put("super", super, len);
+}
+
+static int inode_number_alloc(fsal_u64_t * p_inode)
+{
+  int rc;
+
+  P(super_mutex);
+
+  if(next_inode >= reserved_inode)
+    {
+      if((rc = super_store(next_inode + OBJSTORE_INODE_BATCH)) != 0)
+        {
+          V(super_mutex);
+          return rc;
+        }
+      reserved_inode = next_inode + OBJSTORE_INODE_BATCH;
+    }
+
+  *p_inode = next_inode++;
+
+  V(super_mutex);
+  return 0;
+}
+
+int objstore_meta_init(objstorefs_specific_initinfo_t * p_info)
+{
+  objstore_inode_t *p_root;
+  char *super, *cur;
+  size_t len;
+  int rc;
+
+  rw_lock_init(&objstore_ns_lock);
+
+  meta_chunk_size = p_info->chunk_size;
+
+  rc = objstore_get_object("super", &super, &len);
+
+  if(rc == 0)
+    {
+      unsigned long long next = 0, chunk_size = 0;
+
+      if(len < strlen(OBJSTORE_MAGIC) || strncmp(super, OBJSTORE_MAGIC,
+                                                  strlen(OBJSTORE_MAGIC)))
+        {
+          LogCrit(COMPONENT_FSAL, "OBJSTORE: invalid superblock in bucket %s",
+                  p_info->bucket);
+          Mem_Free(super);
+          return EIO;
+        }
+
+      super[len - 1] = '\0';
+      if((cur = strstr(super, "next_inode ")) != NULL)
+        next = strtoull(cur + 11, NULL, 10);
+      if((cur = strstr(super, "chunk_size ")) != NULL)
+        chunk_size = strtoull(cur + 11, NULL, 10);
+      Mem_Free(super);
+
+      if(next <= OBJSTORE_ROOT_INODE || chunk_size == 0)
+        {
+          LogCrit(COMPONENT_FSAL, "OBJSTORE: invalid superblock in bucket %s",
+                  p_info->bucket);
+          return EIO;
+        }
+
+      /* the layout of existing files depends on the chunk size */
+      if(chunk_size != meta_chunk_size)
+        {
+          LogEvent(COMPONENT_FSAL,
+                   "OBJSTORE: bucket %s uses chunks of %llu bytes, ignoring Chunk_Size=%llu",
+                   p_info->bucket, chunk_size, (unsigned long long)meta_chunk_size);
+          meta_chunk_size = chunk_size;
+        }
+
+      /* numbers reserved by a previous run may have been used */
+      next_inode = reserved_inode = next;
+      return 0;
+    }
+
+  if(rc != ENOENT)
+    return rc;
+
+  /* new filesystem */
+  LogEvent(COMPONENT_FSAL, "OBJSTORE: creating a filesystem in bucket %s",
+           p_info->bucket);
+
+  next_inode = reserved_inode = OBJSTORE_ROOT_INODE + 1;
+
+  if((rc = super_store(reserved_inode)) != 0)
+    return rc;
+
+  if((p_root = inode_alloc(OBJSTORE_ROOT_INODE)) == NULL)
+    return ENOMEM;
+
+  p_root->type = FSAL_TYPE_DIR;
+  p_root->mode = 0755;
+  p_root->nlink = 2;
+  p_root->parent = OBJSTORE_ROOT_INODE;
+  p_root->atime = p_root->mtime = p_root->ctime = time(NULL);
+
+  rc = objstore_inode_store(p_root);
+  inode_free(p_root);
+
+  return rc;
+}                               /* objstore_meta_init */
+
+fsal_size_t objstore_chunk_size(void)
+{
+  return meta_chunk_size;
+}
+
+static objstore_inode_t **table_find(fsal_u64_t inode)
+{
+  objstore_inode_t **pp_inode = &inode_table[inode % OBJSTORE_INODE_HASH];
+
+  while(*pp_inode != NULL && (*pp_inode)->inode != inode)
+    pp_inode = &(*pp_inode)->next;
+
+  return pp_inode;
+}
+
+int objstore_inode_get(fsal_u64_t inode, objstore_inode_t ** pp_inode)
+{
+  objstore_inode_t *p_inode, **pp_slot;
+  char key[64];
+  char *data;
+  size_t len;
+  int rc;
+
+  P(table_mutex);
+  if((p_inode = *table_find(inode)) != NULL)
+    {
+      if(p_inode->removed)
+        {
+          V(table_mutex);
+          return ENOENT;
+        }
+      p_inode->refcount++;
+      V(table_mutex);
+      *pp_inode = p_inode;
+      return 0;
+    }
+  V(table_mutex);
+
+  snprintf(key, sizeof(key), "i/%llu", (unsigned long long)inode);
+
+  if((rc = objstore_get_object(key, &data, &len)) != 0)
+    return rc;
+
+  if((p_inode = inode_alloc(inode)) == NULL)
+    {
+      Mem_Free(data);
+      return ENOMEM;
+    }
+
+  rc = inode_parse(p_inode, data, len);
+  Mem_Free(data);
+
+  if(rc != 0)
+    {
+      LogMajor(COMPONENT_FSAL, "OBJSTORE: invalid index object %s", key);
+      inode_free(p_inode);
+      return rc;
+    }
+
+  /* another thread may have loaded it meanwhile */
+  P(table_mutex);
+  pp_slot = table_find(inode);
+  if(*pp_slot != NULL)
+    {
+      inode_free(p_inode);
+      p_inode = *pp_slot;
+      if(p_inode->removed)
+        {
+          V(table_mutex);
+          return ENOENT;
+        }
+    }
+  else
+    *pp_slot = p_inode;
+  p_inode->refcount++;
+  V(table_mutex);
+
+  *pp_inode = p_inode;
+  return 0;
+}                               /* objstore_inode_get */
+
+void objstore_inode_ref(objstore_inode_t * p_inode)
+{
+  P(table_mutex);
+  p_inode->refcount++;
+  V(table_mutex);
+}
+
+void objstore_inode_put(objstore_inode_t * p_inode)
+{
+  objstore_inode_t **pp_slot;
+
+  P(table_mutex);
+
+  if(--p_inode->refcount > 0 || (p_inode->meta_dirty && !p_inode->removed))
+    {
+      V(table_mutex);
+      return;
+    }
+
+  pp_slot = table_find(p_inode->inode);
+  if(*pp_slot == p_inode)
+    *pp_slot = p_inode->next;
+
+  V(table_mutex);
+
+  inode_free(p_inode);
+}
+
+int objstore_inode_new(fsal_nodetype_t type, mode_t mode, uid_t uid, gid_t gid,
+                       fsal_u64_t parent, const char *link,
+                       objstore_inode_t ** pp_inode)
+{
+  objstore_inode_t *p_inode, **pp_slot;
+  fsal_u64_t inode;
+  int rc;
+
+  if((rc = inode_number_alloc(&inode)) != 0)
+    return rc;
+
+  if((p_inode = inode_alloc(inode)) == NULL)
+    return ENOMEM;
+
+  p_inode->type = type;
+  p_inode->mode = mode & 07777;
+  p_inode->uid = uid;
+  p_inode->gid = gid;
+  p_inode->nlink = (type == FSAL_TYPE_DIR ? 2 : 1);
+  p_inode->parent = parent;
+  p_inode->atime = p_inode->mtime = p_inode->ctime = time(NULL);
+
+  if(link != NULL)
+    {
+      if((p_inode->link = Mem_Alloc(strlen(link) + 1)) == NULL)
+        {
+          inode_free(p_inode);
+          return ENOMEM;
+        }
+      strcpy(p_inode->link, link);
+      p_inode->size = strlen(link);
+    }
+
+  if((rc = objstore_inode_store(p_inode)) != 0)
+    {
+      inode_free(p_inode);
+      return rc;
+    }
+
+  p_inode->refcount = 1;
+
+  P(table_mutex);
+  pp_slot = table_find(inode);
+  *pp_slot = p_inode;
+  V(table_mutex);
+
+  *pp_inode = p_inode;
+  return 0;
+}                               /* objstore_inode_new */
+
+int objstore_inode_store(objstore_inode_t * p_inode)
+{
+  objstore_buff_t buff;
+  char key[64];
+  int rc;
+
+  memset(&buff, 0, sizeof(buff));
+  snprintf(key, sizeof(key), "i/%llu", (unsigned long long)p_inode->inode);
+
+  /* the last snapshot of the attributes is the last one stored */
+  P(p_inode->store_lock);
+
+  P(p_inode->lock);
+  if(p_inode->removed)
+    {
+      V(p_inode->lock);
+      V(p_inode->store_lock);
+      return 0;
+    }
+  rc = inode_serialize(p_inode, &buff);
+  p_inode->meta_dirty = FALSE;
+  V(p_inode->lock);
+
+  if(rc == 0)
+    rc = objstore_put(key, buff.data, buff.len);
+
+  if(rc != 0)
+    {
+      P(p_inode->lock);
+      p_inode->meta_dirty = TRUE;
+      V(p_inode->lock);
+    }
+
+  V(p_inode->store_lock);
+
+  if(buff.data != NULL)
+    Mem_Free(buff.data);
+
+  return rc;
+}                               /* objstore_inode_store */
+
+int objstore_inode_destroy(objstore_inode_t * p_inode)
+{
+  char key[64];
+  int rc;
+
+  snprintf(key, sizeof(key), "i/%llu", (unsigned long long)p_inode->inode);
+
+  P(p_inode->store_lock);
+
+  P(p_inode->lock);
+  p_inode->removed = TRUE;
+  p_inode->meta_dirty = FALSE;
+  V(p_inode->lock);
+
+  rc = objstore_delete(key);
+
+  V(p_inode->store_lock);
+
+  return rc;
+}
+
+int objstore_dir_find(objstore_inode_t * p_dir, const char *name,
+                      fsal_u64_t * p_inode)
+{
+  unsigned int i;
+
+  if(!strcmp(name, "."))
+    {
+      *p_inode = p_dir->inode;
+      return 0;
+    }
+
+  if(!strcmp(name, ".."))
+    {
+      *p_inode = p_dir->parent;
+      return 0;
+    }
+
+  for(i = 0; i < p_dir->nb_entries; i++)
+    {
+      if(!strcmp(p_dir->entries[i].name, name))
+        {
+          *p_inode = p_dir->entries[i].inode;
+          return 0;
+        }
+    }
+
+  return ENOENT;
+}
+
+int objstore_dir_add(objstore_inode_t * p_dir, const char *name, fsal_u64_t inode)
+{
+  fsal_u64_t existing;
+
+  if(strlen(name) >= FSAL_MAX_NAME_LEN)
+    return ENAMETOOLONG;
+
+  if(objstore_dir_find(p_dir, name, &existing) == 0)
+    return EEXIST;
+
+  P(p_dir->lock);
+
+  if(p_dir->nb_entries == p_dir->max_entries)
+    {
+      unsigned int max = (p_dir->max_entries ? 2 * p_dir->max_entries : 16);
+      objstore_dirent_t *entries =
+          (objstore_dirent_t *) Mem_Realloc(p_dir->entries, max * sizeof(objstore_dirent_t));
+
+      if(entries == NULL)
+        {
+          V(p_dir->lock);
+          return ENOMEM;
+        }
+      p_dir->entries = entries;
+      p_dir->max_entries = max;
+    }
+
+  p_dir->entries[p_dir->nb_entries].inode = inode;
+  strcpy(p_dir->entries[p_dir->nb_entries].name, name);
+  p_dir->nb_entries++;
+
+  p_dir->mtime = p_dir->ctime = time(NULL);
+
+  V(p_dir->lock);
+  return 0;
+}
+
+int objstore_dir_remove(objstore_inode_t * p_dir, const char *name)
+{
+  unsigned int i;
+
+  for(i = 0; i < p_dir->nb_entries; i++)
+    {
+      if(!strcmp(p_dir->entries[i].name, name))
+        break;
+    }
+
+  if(i == p_dir->nb_entries)
+    return ENOENT;
+
+  P(p_dir->lock);
+
+  memmove(&p_dir->entries[i], &p_dir->entries[i + 1],
+          (p_dir->nb_entries - i - 1) * sizeof(objstore_dirent_t));
+  p_dir->nb_entries--;
+
+  p_dir->mtime = p_dir->ctime = time(NULL);
+
+  V(p_dir->lock);
+  return 0;
+}
+
+int objstore_meta_flush(void)
+{
+  objstore_inode_t **dirty = NULL;
+  objstore_inode_t *p_inode;
+  unsigned int nb_dirty = 0, max_dirty = 0;
+  unsigned int i;
+  int rc = 0, rc2;
+
+  /* reference the modified objects */
+  P(table_mutex);
+
+  for(i = 0; i < OBJSTORE_INODE_HASH; i++)
+    {
+      for(p_inode = inode_table[i]; p_inode != NULL; p_inode = p_inode->next)
+        {
+          if(!p_inode->meta_dirty || p_inode->removed)
+            continue;
+
+          if(nb_dirty == max_dirty)
+            {
+              objstore_inode_t **dirty2;
+
+              max_dirty = (max_dirty ? 2 * max_dirty : 64);
+              if((dirty2 = (objstore_inode_t **) Mem_Realloc(dirty, max_dirty * sizeof(*dirty))) == NULL)
+                {
+                  rc = ENOMEM;
+                  break;
+                }
+              dirty = dirty2;
+            }
+
+          p_inode->refcount++;
+          dirty[nb_dirty++] = p_inode;
+        }
+    }
+
+  V(table_mutex);
+
+  for(i = 0; i < nb_dirty; i++)
+    {
+      if((rc2 = objstore_inode_store(dirty[i])) != 0)
+        rc = rc2;
+      objstore_inode_put(dirty[i]);
+    }
+
+  if(dirty != NULL)
+    Mem_Free(dirty);
+
+  return rc;
+}                               /* objstore_meta_flush */
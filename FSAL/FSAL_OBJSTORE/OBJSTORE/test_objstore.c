@@ -0,0 +1,667 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ *
+ * Test of the object store backend (chunked files, index objects and local
+ * write-back cache), against a local stand-in of an S3 object store
+ * (PUT, ranged GET and DELETE, with path style requests). The stand-in
+ * closes some of the connections, so that the reconnections are exercised,
+ * and the cache is smaller than the file, so that chunks are evicted.
+ * FSAL_rcp is checked both ways on the same file.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "BuddyMalloc.h"
+#include "log_macros.h"
+#include "fsal.h"
+#include "../fsal_internal.h"
+#include "FSAL/FSAL_OBJSTORE/objstore.h"
+
+#define BUCKET "testbucket"
+#define PREFIX "fs1/"
+#define CHUNK_SIZE 4096
+#define FILE_SIZE 50000
+#define MAX_OBJECTS 256
+#define CLOSE_EVERY 5           /* one response out of CLOSE_EVERY closes the connection */
+
+/* The objects of the stand-in */
+typedef struct object__
+{
+  char key[MAXPATHLEN];
+  char *data;
+  size_t length;
+  int exists;
+} object_t;
+
+static object_t objects[MAX_OBJECTS];
+static pthread_mutex_t server_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int nb_requests = 0;
+static int listen_fd;
+
+static object_t *find_object(const char *key, int create)
+{
+  int i;
+
+  for(i = 0; i < MAX_OBJECTS; i++)
+    if(objects[i].exists && !strcmp(objects[i].key, key))
+      return &objects[i];
+
+  if(!create)
+    return NULL;
+
+  for(i = 0; i < MAX_OBJECTS; i++)
+    if(!objects[i].exists)
+      {
+        strcpy(objects[i].key, key);
+        objects[i].data = NULL;
+        objects[i].length = 0;
+        objects[i].exists = TRUE;
+        return &objects[i];
+      }
+
+  return NULL;
+}                               /* find_object */
+
+static int read_full(int fd, char *buf, size_t len)
+{
+  ssize_t rc;
+
+  while(len > 0)
+    {
+      if((rc = recv(fd, buf, len, 0)) <= 0)
+        return -1;
+      buf += rc;
+      len -= rc;
+    }
+  return 0;
+}                               /* read_full */
+
+/* Reads the request line and headers, byte by byte (no pipelining from the client) */
+static int read_head(int fd, char *head, size_t size)
+{
+  size_t len = 0;
+
+  while(len < size - 1)
+    {
+      if(recv(fd, head + len, 1, 0) != 1)
+        return -1;
+      len++;
+      if(len >= 4 && !memcmp(head + len - 4, "\r\n\r\n", 4))
+        {
+          head[len] = '\0';
+          return 0;
+        }
+    }
+  return -1;
+}                               /* read_head */
+
+static void reply(int fd, int status, const char *extra, const char *body, size_t length,
+                  int close_it)
+{
+  char head[1024];
+  int len;
+
+  len = snprintf(head, sizeof(head),
+                 "HTTP/1.1 %d X\r\nContent-Length: %llu\r\n%s%s\r\n",
+                 status, (unsigned long long)length, extra,
+                 close_it ? "Connection: close\r\n" : "");
+  send(fd, head, len, MSG_NOSIGNAL);
+  if(length > 0)
+    send(fd, body, length, MSG_NOSIGNAL);
+}                               /* reply */
+
+/* A connection to the stand-in */
+static void *server_connection(void *arg)
+{
+  int fd = (int)(long)arg;
+  char head[8192];
+  char method[16];
+  char target[MAXPATHLEN];
+  char key[MAXPATHLEN];
+  char range[128];
+  char *clen;
+  char *body;
+  char *p;
+  char *q;
+  size_t length;
+  unsigned long long first, last;
+  object_t *pobj;
+  int close_it;
+
+  while(read_head(fd, head, sizeof(head)) == 0)
+    {
+      if(sscanf(head, "%15s %1023s", method, target) != 2)
+        break;
+
+      length = 0;
+      if((clen = strstr(head, "Content-Length: ")) != NULL)
+        length = strtoul(clen + strlen("Content-Length: "), NULL, 10);
+
+      body = malloc(length + 1);
+      if(read_full(fd, body, length) != 0)
+        {
+          free(body);
+          break;
+        }
+      body[length] = '\0';
+
+      /* Decode /bucket/prefix/key */
+      if(strncmp(target, "/" BUCKET "/" PREFIX, strlen(BUCKET) + strlen(PREFIX) + 2))
+        {
+          reply(fd, 404, "", NULL, 0, FALSE);
+          free(body);
+          continue;
+        }
+
+      for(p = target + strlen(BUCKET) + strlen(PREFIX) + 2, q = key; *p != '\0'; q++)
+        {
+          if(*p == '%')
+            {
+              unsigned int c;
+              sscanf(p + 1, "%2x", &c);
+              *q = (char)c;
+              p += 3;
+            }
+          else
+            *q = *p++;
+        }
+      *q = '\0';
+
+      pthread_mutex_lock(&server_mutex);
+
+      close_it = (++nb_requests % CLOSE_EVERY == 0);
+
+      if(!strcmp(method, "PUT"))
+        {
+          pobj = find_object(key, TRUE);
+          free(pobj->data);
+          pobj->data = body;
+          pobj->length = length;
+          body = NULL;
+          reply(fd, 200, "ETag: \"x\"\r\n", NULL, 0, close_it);
+        }
+      else if(!strcmp(method, "GET"))
+        {
+          if((pobj = find_object(key, FALSE)) == NULL)
+            reply(fd, 404, "", NULL, 0, close_it);
+          else if((p = strstr(head, "Range: bytes=")) != NULL
+                  && sscanf(p + strlen("Range: bytes="), "%llu-%llu", &first, &last) == 2)
+            {
+              if(first >= pobj->length)
+                reply(fd, 416, "", NULL, 0, close_it);
+              else
+                {
+                  if(last >= pobj->length)
+                    last = pobj->length - 1;
+                  snprintf(range, sizeof(range), "Content-Range: bytes %llu-%llu/%llu\r\n",
+                           first, last, (unsigned long long)pobj->length);
+                  reply(fd, 206, range, pobj->data + first, last - first + 1, close_it);
+                }
+            }
+          else
+            reply(fd, 200, "", pobj->data, pobj->length, close_it);
+        }
+      else if(!strcmp(method, "DELETE"))
+        {
+          if((pobj = find_object(key, FALSE)) == NULL)
+            reply(fd, 404, "", NULL, 0, close_it);
+          else
+            {
+              free(pobj->data);
+              pobj->exists = FALSE;
+              reply(fd, 204, "", NULL, 0, close_it);
+            }
+        }
+      else
+        reply(fd, 400, "", NULL, 0, close_it);
+
+      pthread_mutex_unlock(&server_mutex);
+
+      free(body);
+      if(close_it)
+        break;
+    }
+
+  close(fd);
+  return NULL;
+}                               /* server_connection */
+
+static void *server_thread(void *arg)
+{
+  pthread_t thrid;
+  int fd;
+
+  while((fd = accept(listen_fd, NULL, NULL)) >= 0)
+    {
+      pthread_create(&thrid, NULL, server_connection, (void *)(long)fd);
+      pthread_detach(thrid);
+    }
+  return NULL;
+}                               /* server_thread */
+
+static void check_rc(int rc, const char *what)
+{
+  if(rc != 0)
+    {
+      LogTest("Test FAILED: %s returned %d (%s)", what, rc, strerror(rc));
+      exit(1);
+    }
+}                               /* check_rc */
+
+static void file_write(objstore_inode_t * p_file, char *ref, fsal_off_t offset,
+                       size_t length, char seed)
+{
+  char *buffer = malloc(length);
+  size_t written;
+  size_t i;
+
+  for(i = 0; i < length; i++)
+    buffer[i] = (char)(seed + i * 13);
+
+  check_rc(objstore_cache_write(p_file, offset, length, buffer, &written),
+           "objstore_cache_write");
+
+  if(written != length)
+    {
+      LogTest("Test FAILED: %llu bytes written instead of %llu",
+              (unsigned long long)written, (unsigned long long)length);
+      exit(1);
+    }
+
+  memcpy(ref + offset, buffer, length);
+  free(buffer);
+}                               /* file_write */
+
+/* Reads the whole file in pieces that do not match the chunks */
+static void check_file(objstore_inode_t * p_file, const char *ref, size_t size,
+                       const char *step)
+{
+  char buffer[3000];
+  fsal_off_t offset = 0;
+  size_t nb_read;
+  int eof = FALSE;
+
+  while(!eof)
+    {
+      check_rc(objstore_cache_read(p_file, offset, sizeof(buffer), buffer, &nb_read, &eof),
+               "objstore_cache_read");
+
+      if(offset + nb_read > size || memcmp(buffer, ref + offset, nb_read))
+        {
+          LogTest("Test FAILED (%s): wrong data read at offset %llu", step,
+                  (unsigned long long)offset);
+          exit(1);
+        }
+
+      offset += nb_read;
+
+      if(nb_read == 0 && !eof)
+        {
+          LogTest("Test FAILED (%s): no data and no end of file at offset %llu", step,
+                  (unsigned long long)offset);
+          exit(1);
+        }
+    }
+
+  if(offset != size)
+    {
+      LogTest("Test FAILED (%s): end of file at %llu instead of %llu", step,
+              (unsigned long long)offset, (unsigned long long)size);
+      exit(1);
+    }
+
+  LogTest("%s: the file reads as expected", step);
+}                               /* check_file */
+
+/* Checks the chunks and the index object of the file in the stand-in */
+static void check_store(objstore_inode_t * p_file, const char *ref, size_t size,
+                        const char *step)
+{
+  char key[MAXPATHLEN];
+  char expected_size[64];
+  object_t *pobj;
+  size_t start, len, i;
+  int nb_chunks = 0;
+
+  pthread_mutex_lock(&server_mutex);
+
+  for(start = 0; start < size; start += CHUNK_SIZE)
+    {
+      len = (size - start < CHUNK_SIZE ? size - start : CHUNK_SIZE);
+
+      snprintf(key, sizeof(key), "c/%llu/%llu", (unsigned long long)p_file->inode,
+               (unsigned long long)(start / CHUNK_SIZE));
+
+      /* a missing chunk, or the end of a short one, reads as zeros */
+      if((pobj = find_object(key, FALSE)) != NULL)
+        {
+          nb_chunks++;
+          if(pobj->length > len || memcmp(pobj->data, ref + start, pobj->length))
+            {
+              LogTest("Test FAILED (%s): chunk %s has a wrong content", step, key);
+              exit(1);
+            }
+          i = pobj->length;
+        }
+      else
+        i = 0;
+
+      for(; i < len; i++)
+        if(ref[start + i] != 0)
+          {
+            LogTest("Test FAILED (%s): chunk %s is missing data", step, key);
+            exit(1);
+          }
+    }
+
+  /* no chunk after the end of file */
+  for(i = 0; i < MAX_OBJECTS; i++)
+    {
+      unsigned long long inode, index;
+
+      if(objects[i].exists
+         && sscanf(objects[i].key, "c/%llu/%llu", &inode, &index) == 2
+         && inode == p_file->inode && index * CHUNK_SIZE >= size)
+        {
+          LogTest("Test FAILED (%s): chunk %s should not exist", step, objects[i].key);
+          exit(1);
+        }
+    }
+
+  snprintf(key, sizeof(key), "i/%llu", (unsigned long long)p_file->inode);
+  snprintf(expected_size, sizeof(expected_size), "\nsize %llu\n",
+           (unsigned long long)size);
+
+  if((pobj = find_object(key, FALSE)) == NULL || pobj->data == NULL
+     || strstr(pobj->data, expected_size) == NULL)
+    {
+      LogTest("Test FAILED (%s): index object %s is missing or has a wrong size", step,
+              key);
+      exit(1);
+    }
+
+  pthread_mutex_unlock(&server_mutex);
+
+  LogTest("%s: %d chunks in the bucket, as expected", step, nb_chunks);
+}                               /* check_store */
+
+/* Copies the file from or to a local file with FSAL_rcp, as root */
+static fsal_status_t file_rcp(objstore_inode_t * p_file, const char *local_path,
+                              fsal_rcpflag_t transfer_opt)
+{
+  objstorefsal_export_context_t export_context;
+  objstorefsal_op_context_t context;
+  objstorefsal_handle_t handle;
+  fsal_path_t path;
+
+  memset(&export_context, 0, sizeof(export_context));
+  export_context.root_handle.data.inode = OBJSTORE_ROOT_INODE;
+  memset(&context, 0, sizeof(context));
+  context.export_context = &export_context;
+  memset(&handle, 0, sizeof(handle));
+  handle.data.inode = p_file->inode;
+  handle.data.type = FSAL_TYPE_FILE;
+  strncpy(path.path, local_path, FSAL_MAX_PATH_LEN - 1);
+  path.path[FSAL_MAX_PATH_LEN - 1] = '\0';
+  path.len = strlen(path.path);
+
+  return OBJSTOREFSAL_rcp(&handle, &context, &path, transfer_opt);
+}                               /* file_rcp */
+
+/* Copies the file to a local file with FSAL_rcp, and checks the copy */
+static void check_rcp(objstore_inode_t * p_file, const char *ref, size_t size,
+                      const char *local_path, const char *step)
+{
+  fsal_status_t st;
+  struct stat stbuf;
+  char *buffer;
+  int fd;
+
+  unlink(local_path);
+  st = file_rcp(p_file, local_path, FSAL_RCP_FS_TO_LOCAL | FSAL_RCP_LOCAL_CREAT);
+  if(FSAL_IS_ERROR(st))
+    {
+      LogTest("Test FAILED (%s): FSAL_rcp returned %d.%d", step, st.major, st.minor);
+      exit(1);
+    }
+
+  buffer = malloc(size + 1);
+
+  /* the last block of the file comes with the end of file */
+  if((fd = open(local_path, O_RDONLY)) < 0 || fstat(fd, &stbuf) != 0
+     || stbuf.st_size != (off_t) size || read(fd, buffer, size + 1) != (ssize_t) size
+     || memcmp(buffer, ref, size))
+    {
+      LogTest("Test FAILED (%s): the local copy differs from the file", step);
+      exit(1);
+    }
+
+  close(fd);
+  free(buffer);
+
+  LogTest("%s: the local copy matches the file", step);
+}                               /* check_rcp */
+
+int main(int argc, char *argv[])
+{
+  objstorefs_specific_initinfo_t info;
+  fsal_init_info_t fsal_info;
+  fs_common_initinfo_t fs_common_info;
+  objstore_inode_t *p_root;
+  objstore_inode_t *p_file;
+  struct sockaddr_in addr;
+  socklen_t addrlen = sizeof(addr);
+  pthread_t thrid;
+  fsal_u64_t inode;
+  char cmd[MAXPATHLEN + 16];
+  char key[MAXPATHLEN];
+  char local_path[MAXPATHLEN + 8];
+  char *ref;
+  int i;
+
+  SetDefaultLogging("TEST");
+  SetNamePgm("test_objstore");
+
+  BuddyInit(NULL);
+
+  /* The stand-in */
+  listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  if(bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+     || listen(listen_fd, 16) != 0
+     || getsockname(listen_fd, (struct sockaddr *)&addr, &addrlen) != 0)
+    {
+      LogTest("Test FAILED: can't start the stand-in, errno=%d", errno);
+      exit(1);
+    }
+  pthread_create(&thrid, NULL, server_thread, NULL);
+
+  /* The backend, with a cache of 4 chunks */
+  memset(&info, 0, sizeof(info));
+  strcpy(info.host, "127.0.0.1");
+  info.port = ntohs(addr.sin_port);
+  strcpy(info.bucket, BUCKET);
+  strcpy(info.key_prefix, PREFIX);
+  strcpy(info.access_key_id, "AKIDTEST");
+  strcpy(info.secret_access_key, "secret");
+  info.timeout = 10;
+  info.chunk_size = CHUNK_SIZE;
+  snprintf(info.cache_dir, MAXPATHLEN, "/tmp/test_objstore.%d", (int)getpid());
+  info.cache_size = 4 * CHUNK_SIZE;
+  info.io_threads = 2;
+  info.flush_delay = 0;
+  info.flush_on_close = TRUE;
+
+  /* The FSAL defaults, for FSAL_rcp */
+  memset(&fsal_info, 0, sizeof(fsal_info));
+  memset(&fs_common_info, 0, sizeof(fs_common_info));
+  if(FSAL_IS_ERROR(fsal_internal_init_global(&fsal_info, &fs_common_info, &info)))
+    {
+      LogTest("Test FAILED: can't initialize the FSAL");
+      exit(1);
+    }
+
+  check_rc(objstore_client_init(&info), "objstore_client_init");
+  check_rc(objstore_meta_init(&info), "objstore_meta_init");
+  check_rc(objstore_cache_init(&info), "objstore_cache_init");
+
+  if(find_object("super", FALSE) == NULL || find_object("i/1", FALSE) == NULL)
+    {
+      LogTest("Test FAILED: the filesystem was not created in the bucket");
+      exit(1);
+    }
+
+  /* A file in the root directory */
+  check_rc(objstore_inode_get(OBJSTORE_ROOT_INODE, &p_root), "objstore_inode_get");
+  check_rc(objstore_inode_new(FSAL_TYPE_FILE, 0644, 0, 0, OBJSTORE_ROOT_INODE, NULL,
+                              &p_file), "objstore_inode_new");
+
+  P_w(&objstore_ns_lock);
+  check_rc(objstore_dir_add(p_root, "file", p_file->inode), "objstore_dir_add");
+  V_w(&objstore_ns_lock);
+  check_rc(objstore_inode_store(p_root), "objstore_inode_store");
+
+  P_r(&objstore_ns_lock);
+  check_rc(objstore_dir_find(p_root, "file", &inode), "objstore_dir_find");
+  V_r(&objstore_ns_lock);
+
+  if(inode != p_file->inode)
+    {
+      LogTest("Test FAILED: the entry refers to inode %llu instead of %llu",
+              (unsigned long long)inode, (unsigned long long)p_file->inode);
+      exit(1);
+    }
+
+  /* Writes larger than the cache, with a hole and unaligned pieces */
+  ref = calloc(FILE_SIZE, 1);
+
+  file_write(p_file, ref, 0, 10000, 'a');
+  file_write(p_file, ref, 30000, FILE_SIZE - 30000, 'b');
+  file_write(p_file, ref, CHUNK_SIZE - 6, 20, 'c');
+
+  check_file(p_file, ref, FILE_SIZE, "Write");
+
+  check_rc(objstore_cache_sync(p_file, TRUE), "objstore_cache_sync");
+  check_store(p_file, ref, FILE_SIZE, "Write");
+
+  /* The whole file fits in one block of FSAL_rcp */
+  snprintf(local_path, sizeof(local_path), "%s.rcp", info.cache_dir);
+  check_rcp(p_file, ref, FILE_SIZE, local_path, "Rcp to local");
+
+  /* Back to the object store, after clearing the file */
+  check_rc(objstore_cache_truncate(p_file, 0), "objstore_cache_truncate");
+
+  if(FSAL_IS_ERROR(file_rcp(p_file, local_path, FSAL_RCP_LOCAL_TO_FS)))
+    {
+      LogTest("Test FAILED: FSAL_rcp to the object store failed");
+      exit(1);
+    }
+  unlink(local_path);
+
+  check_file(p_file, ref, FILE_SIZE, "Rcp to the object store");
+  check_store(p_file, ref, FILE_SIZE, "Rcp to the object store");
+
+  /* Truncate in the middle of a chunk, then grow again */
+  check_rc(objstore_cache_truncate(p_file, 20000), "objstore_cache_truncate");
+  memset(ref + 20000, 0, FILE_SIZE - 20000);
+  file_write(p_file, ref, 45000, 4, 'd');
+
+  check_file(p_file, ref, 45004, "Truncate");
+
+  check_rc(objstore_cache_sync(p_file, TRUE), "objstore_cache_sync");
+  check_store(p_file, ref, 45004, "Truncate");
+
+  /* Shrink below a chunk boundary without growing again */
+  check_rc(objstore_cache_truncate(p_file, 5000), "objstore_cache_truncate");
+
+  check_file(p_file, ref, 5000, "Shrink");
+
+  check_rc(objstore_cache_sync(p_file, TRUE), "objstore_cache_sync");
+  check_store(p_file, ref, 5000, "Shrink");
+
+  /* Removal */
+  P_w(&objstore_ns_lock);
+  check_rc(objstore_dir_remove(p_root, "file"), "objstore_dir_remove");
+  V_w(&objstore_ns_lock);
+  check_rc(objstore_inode_store(p_root), "objstore_inode_store");
+
+  check_rc(objstore_inode_destroy(p_file), "objstore_inode_destroy");
+  check_rc(objstore_cache_remove(p_file), "objstore_cache_remove");
+
+  pthread_mutex_lock(&server_mutex);
+  for(i = 0; i < MAX_OBJECTS; i++)
+    {
+      snprintf(key, sizeof(key), "c/%llu/", (unsigned long long)p_file->inode);
+
+      if(objects[i].exists && !strncmp(objects[i].key, key, strlen(key)))
+        {
+          LogTest("Test FAILED: chunk %s was not removed", objects[i].key);
+          exit(1);
+        }
+    }
+  snprintf(key, sizeof(key), "i/%llu", (unsigned long long)p_file->inode);
+  if(find_object(key, FALSE) != NULL)
+    {
+      LogTest("Test FAILED: index object %s was not removed", key);
+      exit(1);
+    }
+  pthread_mutex_unlock(&server_mutex);
+
+  if(objstore_inode_get(p_file->inode, &p_root) != ENOENT)
+    {
+      LogTest("Test FAILED: the removed file can still be loaded");
+      exit(1);
+    }
+
+  objstore_inode_put(p_file);
+
+  check_rc(objstore_cache_terminate(), "objstore_cache_terminate");
+
+  LogTest("%u requests to the stand-in", nb_requests);
+
+  /* Clean up */
+  snprintf(cmd, sizeof(cmd), "rm -rf %s", info.cache_dir);
+  system(cmd);
+
+  LogTest("Test OK");
+
+  return 0;
+}
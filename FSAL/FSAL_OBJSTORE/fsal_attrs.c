@@ -0,0 +1,378 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ *
+ * \file    fsal_attrs.c
+ * \brief   Attributes functions.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+#include <sys/types.h>
+#include <string.h>
+#include <time.h>
+
+/**
+ * FSAL_getattrs:
+ * Get attributes for the object specified by its filehandle.
+ *
+ * \param filehandle (input):
+ *        The handle of the object to get parameters.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param object_attributes (mandatory input/output):
+ *        The retrieved attributes for the object.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_getattrs(objstorefsal_handle_t * p_filehandle, /* IN */
+                               objstorefsal_op_context_t * p_context,        /* IN */
+                               fsal_attrib_list_t * p_object_attributes /* IN/OUT */
+    )
+{
+  fsal_status_t st;
+  objstore_inode_t *p_inode;
+
+  /* sanity checks.
+   * note : object_attributes is mandatory in FSAL_getattrs.
+   */
+  if(!p_filehandle || !p_context || !p_object_attributes)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_getattrs);
+
+  TakeTokenFSCall();
+  st = fsal_internal_getinode(p_filehandle, &p_inode);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(st))
+    ReturnStatus(st, INDEX_FSAL_getattrs);
+
+  /* convert attributes */
+  st = objstore2fsal_attributes(p_inode, p_object_attributes);
+
+  objstore_inode_put(p_inode);
+
+  if(FSAL_IS_ERROR(st))
+    {
+      FSAL_CLEAR_MASK(p_object_attributes->asked_attributes);
+      FSAL_SET_MASK(p_object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+      ReturnStatus(st, INDEX_FSAL_getattrs);
+    }
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_getattrs);
+
+}
+
+/**
+ * FSAL_setattrs:
+ * Set attributes for the object specified by its filehandle.
+ *
+ * \param filehandle (input):
+ *        The handle of the object to get parameters.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param attrib_set (mandatory input):
+ *        The attributes to be set for the object.
+ *        It defines the attributes that the caller
+ *        wants to set and their values.
+ * \param object_attributes (optionnal input/output):
+ *        The post operation attributes for the object.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_setattrs(objstorefsal_handle_t * p_filehandle, /* IN */
+                               objstorefsal_op_context_t * p_context,        /* IN */
+                               fsal_attrib_list_t * p_attrib_set,       /* IN */
+                               fsal_attrib_list_t * p_object_attributes /* [ IN/OUT ] */
+    )
+{
+
+  int rc;
+  unsigned int i;
+  fsal_status_t status;
+  fsal_attrib_list_t attrs;
+  fsal_attrib_list_t current;
+  objstore_inode_t *p_inode;
+
+  /* sanity checks.
+   * note : object_attributes is optional.
+   */
+  if(!p_filehandle || !p_context || !p_attrib_set)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_setattrs);
+
+  /* local copy of attributes */
+  attrs = *p_attrib_set;
+
+  /* First, check that FSAL attributes changes are allowed. */
+
+  /* Is it allowed to change times ? */
+
+  if(!global_fs_info.cansettime)
+    {
+
+      if(attrs.asked_attributes
+         & (FSAL_ATTR_ATIME | FSAL_ATTR_CREATION | FSAL_ATTR_CTIME | FSAL_ATTR_MTIME))
+        {
+          /* handled as an unsettable attribute. */
+          Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_setattrs);
+        }
+    }
+
+  /* apply umask, if mode attribute is to be changed */
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_MODE))
+    {
+      attrs.mode &= (~global_fs_info.umask);
+    }
+
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_filehandle, &p_inode);
+  ReleaseTokenFSCall();
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_setattrs);
+
+  /* get current attributes */
+  current.asked_attributes = FSAL_ATTR_OWNER | FSAL_ATTR_GROUP | FSAL_ATTR_MODE;
+  status = objstore2fsal_attributes(p_inode, &current);
+  if(FSAL_IS_ERROR(status))
+    {
+      objstore_inode_put(p_inode);
+      ReturnStatus(status, INDEX_FSAL_setattrs);
+    }
+
+  /***********
+   *  CHMOD  *
+   ***********/
+
+  /* The mode of a symlink is not used, so we ignore it. */
+  if(p_inode->type == FSAL_TYPE_LNK)
+    attrs.asked_attributes &= ~FSAL_ATTR_MODE;
+
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_MODE))
+    {
+      /* For modifying mode, user must be root or the owner */
+      if((p_context->credential.user != 0)
+         && (p_context->credential.user != current.owner))
+        {
+
+          LogFullDebug(COMPONENT_FSAL,
+                            "Permission denied for CHMOD opeartion: current owner=%d, credential=%d",
+                            current.owner, p_context->credential.user);
+
+          objstore_inode_put(p_inode);
+          Return(ERR_FSAL_PERM, 0, INDEX_FSAL_setattrs);
+        }
+    }
+
+  /***********
+   *  CHOWN  *
+   ***********/
+  /* Only root can change uid and A normal user must be in the group he wants to set */
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_OWNER))
+    {
+
+      /* For modifying owner, user must be root or current owner==wanted==client */
+      if((p_context->credential.user != 0) &&
+         ((p_context->credential.user != current.owner) ||
+          (p_context->credential.user != attrs.owner)))
+        {
+
+          LogFullDebug(COMPONENT_FSAL,
+                            "Permission denied for CHOWN opeartion: current owner=%d, credential=%d, new owner=%d",
+                            current.owner, p_context->credential.user, attrs.owner);
+
+          objstore_inode_put(p_inode);
+          Return(ERR_FSAL_PERM, 0, INDEX_FSAL_setattrs);
+        }
+    }
+
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_GROUP))
+    {
+      int in_grp = 0;
+
+      /* For modifying group, user must be root or current owner */
+      if((p_context->credential.user != 0)
+         && (p_context->credential.user != current.owner))
+        {
+          objstore_inode_put(p_inode);
+          Return(ERR_FSAL_PERM, 0, INDEX_FSAL_setattrs);
+        }
+
+      /* set in_grp */
+      if(p_context->credential.group == attrs.group)
+        in_grp = 1;
+      else
+        for(i = 0; i < p_context->credential.nbgroups; i++)
+          {
+            if((in_grp = (attrs.group == p_context->credential.alt_groups[i])))
+              break;
+          }
+
+      /* it must also be in target group */
+      if(p_context->credential.user != 0 && !in_grp)
+        {
+
+          LogFullDebug(COMPONENT_FSAL,
+                            "Permission denied for CHOWN operation: current group=%d, credential=%d, new group=%d",
+                            current.group, p_context->credential.group, attrs.group);
+
+          objstore_inode_put(p_inode);
+          Return(ERR_FSAL_PERM, 0, INDEX_FSAL_setattrs);
+        }
+    }
+
+  /***********
+   *  UTIME  *
+   ***********/
+
+  /* user must be the owner or have read access to modify 'atime' */
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_ATIME)
+     && (p_context->credential.user != 0)
+     && (p_context->credential.user != current.owner)
+     && ((status = fsal_internal_testAccess(p_context, FSAL_R_OK, NULL, &current)).major
+         != ERR_FSAL_NO_ERROR))
+    {
+      objstore_inode_put(p_inode);
+      ReturnStatus(status, INDEX_FSAL_setattrs);
+    }
+  /* user must be the owner or have write access to modify 'mtime' */
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_MTIME)
+     && (p_context->credential.user != 0)
+     && (p_context->credential.user != current.owner)
+     && ((status = fsal_internal_testAccess(p_context, FSAL_W_OK, NULL, &current)).major
+         != ERR_FSAL_NO_ERROR))
+    {
+      objstore_inode_put(p_inode);
+      ReturnStatus(status, INDEX_FSAL_setattrs);
+    }
+
+  /* everything is allowed: change the attributes, and store them */
+
+  P(p_inode->lock);
+
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_MODE))
+    p_inode->mode = fsal2unix_mode(attrs.mode);
+
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_OWNER))
+    p_inode->uid = attrs.owner;
+
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_GROUP))
+    p_inode->gid = attrs.group;
+
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_ATIME))
+    p_inode->atime = fsal2posix_time(attrs.atime);
+
+  if(FSAL_TEST_MASK(attrs.asked_attributes, FSAL_ATTR_MTIME))
+    p_inode->mtime = fsal2posix_time(attrs.mtime);
+
+  p_inode->ctime = time(NULL);
+  p_inode->meta_dirty = TRUE;
+
+  V(p_inode->lock);
+
+  TakeTokenFSCall();
+  rc = objstore_inode_store(p_inode);
+  ReleaseTokenFSCall();
+
+  if(rc)
+    {
+      objstore_inode_put(p_inode);
+      Return(posix2fsal_error(rc), rc, INDEX_FSAL_setattrs);
+    }
+
+  /* Optionaly fills output attributes. */
+
+  if(p_object_attributes)
+    {
+      status = objstore2fsal_attributes(p_inode, p_object_attributes);
+
+      /* on error, we set a special bit in the mask. */
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_object_attributes->asked_attributes);
+          FSAL_SET_MASK(p_object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+
+    }
+
+  objstore_inode_put(p_inode);
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_setattrs);
+
+}
+
+/**
+ * FSAL_getetxattrs:
+ * Get attributes for the object specified by its filehandle.
+ *
+ * \param filehandle (input):
+ *        The handle of the object to get parameters.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param object_attributes (mandatory input/output):
+ *        The retrieved attributes for the object.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_getextattrs(objstorefsal_handle_t * p_filehandle, /* IN */
+                                  objstorefsal_op_context_t * p_context,        /* IN */
+                                  fsal_extattrib_list_t * p_object_attributes /* OUT */
+    )
+{
+  /* sanity checks.
+   * note : object_attributes is mandatory in FSAL_getattrs.
+   */
+  if(!p_filehandle || !p_context || !p_object_attributes)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_getattrs);
+
+  /* inode numbers are never reused in a bucket */
+  if( p_object_attributes->asked_attributes & FSAL_ATTR_GENERATION )
+    p_object_attributes->generation = 0 ;
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_getextattrs);
+} /* OBJSTOREFSAL_getextattrs */
@@ -0,0 +1,181 @@
+/**
+ *
+ * \file    fsal_creds.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/24 13:45:36 $
+ * \version $Revision: 1.15 $
+ * \brief   FSAL credentials handling functions.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+#include <pwd.h>
+#include <errno.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+#include <time.h>
+#include <stdio.h>
+#include <pthread.h>
+
+/**
+ * @defgroup FSALCredFunctions Credential handling functions.
+ *
+ * Those functions handle security contexts (credentials).
+ *
+ * @{
+ */
+
+/**
+ * build the export entry
+ */
+fsal_status_t OBJSTOREFSAL_BuildExportContext(objstorefsal_export_context_t * p_export_context,   /* OUT */
+                                         fsal_path_t * p_export_path,   /* IN */
+                                         char *fs_specific_options      /* IN */
+    )
+{
+  fsal_status_t status;
+
+  /* sanity check */
+  if(p_export_context == NULL)
+    {
+      LogCrit(COMPONENT_FSAL, "NULL mandatory argument passed to %s()", __FUNCTION__);
+      Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_BuildExportContext);
+    }
+
+  /* the export path is a path in the bucket namespace */
+  if(p_export_path == NULL)
+    {
+      memset(&p_export_context->root_handle, 0, sizeof(objstorefsal_handle_t));
+      p_export_context->root_handle.data.inode = OBJSTORE_ROOT_INODE;
+      p_export_context->root_handle.data.type = FSAL_TYPE_DIR;
+      Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_BuildExportContext);
+    }
+
+  status = fsal_internal_path2handle(p_export_path, &p_export_context->root_handle);
+
+  if(FSAL_IS_ERROR(status))
+    {
+      LogCrit(COMPONENT_FSAL, "Cannot resolve export path '%s' in the bucket: error %d",
+              p_export_path->path, status.major);
+      Return(status.major, status.minor, INDEX_FSAL_BuildExportContext);
+    }
+
+  if(p_export_context->root_handle.data.type != FSAL_TYPE_DIR)
+    {
+      LogCrit(COMPONENT_FSAL, "Export path '%s' is not a directory",
+              p_export_path->path);
+      Return(ERR_FSAL_NOTDIR, 0, INDEX_FSAL_BuildExportContext);
+    }
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_BuildExportContext);
+}
+
+/**
+ * FSAL_CleanUpExportContext :
+ * this will clean up and state in an export that was created during
+ * the BuildExportContext phase.  For many FSALs this may be a noop.
+ *
+ * \param p_export_context (in, objstorefsal_export_context_t)
+ */
+
+fsal_status_t OBJSTOREFSAL_CleanUpExportContext(objstorefsal_export_context_t * p_export_context)
+{
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_CleanUpExportContext);
+}
+
+fsal_status_t OBJSTOREFSAL_InitClientContext(objstorefsal_op_context_t * p_thr_context)
+{
+
+  /* sanity check */
+  if(!p_thr_context)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_InitClientContext);
+
+  /* initialy set the export entry to none */
+  p_thr_context->export_context = NULL;
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_InitClientContext);
+
+}
+
+ /**
+ * FSAL_GetUserCred :
+ * Get a user credential from its uid.
+ *
+ * \param p_cred (in out, fsal_cred_t *)
+ *        Initialized credential to be changed
+ *        for representing user.
+ * \param uid (in, fsal_uid_t)
+ *        user identifier.
+ * \param gid (in, fsal_gid_t)
+ *        group identifier.
+ * \param alt_groups (in, fsal_gid_t *)
+ *        list of alternative groups.
+ * \param nb_alt_groups (in, fsal_count_t)
+ *        number of alternative groups.
+ *
+ * \return major codes :
+ *      - ERR_FSAL_PERM : the current user cannot
+ *                        get credentials for this uid.
+ *      - ERR_FSAL_FAULT : Bad adress parameter.
+ *      - ERR_FSAL_SERVERFAULT : unexpected error.
+ */
+
+fsal_status_t OBJSTOREFSAL_GetClientContext(objstorefsal_op_context_t * p_thr_context,    /* IN/OUT  */
+                                       objstorefsal_export_context_t * p_export_context,     /* IN */
+                                       fsal_uid_t uid,  /* IN */
+                                       fsal_gid_t gid,  /* IN */
+                                       fsal_gid_t * alt_groups, /* IN */
+                                       fsal_count_t nb_alt_groups       /* IN */
+    )
+{
+
+  fsal_count_t ng = nb_alt_groups;
+  unsigned int i;
+
+  /* sanity check */
+  if(!p_thr_context || !p_export_context)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_GetClientContext);
+
+  /* set the export specific context */
+  p_thr_context->export_context = p_export_context;
+
+  /* Extracted from  /opt/hpss/src/nfs/nfsd/nfs_Dispatch.c */
+  p_thr_context->credential.user = uid;
+  p_thr_context->credential.group = gid;
+
+  if(ng > FSAL_NGROUPS_MAX)
+    ng = FSAL_NGROUPS_MAX;
+  if((ng > 0) && (alt_groups == NULL))
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_GetClientContext);
+
+  p_thr_context->credential.nbgroups = ng;
+
+  for(i = 0; i < ng; i++)
+    p_thr_context->credential.alt_groups[i] = alt_groups[i];
+
+  if(isFullDebug(COMPONENT_FSAL))
+    {
+      /* traces: prints p_credential structure */
+
+      LogFullDebug(COMPONENT_FSAL, "credential modified:");
+      LogFullDebug(COMPONENT_FSAL, "\tuid = %d, gid = %d",
+                        p_thr_context->credential.user, p_thr_context->credential.group);
+
+      if (isFullDebug(COMPONENT_FSAL))
+        {
+          for(i = 0; i < p_thr_context->credential.nbgroups; i++)
+            LogFullDebug(COMPONENT_FSAL, "\tAlt grp: %d",
+                         p_thr_context->credential.alt_groups[i]);
+        }
+   }
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_GetClientContext);
+}
+
+/* @} */
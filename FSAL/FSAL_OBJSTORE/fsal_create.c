@@ -0,0 +1,356 @@
+/*
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+
+/**
+ *
+ * \file    fsal_create.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/24 13:45:36 $
+ * \version $Revision: 1.18 $
+ * \brief   Filesystem objects creation functions.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+#include <string.h>
+#include <time.h>
+
+/**
+ * FSAL_create:
+ * Create a regular file.
+ *
+ * \param parent_directory_handle (input):
+ *        Handle of the parent directory where the file is to be created.
+ * \param p_filename (input):
+ *        Pointer to the name of the file to be created.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param accessmode (input):
+ *        Mode for the file to be created.
+ *        (the umask defined into the FSAL configuration file
+ *        will be applied on it).
+ * \param object_handle (output):
+ *        Pointer to the handle of the created file.
+ * \param object_attributes (optional input/output): 
+ *        The attributes of the created file.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occurred.
+ */
+fsal_status_t OBJSTOREFSAL_create(objstorefsal_handle_t * p_parent_directory_handle,      /* IN */
+                             fsal_name_t * p_filename,  /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_accessmode_t accessmode,      /* IN */
+                             objstorefsal_handle_t * p_object_handle,        /* OUT */
+                             fsal_attrib_list_t * p_object_attributes   /* [ IN/OUT ] */
+    )
+{
+
+  fsal_status_t status;
+  mode_t unix_mode;
+
+  /* sanity checks.
+   * note : object_attributes is optional.
+   */
+  if(!p_parent_directory_handle || !p_context || !p_object_handle || !p_filename)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_create);
+
+  /* convert fsal mode to unix mode. */
+  unix_mode = fsal2unix_mode(accessmode);
+
+  /* Apply umask */
+  unix_mode = unix_mode & ~global_fs_info.umask;
+
+  LogFullDebug(COMPONENT_FSAL, "Creation mode: 0%o", accessmode);
+
+  TakeTokenFSCall();
+  status = fsal_internal_create(p_parent_directory_handle, p_filename, p_context,
+                                FSAL_TYPE_FILE, unix_mode, NULL, p_object_handle);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_create);
+
+  /* retrieve file attributes */
+  if(p_object_attributes)
+    {
+      status = OBJSTOREFSAL_getattrs(p_object_handle, p_context, p_object_attributes);
+
+      /* on error, we set a special bit in the mask. */
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_object_attributes->asked_attributes);
+          FSAL_SET_MASK(p_object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+
+    }
+
+  /* OK */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_create);
+
+}
+
+/**
+ * FSAL_mkdir:
+ * Create a directory.
+ *
+ * \param parent_directory_handle (input):
+ *        Handle of the parent directory where
+ *        the subdirectory is to be created.
+ * \param p_dirname (input):
+ *        Pointer to the name of the directory to be created.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param accessmode (input):
+ *        Mode for the directory to be created.
+ *        (the umask defined into the FSAL configuration file
+ *        will be applied on it).
+ * \param object_handle (output):
+ *        Pointer to the handle of the created directory.
+ * \param object_attributes (optionnal input/output): 
+ *        The attributes of the created directory.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_mkdir(objstorefsal_handle_t * p_parent_directory_handle,       /* IN */
+                            fsal_name_t * p_dirname,    /* IN */
+                            objstorefsal_op_context_t * p_context,   /* IN */
+                            fsal_accessmode_t accessmode,       /* IN */
+                            objstorefsal_handle_t * p_object_handle, /* OUT */
+                            fsal_attrib_list_t * p_object_attributes    /* [ IN/OUT ] */
+    )
+{
+
+  fsal_status_t status;
+  mode_t unix_mode;
+
+  /* sanity checks.
+   * note : object_attributes is optional.
+   */
+  if(!p_parent_directory_handle || !p_context || !p_object_handle || !p_dirname)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_mkdir);
+
+  /* convert FSAL mode to unix mode. */
+  unix_mode = fsal2unix_mode(accessmode);
+
+  /* Apply umask */
+  unix_mode = unix_mode & ~global_fs_info.umask;
+
+  TakeTokenFSCall();
+  status = fsal_internal_create(p_parent_directory_handle, p_dirname, p_context,
+                                FSAL_TYPE_DIR, unix_mode, NULL, p_object_handle);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_mkdir);
+
+  /* retrieve file attributes */
+  if(p_object_attributes)
+    {
+      status = OBJSTOREFSAL_getattrs(p_object_handle, p_context, p_object_attributes);
+
+      /* on error, we set a special bit in the mask. */
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_object_attributes->asked_attributes);
+          FSAL_SET_MASK(p_object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+
+    }
+
+  /* OK */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_mkdir);
+
+}
+
+/**
+ * FSAL_link:
+ * Create a hardlink.
+ *
+ * \param target_handle (input):
+ *        Handle of the target object.
+ * \param dir_handle (input):
+ *        Pointer to the directory handle where
+ *        the hardlink is to be created.
+ * \param p_link_name (input):
+ *        Pointer to the name of the hardlink to be created.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param accessmode (input):
+ *        Mode for the directory to be created.
+ *        (the umask defined into the FSAL configuration file
+ *        will be applied on it).
+ * \param attributes (optionnal input/output): 
+ *        The post_operation attributes of the linked object.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_link(objstorefsal_handle_t * p_target_handle,  /* IN */
+                           objstorefsal_handle_t * p_dir_handle,     /* IN */
+                           fsal_name_t * p_link_name,   /* IN */
+                           objstorefsal_op_context_t * p_context,    /* IN */
+                           fsal_attrib_list_t * p_attributes    /* [ IN/OUT ] */
+    )
+{
+
+  int rc;
+  fsal_status_t status;
+  fsal_u64_t existing;
+  objstore_inode_t *p_dir, *p_target;
+
+  /* sanity checks.
+   * note : attributes is optional.
+   */
+  if(!p_target_handle || !p_dir_handle || !p_context || !p_link_name)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_link);
+
+  /* Tests if hardlinking is allowed by configuration. */
+
+  if(!global_fs_info.link_support)
+    Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_link);
+
+  /* hard links to directories are not allowed */
+  if(p_target_handle->data.type == FSAL_TYPE_DIR)
+    Return(ERR_FSAL_PERM, 0, INDEX_FSAL_link);
+
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_dir_handle, &p_dir);
+  ReleaseTokenFSCall();
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_link);
+
+  if(p_dir->type != FSAL_TYPE_DIR)
+    {
+      objstore_inode_put(p_dir);
+      Return(ERR_FSAL_NOTDIR, 0, INDEX_FSAL_link);
+    }
+
+  /* Check the user can write in the directory */
+  status = fsal_internal_inode_access(p_context, p_dir, FSAL_W_OK | FSAL_X_OK);
+  if(FSAL_IS_ERROR(status))
+    {
+      objstore_inode_put(p_dir);
+      ReturnStatus(status, INDEX_FSAL_link);
+    }
+
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_target_handle, &p_target);
+  ReleaseTokenFSCall();
+  if(FSAL_IS_ERROR(status))
+    {
+      objstore_inode_put(p_dir);
+      ReturnStatus(status, INDEX_FSAL_link);
+    }
+
+  TakeTokenFSCall();
+  P_w(&objstore_ns_lock);
+
+  if(objstore_dir_find(p_dir, p_link_name->name, &existing) == 0)
+    rc = EEXIST;
+  else
+    {
+      /* the link count is stored first: a failure may leave an
+       * object with a too high link count, but no dangling entry */
+      P(p_target->lock);
+      p_target->nlink++;
+      p_target->ctime = time(NULL);
+      p_target->meta_dirty = TRUE;
+      V(p_target->lock);
+
+      if((rc = objstore_inode_store(p_target)) == 0
+         && (rc = objstore_dir_add(p_dir, p_link_name->name, p_target->inode)) == 0
+         && (rc = objstore_inode_store(p_dir)) != 0)
+        objstore_dir_remove(p_dir, p_link_name->name);
+
+      if(rc)
+        {
+          P(p_target->lock);
+          p_target->nlink--;
+          V(p_target->lock);
+        }
+    }
+
+  V_w(&objstore_ns_lock);
+  ReleaseTokenFSCall();
+
+  objstore_inode_put(p_dir);
+
+  if(rc)
+    {
+      objstore_inode_put(p_target);
+      Return(posix2fsal_error(rc), rc, INDEX_FSAL_link);
+    }
+
+  /* optionnaly get attributes */
+
+  if(p_attributes)
+    {
+      status = objstore2fsal_attributes(p_target, p_attributes);
+
+      /* on error, we set a special bit in the mask. */
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_attributes->asked_attributes);
+          FSAL_SET_MASK(p_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+    }
+
+  objstore_inode_put(p_target);
+
+  /* OK */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_link);
+
+}
+
+/**
+ * FSAL_mknode:
+ * Create a special object in the filesystem.
+ * Not supported by the object store, which only stores
+ * regular files, directories and symbolic links.
+ *
+ * \return ERR_FSAL_NOTSUPP.
+ */
+fsal_status_t OBJSTOREFSAL_mknode(objstorefsal_handle_t * parentdir_handle,       /* IN */
+                             fsal_name_t * p_node_name, /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_accessmode_t accessmode,      /* IN */
+                             fsal_nodetype_t nodetype,  /* IN */
+                             fsal_dev_t * dev,  /* IN */
+                             objstorefsal_handle_t * p_object_handle,        /* OUT (handle to the created node) */
+                             fsal_attrib_list_t * node_attributes       /* [ IN/OUT ] */
+    )
+{
+  /* sanity checks.
+   * note : link_attributes is optional.
+   */
+  if(!parentdir_handle || !p_context || !p_node_name)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_mknode);
+
+  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_mknode);
+}
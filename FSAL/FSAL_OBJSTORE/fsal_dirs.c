@@ -0,0 +1,294 @@
+/*
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+
+/**
+ *
+ * \file    fsal_dirs.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2005/07/29 09:39:04 $
+ * \version $Revision: 1.10 $
+ * \brief   Directory browsing operations.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+#include "stuff_alloc.h"
+#include <string.h>
+
+/**
+ * FSAL_opendir :
+ *     Opens a directory for reading its content.
+ *     
+ * \param dir_handle (input)
+ *         the handle of the directory to be opened.
+ * \param cred (input)
+ *         Permission context for the operation (user,...).
+ * \param dir_descriptor (output)
+ *         pointer to an allocated structure that will receive
+ *         directory stream informations, on successfull completion.
+ * \param dir_attributes (optional output)
+ *         On successfull completion,the structure pointed
+ *         by dir_attributes receives the new directory attributes.
+ *         May be NULL.
+ * 
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_opendir(objstorefsal_handle_t * p_dir_handle,  /* IN */
+                              objstorefsal_op_context_t * p_context, /* IN */
+                              objstorefsal_dir_t * p_dir_descriptor, /* OUT */
+                              fsal_attrib_list_t * p_dir_attributes     /* [ IN/OUT ] */
+    )
+{
+  fsal_status_t status;
+  objstore_inode_t *p_dir;
+
+  /* sanity checks
+   * note : dir_attributes is optionnal.
+   */
+  if(!p_dir_handle || !p_context || !p_dir_descriptor)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_opendir);
+
+  /* get the directory */
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_dir_handle, &p_dir);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_opendir);
+
+  if(p_dir->type != FSAL_TYPE_DIR)
+    {
+      objstore_inode_put(p_dir);
+      Return(ERR_FSAL_NOTDIR, 0, INDEX_FSAL_opendir);
+    }
+
+  /* Test access rights for this directory */
+  status = fsal_internal_inode_access(p_context, p_dir, FSAL_R_OK);
+  if(FSAL_IS_ERROR(status))
+    {
+      objstore_inode_put(p_dir);
+      ReturnStatus(status, INDEX_FSAL_opendir);
+    }
+
+  /* if everything is OK, fills the dir_desc structure : */
+
+  memcpy(&(p_dir_descriptor->context), p_context, sizeof(objstorefsal_op_context_t));
+  memcpy(&(p_dir_descriptor->handle), p_dir_handle, sizeof(objstorefsal_handle_t));
+
+  if(p_dir_attributes)
+    {
+      status = objstore2fsal_attributes(p_dir, p_dir_attributes);
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_dir_attributes->asked_attributes);
+          FSAL_SET_MASK(p_dir_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+    }
+
+  objstore_inode_put(p_dir);
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_opendir);
+
+}
+
+/**
+ * FSAL_readdir :
+ *     Read the entries of an opened directory.
+ *     
+ * \param dir_descriptor (input):
+ *        Pointer to the directory descriptor filled by FSAL_opendir.
+ * \param start_position (input):
+ *        Cookie that indicates the first object to be read during
+ *        this readdir operation.
+ *        This should be :
+ *        - FSAL_READDIR_FROM_BEGINNING for reading the content
+ *          of the directory from the beginning.
+ *        - The end_position parameter returned by the previous
+ *          call to FSAL_readdir.
+ * \param get_attr_mask (input)
+ *        Specify the set of attributes to be retrieved for directory entries.
+ * \param buffersize (input)
+ *        The size (in bytes) of the buffer where
+ *        the direntries are to be stored.
+ * \param pdirent (output)
+ *        Adresse of the buffer where the direntries are to be stored.
+ * \param end_position (output)
+ *        Cookie that indicates the current position in the directory.
+ * \param nb_entries (output)
+ *        Pointer to the number of entries read during the call.
+ * \param end_of_dir (output)
+ *        Pointer to a boolean that indicates if the end of dir
+ *        has been reached during the call.
+ * 
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_readdir(objstorefsal_dir_t * p_dir_descriptor, /* IN */
+                              objstorefsal_cookie_t start_position,  /* IN */
+                              fsal_attrib_mask_t get_attr_mask, /* IN */
+                              fsal_mdsize_t buffersize, /* IN */
+                              fsal_dirent_t * p_pdirent,        /* OUT */
+                              objstorefsal_cookie_t * p_end_position,        /* OUT */
+                              fsal_count_t * p_nb_entries,      /* OUT */
+                              fsal_boolean_t * p_end_of_dir     /* OUT */
+    )
+{
+  fsal_status_t st;
+  fsal_count_t max_dir_entries;
+  objstore_inode_t *p_dir, *p_entry;
+  objstore_dirent_t *entries;
+  unsigned int nb, i;
+  fsal_u64_t cookie;
+  int rc;
+
+  /*****************/
+  /* sanity checks */
+  /*****************/
+
+  if(!p_dir_descriptor || !p_pdirent || !p_end_position || !p_nb_entries || !p_end_of_dir)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_readdir);
+
+  max_dir_entries = (buffersize / sizeof(fsal_dirent_t));
+
+  *p_nb_entries = 0;
+  *p_end_of_dir = FALSE;
+
+  if(max_dir_entries == 0)
+    Return(ERR_FSAL_TOOSMALL, 0, INDEX_FSAL_readdir);
+
+  TakeTokenFSCall();
+  st = fsal_internal_getinode(&p_dir_descriptor->handle, &p_dir);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(st))
+    ReturnStatus(st, INDEX_FSAL_readdir);
+
+  if((entries = (objstore_dirent_t *) Mem_Alloc(max_dir_entries *
+                                                sizeof(objstore_dirent_t))) == NULL)
+    {
+      objstore_inode_put(p_dir);
+      Return(ERR_FSAL_NOMEM, Mem_Errno, INDEX_FSAL_readdir);
+    }
+
+  /***************************/
+  /* seek into the directory */
+  /***************************/
+
+  /* the cookie is the index of the next entry,
+   * entries are copied so that the lock is not held during the lookups */
+  cookie = start_position.data.cookie;
+
+  P_r(&objstore_ns_lock);
+
+  for(nb = 0; nb < max_dir_entries && cookie + nb < p_dir->nb_entries; nb++)
+    entries[nb] = p_dir->entries[cookie + nb];
+
+  if(cookie + nb >= p_dir->nb_entries)
+    *p_end_of_dir = TRUE;
+
+  V_r(&objstore_ns_lock);
+
+  objstore_inode_put(p_dir);
+
+  /************************/
+  /* browse the directory */
+  /************************/
+
+  for(i = 0; i < nb; i++)
+    {
+      objstorefsal_handle_t *p_handle =
+          (objstorefsal_handle_t *) (&(p_pdirent[*p_nb_entries].handle));
+
+      TakeTokenFSCall();
+      rc = objstore_inode_get(entries[i].inode, &p_entry);
+      ReleaseTokenFSCall();
+
+      /* the entry has been removed meanwhile */
+      if(rc == ENOENT)
+        continue;
+      else if(rc)
+        {
+          Mem_Free(entries);
+          Return(posix2fsal_error(rc), rc, INDEX_FSAL_readdir);
+        }
+
+      if(FSAL_IS_ERROR
+         (st =
+          FSAL_str2name(entries[i].name, FSAL_MAX_NAME_LEN,
+                        &(p_pdirent[*p_nb_entries].name))))
+        {
+          objstore_inode_put(p_entry);
+          Mem_Free(entries);
+          ReturnStatus(st, INDEX_FSAL_readdir);
+        }
+
+      memset(p_handle, 0, sizeof(objstorefsal_handle_t));
+      p_handle->data.inode = p_entry->inode;
+      p_handle->data.type = p_entry->type;
+
+    /************************
+     * Fills the attributes *
+     ************************/
+      p_pdirent[*p_nb_entries].attributes.asked_attributes = get_attr_mask;
+
+      st = objstore2fsal_attributes(p_entry, &p_pdirent[*p_nb_entries].attributes);
+      if(FSAL_IS_ERROR(st))
+        {
+          FSAL_CLEAR_MASK(p_pdirent[*p_nb_entries].attributes.asked_attributes);
+          FSAL_SET_MASK(p_pdirent[*p_nb_entries].attributes.asked_attributes,
+                        FSAL_ATTR_RDATTR_ERR);
+        }
+
+      objstore_inode_put(p_entry);
+
+      ((objstorefsal_cookie_t *) (&p_pdirent[*p_nb_entries].cookie))->data.cookie =
+          cookie + i + 1;
+      p_pdirent[*p_nb_entries].nextentry = NULL;
+      if(*p_nb_entries)
+        p_pdirent[*p_nb_entries - 1].nextentry = &(p_pdirent[*p_nb_entries]);
+
+      (*p_nb_entries)++;
+    }
+
+  Mem_Free(entries);
+
+  p_end_position->data.cookie = cookie + nb;
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_readdir);
+
+}
+
+/**
+ * FSAL_closedir :
+ * Free the resources allocated for reading directory entries.
+ *     
+ * \param dir_descriptor (input):
+ *        Pointer to a directory descriptor filled by FSAL_opendir.
+ * 
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_closedir(objstorefsal_dir_t * p_dir_descriptor /* IN */
+    )
+{
+
+  /* sanity checks */
+  if(!p_dir_descriptor)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_closedir);
+
+  /* fill dir_descriptor with zeros */
+  memset(p_dir_descriptor, 0, sizeof(objstorefsal_dir_t));
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_closedir);
+
+}
@@ -0,0 +1,504 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ------------- 
+ */
+
+/**
+ * \file    fsal_fileop.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/17 14:20:07 $
+ * \version $Revision: 1.9 $
+ * \brief   Files operations.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+
+/* position of an I/O, from the seek descriptor of the caller */
+static int fileop_position(objstorefsal_file_t * p_file_descriptor,
+                           fsal_seek_t * p_seek_descriptor, fsal_off_t * p_offset)
+{
+  fsal_off_t base;
+
+  if(!p_seek_descriptor)
+    {
+      *p_offset = p_file_descriptor->offset;
+      return 0;
+    }
+
+  switch (p_seek_descriptor->whence)
+    {
+    case FSAL_SEEK_CUR:
+      /* set position plus offset */
+      base = p_file_descriptor->offset;
+      break;
+
+    case FSAL_SEEK_SET:
+      /* set absolute position to offset */
+      base = 0;
+      break;
+
+    case FSAL_SEEK_END:
+      /* set end of file plus offset */
+      P(p_file_descriptor->p_inode->lock);
+      base = p_file_descriptor->p_inode->size;
+      V(p_file_descriptor->p_inode->lock);
+      break;
+
+    default:
+      return EINVAL;
+    }
+
+  if((fsal_off_t) (base + p_seek_descriptor->offset) < 0)
+    return EINVAL;
+
+  *p_offset = base + p_seek_descriptor->offset;
+  return 0;
+}
+
+/**
+ * FSAL_open_byname:
+ * Open a regular file for reading/writing its data content.
+ *
+ * \param dirhandle (input):
+ *        Handle of the directory that contain the file to be read/modified.
+ * \param filename (input):
+ *        Name of the file to be read/modified
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param openflags (input):
+ *        Flags that indicates behavior for file opening and access.
+ *        This is an inclusive OR of the following values
+ *        ( such of them are not compatible) :
+ *        - FSAL_O_RDONLY: opening file for reading only.
+ *        - FSAL_O_RDWR: opening file for reading and writing.
+ *        - FSAL_O_WRONLY: opening file for writting only.
+ *        - FSAL_O_APPEND: always write at the end of the file.
+ *        - FSAL_O_TRUNC: truncate the file to 0 on opening.
+ * \param file_descriptor (output):
+ *        The file descriptor to be used for FSAL_read/write operations.
+ * \param file_attributes (optionnal input/output):
+ *        Post operation attributes.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *
+ * \return Major error codes:
+ *      - ERR_FSAL_NO_ERROR     (no error)
+ *      - ERR_FSAL_ACCESS       (user doesn't have the permissions for opening the file)
+ *      - ERR_FSAL_STALE        (filehandle does not address an existing object)
+ *      - ERR_FSAL_INVAL        (filehandle does not address a regular file,
+ *                               or open flags are conflicting)
+ *      - ERR_FSAL_FAULT        (a NULL pointer was passed as mandatory argument)
+ *      - Other error codes can be returned :
+ *        ERR_FSAL_IO, ...
+ */
+
+fsal_status_t OBJSTOREFSAL_open_by_name(objstorefsal_handle_t * dirhandle,        /* IN */
+                                   fsal_name_t * filename,      /* IN */
+                                   objstorefsal_op_context_t * p_context,    /* IN */
+                                   fsal_openflags_t openflags,  /* IN */
+                                   objstorefsal_file_t * file_descriptor,    /* OUT */
+                                   fsal_attrib_list_t * file_attributes /* [ IN/OUT ] */ )
+{
+  fsal_status_t fsal_status;
+  objstorefsal_handle_t filehandle;
+
+  if(!dirhandle || !filename || !p_context || !file_descriptor)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_open_by_name);
+
+  fsal_status =
+      OBJSTOREFSAL_lookup(dirhandle, filename, p_context, &filehandle, file_attributes);
+  if(FSAL_IS_ERROR(fsal_status))
+    return fsal_status;
+
+  return OBJSTOREFSAL_open(&filehandle, p_context, openflags, file_descriptor,
+                      file_attributes);
+}
+
+/**
+ * FSAL_open:
+ * Open a regular file for reading/writing its data content.
+ *
+ * \param filehandle (input):
+ *        Handle of the file to be read/modified.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param openflags (input):
+ *        Flags that indicates behavior for file opening and access.
+ *        This is an inclusive OR of the following values
+ *        ( such of them are not compatible) : 
+ *        - FSAL_O_RDONLY: opening file for reading only.
+ *        - FSAL_O_RDWR: opening file for reading and writing.
+ *        - FSAL_O_WRONLY: opening file for writting only.
+ *        - FSAL_O_APPEND: always write at the end of the file.
+ *        - FSAL_O_TRUNC: truncate the file to 0 on opening.
+ * \param file_descriptor (output):
+ *        The file descriptor to be used for FSAL_read/write operations.
+ * \param file_attributes (optionnal input/output):
+ *        Post operation attributes.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *
+ * \return Major error codes:
+ *      - ERR_FSAL_NO_ERROR: no error.
+ *      - Another error code if an error occured during this call.
+ */
+fsal_status_t OBJSTOREFSAL_open(objstorefsal_handle_t * p_filehandle,     /* IN */
+                           objstorefsal_op_context_t * p_context,    /* IN */
+                           fsal_openflags_t openflags,  /* IN */
+                           objstorefsal_file_t * p_file_descriptor,  /* OUT */
+                           fsal_attrib_list_t * p_file_attributes       /* [ IN/OUT ] */
+    )
+{
+
+  int rc;
+  fsal_status_t status;
+  objstore_inode_t *p_inode;
+  fsal_accessflags_t access_type;
+  int posix_flags = 0;
+
+  /* sanity checks.
+   * note : file_attributes is optional.
+   */
+  if(!p_filehandle || !p_context || !p_file_descriptor)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_open);
+
+  /* convert fsal open flags to posix open flags */
+  rc = fsal2posix_openflags(openflags, &posix_flags);
+
+  /* flags conflicts. */
+  if(rc)
+    {
+      LogEvent(COMPONENT_FSAL, "Invalid/conflicting flags : %#X",
+                        openflags);
+      Return(rc, 0, INDEX_FSAL_open);
+    }
+
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_filehandle, &p_inode);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_open);
+
+  if(p_inode->type != FSAL_TYPE_FILE)
+    {
+      objstore_inode_put(p_inode);
+      Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_open);
+    }
+
+  /* check access rights */
+  if(openflags & FSAL_O_RDWR)
+    access_type = FSAL_R_OK | FSAL_W_OK;
+  else if(openflags & (FSAL_O_WRONLY | FSAL_O_APPEND | FSAL_O_TRUNC))
+    access_type = FSAL_W_OK;
+  else
+    access_type = FSAL_R_OK;
+
+  status = fsal_internal_inode_access(p_context, p_inode, access_type);
+  if(FSAL_IS_ERROR(status))
+    {
+      objstore_inode_put(p_inode);
+      ReturnStatus(status, INDEX_FSAL_open);
+    }
+
+  if(openflags & FSAL_O_TRUNC)
+    {
+      TakeTokenFSCall();
+      rc = objstore_cache_truncate(p_inode, 0);
+      ReleaseTokenFSCall();
+
+      if(rc)
+        {
+          objstore_inode_put(p_inode);
+          Return(posix2fsal_error(rc), rc, INDEX_FSAL_open);
+        }
+    }
+
+  /* the descriptor keeps a reference on the inode until it is closed */
+  p_file_descriptor->p_inode = p_inode;
+  p_file_descriptor->offset = 0;
+
+  /* set the read-only flag of the file descriptor */
+  p_file_descriptor->ro = !(access_type & FSAL_W_OK);
+  p_file_descriptor->append = ((openflags & FSAL_O_APPEND) != 0);
+
+  /* output attributes */
+  if(p_file_attributes)
+    {
+
+      status = objstore2fsal_attributes(p_inode, p_file_attributes);
+
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_file_attributes->asked_attributes);
+          FSAL_SET_MASK(p_file_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+    }
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_open);
+
+}
+
+/**
+ * FSAL_read:
+ * Perform a read operation on an opened file.
+ *
+ * \param file_descriptor (input):
+ *        The file descriptor returned by FSAL_open.
+ * \param seek_descriptor (optional input):
+ *        Specifies the position where data is to be read.
+ *        If not specified, data will be read at the current position.
+ * \param buffer_size (input):
+ *        Amount (in bytes) of data to be read.
+ * \param buffer (output):
+ *        Address where the read data is to be stored in memory.
+ * \param read_amount (output):
+ *        Pointer to the amount of data (in bytes) that have been read
+ *        during this call.
+ * \param end_of_file (output):
+ *        Pointer to a boolean that indicates whether the end of file
+ *        has been reached during this call.
+ *
+ * \return Major error codes:
+ *      - ERR_FSAL_NO_ERROR: no error.
+ *      - Another error code if an error occured during this call.
+ */
+fsal_status_t OBJSTOREFSAL_read(objstorefsal_file_t * p_file_descriptor,  /* IN */
+                           fsal_seek_t * p_seek_descriptor,     /* [IN] */
+                           fsal_size_t buffer_size,     /* IN */
+                           caddr_t buffer,      /* OUT */
+                           fsal_size_t * p_read_amount, /* OUT */
+                           fsal_boolean_t * p_end_of_file       /* OUT */
+    )
+{
+
+  size_t nb_read = 0;
+  fsal_off_t offset;
+  int rc, eof = FALSE;
+
+  /* sanity checks. */
+
+  if(!p_file_descriptor || !p_file_descriptor->p_inode || !buffer || !p_read_amount
+     || !p_end_of_file)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_read);
+
+  /* positioning */
+
+  if((rc = fileop_position(p_file_descriptor, p_seek_descriptor, &offset)) != 0)
+    {
+      LogEvent(COMPONENT_FSAL,
+                        "Error in seek operation (whence=%s, offset=%lld)",
+                        (p_seek_descriptor->whence == FSAL_SEEK_CUR ? "SEEK_CUR" :
+                         (p_seek_descriptor->whence == FSAL_SEEK_SET ? "SEEK_SET" :
+                          (p_seek_descriptor->whence ==
+                           FSAL_SEEK_END ? "SEEK_END" : "ERROR"))),
+                        p_seek_descriptor->offset);
+
+      Return(posix2fsal_error(rc), rc, INDEX_FSAL_read);
+    }
+
+  /* read operation, through the local cache */
+
+  TakeTokenFSCall();
+  rc = objstore_cache_read(p_file_descriptor->p_inode, offset, (size_t) buffer_size,
+                           buffer, &nb_read, &eof);
+  ReleaseTokenFSCall();
+
+  if(rc)
+    Return(posix2fsal_error(rc), rc, INDEX_FSAL_read);
+
+  p_file_descriptor->offset = offset + nb_read;
+
+  *p_read_amount = nb_read;
+  *p_end_of_file = (eof ? TRUE : FALSE);
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_read);
+
+}
+
+/**
+ * FSAL_write:
+ * Perform a write operation on an opened file.
+ *
+ * \param file_descriptor (input):
+ *        The file descriptor returned by FSAL_open.
+ * \param seek_descriptor (optional input):
+ *        Specifies the position where data is to be written.
+ *        If not specified, data will be written at the current position.
+ * \param buffer_size (input):
+ *        Amount (in bytes) of data to be written.
+ * \param buffer (input):
+ *        Address in memory of the data to write to file.
+ * \param write_amount (output):
+ *        Pointer to the amount of data (in bytes) that have been written
+ *        during this call.
+ *
+ * \return Major error codes:
+ *      - ERR_FSAL_NO_ERROR: no error.
+ *      - Another error code if an error occured during this call.
+ */
+fsal_status_t OBJSTOREFSAL_write(objstorefsal_file_t * p_file_descriptor, /* IN */
+                            fsal_seek_t * p_seek_descriptor,    /* IN */
+                            fsal_size_t buffer_size,    /* IN */
+                            caddr_t buffer,     /* IN */
+                            fsal_size_t * p_write_amount        /* OUT */
+    )
+{
+
+  size_t nb_written = 0;
+  fsal_off_t offset;
+  int rc;
+
+  /* sanity checks. */
+  if(!p_file_descriptor || !p_file_descriptor->p_inode || !buffer || !p_write_amount)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_write);
+
+  if(p_file_descriptor->ro)
+    Return(ERR_FSAL_PERM, 0, INDEX_FSAL_write);
+
+  *p_write_amount = 0;
+
+  /* positioning */
+
+  if(p_file_descriptor->append)
+    {
+      P(p_file_descriptor->p_inode->lock);
+      offset = p_file_descriptor->p_inode->size;
+      V(p_file_descriptor->p_inode->lock);
+    }
+  else if((rc = fileop_position(p_file_descriptor, p_seek_descriptor, &offset)) != 0)
+    {
+      LogEvent(COMPONENT_FSAL,
+                        "Error in seek operation (whence=%s, offset=%lld)",
+                        (p_seek_descriptor->whence == FSAL_SEEK_CUR ? "SEEK_CUR" :
+                         (p_seek_descriptor->whence == FSAL_SEEK_SET ? "SEEK_SET" :
+                          (p_seek_descriptor->whence ==
+                           FSAL_SEEK_END ? "SEEK_END" : "ERROR"))),
+                        p_seek_descriptor->offset);
+
+      Return(posix2fsal_error(rc), rc, INDEX_FSAL_write);
+    }
+
+  LogFullDebug(COMPONENT_FSAL,
+                    "Write operation (offset=%lld, size=%llu)",
+                    (long long)offset, (unsigned long long)buffer_size);
+
+  /* write operation, into the local cache */
+
+  TakeTokenFSCall();
+  rc = objstore_cache_write(p_file_descriptor->p_inode, offset, (size_t) buffer_size,
+                            buffer, &nb_written);
+  ReleaseTokenFSCall();
+
+  if(rc)
+    {
+      LogDebug(COMPONENT_FSAL,
+                        "Write operation of size %llu at offset %lld failed. inode=%llu, error=%d.",
+                        (unsigned long long)buffer_size, (long long)offset,
+                        (unsigned long long)p_file_descriptor->p_inode->inode, rc);
+      Return(posix2fsal_error(rc), rc, INDEX_FSAL_write);
+    }
+
+  /* set output vars */
+
+  p_file_descriptor->offset = offset + nb_written;
+  *p_write_amount = (fsal_size_t) nb_written;
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_write);
+
+}
+
+/**
+ * FSAL_close:
+ * Free the resources allocated by the FSAL_open call.
+ * The data written through the descriptor is made durable in the
+ * local cache, and also uploaded to the store if Flush_On_Close is set.
+ *
+ * \param file_descriptor (input):
+ *        The file descriptor returned by FSAL_open.
+ *
+ * \return Major error codes:
+ *      - ERR_FSAL_NO_ERROR: no error.
+ *      - Another error code if an error occured during this call.
+ */
+
+fsal_status_t OBJSTOREFSAL_close(objstorefsal_file_t * p_file_descriptor  /* IN */
+    )
+{
+
+  int rc = 0;
+
+  /* sanity checks. */
+  if(!p_file_descriptor || !p_file_descriptor->p_inode)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_close);
+
+  if(!p_file_descriptor->ro)
+    {
+      TakeTokenFSCall();
+      rc = objstore_cache_sync(p_file_descriptor->p_inode,
+                               global_objstore_info.flush_on_close);
+      ReleaseTokenFSCall();
+    }
+
+  objstore_inode_put(p_file_descriptor->p_inode);
+  p_file_descriptor->p_inode = NULL;
+
+  if(rc)
+    Return(posix2fsal_error(rc), rc, INDEX_FSAL_close);
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_close);
+
+}
+
+/* Some unsupported calls used in FSAL_PROXY, just for permit the ganeshell to compile */
+fsal_status_t OBJSTOREFSAL_open_by_fileid(objstorefsal_handle_t * filehandle,     /* IN */
+                                     fsal_u64_t fileid, /* IN */
+                                     objstorefsal_op_context_t * p_context,  /* IN */
+                                     fsal_openflags_t openflags,        /* IN */
+                                     objstorefsal_file_t * file_descriptor,  /* OUT */
+                                     fsal_attrib_list_t *
+                                     file_attributes /* [ IN/OUT ] */ )
+{
+  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_open_by_fileid);
+}
+
+fsal_status_t OBJSTOREFSAL_close_by_fileid(objstorefsal_file_t * file_descriptor /* IN */ ,
+                                      fsal_u64_t fileid)
+{
+  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_open_by_fileid);
+}
+
+unsigned int OBJSTOREFSAL_GetFileno(objstorefsal_file_t * pfile)
+{
+  return (unsigned int)pfile->p_inode->inode;
+}
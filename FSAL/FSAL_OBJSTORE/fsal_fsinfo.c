@@ -0,0 +1,99 @@
+/*
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+
+/**
+ *
+ * \file    fsal_fsinfo.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/17 14:20:07 $
+ * \version $Revision: 1.7 $
+ * \brief   functions for retrieving filesystem info.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+
+/* 256 TiB */
+#define OBJSTORE_REPORTED_CAPACITY ((fsal_size_t) 1 << 48)
+
+/**
+ * FSAL_static_fsinfo:
+ * Return static filesystem info such as
+ * behavior, configuration, supported operations...
+ *
+ * \param filehandle (input):
+ *        Handle of an object in the filesystem
+ *        whom info is to be retrieved.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param staticinfo (output):
+ *        Pointer to the static info of the filesystem.
+ *
+ * \return Major error codes:
+ *      - ERR_FSAL_NO_ERROR: no error.
+ *      - ERR_FSAL_FAULT: NULL pointer passed as input parameter.
+ *      - ERR_FSAL_SERVERFAULT: Unexpected error.
+ */
+fsal_status_t OBJSTOREFSAL_static_fsinfo(objstorefsal_handle_t * p_filehandle,    /* IN */
+                                    objstorefsal_op_context_t * p_context,   /* IN */
+                                    fsal_staticfsinfo_t * p_staticinfo  /* OUT */
+    )
+{
+  /* sanity checks. */
+  if(!p_staticinfo)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_static_fsinfo);
+
+  /* returning static info about the filesystem */
+  (*p_staticinfo) = global_fs_info;
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_static_fsinfo);
+
+}
+
+/**
+ * FSAL_dynamic_fsinfo:
+ * Return dynamic filesystem info such as
+ * used size, free size, number of objects...
+ *
+ * \param filehandle (input):
+ *        Handle of an object in the filesystem
+ *        whom info is to be retrieved.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param dynamicinfo (output):
+ *        Pointer to the static info of the filesystem.
+ *
+ * \return Major error codes:
+ *      - ERR_FSAL_NO_ERROR: no error.
+ *      - ERR_FSAL_FAULT: NULL pointer passed as input parameter.
+ *      - ERR_FSAL_SERVERFAULT: Unexpected error.
+ */
+fsal_status_t OBJSTOREFSAL_dynamic_fsinfo(objstorefsal_handle_t * p_filehandle,   /* IN */
+                                     objstorefsal_op_context_t * p_context,  /* IN */
+                                     fsal_dynamicfsinfo_t * p_dynamicinfo       /* OUT */
+    )
+{
+  /* sanity checks. */
+  if(!p_filehandle || !p_dynamicinfo || !p_context)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_dynamic_fsinfo);
+
+  /* a bucket has no size limit: report a fixed capacity, as s3 gateways do */
+  p_dynamicinfo->total_bytes = OBJSTORE_REPORTED_CAPACITY;
+  p_dynamicinfo->free_bytes = OBJSTORE_REPORTED_CAPACITY;
+  p_dynamicinfo->avail_bytes = OBJSTORE_REPORTED_CAPACITY;
+  p_dynamicinfo->total_files = 0;
+  p_dynamicinfo->free_files = 0;
+  p_dynamicinfo->avail_files = 0;
+
+  p_dynamicinfo->time_delta.seconds = 1;
+  p_dynamicinfo->time_delta.nseconds = 0;
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_dynamic_fsinfo);
+
+}
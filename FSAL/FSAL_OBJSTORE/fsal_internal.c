@@ -0,0 +1,823 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ------------- 
+ */
+
+/**
+ *
+ * \file    fsal_internal.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/17 14:20:07 $
+ * \version $Revision: 1.24 $
+ * \brief   Defines the datas that are to be
+ *          accessed as extern by the fsal modules
+ * 
+ */
+#define FSAL_INTERNAL_C
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include  "fsal.h"
+#include "fsal_internal.h"
+#include "stuff_alloc.h"
+#include "SemN.h"
+#include "fsal_convert.h"
+#include <pthread.h>
+#include <string.h>
+#include <sys/types.h>
+
+/* credential lifetime (1h) */
+fsal_uint_t CredentialLifetime = 3600;
+
+/* static filesystem info.
+ * The access is thread-safe because
+ * it is read-only, except during initialization.
+ */
+fsal_staticfsinfo_t global_fs_info;
+
+/* object store and cache settings, read-only after initialization */
+objstorefs_specific_initinfo_t global_objstore_info;
+
+/* filesystem info for the object store */
+static fsal_staticfsinfo_t default_objstore_info = {
+  0xFFFFFFFFFFFFFFFFLL,         /* max file size (64bits) */
+  _POSIX_LINK_MAX,              /* max links */
+  FSAL_MAX_NAME_LEN,            /* max filename */
+  FSAL_MAX_PATH_LEN,            /* max pathlen */
+  TRUE,                         /* no_trunc */
+  TRUE,                         /* chown restricted */
+  FALSE,                        /* case insensitivity */
+  TRUE,                         /* case preserving */
+  FSAL_EXPTYPE_PERSISTENT,      /* FH expire type */
+  TRUE,                         /* hard link support */
+  TRUE,                         /* symlink support */
+  FALSE,                        /* lock management */
+  TRUE,                         /* named attributes */
+  TRUE,                         /* handles are unique and persistent */
+  {10, 0},                      /* Duration of lease at FS in seconds */
+  FSAL_ACLSUPPORT_ALLOW,        /* ACL support */
+  TRUE,                         /* can change times */
+  TRUE,                         /* homogenous */
+  OBJSTORE_SUPPORTED_ATTRIBUTES, /* supported attributes */
+  0,                            /* maxread size */
+  0,                            /* maxwrite size */
+  0,                            /* default umask */
+  0,                            /* cross junctions */
+  0400                          /* default access rights for xattrs: root=RW, owner=R */
+};
+
+/* variables for limiting the calls to the filesystem */
+static int limit_calls = FALSE;
+semaphore_t sem_fs_calls;
+
+/* threads keys for stats */
+static pthread_key_t key_stats;
+static pthread_once_t once_key = PTHREAD_ONCE_INIT;
+
+/* init keys */
+static void init_keys(void)
+{
+  if(pthread_key_create(&key_stats, NULL) == -1)
+    LogError(COMPONENT_FSAL, ERR_SYS, ERR_PTHREAD_KEY_CREATE, errno);
+
+  return;
+}                               /* init_keys */
+
+/**
+ * fsal_increment_nbcall:
+ * Updates fonction call statistics.
+ *
+ * \param function_index (input):
+ *        Index of the function whom number of call is to be incremented.
+ * \param status (input):
+ *        Status the function returned.
+ *
+ * \return Nothing.
+ */
+void fsal_increment_nbcall(int function_index, fsal_status_t status)
+{
+
+  fsal_statistics_t *bythread_stat = NULL;
+
+  /* verify index */
+
+  if(function_index >= FSAL_NB_FUNC)
+    return;
+
+  /* first, we init the keys if this is the first time */
+
+  if(pthread_once(&once_key, init_keys) != 0)
+    {
+      LogError(COMPONENT_FSAL, ERR_SYS, ERR_PTHREAD_ONCE, errno);
+      return;
+    }
+
+  /* we get the specific value */
+
+  bythread_stat = (fsal_statistics_t *) pthread_getspecific(key_stats);
+
+  /* we allocate stats if this is the first time */
+
+  if(bythread_stat == NULL)
+    {
+      int i;
+
+      bythread_stat = (fsal_statistics_t *) Mem_Alloc(sizeof(fsal_statistics_t));
+
+      if(bythread_stat == NULL)
+        {
+          LogError(COMPONENT_FSAL, ERR_SYS, ERR_MALLOC, Mem_Errno);
+        }
+
+      /* inits the struct */
+
+      for(i = 0; i < FSAL_NB_FUNC; i++)
+        {
+          bythread_stat->func_stats.nb_call[i] = 0;
+          bythread_stat->func_stats.nb_success[i] = 0;
+          bythread_stat->func_stats.nb_err_retryable[i] = 0;
+          bythread_stat->func_stats.nb_err_unrecover[i] = 0;
+        }
+
+      /* set the specific value */
+      pthread_setspecific(key_stats, (void *)bythread_stat);
+
+    }
+
+  /* we increment the values */
+
+  if(bythread_stat)
+    {
+      bythread_stat->func_stats.nb_call[function_index]++;
+
+      if(!FSAL_IS_ERROR(status))
+        bythread_stat->func_stats.nb_success[function_index]++;
+      else if(status.major == ERR_FSAL_DELAY)   /* Error is retryable */
+        bythread_stat->func_stats.nb_err_retryable[function_index]++;
+      else
+        bythread_stat->func_stats.nb_err_unrecover[function_index]++;
+    }
+
+  return;
+}
+
+/**
+ * fsal_internal_getstats:
+ * (For internal use in the FSAL).
+ * Retrieve call statistics for current thread.
+ *
+ * \param output_stats (output):
+ *        Pointer to the call statistics structure.
+ *
+ * \return Nothing.
+ */
+void fsal_internal_getstats(fsal_statistics_t * output_stats)
+{
+
+  fsal_statistics_t *bythread_stat = NULL;
+
+  /* first, we init the keys if this is the first time */
+  if(pthread_once(&once_key, init_keys) != 0)
+    {
+      LogError(COMPONENT_FSAL, ERR_SYS, ERR_PTHREAD_ONCE, errno);
+      return;
+    }
+
+  /* we get the specific value */
+  bythread_stat = (fsal_statistics_t *) pthread_getspecific(key_stats);
+
+  /* we allocate stats if this is the first time */
+  if(bythread_stat == NULL)
+    {
+      int i;
+
+      if((bythread_stat =
+          (fsal_statistics_t *) Mem_Alloc(sizeof(fsal_statistics_t))) == NULL)
+        LogError(COMPONENT_FSAL, ERR_SYS, ERR_MALLOC, Mem_Errno);
+
+      /* inits the struct */
+      for(i = 0; i < FSAL_NB_FUNC; i++)
+        {
+          bythread_stat->func_stats.nb_call[i] = 0;
+          bythread_stat->func_stats.nb_success[i] = 0;
+          bythread_stat->func_stats.nb_err_retryable[i] = 0;
+          bythread_stat->func_stats.nb_err_unrecover[i] = 0;
+        }
+
+      /* set the specific value */
+      pthread_setspecific(key_stats, (void *)bythread_stat);
+
+    }
+
+  if(output_stats)
+    (*output_stats) = (*bythread_stat);
+
+  return;
+
+}
+
+/**
+ *  Used to limit the number of simultaneous calls to Filesystem.
+ */
+void TakeTokenFSCall()
+{
+  /* no limits */
+  if(limit_calls == FALSE)
+    return;
+
+  /* there is a limit */
+  semaphore_P(&sem_fs_calls);
+
+}
+
+void ReleaseTokenFSCall()
+{
+  /* no limits */
+  if(limit_calls == FALSE)
+    return;
+
+  /* there is a limit */
+  semaphore_V(&sem_fs_calls);
+
+}
+
+#define SET_INTEGER_PARAM( cfg, p_init_info, _field )             \
+    switch( (p_init_info)->behaviors._field ){                    \
+    case FSAL_INIT_FORCE_VALUE :                                  \
+      /* force the value in any case */                           \
+      cfg._field = (p_init_info)->values._field;                  \
+      break;                                                      \
+    case FSAL_INIT_MAX_LIMIT :                                    \
+      /* check the higher limit */                                \
+      if ( cfg._field > (p_init_info)->values._field )            \
+        cfg._field = (p_init_info)->values._field ;               \
+      break;                                                      \
+    case FSAL_INIT_MIN_LIMIT :                                    \
+      /* check the lower limit */                                 \
+      if ( cfg._field < (p_init_info)->values._field )            \
+        cfg._field = (p_init_info)->values._field ;               \
+      break;                                                      \
+    case FSAL_INIT_FS_DEFAULT:                                    \
+    default:                                                      \
+    /* In the other cases, we keep the default value. */          \
+        break;                                                    \
+    }
+
+#define SET_BITMAP_PARAM( cfg, p_init_info, _field )              \
+    switch( (p_init_info)->behaviors._field ){                    \
+    case FSAL_INIT_FORCE_VALUE :                                  \
+        /* force the value in any case */                         \
+        cfg._field = (p_init_info)->values._field;                \
+        break;                                                    \
+    case FSAL_INIT_MAX_LIMIT :                                    \
+      /* proceed a bit AND */                                     \
+      cfg._field &= (p_init_info)->values._field ;                \
+      break;                                                      \
+    case FSAL_INIT_MIN_LIMIT :                                    \
+      /* proceed a bit OR */                                      \
+      cfg._field |= (p_init_info)->values._field ;                \
+      break;                                                      \
+    case FSAL_INIT_FS_DEFAULT:                                    \
+    default:                                                      \
+    /* In the other cases, we keep the default value. */          \
+        break;                                                    \
+    }
+
+#define SET_BOOLEAN_PARAM( cfg, p_init_info, _field )             \
+    switch( (p_init_info)->behaviors._field ){                    \
+    case FSAL_INIT_FORCE_VALUE :                                  \
+        /* force the value in any case */                         \
+        cfg._field = (p_init_info)->values._field;                \
+        break;                                                    \
+    case FSAL_INIT_MAX_LIMIT :                                    \
+      /* proceed a boolean AND */                                 \
+      cfg._field = cfg._field && (p_init_info)->values._field ;   \
+      break;                                                      \
+    case FSAL_INIT_MIN_LIMIT :                                    \
+      /* proceed a boolean OR */                                  \
+      cfg._field = cfg._field && (p_init_info)->values._field ;   \
+      break;                                                      \
+    case FSAL_INIT_FS_DEFAULT:                                    \
+    default:                                                      \
+    /* In the other cases, we keep the default value. */          \
+        break;                                                    \
+    }
+
+/*
+ *  This function initializes shared variables of the fsal.
+ */
+fsal_status_t fsal_internal_init_global(fsal_init_info_t * fsal_info,
+                                        fs_common_initinfo_t * fs_common_info,
+                                        objstorefs_specific_initinfo_t * fs_specific_info)
+{
+
+  /* sanity check */
+  if(!fsal_info || !fs_common_info || !fs_specific_info)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  /* inits FS call semaphore */
+  if(fsal_info->max_fs_calls > 0)
+    {
+      int rc;
+
+      limit_calls = TRUE;
+
+      rc = semaphore_init(&sem_fs_calls, fsal_info->max_fs_calls);
+
+      if(rc != 0)
+        ReturnCode(ERR_FSAL_SERVERFAULT, rc);
+
+      LogDebug(COMPONENT_FSAL,
+                        "FSAL INIT: Max simultaneous calls to filesystem is limited to %u.",
+                        fsal_info->max_fs_calls);
+
+    }
+  else
+    {
+      LogDebug(COMPONENT_FSAL,
+                        "FSAL INIT: Max simultaneous calls to filesystem is unlimited.");
+    }
+
+  /* setting default values. */
+  global_fs_info = default_objstore_info;
+  global_objstore_info = *fs_specific_info;
+
+  LogDebug(COMPONENT_FSAL, "{");
+  LogDebug(COMPONENT_FSAL, "  maxfilesize  = %llX    ",
+           default_objstore_info.maxfilesize);
+  LogDebug(COMPONENT_FSAL, "  maxlink  = %lu   ",
+           default_objstore_info.maxlink);
+  LogDebug(COMPONENT_FSAL, "  maxnamelen  = %lu  ",
+           default_objstore_info.maxnamelen);
+  LogDebug(COMPONENT_FSAL, "  maxpathlen  = %lu  ",
+           default_objstore_info.maxpathlen);
+  LogDebug(COMPONENT_FSAL, "  no_trunc  = %d ",
+           default_objstore_info.no_trunc);
+  LogDebug(COMPONENT_FSAL, "  chown_restricted  = %d ",
+           default_objstore_info.chown_restricted);
+  LogDebug(COMPONENT_FSAL, "  case_insensitive  = %d ",
+           default_objstore_info.case_insensitive);
+  LogDebug(COMPONENT_FSAL, "  case_preserving  = %d ",
+           default_objstore_info.case_preserving);
+  LogDebug(COMPONENT_FSAL, "  fh_expire_type  = %hu ",
+           default_objstore_info.fh_expire_type);
+  LogDebug(COMPONENT_FSAL, "  link_support  = %d  ",
+           default_objstore_info.link_support);
+  LogDebug(COMPONENT_FSAL, "  symlink_support  = %d  ",
+           default_objstore_info.symlink_support);
+  LogDebug(COMPONENT_FSAL, "  lock_support  = %d  ",
+           default_objstore_info.lock_support);
+  LogDebug(COMPONENT_FSAL, "  named_attr  = %d  ",
+           default_objstore_info.named_attr);
+  LogDebug(COMPONENT_FSAL, "  unique_handles  = %d  ",
+           default_objstore_info.unique_handles);
+  LogDebug(COMPONENT_FSAL, "  acl_support  = %hu  ",
+           default_objstore_info.acl_support);
+  LogDebug(COMPONENT_FSAL, "  cansettime  = %d  ",
+           default_objstore_info.cansettime);
+  LogDebug(COMPONENT_FSAL, "  homogenous  = %d  ",
+           default_objstore_info.homogenous);
+  LogDebug(COMPONENT_FSAL, "  supported_attrs  = %llX  ",
+           default_objstore_info.supported_attrs);
+  LogDebug(COMPONENT_FSAL, "  maxread  = %llX     ",
+           default_objstore_info.maxread);
+  LogDebug(COMPONENT_FSAL, "  maxwrite  = %llX     ",
+           default_objstore_info.maxwrite);
+  LogDebug(COMPONENT_FSAL, "  umask  = %X ", default_objstore_info.umask);
+  LogDebug(COMPONENT_FSAL, "}");
+
+  /* Analyzing fs_common_info struct */
+
+  if((fs_common_info->behaviors.maxfilesize != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.maxlink != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.maxnamelen != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.maxpathlen != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.no_trunc != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.case_insensitive != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.case_preserving != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.named_attr != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.lease_time != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.supported_attrs != FSAL_INIT_FS_DEFAULT) ||
+     (fs_common_info->behaviors.homogenous != FSAL_INIT_FS_DEFAULT))
+    ReturnCode(ERR_FSAL_NOTSUPP, 0);
+
+  SET_BOOLEAN_PARAM(global_fs_info, fs_common_info, symlink_support);
+  SET_BOOLEAN_PARAM(global_fs_info, fs_common_info, link_support);
+  SET_BOOLEAN_PARAM(global_fs_info, fs_common_info, lock_support);
+  SET_BOOLEAN_PARAM(global_fs_info, fs_common_info, cansettime);
+
+  SET_INTEGER_PARAM(global_fs_info, fs_common_info, maxread);
+  SET_INTEGER_PARAM(global_fs_info, fs_common_info, maxwrite);
+
+  SET_BITMAP_PARAM(global_fs_info, fs_common_info, umask);
+
+  SET_BOOLEAN_PARAM(global_fs_info, fs_common_info, auth_exportpath_xdev);
+
+  SET_BITMAP_PARAM(global_fs_info, fs_common_info, xattr_access_rights);
+
+  LogFullDebug(COMPONENT_FSAL,
+                    "Supported attributes constant = 0x%llX.",
+                    OBJSTORE_SUPPORTED_ATTRIBUTES);
+
+  LogFullDebug(COMPONENT_FSAL,
+                    "Supported attributes default = 0x%llX.",
+                    default_objstore_info.supported_attrs);
+
+  LogDebug(COMPONENT_FSAL,
+                    "FSAL INIT: Supported attributes mask = 0x%llX.",
+                    global_fs_info.supported_attrs);
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+}
+
+/**
+ * fsal_internal_getinode:
+ * Gets the in-memory inode of an object, loading its index object
+ * from the store if it is not cached.
+ * The inode must be released with objstore_inode_put().
+ */
+fsal_status_t fsal_internal_getinode(objstorefsal_handle_t * p_handle,    /* IN */
+                                     objstore_inode_t ** pp_inode /* OUT */ )
+{
+  int rc;
+
+  if(!p_handle || !pp_inode)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  rc = objstore_inode_get(p_handle->data.inode, pp_inode);
+
+  /* the object was removed by another client of the bucket */
+  if(rc == ENOENT)
+    ReturnCode(ERR_FSAL_STALE, rc);
+  else if(rc)
+    ReturnCode(posix2fsal_error(rc), rc);
+
+  if((*pp_inode)->removed || (*pp_inode)->type != p_handle->data.type)
+    {
+      objstore_inode_put(*pp_inode);
+      ReturnCode(ERR_FSAL_STALE, ESTALE);
+    }
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+}                               /* fsal_internal_getinode */
+
+/**
+ * fsal_internal_path2handle:
+ * Walks an absolute path from the root directory of the bucket.
+ * Symbolic links are not followed.
+ */
+fsal_status_t fsal_internal_path2handle(fsal_path_t * p_fsalpath,       /* IN */
+                                        objstorefsal_handle_t * p_handle /* OUT */ )
+{
+  char path[FSAL_MAX_PATH_LEN];
+  char *name, *next;
+  objstore_inode_t *p_dir;
+  fsal_u64_t inode = OBJSTORE_ROOT_INODE;
+  fsal_nodetype_t type = FSAL_TYPE_DIR;
+  int rc = 0;
+
+  if(!p_fsalpath || !p_handle)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  if(p_fsalpath->path[0] != '/')
+    ReturnCode(ERR_FSAL_INVAL, 0);
+
+  strncpy(path, p_fsalpath->path, FSAL_MAX_PATH_LEN);
+  path[FSAL_MAX_PATH_LEN - 1] = '\0';
+
+  LogFullDebug(COMPONENT_FSAL, "Lookup handle for %s", path);
+
+  P_r(&objstore_ns_lock);
+
+  for(name = path; name != NULL; name = next)
+    {
+      /* skip the slashes, and split the next component */
+      while(*name == '/')
+        name++;
+
+      if(*name == '\0')
+        break;
+
+      next = strchr(name, '/');
+      if(next)
+        *(next++) = '\0';
+
+      if(type != FSAL_TYPE_DIR)
+        {
+          rc = ENOTDIR;
+          break;
+        }
+
+      if((rc = objstore_inode_get(inode, &p_dir)) != 0)
+        break;
+
+      rc = objstore_dir_find(p_dir, name, &inode);
+
+      objstore_inode_put(p_dir);
+
+      if(rc)
+        break;
+
+      /* get the type of the entry */
+      if((rc = objstore_inode_get(inode, &p_dir)) != 0)
+        break;
+
+      type = p_dir->type;
+      objstore_inode_put(p_dir);
+    }
+
+  V_r(&objstore_ns_lock);
+
+  if(rc)
+    ReturnCode(posix2fsal_error(rc), rc);
+
+  memset(p_handle, 0, sizeof(objstorefsal_handle_t));
+  p_handle->data.inode = inode;
+  p_handle->data.type = type;
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+}                               /* fsal_internal_path2handle */
+
+/*
+   Check the access from an existing fsal_attrib_list_t or struct stat
+*/
+/* XXX : ACL */
+fsal_status_t fsal_internal_testAccess(objstorefsal_op_context_t * p_context,        /* IN */
+                                       fsal_accessflags_t access_type,  /* IN */
+                                       struct stat * p_buffstat,        /* IN */
+                                       fsal_attrib_list_t * p_object_attributes /* IN */ )
+{
+  fsal_accessflags_t missing_access;
+  unsigned int is_grp, i;
+  fsal_uid_t uid;
+  fsal_gid_t gid;
+  fsal_accessmode_t mode;
+
+  /* sanity checks. */
+
+  if((!p_object_attributes && !p_buffstat) || !p_context)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  /* If the FSAL_F_OK flag is set, returns ERR INVAL */
+
+  if(access_type & FSAL_F_OK)
+    ReturnCode(ERR_FSAL_INVAL, 0);
+
+  /* test root access */
+
+  if(p_context->credential.user == 0)
+    ReturnCode(ERR_FSAL_NO_ERROR, 0);
+
+  /* unsatisfied flags */
+
+  missing_access = access_type;
+
+  if(p_object_attributes)
+    {
+      uid = p_object_attributes->owner;
+      gid = p_object_attributes->group;
+      mode = p_object_attributes->mode;
+    }
+  else
+    {
+      uid = p_buffstat->st_uid;
+      gid = p_buffstat->st_gid;
+      mode = unix2fsal_mode(p_buffstat->st_mode);
+    }
+
+  /* Test if file belongs to user. */
+
+  if(p_context->credential.user == uid)
+    {
+
+      LogFullDebug(COMPONENT_FSAL, "File belongs to user %d", uid);
+
+      if(mode & FSAL_MODE_RUSR)
+        missing_access &= ~FSAL_R_OK;
+
+      if(mode & FSAL_MODE_WUSR)
+        missing_access &= ~FSAL_W_OK;
+
+      if(mode & FSAL_MODE_XUSR)
+        missing_access &= ~FSAL_X_OK;
+
+      if(missing_access == 0)
+        ReturnCode(ERR_FSAL_NO_ERROR, 0);
+      else
+        {
+          LogFullDebug(COMPONENT_FSAL,
+                            "Mode=%#o, Access=%#o, Rights missing: %#o", mode,
+                            access_type, missing_access);
+          ReturnCode(ERR_FSAL_ACCESS, 0);
+        }
+
+    }
+
+  /* Test if the file belongs to user's group. */
+
+  is_grp = (p_context->credential.group == gid);
+
+  if(is_grp)
+    LogFullDebug(COMPONENT_FSAL, "File belongs to user's group %d",
+                      p_context->credential.group);
+
+
+  /* Test if file belongs to alt user's groups */
+
+  if(!is_grp)
+    {
+      for(i = 0; i < p_context->credential.nbgroups; i++)
+        {
+          is_grp = (p_context->credential.alt_groups[i] == gid);
+
+          if(is_grp)
+            LogFullDebug(COMPONENT_FSAL,
+                              "File belongs to user's alt group %d",
+                              p_context->credential.alt_groups[i]);
+
+          // exits loop if found
+          if(is_grp)
+            break;
+        }
+    }
+
+  /* finally apply group rights */
+
+  if(is_grp)
+    {
+      if(mode & FSAL_MODE_RGRP)
+        missing_access &= ~FSAL_R_OK;
+
+      if(mode & FSAL_MODE_WGRP)
+        missing_access &= ~FSAL_W_OK;
+
+      if(mode & FSAL_MODE_XGRP)
+        missing_access &= ~FSAL_X_OK;
+
+      if(missing_access == 0)
+        ReturnCode(ERR_FSAL_NO_ERROR, 0);
+      else
+        ReturnCode(ERR_FSAL_ACCESS, 0);
+
+    }
+
+  /* test other perms */
+
+  if(mode & FSAL_MODE_ROTH)
+    missing_access &= ~FSAL_R_OK;
+
+  if(mode & FSAL_MODE_WOTH)
+    missing_access &= ~FSAL_W_OK;
+
+  if(mode & FSAL_MODE_XOTH)
+    missing_access &= ~FSAL_X_OK;
+
+  /* XXX ACLs. */
+
+  if(missing_access == 0)
+    ReturnCode(ERR_FSAL_NO_ERROR, 0);
+  else
+    ReturnCode(ERR_FSAL_ACCESS, 0);
+
+}
+
+fsal_status_t fsal_internal_inode_access(objstorefsal_op_context_t * p_context,       /* IN */
+                                         objstore_inode_t * p_inode,    /* IN */
+                                         fsal_accessflags_t access_type /* IN */ )
+{
+  fsal_attrib_list_t attrs;
+  fsal_status_t status;
+
+  attrs.asked_attributes = FSAL_ATTR_OWNER | FSAL_ATTR_GROUP | FSAL_ATTR_MODE;
+
+  status = objstore2fsal_attributes(p_inode, &attrs);
+  if(FSAL_IS_ERROR(status))
+    return status;
+
+  return fsal_internal_testAccess(p_context, access_type, NULL, &attrs);
+}                               /* fsal_internal_inode_access */
+
+/**
+ * fsal_internal_create:
+ * The index object of the new entry is stored before the one of
+ * its parent directory, so that a failure never leaves an entry
+ * that refers to a missing object.
+ */
+fsal_status_t fsal_internal_create(objstorefsal_handle_t * p_parent_handle,   /* IN */
+                                   fsal_name_t * p_name,        /* IN */
+                                   objstorefsal_op_context_t * p_context,     /* IN */
+                                   fsal_nodetype_t type,        /* IN */
+                                   mode_t unix_mode,    /* IN */
+                                   const char *link,    /* IN (symlinks only) */
+                                   objstorefsal_handle_t * p_object_handle /* OUT */ )
+{
+  objstore_inode_t *p_dir, *p_inode;
+  fsal_status_t status;
+  fsal_u64_t existing;
+  gid_t gid;
+  int rc;
+
+  status = fsal_internal_getinode(p_parent_handle, &p_dir);
+  if(FSAL_IS_ERROR(status))
+    return status;
+
+  if(p_dir->type != FSAL_TYPE_DIR)
+    {
+      objstore_inode_put(p_dir);
+      ReturnCode(ERR_FSAL_NOTDIR, 0);
+    }
+
+  status = fsal_internal_inode_access(p_context, p_dir, FSAL_W_OK | FSAL_X_OK);
+  if(FSAL_IS_ERROR(status))
+    {
+      objstore_inode_put(p_dir);
+      return status;
+    }
+
+  P_w(&objstore_ns_lock);
+
+  if(objstore_dir_find(p_dir, p_name->name, &existing) == 0)
+    {
+      rc = EEXIST;
+      goto out;
+    }
+
+  /* the setgid bit of the parent directory is inherited */
+  P(p_dir->lock);
+  if(p_dir->mode & S_ISGID)
+    {
+      gid = p_dir->gid;
+      if(type == FSAL_TYPE_DIR)
+        unix_mode |= S_ISGID;
+    }
+  else
+    gid = p_context->credential.group;
+  V(p_dir->lock);
+
+  if((rc = objstore_inode_new(type, unix_mode, p_context->credential.user, gid,
+                              p_dir->inode, link, &p_inode)) != 0)
+    goto out;
+
+  if((rc = objstore_dir_add(p_dir, p_name->name, p_inode->inode)) == 0)
+    {
+      if(type == FSAL_TYPE_DIR)
+        {
+          P(p_dir->lock);
+          p_dir->nlink++;
+          V(p_dir->lock);
+        }
+
+      if((rc = objstore_inode_store(p_dir)) != 0)
+        {
+          objstore_dir_remove(p_dir, p_name->name);
+
+          if(type == FSAL_TYPE_DIR)
+            {
+              P(p_dir->lock);
+              p_dir->nlink--;
+              V(p_dir->lock);
+            }
+        }
+    }
+
+  if(rc == 0)
+    {
+      memset(p_object_handle, 0, sizeof(objstorefsal_handle_t));
+      p_object_handle->data.inode = p_inode->inode;
+      p_object_handle->data.type = type;
+    }
+  else
+    objstore_inode_destroy(p_inode);
+
+  objstore_inode_put(p_inode);
+
+ out:
+  V_w(&objstore_ns_lock);
+  objstore_inode_put(p_dir);
+
+  if(rc)
+    ReturnCode(posix2fsal_error(rc), rc);
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+}                               /* fsal_internal_create */
@@ -0,0 +1,464 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ *
+ * \file    fsal_internal.h
+ * \version $Revision: 1.12 $
+ * \brief   Extern definitions for variables that are
+ *          defined in fsal_internal.c.
+ * 
+ */
+
+#include  "fsal.h"
+#include "FSAL/FSAL_OBJSTORE/objstore.h"
+#include <sys/stat.h>
+
+/* defined the set of attributes supported by the object store */
+#define OBJSTORE_SUPPORTED_ATTRIBUTES (                                    \
+          FSAL_ATTR_SUPPATTR | FSAL_ATTR_TYPE     | FSAL_ATTR_SIZE      | \
+          FSAL_ATTR_FSID     |  FSAL_ATTR_FILEID  | \
+          FSAL_ATTR_MODE     | FSAL_ATTR_NUMLINKS | FSAL_ATTR_OWNER     | \
+          FSAL_ATTR_GROUP    | FSAL_ATTR_ATIME    | FSAL_ATTR_RAWDEV    | \
+          FSAL_ATTR_CTIME    | FSAL_ATTR_MTIME    | FSAL_ATTR_SPACEUSED | \
+          FSAL_ATTR_CHGTIME  )
+
+/* the following variables must not be defined in fsal_internal.c */
+#ifndef FSAL_INTERNAL_C
+
+/* static filesystem info.
+ * read access only.
+ */
+extern fsal_staticfsinfo_t global_fs_info;
+
+/* object store and cache settings */
+extern objstorefs_specific_initinfo_t global_objstore_info;
+
+#endif
+
+/**
+ *  This function initializes shared variables of the FSAL.
+ */
+fsal_status_t fsal_internal_init_global(fsal_init_info_t * fsal_info,
+                                        fs_common_initinfo_t * fs_common_info,
+                                        objstorefs_specific_initinfo_t * fs_specific_info);
+
+/**
+ *  Increments the number of calls for a function.
+ */
+void fsal_increment_nbcall(int function_index, fsal_status_t status);
+
+/**
+ * Retrieves current thread statistics.
+ */
+void fsal_internal_getstats(fsal_statistics_t * output_stats);
+
+/**
+ *  Used to limit the number of simultaneous calls to Filesystem.
+ */
+void TakeTokenFSCall();
+void ReleaseTokenFSCall();
+
+/**
+ * Gets the referenced in-memory inode of a handle.
+ */
+fsal_status_t fsal_internal_getinode(objstorefsal_handle_t * p_handle,    /* IN */
+                                     objstore_inode_t ** pp_inode /* OUT */ );
+
+/**
+ * Gets the handle of an absolute path of the bucket namespace.
+ */
+fsal_status_t fsal_internal_path2handle(fsal_path_t * p_fsalpath,       /* IN */
+                                        objstorefsal_handle_t * p_handle /* OUT */ );
+
+/**
+ *  test the access to a file from its POSIX attributes (struct stat) OR its FSAL attributes (fsal_attrib_list_t).
+ *
+ */
+fsal_status_t fsal_internal_testAccess(objstorefsal_op_context_t * p_context,        /* IN */
+                                       fsal_accessflags_t access_type,  /* IN */
+                                       struct stat *p_buffstat, /* IN, optional */
+                                       fsal_attrib_list_t *
+                                       p_object_attributes /* IN, optional */ );
+
+/**
+ * test the access to an object from its in-memory inode.
+ */
+fsal_status_t fsal_internal_inode_access(objstorefsal_op_context_t * p_context,       /* IN */
+                                         objstore_inode_t * p_inode,    /* IN */
+                                         fsal_accessflags_t access_type /* IN */ );
+
+/**
+ * Creates a new entry (file, directory or symlink) in a directory.
+ */
+fsal_status_t fsal_internal_create(objstorefsal_handle_t * p_parent_handle,   /* IN */
+                                   fsal_name_t * p_name,        /* IN */
+                                   objstorefsal_op_context_t * p_context,     /* IN */
+                                   fsal_nodetype_t type,        /* IN */
+                                   mode_t unix_mode,    /* IN */
+                                   const char *link,    /* IN (symlinks only) */
+                                   objstorefsal_handle_t * p_object_handle /* OUT */ );
+
+/* All the call to FSAL to be wrapped */
+fsal_status_t OBJSTOREFSAL_access(objstorefsal_handle_t * p_object_handle,        /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_accessflags_t access_type,    /* IN */
+                             fsal_attrib_list_t * p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_getattrs(objstorefsal_handle_t * p_filehandle, /* IN */
+                               objstorefsal_op_context_t * p_context,        /* IN */
+                               fsal_attrib_list_t * p_object_attributes /* IN/OUT */ );
+
+fsal_status_t OBJSTOREFSAL_setattrs(objstorefsal_handle_t * p_filehandle, /* IN */
+                               objstorefsal_op_context_t * p_context,        /* IN */
+                               fsal_attrib_list_t * p_attrib_set,       /* IN */
+                               fsal_attrib_list_t *
+                               p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_BuildExportContext(objstorefsal_export_context_t * p_export_context,   /* OUT */
+                                         fsal_path_t * p_export_path,   /* IN */
+                                         char *fs_specific_options /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_InitClientContext(objstorefsal_op_context_t * p_thr_context);
+
+fsal_status_t OBJSTOREFSAL_CleanUpExportContext(objstorefsal_export_context_t * p_export_context) ;
+
+fsal_status_t OBJSTOREFSAL_GetClientContext(objstorefsal_op_context_t * p_thr_context,    /* IN/OUT  */
+                                       objstorefsal_export_context_t * p_export_context,     /* IN */
+                                       fsal_uid_t uid,  /* IN */
+                                       fsal_gid_t gid,  /* IN */
+                                       fsal_gid_t * alt_groups, /* IN */
+                                       fsal_count_t nb_alt_groups /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_create(objstorefsal_handle_t * p_parent_directory_handle,      /* IN */
+                             fsal_name_t * p_filename,  /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_accessmode_t accessmode,      /* IN */
+                             objstorefsal_handle_t * p_object_handle,        /* OUT */
+                             fsal_attrib_list_t * p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_mkdir(objstorefsal_handle_t * p_parent_directory_handle,       /* IN */
+                            fsal_name_t * p_dirname,    /* IN */
+                            objstorefsal_op_context_t * p_context,   /* IN */
+                            fsal_accessmode_t accessmode,       /* IN */
+                            objstorefsal_handle_t * p_object_handle, /* OUT */
+                            fsal_attrib_list_t * p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_link(objstorefsal_handle_t * p_target_handle,  /* IN */
+                           objstorefsal_handle_t * p_dir_handle,     /* IN */
+                           fsal_name_t * p_link_name,   /* IN */
+                           objstorefsal_op_context_t * p_context,    /* IN */
+                           fsal_attrib_list_t * p_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_mknode(objstorefsal_handle_t * parentdir_handle,       /* IN */
+                             fsal_name_t * p_node_name, /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_accessmode_t accessmode,      /* IN */
+                             fsal_nodetype_t nodetype,  /* IN */
+                             fsal_dev_t * dev,  /* IN */
+                             objstorefsal_handle_t * p_object_handle,        /* OUT (handle to the created node) */
+                             fsal_attrib_list_t * node_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_opendir(objstorefsal_handle_t * p_dir_handle,  /* IN */
+                              objstorefsal_op_context_t * p_context, /* IN */
+                              objstorefsal_dir_t * p_dir_descriptor, /* OUT */
+                              fsal_attrib_list_t * p_dir_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_readdir(objstorefsal_dir_t * p_dir_descriptor, /* IN */
+                              objstorefsal_cookie_t start_position,  /* IN */
+                              fsal_attrib_mask_t get_attr_mask, /* IN */
+                              fsal_mdsize_t buffersize, /* IN */
+                              fsal_dirent_t * p_pdirent,        /* OUT */
+                              objstorefsal_cookie_t * p_end_position,        /* OUT */
+                              fsal_count_t * p_nb_entries,      /* OUT */
+                              fsal_boolean_t * p_end_of_dir /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_closedir(objstorefsal_dir_t * p_dir_descriptor /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_open_by_name(objstorefsal_handle_t * dirhandle,        /* IN */
+                                   fsal_name_t * filename,      /* IN */
+                                   objstorefsal_op_context_t * p_context,    /* IN */
+                                   fsal_openflags_t openflags,  /* IN */
+                                   objstorefsal_file_t * file_descriptor,    /* OUT */
+                                   fsal_attrib_list_t *
+                                   file_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_open(objstorefsal_handle_t * p_filehandle,     /* IN */
+                           objstorefsal_op_context_t * p_context,    /* IN */
+                           fsal_openflags_t openflags,  /* IN */
+                           objstorefsal_file_t * p_file_descriptor,  /* OUT */
+                           fsal_attrib_list_t * p_file_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_read(objstorefsal_file_t * p_file_descriptor,  /* IN */
+                           fsal_seek_t * p_seek_descriptor,     /* [IN] */
+                           fsal_size_t buffer_size,     /* IN */
+                           caddr_t buffer,      /* OUT */
+                           fsal_size_t * p_read_amount, /* OUT */
+                           fsal_boolean_t * p_end_of_file /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_write(objstorefsal_file_t * p_file_descriptor, /* IN */
+                            fsal_seek_t * p_seek_descriptor,    /* IN */
+                            fsal_size_t buffer_size,    /* IN */
+                            caddr_t buffer,     /* IN */
+                            fsal_size_t * p_write_amount /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_close(objstorefsal_file_t * p_file_descriptor /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_open_by_fileid(objstorefsal_handle_t * filehandle,     /* IN */
+                                     fsal_u64_t fileid, /* IN */
+                                     objstorefsal_op_context_t * p_context,  /* IN */
+                                     fsal_openflags_t openflags,        /* IN */
+                                     objstorefsal_file_t * file_descriptor,  /* OUT */
+                                     fsal_attrib_list_t *
+                                     file_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_close_by_fileid(objstorefsal_file_t * file_descriptor /* IN */ ,
+                                      fsal_u64_t fileid);
+
+fsal_status_t OBJSTOREFSAL_static_fsinfo(objstorefsal_handle_t * p_filehandle,    /* IN */
+                                    objstorefsal_op_context_t * p_context,   /* IN */
+                                    fsal_staticfsinfo_t * p_staticinfo /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_dynamic_fsinfo(objstorefsal_handle_t * p_filehandle,   /* IN */
+                                     objstorefsal_op_context_t * p_context,  /* IN */
+                                     fsal_dynamicfsinfo_t * p_dynamicinfo /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_Init(fsal_parameter_t * init_info /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_terminate();
+
+fsal_status_t OBJSTOREFSAL_test_access(objstorefsal_op_context_t * p_context,     /* IN */
+                                  fsal_accessflags_t access_type,       /* IN */
+                                  fsal_attrib_list_t * p_object_attributes /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_setattr_access(objstorefsal_op_context_t * p_context,  /* IN */
+                                     fsal_attrib_list_t * candidate_attributes, /* IN */
+                                     fsal_attrib_list_t * object_attributes /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_rename_access(objstorefsal_op_context_t * pcontext,    /* IN */
+                                    fsal_attrib_list_t * pattrsrc,      /* IN */
+                                    fsal_attrib_list_t * pattrdest) /* IN */ ;
+
+fsal_status_t OBJSTOREFSAL_create_access(objstorefsal_op_context_t * pcontext,    /* IN */
+                                    fsal_attrib_list_t * pattr) /* IN */ ;
+
+fsal_status_t OBJSTOREFSAL_unlink_access(objstorefsal_op_context_t * pcontext,    /* IN */
+                                    fsal_attrib_list_t * pattr) /* IN */ ;
+
+fsal_status_t OBJSTOREFSAL_link_access(objstorefsal_op_context_t * pcontext,      /* IN */
+                                  fsal_attrib_list_t * pattr) /* IN */ ;
+
+fsal_status_t OBJSTOREFSAL_merge_attrs(fsal_attrib_list_t * pinit_attr,
+                                  fsal_attrib_list_t * pnew_attr,
+                                  fsal_attrib_list_t * presult_attr);
+
+fsal_status_t OBJSTOREFSAL_lookup(objstorefsal_handle_t * p_parent_directory_handle,      /* IN */
+                             fsal_name_t * p_filename,  /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             objstorefsal_handle_t * p_object_handle,        /* OUT */
+                             fsal_attrib_list_t * p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_lookupPath(fsal_path_t * p_path,  /* IN */
+                                 objstorefsal_op_context_t * p_context,      /* IN */
+                                 objstorefsal_handle_t * object_handle,      /* OUT */
+                                 fsal_attrib_list_t *
+                                 p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_lookupJunction(objstorefsal_handle_t * p_junction_handle,      /* IN */
+                                     objstorefsal_op_context_t * p_context,  /* IN */
+                                     objstorefsal_handle_t * p_fsoot_handle, /* OUT */
+                                     fsal_attrib_list_t *
+                                     p_fsroot_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_lock(objstorefsal_file_t * obj_handle,
+                           objstorefsal_lockdesc_t * ldesc, fsal_boolean_t blocking);
+
+fsal_status_t OBJSTOREFSAL_changelock(objstorefsal_lockdesc_t * lock_descriptor,  /* IN / OUT */
+                                 fsal_lockparam_t * lock_info /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_unlock(objstorefsal_file_t * obj_handle, objstorefsal_lockdesc_t * ldesc);
+
+fsal_status_t OBJSTOREFSAL_getlock(objstorefsal_file_t * obj_handle, objstorefsal_lockdesc_t * ldesc);
+
+fsal_status_t OBJSTOREFSAL_CleanObjectResources(objstorefsal_handle_t * in_fsal_handle);
+
+fsal_status_t OBJSTOREFSAL_set_quota(fsal_path_t * pfsal_path,       /* IN */
+                                int quota_type, /* IN */
+                                fsal_uid_t fsal_uid,    /* IN */
+                                fsal_quota_t * pquota,  /* IN */
+                                fsal_quota_t * presquota);      /* OUT */
+
+fsal_status_t OBJSTOREFSAL_get_quota(fsal_path_t * pfsal_path,       /* IN */
+                                int quota_type, /* IN */
+                                fsal_uid_t fsal_uid,    /* IN */
+                                fsal_quota_t * pquota); /* OUT */
+
+fsal_status_t OBJSTOREFSAL_rcp(objstorefsal_handle_t * filehandle,        /* IN */
+                          objstorefsal_op_context_t * p_context,     /* IN */
+                          fsal_path_t * p_local_path,   /* IN */
+                          fsal_rcpflag_t transfer_opt /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_rcp_by_fileid(objstorefsal_handle_t * filehandle,      /* IN */
+                                    fsal_u64_t fileid,  /* IN */
+                                    objstorefsal_op_context_t * p_context,   /* IN */
+                                    fsal_path_t * p_local_path, /* IN */
+                                    fsal_rcpflag_t transfer_opt /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_rename(objstorefsal_handle_t * p_old_parentdir_handle, /* IN */
+                             fsal_name_t * p_old_name,  /* IN */
+                             objstorefsal_handle_t * p_new_parentdir_handle, /* IN */
+                             fsal_name_t * p_new_name,  /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_attrib_list_t * p_src_dir_attributes, /* [ IN/OUT ] */
+                             fsal_attrib_list_t * p_tgt_dir_attributes /* [ IN/OUT ] */ );
+
+void OBJSTOREFSAL_get_stats(fsal_statistics_t * stats,       /* OUT */
+                       fsal_boolean_t reset /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_readlink(objstorefsal_handle_t * p_linkhandle, /* IN */
+                               objstorefsal_op_context_t * p_context,        /* IN */
+                               fsal_path_t * p_link_content,    /* OUT */
+                               fsal_attrib_list_t * p_link_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_symlink(objstorefsal_handle_t * p_parent_directory_handle,     /* IN */
+                              fsal_name_t * p_linkname, /* IN */
+                              fsal_path_t * p_linkcontent,      /* IN */
+                              objstorefsal_op_context_t * p_context, /* IN */
+                              fsal_accessmode_t accessmode,     /* IN (ignored) */
+                              objstorefsal_handle_t * p_link_handle, /* OUT */
+                              fsal_attrib_list_t * p_link_attributes /* [ IN/OUT ] */ );
+
+int OBJSTOREFSAL_handlecmp(objstorefsal_handle_t * handle1, objstorefsal_handle_t * handle2,
+                      fsal_status_t * status);
+
+unsigned int OBJSTOREFSAL_Handle_to_HashIndex(objstorefsal_handle_t * p_handle,
+                                         unsigned int cookie,
+                                         unsigned int alphabet_len,
+                                         unsigned int index_size);
+
+unsigned int OBJSTOREFSAL_Handle_to_RBTIndex(objstorefsal_handle_t * p_handle, unsigned int cookie);
+
+fsal_status_t OBJSTOREFSAL_DigestHandle(objstorefsal_export_context_t * p_expcontext,     /* IN */
+                                   fsal_digesttype_t output_type,       /* IN */
+                                   objstorefsal_handle_t * p_in_fsal_handle, /* IN */
+                                   caddr_t out_buff /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_ExpandHandle(objstorefsal_export_context_t * p_expcontext,     /* IN */
+                                   fsal_digesttype_t in_type,   /* IN */
+                                   caddr_t in_buff,     /* IN */
+                                   objstorefsal_handle_t * p_out_fsal_handle /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_SetDefault_FSAL_parameter(fsal_parameter_t * out_parameter);
+
+fsal_status_t OBJSTOREFSAL_SetDefault_FS_common_parameter(fsal_parameter_t * out_parameter);
+
+fsal_status_t OBJSTOREFSAL_SetDefault_FS_specific_parameter(fsal_parameter_t * out_parameter);
+
+fsal_status_t OBJSTOREFSAL_load_FSAL_parameter_from_conf(config_file_t in_config,
+                                                    fsal_parameter_t * out_parameter);
+
+fsal_status_t OBJSTOREFSAL_load_FS_common_parameter_from_conf(config_file_t in_config,
+                                                         fsal_parameter_t *
+                                                         out_parameter);
+
+fsal_status_t OBJSTOREFSAL_load_FS_specific_parameter_from_conf(config_file_t in_config,
+                                                           fsal_parameter_t *
+                                                           out_parameter);
+
+fsal_status_t OBJSTOREFSAL_truncate(objstorefsal_handle_t * p_filehandle, /* IN */
+                               objstorefsal_op_context_t * p_context,        /* IN */
+                               fsal_size_t length,      /* IN */
+                               objstorefsal_file_t * file_descriptor,        /* Unused in this FSAL */
+                               fsal_attrib_list_t *
+                               p_object_attributes /* [ IN/OUT ] */ );
+
+fsal_status_t OBJSTOREFSAL_unlink(objstorefsal_handle_t * p_parent_directory_handle,      /* IN */
+                             fsal_name_t * p_object_name,       /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_attrib_list_t *
+                             p_parent_directory_attributes /* [IN/OUT ] */ );
+
+char *OBJSTOREFSAL_GetFSName();
+
+fsal_status_t OBJSTOREFSAL_GetXAttrAttrs(objstorefsal_handle_t * p_objecthandle,  /* IN */
+                                    objstorefsal_op_context_t * p_context,   /* IN */
+                                    unsigned int xattr_id,      /* IN */
+                                    fsal_attrib_list_t * p_attrs);
+
+fsal_status_t OBJSTOREFSAL_ListXAttrs(objstorefsal_handle_t * p_objecthandle,     /* IN */
+                                 unsigned int cookie,   /* IN */
+                                 objstorefsal_op_context_t * p_context,      /* IN */
+                                 fsal_xattrent_t * xattrs_tab,  /* IN/OUT */
+                                 unsigned int xattrs_tabsize,   /* IN */
+                                 unsigned int *p_nb_returned,   /* OUT */
+                                 int *end_of_list /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_GetXAttrValueById(objstorefsal_handle_t * p_objecthandle,      /* IN */
+                                        unsigned int xattr_id,  /* IN */
+                                        objstorefsal_op_context_t * p_context,       /* IN */
+                                        caddr_t buffer_addr,    /* IN/OUT */
+                                        size_t buffer_size,     /* IN */
+                                        size_t * p_output_size /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_GetXAttrIdByName(objstorefsal_handle_t * p_objecthandle,       /* IN */
+                                       const fsal_name_t * xattr_name,  /* IN */
+                                       objstorefsal_op_context_t * p_context,        /* IN */
+                                       unsigned int *pxattr_id /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_GetXAttrValueByName(objstorefsal_handle_t * p_objecthandle,    /* IN */
+                                          const fsal_name_t * xattr_name,       /* IN */
+                                          objstorefsal_op_context_t * p_context,     /* IN */
+                                          caddr_t buffer_addr,  /* IN/OUT */
+                                          size_t buffer_size,   /* IN */
+                                          size_t * p_output_size /* OUT */ );
+
+fsal_status_t OBJSTOREFSAL_SetXAttrValue(objstorefsal_handle_t * p_objecthandle,  /* IN */
+                                    const fsal_name_t * xattr_name,     /* IN */
+                                    objstorefsal_op_context_t * p_context,   /* IN */
+                                    caddr_t buffer_addr,        /* IN */
+                                    size_t buffer_size, /* IN */
+                                    int create /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_SetXAttrValueById(objstorefsal_handle_t * p_objecthandle,      /* IN */
+                                        unsigned int xattr_id,  /* IN */
+                                        objstorefsal_op_context_t * p_context,       /* IN */
+                                        caddr_t buffer_addr,    /* IN */
+                                        size_t buffer_size /* IN */ );
+
+fsal_status_t OBJSTOREFSAL_RemoveXAttrById(objstorefsal_handle_t * p_objecthandle,        /* IN */
+                                      objstorefsal_op_context_t * p_context, /* IN */
+                                      unsigned int xattr_id) /* IN */ ;
+
+fsal_status_t OBJSTOREFSAL_RemoveXAttrByName(objstorefsal_handle_t * p_objecthandle,      /* IN */
+                                        objstorefsal_op_context_t * p_context,       /* IN */
+                                        const fsal_name_t * xattr_name) /* IN */ ;
+
+unsigned int OBJSTOREFSAL_GetFileno(objstorefsal_file_t * pfile);
+
+fsal_status_t OBJSTOREFSAL_getextattrs(objstorefsal_handle_t * p_filehandle, /* IN */
+                                  objstorefsal_op_context_t * p_context,        /* IN */
+                                  fsal_extattrib_list_t * p_object_attributes /* OUT */) ;
+
+
@@ -0,0 +1,90 @@
+/*
+ * Copyright IBM Corporation, 2010
+ *  Contributor: Aneesh Kumar K.v  <aneesh.kumar@linux.vnet.ibm.com>
+ *
+ *
+ * This software is a server that implements the NFS protocol.
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301
+ * 
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+
+/* Locks are not supported by the object store (lock_support is FALSE):
+ * they are managed by the upper layers. */
+
+/**
+ * FSAL_lock:
+ * Not implemented.
+ */
+fsal_status_t OBJSTOREFSAL_lock(objstorefsal_file_t * obj_handle,
+                           objstorefsal_lockdesc_t * ldesc, fsal_boolean_t blocking)
+{
+
+  /* sanity checks. */
+  if(!obj_handle || !ldesc)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_lock);
+
+  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_lock);
+}
+
+/**
+ * FSAL_changelock:
+ * Not implemented.
+ */
+fsal_status_t OBJSTOREFSAL_changelock(objstorefsal_lockdesc_t * lock_descriptor,  /* IN / OUT */
+                                 fsal_lockparam_t * lock_info   /* IN */
+    )
+{
+
+  /* sanity checks. */
+  if(!lock_descriptor)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_changelock);
+
+  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_changelock);
+
+}
+
+/**
+ * FSAL_unlock:
+ * Not implemented.
+ */
+fsal_status_t OBJSTOREFSAL_unlock(objstorefsal_file_t * obj_handle, objstorefsal_lockdesc_t * ldesc)
+{
+
+  /* sanity checks. */
+  if(!obj_handle || !ldesc)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_unlock);
+
+  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_unlock);
+}
+
+fsal_status_t OBJSTOREFSAL_getlock(objstorefsal_file_t * obj_handle, objstorefsal_lockdesc_t * ldesc)
+{
+
+  /* sanity checks. */
+  if(!obj_handle || !ldesc)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_getlock);
+
+  Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_getlock);
+}
@@ -0,0 +1,301 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ------------- 
+ */
+
+/**
+ * \file    fsal_lookup.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/24 13:45:37 $
+ * \version $Revision: 1.17 $
+ * \brief   Lookup operations.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <string.h>
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+
+/**
+ * FSAL_lookup :
+ * Looks up for an object into a directory.
+ *
+ * Note : if parent handle and filename are NULL,
+ *        this retrieves root's handle.
+ *
+ * \param parent_directory_handle (input)
+ *        Handle of the parent directory to search the object in.
+ * \param filename (input)
+ *        The name of the object to find.
+ * \param p_context (input)
+ *        Authentication context for the operation (user,...).
+ * \param object_handle (output)
+ *        The handle of the object corresponding to filename.
+ * \param object_attributes (optional input/output)
+ *        Pointer to the attributes of the object we found.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        It can be NULL (increases performances).
+ *
+ * \return - ERR_FSAL_NO_ERROR, if no error.
+ *         - Another error code else.
+ *          
+ */
+fsal_status_t OBJSTOREFSAL_lookup(objstorefsal_handle_t * p_parent_directory_handle,      /* IN */
+                             fsal_name_t * p_filename,  /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             objstorefsal_handle_t * p_object_handle,        /* OUT */
+                             fsal_attrib_list_t * p_object_attributes   /* [ IN/OUT ] */
+    )
+{
+  int rc;
+  fsal_status_t status;
+  objstore_inode_t *p_dir, *p_inode;
+  fsal_u64_t inode;
+
+  /* sanity checks
+   * note : object_attributes is optionnal
+   *        parent_directory_handle may be null for getting FS root.
+   */
+  if(!p_object_handle || !p_context)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_lookup);
+
+  /* filename AND parent handle are NULL => lookup "/" */
+  if((p_parent_directory_handle && !p_filename)
+     || (!p_parent_directory_handle && p_filename))
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_lookup);
+
+  /* get information about root */
+  if(!p_parent_directory_handle)
+    {
+      /* get handle for the mount point  */
+      memcpy(p_object_handle, &p_context->export_context->root_handle,
+             sizeof(objstorefsal_handle_t));
+
+      /* get attributes, if asked */
+      if(p_object_attributes)
+        {
+          status = OBJSTOREFSAL_getattrs(p_object_handle, p_context, p_object_attributes);
+          if(FSAL_IS_ERROR(status))
+            {
+              FSAL_CLEAR_MASK(p_object_attributes->asked_attributes);
+              FSAL_SET_MASK(p_object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+            }
+        }
+      /* Done */
+      Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_lookup);
+    }
+
+  /* get the parent directory */
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_parent_directory_handle, &p_dir);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_lookup);
+
+  if(p_dir->type != FSAL_TYPE_DIR)
+    {
+      objstore_inode_put(p_dir);
+      Return(ERR_FSAL_NOTDIR, 0, INDEX_FSAL_lookup);
+    }
+
+  /* check rights to enter into the directory */
+  status = fsal_internal_inode_access(p_context, p_dir, FSAL_X_OK);
+  if(FSAL_IS_ERROR(status))
+    {
+      objstore_inode_put(p_dir);
+      ReturnStatus(status, INDEX_FSAL_lookup);
+    }
+
+  /* "." and ".." are not stored in the directories */
+  P_r(&objstore_ns_lock);
+
+  if(!strcmp(p_filename->name, "."))
+    {
+      inode = p_dir->inode;
+      rc = 0;
+    }
+  else if(!strcmp(p_filename->name, ".."))
+    {
+      P(p_dir->lock);
+      inode = p_dir->parent;
+      V(p_dir->lock);
+      rc = 0;
+    }
+  else
+    rc = objstore_dir_find(p_dir, p_filename->name, &inode);
+
+  if(rc == 0)
+    rc = objstore_inode_get(inode, &p_inode);
+
+  V_r(&objstore_ns_lock);
+
+  objstore_inode_put(p_dir);
+
+  if(rc)
+    Return(posix2fsal_error(rc), rc, INDEX_FSAL_lookup);
+
+  memset(p_object_handle, 0, sizeof(objstorefsal_handle_t));
+  p_object_handle->data.inode = p_inode->inode;
+  p_object_handle->data.type = p_inode->type;
+
+  /* get object attributes */
+  if(p_object_attributes)
+    {
+      status = objstore2fsal_attributes(p_inode, p_object_attributes);
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_object_attributes->asked_attributes);
+          FSAL_SET_MASK(p_object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+    }
+
+  objstore_inode_put(p_inode);
+
+  /* lookup complete ! */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_lookup);
+
+}
+
+/**
+ * FSAL_lookupPath :
+ * Looks up for an object into the namespace.
+ *
+ * Note : if path equals "/",
+ *        this retrieves root's handle.
+ *
+ * \param path (input)
+ *        The path of the object to find.
+ * \param p_context (input)
+ *        Authentication context for the operation (user,...).
+ * \param object_handle (output)
+ *        The handle of the object corresponding to filename.
+ * \param object_attributes (optional input/output)
+ *        Pointer to the attributes of the object we found.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        It can be NULL (increases performances).
+ */
+
+fsal_status_t OBJSTOREFSAL_lookupPath(fsal_path_t * p_path,  /* IN */
+                                 objstorefsal_op_context_t * p_context,      /* IN */
+                                 objstorefsal_handle_t * object_handle,      /* OUT */
+                                 fsal_attrib_list_t * p_object_attributes       /* [ IN/OUT ] */
+    )
+{
+  fsal_status_t status;
+
+  /* sanity checks
+   * note : object_attributes is optionnal.
+   */
+
+  if(!object_handle || !p_context || !p_path)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_lookupPath);
+
+  /* test whether the path begins with a slash */
+
+  if(p_path->path[0] != '/')
+    Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_lookupPath);
+
+  /* directly call the lookup function */
+
+  status = fsal_internal_path2handle(p_path, object_handle);
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_lookupPath);
+
+  /* get object attributes */
+  if(p_object_attributes)
+    {
+      status = OBJSTOREFSAL_getattrs(object_handle, p_context, p_object_attributes);
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_object_attributes->asked_attributes);
+          FSAL_SET_MASK(p_object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+    }
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_lookupPath);
+
+}
+
+/**
+ * FSAL_lookupJunction :
+ * Get the fileset root for a junction.
+ * There is no junction in the object store: this returns
+ * the root directory of the export.
+ *
+ * \param p_junction_handle (input)
+ *        Handle of the junction to be looked up.
+ * \param p_context (input)
+ *        Authentication context for the operation (user,...).
+ * \param p_fsroot_handle (output)
+ *        The handle of root directory of the fileset.
+ * \param p_fsroot_attributes (optional input/output)
+ *        Pointer to the attributes of the root directory
+ *        for the fileset.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        It can be NULL (increases performances).
+ *
+ * \return - ERR_FSAL_NO_ERROR, if no error.
+ *         - Another error code else.
+ *          
+ */
+fsal_status_t OBJSTOREFSAL_lookupJunction(objstorefsal_handle_t * p_junction_handle,      /* IN */
+                                     objstorefsal_op_context_t * p_context,  /* IN */
+                                     objstorefsal_handle_t * p_fsoot_handle, /* OUT */
+                                     fsal_attrib_list_t * p_fsroot_attributes   /* [ IN/OUT ] */
+    )
+{
+  fsal_status_t status;
+
+  /* sanity checks
+   * note : p_fsroot_attributes is optionnal
+   */
+  if(!p_junction_handle || !p_fsoot_handle || !p_context)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_lookupJunction);
+
+  memcpy(p_fsoot_handle, &p_context->export_context->root_handle,
+         sizeof(objstorefsal_handle_t));
+
+  if(p_fsroot_attributes)
+    {
+      status = OBJSTOREFSAL_getattrs(p_fsoot_handle, p_context, p_fsroot_attributes);
+      if(FSAL_IS_ERROR(status))
+        Return(status.major, status.minor, INDEX_FSAL_lookupJunction);
+    }
+
+  /* lookup complete ! */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_lookupJunction);
+}
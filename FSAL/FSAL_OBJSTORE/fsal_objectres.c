@@ -0,0 +1,23 @@
+/*
+ * vim:expandtab:shiftwidth=4:tabstop=4:
+ */
+
+/**
+ * \file    fsal_objectres.c
+ * \author  $Author$
+ * \date    $Date$
+ * \version $Revision$
+ * \brief   FSAL remanent resources management routines.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "fsal.h"
+#include "fsal_internal.h"
+
+fsal_status_t OBJSTOREFSAL_CleanObjectResources(objstorefsal_handle_t * in_fsal_handle)
+{
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_CleanObjectResources);
+
+}
@@ -0,0 +1,365 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ------------- 
+ */
+
+/**
+ *
+ * \file    fsal_rename.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/24 13:45:37 $
+ * \version $Revision: 1.9 $
+ * \brief   object renaming/moving function.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+#include <string.h>
+#include <time.h>
+
+/* tells whether 'p_dir' is 'inode' or one of its subdirectories,
+ * called with the namespace lock held */
+static int rename_is_subdir(objstore_inode_t * p_dir, fsal_u64_t inode)
+{
+  fsal_u64_t current = p_dir->inode, parent;
+  objstore_inode_t *p_inode;
+
+  while(current != inode)
+    {
+      if(current == OBJSTORE_ROOT_INODE)
+        return FALSE;
+
+      if(objstore_inode_get(current, &p_inode) != 0)
+        return FALSE;
+
+      P(p_inode->lock);
+      parent = p_inode->parent;
+      V(p_inode->lock);
+
+      objstore_inode_put(p_inode);
+
+      /* corrupted tree */
+      if(parent == current)
+        return FALSE;
+
+      current = parent;
+    }
+
+  return TRUE;
+}
+
+/**
+ * FSAL_rename:
+ * Change name and/or parent dir of a filesystem object.
+ *
+ * \param old_parentdir_handle (input):
+ *        Source parent directory of the object is to be moved/renamed.
+ * \param p_old_name (input):
+ *        Pointer to the current name of the object to be moved/renamed.
+ * \param new_parentdir_handle (input):
+ *        Target parent directory for the object.
+ * \param p_new_name (input):
+ *        Pointer to the new name for the object.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param src_dir_attributes (optionnal input/output): 
+ *        Post operation attributes for the source directory.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ * \param tgt_dir_attributes (optionnal input/output): 
+ *        Post operation attributes for the target directory.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+
+fsal_status_t OBJSTOREFSAL_rename(objstorefsal_handle_t * p_old_parentdir_handle, /* IN */
+                             fsal_name_t * p_old_name,  /* IN */
+                             objstorefsal_handle_t * p_new_parentdir_handle, /* IN */
+                             fsal_name_t * p_new_name,  /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_attrib_list_t * p_src_dir_attributes, /* [ IN/OUT ] */
+                             fsal_attrib_list_t * p_tgt_dir_attributes  /* [ IN/OUT ] */
+    )
+{
+
+  fsal_status_t status;
+  objstore_inode_t *p_old_dir, *p_new_dir = NULL;
+  objstore_inode_t *p_inode = NULL, *p_target = NULL;
+  fsal_u64_t inode;
+  int rc, is_dir, src_equal_tgt, last = FALSE;
+
+  /* sanity checks.
+   * note : src/tgt_dir_attributes are optional.
+   */
+  if(!p_old_parentdir_handle || !p_new_parentdir_handle
+     || !p_old_name || !p_new_name || !p_context)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_rename);
+
+  if(!strcmp(p_old_name->name, ".") || !strcmp(p_old_name->name, "..")
+     || !strcmp(p_new_name->name, ".") || !strcmp(p_new_name->name, ".."))
+    Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_rename);
+
+  /* get the directories */
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_old_parentdir_handle, &p_old_dir);
+  ReleaseTokenFSCall();
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_rename);
+
+  src_equal_tgt = (p_old_parentdir_handle->data.inode == p_new_parentdir_handle->data.inode);
+
+  if(src_equal_tgt)
+    {
+      p_new_dir = p_old_dir;
+      objstore_inode_ref(p_new_dir);
+    }
+  else
+    {
+      TakeTokenFSCall();
+      status = fsal_internal_getinode(p_new_parentdir_handle, &p_new_dir);
+      ReleaseTokenFSCall();
+      if(FSAL_IS_ERROR(status))
+        {
+          objstore_inode_put(p_old_dir);
+          ReturnStatus(status, INDEX_FSAL_rename);
+        }
+    }
+
+  if(p_old_dir->type != FSAL_TYPE_DIR || p_new_dir->type != FSAL_TYPE_DIR)
+    {
+      status.major = ERR_FSAL_NOTDIR;
+      status.minor = 0;
+      goto release;
+    }
+
+  /* the user must be able to modify both directories */
+  status = fsal_internal_inode_access(p_context, p_old_dir, FSAL_W_OK | FSAL_X_OK);
+  if(!FSAL_IS_ERROR(status) && !src_equal_tgt)
+    status = fsal_internal_inode_access(p_context, p_new_dir, FSAL_W_OK | FSAL_X_OK);
+  if(FSAL_IS_ERROR(status))
+    goto release;
+
+  P_w(&objstore_ns_lock);
+
+  if((rc = objstore_dir_find(p_old_dir, p_old_name->name, &inode)) != 0
+     || (rc = objstore_inode_get(inode, &p_inode)) != 0)
+    goto out;
+
+  is_dir = (p_inode->type == FSAL_TYPE_DIR);
+
+  /* Sticky bit on the source directory => the user who wants to delete the file must own it or its parent dir */
+  if((p_old_dir->mode & S_ISVTX)
+     && p_old_dir->uid != p_context->credential.user
+     && p_inode->uid != p_context->credential.user && p_context->credential.user != 0)
+    {
+      rc = EACCES;
+      goto out;
+    }
+
+  /* check the entry that is replaced, if any */
+  if(objstore_dir_find(p_new_dir, p_new_name->name, &inode) == 0)
+    {
+      if((rc = objstore_inode_get(inode, &p_target)) != 0)
+        goto out;
+
+      /* both names refer to the same object: nothing to do */
+      if(p_target == p_inode)
+        goto out;
+
+      /* Sticky bit on the target directory => the user who wants to create the file must own it or its parent dir */
+      if((p_new_dir->mode & S_ISVTX)
+         && p_new_dir->uid != p_context->credential.user
+         && p_target->uid != p_context->credential.user
+         && p_context->credential.user != 0)
+        rc = EACCES;
+      else if(is_dir && p_target->type != FSAL_TYPE_DIR)
+        rc = ENOTDIR;
+      else if(!is_dir && p_target->type == FSAL_TYPE_DIR)
+        rc = EISDIR;
+      else if(p_target->type == FSAL_TYPE_DIR && p_target->nb_entries > 0)
+        rc = ENOTEMPTY;
+
+      if(rc)
+        goto out;
+    }
+
+  /* a directory cannot be moved into itself */
+  if(is_dir && !src_equal_tgt && rename_is_subdir(p_new_dir, p_inode->inode))
+    {
+      rc = EINVAL;
+      goto out;
+    }
+
+  /*************************************
+   * Rename the file on the filesystem *
+   *************************************/
+
+  if(p_target)
+    objstore_dir_remove(p_new_dir, p_new_name->name);
+
+  if((rc = objstore_dir_add(p_new_dir, p_new_name->name, p_inode->inode)) != 0)
+    {
+      if(p_target)
+        objstore_dir_add(p_new_dir, p_new_name->name, p_target->inode);
+      goto out;
+    }
+
+  objstore_dir_remove(p_old_dir, p_old_name->name);
+
+  /* a replaced directory loses its ".." link to the target directory */
+  if(p_target && p_target->type == FSAL_TYPE_DIR)
+    {
+      P(p_new_dir->lock);
+      p_new_dir->nlink--;
+      V(p_new_dir->lock);
+    }
+
+  if(is_dir && !src_equal_tgt)
+    {
+      P(p_old_dir->lock);
+      p_old_dir->nlink--;
+      V(p_old_dir->lock);
+
+      P(p_new_dir->lock);
+      p_new_dir->nlink++;
+      V(p_new_dir->lock);
+    }
+
+  P(p_inode->lock);
+  if(is_dir)
+    p_inode->parent = p_new_dir->inode;
+  p_inode->ctime = time(NULL);
+  p_inode->meta_dirty = TRUE;
+  V(p_inode->lock);
+
+  /* the target directory is stored first: a failure may leave
+   * the object in both directories, but never in none of them.
+   * Whatever is not stored is flushed later. */
+  rc = objstore_inode_store(p_new_dir);
+
+  if(rc == 0 && !src_equal_tgt)
+    rc = objstore_inode_store(p_old_dir);
+
+  if(rc == 0)
+    rc = objstore_inode_store(p_inode);
+
+  /* drop the link of the replaced object */
+  if(p_target)
+    {
+      P(p_target->lock);
+      if(p_target->type == FSAL_TYPE_DIR || p_target->nlink <= 1)
+        last = TRUE;
+      else
+        {
+          p_target->nlink--;
+          p_target->ctime = time(NULL);
+          p_target->meta_dirty = TRUE;
+        }
+      V(p_target->lock);
+
+      if(!last)
+        objstore_inode_store(p_target);
+    }
+
+ out:
+  V_w(&objstore_ns_lock);
+
+  if(last)
+    {
+      /* same order as in unlink */
+      int rc2 = objstore_inode_destroy(p_target);
+      int rc3 = (p_target->type == FSAL_TYPE_FILE ? objstore_cache_remove(p_target) : 0);
+
+      if(rc2 == 0)
+        rc2 = rc3;
+
+      if(rc2)
+        LogCrit(COMPONENT_FSAL,
+                "Could not remove object %llu from the store: error %d",
+                (unsigned long long)p_target->inode, rc2);
+    }
+
+  if(p_target)
+    objstore_inode_put(p_target);
+  if(p_inode)
+    objstore_inode_put(p_inode);
+
+  status.major = (rc ? posix2fsal_error(rc) : ERR_FSAL_NO_ERROR);
+  status.minor = rc;
+
+ release:
+  objstore_inode_put(p_new_dir);
+  objstore_inode_put(p_old_dir);
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_rename);
+
+  /***********************
+   * Fill the attributes *
+   ***********************/
+
+  if(p_src_dir_attributes)
+    {
+
+      status = OBJSTOREFSAL_getattrs(p_old_parentdir_handle, p_context, p_src_dir_attributes);
+
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_src_dir_attributes->asked_attributes);
+          FSAL_SET_MASK(p_src_dir_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+
+    }
+
+  if(p_tgt_dir_attributes)
+    {
+
+      status = OBJSTOREFSAL_getattrs(p_new_parentdir_handle, p_context, p_tgt_dir_attributes);
+
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_tgt_dir_attributes->asked_attributes);
+          FSAL_SET_MASK(p_tgt_dir_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+
+    }
+
+  /* OK */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_rename);
+
+}
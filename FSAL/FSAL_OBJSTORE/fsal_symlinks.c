@@ -0,0 +1,214 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ------------- 
+ */
+
+/**
+ * \file    fsal_symlinks.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2005/07/29 09:39:04 $
+ * \version $Revision: 1.15 $
+ * \brief   symlinks operations.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+#include <string.h>
+
+/**
+ * FSAL_readlink:
+ * Read the content of a symbolic link.
+ *
+ * \param linkhandle (input):
+ *        Handle of the link to be read.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param p_link_content (output):
+ *        Pointer to an fsal path structure where
+ *        the link content is to be stored..
+ * \param link_attributes (optionnal input/output): 
+ *        The post operation attributes of the symlink link.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_readlink(objstorefsal_handle_t * p_linkhandle, /* IN */
+                               objstorefsal_op_context_t * p_context,        /* IN */
+                               fsal_path_t * p_link_content,    /* OUT */
+                               fsal_attrib_list_t * p_link_attributes   /* [ IN/OUT ] */
+    )
+{
+
+  fsal_status_t status;
+  objstore_inode_t *p_inode;
+  char link_content_out[FSAL_MAX_PATH_LEN];
+
+  /* sanity checks.
+   * note : link_attributes is optional.
+   */
+  if(!p_linkhandle || !p_context || !p_link_content)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_readlink);
+
+  memset(link_content_out, 0, FSAL_MAX_PATH_LEN);
+
+  /* Read the link from its index object */
+
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_linkhandle, &p_inode);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_readlink);
+
+  if(p_inode->type != FSAL_TYPE_LNK)
+    {
+      objstore_inode_put(p_inode);
+      Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_readlink);
+    }
+
+  P(p_inode->lock);
+  if(p_inode->link)
+    strncpy(link_content_out, p_inode->link, FSAL_MAX_PATH_LEN - 1);
+  V(p_inode->lock);
+
+  /* retrieves object attributes, if asked */
+
+  if(p_link_attributes)
+    {
+
+      status = objstore2fsal_attributes(p_inode, p_link_attributes);
+
+      /* On error, we set a flag in the returned attributes */
+
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_link_attributes->asked_attributes);
+          FSAL_SET_MASK(p_link_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+
+    }
+
+  objstore_inode_put(p_inode);
+
+  /* convert char * to fsal_path_t */
+  status = FSAL_str2path(link_content_out, FSAL_MAX_PATH_LEN, p_link_content);
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_readlink);
+
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_readlink);
+
+}
+
+/**
+ * FSAL_symlink:
+ * Create a symbolic link.
+ *
+ * \param parent_directory_handle (input):
+ *        Handle of the parent directory where the link is to be created.
+ * \param p_linkname (input):
+ *        Name of the link to be created.
+ * \param p_linkcontent (input):
+ *        Content of the link to be created.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param accessmode (ignored input):
+ *        Mode of the link to be created.
+ *        It has no sense in HPSS nor UNIX filesystems.
+ * \param link_handle (output):
+ *        Pointer to the handle of the created symlink.
+ * \param link_attributes (optionnal input/output): 
+ *        Attributes of the newly created symlink.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+fsal_status_t OBJSTOREFSAL_symlink(objstorefsal_handle_t * p_parent_directory_handle,     /* IN */
+                              fsal_name_t * p_linkname, /* IN */
+                              fsal_path_t * p_linkcontent,      /* IN */
+                              objstorefsal_op_context_t * p_context, /* IN */
+                              fsal_accessmode_t accessmode,     /* IN (ignored) */
+                              objstorefsal_handle_t * p_link_handle, /* OUT */
+                              fsal_attrib_list_t * p_link_attributes    /* [ IN/OUT ] */
+    )
+{
+
+  fsal_status_t status;
+
+  /* sanity checks.
+   * note : link_attributes is optional.
+   */
+  if(!p_parent_directory_handle || !p_context ||
+     !p_link_handle || !p_linkname || !p_linkcontent)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_symlink);
+
+  /* Tests if symlinking is allowed by configuration. */
+
+  if(!global_fs_info.symlink_support)
+    Return(ERR_FSAL_NOTSUPP, 0, INDEX_FSAL_symlink);
+
+  /* the content of the link is kept in its index object */
+  TakeTokenFSCall();
+  status = fsal_internal_create(p_parent_directory_handle, p_linkname, p_context,
+                                FSAL_TYPE_LNK, 0777, p_linkcontent->path, p_link_handle);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_symlink);
+
+  /* get attributes if asked */
+
+  if(p_link_attributes)
+    {
+
+      status = OBJSTOREFSAL_getattrs(p_link_handle, p_context, p_link_attributes);
+
+      /* On error, we set a flag in the returned attributes */
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_link_attributes->asked_attributes);
+          FSAL_SET_MASK(p_link_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+
+    }
+
+  /* OK */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_symlink);
+}
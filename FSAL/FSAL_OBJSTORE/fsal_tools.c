@@ -0,0 +1,879 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ------------- 
+ */
+
+/**
+ * \file    fsal_tools.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/17 14:20:07 $
+ * \version $Revision: 1.26 $
+ * \brief   miscelaneous FSAL tools.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+#include "config_parsing.h"
+#include <string.h>
+
+/* case unsensitivity */
+#define STRCMP   strcasecmp
+
+char *OBJSTOREFSAL_GetFSName()
+{
+  return "OBJSTORE";
+}
+
+/** 
+ * FSAL_handlecmp:
+ * Compare 2 handles.
+ *
+ * \param handle1 (input):
+ *        The first handle to be compared.
+ * \param handle2 (input):
+ *        The second handle to be compared.
+ * \param status (output):
+ *        The status of the compare operation.
+ *
+ * \return - 0 if handles are the same.
+ *         - A non null value else.
+ *         - Segfault if status is a NULL pointer.
+ */
+
+int OBJSTOREFSAL_handlecmp(objstorefsal_handle_t * handle1, objstorefsal_handle_t * handle2,
+                      fsal_status_t * status)
+{
+
+  *status = FSAL_STATUS_NO_ERROR;
+
+  if(!handle1 || !handle2)
+    {
+      status->major = ERR_FSAL_FAULT;
+      return -1;
+    }
+
+  if(handle1->data.inode != handle2->data.inode)
+    return 1;
+
+  return (handle1->data.type != handle2->data.type);
+}
+
+/**
+ * FSAL_Handle_to_HashIndex
+ * This function is used for hashing a FSAL handle
+ * in order to dispatch entries into the hash table array.
+ *
+ * \param p_handle      The handle to be hashed
+ * \param cookie        Makes it possible to have different hash value for the
+ *                      same handle, when cookie changes.
+ * \param alphabet_len  Parameter for polynomial hashing algorithm
+ * \param index_size    The range of hash value will be [0..index_size-1]
+ *
+ * \return The hash value
+ */
+unsigned int OBJSTOREFSAL_Handle_to_HashIndex(objstorefsal_handle_t * p_handle,
+                                         unsigned int cookie,
+                                         unsigned int alphabet_len,
+                                         unsigned int index_size)
+{
+  unsigned int h;
+
+  h = (cookie * alphabet_len + ((unsigned int)p_handle->data.inode ^
+                                (unsigned int)(p_handle->data.inode >> 32)));
+  return (3 * h + 1999) % index_size;
+}
+
+/*
+ * FSAL_Handle_to_RBTIndex
+ * This function is used for generating a RBT node ID
+ * in order to identify entries into the RBT.
+ *
+ * \param p_handle      The handle to be hashed
+ * \param cookie        Makes it possible to have different hash value for the
+ *                      same handle, when cookie changes.
+ *
+ * \return The hash value
+ */
+
+unsigned int OBJSTOREFSAL_Handle_to_RBTIndex(objstorefsal_handle_t * p_handle, unsigned int cookie)
+{
+#define MAGIC   0xABCD1234
+  unsigned int h;
+
+  h = (cookie ^ (unsigned int)p_handle->data.inode ^
+       (unsigned int)(p_handle->data.inode >> 32) ^ MAGIC);
+  return h;
+}
+
+/**
+ * FSAL_DigestHandle :
+ *  Convert an objstorefsal_handle_t to a buffer
+ *  to be included into NFS handles,
+ *  or another digest.
+ *
+ * \param output_type (input):
+ *        Indicates the type of digest to do.
+ * \param in_fsal_handle (input):
+ *        The handle to be converted to digest.
+ * \param out_buff (output):
+ *        The buffer where the digest is to be stored.
+ *
+ * \return The major code is ERR_FSAL_NO_ERROR is no error occured.
+ *         Else, it is a non null value.
+ */
+fsal_status_t OBJSTOREFSAL_DigestHandle(objstorefsal_export_context_t * p_expcontext,     /* IN */
+                                   fsal_digesttype_t output_type,       /* IN */
+                                   objstorefsal_handle_t * p_in_fsal_handle, /* IN */
+                                   caddr_t out_buff     /* OUT */
+    )
+{
+  unsigned int ino32;
+
+  /* sanity checks */
+  if(!p_in_fsal_handle || !out_buff || !p_expcontext)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  switch (output_type)
+    {
+
+      /* NFS handle digest */
+    case FSAL_DIGEST_NFSV2:
+
+      if(sizeof(p_in_fsal_handle->data) > FSAL_DIGEST_SIZE_HDLV2)
+        ReturnCode(ERR_FSAL_TOOSMALL, 0);
+
+      memset(out_buff, 0, FSAL_DIGEST_SIZE_HDLV2);
+      memcpy(out_buff, &(p_in_fsal_handle->data), sizeof(p_in_fsal_handle->data));
+      break;
+
+    case FSAL_DIGEST_NFSV3:
+
+      if(sizeof(p_in_fsal_handle->data) > FSAL_DIGEST_SIZE_HDLV3)
+        ReturnCode(ERR_FSAL_TOOSMALL, 0);
+
+      memset(out_buff, 0, FSAL_DIGEST_SIZE_HDLV3);
+      memcpy(out_buff, &(p_in_fsal_handle->data), sizeof(p_in_fsal_handle->data));
+      break;
+
+    case FSAL_DIGEST_NFSV4:
+
+      if(sizeof(p_in_fsal_handle->data) > FSAL_DIGEST_SIZE_HDLV4)
+        ReturnCode(ERR_FSAL_TOOSMALL, 0);
+
+      memset(out_buff, 0, FSAL_DIGEST_SIZE_HDLV4);
+      memcpy(out_buff, &(p_in_fsal_handle->data), sizeof(p_in_fsal_handle->data));
+      break;
+
+      /* FileId digest for NFSv2 */
+    case FSAL_DIGEST_FILEID2:
+
+      ino32 = low32m(p_in_fsal_handle->data.inode);
+
+      /* sanity check about output size */
+      memset(out_buff, 0, FSAL_DIGEST_SIZE_FILEID2);
+      memcpy(out_buff, &ino32, sizeof(int));
+
+      break;
+
+      /* FileId digest for NFSv3 */
+    case FSAL_DIGEST_FILEID3:
+
+      /* sanity check about output size */
+      memset(out_buff, 0, FSAL_DIGEST_SIZE_FILEID3);
+      memcpy(out_buff, &(p_in_fsal_handle->data.inode), sizeof(fsal_u64_t));
+      break;
+
+      /* FileId digest for NFSv4 */
+    case FSAL_DIGEST_FILEID4:
+
+      memset(out_buff, 0, FSAL_DIGEST_SIZE_FILEID4);
+      memcpy(out_buff, &(p_in_fsal_handle->data.inode), sizeof(fsal_u64_t));
+      break;
+
+    default:
+      ReturnCode(ERR_FSAL_SERVERFAULT, 0);
+
+    }
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+
+}
+
+/**
+ * FSAL_ExpandHandle :
+ *  Convert a buffer extracted from NFS handles
+ *  to an FSAL handle.
+ *
+ * \param in_type (input):
+ *        Indicates the type of digest to be expanded.
+ * \param in_buff (input):
+ *        Pointer to the digest to be expanded.
+ * \param out_fsal_handle (output):
+ *        The handle built from digest.
+ *
+ * \return The major code is ERR_FSAL_NO_ERROR is no error occured.
+ *         Else, it is a non null value.
+ */
+fsal_status_t OBJSTOREFSAL_ExpandHandle(objstorefsal_export_context_t * p_expcontext,     /* IN */
+                                   fsal_digesttype_t in_type,   /* IN */
+                                   caddr_t in_buff,     /* IN */
+                                   objstorefsal_handle_t * p_out_fsal_handle /* OUT */
+    )
+{
+  /* sanity checks */
+  if(!p_out_fsal_handle || !in_buff || !p_expcontext)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  switch (in_type)
+    {
+
+      /* NFSV2 handle digest */
+    case FSAL_DIGEST_NFSV2:
+      memset(p_out_fsal_handle, 0, sizeof(objstorefsal_handle_t));
+      memcpy(&(p_out_fsal_handle->data), in_buff, sizeof(p_out_fsal_handle->data));
+      break;
+
+      /* NFSV3 handle digest */
+    case FSAL_DIGEST_NFSV3:
+      memset(p_out_fsal_handle, 0, sizeof(objstorefsal_handle_t));
+      memcpy(&(p_out_fsal_handle->data), in_buff, sizeof(p_out_fsal_handle->data));
+      break;
+
+      /* NFSV4 handle digest */
+    case FSAL_DIGEST_NFSV4:
+      memset(p_out_fsal_handle, 0, sizeof(objstorefsal_handle_t));
+      memcpy(&(p_out_fsal_handle->data), in_buff, sizeof(p_out_fsal_handle->data));
+      break;
+
+    default:
+      ReturnCode(ERR_FSAL_SERVERFAULT, 0);
+    }
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+
+}
+
+/**
+ * Those routines set the default parameters
+ * for FSAL init structure.
+ * \return ERR_FSAL_NO_ERROR (no error) ,
+ *         ERR_FSAL_FAULT (null pointer given as parameter),
+ *         ERR_FSAL_SERVERFAULT (unexpected error)
+ */
+fsal_status_t OBJSTOREFSAL_SetDefault_FSAL_parameter(fsal_parameter_t * out_parameter)
+{
+  /* defensive programming... */
+  if(out_parameter == NULL)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  /* init max FS calls = unlimited */
+  out_parameter->fsal_info.max_fs_calls = 0;
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+
+}
+
+fsal_status_t OBJSTOREFSAL_SetDefault_FS_common_parameter(fsal_parameter_t * out_parameter)
+{
+  /* defensive programming... */
+  if(out_parameter == NULL)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  /* set default values for all parameters of fs_common_info */
+
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, maxfilesize);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, maxlink);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, maxnamelen);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, maxpathlen);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, no_trunc);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, chown_restricted);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, case_insensitive);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, case_preserving);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, fh_expire_type);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, link_support);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, symlink_support);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, lock_support);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, named_attr);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, unique_handles);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, lease_time);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, acl_support);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, cansettime);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, homogenous);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, supported_attrs);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, maxread);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, maxwrite);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, umask);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, auth_exportpath_xdev);
+  FSAL_SET_INIT_DEFAULT(out_parameter->fs_common_info, xattr_access_rights);
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+
+}
+
+fsal_status_t OBJSTOREFSAL_SetDefault_FS_specific_parameter(fsal_parameter_t * out_parameter)
+{
+  /* defensive programming... */
+  if(out_parameter == NULL)
+    ReturnCode(ERR_FSAL_FAULT, 0);
+
+  /* set default values for all parameters of fs_specific_info */
+
+  strcpy(out_parameter->fs_specific_info.host, "localhost");
+  out_parameter->fs_specific_info.port = 80;
+  strcpy(out_parameter->fs_specific_info.bucket, "ganesha");
+  out_parameter->fs_specific_info.key_prefix[0] = '\0';
+  out_parameter->fs_specific_info.access_key_id[0] = '\0';   /* unsigned requests */
+  out_parameter->fs_specific_info.secret_access_key[0] = '\0';
+  out_parameter->fs_specific_info.timeout = 30;
+
+  out_parameter->fs_specific_info.chunk_size = OBJSTORE_DEFAULT_CHUNK_SIZE;
+
+  strcpy(out_parameter->fs_specific_info.cache_dir, "/var/ganesha/objstore_cache");
+  out_parameter->fs_specific_info.cache_size = 1024LL * 1024LL * 1024LL;        /* 1GB */
+  out_parameter->fs_specific_info.io_threads = 4;
+  out_parameter->fs_specific_info.flush_delay = 5;
+  out_parameter->fs_specific_info.flush_on_close = FALSE;
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+
+}
+
+/**
+ * FSAL_load_FSAL_parameter_from_conf,
+ * FSAL_load_FS_common_parameter_from_conf,
+ * FSAL_load_FS_specific_parameter_from_conf:
+ *
+ * Those functions initialize the FSAL init parameter
+ * structure from a configuration structure.
+ *
+ * \param in_config (input):
+ *        Structure that represents the parsed configuration file.
+ * \param out_parameter (ouput)
+ *        FSAL initialization structure filled according
+ *        to the configuration file given as parameter.
+ *
+ * \return ERR_FSAL_NO_ERROR (no error) ,
+ *         ERR_FSAL_NOENT (missing a mandatory stanza in config file),
+ *         ERR_FSAL_INVAL (invalid parameter),
+ *         ERR_FSAL_SERVERFAULT (unexpected error)
+ *         ERR_FSAL_FAULT (null pointer given as parameter),
+ */
+
+/* load FSAL init info */
+
+fsal_status_t OBJSTOREFSAL_load_FSAL_parameter_from_conf(config_file_t in_config,
+                                                    fsal_parameter_t * out_parameter)
+{
+  int err;
+  int var_max, var_index;
+  char *key_name;
+  char *key_value;
+  config_item_t block;
+
+  int DebugLevel = -1;
+  char *LogFile = NULL;
+
+  block = config_FindItemByName(in_config, CONF_LABEL_FSAL);
+
+  /* cannot read item */
+
+  if(block == NULL)
+    {
+      LogCrit(COMPONENT_FSAL, "FSAL LOAD PARAMETER: Cannot read item \"%s\" from configuration file",
+                 CONF_LABEL_FSAL);
+      ReturnCode(ERR_FSAL_NOENT, 0);
+    }
+  else if(config_ItemType(block) != CONFIG_ITEM_BLOCK)
+    {
+      LogCrit(COMPONENT_FSAL,"FSAL LOAD PARAMETER: Item \"%s\" is expected to be a block",
+                 CONF_LABEL_FSAL);
+      ReturnCode(ERR_FSAL_INVAL, 0);
+    }
+
+  /* read variable for fsal init */
+
+  var_max = config_GetNbItems(block);
+
+  for(var_index = 0; var_index < var_max; var_index++)
+    {
+      config_item_t item;
+
+      item = config_GetItemByIndex(block, var_index);
+
+      err = config_GetKeyValue(item, &key_name, &key_value);
+      if(err)
+        {
+          LogCrit(COMPONENT_FSAL,
+              "FSAL LOAD PARAMETER: ERROR reading key[%d] from section \"%s\" of configuration file.",
+               var_index, CONF_LABEL_FSAL);
+          ReturnCode(ERR_FSAL_SERVERFAULT, err);
+        }
+
+      if(!STRCMP(key_name, "DebugLevel"))
+        {
+          DebugLevel = ReturnLevelAscii(key_value);
+
+          if(DebugLevel == -1)
+            {
+              LogCrit(COMPONENT_FSAL,"FSAL LOAD PARAMETER: ERROR: Invalid debug level name: \"%s\".",
+                         key_value);
+              ReturnCode(ERR_FSAL_INVAL, -1);
+            }
+
+        }
+      else if(!STRCMP(key_name, "LogFile"))
+        {
+
+          LogFile = key_value;
+
+        }
+      else if(!STRCMP(key_name, "Max_FS_calls"))
+        {
+
+          int maxcalls = s_read_int(key_value);
+
+          if(maxcalls < 0)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: null or positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          out_parameter->fsal_info.max_fs_calls = (unsigned int)maxcalls;
+
+        }
+      else
+        {
+          LogCrit(COMPONENT_FSAL,
+              "FSAL LOAD PARAMETER: ERROR: Unknown or unsettable key: %s (item %s)",
+               key_name, CONF_LABEL_FSAL);
+          ReturnCode(ERR_FSAL_INVAL, 0);
+        }
+
+    }
+
+  /* init logging */
+
+  if(LogFile)
+    SetComponentLogFile(COMPONENT_FSAL, LogFile);
+
+  if(DebugLevel > -1)
+    SetComponentLogLevel(COMPONENT_FSAL, DebugLevel);
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+}                               /* FSAL_load_FSAL_parameter_from_conf */
+
+/* load general filesystem configuration options */
+
+fsal_status_t OBJSTOREFSAL_load_FS_common_parameter_from_conf(config_file_t in_config,
+                                                         fsal_parameter_t * out_parameter)
+{
+  int err;
+  int var_max, var_index;
+  char *key_name;
+  char *key_value;
+  config_item_t block;
+
+  block = config_FindItemByName(in_config, CONF_LABEL_FS_COMMON);
+
+  /* cannot read item */
+  if(block == NULL)
+    {
+      LogCrit(COMPONENT_FSAL,"FSAL LOAD PARAMETER: Cannot read item \"%s\" from configuration file",
+                 CONF_LABEL_FS_COMMON);
+      ReturnCode(ERR_FSAL_NOENT, 0);
+    }
+  else if(config_ItemType(block) != CONFIG_ITEM_BLOCK)
+    {
+      LogCrit(COMPONENT_FSAL,"FSAL LOAD PARAMETER: Item \"%s\" is expected to be a block",
+                 CONF_LABEL_FS_COMMON);
+      ReturnCode(ERR_FSAL_INVAL, 0);
+    }
+
+  /*
+     configurable common info for filesystem are:
+     link_support      # hardlink support
+     symlink_support   # symlinks support
+     cansettime        # Is it possible to change file times
+     maxread           # Max read size from FS
+     maxwrite          # Max write size to FS
+     umask
+     auth_exportpath_xdev
+     xattr_access_rights
+
+   */
+
+  var_max = config_GetNbItems(block);
+
+  for(var_index = 0; var_index < var_max; var_index++)
+    {
+      config_item_t item;
+
+      item = config_GetItemByIndex(block, var_index);
+
+      err = config_GetKeyValue(item, &key_name, &key_value);
+      if(err)
+        {
+          LogCrit(COMPONENT_FSAL,
+              "FSAL LOAD PARAMETER: ERROR reading key[%d] from section \"%s\" of configuration file.",
+               var_index, CONF_LABEL_FS_COMMON);
+          ReturnCode(ERR_FSAL_SERVERFAULT, err);
+        }
+
+      /* does the variable exists ? */
+      if(!STRCMP(key_name, "link_support"))
+        {
+
+          int bool = StrToBoolean(key_value);
+
+          if(bool == -1)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: 0 or 1 expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          /* if set to false, force value to false.
+           * else keep fs default.
+           */
+          FSAL_SET_INIT_INFO(out_parameter->fs_common_info, link_support,
+                             FSAL_INIT_MAX_LIMIT, bool);
+
+        }
+      else if(!STRCMP(key_name, "symlink_support"))
+        {
+          int bool = StrToBoolean(key_value);
+
+          if(bool == -1)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: 0 or 1 expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          /* if set to false, force value to false.
+           * else keep fs default.
+           */
+          FSAL_SET_INIT_INFO(out_parameter->fs_common_info, symlink_support,
+                             FSAL_INIT_MAX_LIMIT, bool);
+        }
+      else if(!STRCMP(key_name, "cansettime"))
+        {
+          int bool = StrToBoolean(key_value);
+
+          if(bool == -1)
+            {
+              LogCrit(COMPONENT_FSAL,
+		"FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: 0 or 1 expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          /* if set to false, force value to false.
+           * else keep fs default.
+           */
+          FSAL_SET_INIT_INFO(out_parameter->fs_common_info, cansettime,
+                             FSAL_INIT_MAX_LIMIT, bool);
+
+        }
+      else if(!STRCMP(key_name, "maxread"))
+        {
+          fsal_u64_t size;
+
+          if(s_read_int64(key_value, &size))
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          FSAL_SET_INIT_INFO(out_parameter->fs_common_info, maxread,
+                             FSAL_INIT_FORCE_VALUE, size);
+
+        }
+      else if(!STRCMP(key_name, "maxwrite"))
+        {
+          fsal_u64_t size;
+
+          if(s_read_int64(key_value, &size))
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          FSAL_SET_INIT_INFO(out_parameter->fs_common_info, maxwrite,
+                             FSAL_INIT_FORCE_VALUE, size);
+
+        }
+      else if(!STRCMP(key_name, "umask"))
+        {
+          int mode = s_read_octal(key_value);
+
+          if(mode < 0)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: octal expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          FSAL_SET_INIT_INFO(out_parameter->fs_common_info, umask,
+                             FSAL_INIT_FORCE_VALUE, unix2fsal_mode(mode));
+
+        }
+      else if(!STRCMP(key_name, "auth_xdev_export"))
+        {
+          int bool = StrToBoolean(key_value);
+
+          if(bool == -1)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: boolean expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          FSAL_SET_INIT_INFO(out_parameter->fs_common_info, auth_exportpath_xdev,
+                             FSAL_INIT_FORCE_VALUE, bool);
+        }
+      else if(!STRCMP(key_name, "xattr_access_rights"))
+        {
+          int mode = s_read_octal(key_value);
+
+          if(mode < 0)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: octal expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          FSAL_SET_INIT_INFO(out_parameter->fs_common_info, xattr_access_rights,
+                             FSAL_INIT_FORCE_VALUE, unix2fsal_mode(mode));
+
+        }
+      else
+        {
+          LogCrit(COMPONENT_FSAL,
+              "FSAL LOAD PARAMETER: ERROR: Unknown or unsettable key: %s (item %s)",
+               key_name, CONF_LABEL_FS_COMMON);
+          ReturnCode(ERR_FSAL_INVAL, 0);
+        }
+
+    }
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+
+}                               /* FSAL_load_FS_common_parameter_from_conf */
+
+/* load specific filesystem configuration options */
+
+fsal_status_t OBJSTOREFSAL_load_FS_specific_parameter_from_conf(config_file_t in_config,
+                                                           fsal_parameter_t *
+                                                           out_parameter)
+{
+  int err;
+  int var_max, var_index;
+  char *key_name;
+  char *key_value;
+  config_item_t block;
+
+  block = config_FindItemByName(in_config, CONF_LABEL_FS_SPECIFIC);
+
+  /* cannot read item */
+  if(block == NULL)
+    {
+      LogCrit(COMPONENT_FSAL,"FSAL LOAD PARAMETER: Cannot read item \"%s\" from configuration file",
+                 CONF_LABEL_FS_SPECIFIC);
+      ReturnCode(ERR_FSAL_NOENT, 0);
+    }
+  else if(config_ItemType(block) != CONFIG_ITEM_BLOCK)
+    {
+      LogCrit(COMPONENT_FSAL,"FSAL LOAD PARAMETER: Item \"%s\" is expected to be a block",
+                 CONF_LABEL_FS_SPECIFIC);
+      ReturnCode(ERR_FSAL_INVAL, 0);
+    }
+
+  /* makes an iteration on the (key, value) couplets */
+
+  var_max = config_GetNbItems(block);
+
+  for(var_index = 0; var_index < var_max; var_index++)
+    {
+      config_item_t item;
+
+      item = config_GetItemByIndex(block, var_index);
+
+      err = config_GetKeyValue(item, &key_name, &key_value);
+      if(err)
+        {
+          LogCrit(COMPONENT_FSAL,
+              "FSAL LOAD PARAMETER: ERROR reading key[%d] from section \"%s\" of configuration file.",
+               var_index, CONF_LABEL_FS_SPECIFIC);
+          ReturnCode(ERR_FSAL_SERVERFAULT, err);
+        }
+
+      /* what parameter is it ? */
+
+      if(!STRCMP(key_name, "Host"))
+        {
+          strncpy(out_parameter->fs_specific_info.host, key_value, MAXHOSTNAMELEN - 1);
+        }
+      else if(!STRCMP(key_name, "Port"))
+        {
+          int port = s_read_int(key_value);
+
+          if(port <= 0 || port > 65535)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: port number expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.port = (unsigned short)port;
+        }
+      else if(!STRCMP(key_name, "Bucket"))
+        {
+          strncpy(out_parameter->fs_specific_info.bucket, key_value, MAXNAMLEN - 1);
+        }
+      else if(!STRCMP(key_name, "Key_Prefix"))
+        {
+          strncpy(out_parameter->fs_specific_info.key_prefix, key_value, MAXNAMLEN - 1);
+        }
+      else if(!STRCMP(key_name, "Access_Key_Id"))
+        {
+          strncpy(out_parameter->fs_specific_info.access_key_id, key_value, MAXNAMLEN - 1);
+        }
+      else if(!STRCMP(key_name, "Secret_Access_Key"))
+        {
+          strncpy(out_parameter->fs_specific_info.secret_access_key, key_value,
+                  MAXNAMLEN - 1);
+        }
+      else if(!STRCMP(key_name, "Timeout"))
+        {
+          int timeout = s_read_int(key_value);
+
+          if(timeout <= 0)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.timeout = (unsigned int)timeout;
+        }
+      else if(!STRCMP(key_name, "Chunk_Size"))
+        {
+          fsal_u64_t size;
+
+          /* must not change once the bucket is formatted */
+          if(s_read_int64(key_value, &size) || size == 0)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.chunk_size = size;
+        }
+      else if(!STRCMP(key_name, "Cache_Dir"))
+        {
+          strncpy(out_parameter->fs_specific_info.cache_dir, key_value, MAXPATHLEN - 1);
+        }
+      else if(!STRCMP(key_name, "Cache_Size"))
+        {
+          fsal_u64_t size;
+
+          if(s_read_int64(key_value, &size) || size == 0)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.cache_size = size;
+        }
+      else if(!STRCMP(key_name, "IO_Threads"))
+        {
+          int nb_threads = s_read_int(key_value);
+
+          if(nb_threads <= 0)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.io_threads = (unsigned int)nb_threads;
+        }
+      else if(!STRCMP(key_name, "Flush_Delay"))
+        {
+          /* 0 uploads the dirty chunks as soon as possible */
+          int delay = s_read_int(key_value);
+
+          if(delay < 0)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: null or positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.flush_delay = (unsigned int)delay;
+        }
+      else if(!STRCMP(key_name, "Flush_On_Close"))
+        {
+          int bool = StrToBoolean(key_value);
+
+          if(bool == -1)
+            {
+              LogCrit(COMPONENT_FSAL,
+                  "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: boolean expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.flush_on_close = bool;
+        }
+      else
+        {
+          LogCrit(COMPONENT_FSAL,
+              "FSAL LOAD PARAMETER: ERROR: Unknown or unsettable key: %s (item %s)",
+               key_name, CONF_LABEL_FS_SPECIFIC);
+          ReturnCode(ERR_FSAL_INVAL, 0);
+        }
+
+    }
+
+  ReturnCode(ERR_FSAL_NO_ERROR, 0);
+
+}                               /* FSAL_load_FS_specific_parameter_from_conf */
@@ -0,0 +1,131 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ------------- 
+ */
+
+/**
+ *
+ * \file    fsal_truncate.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2005/07/29 09:39:05 $
+ * \version $Revision: 1.4 $
+ * \brief   Truncate function.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+
+/**
+ * FSAL_truncate:
+ * Modify the data length of a regular file.
+ *
+ * \param filehandle (input):
+ *        Handle of the file is to be truncated.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param length (input):
+ *        The new data length for the file.
+ * \param object_attributes (optionnal input/output): 
+ *        The post operation attributes of the file.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occurred.
+ */
+
+fsal_status_t OBJSTOREFSAL_truncate(objstorefsal_handle_t * p_filehandle, /* IN */
+                               objstorefsal_op_context_t * p_context,        /* IN */
+                               fsal_size_t length,      /* IN */
+                               objstorefsal_file_t * file_descriptor,        /* Unused in this FSAL */
+                               fsal_attrib_list_t * p_object_attributes /* [ IN/OUT ] */
+    )
+{
+
+  int rc;
+  fsal_status_t st;
+  objstore_inode_t *p_inode;
+
+  /* sanity checks.
+   * note : object_attributes is optional.
+   */
+  if(!p_filehandle || !p_context)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_truncate);
+
+  /* get the file */
+  TakeTokenFSCall();
+  st = fsal_internal_getinode(p_filehandle, &p_inode);
+  ReleaseTokenFSCall();
+
+  if(FSAL_IS_ERROR(st))
+    ReturnStatus(st, INDEX_FSAL_truncate);
+
+  if(p_inode->type != FSAL_TYPE_FILE)
+    {
+      objstore_inode_put(p_inode);
+      Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_truncate);
+    }
+
+  /* the chunks after the new end of file are removed from the cache
+   * and from the store, the size is stored in the index object */
+
+  TakeTokenFSCall();
+  rc = objstore_cache_truncate(p_inode, length);
+  ReleaseTokenFSCall();
+
+  /* convert return code */
+  if(rc)
+    {
+      objstore_inode_put(p_inode);
+      Return(posix2fsal_error(rc), rc, INDEX_FSAL_truncate);
+    }
+
+  /* Optionally retrieve attributes */
+  if(p_object_attributes)
+    {
+
+      st = objstore2fsal_attributes(p_inode, p_object_attributes);
+
+      if(FSAL_IS_ERROR(st))
+        {
+          FSAL_CLEAR_MASK(p_object_attributes->asked_attributes);
+          FSAL_SET_MASK(p_object_attributes->asked_attributes, FSAL_ATTR_RDATTR_ERR);
+        }
+
+    }
+
+  objstore_inode_put(p_inode);
+
+  /* No error occurred */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_truncate);
+
+}
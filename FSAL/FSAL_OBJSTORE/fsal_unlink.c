@@ -0,0 +1,215 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ------------- 
+ */
+
+/**
+ *
+ * \file    fsal_unlink.c
+ * \author  $Author: leibovic $
+ * \date    $Date: 2006/01/24 13:45:37 $
+ * \version $Revision: 1.9 $
+ * \brief   object removing function.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_convert.h"
+#include <time.h>
+
+/**
+ * FSAL_unlink:
+ * Remove a filesystem object .
+ *
+ * \param parentdir_handle (input):
+ *        Handle of the parent directory of the object to be deleted.
+ * \param p_object_name (input):
+ *        Name of the object to be removed.
+ * \param cred (input):
+ *        Authentication context for the operation (user,...).
+ * \param parentdir_attributes (optionnal input/output): 
+ *        Post operation attributes of the parent directory.
+ *        As input, it defines the attributes that the caller
+ *        wants to retrieve (by positioning flags into this structure)
+ *        and the output is built considering this input
+ *        (it fills the structure according to the flags it contains).
+ *        May be NULL.
+ *
+ * \return Major error codes :
+ *        - ERR_FSAL_NO_ERROR     (no error)
+ *        - Another error code if an error occured.
+ */
+
+fsal_status_t OBJSTOREFSAL_unlink(objstorefsal_handle_t * p_parent_directory_handle,      /* IN */
+                             fsal_name_t * p_object_name,       /* IN */
+                             objstorefsal_op_context_t * p_context,  /* IN */
+                             fsal_attrib_list_t * p_parent_directory_attributes /* [IN/OUT ] */
+    )
+{
+
+  fsal_status_t status;
+  objstore_inode_t *p_dir, *p_inode = NULL;
+  fsal_u64_t inode;
+  int rc, rc2, last = FALSE;
+
+  /* sanity checks. */
+  if(!p_parent_directory_handle || !p_context || !p_object_name)
+    Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_unlink);
+
+  /* get the parent directory */
+  TakeTokenFSCall();
+  status = fsal_internal_getinode(p_parent_directory_handle, &p_dir);
+  ReleaseTokenFSCall();
+  if(FSAL_IS_ERROR(status))
+    ReturnStatus(status, INDEX_FSAL_unlink);
+
+  if(p_dir->type != FSAL_TYPE_DIR)
+    {
+      objstore_inode_put(p_dir);
+      Return(ERR_FSAL_NOTDIR, 0, INDEX_FSAL_unlink);
+    }
+
+  /* client must be able to lookup the parent directory and modify it */
+  status = fsal_internal_inode_access(p_context, p_dir, FSAL_W_OK | FSAL_X_OK);
+  if(FSAL_IS_ERROR(status))
+    {
+      objstore_inode_put(p_dir);
+      ReturnStatus(status, INDEX_FSAL_unlink);
+    }
+
+  P_w(&objstore_ns_lock);
+
+  if((rc = objstore_dir_find(p_dir, p_object_name->name, &inode)) != 0
+     || (rc = objstore_inode_get(inode, &p_inode)) != 0)
+    goto out;
+
+  /* Sticky bit on the directory => the user who wants to delete the file must own it or its parent dir */
+  if((p_dir->mode & S_ISVTX)
+     && p_dir->uid != p_context->credential.user
+     && p_inode->uid != p_context->credential.user && p_context->credential.user != 0)
+    {
+      rc = EACCES;
+      goto out;
+    }
+
+  if(p_inode->type == FSAL_TYPE_DIR && p_inode->nb_entries > 0)
+    {
+      rc = ENOTEMPTY;
+      goto out;
+    }
+
+  /******************************
+   * DELETE FROM THE FILESYSTEM *
+   ******************************/
+
+  /* the entry is removed first, so that a failure never leaves
+   * an entry that refers to a removed object */
+  if((rc = objstore_dir_remove(p_dir, p_object_name->name)) != 0)
+    goto out;
+
+  if(p_inode->type == FSAL_TYPE_DIR)
+    {
+      P(p_dir->lock);
+      p_dir->nlink--;
+      V(p_dir->lock);
+    }
+
+  if((rc = objstore_inode_store(p_dir)) != 0)
+    {
+      objstore_dir_add(p_dir, p_object_name->name, p_inode->inode);
+
+      if(p_inode->type == FSAL_TYPE_DIR)
+        {
+          P(p_dir->lock);
+          p_dir->nlink++;
+          V(p_dir->lock);
+        }
+      goto out;
+    }
+
+  P(p_inode->lock);
+  if(p_inode->type == FSAL_TYPE_DIR || p_inode->nlink <= 1)
+    last = TRUE;
+  else
+    {
+      p_inode->nlink--;
+      p_inode->ctime = time(NULL);
+      p_inode->meta_dirty = TRUE;
+    }
+  V(p_inode->lock);
+
+  /* the remaining links are flushed later if this fails */
+  if(!last)
+    objstore_inode_store(p_inode);
+
+ out:
+  V_w(&objstore_ns_lock);
+
+  /* the last link is gone: drop the data and the index object */
+  if(rc == 0 && last)
+    {
+      /* once the inode is marked removed, writers fail with ESTALE
+       * and cannot bring chunks back after they are dropped */
+      rc = objstore_inode_destroy(p_inode);
+
+      if(p_inode->type == FSAL_TYPE_FILE && (rc2 = objstore_cache_remove(p_inode)) != 0)
+        rc = rc2;
+
+      if(rc)
+        LogCrit(COMPONENT_FSAL,
+                "Could not remove object %llu from the store: error %d",
+                (unsigned long long)p_inode->inode, rc);
+      rc = 0;
+    }
+
+  if(p_inode)
+    objstore_inode_put(p_inode);
+  objstore_inode_put(p_dir);
+
+  if(rc)
+    Return(posix2fsal_error(rc), rc, INDEX_FSAL_unlink);
+
+  /***********************
+   * FILL THE ATTRIBUTES *
+   ***********************/
+
+  if(p_parent_directory_attributes)
+    {
+      status =
+          OBJSTOREFSAL_getattrs(p_parent_directory_handle, p_context,
+                           p_parent_directory_attributes);
+      if(FSAL_IS_ERROR(status))
+        {
+          FSAL_CLEAR_MASK(p_parent_directory_attributes->asked_attributes);
+          FSAL_SET_MASK(p_parent_directory_attributes->asked_attributes,
+                        FSAL_ATTR_RDATTR_ERR);
+        }
+    }
+  /* OK */
+  Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_unlink);
+
+}
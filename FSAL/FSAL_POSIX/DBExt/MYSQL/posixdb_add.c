@@ -28,6 +28,7 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
   char query[4096];
   MYSQL_ROW row;
   int add_parent_entry = FALSE;
+  unsigned int generation;
 
   /*******************
    * 1/ sanity check *
@@ -44,6 +45,8 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
          p_object_info ? p_object_info->inode : 0,
          p_filename ? p_filename->name : "NULL");
 
+  generation = fsal_posixdb_CacheGeneration();
+
   /***************************************
    * 2/ check that parent handle exists
    ***************************************/
@@ -130,12 +133,14 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
 
           p_object_handle->data.info = *p_object_info;
 
+          fsal_posixdb_InvalidateHandle(p_object_handle->data.id, p_object_handle->data.ts);
+
           st = db_exec_sql(p_conn, query, NULL);
           if(FSAL_POSIXDB_IS_ERROR(st))
             goto rollback;
         }
 
-      fsal_posixdb_UpdateInodeCache(p_object_handle);
+      fsal_posixdb_UpdateInodeCache(p_object_handle, generation);
 
     }
   else                          /* no handle found */
@@ -161,7 +166,7 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
       p_object_handle->data.id = mysql_insert_id(&p_conn->db_conn);
 
       /* now, we have the handle id */
-      fsal_posixdb_UpdateInodeCache(p_object_handle);
+      fsal_posixdb_UpdateInodeCache(p_object_handle, generation);
 
     }
 
@@ -276,6 +281,15 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
 
   if(add_parent_entry)
     {
+      /* invalidate name cache */
+      fsal_posixdb_InvalidateName(p_parent_directory_handle ?
+                                  p_parent_directory_handle->data.id :
+                                  p_object_handle->data.id,
+                                  p_parent_directory_handle ?
+                                  p_parent_directory_handle->data.ts :
+                                  p_object_handle->data.ts,
+                                  p_filename ? p_filename->name : "");
+
       /* add a Parent entry */
 
       snprintf(query, 4096,
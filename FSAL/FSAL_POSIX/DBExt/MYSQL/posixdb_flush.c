@@ -11,6 +11,9 @@ fsal_posixdb_status_t fsal_posixdb_flush(fsal_posixdb_conn * p_conn)
 {
   fsal_posixdb_status_t rc;
 
+  /* invalidate cache */
+  fsal_posixdb_InvalidateCache();
+
   rc = db_exec_sql(p_conn, "DELETE FROM Parent", NULL);
   if(FSAL_POSIXDB_IS_ERROR(rc))
     return rc;
@@ -8,225 +8,6 @@
 #include "posixdb_internal.h"
 #include "posixdb_consistency.h"
 #include "string.h"
-#include "RW_Lock.h"
-
-/* cyclic cache of paths */
-
-typedef struct cache_path_entry__
-{
-  int is_set;
-  int path_is_set;
-  int info_is_set;
-  posixfsal_handle_t handle;
-  fsal_path_t path;
-  rw_lock_t entry_lock;
-
-} cache_path_entry_t;
-
-#define CACHE_PATH_SIZE 509     /* prime near 512 */
-
-static cache_path_entry_t cache_array[CACHE_PATH_SIZE];
-
-int fsal_posixdb_cache_init()
-{
-#ifdef _ENABLE_CACHE_PATH
-  unsigned int i;
-
-  memset((char *)cache_array, 0, CACHE_PATH_SIZE * sizeof(cache_path_entry_t));
-
-  for(i = 0; i < CACHE_PATH_SIZE; i++)
-    {
-      if(rw_lock_init(&cache_array[i].entry_lock))
-        return -1;
-
-      cache_array[i].is_set = 0;
-      cache_array[i].path_is_set = 0;
-      cache_array[i].info_is_set = 0;
-    }
-
-#endif
-  return 0;
-}
-
-static unsigned int hash_cache_path(fsal_u64_t id, int ts)
-{
-  return (1999 * id + 3 * ts + 5) % CACHE_PATH_SIZE;
-}
-
-/* @todo pour augmenter les performances d'acces au cache,
- * on hash le handle, et on considere qu'un seul element
- * ayant un hash donne peut occuper une case du tableau.
- */
-
-void fsal_posixdb_CachePath(posixfsal_handle_t * p_handle,      /* IN */
-                            fsal_path_t * p_path /* IN */ )
-{
-
-#ifdef _ENABLE_CACHE_PATH
-
-  unsigned int i;
-
-  LogDebug(COMPONENT_FSAL, "fsal_posixdb_CachePath: %u, %u = %s", (unsigned int)(p_handle->id),
-           (unsigned int)(p_handle->ts), p_path->path);
-
-  i = hash_cache_path(p_handle->id, p_handle->ts);
-
-  /* in the handle already in cache ? */
-  P_w(&cache_array[i].entry_lock);
-
-  if(cache_array[i].is_set
-     && cache_array[i].handle.id == p_handle->id
-     && cache_array[i].handle.ts == p_handle->ts)
-    {
-      cache_array[i].path_is_set = TRUE;
-
-      /* override it */
-      cache_array[i].path = *p_path;
-
-      V_w(&cache_array[i].entry_lock);
-      return;
-    }
-
-  /* add it (replace previous handle) */
-  cache_array[i].is_set = TRUE;
-  cache_array[i].path_is_set = TRUE;
-  cache_array[i].info_is_set = FALSE;
-  cache_array[i].handle = *p_handle;
-  cache_array[i].path = *p_path;
-  V_w(&cache_array[i].entry_lock);
-
-#endif
-  return;
-}
-
-/* set/update informations about a handle */
-int fsal_posixdb_UpdateInodeCache(posixfsal_handle_t * p_handle)        /* IN */
-{
-#ifdef _ENABLE_CACHE_PATH
-
-  unsigned int i;
-
-  LogDebug(COMPONENT_FSAL, "UpdateInodeCache: inode_id=%llu", p_handle->info.inode);
-
-  i = hash_cache_path(p_handle->id, p_handle->ts);
-
-  /* in the handle in cache ? */
-  P_w(&cache_array[i].entry_lock);
-
-  if(cache_array[i].is_set
-     && cache_array[i].handle.id == p_handle->id
-     && cache_array[i].handle.ts == p_handle->ts)
-    {
-      /* update its inode info */
-      cache_array[i].handle.info = p_handle->info;
-      cache_array[i].info_is_set = TRUE;
-
-      LogDebug(COMPONENT_FSAL, "fsal_posixdb_UpdateInodeCache: %u, %u (existing entry)",
-               (unsigned int)(p_handle->id), (unsigned int)(p_handle->ts));
-
-      V_w(&cache_array[i].entry_lock);
-
-      return TRUE;
-    }
-  LogDebug(COMPONENT_FSAL, "fsal_posixdb_UpdateInodeCache: %u, %u (new entry)",
-           (unsigned int)(p_handle->id), (unsigned int)(p_handle->ts));
-
-  /* add it (replace previous handle) */
-  cache_array[i].is_set = TRUE;
-  cache_array[i].path_is_set = FALSE;
-  cache_array[i].info_is_set = TRUE;
-  cache_array[i].handle = *p_handle;
-  memset(&cache_array[i].path, 0, sizeof(fsal_path_t));
-
-  V_w(&cache_array[i].entry_lock);
-#endif
-  return FALSE;
-
-}
-
-/* retrieve last informations about a handle */
-int fsal_posixdb_GetInodeCache(posixfsal_handle_t * p_handle)   /* IN/OUT */
-{
-#ifdef _ENABLE_CACHE_PATH
-  unsigned int i;
-
-  i = hash_cache_path(p_handle->id, p_handle->ts);
-
-  /* in the handle in cache ? */
-  P_r(&cache_array[i].entry_lock);
-  if(cache_array[i].is_set
-     && cache_array[i].handle.id == p_handle->id
-     && cache_array[i].handle.ts == p_handle->ts)
-    {
-      if(cache_array[i].info_is_set)
-        {
-          p_handle->info = cache_array[i].handle.info;
-
-          LogDebug(COMPONENT_FSAL, "fsal_posixdb_GetInodeCache(%u, %u)", (unsigned int)(p_handle->id),
-                   (unsigned int)(p_handle->ts));
-          V_r(&cache_array[i].entry_lock);
-
-          return TRUE;
-        }
-    }
-  V_r(&cache_array[i].entry_lock);
-#endif
-  return FALSE;
-
-}
-
-void fsal_posixdb_InvalidateCache()
-{
-#ifdef _ENABLE_CACHE_PATH
-  unsigned int i;
-
-  LogDebug(COMPONENT_FSAL, "fsal_posixdb_InvalidateCache");
-
-  for(i = 0; i < CACHE_PATH_SIZE; i++)
-    {
-      P_w(&cache_array[i].entry_lock);
-      cache_array[i].is_set = FALSE;
-      cache_array[i].path_is_set = FALSE;
-      cache_array[i].info_is_set = FALSE;
-      cache_array[i].handle.id = 0;
-      cache_array[i].handle.ts = 0;
-      V_w(&cache_array[i].entry_lock);
-    }
-
-#endif
-}
-
-int fsal_posixdb_GetPathCache(posixfsal_handle_t * p_handle,    /* IN */
-                              fsal_path_t * p_path /* OUT */ )
-{
-#ifdef _ENABLE_CACHE_PATH
-
-  unsigned int i;
-
-  i = hash_cache_path(p_handle->id, p_handle->ts);
-
-  /* in the handle in cache ? */
-  P_r(&cache_array[i].entry_lock);
-  if(cache_array[i].is_set
-     && cache_array[i].handle.id == p_handle->id
-     && cache_array[i].handle.ts == p_handle->ts)
-    {
-      if(cache_array[i].path_is_set)
-        {
-          /* return path it */
-          memcpy(p_path, &cache_array[i].path, sizeof(fsal_path_t));
-          V_r(&cache_array[i].entry_lock);
-
-          LogDebug(COMPONENT_FSAL, "fsal_posixdb_GetPathCache(%u, %u)=%s",
-                   (unsigned int)p_handle->id, (unsigned int)p_handle->ts,
-                   p_path->path);
-          return TRUE;
-        }
-    }
-  V_r(&cache_array[i].entry_lock);
-#endif
-  return FALSE;
-}
 
 fsal_posixdb_status_t mysql_error_convert(int err)
 {
@@ -331,6 +112,7 @@ fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
   int root_reached = FALSE;
   MYSQL_STMT *stmt;
   int rc;
+  unsigned int generation;
 
   memset(output, 0, sizeof(MYSQL_BIND) * output_num);
   memset(is_null, 0, sizeof(my_bool) * output_num);
@@ -355,6 +137,8 @@ fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
   if(fsal_posixdb_GetPathCache(p_handle, p_path))
     ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
 
+  generation = fsal_posixdb_CacheGeneration();
+
   last_id = p_handle->data.id;
   last_ts = p_handle->data.ts;
 
@@ -471,7 +255,7 @@ fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
   else
     {
       /* set result in cache and return */
-      fsal_posixdb_CachePath(p_handle, p_path);
+      fsal_posixdb_CachePath(p_handle, p_path, generation);
 
       ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
     }
@@ -532,8 +316,8 @@ fsal_posixdb_status_t fsal_posixdb_recursiveDelete(fsal_posixdb_conn * p_conn,
       mysql_free_result(res);
     }
 
-  /* invalidate name cache */
-  fsal_posixdb_InvalidateCache();
+  /* invalidate the handle (and the names leading to it) */
+  fsal_posixdb_InvalidateHandle(id, ts);
 
   /* Delete the Handle (this also delete entries in Parent, thanks to DELETE CASCADE) */
   snprintf(query, 2048, "DELETE FROM Handle WHERE handleid=%llu AND handlets=%u", id, ts);
@@ -573,6 +357,9 @@ fsal_posixdb_status_t fsal_posixdb_deleteParent(fsal_posixdb_conn * p_conn,
       ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
     }
 
+  /* invalidate name cache */
+  fsal_posixdb_InvalidateName(idparent, tsparent, filename);
+
   snprintf(query, 1024,
            "DELETE FROM Parent WHERE handleidparent=%llu AND handletsparent=%u AND name='%s'",
            idparent, tsparent, filename);
@@ -584,8 +371,8 @@ fsal_posixdb_status_t fsal_posixdb_deleteParent(fsal_posixdb_conn * p_conn,
   if(nlink == 1)
     {
 
-      /* invalidate cache */
-      fsal_posixdb_InvalidateCache();
+      /* invalidate handle cache */
+      fsal_posixdb_InvalidateHandle(id, ts);
 
       /* delete the handle */
 
@@ -608,8 +395,8 @@ fsal_posixdb_status_t fsal_posixdb_deleteParent(fsal_posixdb_conn * p_conn,
     }
   else
     {
-      /* invalidate cache */
-      fsal_posixdb_InvalidateCache();
+      /* invalidate handle cache */
+      fsal_posixdb_InvalidateHandle(id, ts);
 
       /* update the Handle entry ( Handle.nlink <- (nlink - 1) ) */
       snprintf(query, 1024,
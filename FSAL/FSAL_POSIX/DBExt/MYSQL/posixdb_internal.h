@@ -149,31 +149,7 @@ fsal_posixdb_status_t posixdb_internal_fillFileinfoFromStrValues(fsal_posixdb_fi
                                                                  char *ctime_str,
                                                                  char *ftype_str);
 
-/* this manages a mini-cache for the last few handles handled
- * it is invalidated as soon has there is a modification in the database
- */
-
-/* enter an entry in cache path */
-
-void fsal_posixdb_CachePath(posixfsal_handle_t * p_handle,      /* IN */
-                            fsal_path_t * p_path /* IN */ );
-
-/* invalidate cache in case of a modification */
-
-void fsal_posixdb_InvalidateCache();
-
-/* get a path from the cache
- * return true if the entry is found,
- * false else.
- */
-
-int fsal_posixdb_GetPathCache(posixfsal_handle_t * p_handle,    /* IN */
-                              fsal_path_t * p_path /* OUT */ );
-
-/* update informations about a handle */
-int fsal_posixdb_UpdateInodeCache(posixfsal_handle_t * p_handle);       /* IN */
-
-/* retrieve last informations about a handle */
-int fsal_posixdb_GetInodeCache(posixfsal_handle_t * p_handle);  /* IN/OUT */
+/* the handle, path and name cache is shared by the posixdb backends */
+#include "../posixdb_cache.h"
 
 #endif
@@ -155,8 +155,13 @@ fsal_posixdb_status_t fsal_posixdb_replace(fsal_posixdb_conn * p_conn,  /* IN */
 
       re_update = FALSE;
 
-      /* invalidate name cache */
-      fsal_posixdb_InvalidateCache();
+      /* invalidate the names and the paths of the moved subtree */
+      fsal_posixdb_InvalidateRename(p_parent_directory_handle_old->data.id,
+                                    p_parent_directory_handle_old->data.ts,
+                                    p_filename_old->name,
+                                    p_parent_directory_handle_new->data.id,
+                                    p_parent_directory_handle_new->data.ts,
+                                    p_filename_new->name);
 
       snprintf(query, 4096, "UPDATE Parent "
                "SET handleidparent=%llu, handletsparent=%u, name='%s' "
@@ -27,6 +27,7 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
   int found;
   const char *paramValues[6];
   fsal_posixdb_status_t st;
+  unsigned int generation;
 
   /*******************
    * 1/ sanity check *
@@ -45,6 +46,8 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
          p_object_info ? p_object_info->inode : 0,
          p_filename ? p_filename->name : "NULL");
 
+  generation = fsal_posixdb_CacheGeneration();
+
   BeginTransaction(p_conn, p_res);
 
   /*********************************
@@ -124,11 +127,13 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
 
           p_object_handle->data.info = *p_object_info;
 
+          fsal_posixdb_InvalidateHandle(p_object_handle->data.id, p_object_handle->data.ts);
+
           p_res = PQexecPrepared(p_conn, "updateHandle", 4, paramValues, NULL, NULL, 0);
           CheckCommand(p_res);
         }
 
-      fsal_posixdb_UpdateInodeCache(p_object_handle);
+      fsal_posixdb_UpdateInodeCache(p_object_handle, generation);
 
     }
   else
@@ -168,7 +173,7 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
       PQclear(p_res);
 
       /* now, we have the handle id */
-      fsal_posixdb_UpdateInodeCache(p_object_handle);
+      fsal_posixdb_UpdateInodeCache(p_object_handle, generation);
 
     }
 
@@ -257,6 +262,10 @@ fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
       paramValues[3] = handleid_str;
       paramValues[4] = handlets_str;
 
+      /* invalidate name cache */
+      fsal_posixdb_InvalidateName(atoll(paramValues[0]), atoi(paramValues[1]),
+                                  (char *)paramValues[2]);
+
       p_res = PQexecPrepared(p_conn, "insertParent", 5, paramValues, NULL, NULL, 0);
       CheckCommand(p_res);
       PQclear(p_res);
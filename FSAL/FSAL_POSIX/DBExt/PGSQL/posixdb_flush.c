@@ -8,6 +8,9 @@ fsal_posixdb_status_t fsal_posixdb_flush(fsal_posixdb_conn * p_conn)
 {
   PGresult *p_res;
 
+  /* invalidate cache */
+  fsal_posixdb_InvalidateCache();
+
   p_res = PQexec(p_conn, "DELETE FROM Parent");
   CheckCommand(p_res);
   PQclear(p_res);
@@ -17,6 +17,7 @@ fsal_posixdb_status_t fsal_posixdb_getInfoFromName(fsal_posixdb_conn * p_conn,
   char handleid_str[MAX_HANDLEIDSTR_SIZE];
   char handlets_str[MAX_HANDLETSSTR_SIZE];
   const char *paramValues[3] = { handleid_str, handlets_str, p_objectname->name };
+  unsigned int generation;
 
   /* sanity check */
   if(!p_conn || !p_handle)
@@ -28,6 +29,25 @@ fsal_posixdb_status_t fsal_posixdb_getInfoFromName(fsal_posixdb_conn * p_conn,
 
   LogFullDebug(COMPONENT_FSAL, "object_name='%s'\n", p_objectname->name);
 
+  /* the entry and the path of its parent may be known by the cache */
+  if(p_parent_directory_handle && p_parent_directory_handle->data.id
+     && fsal_posixdb_GetNameCache(p_parent_directory_handle, p_objectname, p_handle))
+    {
+      if(!p_path)
+        ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+
+      if(fsal_posixdb_GetPathCache(p_parent_directory_handle, p_path)
+         && p_path->len + 1 + p_objectname->len < FSAL_MAX_PATH_LEN)
+        {
+          p_path->path[p_path->len] = '/';
+          strcpy(&p_path->path[p_path->len + 1], p_objectname->name);
+          p_path->len += 1 + p_objectname->len;
+          ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+        }
+    }
+
+  generation = fsal_posixdb_CacheGeneration();
+
   BeginTransaction(p_conn, p_res);
   /* lookup for the handle of the file */
   if(p_parent_directory_handle && p_parent_directory_handle->data.id)
@@ -61,6 +81,13 @@ fsal_posixdb_status_t fsal_posixdb_getInfoFromName(fsal_posixdb_conn * p_conn,
       );
   PQclear(p_res);
 
+  /* remember the name and the informations about the handle */
+  if(p_parent_directory_handle && p_parent_directory_handle->data.id)
+    fsal_posixdb_CacheName(p_parent_directory_handle, p_objectname, p_handle,
+                           generation);
+  else
+    fsal_posixdb_UpdateInodeCache(p_handle, generation);
+
   /* Build the path of the object */
   if(p_path && p_objectname)
     {
@@ -83,12 +110,7 @@ fsal_posixdb_status_t fsal_posixdb_getInfoFromName(fsal_posixdb_conn * p_conn,
       p_path->len += 1 + p_objectname->len;
 
       /* add the the path to cache */
-      fsal_posixdb_CachePath(p_handle, p_path);
-    }
-  else
-    {
-      /* update handle if it was in cache */
-      fsal_posixdb_UpdateInodeCache(p_handle);
+      fsal_posixdb_CachePath(p_handle, p_path, generation);
     }
 
   EndTransaction(p_conn, p_res);
@@ -110,6 +132,8 @@ fsal_posixdb_status_t fsal_posixdb_getInfoFromHandle(fsal_posixdb_conn * p_conn,
   int i_path;
   int toomanypaths = 0;
   const char *paramValues[2] = { handleid_str, handlets_str };
+  int info_cached;
+  unsigned int generation;
 
   /* sanity check */
   if(!p_conn || !p_object_handle || ((!p_paths || !p_count) && paths_size > 0))
@@ -121,13 +145,31 @@ fsal_posixdb_status_t fsal_posixdb_getInfoFromHandle(fsal_posixdb_conn * p_conn,
 
   LogFullDebug(COMPONENT_FSAL, "OBJECT_ID=%lli\n", p_object_handle->data.id);
 
+  /* the informations may be known by the cache, and also the path
+   * of an object that has only one */
+  info_cached = fsal_posixdb_GetInodeCache(p_object_handle);
+
+  if(info_cached
+     && (!p_paths
+         || (paths_size > 0
+             && (p_object_handle->data.info.ftype == FSAL_TYPE_DIR
+                 || p_object_handle->data.info.nlink == 1)
+             && fsal_posixdb_GetPathCache(p_object_handle, &p_paths[0]))))
+    {
+      if(p_paths)
+        *p_count = 1;
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+    }
+
+  generation = fsal_posixdb_CacheGeneration();
+
   BeginTransaction(p_conn, p_res);
 
   /* lookup for the handle of the file */
   snprintf(handleid_str, MAX_HANDLEIDSTR_SIZE, "%lli", p_object_handle->data.id);
   snprintf(handlets_str, MAX_HANDLETSSTR_SIZE, "%i", p_object_handle->data.ts);
 
-  if(!fsal_posixdb_GetInodeCache(p_object_handle))
+  if(!info_cached)
     {
 
       p_res = PQexecPrepared(p_conn, "lookupHandle", 2, paramValues, NULL, NULL, 0);
@@ -152,7 +194,7 @@ fsal_posixdb_status_t fsal_posixdb_getInfoFromHandle(fsal_posixdb_conn * p_conn,
       PQclear(p_res);
 
       /* update the inode */
-      fsal_posixdb_UpdateInodeCache(p_object_handle);
+      fsal_posixdb_UpdateInodeCache(p_object_handle, generation);
     }
 
   /* Build the paths of the object */
@@ -222,11 +264,12 @@ fsal_posixdb_status_t fsal_posixdb_getInfoFromHandle(fsal_posixdb_conn * p_conn,
               strcpy(&p_paths[i_path].path[tmp_len + 1], PQgetvalue(p_res, i_path, 0));
               p_paths[i_path].len += 1 + strlen(PQgetvalue(p_res, i_path, 0));
             }
+        }
 
-          /* insert the object into cache */
-          fsal_posixdb_CachePath(p_object_handle, &p_paths[i_path]);
+      /* insert the object into cache, if it has only one path */
+      if(*p_count == 1 && !toomanypaths)
+        fsal_posixdb_CachePath(p_object_handle, &p_paths[0], generation);
 
-        }
       PQclear(p_res);
     }
 
@@ -5,225 +5,6 @@
 #include "posixdb_internal.h"
 #include "posixdb_consistency.h"
 #include "string.h"
-#include "RW_Lock.h"
-
-/* cyclic cache of paths */
-
-typedef struct cache_path_entry__
-{
-  int is_set;
-  int path_is_set;
-  int info_is_set;
-  posixfsal_handle_t handle;
-  fsal_path_t path;
-  rw_lock_t entry_lock;
-
-} cache_path_entry_t;
-
-#define CACHE_PATH_SIZE 509     /* prime near 512 */
-
-static cache_path_entry_t cache_array[CACHE_PATH_SIZE];
-
-int fsal_posixdb_cache_init()
-{
-#ifdef _ENABLE_CACHE_PATH
-  unsigned int i;
-
-  memset((char *)cache_array, 0, CACHE_PATH_SIZE * sizeof(cache_path_entry_t));
-
-  for(i = 0; i < CACHE_PATH_SIZE; i++)
-    {
-      if(rw_lock_init(&cache_array[i].entry_lock))
-        return -1;
-
-      cache_array[i].is_set = 0;
-      cache_array[i].path_is_set = 0;
-      cache_array[i].info_is_set = 0;
-    }
-
-#endif
-  return 0;
-}
-
-static unsigned int hash_cache_path(fsal_u64_t id, int ts)
-{
-  return (1999 * id + 3 * ts + 5) % CACHE_PATH_SIZE;
-}
-
-/* @todo pour augmenter les performances d'acces au cache,
- * on hash le handle, et on considere qu'un seul element
- * ayant un hash donne peut occuper une case du tableau.
- */
-
-void fsal_posixdb_CachePath(posixfsal_handle_t * p_handle,      /* IN */
-                            fsal_path_t * p_path /* IN */ )
-{
-
-#ifdef _ENABLE_CACHE_PATH
-
-  unsigned int i;
-
-  LogDebug(COMPONENT_FSAL, "fsal_posixdb_CachePath: %u, %u = %s", (unsigned int)(p_handle->id),
-           (unsigned int)(p_handle->ts), p_path->path);
-
-  i = hash_cache_path(p_handle->id, p_handle->ts);
-
-  /* in the handle already in cache ? */
-  P_w(&cache_array[i].entry_lock);
-
-  if(cache_array[i].is_set
-     && cache_array[i].handle.id == p_handle->id
-     && cache_array[i].handle.ts == p_handle->ts)
-    {
-      cache_array[i].path_is_set = TRUE;
-
-      /* override it */
-      cache_array[i].path = *p_path;
-
-      V_w(&cache_array[i].entry_lock);
-      return;
-    }
-
-  /* add it (replace previous handle) */
-  cache_array[i].is_set = TRUE;
-  cache_array[i].path_is_set = TRUE;
-  cache_array[i].info_is_set = FALSE;
-  cache_array[i].handle = *p_handle;
-  cache_array[i].path = *p_path;
-  V_w(&cache_array[i].entry_lock);
-
-#endif
-  return;
-}
-
-/* set/update informations about a handle */
-int fsal_posixdb_UpdateInodeCache(posixfsal_handle_t * p_handle)        /* IN */
-{
-#ifdef _ENABLE_CACHE_PATH
-
-  unsigned int i;
-
-  LogDebug(COMPONENT_FSAL, "UpdateInodeCache: inode_id=%llu", p_handle->info.inode);
-
-  i = hash_cache_path(p_handle->id, p_handle->ts);
-
-  /* in the handle in cache ? */
-  P_w(&cache_array[i].entry_lock);
-
-  if(cache_array[i].is_set
-     && cache_array[i].handle.id == p_handle->id
-     && cache_array[i].handle.ts == p_handle->ts)
-    {
-      /* update its inode info */
-      cache_array[i].handle.info = p_handle->info;
-      cache_array[i].info_is_set = TRUE;
-
-      LogDebug(COMPONENT_FSAL, "fsal_posixdb_UpdateInodeCache: %u, %u (existing entry)",
-               (unsigned int)(p_handle->id), (unsigned int)(p_handle->ts));
-
-      V_w(&cache_array[i].entry_lock);
-
-      return TRUE;
-    }
-  LogDebug(COMPONENT_FSAL, "fsal_posixdb_UpdateInodeCache: %u, %u (new entry)",
-           (unsigned int)(p_handle->id), (unsigned int)(p_handle->ts));
-
-  /* add it (replace previous handle) */
-  cache_array[i].is_set = TRUE;
-  cache_array[i].path_is_set = FALSE;
-  cache_array[i].info_is_set = TRUE;
-  cache_array[i].handle = *p_handle;
-  memset(&cache_array[i].path, 0, sizeof(fsal_path_t));
-
-  V_w(&cache_array[i].entry_lock);
-#endif
-  return FALSE;
-
-}
-
-/* retrieve last informations about a handle */
-int fsal_posixdb_GetInodeCache(posixfsal_handle_t * p_handle)   /* IN/OUT */
-{
-#ifdef _ENABLE_CACHE_PATH
-  unsigned int i;
-
-  i = hash_cache_path(p_handle->id, p_handle->ts);
-
-  /* in the handle in cache ? */
-  P_r(&cache_array[i].entry_lock);
-  if(cache_array[i].is_set
-     && cache_array[i].handle.id == p_handle->id
-     && cache_array[i].handle.ts == p_handle->ts)
-    {
-      if(cache_array[i].info_is_set)
-        {
-          p_handle->info = cache_array[i].handle.info;
-
-          LogDebug(COMPONENT_FSAL, "fsal_posixdb_GetInodeCache(%u, %u)", (unsigned int)(p_handle->id),
-                   (unsigned int)(p_handle->ts));
-          V_r(&cache_array[i].entry_lock);
-
-          return TRUE;
-        }
-    }
-  V_r(&cache_array[i].entry_lock);
-#endif
-  return FALSE;
-
-}
-
-void fsal_posixdb_InvalidateCache()
-{
-#ifdef _ENABLE_CACHE_PATH
-  unsigned int i;
-
-  LogDebug(COMPONENT_FSAL, "fsal_posixdb_InvalidateCache");
-
-  for(i = 0; i < CACHE_PATH_SIZE; i++)
-    {
-      P_w(&cache_array[i].entry_lock);
-      cache_array[i].is_set = FALSE;
-      cache_array[i].path_is_set = FALSE;
-      cache_array[i].info_is_set = FALSE;
-      cache_array[i].handle.id = 0;
-      cache_array[i].handle.ts = 0;
-      V_w(&cache_array[i].entry_lock);
-    }
-
-#endif
-}
-
-int fsal_posixdb_GetPathCache(posixfsal_handle_t * p_handle,    /* IN */
-                              fsal_path_t * p_path /* OUT */ )
-{
-#ifdef _ENABLE_CACHE_PATH
-
-  unsigned int i;
-
-  i = hash_cache_path(p_handle->id, p_handle->ts);
-
-  /* in the handle in cache ? */
-  P_r(&cache_array[i].entry_lock);
-  if(cache_array[i].is_set
-     && cache_array[i].handle.id == p_handle->id
-     && cache_array[i].handle.ts == p_handle->ts)
-    {
-      if(cache_array[i].path_is_set)
-        {
-          /* return path it */
-          memcpy(p_path, &cache_array[i].path, sizeof(fsal_path_t));
-          V_r(&cache_array[i].entry_lock);
-
-          LogDebug(COMPONENT_FSAL, "fsal_posixdb_GetPathCache(%u, %u)=%s",
-                   (unsigned int)p_handle->id, (unsigned int)p_handle->ts,
-                   p_path->path);
-          return TRUE;
-        }
-    }
-  V_r(&cache_array[i].entry_lock);
-#endif
-  return FALSE;
-}
 
 fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
                                                 posixfsal_handle_t * p_handle,
@@ -236,6 +17,7 @@ fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
   char *new_pos;
   int toomanypaths = 0;
   const char *paramValues[2] = { handleid_str, handlets_str };
+  unsigned int generation;
 
   if(!p_conn || !p_handle || !p_path)
     {
@@ -253,6 +35,8 @@ fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
   if(fsal_posixdb_GetPathCache(p_handle, p_path))
     ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
 
+  generation = fsal_posixdb_CacheGeneration();
+
   snprintf(handleid_str, MAX_HANDLEIDSTR_SIZE, "%lli", p_handle->data.id);
   snprintf(handlets_str, MAX_HANDLETSSTR_SIZE, "%i", p_handle->data.ts);
 
@@ -269,7 +53,7 @@ fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
   strcpy(p_path->path, PQgetvalue(p_res, 0, 0));
 
   /* set result in cache */
-  fsal_posixdb_CachePath(p_handle, p_path);
+  fsal_posixdb_CachePath(p_handle, p_path, generation);
 
   ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
 
@@ -316,7 +100,7 @@ fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
   else
     {
       /* set result in cache */
-      fsal_posixdb_CachePath(p_handle, p_path);
+      fsal_posixdb_CachePath(p_handle, p_path, generation);
 
       ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
     }
@@ -378,8 +162,8 @@ fsal_posixdb_status_t fsal_posixdb_recursiveDelete(fsal_posixdb_conn * p_conn,
   paramValues[0] = handleid_str;
   paramValues[1] = handlets_str;
 
-  /* invalidate name cache */
-  fsal_posixdb_InvalidateCache();
+  /* invalidate the handle (and the names leading to it) */
+  fsal_posixdb_InvalidateHandle(atoll(handleid_str), atoi(handlets_str));
 
   p_res = PQexecPrepared(p_conn, "deleteHandle", 2, paramValues, NULL, NULL, 0);
   CheckCommand(p_res);
@@ -411,7 +195,8 @@ fsal_posixdb_status_t fsal_posixdb_deleteParent(fsal_posixdb_conn * p_conn,
   paramValues[2] = filename;
 
   /* invalidate name cache */
-  fsal_posixdb_InvalidateCache();
+  fsal_posixdb_InvalidateName(atoll(handleidparent_str), atoi(handletsparent_str),
+                              filename);
 
   p_res = PQexecPrepared(p_conn, "deleteParent", 3, paramValues, NULL, NULL, 0);
   CheckCommand(p_res);
@@ -424,8 +209,8 @@ fsal_posixdb_status_t fsal_posixdb_deleteParent(fsal_posixdb_conn * p_conn,
       paramValues[0] = handleid_str;
       paramValues[1] = handlets_str;
 
-      /* invalidate cache */
-      fsal_posixdb_InvalidateCache();
+      /* invalidate handle cache */
+      fsal_posixdb_InvalidateHandle(atoll(handleid_str), atoi(handlets_str));
 
       p_res = PQexecPrepared(p_conn, "deleteHandle", 2, paramValues, NULL, NULL, 0);
       CheckCommand(p_res);
@@ -438,8 +223,8 @@ fsal_posixdb_status_t fsal_posixdb_deleteParent(fsal_posixdb_conn * p_conn,
       snprintf(nlink_str, MAX_NLINKSTR_SIZE, "%i", nlink - 1);
       paramValues[2] = nlink_str;
 
-      /* invalidate cache */
-      fsal_posixdb_InvalidateCache();
+      /* invalidate handle cache */
+      fsal_posixdb_InvalidateHandle(atoll(handleid_str), atoi(handlets_str));
 
       p_res = PQexecPrepared(p_conn, "updateHandleNlink", 3, paramValues, NULL, NULL, 0);
       CheckCommand(p_res);
@@ -142,8 +142,13 @@ fsal_posixdb_status_t fsal_posixdb_replace(fsal_posixdb_conn * p_conn,  /* IN */
 
  update:
 
-  /* invalidate name cache */
-  fsal_posixdb_InvalidateCache();
+  /* invalidate the names and the paths of the moved subtree */
+  fsal_posixdb_InvalidateRename(p_parent_directory_handle_old->data.id,
+                                p_parent_directory_handle_old->data.ts,
+                                p_filename_old->name,
+                                p_parent_directory_handle_new->data.id,
+                                p_parent_directory_handle_new->data.ts,
+                                p_filename_new->name);
 
   p_res = PQexecPrepared(p_conn, "updateParent", 6, paramValues, NULL, NULL, 0);
 
@@ -0,0 +1,238 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif
+
+#include "fsal_types.h"
+#include "posixdb_internal.h"
+#include "posixdb_consistency.h"
+#include <string.h>
+
+fsal_posixdb_status_t fsal_posixdb_add(fsal_posixdb_conn * p_conn,      /* IN */
+                                       fsal_posixdb_fileinfo_t * p_object_info, /* IN */
+                                       posixfsal_handle_t * p_parent_directory_handle,  /* IN */
+                                       fsal_name_t * p_filename,        /* IN */
+                                       posixfsal_handle_t * p_object_handle /* OUT */ )
+{
+  sqlite3_stmt *stmt;
+  unsigned long long idparent;
+  unsigned int tsparent;
+  char *name;
+  int found;
+  int rc;
+  fsal_posixdb_status_t st;
+  unsigned int generation;
+
+  /*******************
+   * 1/ sanity check *
+   *******************/
+
+  /* parent_directory and filename are NULL only if it is the root directory */
+  if(!p_conn || !p_object_info || !p_object_handle
+     || (p_filename && !p_parent_directory_handle) || (!p_filename
+                                                       && p_parent_directory_handle))
+    ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+
+  LogFullDebug(COMPONENT_FSAL, "adding entry with parentid=%llu, id=%llu, name=%s\n",
+         p_parent_directory_handle ? p_parent_directory_handle->data.id : 0,
+         p_object_info ? p_object_info->inode : 0,
+         p_filename ? p_filename->name : "NULL");
+
+  generation = fsal_posixdb_CacheGeneration();
+
+  BeginUpdateTransaction(p_conn);
+
+  /*********************************
+   * 2/ we check the parent handle *
+   *********************************/
+
+  if(p_parent_directory_handle)
+    {                           /* the root has no parent */
+      stmt = db_get_stmt(p_conn, LOOKUPHANDLE);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_parent_directory_handle->data.id);
+      sqlite3_bind_int(stmt, 2, (int)p_parent_directory_handle->data.ts);
+      rc = sqlite3_step(stmt);
+      CheckStep(p_conn, rc);
+
+      if(rc != SQLITE_ROW)
+        {
+          /* parent entry not found */
+          RollbackTransaction(p_conn);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_NOENT, 0);
+        }
+      sqlite3_reset(stmt);
+    }
+
+  /**********************************************************
+   * 3/ Check if there is an existing Handle for the object *
+   **********************************************************/
+  stmt = db_get_stmt(p_conn, LOOKUPHANDLEBYINODEFU);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_object_info->devid);
+  sqlite3_bind_int64(stmt, 2, (sqlite3_int64) p_object_info->inode);
+  rc = sqlite3_step(stmt);
+  CheckStep(p_conn, rc);
+  found = (rc == SQLITE_ROW);
+
+  if(found)
+    {                           /* a Handle (that matches devid & inode) already exists */
+      /* fill 'info' with information about the handle in the database */
+      posixdb_internal_fillFileinfoFromColumns(&(p_object_handle->data.info), stmt, -1, -1, 2,  /* nlink */
+                                               3,       /* ctime */
+                                               4        /* ftype */
+          );
+      p_object_handle->data.info.inode = p_object_info->inode;
+      p_object_handle->data.info.devid = p_object_info->devid;
+      p_object_handle->data.id = (unsigned long long)sqlite3_column_int64(stmt, 0);
+      p_object_handle->data.ts = (unsigned int)sqlite3_column_int(stmt, 1);
+      sqlite3_reset(stmt);
+
+      /* check the consistency of the handle */
+      if(fsal_posixdb_consistency_check(&(p_object_handle->data.info), p_object_info))
+        {
+          /* consistency check failed */
+          /* p_object_handle has been filled in order to be able to fix the consistency later */
+          RollbackTransaction(p_conn);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_CONSISTENCY, 0);
+        }
+
+      /* update nlink & ctime if needed */
+      if(p_object_info->nlink != p_object_handle->data.info.nlink
+         || p_object_info->ctime != p_object_handle->data.info.ctime)
+        {
+          p_object_handle->data.info = *p_object_info;
+
+          fsal_posixdb_InvalidateHandle(p_object_handle->data.id, p_object_handle->data.ts);
+
+          stmt = db_get_stmt(p_conn, UPDATEHANDLE);
+          sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_object_handle->data.id);
+          sqlite3_bind_int(stmt, 2, (int)p_object_handle->data.ts);
+          sqlite3_bind_int(stmt, 3, p_object_info->nlink);
+          sqlite3_bind_int(stmt, 4, (int)p_object_info->ctime);
+          rc = sqlite3_step(stmt);
+          sqlite3_reset(stmt);
+          CheckStep(p_conn, rc);
+        }
+
+      fsal_posixdb_UpdateInodeCache(p_object_handle, generation);
+
+    }
+  else
+    {                           /* no handle found */
+      /* Handle does not exist, add a new Handle entry */
+      sqlite3_reset(stmt);
+
+      p_object_handle->data.ts = (int)time(NULL);
+      p_object_handle->data.info = *p_object_info;
+
+      stmt = db_get_stmt(p_conn, INSERTHANDLE);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_object_info->devid);
+      sqlite3_bind_int64(stmt, 2, (sqlite3_int64) p_object_info->inode);
+      sqlite3_bind_int(stmt, 3, (int)p_object_handle->data.ts);
+      sqlite3_bind_int(stmt, 4, p_object_info->nlink);
+      sqlite3_bind_int(stmt, 5, (int)p_object_info->ctime);
+      sqlite3_bind_int(stmt, 6, (int)p_object_info->ftype);
+      rc = sqlite3_step(stmt);
+      sqlite3_reset(stmt);
+      CheckStep(p_conn, rc);
+
+      /* handleId is the rowid of the new entry */
+      p_object_handle->data.id =
+          (unsigned long long)sqlite3_last_insert_rowid(p_conn->db_conn);
+
+      /* now, we have the handle id */
+      fsal_posixdb_UpdateInodeCache(p_object_handle, generation);
+
+    }
+
+  /************************************************
+   * add (or update) an entry in the Parent table *
+   ************************************************/
+  idparent = p_parent_directory_handle ? p_parent_directory_handle->data.id
+      : p_object_handle->data.id;
+  tsparent = p_parent_directory_handle ? p_parent_directory_handle->data.ts
+      : p_object_handle->data.ts;
+  name = p_filename ? p_filename->name : "";
+
+  stmt = db_get_stmt(p_conn, LOOKUPPARENT);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) idparent);
+  sqlite3_bind_int(stmt, 2, (int)tsparent);
+  sqlite3_bind_text(stmt, 3, name, -1, SQLITE_STATIC);
+  rc = sqlite3_step(stmt);
+  CheckStep(p_conn, rc);
+  /* stmt contains handleid & handlets */
+  found = (rc == SQLITE_ROW);
+
+  if(found)
+    {
+      unsigned long long bad_id = (unsigned long long)sqlite3_column_int64(stmt, 0);
+      unsigned int bad_ts = (unsigned int)sqlite3_column_int(stmt, 1);
+
+      sqlite3_reset(stmt);
+
+      /* update the Parent entry if necessary (there entry exists with another handle) */
+      if(bad_id == p_object_handle->data.id && bad_ts == p_object_handle->data.ts)
+        {
+          /* a Parent entry exists with our handle, nothing to do */
+          EndTransaction(p_conn);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+        }
+
+      /* steps :
+         - check the nlink value of the Parent entry to be overwritten
+         - if nlink = 1, then we can delete the handle.
+         else we have to update it (nlink--) : that is done by fsal_posixdb_deleteParent
+         - update the handle of the entry
+       */
+      stmt = db_get_stmt(p_conn, LOOKUPHANDLEFU);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) bad_id);
+      sqlite3_bind_int(stmt, 2, (int)bad_ts);
+      rc = sqlite3_step(stmt);
+      CheckStep(p_conn, rc);
+
+      if(rc == SQLITE_ROW)
+        {                       /* we have retrieved the handle information of the bad entry */
+          int nlink = sqlite3_column_int(stmt, 2);
+
+          sqlite3_reset(stmt);
+
+          /* a Parent entry already exists, we delete it */
+          st = fsal_posixdb_deleteParent(p_conn, bad_id, bad_ts, idparent, tsparent,
+                                         name, nlink);
+          if(FSAL_POSIXDB_IS_ERROR(st))
+            {
+              RollbackTransaction(p_conn);
+              return st;
+            }
+        }
+      else
+        {                       /* the Handle line has been deleted */
+          sqlite3_reset(stmt);
+        }
+
+      /* the bad entry has been deleted. Now we had a new Parent entry */
+    }
+  else
+    sqlite3_reset(stmt);
+
+  /* add a Parent entry */
+
+  /* invalidate name cache */
+  fsal_posixdb_InvalidateName(idparent, tsparent, name);
+
+  stmt = db_get_stmt(p_conn, INSERTPARENT);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) idparent);
+  sqlite3_bind_int(stmt, 2, (int)tsparent);
+  sqlite3_bind_text(stmt, 3, name, -1, SQLITE_STATIC);
+  sqlite3_bind_int64(stmt, 4, (sqlite3_int64) p_object_handle->data.id);
+  sqlite3_bind_int(stmt, 5, (int)p_object_handle->data.ts);
+  rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  CheckStep(p_conn, rc);
+
+  EndTransaction(p_conn);
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
@@ -0,0 +1,252 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "fsal_types.h"
+#include "posixdb_internal.h"
+#include "stuff_alloc.h"
+#include <string.h>
+
+/* Tables of the database, created when the database file is new
+ * (see posixdb_sqlite3.sql).
+ * handleId is an alias for the rowid, so the Handle table is stored
+ * in a B-tree ordered by handleId. AUTOINCREMENT prevents the id of
+ * a deleted handle from being given to a new one.
+ */
+static const char *posixdb_schema =
+    "CREATE TABLE IF NOT EXISTS Handle ( \
+       handleId  INTEGER PRIMARY KEY AUTOINCREMENT, \
+       handleTs  INTEGER NOT NULL, \
+       deviceId  INTEGER NOT NULL, \
+       inode     INTEGER NOT NULL, \
+       ctime     INTEGER, \
+       nlink     INTEGER DEFAULT 1, \
+       ftype     INTEGER, \
+       UNIQUE (handleId, handleTs), \
+       UNIQUE (deviceId, inode) \
+     ); \
+     CREATE TABLE IF NOT EXISTS Parent ( \
+       handleId        INTEGER NOT NULL, \
+       handleTs        INTEGER NOT NULL, \
+       handleIdParent  INTEGER, \
+       handleTsParent  INTEGER, \
+       name            TEXT, \
+       UNIQUE (handleIdParent, handleTsParent, name), \
+       FOREIGN KEY (handleId, handleTs) REFERENCES Handle(handleId, handleTs) ON DELETE CASCADE, \
+       FOREIGN KEY (handleIdParent, handleTsParent) REFERENCES Handle(handleId, handleTs) ON DELETE CASCADE \
+     ); \
+     CREATE INDEX IF NOT EXISTS parent_handle_index ON Parent (handleId, handleTs);";
+
+/* Prepared requests, in the order of their index (see posixdb.h).
+ * SQLite has no row locks: the "FU" (for update) requests are run
+ * in transactions that hold the write lock of the database.
+ */
+static const char *posixdb_queries[NB_PREPARED_REQ] = {
+  /* BUILDONEPATH */
+  "SELECT '/' || name, handleidparent, handletsparent FROM Parent WHERE handleid=?1 AND handlets=?2",
+  /* LOOKUPPATHS */
+  "SELECT name, handleidparent, handletsparent \
+     FROM Parent \
+     WHERE handleid=?1 AND handleTs=?2",
+  /* LOOKUPPATHSEXT */
+  "SELECT Parent.name, Parent.handleidparent, Parent.handletsparent, Handle.deviceId, Handle.inode, Handle.nlink, Handle.ctime, Handle.ftype \
+     FROM Parent LEFT JOIN Handle ON Parent.handleidparent = Handle.handleid AND Parent.handletsparent=Handle.handleTs \
+     WHERE Parent.handleid=?1 AND Parent.handleTs=?2",
+  /* LOOKUPHANDLEBYNAME */
+  "SELECT Parent.handleid, Parent.handlets, Handle.deviceId, Handle.inode, Handle.nlink, Handle.ctime, Handle.ftype \
+     FROM Parent INNER JOIN Handle ON Parent.handleid = Handle.handleid AND Parent.handlets=Handle.handleTs \
+     WHERE handleidparent=?1 AND handletsparent=?2 AND name=?3",
+  /* LOOKUPHANDLEBYNAMEFU */
+  "SELECT Parent.handleid, Parent.handlets, Handle.deviceId, Handle.inode, Handle.nlink, Handle.ctime, Handle.ftype \
+     FROM Parent INNER JOIN Handle ON Parent.handleid = Handle.handleid AND Parent.handlets=Handle.handleTs \
+     WHERE handleidparent=?1 AND handletsparent=?2 AND name=?3",
+  /* LOOKUPROOTHANDLE */
+  "SELECT Parent.handleid, Parent.handlets, Handle.deviceId, Handle.inode, Handle.nlink, Handle.ctime, Handle.ftype \
+     FROM Parent INNER JOIN Handle ON Parent.handleid = Handle.handleid AND Parent.handlets=Handle.handleTs \
+     WHERE Parent.handleidparent=Parent.handleid AND Parent.handletsparent=Parent.handlets",
+  /* LOOKUPHANDLEBYINODEFU */
+  "SELECT handleId, handleTs, nlink, ctime, ftype \
+     FROM Handle \
+     WHERE deviceid=?1 AND inode=?2",
+  /* LOOKUPHANDLEFU */
+  "SELECT Handle.deviceId, Handle.inode, Handle.nlink, Handle.ctime, Handle.ftype \
+     FROM Handle \
+     WHERE handleid=?1 AND handleTs=?2",
+  /* LOOKUPHANDLE */
+  "SELECT Handle.deviceId, Handle.inode, Handle.nlink, Handle.ctime, Handle.ftype \
+     FROM Handle \
+     WHERE handleid=?1 AND handleTs=?2",
+  /* UPDATEHANDLE */
+  "UPDATE Handle \
+     SET ctime=?4, nlink=?3 \
+     WHERE handleid=?1 AND handleTs=?2",
+  /* UPDATEHANDLENLINK */
+  "UPDATE Handle \
+     SET nlink=?3 \
+     WHERE handleid=?1 AND handleTs=?2",
+  /* LOOKUPPARENT */
+  "SELECT handleid, handlets \
+     FROM Parent \
+     WHERE handleidparent=?1 AND handletsparent=?2 AND name=?3",
+  /* LOOKUPCHILDRENFU */
+  "SELECT Handle.handleid, Handle.handlets, Handle.ftype, Parent.name, Handle.nlink \
+     FROM Parent INNER JOIN Handle ON Handle.handleid=Parent.handleid AND Handle.handlets=Parent.handlets \
+     WHERE Parent.handleidparent=?1 AND Parent.handletsparent=?2 \
+       AND NOT (Parent.handleidparent = Parent.handleid AND Parent.handletsparent = Parent.handlets)",
+  /* LOOKUPCHILDREN */
+  "SELECT Handle.handleid, Handle.handlets, Parent.name, Handle.inode, Handle.deviceid, Handle.nlink, Handle.ctime, Handle.ftype \
+     FROM Parent INNER JOIN Handle ON Handle.handleid=Parent.handleid AND Handle.handlets=Parent.handlets \
+     WHERE Parent.handleidparent=?1 AND Parent.handletsparent=?2 \
+       AND NOT (Parent.handleidparent = Parent.handleid AND Parent.handletsparent = Parent.handlets)",
+  /* COUNTCHILDREN */
+  "SELECT count(*) \
+     FROM Parent INNER JOIN Handle ON Handle.handleid=Parent.handleid AND Handle.handlets=Parent.handlets \
+     WHERE Parent.handleidparent=?1 AND Parent.handletsparent=?2 \
+       AND NOT (Parent.handleidparent = Parent.handleid AND Parent.handletsparent = Parent.handlets)",
+  /* INSERTHANDLE */
+  "INSERT INTO Handle(deviceid, inode, handleTs, nlink, ctime, ftype) \
+     VALUES (?1, ?2, ?3, ?4, ?5, ?6)",
+  /* UPDATEPARENT */
+  "UPDATE Parent \
+     SET handleidparent=?4, handletsparent=?5, name=?6 \
+     WHERE handleidparent=?1 AND handletsparent=?2 AND name=?3",
+  /* INSERTPARENT */
+  "INSERT INTO Parent(handleidparent, handletsparent, name, handleid, handlets) \
+     VALUES(?1, ?2, ?3, ?4, ?5)",
+  /* DELETEPARENT */
+  "DELETE FROM Parent WHERE handleidparent=?1 AND handletsparent=?2 AND name=?3",
+  /* DELETEHANDLE */
+  "DELETE FROM Handle WHERE handleid=?1 AND handlets=?2"
+};
+
+/* check the journal mode returned by "PRAGMA journal_mode" */
+static int check_journal_mode(void *arg, int ncol, char **values, char **names)
+{
+  if(ncol > 0 && values[0] && strcasecmp(values[0], "wal"))
+    LogMajor(COMPONENT_FSAL,
+             "Could not set WAL journal mode for database (mode is '%s'): readers will be blocked by writers",
+             values[0]);
+  return 0;
+}
+
+fsal_posixdb_status_t fsal_posixdb_connect(fsal_posixdb_conn_params_t * dbparams,
+                                           fsal_posixdb_conn ** p_conn)
+{
+  fsal_posixdb_status_t st;
+  char query[FSAL_MAX_PATH_LEN + 64];
+  int rc;
+
+  *p_conn = (fsal_posixdb_conn *) Mem_Alloc(sizeof(fsal_posixdb_conn));
+  if(*p_conn == NULL)
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: failed to allocate memory");
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NO_MEM, errno);
+    }
+  memset(*p_conn, 0, sizeof(fsal_posixdb_conn));
+
+  /* each thread has its own connection, no need for SQLite mutexes */
+  rc = sqlite3_open_v2(dbparams->dbfile, &(*p_conn)->db_conn,
+                       SQLITE_OPEN_READWRITE | SQLITE_OPEN_CREATE | SQLITE_OPEN_NOMUTEX,
+                       NULL);
+  if(rc != SQLITE_OK)
+    {
+      LogEvent(COMPONENT_FSAL, "ERROR: could not open database file '%s' : %s",
+               dbparams->dbfile,
+               (*p_conn)->db_conn ? sqlite3_errmsg((*p_conn)->db_conn) : sqlite3_errstr(rc));
+      sqlite3_close((*p_conn)->db_conn);
+      Mem_Free(*p_conn);
+      ReturnCodeDB(ERR_FSAL_POSIXDB_BADCONN, rc);
+    }
+
+  /* wait for the other threads to release the write lock */
+  sqlite3_busy_timeout((*p_conn)->db_conn, POSIXDB_SQLITE3_BUSY_TIMEOUT);
+
+  /* The write-ahead log keeps each commit atomic across a crash,
+   * and lets readers run concurrently with the writer.
+   * synchronous=NORMAL only syncs the log at checkpoints: the last transactions
+   * may be lost after a power failure, but the database stays consistent.
+   */
+  rc = sqlite3_exec((*p_conn)->db_conn, "PRAGMA journal_mode=WAL", check_journal_mode,
+                    NULL, NULL);
+  if(rc != SQLITE_OK)
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: could not set journal mode of database '%s' : %s",
+              dbparams->dbfile, sqlite3_errmsg((*p_conn)->db_conn));
+      fsal_posixdb_disconnect(*p_conn);
+      ReturnCodeDB(ERR_FSAL_POSIXDB_BADCONN, rc);
+    }
+
+  snprintf(query, sizeof(query),
+           "PRAGMA synchronous=NORMAL; PRAGMA foreign_keys=ON; PRAGMA mmap_size=%lld;",
+           POSIXDB_SQLITE3_MMAP_SIZE);
+  st = db_exec_sql(*p_conn, query);
+
+  if(!FSAL_POSIXDB_IS_ERROR(st) && dbparams->tempdir[0] != '\0')
+    {
+      sqlite3_snprintf(sizeof(query), query, "PRAGMA temp_store_directory='%q'",
+                       dbparams->tempdir);
+      st = db_exec_sql(*p_conn, query);
+    }
+
+  /* create the tables if the database is new */
+  if(!FSAL_POSIXDB_IS_ERROR(st))
+    {
+      st = db_exec_sql(*p_conn, "BEGIN IMMEDIATE");
+      if(!FSAL_POSIXDB_IS_ERROR(st))
+        {
+          st = db_exec_sql(*p_conn, posixdb_schema);
+          if(FSAL_POSIXDB_IS_ERROR(st))
+            db_exec_sql(*p_conn, "ROLLBACK");
+          else
+            st = db_exec_sql(*p_conn, "COMMIT");
+        }
+    }
+
+  if(FSAL_POSIXDB_IS_ERROR(st))
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: could not initialize database '%s'",
+              dbparams->dbfile);
+      fsal_posixdb_disconnect(*p_conn);
+      return st;
+    }
+
+  /*
+     prepared statements
+   */
+  st = fsal_posixdb_initPreparedQueries(*p_conn);
+  if(FSAL_POSIXDB_IS_ERROR(st))
+    fsal_posixdb_disconnect(*p_conn);
+
+  return st;
+}
+
+fsal_posixdb_status_t fsal_posixdb_disconnect(fsal_posixdb_conn * p_conn)
+{
+  int i;
+
+  for(i = 0; i < NB_PREPARED_REQ; i++)
+    sqlite3_finalize(p_conn->stmt_tab[i]);
+
+  sqlite3_close(p_conn->db_conn);
+  Mem_Free(p_conn);
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
+
+fsal_posixdb_status_t fsal_posixdb_initPreparedQueries(fsal_posixdb_conn * p_conn)
+{
+  int i;
+  int rc;
+
+  for(i = 0; i < NB_PREPARED_REQ; i++)
+    {
+      rc = sqlite3_prepare_v2(p_conn->db_conn, posixdb_queries[i], -1,
+                              &p_conn->stmt_tab[i], NULL);
+      if(rc != SQLITE_OK)
+        {
+          LogCrit(COMPONENT_FSAL, "Failed to create prepared statement: Error: %s (query='%s')",
+                  sqlite3_errmsg(p_conn->db_conn), posixdb_queries[i]);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_CMDFAILED, rc);
+        }
+    }
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
@@ -0,0 +1,83 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "fsal_types.h"
+#include "posixdb_internal.h"
+#include <string.h>
+
+fsal_posixdb_status_t fsal_posixdb_delete(fsal_posixdb_conn * p_conn,   /* IN */
+                                          posixfsal_handle_t * p_parent_directory_handle,       /* IN */
+                                          fsal_name_t * p_filename,     /* IN */
+                                          fsal_posixdb_fileinfo_t *
+                                          p_object_info /* IN */ )
+{
+  fsal_posixdb_status_t st;
+
+  /*******************
+   * 1/ sanity check *
+   *******************/
+
+  if(!p_conn || !p_parent_directory_handle || !p_filename)
+    ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+
+  BeginUpdateTransaction(p_conn);
+
+  /*********************************************************
+   * 2/ Get information about the file and delete it       *
+   *    (NOENT is returned if the file does not exist)     *
+   *********************************************************/
+
+  st = fsal_posixdb_internal_delete(p_conn, p_parent_directory_handle->data.id,
+                                    p_parent_directory_handle->data.ts,
+                                    p_filename->name, p_object_info);
+  if(FSAL_POSIXDB_IS_ERROR(st))
+    {
+      RollbackTransaction(p_conn);
+      return st;
+    }
+
+  EndTransaction(p_conn);
+
+  return st;
+}
+
+fsal_posixdb_status_t fsal_posixdb_deleteHandle(fsal_posixdb_conn * p_conn,     /* IN */
+                                                posixfsal_handle_t *
+                                                p_parent_directory_handle /* IN */ )
+{
+  sqlite3_stmt *stmt;
+  int found;
+  int rc;
+  fsal_posixdb_status_t st;
+
+  BeginUpdateTransaction(p_conn);
+
+  LogFullDebug(COMPONENT_FSAL, "Deleting %llu.%u\n", p_parent_directory_handle->data.id,
+               p_parent_directory_handle->data.ts);
+
+  stmt = db_get_stmt(p_conn, LOOKUPHANDLEFU);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_parent_directory_handle->data.id);
+  sqlite3_bind_int(stmt, 2, (int)p_parent_directory_handle->data.ts);
+  rc = sqlite3_step(stmt);
+  CheckStep(p_conn, rc);
+
+  found = (rc == SQLITE_ROW);
+  sqlite3_reset(stmt);
+
+  if(found)
+    {
+      /* entry found */
+      st = fsal_posixdb_recursiveDelete(p_conn, p_parent_directory_handle->data.id,
+                                        p_parent_directory_handle->data.ts,
+                                        FSAL_TYPE_DIR);
+      if(FSAL_POSIXDB_IS_ERROR(st))
+        {
+          RollbackTransaction(p_conn);
+          return st;
+        }
+    }
+
+  EndTransaction(p_conn);
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
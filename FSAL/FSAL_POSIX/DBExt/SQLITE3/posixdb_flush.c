@@ -0,0 +1,23 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "fsal_types.h"
+#include "posixdb_internal.h"
+
+fsal_posixdb_status_t fsal_posixdb_flush(fsal_posixdb_conn * p_conn)
+{
+  fsal_posixdb_status_t st;
+
+  /* invalidate cache */
+  fsal_posixdb_InvalidateCache();
+
+  /* both tables are emptied in a single transaction */
+  st = db_exec_sql(p_conn, "BEGIN IMMEDIATE; \
+                            DELETE FROM Parent; \
+                            DELETE FROM Handle; \
+                            COMMIT;");
+  if(FSAL_POSIXDB_IS_ERROR(st))
+    RollbackTransaction(p_conn);
+
+  return st;
+}
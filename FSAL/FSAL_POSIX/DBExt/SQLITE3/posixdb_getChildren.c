@@ -0,0 +1,94 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+
+#include "posixdb_internal.h"
+#include "stuff_alloc.h"
+#include "fsal_types.h"
+#include "fsal.h"
+
+/**
+ * fsal_posixdb_getChildren:
+ * retrieve all the children of a directory handle.
+ *
+ * \param p_conn (input)
+ *        Database connection
+ * \param p_parent_directory_handle (input):
+ *        Handle of the directory where the objects to be retrieved are.
+ * \param p_children:
+ *        Children of p_parent_directory_handle. It is dynamically allocated inside the function. It have to be freed outside the function !!!
+ * \param p_count:
+ *        Number of children returned in p_children
+ * \return - FSAL_POSIXDB_NOERR, if no error.
+ *         - another error code else.
+ */
+fsal_posixdb_status_t fsal_posixdb_getChildren(fsal_posixdb_conn * p_conn,      /* IN */
+                                               posixfsal_handle_t * p_parent_directory_handle,  /* IN */
+                                               unsigned int max_count, fsal_posixdb_child ** p_children,        /* OUT */
+                                               unsigned int *p_count /* OUT */ )
+{
+  sqlite3_stmt *stmt;
+  unsigned int i;
+  int rc;
+
+  /* sanity check */
+  if(!p_conn || !p_parent_directory_handle || !(p_children) || !p_count)
+    ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+
+  stmt = db_get_stmt(p_conn, COUNTCHILDREN);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_parent_directory_handle->data.id);
+  sqlite3_bind_int(stmt, 2, (int)p_parent_directory_handle->data.ts);
+  rc = sqlite3_step(stmt);
+  CheckStep(p_conn, rc);
+
+  *p_count = (rc == SQLITE_ROW) ? (unsigned int)sqlite3_column_int(stmt, 0) : 0;
+  sqlite3_reset(stmt);
+
+  if(*p_count == 0)
+    {
+      *p_children = NULL;
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+    }
+
+  if(max_count && (*p_count > max_count))
+    {
+      *p_children = NULL;
+      LogCrit(COMPONENT_FSAL, "Children count %u exceed max_count %u in fsal_posixdb_getChildren",
+                 *p_count, max_count);
+      ReturnCodeDB(ERR_FSAL_POSIXDB_TOOMANYPATHS, 0);
+    }
+
+  *p_children = (fsal_posixdb_child *) Mem_Alloc(sizeof(fsal_posixdb_child) * (*p_count));
+  if(*p_children == NULL)
+    {
+      ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+    }
+
+  stmt = db_get_stmt(p_conn, LOOKUPCHILDREN);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_parent_directory_handle->data.id);
+  sqlite3_bind_int(stmt, 2, (int)p_parent_directory_handle->data.ts);
+
+  for(i = 0; i < *p_count && (rc = sqlite3_step(stmt)) == SQLITE_ROW; i++)
+    {
+      FSAL_str2name((char *)sqlite3_column_text(stmt, 2), FSAL_MAX_NAME_LEN,
+                    &((*p_children)[i].name));
+
+      (*p_children)[i].handle.data.id = (unsigned long long)sqlite3_column_int64(stmt, 0);
+      (*p_children)[i].handle.data.ts = (unsigned int)sqlite3_column_int(stmt, 1);
+      posixdb_internal_fillFileinfoFromColumns(&((*p_children)[i].handle.data.info), stmt,
+                                               4, 3, 5, 6, 7);
+    }
+  if(i < *p_count && rc != SQLITE_DONE)
+    {
+      Mem_Free(*p_children);
+      *p_children = NULL;
+      CheckStep(p_conn, rc);
+    }
+  sqlite3_reset(stmt);
+
+  /* entries may have been removed since they were counted */
+  *p_count = i;
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
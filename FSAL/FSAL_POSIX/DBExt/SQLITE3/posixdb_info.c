@@ -0,0 +1,318 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "fsal_types.h"
+#include "posixdb_internal.h"
+#include "string.h"
+
+fsal_posixdb_status_t fsal_posixdb_getInfoFromName(fsal_posixdb_conn * p_conn,  /* IN */
+                                                   posixfsal_handle_t * p_parent_directory_handle,      /* IN/OUT */
+                                                   fsal_name_t * p_objectname,  /* IN */
+                                                   fsal_path_t * p_path,        /* OUT */
+                                                   posixfsal_handle_t *
+                                                   p_handle /* OUT */ )
+{
+  sqlite3_stmt *stmt;
+  fsal_posixdb_status_t st;
+  int rc;
+  unsigned int generation;
+
+  /* sanity check */
+  if(!p_conn || !p_handle)
+    {
+      ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+    }
+
+  LogFullDebug(COMPONENT_FSAL, "object_name='%s'\n", p_objectname->name);
+
+  /* the entry and the path of its parent may be known by the cache */
+  if(p_parent_directory_handle && p_parent_directory_handle->data.id
+     && fsal_posixdb_GetNameCache(p_parent_directory_handle, p_objectname, p_handle))
+    {
+      if(!p_path)
+        ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+
+      if(fsal_posixdb_GetPathCache(p_parent_directory_handle, p_path)
+         && p_path->len + 1 + p_objectname->len < FSAL_MAX_PATH_LEN)
+        {
+          p_path->path[p_path->len] = '/';
+          strcpy(&p_path->path[p_path->len + 1], p_objectname->name);
+          p_path->len += 1 + p_objectname->len;
+          ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+        }
+    }
+
+  generation = fsal_posixdb_CacheGeneration();
+
+  BeginTransaction(p_conn);
+  /* lookup for the handle of the file */
+  if(p_parent_directory_handle && p_parent_directory_handle->data.id)
+    {
+      stmt = db_get_stmt(p_conn, LOOKUPHANDLEBYNAME);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_parent_directory_handle->data.id);
+      sqlite3_bind_int(stmt, 2, (int)p_parent_directory_handle->data.ts);
+      sqlite3_bind_text(stmt, 3, p_objectname->name, -1, SQLITE_STATIC);
+    }
+  else
+    {
+      // get root handle :
+      stmt = db_get_stmt(p_conn, LOOKUPROOTHANDLE);
+    }
+  rc = sqlite3_step(stmt);
+  CheckStep(p_conn, rc);
+  /* stmt contains : Parent.handleid, Parent.handlets, Handle.deviceId, Handle.inode, Handle.nlink, Handle.ctime, Handle.ftype  */
+
+  /* entry not found */
+  if(rc != SQLITE_ROW)
+    {
+      RollbackTransaction(p_conn);
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOENT, 0);
+    }
+
+  p_handle->data.id = (unsigned long long)sqlite3_column_int64(stmt, 0);
+  p_handle->data.ts = (unsigned int)sqlite3_column_int(stmt, 1);
+  posixdb_internal_fillFileinfoFromColumns(&(p_handle->data.info), stmt, 2, 3, 4,       /* nlink */
+                                           5,   /* ctime */
+                                           6    /* ftype */
+      );
+  sqlite3_reset(stmt);
+
+  /* remember the name and the informations about the handle */
+  if(p_parent_directory_handle && p_parent_directory_handle->data.id)
+    fsal_posixdb_CacheName(p_parent_directory_handle, p_objectname, p_handle,
+                           generation);
+  else
+    fsal_posixdb_UpdateInodeCache(p_handle, generation);
+
+  /* Build the path of the object */
+  if(p_path && p_objectname)
+    {
+      /* build the path of the Parent */
+      st = fsal_posixdb_buildOnePath(p_conn, p_parent_directory_handle, p_path);
+      if(st.major != ERR_FSAL_POSIXDB_NOERR)
+        {
+          RollbackTransaction(p_conn);
+          return st;
+        }
+
+      /* then concatenate the filename */
+      if(!(p_path->len + 1 + p_objectname->len < FSAL_MAX_PATH_LEN))
+        {
+          RollbackTransaction(p_conn);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_PATHTOOLONG, 0);
+        }
+      p_path->path[p_path->len] = '/';
+      strcpy(&p_path->path[p_path->len + 1], p_objectname->name);
+      p_path->len += 1 + p_objectname->len;
+
+      /* add the the path to cache */
+      fsal_posixdb_CachePath(p_handle, p_path, generation);
+    }
+
+  EndTransaction(p_conn);
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
+
+fsal_posixdb_status_t fsal_posixdb_getInfoFromHandle(fsal_posixdb_conn * p_conn,        /* IN */
+                                                     posixfsal_handle_t * p_object_handle,      /* IN/OUT */
+                                                     fsal_path_t * p_paths,     /* OUT */
+                                                     int paths_size,    /* IN */
+                                                     int *p_count /* OUT */ )
+{
+  sqlite3_stmt *stmt;
+  fsal_posixdb_status_t st;
+  posixfsal_handle_t parent_directory_handle;
+  int i_path;
+  int toomanypaths = 0;
+  int info_cached;
+  int rc;
+  unsigned int generation;
+
+  /* sanity check */
+  if(!p_conn || !p_object_handle || ((!p_paths || !p_count) && paths_size > 0))
+    {
+      ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+    }
+
+  LogFullDebug(COMPONENT_FSAL, "OBJECT_ID=%lli\n", p_object_handle->data.id);
+
+  /* the informations may be known by the cache, and also the path
+   * of an object that has only one */
+  info_cached = fsal_posixdb_GetInodeCache(p_object_handle);
+
+  if(info_cached
+     && (!p_paths
+         || (paths_size > 0
+             && (p_object_handle->data.info.ftype == FSAL_TYPE_DIR
+                 || p_object_handle->data.info.nlink == 1)
+             && fsal_posixdb_GetPathCache(p_object_handle, &p_paths[0]))))
+    {
+      if(p_paths)
+        *p_count = 1;
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+    }
+
+  generation = fsal_posixdb_CacheGeneration();
+
+  BeginTransaction(p_conn);
+
+  /* lookup for the handle of the file */
+  if(!info_cached)
+    {
+      stmt = db_get_stmt(p_conn, LOOKUPHANDLE);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_object_handle->data.id);
+      sqlite3_bind_int(stmt, 2, (int)p_object_handle->data.ts);
+      rc = sqlite3_step(stmt);
+      CheckStep(p_conn, rc);
+      /* stmt contains : Handle.deviceId, Handle.inode, Handle.nlink, Handle.ctime, Handle.ftype  */
+
+      LogDebug(COMPONENT_FSAL, "lookupHandle(%u,%u)", (unsigned int)p_object_handle->data.id,
+               (unsigned int)p_object_handle->data.ts);
+
+      /* entry not found */
+      if(rc != SQLITE_ROW)
+        {
+          LogDebug(COMPONENT_FSAL, "lookupHandle=0 entries");
+          RollbackTransaction(p_conn);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_NOENT, 0);
+        }
+
+      posixdb_internal_fillFileinfoFromColumns(&(p_object_handle->data.info), stmt, 0, 1, 2,    /* nlink */
+                                               3,       /* ctime */
+                                               4        /* ftype */
+          );
+      sqlite3_reset(stmt);
+
+      /* update the inode */
+      fsal_posixdb_UpdateInodeCache(p_object_handle, generation);
+    }
+
+  /* Build the paths of the object */
+  if(p_paths)
+    {
+      /* find all the paths to the object */
+      stmt = db_get_stmt(p_conn, LOOKUPPATHS);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_object_handle->data.id);
+      sqlite3_bind_int(stmt, 2, (int)p_object_handle->data.ts);
+      /* stmt contains name, handleidparent, handletsparent */
+
+      for(i_path = 0; (rc = sqlite3_step(stmt)) == SQLITE_ROW; i_path++)
+        {
+          const char *name;
+          unsigned int name_len;
+          unsigned int tmp_len;
+
+          if(i_path >= paths_size)
+            {
+              toomanypaths = 1;
+              break;
+            }
+
+          /* build the path of the parent directory */
+          parent_directory_handle.data.id =
+              (unsigned long long)sqlite3_column_int64(stmt, 1);
+          parent_directory_handle.data.ts = (unsigned int)sqlite3_column_int(stmt, 2);
+
+          st = fsal_posixdb_buildOnePath(p_conn, &parent_directory_handle,
+                                         &p_paths[i_path]);
+          if(st.major != ERR_FSAL_POSIXDB_NOERR)
+            {
+              RollbackTransaction(p_conn);
+              return st;
+            }
+
+          name = (const char *)sqlite3_column_text(stmt, 0);
+          name_len = sqlite3_column_bytes(stmt, 0);
+          tmp_len = p_paths[i_path].len;
+
+          if((tmp_len > 0) && (p_paths[i_path].path[tmp_len - 1] == '/'))
+            {
+              /* then concatenate the name of the file */
+              /* but not concatenate '/' */
+              if(tmp_len + name_len >= FSAL_MAX_PATH_LEN)
+                {
+                  RollbackTransaction(p_conn);
+                  ReturnCodeDB(ERR_FSAL_POSIXDB_PATHTOOLONG, 0);
+                }
+              strcpy(&p_paths[i_path].path[tmp_len], name);
+              p_paths[i_path].len += name_len;
+
+            }
+          else
+            {
+              /* then concatenate the name of the file */
+              if(tmp_len + 1 + name_len >= FSAL_MAX_PATH_LEN)
+                {
+                  RollbackTransaction(p_conn);
+                  ReturnCodeDB(ERR_FSAL_POSIXDB_PATHTOOLONG, 0);
+                }
+              p_paths[i_path].path[tmp_len] = '/';
+              strcpy(&p_paths[i_path].path[tmp_len + 1], name);
+              p_paths[i_path].len += 1 + name_len;
+            }
+        }
+      if(!toomanypaths)
+        CheckStep(p_conn, rc);
+      sqlite3_reset(stmt);
+
+      *p_count = i_path;
+
+      if(*p_count == 0)
+        {
+          RollbackTransaction(p_conn);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_NOPATH, 0);
+        }
+
+      if(toomanypaths)
+        LogCrit(COMPONENT_FSAL, "Too many paths found for object %llu.%u: max=%d",
+                p_object_handle->data.id, p_object_handle->data.ts, paths_size);
+
+      /* insert the object into cache, if it has only one path */
+      if(*p_count == 1 && !toomanypaths)
+        fsal_posixdb_CachePath(p_object_handle, &p_paths[0], generation);
+    }
+
+  EndTransaction(p_conn);
+
+  ReturnCodeDB(toomanypaths ? ERR_FSAL_POSIXDB_TOOMANYPATHS : ERR_FSAL_POSIXDB_NOERR, 0);
+}
+
+fsal_posixdb_status_t fsal_posixdb_getParentDirHandle(fsal_posixdb_conn * p_conn,       /* IN */
+                                                      posixfsal_handle_t * p_object_handle,     /* IN */
+                                                      posixfsal_handle_t * p_parent_directory_handle    /* OUT */
+    )
+{
+  sqlite3_stmt *stmt;
+  int rc;
+
+  /* sanity check */
+  if(!p_conn || !p_parent_directory_handle || !p_object_handle)
+    ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+
+  /* no need to start a transaction, there is anly one query */
+  stmt = db_get_stmt(p_conn, LOOKUPPATHSEXT);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_object_handle->data.id);
+  sqlite3_bind_int(stmt, 2, (int)p_object_handle->data.ts);
+  rc = sqlite3_step(stmt);
+  CheckStep(p_conn, rc);
+
+  /* entry not found */
+  if(rc != SQLITE_ROW)
+    {
+      sqlite3_reset(stmt);
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOENT, 0);
+    }
+  LogDebug(COMPONENT_FSAL, "lookupPathsExt");
+
+  p_parent_directory_handle->data.id = (unsigned long long)sqlite3_column_int64(stmt, 1);
+  p_parent_directory_handle->data.ts = (unsigned int)sqlite3_column_int(stmt, 2);
+  posixdb_internal_fillFileinfoFromColumns(&(p_parent_directory_handle->data.info), stmt, 3, 4, 5,      /* nlink */
+                                           6,   /* ctime */
+                                           7    /* ftype */
+      );
+
+  sqlite3_reset(stmt);
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
@@ -0,0 +1,441 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "fsal_types.h"
+#include "posixdb_internal.h"
+#include "posixdb_consistency.h"
+#include "fsal.h"
+#include "stuff_alloc.h"
+#include "string.h"
+
+fsal_posixdb_status_t db_error_convert(int rc)
+{
+  switch (rc & 0xff)            /* primary result code */
+    {
+    case SQLITE_OK:
+    case SQLITE_ROW:
+    case SQLITE_DONE:
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+    case SQLITE_CONSTRAINT:
+      ReturnCodeDB(ERR_FSAL_POSIXDB_CONSISTENCY, rc);
+    case SQLITE_NOMEM:
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NO_MEM, rc);
+    case SQLITE_CANTOPEN:
+    case SQLITE_NOTADB:
+      ReturnCodeDB(ERR_FSAL_POSIXDB_BADCONN, rc);
+    default:
+      ReturnCodeDB(ERR_FSAL_POSIXDB_CMDFAILED, rc);
+    }
+}
+
+fsal_posixdb_status_t db_exec_sql(fsal_posixdb_conn * p_conn, const char *query)
+{
+  int rc;
+  char *errmsg = NULL;
+
+  LogFullDebug(COMPONENT_FSAL, "SQL query: %s", query);
+
+  rc = sqlite3_exec(p_conn->db_conn, query, NULL, NULL, &errmsg);
+
+  if(rc != SQLITE_OK)
+    {
+      LogMajor(COMPONENT_FSAL, "DB request failed: %s (query: %s)",
+               errmsg ? errmsg : sqlite3_errstr(rc), query);
+      sqlite3_free(errmsg);
+      return db_error_convert(rc);
+    }
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
+
+sqlite3_stmt *db_get_stmt(fsal_posixdb_conn * p_conn, int index)
+{
+  sqlite3_stmt *stmt = p_conn->stmt_tab[index];
+
+  /* the statement may not have been reset after its last use */
+  sqlite3_reset(stmt);
+  sqlite3_clear_bindings(stmt);
+
+  return stmt;
+}
+
+/* Reset all the prepared statements, so that none of them keeps a snapshot
+ * of the database (this would prevent the WAL from being checkpointed).
+ */
+static void db_reset_stmts(fsal_posixdb_conn * p_conn)
+{
+  int i;
+
+  for(i = 0; i < NB_PREPARED_REQ; i++)
+    if(p_conn->stmt_tab[i])
+      sqlite3_reset(p_conn->stmt_tab[i]);
+}
+
+fsal_posixdb_status_t db_begin_transaction(fsal_posixdb_conn * p_conn, int for_update)
+{
+  /* a transaction is already opened */
+  if(!sqlite3_get_autocommit(p_conn->db_conn))
+    ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+
+  return db_exec_sql(p_conn, for_update ? "BEGIN IMMEDIATE" : "BEGIN");
+}
+
+fsal_posixdb_status_t db_end_transaction(fsal_posixdb_conn * p_conn)
+{
+  fsal_posixdb_status_t st;
+
+  db_reset_stmts(p_conn);
+
+  if(sqlite3_get_autocommit(p_conn->db_conn))
+    ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+
+  st = db_exec_sql(p_conn, "COMMIT");
+  if(FSAL_POSIXDB_IS_ERROR(st))
+    db_rollback_transaction(p_conn);
+
+  return st;
+}
+
+void db_rollback_transaction(fsal_posixdb_conn * p_conn)
+{
+  db_reset_stmts(p_conn);
+
+  if(!sqlite3_get_autocommit(p_conn->db_conn))
+    db_exec_sql(p_conn, "ROLLBACK");
+}
+
+fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,
+                                                posixfsal_handle_t * p_handle,
+                                                fsal_path_t * p_path)
+{
+  sqlite3_stmt *stmt;
+  unsigned long long last_id;
+  unsigned int last_ts;
+  unsigned long long id;
+  unsigned int ts;
+  const char *name;
+  unsigned int shift;
+  char *new_pos;
+  int toomanypaths = 0;
+  int rc;
+  unsigned int generation;
+
+  if(!p_conn || !p_handle || !p_path)
+    {
+      ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+    }
+
+  /* init values */
+  memset(p_path, 0, sizeof(fsal_path_t));
+
+  /* Nothing to do, it's the root path */
+  if(p_handle->data.id == 0 && p_handle->data.ts == 0)
+    ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+
+  /* check if the entry is in the cache */
+  if(fsal_posixdb_GetPathCache(p_handle, p_path))
+    ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+
+  generation = fsal_posixdb_CacheGeneration();
+
+  last_id = p_handle->data.id;
+  last_ts = p_handle->data.ts;
+
+  stmt = db_get_stmt(p_conn, BUILDONEPATH);
+
+  while(1)
+    {
+      sqlite3_reset(stmt);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) last_id);
+      sqlite3_bind_int(stmt, 2, (int)last_ts);
+
+      rc = sqlite3_step(stmt);
+      CheckStep(p_conn, rc);
+
+      if(rc == SQLITE_DONE)
+        {
+          sqlite3_reset(stmt);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_NOENT, 0);      /* not found */
+        }
+
+      id = (unsigned long long)sqlite3_column_int64(stmt, 1);
+      ts = (unsigned int)sqlite3_column_int(stmt, 2);
+
+      if((id == last_id) && (ts == last_ts))
+        break;                  /* handle is equal to its parent handle (root reached) */
+
+      /* insertion of the name at the beginning of the path */
+      name = (const char *)sqlite3_column_text(stmt, 0);
+      shift = sqlite3_column_bytes(stmt, 0);
+      if(p_path->len + shift >= FSAL_MAX_PATH_LEN)
+        {
+          sqlite3_reset(stmt);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_PATHTOOLONG, 0);
+        }
+      new_pos = p_path->path + shift;
+      memmove(new_pos, p_path->path, p_path->len);
+      memcpy(p_path->path, name, shift);
+      p_path->len += shift;
+
+      /* a directory should have only one path */
+      if(sqlite3_step(stmt) == SQLITE_ROW)
+        {
+          LogCrit(COMPONENT_FSAL, "Too many paths found for object %llu.%u: expected=1",
+                  last_id, last_ts);
+
+          toomanypaths++;       /* too many entries */
+        }
+
+      /* prepare next step */
+      last_id = id;
+      last_ts = ts;
+    }
+
+  sqlite3_reset(stmt);
+
+  if(toomanypaths)
+    {
+      LogCrit(COMPONENT_FSAL, "Returned path: %s", p_path->path);
+      ReturnCodeDB(ERR_FSAL_POSIXDB_TOOMANYPATHS, toomanypaths);        /* too many entries */
+    }
+  else
+    {
+      /* set result in cache */
+      fsal_posixdb_CachePath(p_handle, p_path, generation);
+
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+    }
+}
+
+fsal_posixdb_status_t fsal_posixdb_recursiveDelete(fsal_posixdb_conn * p_conn,
+                                                   unsigned long long id, unsigned int ts,
+                                                   fsal_nodetype_t ftype)
+{
+  sqlite3_stmt *stmt;
+  fsal_posixdb_status_t st;
+  fsal_posixdb_child *p_children;
+  unsigned int count;
+  unsigned int i;
+  int rc;
+
+  /* Sanity check */
+  if(!p_conn)
+    {
+      ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+    }
+
+  if(ftype == FSAL_TYPE_DIR)
+    {
+      /* We find all the children of the directory in order to delete them, and then we delete the current handle.
+       * The children are read before deleting them: the statement can not be used again
+       * by the recursive calls while it is walking the Parent table.
+       */
+      stmt = db_get_stmt(p_conn, COUNTCHILDREN);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) id);
+      sqlite3_bind_int(stmt, 2, (int)ts);
+      rc = sqlite3_step(stmt);
+      CheckStep(p_conn, rc);
+      count = (rc == SQLITE_ROW) ? (unsigned int)sqlite3_column_int(stmt, 0) : 0;
+      sqlite3_reset(stmt);
+
+      if(count > 0)
+        {
+          p_children =
+              (fsal_posixdb_child *) Mem_Alloc(sizeof(fsal_posixdb_child) * count);
+          if(p_children == NULL)
+            ReturnCodeDB(ERR_FSAL_POSIXDB_NO_MEM, 0);
+
+          stmt = db_get_stmt(p_conn, LOOKUPCHILDRENFU);
+          sqlite3_bind_int64(stmt, 1, (sqlite3_int64) id);
+          sqlite3_bind_int(stmt, 2, (int)ts);
+
+          for(i = 0; i < count && (rc = sqlite3_step(stmt)) == SQLITE_ROW; i++)
+            {
+              p_children[i].handle.data.id =
+                  (unsigned long long)sqlite3_column_int64(stmt, 0);
+              p_children[i].handle.data.ts = (unsigned int)sqlite3_column_int(stmt, 1);
+              p_children[i].handle.data.info.ftype =
+                  (fsal_nodetype_t) sqlite3_column_int(stmt, 2);
+              FSAL_str2name((char *)sqlite3_column_text(stmt, 3), FSAL_MAX_NAME_LEN,
+                            &p_children[i].name);
+              p_children[i].handle.data.info.nlink = sqlite3_column_int(stmt, 4);
+            }
+          count = i;
+          sqlite3_reset(stmt);
+
+          for(i = 0; i < count; i++)
+            {
+              if(p_children[i].handle.data.info.ftype == FSAL_TYPE_DIR)
+                {
+                  st = fsal_posixdb_recursiveDelete(p_conn, p_children[i].handle.data.id,
+                                                    p_children[i].handle.data.ts,
+                                                    FSAL_TYPE_DIR);
+                }
+              else
+                {
+                  st = fsal_posixdb_deleteParent(p_conn, p_children[i].handle.data.id,
+                                                 p_children[i].handle.data.ts, id, ts,
+                                                 p_children[i].name.name,
+                                                 p_children[i].handle.data.info.nlink);
+                }
+              if(FSAL_POSIXDB_IS_ERROR(st))
+                {
+                  Mem_Free(p_children);
+                  return st;
+                }
+            }
+          Mem_Free(p_children);
+        }
+    }
+
+  /* invalidate the handle (and the names leading to it) */
+  fsal_posixdb_InvalidateHandle(id, ts);
+
+  /* Delete the Handle */
+  /* All Parent entries having this handle will be deleted thanks to foreign keys */
+  stmt = db_get_stmt(p_conn, DELETEHANDLE);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) id);
+  sqlite3_bind_int(stmt, 2, (int)ts);
+  rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  CheckStep(p_conn, rc);
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
+
+fsal_posixdb_status_t fsal_posixdb_deleteParent(fsal_posixdb_conn * p_conn,     /* IN */
+                                                unsigned long long id,  /* IN */
+                                                unsigned int ts,        /* IN */
+                                                unsigned long long idparent,    /* IN */
+                                                unsigned int tsparent,  /* IN */
+                                                char *filename, /* IN */
+                                                int nlink)      /* IN */
+{
+  sqlite3_stmt *stmt;
+  int rc;
+
+  /* Sanity check */
+  if(!p_conn || !filename || nlink < 1)
+    {
+      ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+    }
+
+  /* invalidate name cache */
+  fsal_posixdb_InvalidateName(idparent, tsparent, filename);
+
+  /* delete the Parent entry */
+  stmt = db_get_stmt(p_conn, DELETEPARENT);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) idparent);
+  sqlite3_bind_int(stmt, 2, (int)tsparent);
+  sqlite3_bind_text(stmt, 3, filename, -1, SQLITE_STATIC);
+  rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  CheckStep(p_conn, rc);
+
+  /* invalidate handle cache */
+  fsal_posixdb_InvalidateHandle(id, ts);
+
+  /* delete the handle or update it */
+  if(nlink == 1)
+    {
+      /* delete the handle */
+      /* If there are other entries in the Parent table with this Handle, they will be deleted (thanks to foreign keys) */
+      stmt = db_get_stmt(p_conn, DELETEHANDLE);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) id);
+      sqlite3_bind_int(stmt, 2, (int)ts);
+    }
+  else
+    {
+      /* update the Handle entry ( Handle.nlink <- (nlink - 1) ) */
+      stmt = db_get_stmt(p_conn, UPDATEHANDLENLINK);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) id);
+      sqlite3_bind_int(stmt, 2, (int)ts);
+      sqlite3_bind_int(stmt, 3, nlink - 1);
+    }
+  rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+  CheckStep(p_conn, rc);
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
+
+fsal_posixdb_status_t fsal_posixdb_internal_delete(fsal_posixdb_conn * p_conn,  /* IN */
+                                                   unsigned long long idparent, /* IN */
+                                                   unsigned int tsparent,       /* IN */
+                                                   char *filename,      /* IN */
+                                                   fsal_posixdb_fileinfo_t *
+                                                   p_object_info /* IN */ )
+{
+  sqlite3_stmt *stmt;
+  unsigned long long id;
+  unsigned int ts;
+  fsal_posixdb_status_t st;
+  fsal_posixdb_fileinfo_t infodb;
+  int rc;
+
+  if(!p_conn || !filename)
+    ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+
+  stmt = db_get_stmt(p_conn, LOOKUPHANDLEBYNAMEFU);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) idparent);
+  sqlite3_bind_int(stmt, 2, (int)tsparent);
+  sqlite3_bind_text(stmt, 3, filename, -1, SQLITE_STATIC);
+  rc = sqlite3_step(stmt);
+  CheckStep(p_conn, rc);
+  /* stmt contains : handleid, handlets, deviceId, inode, nlink, ctime, ftype  */
+
+  /* no entry found */
+  if(rc != SQLITE_ROW)
+    {
+      sqlite3_reset(stmt);
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOENT, 0);
+    }
+
+  id = (unsigned long long)sqlite3_column_int64(stmt, 0);
+  ts = (unsigned int)sqlite3_column_int(stmt, 1);
+
+  /* consistency check */
+  /* fill 'infodb' with information about the handle in the database */
+  posixdb_internal_fillFileinfoFromColumns(&infodb, stmt, 2, 3, 4, 5, 6);
+  sqlite3_reset(stmt);
+
+  if(p_object_info && fsal_posixdb_consistency_check(&infodb, p_object_info))
+    {
+      /* not consistent, the bad handle have to be deleted */
+      LogCrit(COMPONENT_FSAL, "Consistency check failed while deleting a Path : Handle deleted");
+      infodb.ftype = FSAL_TYPE_DIR;     /* considers that the entry is a directory in order to delete all its Parent entries and its Handle */
+    }
+
+  switch (infodb.ftype)
+    {
+    case FSAL_TYPE_DIR:
+      /* directory */
+      st = fsal_posixdb_recursiveDelete(p_conn, id, ts, infodb.ftype);
+      break;
+    default:
+      st = fsal_posixdb_deleteParent(p_conn,
+                                     id, ts, idparent, tsparent, filename, infodb.nlink);
+    }
+  return st;
+}
+
+fsal_posixdb_status_t posixdb_internal_fillFileinfoFromColumns(fsal_posixdb_fileinfo_t *
+                                                               p_info, sqlite3_stmt * stmt,
+                                                               int devid_col,
+                                                               int inode_col,
+                                                               int nlink_col,
+                                                               int ctime_col,
+                                                               int ftype_col)
+{
+
+  if(!p_info || !stmt)
+    ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+
+  p_info->devid = devid_col >= 0 ? (dev_t) sqlite3_column_int64(stmt, devid_col) : 0;
+  p_info->inode = inode_col >= 0 ? (ino_t) sqlite3_column_int64(stmt, inode_col) : 0;
+  p_info->nlink = nlink_col >= 0 ? sqlite3_column_int(stmt, nlink_col) : 0;
+  p_info->ctime = ctime_col >= 0 ? (time_t) sqlite3_column_int(stmt, ctime_col) : 0;
+  p_info->ftype = ftype_col >= 0 ? (fsal_nodetype_t) sqlite3_column_int(stmt, ftype_col) : 0;
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
@@ -0,0 +1,197 @@
+#ifndef _POSIXDB_INTERNAL_H
+#define _POSIXDB_INTERNAL_H
+
+#include "fsal_types.h"
+
+/* time (in msec) a connection waits for the write lock of the database,
+ * held by another thread, before giving up */
+#define POSIXDB_SQLITE3_BUSY_TIMEOUT  60000
+
+/* size of the database file that is memory mapped for reading */
+#define POSIXDB_SQLITE3_MMAP_SIZE     268435456LL
+
+#define ReturnCodeDB( _code_, _minor_ ) do {                 \
+               fsal_posixdb_status_t _struct_status_;        \
+               if(isFullDebug(COMPONENT_FSAL))               \
+                 {                                           \
+                   LogCrit(COMPONENT_FSAL, "Exiting %s ( %s:%i ) with status code = %i/%i\n", __FUNCTION__, __FILE__, __LINE__ - 2, _code_, _minor_ ); \
+                 }                                           \
+               (_struct_status_).major = (_code_) ;          \
+               (_struct_status_).minor = (_minor_) ;         \
+               return (_struct_status_);                     \
+              } while(0)
+
+/* check the result of sqlite3_step() */
+#define CheckStep( _conn_, _rc_ ) do { \
+                              if ((_rc_) != SQLITE_ROW && (_rc_) != SQLITE_DONE)                       \
+                                {                                                                       \
+                                    LogCrit(COMPONENT_FSAL, "SQLite request failed in %s ( %s:%i ) with %s", __FUNCTION__, __FILE__, __LINE__, sqlite3_errmsg((_conn_)->db_conn)); \
+                                    RollbackTransaction( _conn_ );  \
+                                    return db_error_convert( _rc_ ); \
+                                } \
+                              } while (0)
+
+/* Read-only transactions are deferred: they only take a snapshot of the
+ * database, and never wait for the writers (WAL mode).
+ * Update transactions take the write lock of the database immediately,
+ * as the "SELECT ... FOR UPDATE" of the other backends would do.
+ * Like with the other backends, a transaction that is already opened
+ * (by fsal_posixdb_lockHandleForUpdate) is kept.
+ */
+#define BeginTransaction( _conn_ )   do { \
+                                       fsal_posixdb_status_t _st_ = db_begin_transaction( _conn_, FALSE ); \
+                                       if(FSAL_POSIXDB_IS_ERROR(_st_)) return _st_; \
+                                     } while (0)
+
+#define BeginUpdateTransaction( _conn_ )   do { \
+                                       fsal_posixdb_status_t _st_ = db_begin_transaction( _conn_, TRUE ); \
+                                       if(FSAL_POSIXDB_IS_ERROR(_st_)) return _st_; \
+                                     } while (0)
+
+#define EndTransaction( _conn_ )     do { \
+                                       fsal_posixdb_status_t _st_ = db_end_transaction( _conn_ ); \
+                                       if(FSAL_POSIXDB_IS_ERROR(_st_)) return _st_; \
+                                     } while (0)
+
+#define RollbackTransaction( _conn_ )  db_rollback_transaction( _conn_ )
+
+/**
+ * db_exec_sql:
+ * Execute one or several SQL statements that return no value.
+ */
+fsal_posixdb_status_t db_exec_sql(fsal_posixdb_conn * p_conn, const char *query);
+
+/**
+ * db_error_convert:
+ * Convert an SQLite result code to a posixdb status.
+ */
+fsal_posixdb_status_t db_error_convert(int rc);
+
+/**
+ * db_get_stmt:
+ * Get a prepared statement, ready to be bound and executed.
+ */
+sqlite3_stmt *db_get_stmt(fsal_posixdb_conn * p_conn, int index);
+
+/* transaction management (see the macros above) */
+fsal_posixdb_status_t db_begin_transaction(fsal_posixdb_conn * p_conn, int for_update);
+fsal_posixdb_status_t db_end_transaction(fsal_posixdb_conn * p_conn);
+void db_rollback_transaction(fsal_posixdb_conn * p_conn);
+
+/**
+ * fsal_posixdb_buildOnePath:
+ * Build the path of an object with only one Path in the parent table (usually a directory).
+ *
+ * \param p_conn (input)
+ *    Connection to the database
+ * \param p_handle (input)
+ *    Handle of the object we want the path
+ * \param path (output)
+ *    Path of the object
+ * \return - FSAL_POSIXDB_NOERR, if no error.
+ *           Another error code else.
+ */
+fsal_posixdb_status_t fsal_posixdb_buildOnePath(fsal_posixdb_conn * p_conn,     /* IN */
+                                                posixfsal_handle_t * p_handle,  /* IN */
+                                                fsal_path_t * p_path /* OUT */ );
+
+/**
+ * fsal_posixdb_recursiveDelete:
+ * Delete a handle and all its entries in the Parent table. If the object is a directory, then all its entries will be recursively deleted.
+ *
+ * \param p_conn (input)
+ *    Connection to the database
+ * \param id (input)
+ *    ID part of the handle
+ * \param ts (input)
+ *    Timestamp part of the handle
+ * \param ftype (input)
+ *    Type of the object (regular file, directory, ...)
+ * \return - FSAL_POSIXDB_NOERR, if no error.
+ *           Another error code else.
+ */
+fsal_posixdb_status_t fsal_posixdb_recursiveDelete(fsal_posixdb_conn * p_conn,  /* IN */
+                                                   unsigned long long id,       /* IN */
+                                                   unsigned int ts,     /* IN */
+                                                   fsal_nodetype_t ftype);      /* IN */
+
+/**
+ * fsal_posixdb_deleteParent:
+ * Delete a parent entry. If the handle has no more links, then it is also deleted.
+ * Notice : do not use with a directory
+ *
+ * \param p_conn (input)
+ *    Connection to the database
+ * \param id (input)
+ *    ID part of the handle of the object
+ * \param ts (input)
+ *    Timestamp part of the handle of the object
+ * \param idparent (input)
+ *    ID part of the handle of the parent directory
+ * \param tsparent (input)
+ *    Timestamp part of the handle of the parent directory
+ * \param filename (input)
+ *    Filename of the entry to delete
+ * \param nlink (input)
+ *    Number of hardlink on the object
+ * \return - FSAL_POSIXDB_NOERR, if no error.
+ *           Another error code else.
+ */
+fsal_posixdb_status_t fsal_posixdb_deleteParent(fsal_posixdb_conn * p_conn,     /* IN */
+                                                unsigned long long id,  /* IN */
+                                                unsigned int ts,        /* IN */
+                                                unsigned long long idparent,    /* IN */
+                                                unsigned int tsparent,  /* IN */
+                                                char *filename, /* IN */
+                                                int nlink) /* IN */ ;
+
+/**
+ * fsal_posixdb_internal_delete:
+ * Delete a Parent entry knowing its parent handle and its name
+ *
+ * \see fsal_posixdb_delete
+ */
+fsal_posixdb_status_t fsal_posixdb_internal_delete(fsal_posixdb_conn * p_conn,  /* IN */
+                                                   unsigned long long idparent, /* IN */
+                                                   unsigned int tsparent,       /* IN */
+                                                   char *filename,      /* IN */
+                                                   fsal_posixdb_fileinfo_t *
+                                                   p_object_info /* IN */ );
+
+/**
+ * fsal_posixdb_initPreparedQueries:
+ * setup the prepared queries for a new connection
+ *
+ * \param p_conn (input)
+ *    Connection to the database
+ * \return - ERR_FSAL_POSIXDB_NOERR, if no error.
+ *           Another error code else.
+ */
+fsal_posixdb_status_t fsal_posixdb_initPreparedQueries(fsal_posixdb_conn * p_conn);
+
+/**
+ * @brief Fill a fsal_posixdb_fileinfo_t struct from the columns of a statement
+ *
+ * @param p_info
+ * @param stmt
+ * @param devid_col (-1 if the statement does not return it)
+ * @param inode_col (-1 if the statement does not return it)
+ * @param nlink_col
+ * @param ctime_col
+ * @param ftype_col
+ *
+ * @return ERR_FSAL_POSIXDB_NOERR, if no error
+ *         ERR_FSAL_POSIXDB_FAULT if p_info is NULL
+ */
+fsal_posixdb_status_t posixdb_internal_fillFileinfoFromColumns(fsal_posixdb_fileinfo_t *
+                                                               p_info, sqlite3_stmt * stmt,
+                                                               int devid_col,
+                                                               int inode_col,
+                                                               int nlink_col,
+                                                               int ctime_col,
+                                                               int ftype_col);
+
+/* the handle, path and name cache is shared by the posixdb backends */
+#include "../posixdb_cache.h"
+
+#endif
@@ -0,0 +1,47 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "fsal_types.h"
+#include "posixdb_internal.h"
+#include <string.h>
+
+/** 
+ * @brief Lock the line of the Handle table with inode & devid defined in p_info
+ *
+ * SQLite has no row locks: the write lock of the whole database is taken
+ * by starting an update transaction.
+ * 
+ * @param p_conn
+ *        Database connection
+ * @param p_info 
+ *        Information about the file
+ * 
+ * @return ERR_FSAL_POSIXDB_NOERR if no error,
+ *         another error code else.
+ */
+fsal_posixdb_status_t fsal_posixdb_lockHandleForUpdate(fsal_posixdb_conn * p_conn,      /* IN */
+                                                       fsal_posixdb_fileinfo_t *
+                                                       p_info /* IN */ )
+{
+  BeginUpdateTransaction(p_conn);
+
+  /* Do not end the transaction, because it will be closed by the next call to a posixdb function */
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
+
+/** 
+ * @brief Unlock the Handle line previously locked by fsal_posixdb_lockHandleForUpdate
+ * 
+ * @param p_conn
+ *        Database connection
+ * 
+ * @return ERR_FSAL_POSIXDB_NOERR if no error,
+ *         another error code else.
+ */
+fsal_posixdb_status_t fsal_posixdb_cancelHandleLock(fsal_posixdb_conn * p_conn /* IN */ )
+{
+  RollbackTransaction(p_conn);
+
+  ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+}
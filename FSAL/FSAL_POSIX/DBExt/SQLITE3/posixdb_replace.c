@@ -0,0 +1,192 @@
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include "fsal_types.h"
+#include "posixdb_consistency.h"
+#include "posixdb_internal.h"
+#include <string.h>
+
+fsal_posixdb_status_t fsal_posixdb_replace(fsal_posixdb_conn * p_conn,  /* IN */
+                                           fsal_posixdb_fileinfo_t * p_object_info,     /* IN */
+                                           posixfsal_handle_t * p_parent_directory_handle_old,  /* IN */
+                                           fsal_name_t * p_filename_old,        /* IN */
+                                           posixfsal_handle_t * p_parent_directory_handle_new,  /* IN */
+                                           fsal_name_t * p_filename_new /* IN */ )
+{
+  sqlite3_stmt *stmt;
+  posixfsal_handle_t object_handle;
+  fsal_posixdb_status_t st;
+  int rc;
+
+  /*******************
+   * 1/ sanity check *
+   *******************/
+
+  if(!p_conn || !p_object_info || !p_parent_directory_handle_old || !p_filename_old
+     || !p_parent_directory_handle_new || !p_filename_new)
+    ReturnCodeDB(ERR_FSAL_POSIXDB_FAULT, 0);
+
+  BeginUpdateTransaction(p_conn);
+
+  /**************************************************************************
+   * 2/ check that 'p_filename_old' exists in p_parent_directory_handle_old *
+   **************************************************************************/
+
+  /*
+     There are three cases :
+     * the entry do not exists -> return an error (NOENT)
+     * the entry exists.
+     * the entry exists but its information are not consistent with p_object_info -> return an error (CONSISTENCY)
+   */
+
+  /* check if info is in cache or if this info is inconsistent */
+  if(!fsal_posixdb_GetNameCache(p_parent_directory_handle_old, p_filename_old,
+                                &object_handle)
+     || fsal_posixdb_consistency_check(&(object_handle.data.info), p_object_info))
+    {
+      stmt = db_get_stmt(p_conn, LOOKUPHANDLEBYNAME);
+      sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_parent_directory_handle_old->data.id);
+      sqlite3_bind_int(stmt, 2, (int)p_parent_directory_handle_old->data.ts);
+      sqlite3_bind_text(stmt, 3, p_filename_old->name, -1, SQLITE_STATIC);
+      rc = sqlite3_step(stmt);
+      CheckStep(p_conn, rc);
+
+      if(rc != SQLITE_ROW)
+        {
+          /* parent entry not found */
+          RollbackTransaction(p_conn);
+          ReturnCodeDB(ERR_FSAL_POSIXDB_NOENT, 0);
+        }
+
+      /* fill 'infodb' with information about the handle in the database */
+      object_handle.data.id = (unsigned long long)sqlite3_column_int64(stmt, 0);
+      object_handle.data.ts = (unsigned int)sqlite3_column_int(stmt, 1);
+      posixdb_internal_fillFileinfoFromColumns(&(object_handle.data.info), stmt, 2,     /* devid */
+                                               3,       /* inode */
+                                               4,       /* nlink */
+                                               5,       /* ctime */
+                                               6        /* ftype */
+          );
+      sqlite3_reset(stmt);
+
+      /* check consistency */
+
+      if(fsal_posixdb_consistency_check(&(object_handle.data.info), p_object_info))
+        {
+          LogCrit(COMPONENT_FSAL, "Consistency check failed while renaming a file : Handle deleted");
+          st = fsal_posixdb_recursiveDelete(p_conn, object_handle.data.id,
+                                            object_handle.data.ts, FSAL_TYPE_DIR);
+          if(FSAL_POSIXDB_IS_ERROR(st))
+            {
+              RollbackTransaction(p_conn);
+              return st;
+            }
+          EndTransaction(p_conn);
+          return st;
+        }
+    }
+
+  /* renaming an entry to itself: nothing to do */
+  if(p_parent_directory_handle_old->data.id == p_parent_directory_handle_new->data.id
+     && p_parent_directory_handle_old->data.ts == p_parent_directory_handle_new->data.ts
+     && !strcmp(p_filename_old->name, p_filename_new->name))
+    {
+      EndTransaction(p_conn);
+      ReturnCodeDB(ERR_FSAL_POSIXDB_NOERR, 0);
+    }
+
+  /**********************************************************************************
+   * 3/ update the parent entry (in order to change its name and its parent handle) *
+   **********************************************************************************/
+
+  /*
+     Different cases :
+     * a line has been updated -> everything goes well.
+     * no line has been updated -> the entry does not exists in the database. -> return NOENT (should never happen because of the previous check)
+     * foreign key constraint violation -> new parentdir handle does not exists -> return NOENT
+     * there is already a file with this name in the directory -> replace it !
+   */
+
+  /* Remove target entry if it exists */
+  stmt = db_get_stmt(p_conn, LOOKUPHANDLEBYNAMEFU);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_parent_directory_handle_new->data.id);
+  sqlite3_bind_int(stmt, 2, (int)p_parent_directory_handle_new->data.ts);
+  sqlite3_bind_text(stmt, 3, p_filename_new->name, -1, SQLITE_STATIC);
+  rc = sqlite3_step(stmt);
+  CheckStep(p_conn, rc);
+
+  if(rc == SQLITE_ROW)
+    {
+      unsigned long long id = (unsigned long long)sqlite3_column_int64(stmt, 0);
+      unsigned int ts = (unsigned int)sqlite3_column_int(stmt, 1);
+      int nlink = sqlite3_column_int(stmt, 4);
+
+      sqlite3_reset(stmt);
+
+      st = fsal_posixdb_deleteParent(p_conn, id, ts,
+                                     p_parent_directory_handle_new->data.id,
+                                     p_parent_directory_handle_new->data.ts,
+                                     p_filename_new->name, nlink);
+
+      if(FSAL_POSIXDB_IS_ERROR(st) && !FSAL_POSIXDB_IS_NOENT(st))
+        {
+          RollbackTransaction(p_conn);
+          return st;
+        }
+    }
+  else
+    sqlite3_reset(stmt);
+
+  /* invalidate the names and the paths of the moved subtree */
+  fsal_posixdb_InvalidateRename(p_parent_directory_handle_old->data.id,
+                                p_parent_directory_handle_old->data.ts,
+                                p_filename_old->name,
+                                p_parent_directory_handle_new->data.id,
+                                p_parent_directory_handle_new->data.ts,
+                                p_filename_new->name);
+
+  stmt = db_get_stmt(p_conn, UPDATEPARENT);
+  sqlite3_bind_int64(stmt, 1, (sqlite3_int64) p_parent_directory_handle_old->data.id);
+  sqlite3_bind_int(stmt, 2, (int)p_parent_directory_handle_old->data.ts);
+  sqlite3_bind_text(stmt, 3, p_filename_old->name, -1, SQLITE_STATIC);
+  sqlite3_bind_int64(stmt, 4, (sqlite3_int64) p_parent_directory_handle_new->data.id);
+  sqlite3_bind_int(stmt, 5, (int)p_parent_directory_handle_new->data.ts);
+  sqlite3_bind_text(stmt, 6, p_filename_new->name, -1, SQLITE_STATIC);
+  rc = sqlite3_step(stmt);
+  sqlite3_reset(stmt);
+
+  if(rc == SQLITE_DONE)
+    {
+      if(sqlite3_changes(p_conn->db_conn) == 1)
+        {
+          /* there was 1 update */
+          st.major = ERR_FSAL_POSIXDB_NOERR;
+          st.minor = 0;
+        }
+      else
+        {
+          /* no row updated */
+          st.major = ERR_FSAL_POSIXDB_NOENT;
+          st.minor = 0;
+        }
+    }
+  else if(sqlite3_extended_errcode(p_conn->db_conn) == SQLITE_CONSTRAINT_FOREIGNKEY)
+    {
+      /* Foreign key violation : new parentdir does not exist, do nothing */
+      st.major = ERR_FSAL_POSIXDB_NOENT;
+      st.minor = rc;
+    }
+  else
+    {
+      LogCrit(COMPONENT_FSAL, "SQLite request failed in %s ( %s:%i ) with %s", __FUNCTION__,
+              __FILE__, __LINE__, sqlite3_errmsg(p_conn->db_conn));
+      st = db_error_convert(rc);
+    }
+
+  if(FSAL_POSIXDB_IS_ERROR(st))
+    RollbackTransaction(p_conn);
+  else
+    EndTransaction(p_conn);
+
+  return st;
+}
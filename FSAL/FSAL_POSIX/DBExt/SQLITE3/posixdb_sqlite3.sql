@@ -0,0 +1,31 @@
+
+/*
+ * Schema of the SQLite database.
+ * The tables are created by fsal_posixdb_connect() if the database file is new.
+ *
+ * handleId is an alias for the rowid (64 bits signed integer),
+ * AUTOINCREMENT prevents the id of a deleted handle from being reused.
+ */
+CREATE TABLE IF NOT EXISTS Handle (
+  handleId  INTEGER PRIMARY KEY AUTOINCREMENT,
+  handleTs  INTEGER NOT NULL,
+  deviceId  INTEGER NOT NULL,
+  inode     INTEGER NOT NULL,
+  ctime     INTEGER,
+  nlink     INTEGER DEFAULT 1,
+  ftype     INTEGER,
+  UNIQUE (handleId, handleTs),
+  UNIQUE (deviceId, inode)
+);
+
+CREATE TABLE IF NOT EXISTS Parent (
+  handleId        INTEGER NOT NULL,
+  handleTs        INTEGER NOT NULL,
+  handleIdParent  INTEGER,
+  handleTsParent  INTEGER,
+  name            TEXT,
+  UNIQUE (handleIdParent, handleTsParent, name),
+  FOREIGN KEY (handleId, handleTs) REFERENCES Handle(handleId, handleTs) ON DELETE CASCADE,
+  FOREIGN KEY (handleIdParent, handleTsParent) REFERENCES Handle(handleId, handleTs) ON DELETE CASCADE
+);
+CREATE INDEX IF NOT EXISTS parent_handle_index ON Parent (handleId, handleTs);
@@ -0,0 +1,653 @@
+/**
+ * \file    posixdb_cache.c
+ * \brief   Handle, path and name cache shared by the posixdb backends.
+ *
+ * Two hash tables are kept, each one bounded by the configured size
+ * (DB_Cache_Size) and evicted in insertion order:
+ *  - the handle table, indexed by (id, ts), holds the informations of the
+ *    Handle table and the path of the object;
+ *  - the name table, indexed by (parent id, parent ts, name), holds the
+ *    links of the Parent table. A link is only used while the handle it
+ *    points to is in the handle table, so deleting a handle also deletes
+ *    all the names leading to it.
+ *
+ * Lookups only take the cache lock for reading.
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+#include <string.h>
+
+#include "fsal_types.h"
+#include "posixdb_cache.h"
+#include "stuff_alloc.h"
+#include "RW_Lock.h"
+#include "log_macros.h"
+
+/* a summary of the hit rates is logged every POSIXDB_CACHE_STATS_PERIOD lookups */
+#define POSIXDB_CACHE_STATS_PERIOD 100000
+
+typedef struct posixdb_cache_handle__
+{
+  fsal_u64_t id;
+  int ts;
+  int info_is_set;
+  fsal_posixdb_fileinfo_t info;
+  char *path;                   /* NULL if the path is unknown */
+  unsigned int pathlen;
+  struct posixdb_cache_handle__ *hash_next;
+  struct posixdb_cache_handle__ *fifo_prev;
+  struct posixdb_cache_handle__ *fifo_next;
+} posixdb_cache_handle_t;
+
+typedef struct posixdb_cache_name__
+{
+  fsal_u64_t idparent;
+  int tsparent;
+  fsal_u64_t id;
+  int ts;
+  unsigned int hashval;
+  struct posixdb_cache_name__ *hash_next;
+  struct posixdb_cache_name__ *fifo_prev;
+  struct posixdb_cache_name__ *fifo_next;
+  char name[1];                 /* allocated with the entry */
+} posixdb_cache_name_t;
+
+static unsigned int cache_size = 0;     /* 0 means the cache is disabled */
+static rw_lock_t cache_lock;
+static unsigned int cache_generation = 0;
+
+static posixdb_cache_handle_t **handle_buckets = NULL;
+static posixdb_cache_handle_t *handle_fifo_head = NULL;  /* oldest */
+static posixdb_cache_handle_t *handle_fifo_tail = NULL;  /* newest */
+static unsigned int handle_count = 0;
+
+static posixdb_cache_name_t **name_buckets = NULL;
+static posixdb_cache_name_t *name_fifo_head = NULL;
+static posixdb_cache_name_t *name_fifo_tail = NULL;
+static unsigned int name_count = 0;
+
+static fsal_posixdb_cache_stats_t cache_stats;
+static unsigned int cache_lookups = 0;
+
+int fsal_posixdb_cache_init(unsigned int size)
+{
+  if(cache_size != 0 || size == 0)
+    return 0;
+
+  if(rw_lock_init(&cache_lock))
+    return 1;
+
+  if((handle_buckets = (posixdb_cache_handle_t **)
+      Mem_Alloc(size * sizeof(posixdb_cache_handle_t *))) == NULL)
+    return 1;
+
+  if((name_buckets = (posixdb_cache_name_t **)
+      Mem_Alloc(size * sizeof(posixdb_cache_name_t *))) == NULL)
+    {
+      Mem_Free(handle_buckets);
+      handle_buckets = NULL;
+      return 1;
+    }
+
+  memset(handle_buckets, 0, size * sizeof(posixdb_cache_handle_t *));
+  memset(name_buckets, 0, size * sizeof(posixdb_cache_name_t *));
+  memset(&cache_stats, 0, sizeof(fsal_posixdb_cache_stats_t));
+
+  cache_size = size;
+
+  LogEvent(COMPONENT_FSAL, "posixdb cache: up to %u handles and %u names", size, size);
+
+  return 0;
+}                               /* fsal_posixdb_cache_init */
+
+static unsigned int hash_handle(fsal_u64_t id, int ts)
+{
+  return (unsigned int)((1999 * id + 3 * ts + 5) % cache_size);
+}                               /* hash_handle */
+
+static unsigned int hash_name(fsal_u64_t idparent, int tsparent, char *name)
+{
+  unsigned int hash = (unsigned int)(1999 * idparent + 3 * tsparent + 5);
+  unsigned char *p;
+
+  for(p = (unsigned char *)name; *p != '\0'; p++)
+    hash = (hash * 31) + *p;
+
+  return hash;
+}                               /* hash_name */
+
+static void cache_log_stats()
+{
+  fsal_posixdb_cache_stats_t stats;
+
+  fsal_posixdb_cache_getstats(&stats);
+
+#define RATE( _hit_, _miss_ ) \
+  ( (_hit_) + (_miss_) ? 100.0 * (_hit_) / ((_hit_) + (_miss_)) : 0.0 )
+
+  LogEvent(COMPONENT_FSAL,
+           "posixdb cache: %u handles, %u names, hit rates: info %.1f%% path %.1f%% name %.1f%%, %llu invalidations",
+           stats.nb_handles, stats.nb_names,
+           RATE(stats.nb_info_hit, stats.nb_info_miss),
+           RATE(stats.nb_path_hit, stats.nb_path_miss),
+           RATE(stats.nb_name_hit, stats.nb_name_miss), stats.nb_invalidate);
+
+#undef RATE
+}                               /* cache_log_stats */
+
+static void cache_count_lookup(unsigned long long *p_counter)
+{
+  __sync_fetch_and_add(p_counter, 1);
+
+  if(__sync_add_and_fetch(&cache_lookups, 1) % POSIXDB_CACHE_STATS_PERIOD == 0)
+    cache_log_stats();
+}                               /* cache_count_lookup */
+
+/* The following functions are called with cache_lock held */
+
+static posixdb_cache_handle_t *cache_find_handle(fsal_u64_t id, int ts)
+{
+  posixdb_cache_handle_t *pentry;
+
+  for(pentry = handle_buckets[hash_handle(id, ts)]; pentry != NULL;
+      pentry = pentry->hash_next)
+    if(pentry->id == id && pentry->ts == ts)
+      return pentry;
+
+  return NULL;
+}                               /* cache_find_handle */
+
+static void cache_drop_path(posixdb_cache_handle_t * pentry)
+{
+  if(pentry->path != NULL)
+    {
+      Mem_Free(pentry->path);
+      pentry->path = NULL;
+      pentry->pathlen = 0;
+    }
+}                               /* cache_drop_path */
+
+static void cache_remove_handle(posixdb_cache_handle_t * pentry)
+{
+  posixdb_cache_handle_t **ppentry;
+
+  for(ppentry = &handle_buckets[hash_handle(pentry->id, pentry->ts)];
+      *ppentry != pentry; ppentry = &(*ppentry)->hash_next) ;
+  *ppentry = pentry->hash_next;
+
+  if(pentry->fifo_prev)
+    pentry->fifo_prev->fifo_next = pentry->fifo_next;
+  else
+    handle_fifo_head = pentry->fifo_next;
+
+  if(pentry->fifo_next)
+    pentry->fifo_next->fifo_prev = pentry->fifo_prev;
+  else
+    handle_fifo_tail = pentry->fifo_prev;
+
+  handle_count -= 1;
+
+  cache_drop_path(pentry);
+  Mem_Free(pentry);
+}                               /* cache_remove_handle */
+
+/* get the entry of a handle, creating it if needed */
+static posixdb_cache_handle_t *cache_get_handle(fsal_u64_t id, int ts)
+{
+  posixdb_cache_handle_t *pentry;
+  unsigned int i;
+
+  if((pentry = cache_find_handle(id, ts)) != NULL)
+    return pentry;
+
+  if(handle_count >= cache_size)
+    cache_remove_handle(handle_fifo_head);
+
+  if((pentry = (posixdb_cache_handle_t *) Mem_Alloc(sizeof(posixdb_cache_handle_t))) == NULL)
+    return NULL;
+
+  memset(pentry, 0, sizeof(posixdb_cache_handle_t));
+  pentry->id = id;
+  pentry->ts = ts;
+
+  i = hash_handle(id, ts);
+  pentry->hash_next = handle_buckets[i];
+  handle_buckets[i] = pentry;
+
+  pentry->fifo_prev = handle_fifo_tail;
+  if(handle_fifo_tail)
+    handle_fifo_tail->fifo_next = pentry;
+  else
+    handle_fifo_head = pentry;
+  handle_fifo_tail = pentry;
+
+  handle_count += 1;
+
+  return pentry;
+}                               /* cache_get_handle */
+
+static posixdb_cache_name_t *cache_find_name(fsal_u64_t idparent, int tsparent,
+                                             char *name, unsigned int hashval)
+{
+  posixdb_cache_name_t *pname;
+
+  for(pname = name_buckets[hashval % cache_size]; pname != NULL;
+      pname = pname->hash_next)
+    if(pname->hashval == hashval && pname->idparent == idparent
+       && pname->tsparent == tsparent && !strcmp(pname->name, name))
+      return pname;
+
+  return NULL;
+}                               /* cache_find_name */
+
+static void cache_remove_name(posixdb_cache_name_t * pname)
+{
+  posixdb_cache_name_t **ppname;
+
+  for(ppname = &name_buckets[pname->hashval % cache_size];
+      *ppname != pname; ppname = &(*ppname)->hash_next) ;
+  *ppname = pname->hash_next;
+
+  if(pname->fifo_prev)
+    pname->fifo_prev->fifo_next = pname->fifo_next;
+  else
+    name_fifo_head = pname->fifo_next;
+
+  if(pname->fifo_next)
+    pname->fifo_next->fifo_prev = pname->fifo_prev;
+  else
+    name_fifo_tail = pname->fifo_prev;
+
+  name_count -= 1;
+
+  Mem_Free(pname);
+}                               /* cache_remove_name */
+
+/* drop the path of 'path' and the paths of everything below it.
+ * if path is NULL, all the paths are dropped. */
+static void cache_drop_paths_under(char *path, unsigned int len)
+{
+  posixdb_cache_handle_t *pentry;
+
+  for(pentry = handle_fifo_head; pentry != NULL; pentry = pentry->fifo_next)
+    {
+      if(pentry->path == NULL)
+        continue;
+
+      if(path == NULL
+         || (pentry->pathlen >= len && !strncmp(pentry->path, path, len)
+             && (pentry->pathlen == len || pentry->path[len] == '/'
+                 || (len > 0 && path[len - 1] == '/'))))
+        cache_drop_path(pentry);
+    }
+}                               /* cache_drop_paths_under */
+
+static void cache_invalidated()
+{
+  cache_generation += 1;
+  __sync_fetch_and_add(&cache_stats.nb_invalidate, 1);
+}                               /* cache_invalidated */
+
+unsigned int fsal_posixdb_CacheGeneration()
+{
+  return __sync_add_and_fetch(&cache_generation, 0);
+}                               /* fsal_posixdb_CacheGeneration */
+
+void fsal_posixdb_CachePath(posixfsal_handle_t * p_handle,      /* IN */
+                            fsal_path_t * p_path,       /* IN */
+                            unsigned int generation /* IN */ )
+{
+  posixdb_cache_handle_t *pentry;
+  char *path;
+
+  if(cache_size == 0)
+    return;
+
+  LogFullDebug(COMPONENT_FSAL, "fsal_posixdb_CachePath: %llu, %u = %s",
+               (unsigned long long)p_handle->data.id, (unsigned int)p_handle->data.ts,
+               p_path->path);
+
+  /* allocate outside of the lock */
+  if((path = (char *)Mem_Alloc(p_path->len + 1)) == NULL)
+    return;
+  memcpy(path, p_path->path, p_path->len);
+  path[p_path->len] = '\0';
+
+  P_w(&cache_lock);
+
+  if(generation != cache_generation
+     || (pentry = cache_get_handle(p_handle->data.id, p_handle->data.ts)) == NULL)
+    {
+      V_w(&cache_lock);
+      Mem_Free(path);
+      return;
+    }
+
+  cache_drop_path(pentry);
+  pentry->path = path;
+  pentry->pathlen = p_path->len;
+
+  V_w(&cache_lock);
+}                               /* fsal_posixdb_CachePath */
+
+int fsal_posixdb_GetPathCache(posixfsal_handle_t * p_handle,    /* IN */
+                              fsal_path_t * p_path /* OUT */ )
+{
+  posixdb_cache_handle_t *pentry;
+
+  if(cache_size == 0)
+    return FALSE;
+
+  P_r(&cache_lock);
+
+  pentry = cache_find_handle(p_handle->data.id, p_handle->data.ts);
+
+  if(pentry == NULL || pentry->path == NULL)
+    {
+      V_r(&cache_lock);
+      cache_count_lookup(&cache_stats.nb_path_miss);
+      return FALSE;
+    }
+
+  memcpy(p_path->path, pentry->path, pentry->pathlen + 1);
+  p_path->len = pentry->pathlen;
+
+  V_r(&cache_lock);
+
+  cache_count_lookup(&cache_stats.nb_path_hit);
+
+  LogFullDebug(COMPONENT_FSAL, "fsal_posixdb_GetPathCache(%llu, %u)=%s",
+               (unsigned long long)p_handle->data.id, (unsigned int)p_handle->data.ts,
+               p_path->path);
+
+  return TRUE;
+}                               /* fsal_posixdb_GetPathCache */
+
+void fsal_posixdb_UpdateInodeCache(posixfsal_handle_t * p_handle,       /* IN */
+                                   unsigned int generation /* IN */ )
+{
+  posixdb_cache_handle_t *pentry;
+
+  if(cache_size == 0)
+    return;
+
+  LogFullDebug(COMPONENT_FSAL, "fsal_posixdb_UpdateInodeCache: %llu, %u (inode %llu)",
+               (unsigned long long)p_handle->data.id, (unsigned int)p_handle->data.ts,
+               (unsigned long long)p_handle->data.info.inode);
+
+  P_w(&cache_lock);
+
+  if(generation == cache_generation
+     && (pentry = cache_get_handle(p_handle->data.id, p_handle->data.ts)) != NULL)
+    {
+      pentry->info = p_handle->data.info;
+      pentry->info_is_set = TRUE;
+    }
+
+  V_w(&cache_lock);
+}                               /* fsal_posixdb_UpdateInodeCache */
+
+int fsal_posixdb_GetInodeCache(posixfsal_handle_t * p_handle)   /* IN/OUT */
+{
+  posixdb_cache_handle_t *pentry;
+
+  if(cache_size == 0)
+    return FALSE;
+
+  P_r(&cache_lock);
+
+  pentry = cache_find_handle(p_handle->data.id, p_handle->data.ts);
+
+  if(pentry == NULL || !pentry->info_is_set)
+    {
+      V_r(&cache_lock);
+      cache_count_lookup(&cache_stats.nb_info_miss);
+      return FALSE;
+    }
+
+  p_handle->data.info = pentry->info;
+
+  V_r(&cache_lock);
+
+  cache_count_lookup(&cache_stats.nb_info_hit);
+
+  return TRUE;
+}                               /* fsal_posixdb_GetInodeCache */
+
+void fsal_posixdb_CacheName(posixfsal_handle_t * p_parent_handle,       /* IN */
+                            fsal_name_t * p_name,       /* IN */
+                            posixfsal_handle_t * p_handle,      /* IN */
+                            unsigned int generation /* IN */ )
+{
+  posixdb_cache_handle_t *pentry;
+  posixdb_cache_name_t *pname;
+  unsigned int hashval;
+
+  if(cache_size == 0)
+    return;
+
+  hashval = hash_name(p_parent_handle->data.id, p_parent_handle->data.ts, p_name->name);
+
+  if((pname = (posixdb_cache_name_t *)
+      Mem_Alloc(sizeof(posixdb_cache_name_t) + p_name->len)) == NULL)
+    return;
+
+  pname->idparent = p_parent_handle->data.id;
+  pname->tsparent = p_parent_handle->data.ts;
+  pname->id = p_handle->data.id;
+  pname->ts = p_handle->data.ts;
+  pname->hashval = hashval;
+  memcpy(pname->name, p_name->name, p_name->len);
+  pname->name[p_name->len] = '\0';
+
+  P_w(&cache_lock);
+
+  if(generation != cache_generation
+     || cache_find_name(pname->idparent, pname->tsparent, pname->name, hashval) != NULL)
+    {
+      V_w(&cache_lock);
+      Mem_Free(pname);
+      return;
+    }
+
+  /* the link is useless without the informations about the handle */
+  if((pentry = cache_get_handle(pname->id, pname->ts)) == NULL)
+    {
+      V_w(&cache_lock);
+      Mem_Free(pname);
+      return;
+    }
+  pentry->info = p_handle->data.info;
+  pentry->info_is_set = TRUE;
+
+  if(name_count >= cache_size)
+    cache_remove_name(name_fifo_head);
+
+  pname->hash_next = name_buckets[hashval % cache_size];
+  name_buckets[hashval % cache_size] = pname;
+
+  pname->fifo_next = NULL;
+  pname->fifo_prev = name_fifo_tail;
+  if(name_fifo_tail)
+    name_fifo_tail->fifo_next = pname;
+  else
+    name_fifo_head = pname;
+  name_fifo_tail = pname;
+
+  name_count += 1;
+
+  V_w(&cache_lock);
+}                               /* fsal_posixdb_CacheName */
+
+int fsal_posixdb_GetNameCache(posixfsal_handle_t * p_parent_handle,     /* IN */
+                              fsal_name_t * p_name,     /* IN */
+                              posixfsal_handle_t * p_handle /* OUT */ )
+{
+  posixdb_cache_handle_t *pentry = NULL;
+  posixdb_cache_name_t *pname;
+  unsigned int hashval;
+
+  if(cache_size == 0)
+    return FALSE;
+
+  hashval = hash_name(p_parent_handle->data.id, p_parent_handle->data.ts, p_name->name);
+
+  P_r(&cache_lock);
+
+  pname = cache_find_name(p_parent_handle->data.id, p_parent_handle->data.ts,
+                          p_name->name, hashval);
+
+  if(pname != NULL)
+    pentry = cache_find_handle(pname->id, pname->ts);
+
+  if(pentry == NULL || !pentry->info_is_set)
+    {
+      V_r(&cache_lock);
+      cache_count_lookup(&cache_stats.nb_name_miss);
+      return FALSE;
+    }
+
+  p_handle->data.id = pentry->id;
+  p_handle->data.ts = pentry->ts;
+  p_handle->data.info = pentry->info;
+
+  V_r(&cache_lock);
+
+  cache_count_lookup(&cache_stats.nb_name_hit);
+
+  return TRUE;
+}                               /* fsal_posixdb_GetNameCache */
+
+void fsal_posixdb_InvalidateName(fsal_u64_t idparent,   /* IN */
+                                 int tsparent,  /* IN */
+                                 char *name /* IN */ )
+{
+  posixdb_cache_name_t *pname;
+
+  if(cache_size == 0)
+    return;
+
+  P_w(&cache_lock);
+
+  pname = cache_find_name(idparent, tsparent, name, hash_name(idparent, tsparent, name));
+  if(pname != NULL)
+    cache_remove_name(pname);
+
+  cache_invalidated();
+
+  V_w(&cache_lock);
+}                               /* fsal_posixdb_InvalidateName */
+
+void fsal_posixdb_InvalidateHandle(fsal_u64_t id,       /* IN */
+                                   int ts /* IN */ )
+{
+  posixdb_cache_handle_t *pentry;
+
+  if(cache_size == 0)
+    return;
+
+  P_w(&cache_lock);
+
+  /* the names leading to this handle become unusable */
+  if((pentry = cache_find_handle(id, ts)) != NULL)
+    cache_remove_handle(pentry);
+
+  cache_invalidated();
+
+  V_w(&cache_lock);
+}                               /* fsal_posixdb_InvalidateHandle */
+
+void fsal_posixdb_InvalidateRename(fsal_u64_t idparent_old,     /* IN */
+                                   int tsparent_old,    /* IN */
+                                   char *name_old,      /* IN */
+                                   fsal_u64_t idparent_new,     /* IN */
+                                   int tsparent_new,    /* IN */
+                                   char *name_new /* IN */ )
+{
+  posixdb_cache_handle_t *pentry = NULL;
+  posixdb_cache_name_t *pname;
+  char path[FSAL_MAX_PATH_LEN];
+  unsigned int len = 0;
+  int path_known = FALSE;
+
+  if(cache_size == 0)
+    return;
+
+  P_w(&cache_lock);
+
+  /* find the old path of the object, from its own entry or from its parent */
+  pname = cache_find_name(idparent_old, tsparent_old, name_old,
+                          hash_name(idparent_old, tsparent_old, name_old));
+  if(pname != NULL)
+    pentry = cache_find_handle(pname->id, pname->ts);
+
+  if(pentry != NULL && pentry->path != NULL)
+    {
+      len = pentry->pathlen;
+      memcpy(path, pentry->path, len);
+      path_known = TRUE;
+    }
+  else if((pentry = cache_find_handle(idparent_old, tsparent_old)) != NULL
+          && pentry->path != NULL
+          && pentry->pathlen + 1 + strlen(name_old) < FSAL_MAX_PATH_LEN)
+    {
+      len = pentry->pathlen;
+      memcpy(path, pentry->path, len);
+      if(len == 0 || path[len - 1] != '/')
+        path[len++] = '/';
+      strcpy(&path[len], name_old);
+      len += strlen(name_old);
+      path_known = TRUE;
+    }
+
+  if(pname != NULL)
+    cache_remove_name(pname);
+
+  pname = cache_find_name(idparent_new, tsparent_new, name_new,
+                          hash_name(idparent_new, tsparent_new, name_new));
+  if(pname != NULL)
+    cache_remove_name(pname);
+
+  /* the object and its subtree have moved.
+   * if the old location is unknown, any cached path may be wrong */
+  cache_drop_paths_under(path_known ? path : NULL, len);
+
+  cache_invalidated();
+
+  V_w(&cache_lock);
+}                               /* fsal_posixdb_InvalidateRename */
+
+void fsal_posixdb_InvalidateCache()
+{
+  if(cache_size == 0)
+    return;
+
+  LogDebug(COMPONENT_FSAL, "fsal_posixdb_InvalidateCache");
+
+  P_w(&cache_lock);
+
+  while(name_fifo_head != NULL)
+    cache_remove_name(name_fifo_head);
+
+  while(handle_fifo_head != NULL)
+    cache_remove_handle(handle_fifo_head);
+
+  cache_invalidated();
+
+  V_w(&cache_lock);
+}                               /* fsal_posixdb_InvalidateCache */
+
+void fsal_posixdb_cache_getstats(fsal_posixdb_cache_stats_t * p_stats)
+{
+  if(cache_size != 0)
+    {
+      P_r(&cache_lock);
+      *p_stats = cache_stats;
+      p_stats->nb_handles = handle_count;
+      p_stats->nb_names = name_count;
+      V_r(&cache_lock);
+    }
+  else
+    memset(p_stats, 0, sizeof(fsal_posixdb_cache_stats_t));
+}                               /* fsal_posixdb_cache_getstats */
@@ -0,0 +1,86 @@
+/**
+ * \file    posixdb_cache.h
+ * \brief   Handle, path and name cache shared by the posixdb backends.
+ *
+ * The cache remembers, for the handles recently resolved through the
+ * database:
+ *  - the information stored in the Handle table (devid, inode, nlink...),
+ *  - the path of the object, when it has only one,
+ *  - the (parent handle, name) -> handle links of the Parent table.
+ *
+ * The backends call the invalidation functions before changing a table,
+ * so that only the entries concerned by a modification are thrown away:
+ * the links of the renamed or deleted names, the handles deleted or updated,
+ * and the paths of the renamed subtree.
+ *
+ * A lookup that raced with a modification must not put stale data in the
+ * cache: the backends read fsal_posixdb_CacheGeneration() before querying
+ * the database and give it back when filling the cache. The entry is not
+ * inserted if an invalidation happened in the meantime.
+ */
+
+#ifndef _POSIXDB_CACHE_H
+#define _POSIXDB_CACHE_H
+
+#include "fsal_types.h"
+
+/* get the current generation of the cache (changed by every invalidation) */
+unsigned int fsal_posixdb_CacheGeneration();
+
+/* enter the path of a handle in the cache */
+void fsal_posixdb_CachePath(posixfsal_handle_t * p_handle,      /* IN */
+                            fsal_path_t * p_path,       /* IN */
+                            unsigned int generation /* IN */ );
+
+/* get a path from the cache
+ * return true if the entry is found,
+ * false else.
+ */
+int fsal_posixdb_GetPathCache(posixfsal_handle_t * p_handle,    /* IN */
+                              fsal_path_t * p_path /* OUT */ );
+
+/* update informations about a handle */
+void fsal_posixdb_UpdateInodeCache(posixfsal_handle_t * p_handle,       /* IN */
+                                   unsigned int generation /* IN */ );
+
+/* retrieve last informations about a handle
+ * return true if the entry is found,
+ * false else.
+ */
+int fsal_posixdb_GetInodeCache(posixfsal_handle_t * p_handle);  /* IN/OUT */
+
+/* enter a (parent, name) -> handle link in the cache */
+void fsal_posixdb_CacheName(posixfsal_handle_t * p_parent_handle,       /* IN */
+                            fsal_name_t * p_name,       /* IN */
+                            posixfsal_handle_t * p_handle,      /* IN */
+                            unsigned int generation /* IN */ );
+
+/* get the handle (and its informations) named p_name in p_parent_handle
+ * return true if the entry is found,
+ * false else.
+ */
+int fsal_posixdb_GetNameCache(posixfsal_handle_t * p_parent_handle,     /* IN */
+                              fsal_name_t * p_name,     /* IN */
+                              posixfsal_handle_t * p_handle /* OUT */ );
+
+/* a Parent entry is added or deleted */
+void fsal_posixdb_InvalidateName(fsal_u64_t idparent,   /* IN */
+                                 int tsparent,  /* IN */
+                                 char *name /* IN */ );
+
+/* a Handle entry is deleted or updated */
+void fsal_posixdb_InvalidateHandle(fsal_u64_t id,       /* IN */
+                                   int ts /* IN */ );
+
+/* a Parent entry is moved: drop the paths below its old location */
+void fsal_posixdb_InvalidateRename(fsal_u64_t idparent_old,     /* IN */
+                                   int tsparent_old,    /* IN */
+                                   char *name_old,      /* IN */
+                                   fsal_u64_t idparent_new,     /* IN */
+                                   int tsparent_new,    /* IN */
+                                   char *name_new /* IN */ );
+
+/* invalidate the whole cache */
+void fsal_posixdb_InvalidateCache();
+
+#endif                          /* _POSIXDB_CACHE_H */
@@ -326,7 +326,6 @@ fsal_status_t POSIXFSAL_read(posixfsal_file_t * p_file_descriptor,      /* IN */
   size_t i_size;
   size_t nb_read;
   int rc, errsv;
-  char c;
 
   /* sanity checks. */
   if(!p_file_descriptor || !buffer || !p_read_amount || !p_end_of_file)
@@ -335,6 +334,8 @@ fsal_status_t POSIXFSAL_read(posixfsal_file_t * p_file_descriptor,      /* IN */
   /** @todo: manage fsal_size_t to size_t convertion */
   i_size = (size_t) buffer_size;
 
+  *p_end_of_file = 0;
+
   /* positioning */
 
   if(p_seek_descriptor)
@@ -381,13 +382,13 @@ fsal_status_t POSIXFSAL_read(posixfsal_file_t * p_file_descriptor,      /* IN */
               pread(p_file_descriptor->filefd, buffer, i_size, p_seek_descriptor->offset);
           errsv = errno;
 
-          rc = pread(p_file_descriptor->filefd, &c, 1,
-                     p_seek_descriptor->offset + i_size);
-          if(rc == 0)
-            *p_end_of_file = 1;
-
           ReleaseTokenFSCall();
 
+          /* A short read on a regular file stops at its end. A full read does
+           * not tell, cache_inode completes the eof with the file size. */
+          if(nb_read != -1 && nb_read < i_size)
+            *p_end_of_file = 1;
+
           break;
         }
     }
@@ -440,7 +440,7 @@ fsal_status_t fsal_internal_init_global(fsal_init_info_t * fsal_info,
            global_fs_info.supported_attrs);
 
   /* initialize database cache */
-  if(fsal_posixdb_cache_init())
+  if(fsal_posixdb_cache_init(fs_specific_info->dbcachesize))
     ReturnCode(ERR_FSAL_FAULT, 0);
 
   LogDebug(COMPONENT_FSAL, "global_fs_info {");
@@ -214,6 +214,7 @@ int main(int argc, char **argv)
   char path[MAXPATHLEN];
   int rc;
 
+#ifndef _USE_SQLITE3
   char options[] = "h@H:P:L:D:K:";
   char usage[] =
       "Usage: %s [-h][-H <host>][-P <port>][-L <login>][-D <dbname>][-K <passwd file>] operation operation_parameters\n"
@@ -234,10 +235,30 @@ int main(int argc, char **argv)
       "empty_database        : Delete all entries in the database\n"
       "find                  : Print the entries of the database (as 'find' would do it)\n"
       "populate <path>       : Add (recursively) the object in <path> into the database\n\n";
+#else
+  char options[] = "h@D:T:";
+  char usage[] =
+      "Usage: %s [-h][-D <db file>][-T <tmp dir>] operation operation_parameters\n"
+      "\t[-h]               display this help\n"
+      "\t[-D <db file>]     Path of the database file\n"
+      "\t[-T <tmp dir>]     Directory for the temporary files of the database\n"
+      "------------- Default Values -------------\n"
+      "db file     : posixdb.db\n"
+      "tmp dir     : default SQLite temporary directory\n"
+      "------------- Operations -----------------\n"
+      "test_connection       : try to connect to the database\n"
+      "empty_database        : Delete all entries in the database\n"
+      "find                  : Print the entries of the database (as 'find' would do it)\n"
+      "populate <path>       : Add (recursively) the object in <path> into the database\n\n";
+#endif
 
   memset(&dbparams, 0, sizeof(fsal_posixdb_conn_params_t));
+#ifndef _USE_SQLITE3
   strcpy(dbparams.host, "localhost");
   strcpy(dbparams.dbname, "posixdb");
+#else
+  strcpy(dbparams.dbfile, "posixdb.db");
+#endif
 
   /* What is the executable file's name */
   if(*exec_name == '\0')
@@ -253,6 +274,7 @@ int main(int argc, char **argv)
           printf("%s compiled on %s at %s\n", exec_name, __DATE__, __TIME__);
           exit(0);
           break;
+#ifndef _USE_SQLITE3
         case 'H':
           strncpy(dbparams.host, optarg, FSAL_MAX_DBHOST_NAME_LEN);
           break;
@@ -268,6 +290,14 @@ int main(int argc, char **argv)
         case 'K':
           strncpy(dbparams.passwdfile, optarg, PATH_MAX);
           break;
+#else
+        case 'D':
+          strncpy(dbparams.dbfile, optarg, FSAL_MAX_PATH_LEN);
+          break;
+        case 'T':
+          strncpy(dbparams.tempdir, optarg, FSAL_MAX_PATH_LEN);
+          break;
+#endif
         default:
           /* display the help */
           fprintf(stderr, usage, exec_name);
@@ -323,6 +353,7 @@ int main(int argc, char **argv)
 #endif
 
   /* Connecting to database */
+#ifndef _USE_SQLITE3
   if(*(dbparams.passwdfile) != '\0')
     {
       rc = setenv("PGPASSFILE", dbparams.passwdfile, 1);
@@ -331,6 +362,9 @@ int main(int argc, char **argv)
     }
 
   fprintf(stderr, "Opening database connection to %s...\n", dbparams.host);
+#else
+  fprintf(stderr, "Opening database file %s...\n", dbparams.dbfile);
+#endif
   statusdb = fsal_posixdb_connect(&dbparams, &p_conn);
   if(FSAL_POSIXDB_IS_ERROR(statusdb))
     {
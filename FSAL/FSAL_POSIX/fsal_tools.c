@@ -388,8 +388,15 @@ fsal_status_t POSIXFSAL_SetDefault_FS_specific_parameter(fsal_parameter_t * out_
   out_parameter->fs_specific_info.dbparams.login[0] = '\0';
   out_parameter->fs_specific_info.dbparams.passwdfile[0] = '\0';
 
+#elif defined(_USE_SQLITE3)
+
+  out_parameter->fs_specific_info.dbparams.dbfile[0] = '\0';
+  out_parameter->fs_specific_info.dbparams.tempdir[0] = '\0';
+
 #endif
 
+  out_parameter->fs_specific_info.dbcachesize = 65536;
+
   ReturnCode(ERR_FSAL_NO_ERROR, 0);
 
 }
@@ -777,6 +784,18 @@ fsal_status_t POSIXFSAL_load_FS_specific_parameter_from_conf(config_file_t in_co
           ReturnCode(ERR_FSAL_SERVERFAULT, err);
         }
       /* does the variable exists ? */
+#ifdef _USE_SQLITE3
+      if(!STRCMP(key_name, "DB_File"))
+        {
+          strncpy(out_parameter->fs_specific_info.dbparams.dbfile,
+                  key_value, FSAL_MAX_PATH_LEN);
+        }
+      else if(!STRCMP(key_name, "DB_TmpDir"))
+        {
+          strncpy(out_parameter->fs_specific_info.dbparams.tempdir,
+                  key_value, FSAL_MAX_PATH_LEN);
+        }
+#else
       if(!STRCMP(key_name, "DB_Host"))
         {
           strncpy(out_parameter->fs_specific_info.dbparams.host,
@@ -811,6 +830,21 @@ fsal_status_t POSIXFSAL_load_FS_specific_parameter_from_conf(config_file_t in_co
           strncpy(out_parameter->fs_specific_info.dbparams.passwdfile,
                   key_value, FSAL_MAX_PATH_LEN);
         }
+#endif
+      else if(!STRCMP(key_name, "DB_Cache_Size"))
+        {
+          int cachesize = s_read_int(key_value);
+
+          if(cachesize < 0)
+            {
+              LogCrit(COMPONENT_CONFIG,
+                   "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: null or positive integer expected.",
+                   key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+
+          out_parameter->fs_specific_info.dbcachesize = (unsigned int)cachesize;
+        }
       else
         {
           LogCrit(COMPONENT_CONFIG,
@@ -820,6 +854,14 @@ fsal_status_t POSIXFSAL_load_FS_specific_parameter_from_conf(config_file_t in_co
         }
     }
 
+#ifdef _USE_SQLITE3
+  if(out_parameter->fs_specific_info.dbparams.dbfile[0] == '\0')
+    {
+      LogCrit(COMPONENT_CONFIG,
+           "FSAL LOAD PARAMETER: DB_File MUST be specified in the configuration file");
+      ReturnCode(ERR_FSAL_NOENT, 0);
+    }
+#else
   if(out_parameter->fs_specific_info.dbparams.host[0] == '\0'
      || out_parameter->fs_specific_info.dbparams.dbname[0] == '\0')
     {
@@ -828,6 +870,7 @@ fsal_status_t POSIXFSAL_load_FS_specific_parameter_from_conf(config_file_t in_co
            CONF_LABEL_FS_SPECIFIC);
       ReturnCode(ERR_FSAL_NOENT, 0);
     }
+#endif
 
   ReturnCode(ERR_FSAL_NO_ERROR, 0);
 
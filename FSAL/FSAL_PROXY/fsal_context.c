@@ -230,7 +230,12 @@ fsal_status_t PROXYFSAL_InitClientContext(proxyfsal_op_context_t * p_thr_context
   addr_rpc.sin_family = AF_INET;
   addr_rpc.sin_addr.s_addr = p_thr_context->srv_addr;
 
-  if(!strcmp(p_thr_context->srv_proto, "udp"))
+  if(fsal_proxy_rpc_enabled())
+    {
+      /* The sockets belong to the shared pipelined client, the thread only keeps its credentials */
+      p_thr_context->rpc_client = NULL;
+    }
+  else if(!strcmp(p_thr_context->srv_proto, "udp"))
     {
       if((sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP)) < 0)
         Return(ERR_FSAL_FAULT, errno, INDEX_FSAL_InitClientContext);
@@ -324,15 +329,27 @@ fsal_status_t PROXYFSAL_InitClientContext(proxyfsal_op_context_t * p_thr_context
     }
   else
 #endif                          /* _USE_GSSRPC */
-  if((p_thr_context->rpc_client->cl_auth = authunix_create_default()) == NULL)
+  if(p_thr_context->rpc_client == NULL)
+    {
+      if((p_thr_context->rpc_auth = authunix_create_default()) == NULL)
+        Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_InitClientContext);
+    }
+  else if((p_thr_context->rpc_client->cl_auth = authunix_create_default()) == NULL)
     {
       Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_InitClientContext);
     }
 
   /* test if the newly created context can 'ping' the server via PROC_NULL */
-  if((rc = clnt_call(p_thr_context->rpc_client, NFSPROC4_NULL,
-                     (xdrproc_t) xdr_void, (caddr_t) NULL,
-                     (xdrproc_t) xdr_void, (caddr_t) NULL, timeout)) != RPC_SUCCESS)
+  if(p_thr_context->rpc_client == NULL)
+    rc = fsal_proxy_rpc_call(p_thr_context->rpc_auth, NFSPROC4_NULL,
+                             (xdrproc_t) xdr_void, (caddr_t) NULL,
+                             (xdrproc_t) xdr_void, (caddr_t) NULL, timeout);
+  else
+    rc = clnt_call(p_thr_context->rpc_client, NFSPROC4_NULL,
+                   (xdrproc_t) xdr_void, (caddr_t) NULL,
+                   (xdrproc_t) xdr_void, (caddr_t) NULL, timeout);
+
+  if(rc != RPC_SUCCESS)
     {
       Return(ERR_FSAL_INVAL, rc, INDEX_FSAL_InitClientContext);
     }
@@ -37,11 +37,559 @@
 
 #include "nfs_proto_functions.h"
 #include "fsal_nfsv4_macros.h"
+#include "RW_Lock.h"
 
 #ifdef _APPLE
 #define strnlen( s, l ) strlen( s )
 #endif
 
+extern proxyfs_specific_initinfo_t global_fsal_proxy_specific_info;
+
+/*
+ * Pipelined reads and writes.
+ *
+ * When the op context uses the shared pipelined client, a read or a write is
+ * split in PUTFH+READ (or PUTFH+WRITE) compounds of io_chunk_size bytes, and
+ * up to io_window of them are in flight at the same time. A read that starts
+ * where the previous read of the same file descriptor stopped also sends the
+ * READs of the next io_window chunks, they are served from the window by the
+ * following reads.
+ *
+ * Writes are not delayed past PROXYFSAL_write: cache_inode gets the size of the
+ * file from the server right after the write.
+ */
+
+#define FSAL_PROXY_IO_NB_OP_ALLOC  2
+#define FSAL_PROXY_IO_IDX_OP_PUTFH 0
+#define FSAL_PROXY_IO_IDX_OP_RDWR  1
+
+/* One READ or WRITE compound */
+typedef struct proxyfsal_io_chunk__
+{
+  fsal_proxy_rpc_call_t call;
+  COMPOUND4args argnfs4;
+  COMPOUND4res resnfs4;
+  nfs_argop4 argoparray[FSAL_PROXY_IO_NB_OP_ALLOC];
+  nfs_resop4 resoparray[FSAL_PROXY_IO_NB_OP_ALLOC];
+  int is_write;
+  fsal_off_t offset;
+  fsal_size_t length;
+  caddr_t data;
+  fsal_boolean_t in_flight;     /* sent through the pipelined client, reply not used yet */
+  fsal_boolean_t ready;         /* status, done and eof are set */
+  fsal_status_t status;
+  fsal_size_t done;             /* amount read or written */
+  fsal_boolean_t eof;
+} proxyfsal_io_chunk_t;
+
+/* Read-ahead state of an open file */
+typedef struct proxyfsal_io_window__
+{
+  pthread_mutex_t lock;
+  fsal_boolean_t has_last;
+  fsal_off_t last_end;          /* where the previous read stopped */
+  unsigned int first;           /* oldest chunk read ahead */
+  unsigned int count;           /* chunks read ahead, in flight or ready */
+  char *buffer;                 /* io_window * io_chunk_size bytes */
+  proxyfsal_io_chunk_t *chunks;
+} proxyfsal_io_window_t;
+
+static void proxyfsal_io_chunk_setup(proxyfsal_file_t * file_descriptor,
+                                     proxyfsal_io_chunk_t * p_chunk,
+                                     int is_write,
+                                     nfs_fh4 * p_nfs4fh,
+                                     fsal_off_t offset, fsal_size_t length, caddr_t data)
+{
+  p_chunk->argnfs4.argarray.argarray_val = p_chunk->argoparray;
+  p_chunk->resnfs4.resarray.resarray_val = p_chunk->resoparray;
+  p_chunk->argnfs4.minorversion = 0;
+  p_chunk->argnfs4.tag.utf8string_val = NULL;
+  p_chunk->argnfs4.tag.utf8string_len = 0;
+  p_chunk->argnfs4.argarray.argarray_len = 0;
+
+  COMPOUNDV4_ARG_ADD_OP_PUTFH(p_chunk->argnfs4, *p_nfs4fh);
+  if(is_write)
+    COMPOUNDV4_ARG_ADD_OP_WRITE(p_chunk->argnfs4, &(file_descriptor->stateid), offset,
+                                data, length);
+  else
+    COMPOUNDV4_ARG_ADD_OP_READ(p_chunk->argnfs4, &(file_descriptor->stateid), offset,
+                               length);
+
+  p_chunk->is_write = is_write;
+  p_chunk->offset = offset;
+  p_chunk->length = length;
+  p_chunk->data = data;
+  p_chunk->in_flight = FALSE;
+  p_chunk->ready = FALSE;
+  p_chunk->done = 0;
+  p_chunk->eof = FALSE;
+}                               /* proxyfsal_io_chunk_setup */
+
+/* Sends a chunk without waiting for the reply. If it cannot be sent now,
+ * proxyfsal_io_chunk_complete will do it the usual way. */
+static void proxyfsal_io_chunk_submit(proxyfsal_file_t * file_descriptor,
+                                      proxyfsal_io_chunk_t * p_chunk)
+{
+  AUTH *p_auth;
+
+  if(!p_chunk->is_write)
+    p_chunk->resnfs4.resarray.resarray_val[FSAL_PROXY_IO_IDX_OP_RDWR].nfs_resop4_u.opread.
+        READ4res_u.resok4.data.data_val = p_chunk->data;
+
+  /* the chunk has its own credentials, released with its reply */
+  if((p_auth = FSAL_proxy_call_auth(file_descriptor->pcontext)) == NULL)
+    return;
+
+  if(fsal_proxy_rpc_submit(&p_chunk->call, p_auth, NFSPROC4_COMPOUND,
+                           (xdrproc_t) xdr_COMPOUND4args, (caddr_t) & p_chunk->argnfs4,
+                           (xdrproc_t) xdr_COMPOUND4res,
+                           (caddr_t) & p_chunk->resnfs4) == RPC_SUCCESS)
+    p_chunk->in_flight = TRUE;
+  else
+    auth_destroy(p_auth);
+}                               /* proxyfsal_io_chunk_submit */
+
+/* Gets the reply of a chunk and sets its status */
+static void proxyfsal_io_chunk_complete(proxyfsal_file_t * file_descriptor,
+                                        proxyfsal_io_chunk_t * p_chunk)
+{
+  struct timeval timeout = { 25, 0 };
+  int rc = RPC_CANTSEND;
+
+  if(p_chunk->in_flight)
+    {
+      rc = fsal_proxy_rpc_wait(&p_chunk->call, timeout);
+      auth_destroy(p_chunk->call.auth);
+      p_chunk->in_flight = FALSE;
+    }
+
+  /* not sent, or the connection was lost: send it again and wait for a connection */
+  if(FSAL_PROXY_RPC_RETRYABLE(rc))
+    {
+      if(!p_chunk->is_write)
+        p_chunk->resnfs4.resarray.resarray_val[FSAL_PROXY_IO_IDX_OP_RDWR].nfs_resop4_u.
+            opread.READ4res_u.resok4.data.data_val = p_chunk->data;
+
+      COMPOUNDV4_EXECUTE(file_descriptor->pcontext, p_chunk->argnfs4, p_chunk->resnfs4,
+                         rc);
+    }
+
+  p_chunk->ready = TRUE;
+
+  if(rc != RPC_SUCCESS)
+    {
+      p_chunk->status.major = ERR_FSAL_IO;
+      p_chunk->status.minor = rc;
+      return;
+    }
+
+  if(p_chunk->resnfs4.status != NFS4_OK)
+    {
+      p_chunk->status =
+          fsal_internal_proxy_error_convert(p_chunk->resnfs4.status,
+                                            p_chunk->is_write ? INDEX_FSAL_write :
+                                            INDEX_FSAL_read);
+      return;
+    }
+
+  if(p_chunk->is_write)
+    p_chunk->done =
+        p_chunk->resnfs4.resarray.resarray_val[FSAL_PROXY_IO_IDX_OP_RDWR].nfs_resop4_u.
+        opwrite.WRITE4res_u.resok4.count;
+  else
+    {
+      p_chunk->done =
+          p_chunk->resnfs4.resarray.resarray_val[FSAL_PROXY_IO_IDX_OP_RDWR].nfs_resop4_u.
+          opread.READ4res_u.resok4.data.data_len;
+      p_chunk->eof =
+          p_chunk->resnfs4.resarray.resarray_val[FSAL_PROXY_IO_IDX_OP_RDWR].nfs_resop4_u.
+          opread.READ4res_u.resok4.eof;
+    }
+
+  p_chunk->status.major = ERR_FSAL_NO_ERROR;
+  p_chunk->status.minor = 0;
+}                               /* proxyfsal_io_chunk_complete */
+
+/* Gets the reply of a chunk, then asks for what the server did not read
+ * or write at once (its maximum size may be smaller than io_chunk_size) */
+static void proxyfsal_io_chunk_finish(proxyfsal_file_t * file_descriptor,
+                                      proxyfsal_io_chunk_t * p_chunk)
+{
+  proxyfsal_io_chunk_t rest;
+
+  proxyfsal_io_chunk_complete(file_descriptor, p_chunk);
+
+  while(!FSAL_IS_ERROR(p_chunk->status) && !p_chunk->eof && p_chunk->done < p_chunk->length)
+    {
+      proxyfsal_io_chunk_setup(file_descriptor, &rest, p_chunk->is_write,
+                               &p_chunk->argoparray[FSAL_PROXY_IO_IDX_OP_PUTFH].nfs_argop4_u.
+                               opputfh.object, p_chunk->offset + p_chunk->done,
+                               p_chunk->length - p_chunk->done,
+                               p_chunk->data + p_chunk->done);
+      proxyfsal_io_chunk_complete(file_descriptor, &rest);
+
+      if(FSAL_IS_ERROR(rest.status))
+        p_chunk->status = rest.status;
+      else if(rest.done == 0 && !rest.eof)
+        break;
+
+      p_chunk->done += rest.done;
+      p_chunk->eof = rest.eof;
+    }
+}                               /* proxyfsal_io_chunk_finish */
+
+/**
+ * proxyfsal_io_pipeline:
+ * Reads or writes a range with io_window compounds in flight.
+ * The result is the contiguous part done from the beginning of the range:
+ * it stops at the first error or at the end of file.
+ */
+static fsal_status_t proxyfsal_io_pipeline(proxyfsal_file_t * file_descriptor,  /* IN */
+                                           int is_write,        /* IN */
+                                           fsal_off_t offset,   /* IN */
+                                           fsal_size_t size,    /* IN */
+                                           caddr_t buffer,      /* IN/OUT */
+                                           fsal_size_t * p_done,        /* OUT */
+                                           fsal_boolean_t * p_eof       /* OUT */ )
+{
+  proxyfsal_io_chunk_t *chunks;
+  proxyfsal_io_chunk_t *p_chunk;
+  fsal_status_t status;
+  nfs_fh4 nfs4fh;
+  fsal_size_t chunk_size = global_fsal_proxy_specific_info.io_chunk_size;
+  fsal_size_t issued = 0;
+  unsigned int nb_chunks;
+  unsigned int nb_sent = 0;
+  unsigned int nb_done = 0;
+  int stop = FALSE;
+
+  *p_done = 0;
+  *p_eof = FALSE;
+  status.major = ERR_FSAL_NO_ERROR;
+  status.minor = 0;
+
+  if(fsal_internal_proxy_extract_fh(&nfs4fh, &(file_descriptor->fhandle)) == FALSE)
+    {
+      status.major = ERR_FSAL_FAULT;
+      return status;
+    }
+
+  nb_chunks = (size + chunk_size - 1) / chunk_size;
+  if(nb_chunks == 0)
+    nb_chunks = 1;
+  if(nb_chunks > global_fsal_proxy_specific_info.io_window)
+    nb_chunks = global_fsal_proxy_specific_info.io_window;
+
+  if((chunks =
+      (proxyfsal_io_chunk_t *) Mem_Alloc(nb_chunks * sizeof(proxyfsal_io_chunk_t))) == NULL)
+    {
+      status.major = ERR_FSAL_NOMEM;
+      return status;
+    }
+
+  do
+    {
+      /* keep the window full */
+      while(!stop && nb_sent - nb_done < nb_chunks && (issued < size || nb_sent == 0))
+        {
+          fsal_size_t length = (size - issued < chunk_size) ? size - issued : chunk_size;
+
+          p_chunk = &chunks[nb_sent % nb_chunks];
+          proxyfsal_io_chunk_setup(file_descriptor, p_chunk, is_write, &nfs4fh,
+                                   offset + issued, length, buffer + issued);
+          proxyfsal_io_chunk_submit(file_descriptor, p_chunk);
+          issued += length;
+          nb_sent += 1;
+        }
+
+      p_chunk = &chunks[nb_done % nb_chunks];
+      nb_done += 1;
+
+      if(stop)
+        {
+          /* a READ is not needed anymore, a WRITE must be over before returning */
+          if(p_chunk->is_write)
+            proxyfsal_io_chunk_finish(file_descriptor, p_chunk);
+          else if(p_chunk->in_flight)
+            {
+              fsal_proxy_rpc_abandon(&p_chunk->call);
+              auth_destroy(p_chunk->call.auth);
+            }
+          continue;
+        }
+
+      proxyfsal_io_chunk_finish(file_descriptor, p_chunk);
+
+      if(FSAL_IS_ERROR(p_chunk->status))
+        {
+          status = p_chunk->status;
+          stop = TRUE;
+          continue;
+        }
+
+      *p_done += p_chunk->done;
+
+      if(p_chunk->eof || p_chunk->done < p_chunk->length)
+        {
+          *p_eof = p_chunk->eof;
+          stop = TRUE;
+        }
+    }
+  while(nb_done < nb_sent);
+
+  Mem_Free(chunks);
+
+  return status;
+}                               /* proxyfsal_io_pipeline */
+
+/* Creates the read-ahead window of a file that has just been opened */
+static void proxyfsal_io_window_init(proxyfsal_file_t * file_descriptor)
+{
+  proxyfsal_io_window_t *p_window;
+
+  file_descriptor->p_io_window = NULL;
+
+  if(file_descriptor->pcontext->rpc_client != NULL
+     || global_fsal_proxy_specific_info.io_window == 0)
+    return;
+
+  if((p_window = (proxyfsal_io_window_t *) Mem_Alloc(sizeof(proxyfsal_io_window_t))) == NULL)
+    return;
+
+  if((p_window->chunks =
+      (proxyfsal_io_chunk_t *) Mem_Alloc(global_fsal_proxy_specific_info.io_window *
+                                         sizeof(proxyfsal_io_chunk_t))) == NULL)
+    {
+      Mem_Free(p_window);
+      return;
+    }
+
+  pthread_mutex_init(&p_window->lock, NULL);
+  p_window->has_last = FALSE;
+  p_window->last_end = 0;
+  p_window->first = 0;
+  p_window->count = 0;
+  p_window->buffer = NULL;      /* allocated by the first read-ahead */
+
+  file_descriptor->p_io_window = p_window;
+}                               /* proxyfsal_io_window_init */
+
+/* Forgets the chunks read ahead. Must be called with the window locked */
+static void proxyfsal_io_window_drop(proxyfsal_io_window_t * p_window)
+{
+  proxyfsal_io_chunk_t *p_chunk;
+
+  while(p_window->count > 0)
+    {
+      p_chunk = &p_window->chunks[p_window->first];
+      if(p_chunk->in_flight)
+        {
+          fsal_proxy_rpc_abandon(&p_chunk->call);
+          auth_destroy(p_chunk->call.auth);
+          p_chunk->in_flight = FALSE;
+        }
+      p_window->first = (p_window->first + 1) % global_fsal_proxy_specific_info.io_window;
+      p_window->count -= 1;
+    }
+  p_window->first = 0;
+}                               /* proxyfsal_io_window_drop */
+
+static void proxyfsal_io_window_free(proxyfsal_file_t * file_descriptor)
+{
+  proxyfsal_io_window_t *p_window = file_descriptor->p_io_window;
+
+  if(p_window == NULL)
+    return;
+
+  P(p_window->lock);
+  proxyfsal_io_window_drop(p_window);
+  V(p_window->lock);
+
+  pthread_mutex_destroy(&p_window->lock);
+  if(p_window->buffer != NULL)
+    Mem_Free(p_window->buffer);
+  Mem_Free(p_window->chunks);
+  Mem_Free(p_window);
+
+  file_descriptor->p_io_window = NULL;
+}                               /* proxyfsal_io_window_free */
+
+/* Sends the READs of the chunks following 'offset' (or the last chunk read ahead)
+ * until the window is full. Must be called with the window locked */
+static void proxyfsal_io_window_fill(proxyfsal_file_t * file_descriptor,
+                                     proxyfsal_io_window_t * p_window, fsal_off_t offset)
+{
+  proxyfsal_io_chunk_t *p_chunk;
+  nfs_fh4 nfs4fh;
+  unsigned int nb_chunks = global_fsal_proxy_specific_info.io_window;
+  fsal_size_t chunk_size = global_fsal_proxy_specific_info.io_chunk_size;
+  unsigned int index;
+
+  if(p_window->buffer == NULL
+     && (p_window->buffer = (char *)Mem_Alloc(nb_chunks * chunk_size)) == NULL)
+    return;
+
+  if(fsal_internal_proxy_extract_fh(&nfs4fh, &(file_descriptor->fhandle)) == FALSE)
+    return;
+
+  if(p_window->count > 0)
+    {
+      p_chunk = &p_window->chunks[(p_window->first + p_window->count - 1) % nb_chunks];
+      offset = p_chunk->offset + p_chunk->length;
+    }
+
+  while(p_window->count < nb_chunks)
+    {
+      index = (p_window->first + p_window->count) % nb_chunks;
+      p_chunk = &p_window->chunks[index];
+
+      proxyfsal_io_chunk_setup(file_descriptor, p_chunk, FALSE, &nfs4fh, offset, chunk_size,
+                               p_window->buffer + index * chunk_size);
+      proxyfsal_io_chunk_submit(file_descriptor, p_chunk);
+
+      /* no connection: this is not the time for reading ahead */
+      if(!p_chunk->in_flight)
+        break;
+
+      p_window->count += 1;
+      offset += chunk_size;
+    }
+}                               /* proxyfsal_io_window_fill */
+
+/**
+ * proxyfsal_io_read:
+ * Reads a range from the chunks read ahead, then from the server,
+ * and keeps reading ahead if the read is sequential.
+ */
+static fsal_status_t proxyfsal_io_read(proxyfsal_file_t * file_descriptor,      /* IN */
+                                       fsal_off_t offset,       /* IN */
+                                       fsal_size_t size,        /* IN */
+                                       caddr_t buffer,  /* OUT */
+                                       fsal_size_t * p_read_amount,     /* OUT */
+                                       fsal_boolean_t * p_eof   /* OUT */ )
+{
+  proxyfsal_io_window_t *p_window = file_descriptor->p_io_window;
+  proxyfsal_io_chunk_t *p_chunk;
+  fsal_status_t status;
+  fsal_size_t done = 0;
+  fsal_size_t direct;
+  fsal_size_t length;
+  fsal_off_t position;
+  fsal_boolean_t eof = FALSE;
+
+  /* readers of the same file do not wait for each other: the window is for
+   * the first one, the others read directly */
+  if(p_window == NULL || pthread_mutex_trylock(&p_window->lock) != 0)
+    return proxyfsal_io_pipeline(file_descriptor, FALSE, offset, size, buffer,
+                                 p_read_amount, p_eof);
+
+  while(done < size && p_window->count > 0)
+    {
+      p_chunk = &p_window->chunks[p_window->first];
+      position = offset + done;
+
+      if(!p_chunk->ready)
+        proxyfsal_io_chunk_finish(file_descriptor, p_chunk);
+
+      /* the read is not where we read ahead: it will be done directly */
+      if(FSAL_IS_ERROR(p_chunk->status) || position < p_chunk->offset)
+        {
+          proxyfsal_io_window_drop(p_window);
+          break;
+        }
+
+      if(position >= p_chunk->offset + p_chunk->done)
+        {
+          if(p_chunk->eof)
+            {
+              eof = TRUE;
+              break;
+            }
+
+          /* skipped, or after a short read */
+          p_window->first = (p_window->first + 1) % global_fsal_proxy_specific_info.io_window;
+          p_window->count -= 1;
+          continue;
+        }
+
+      length = p_chunk->offset + p_chunk->done - position;
+      if(length > size - done)
+        length = size - done;
+
+      memcpy(buffer + done, p_chunk->data + (position - p_chunk->offset), length);
+      done += length;
+
+      if(position + length == p_chunk->offset + p_chunk->done)
+        {
+          if(p_chunk->eof)
+            {
+              eof = TRUE;
+              break;
+            }
+
+          p_window->first = (p_window->first + 1) % global_fsal_proxy_specific_info.io_window;
+          p_window->count -= 1;
+        }
+    }
+
+  if(done < size && !eof)
+    {
+      status = proxyfsal_io_pipeline(file_descriptor, FALSE, offset + done, size - done,
+                                     buffer + done, &direct, &eof);
+      if(FSAL_IS_ERROR(status))
+        {
+          proxyfsal_io_window_drop(p_window);
+          p_window->has_last = FALSE;
+          V(p_window->lock);
+          return status;
+        }
+      done += direct;
+    }
+
+  /* sequential read: get the next chunks before they are asked */
+  if(p_window->has_last && p_window->last_end == offset && !eof)
+    proxyfsal_io_window_fill(file_descriptor, p_window, offset + done);
+
+  p_window->has_last = TRUE;
+  p_window->last_end = offset + done;
+
+  V(p_window->lock);
+
+  *p_read_amount = done;
+  *p_eof = eof;
+
+  status.major = ERR_FSAL_NO_ERROR;
+  status.minor = 0;
+  return status;
+}                               /* proxyfsal_io_read */
+
+/**
+ * proxyfsal_io_write:
+ * Writes a range with io_window compounds in flight,
+ * after dropping what was read ahead.
+ */
+static fsal_status_t proxyfsal_io_write(proxyfsal_file_t * file_descriptor,     /* IN */
+                                        fsal_off_t offset,      /* IN */
+                                        fsal_size_t size,       /* IN */
+                                        caddr_t buffer, /* IN */
+                                        fsal_size_t * p_write_amount    /* OUT */ )
+{
+  proxyfsal_io_window_t *p_window = file_descriptor->p_io_window;
+  fsal_boolean_t eof;
+
+  if(p_window != NULL)
+    {
+      P(p_window->lock);
+      proxyfsal_io_window_drop(p_window);
+      p_window->has_last = FALSE;
+      V(p_window->lock);
+    }
+
+  return proxyfsal_io_pipeline(file_descriptor, TRUE, offset, size, buffer, p_write_amount,
+                               &eof);
+}                               /* proxyfsal_io_write */
+
+
 /**
  * FSAL_open_by_name:
  * Open a regular file for reading/writing its data content.
@@ -279,6 +827,8 @@ fsal_status_t PROXYFSAL_open_by_name(proxyfsal_handle_t * dirhandle,    /* IN */
         Return(fsal_status.major, fsal_status.minor, INDEX_FSAL_open_by_name);
     }
 
+  proxyfsal_io_window_init(file_descriptor);
+
   Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_open_by_name);
 }                               /* FSAL_open_by_name */
 
@@ -351,6 +901,22 @@ static fsal_status_t PROXYFSAL_open_stateless(proxyfsal_handle_t * filehandle,
       Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_open);
     }
 
+  /* Without attributes to return, there is nothing to ask the server: a stale
+   * handle will be reported by the PUTFH in front of the first READ or WRITE */
+  if(file_attributes == NULL)
+    {
+      memcpy((char *)&file_descriptor->fhandle, filehandle, sizeof(proxyfsal_handle_t));
+      file_descriptor->openflags = openflags;
+      file_descriptor->current_offset = 0;
+      file_descriptor->pcontext = p_context;
+      file_descriptor->stateid.seqid = 0;
+      memset((char *)file_descriptor->stateid.other, 0, 12);
+
+      proxyfsal_io_window_init(file_descriptor);
+
+      Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_open);
+    }
+
   /* Setup results structures */
   argnfs4.argarray.argarray_val = argoparray;
   resnfs4.resarray.resarray_val = resoparray;
@@ -445,6 +1011,8 @@ static fsal_status_t PROXYFSAL_open_stateless(proxyfsal_handle_t * filehandle,
   file_descriptor->stateid.seqid = 0;
   memset((char *)file_descriptor->stateid.other, 0, 12);
 
+  proxyfsal_io_window_init(file_descriptor);
+
   Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_open);
 }                               /* FSAL_open_stateless */
 
@@ -555,6 +1123,7 @@ fsal_status_t PROXYFSAL_read(proxyfsal_file_t * file_descriptor,        /* IN */
   COMPOUND4res resnfs4;
   nfs_fh4 nfs4fh;
   fsal_off_t offset;
+  fsal_status_t fsal_status;
   struct timeval timeout = { 25, 0 };
 
 #define FSAL_READ_NB_OP_ALLOC 2
@@ -582,11 +1151,32 @@ fsal_status_t PROXYFSAL_read(proxyfsal_file_t * file_descriptor,        /* IN */
           break;
 
         case FSAL_SEEK_END:
+        default:
           Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_read);
           break;
         }
     }
 
+  /* Through the pipelined client, the read is split in compounds sent together */
+  if(file_descriptor->pcontext->rpc_client == NULL
+     && global_fsal_proxy_specific_info.io_window > 0)
+    {
+      TakeTokenFSCall();
+
+      fsal_status = proxyfsal_io_read(file_descriptor, offset, buffer_size, buffer,
+                                      read_amount, end_of_file);
+
+      ReleaseTokenFSCall();
+
+      if(FSAL_IS_ERROR(fsal_status))
+        Return(fsal_status.major, fsal_status.minor, INDEX_FSAL_read);
+
+      /* update the offset within the fsal_fd_t */
+      file_descriptor->current_offset += *read_amount;
+
+      Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_read);
+    }
+
   /* Setup results structures */
   argnfs4.argarray.argarray_val = argoparray;
   resnfs4.resarray.resarray_val = resoparray;
@@ -681,6 +1271,7 @@ fsal_status_t PROXYFSAL_write(proxyfsal_file_t * file_descriptor,       /* IN */
   nfs_fh4 nfs4fh;
 
   fsal_off_t offset;
+  fsal_status_t fsal_status;
 
   struct timeval timeout = { 25, 0 };
 
@@ -708,11 +1299,32 @@ fsal_status_t PROXYFSAL_write(proxyfsal_file_t * file_descriptor,       /* IN */
           break;
 
         case FSAL_SEEK_END:
+        default:
           Return(ERR_FSAL_INVAL, 0, INDEX_FSAL_write);
           break;
         }
     }
 
+  /* Through the pipelined client, the write is split in compounds sent together */
+  if(file_descriptor->pcontext->rpc_client == NULL
+     && global_fsal_proxy_specific_info.io_window > 0)
+    {
+      TakeTokenFSCall();
+
+      fsal_status = proxyfsal_io_write(file_descriptor, offset, buffer_size, buffer,
+                                       write_amount);
+
+      ReleaseTokenFSCall();
+
+      if(FSAL_IS_ERROR(fsal_status))
+        Return(fsal_status.major, fsal_status.minor, INDEX_FSAL_write);
+
+      /* update the offset within the fsal_fd_t */
+      file_descriptor->current_offset += *write_amount;
+
+      Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_write);
+    }
+
   /* Setup results structures */
   argnfs4.argarray.argarray_val = argoparray;
   resnfs4.resarray.resarray_val = resoparray;
@@ -803,6 +1415,8 @@ fsal_status_t PROXYFSAL_close(proxyfsal_file_t * file_descriptor        /* IN */
   if(!file_descriptor)
     Return(ERR_FSAL_FAULT, 0, INDEX_FSAL_close);
 
+  proxyfsal_io_window_free(file_descriptor);
+
   /* Check if this was a "stateless" open, then nothing is to be done at close */
   if(!memcmp(file_descriptor->stateid.other, All_Zero, 12))
     Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_close);
@@ -1190,6 +1804,8 @@ fsal_status_t PROXYFSAL_open_by_fileid(proxyfsal_handle_t * filehandle, /* IN */
         Return(fsal_status.major, fsal_status.minor, INDEX_FSAL_open);
     }
 
+  proxyfsal_io_window_init(file_descriptor);
+
   Return(ERR_FSAL_NO_ERROR, 0, INDEX_FSAL_open_by_fileid);
 
 }                               /* FSAL_open_by_fileid */
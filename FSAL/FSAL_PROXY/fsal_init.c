@@ -186,6 +186,11 @@ static int FS_Specific_Init(proxyfs_specific_initinfo_t * fs_init_info)
         return rc;
     }
 #endif
+
+  /* Start the shared connections to the server, before any op context is created */
+  if((rc = fsal_proxy_rpc_init(fs_init_info)) != 0)
+    return rc;
+
   /* Init the thread in charge of renewing the client id */
   /* Init for thread parameter (mostly for scheduling) */
   pthread_attr_init(&attr_thr);
@@ -134,6 +134,54 @@ int FSAL_proxy_set_hldir(fsal_op_context_t * p_thr_context, char *hl_path);
 int fsal_internal_ClientReconnect(fsal_op_context_t * p_thr_context);
 fsal_status_t FSAL_proxy_open_confirm(fsal_file_t * pfd);
 void *FSAL_proxy_change_user(fsal_op_context_t * p_thr_context);
+AUTH *FSAL_proxy_call_auth(fsal_op_context_t * p_thr_context);
+
+/* Pipelined RPC client shared by the op contexts (fsal_proxy_rpc.c) */
+
+#define FSAL_PROXY_RPC_CALL_PENDING  0
+#define FSAL_PROXY_RPC_CALL_REPLIED  1
+#define FSAL_PROXY_RPC_CALL_FAILED   2
+
+/* The pipelined client handles AUTH_UNIX over TCP, RPCSEC_GSS and UDP keep a client per thread */
+#define FSAL_PROXY_RPC_USABLE( p_init_info )           \
+  ( !strcmp( (p_init_info)->srv_proto, "tcp" )         \
+    && !(p_init_info)->active_krb5                     \
+    && (p_init_info)->srv_nb_conn > 0 )
+
+/* Errors after which a call can be sent again once a connection is back */
+#define FSAL_PROXY_RPC_RETRYABLE( rc )                 \
+  ( (rc) == RPC_CANTSEND || (rc) == RPC_CANTRECV || (rc) == RPC_TIMEDOUT )
+
+/* Completion object of a call, owned by the caller (usually on its stack) */
+typedef struct fsal_proxy_rpc_call__
+{
+  u_int32_t xid;
+  unsigned int state;           /* FSAL_PROXY_RPC_CALL_* */
+  enum clnt_stat status;        /* set when state is FSAL_PROXY_RPC_CALL_FAILED */
+  struct fsal_proxy_rpc_conn__ *p_conn;
+  AUTH *auth;
+  xdrproc_t xdr_res;
+  caddr_t res;
+  char *reply_buff;
+  unsigned int reply_len;
+  pthread_cond_t cond;
+  struct fsal_proxy_rpc_call__ *next;
+} fsal_proxy_rpc_call_t;
+
+int fsal_proxy_rpc_init(proxyfs_specific_initinfo_t * p_init_info);
+int fsal_proxy_rpc_enabled(void);
+enum clnt_stat fsal_proxy_rpc_submit(fsal_proxy_rpc_call_t * p_call,
+                                     AUTH * auth,
+                                     u_int proc,
+                                     xdrproc_t xdr_args,
+                                     caddr_t args, xdrproc_t xdr_res, caddr_t res);
+enum clnt_stat fsal_proxy_rpc_wait(fsal_proxy_rpc_call_t * p_call, struct timeval timeout);
+void fsal_proxy_rpc_abandon(fsal_proxy_rpc_call_t * p_call);
+enum clnt_stat fsal_proxy_rpc_call(AUTH * auth,
+                                   u_int proc,
+                                   xdrproc_t xdr_args,
+                                   caddr_t args,
+                                   xdrproc_t xdr_res, caddr_t res, struct timeval timeout);
 
 /* All the call to FSAL to be wrapped */
 fsal_status_t PROXYFSAL_access(proxyfsal_handle_t * p_object_handle,    /* IN */
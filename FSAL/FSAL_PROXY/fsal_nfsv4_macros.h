@@ -262,6 +262,20 @@ do {
 do {                                                                                \
   int __renew_rc = 0 ;                                                              \
   rc = -1 ;                                                                         \
+  if( pcontext->rpc_client == NULL )                                                \
+    {                                                                               \
+      /* shared pipelined client: its receiver threads handle the reconnection */  \
+      do {                                                                          \
+        AUTH * __call_auth ;                                                        \
+        if( ( __call_auth = FSAL_proxy_call_auth( pcontext ) ) == NULL ) break ;    \
+        rc = fsal_proxy_rpc_call( __call_auth, NFSPROC4_COMPOUND,                   \
+                                  (xdrproc_t)xdr_COMPOUND4args, (caddr_t)&argcompound, \
+                                  (xdrproc_t)xdr_COMPOUND4res,  (caddr_t)&rescompound, \
+                                  timeout ) ;                                       \
+        auth_destroy( __call_auth ) ;                                               \
+      } while( FSAL_PROXY_RPC_RETRYABLE( rc ) ) ;                                   \
+      break ;                                                                       \
+    }                                                                               \
   do {                                                                              \
   if( __renew_rc == 0 )                                                             \
       {                                                                             \
@@ -280,9 +294,14 @@ do {
 }  while( 0 )
 
 #define COMPOUNDV4_EXECUTE_SIMPLE( pcontext, argcompound, rescompound )   \
-   clnt_call( pcontext->rpc_client, NFSPROC4_COMPOUND,                    \
+   ( ( pcontext->rpc_client == NULL ) ?                                   \
+     fsal_proxy_rpc_call( pcontext->rpc_auth, NFSPROC4_COMPOUND,          \
               (xdrproc_t)xdr_COMPOUND4args, (caddr_t)&argcompound,        \
               (xdrproc_t)xdr_COMPOUND4res,  (caddr_t)&rescompound,        \
-              timeout )
+              timeout ) :                                                 \
+     clnt_call( pcontext->rpc_client, NFSPROC4_COMPOUND,                  \
+              (xdrproc_t)xdr_COMPOUND4args, (caddr_t)&argcompound,        \
+              (xdrproc_t)xdr_COMPOUND4res,  (caddr_t)&rescompound,        \
+              timeout ) )
 
 #endif                          /* _FSAL_NFSV4_MACROS_H */
@@ -1514,3 +1514,55 @@ void *FSAL_proxy_change_user(proxyfsal_op_context_t * p_thr_context)
   /* Return authentication */
   return p_thr_context->rpc_client->cl_auth;
 }                               /* FSAL_proxy_change_user */
+
+/**
+ * FSAL_proxy_call_auth: builds the credentials of one call of the shared
+ * pipelined client, for the user of the context.
+ *
+ * The AUTH of the context is never given to the pipelined client: several
+ * threads may use one context (e.g. the readers of an open file), and an AUTH
+ * replaced by one of them could still be marshalled by another. The caller
+ * releases the AUTH with auth_destroy once the reply is received.
+ *
+ * \return the new AUTH, or NULL if it can't be built.
+ */
+AUTH *FSAL_proxy_call_auth(proxyfsal_op_context_t * p_thr_context)
+{
+  static char hostname[MAXNAMLEN];
+  static bool_t done = FALSE;
+  AUTH *p_auth = NULL;
+
+  P(p_thr_context->lock);
+  switch (p_thr_context->rpc_auth->ah_cred.oa_flavor)
+    {
+    case AUTH_NONE:
+      p_auth = authnone_create();
+      break;
+
+    case AUTH_UNIX:
+      if(!done)
+        {
+          if(gethostname(hostname, MAXNAMLEN) == -1)
+            strncpy(hostname, "NFS-GANESHA/Proxy", MAXNAMLEN);
+
+          done = TRUE;
+        }
+
+      p_auth = authunix_create(hostname,
+                               p_thr_context->user_credential.user,
+                               p_thr_context->user_credential.group,
+                               p_thr_context->user_credential.nbgroups,
+                               p_thr_context->user_credential.alt_groups);
+      break;
+
+    default:
+      /* the pipelined client is only set up with AUTH_UNIX */
+      LogCrit(COMPONENT_FSAL, "FSAL_proxy_call_auth: unsupported flavor %d",
+              p_thr_context->rpc_auth->ah_cred.oa_flavor);
+      break;
+    }
+
+  V(p_thr_context->lock);
+
+  return p_auth;
+}                               /* FSAL_proxy_call_auth */
@@ -0,0 +1,809 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ */
+
+/**
+ *
+ * \file    fsal_proxy_rpc.c
+ * \brief   Pipelined RPC client shared by all the threads using FSAL_PROXY.
+ *
+ * A small pool of TCP connections to the upstream NFSv4 server is shared by
+ * every op context. Requests are encoded and written by the calling thread,
+ * each connection has its own receiver thread that reads the replies and
+ * hands them to the waiting call matching their xid. Many calls can be in
+ * flight on the same connection. Reconnection (with its backoff) is done by
+ * the receiver thread, request threads only wait for a connection to be up.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif                          /* _SOLARIS */
+
+#ifdef _USE_GSSRPC
+#include <gssrpc/rpc.h>
+#include <gssrpc/xdr.h>
+#include <gssrpc/auth.h>
+#else
+#include <rpc/rpc.h>
+#include <rpc/xdr.h>
+#include <rpc/auth.h>
+#endif
+
+#include "stuff_alloc.h"
+#include "fsal.h"
+#include "fsal_internal.h"
+#include "fsal_common.h"
+#include "RW_Lock.h"
+
+#include <pthread.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/time.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <netdb.h>              /* For rresvport */
+
+#ifndef _NO_BUDDY_SYSTEM
+extern buddy_parameter_t default_buddy_parameter;
+#endif
+
+extern proxyfs_specific_initinfo_t global_fsal_proxy_specific_info;
+
+/* number of buckets for the table of the calls waiting for a reply */
+#define FSAL_PROXY_RPC_XID_HASH      64
+
+/* room for the call header and the credentials, in front of the arguments */
+#define FSAL_PROXY_RPC_HEADER_MAXLEN (64 + 2 * MAX_AUTH_BYTES)
+
+/* a reply record bigger than this means the stream is out of sync */
+#define FSAL_PROXY_RPC_MAX_RECORD    (16 * 1024 * 1024)
+
+#define FSAL_PROXY_RPC_LAST_FRAG     0x80000000U
+
+typedef struct fsal_proxy_rpc_conn__
+{
+  int sock;                     /* -1 while disconnected */
+  unsigned int index;
+  unsigned int generation;      /* incremented at each (re)connection */
+  u_int32_t next_xid;
+  unsigned int nb_pending;
+  fsal_proxy_rpc_call_t *pending[FSAL_PROXY_RPC_XID_HASH];
+  pthread_mutex_t lock;         /* protects all the fields above */
+  pthread_mutex_t send_lock;    /* one record at a time on the socket */
+  pthread_t thrid;
+} fsal_proxy_rpc_conn_t;
+
+typedef struct fsal_proxy_rpc_pool__
+{
+  unsigned int nb_conn;
+  fsal_proxy_rpc_conn_t *conn;
+  unsigned int next_conn;
+  unsigned int nb_up;
+  pthread_mutex_t lock;         /* protects nb_up */
+  pthread_cond_t cond_up;
+} fsal_proxy_rpc_pool_t;
+
+static fsal_proxy_rpc_pool_t rpc_pool;
+
+static int write_all(int fd, char *buff, size_t len)
+{
+  ssize_t rc;
+
+  while(len > 0)
+    {
+      rc = write(fd, buff, len);
+      if(rc < 0 && errno == EINTR)
+        continue;
+      if(rc <= 0)
+        return -1;
+      buff += rc;
+      len -= rc;
+    }
+  return 0;
+}                               /* write_all */
+
+static int read_all(int fd, char *buff, size_t len)
+{
+  ssize_t rc;
+
+  while(len > 0)
+    {
+      rc = read(fd, buff, len);
+      if(rc < 0 && errno == EINTR)
+        continue;
+      if(rc <= 0)
+        return -1;
+      buff += rc;
+      len -= rc;
+    }
+  return 0;
+}                               /* read_all */
+
+/* Removes a call from the pending table. Must be called with p_conn->lock held.
+ * Returns TRUE if the call was still waiting for its reply. */
+static int fsal_proxy_rpc_unlink(fsal_proxy_rpc_conn_t * p_conn,
+                                 fsal_proxy_rpc_call_t * p_call)
+{
+  fsal_proxy_rpc_call_t **pp_call;
+
+  for(pp_call = &p_conn->pending[p_call->xid % FSAL_PROXY_RPC_XID_HASH];
+      *pp_call != NULL; pp_call = &(*pp_call)->next)
+    {
+      if(*pp_call == p_call)
+        {
+          *pp_call = p_call->next;
+          p_call->next = NULL;
+          p_conn->nb_pending -= 1;
+          return TRUE;
+        }
+    }
+  return FALSE;
+}                               /* fsal_proxy_rpc_unlink */
+
+static int fsal_proxy_rpc_connect(fsal_proxy_rpc_conn_t * p_conn)
+{
+  struct sockaddr_in addr_rpc;
+  int sock;
+  int priv_port = 0;
+  int one = 1;
+
+  memset(&addr_rpc, 0, sizeof(addr_rpc));
+  addr_rpc.sin_port = global_fsal_proxy_specific_info.srv_port;
+  addr_rpc.sin_family = AF_INET;
+  addr_rpc.sin_addr.s_addr = global_fsal_proxy_specific_info.srv_addr;
+
+  if(global_fsal_proxy_specific_info.use_privileged_client_port == TRUE)
+    sock = rresvport(&priv_port);
+  else
+    sock = socket(AF_INET, SOCK_STREAM, IPPROTO_TCP);
+
+  if(sock < 0)
+    {
+      LogCrit(COMPONENT_FSAL, "FSAL RPC: cannot create a tcp socket (errno=%u)", errno);
+      return -1;
+    }
+
+  if(connect(sock, (struct sockaddr *)&addr_rpc, sizeof(addr_rpc)) < 0)
+    {
+      LogMajor(COMPONENT_FSAL,
+               "FSAL RPC: connection #%u cannot connect to server addr=%u.%u.%u.%u port=%u",
+               p_conn->index,
+               (ntohl(global_fsal_proxy_specific_info.srv_addr) & 0xFF000000) >> 24,
+               (ntohl(global_fsal_proxy_specific_info.srv_addr) & 0x00FF0000) >> 16,
+               (ntohl(global_fsal_proxy_specific_info.srv_addr) & 0x0000FF00) >> 8,
+               (ntohl(global_fsal_proxy_specific_info.srv_addr) & 0x000000FF),
+               ntohs(global_fsal_proxy_specific_info.srv_port));
+      close(sock);
+      return -1;
+    }
+
+  /* requests are written as whole records, do not let Nagle delay them */
+  setsockopt(sock, IPPROTO_TCP, TCP_NODELAY, (char *)&one, sizeof(one));
+
+  P(p_conn->lock);
+  p_conn->sock = sock;
+  p_conn->generation += 1;
+  V(p_conn->lock);
+
+  P(rpc_pool.lock);
+  rpc_pool.nb_up += 1;
+  pthread_cond_broadcast(&rpc_pool.cond_up);
+  V(rpc_pool.lock);
+
+  LogEvent(COMPONENT_FSAL, "FSAL RPC: connection #%u to the server is up", p_conn->index);
+
+  return 0;
+}                               /* fsal_proxy_rpc_connect */
+
+/* Closes the connection and fails all the calls still waiting on it. */
+static void fsal_proxy_rpc_disconnect(fsal_proxy_rpc_conn_t * p_conn)
+{
+  fsal_proxy_rpc_call_t *p_call;
+  unsigned int i;
+
+  /* unblock a sender stuck on the dead socket, then wait for it to leave */
+  shutdown(p_conn->sock, SHUT_RDWR);
+
+  P(p_conn->send_lock);
+  P(p_conn->lock);
+
+  close(p_conn->sock);
+  p_conn->sock = -1;
+  p_conn->generation += 1;
+
+  for(i = 0; i < FSAL_PROXY_RPC_XID_HASH; i++)
+    {
+      while((p_call = p_conn->pending[i]) != NULL)
+        {
+          p_conn->pending[i] = p_call->next;
+          p_call->next = NULL;
+          p_call->state = FSAL_PROXY_RPC_CALL_FAILED;
+          p_call->status = RPC_CANTRECV;
+          pthread_cond_signal(&p_call->cond);
+        }
+    }
+  p_conn->nb_pending = 0;
+
+  V(p_conn->lock);
+  V(p_conn->send_lock);
+
+  P(rpc_pool.lock);
+  rpc_pool.nb_up -= 1;
+  V(rpc_pool.lock);
+
+  LogMajor(COMPONENT_FSAL, "FSAL RPC: connection #%u to the server was lost", p_conn->index);
+}                               /* fsal_proxy_rpc_disconnect */
+
+/* Reads a whole record (all its fragments) in a buffer allocated here. */
+static int fsal_proxy_rpc_read_record(int sock, char **p_buff, unsigned int *p_len)
+{
+  u_int32_t mark;
+  unsigned int frag_len;
+  unsigned int len = 0;
+  char *buff = NULL;
+  char *new_buff;
+
+  do
+    {
+      if(read_all(sock, (char *)&mark, sizeof(mark)))
+        break;
+
+      mark = ntohl(mark);
+      frag_len = mark & ~FSAL_PROXY_RPC_LAST_FRAG;
+
+      if(len + frag_len > FSAL_PROXY_RPC_MAX_RECORD)
+        {
+          LogCrit(COMPONENT_FSAL, "FSAL RPC: unexpected record size %u", len + frag_len);
+          break;
+        }
+
+      new_buff = (buff == NULL) ? Mem_Alloc(len + frag_len)
+          : Mem_Realloc(buff, len + frag_len);
+      if(new_buff == NULL)
+        break;
+      buff = new_buff;
+
+      if(read_all(sock, buff + len, frag_len))
+        break;
+      len += frag_len;
+
+      if(mark & FSAL_PROXY_RPC_LAST_FRAG)
+        {
+          *p_buff = buff;
+          *p_len = len;
+          return 0;
+        }
+    }
+  while(1);
+
+  if(buff != NULL)
+    Mem_Free(buff);
+  return -1;
+}                               /* fsal_proxy_rpc_read_record */
+
+/* Gives a reply to the call waiting for its xid (or drops it). */
+static void fsal_proxy_rpc_dispatch(fsal_proxy_rpc_conn_t * p_conn, char *buff,
+                                    unsigned int len)
+{
+  fsal_proxy_rpc_call_t *p_call;
+  u_int32_t xid;
+
+  if(len < sizeof(xid))
+    {
+      Mem_Free(buff);
+      return;
+    }
+
+  memcpy(&xid, buff, sizeof(xid));
+  xid = ntohl(xid);
+
+  P(p_conn->lock);
+
+  for(p_call = p_conn->pending[xid % FSAL_PROXY_RPC_XID_HASH]; p_call != NULL;
+      p_call = p_call->next)
+    if(p_call->xid == xid)
+      break;
+
+  if(p_call != NULL)
+    {
+      fsal_proxy_rpc_unlink(p_conn, p_call);
+      p_call->reply_buff = buff;
+      p_call->reply_len = len;
+      p_call->state = FSAL_PROXY_RPC_CALL_REPLIED;
+      pthread_cond_signal(&p_call->cond);
+    }
+
+  V(p_conn->lock);
+
+  /* the call gave up waiting (timeout) */
+  if(p_call == NULL)
+    {
+      LogFullDebug(COMPONENT_FSAL, "FSAL RPC: dropping reply for unknown xid %u", xid);
+      Mem_Free(buff);
+    }
+}                               /* fsal_proxy_rpc_dispatch */
+
+static void *fsal_proxy_rpc_receiver_thread(void *Arg)
+{
+  fsal_proxy_rpc_conn_t *p_conn = (fsal_proxy_rpc_conn_t *) Arg;
+  unsigned int delay = 1;
+  unsigned int max_delay;
+  char *buff;
+  unsigned int len;
+#ifndef _NO_BUDDY_SYSTEM
+  int rc;
+  buddy_parameter_t buddy_param = default_buddy_parameter;
+
+  if((rc = BuddyInit(&buddy_param)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_FSAL,
+              "FSAL RPC: Memory manager could not be initialized, exiting...");
+      exit(1);
+    }
+#endif
+
+  max_delay = global_fsal_proxy_specific_info.retry_sleeptime;
+  if(max_delay == 0)
+    max_delay = 1;
+
+  while(1)
+    {
+      /* only this thread changes p_conn->sock */
+      if(p_conn->sock < 0)
+        {
+          if(fsal_proxy_rpc_connect(p_conn) != 0)
+            {
+              /* exponential backoff, up to Retry_SleepTime */
+              sleep(delay);
+              delay = (2 * delay > max_delay) ? max_delay : 2 * delay;
+              continue;
+            }
+          delay = 1;
+        }
+
+      if(fsal_proxy_rpc_read_record(p_conn->sock, &buff, &len) != 0)
+        {
+          fsal_proxy_rpc_disconnect(p_conn);
+          continue;
+        }
+
+      fsal_proxy_rpc_dispatch(p_conn, buff, len);
+    }
+
+  return NULL;
+}                               /* fsal_proxy_rpc_receiver_thread */
+
+/**
+ * fsal_proxy_rpc_init:
+ * Creates the connection pool and starts one receiver thread per connection.
+ * The connections are established asynchronously by the receiver threads.
+ *
+ * \param p_init_info (input):
+ *        FSAL_PROXY specific configuration.
+ *
+ * \return 0 if OK, an errno otherwise.
+ */
+int fsal_proxy_rpc_init(proxyfs_specific_initinfo_t * p_init_info)
+{
+  pthread_attr_t attr_thr;
+  unsigned int i;
+  int rc;
+
+  memset(&rpc_pool, 0, sizeof(rpc_pool));
+
+  if(!FSAL_PROXY_RPC_USABLE(p_init_info))
+    {
+      LogEvent(COMPONENT_FSAL,
+               "FSAL RPC: pipelined client not used, each thread owns its rpc client");
+      return 0;
+    }
+
+  rpc_pool.conn =
+      (fsal_proxy_rpc_conn_t *) Mem_Alloc(p_init_info->srv_nb_conn *
+                                          sizeof(fsal_proxy_rpc_conn_t));
+  if(rpc_pool.conn == NULL)
+    return ENOMEM;
+
+  memset(rpc_pool.conn, 0, p_init_info->srv_nb_conn * sizeof(fsal_proxy_rpc_conn_t));
+  pthread_mutex_init(&rpc_pool.lock, NULL);
+  pthread_cond_init(&rpc_pool.cond_up, NULL);
+
+  pthread_attr_init(&attr_thr);
+  pthread_attr_setscope(&attr_thr, PTHREAD_SCOPE_SYSTEM);
+  pthread_attr_setdetachstate(&attr_thr, PTHREAD_CREATE_JOINABLE);
+
+  for(i = 0; i < p_init_info->srv_nb_conn; i++)
+    {
+      fsal_proxy_rpc_conn_t *p_conn = &rpc_pool.conn[i];
+
+      p_conn->sock = -1;
+      p_conn->index = i;
+      p_conn->next_xid = ((u_int32_t) time(NULL) ^ (u_int32_t) getpid()) + (i << 24);
+      pthread_mutex_init(&p_conn->lock, NULL);
+      pthread_mutex_init(&p_conn->send_lock, NULL);
+
+      if((rc = pthread_create(&p_conn->thrid, &attr_thr,
+                              fsal_proxy_rpc_receiver_thread, (void *)p_conn)) != 0)
+        {
+          LogError(COMPONENT_FSAL, ERR_SYS, ERR_PTHREAD_CREATE, rc);
+          return rc;
+        }
+    }
+
+  /* the pool is only used once all its receivers are running */
+  rpc_pool.nb_conn = p_init_info->srv_nb_conn;
+
+  LogEvent(COMPONENT_FSAL, "FSAL RPC: pipelined client started with %u connections",
+           rpc_pool.nb_conn);
+
+  return 0;
+}                               /* fsal_proxy_rpc_init */
+
+/**
+ * fsal_proxy_rpc_enabled:
+ * Tells whether the op contexts must use the shared pipelined client.
+ */
+int fsal_proxy_rpc_enabled(void)
+{
+  return (rpc_pool.nb_conn > 0);
+}                               /* fsal_proxy_rpc_enabled */
+
+/* Waits (without polling) until a connection is up, or the timeout expires. */
+static int fsal_proxy_rpc_wait_connected(struct timeval timeout)
+{
+  struct timeval now;
+  struct timespec deadline;
+  int rc = 0;
+
+  P(rpc_pool.lock);
+
+  if(rpc_pool.nb_up == 0)
+    {
+      gettimeofday(&now, NULL);
+      deadline.tv_sec = now.tv_sec + timeout.tv_sec;
+      deadline.tv_nsec = (now.tv_usec + timeout.tv_usec) * 1000;
+      if(deadline.tv_nsec >= 1000000000)
+        {
+          deadline.tv_sec += 1;
+          deadline.tv_nsec -= 1000000000;
+        }
+
+      while(rpc_pool.nb_up == 0 && rc != ETIMEDOUT)
+        rc = pthread_cond_timedwait(&rpc_pool.cond_up, &rpc_pool.lock, &deadline);
+    }
+
+  rc = (rpc_pool.nb_up == 0);
+  V(rpc_pool.lock);
+
+  return rc;
+}                               /* fsal_proxy_rpc_wait_connected */
+
+/* Picks a connection that is up, the least loaded one starting from a rotating index. */
+static fsal_proxy_rpc_conn_t *fsal_proxy_rpc_choose_conn(void)
+{
+  fsal_proxy_rpc_conn_t *p_best = NULL;
+  fsal_proxy_rpc_conn_t *p_conn;
+  unsigned int start;
+  unsigned int i;
+
+  /* racy reads: this is only a hint, the connection is checked again under its lock */
+  start = rpc_pool.next_conn++;
+
+  for(i = 0; i < rpc_pool.nb_conn; i++)
+    {
+      p_conn = &rpc_pool.conn[(start + i) % rpc_pool.nb_conn];
+
+      if(p_conn->sock < 0)
+        continue;
+
+      if(p_best == NULL || p_conn->nb_pending < p_best->nb_pending)
+        p_best = p_conn;
+    }
+
+  return p_best;
+}                               /* fsal_proxy_rpc_choose_conn */
+
+/**
+ * fsal_proxy_rpc_submit:
+ * Encodes a call and sends it on one of the pooled connections, without
+ * waiting for the reply. If RPC_SUCCESS is returned, the caller must
+ * collect the result with fsal_proxy_rpc_wait.
+ *
+ * \param p_call (output):
+ *        Completion object of the call, owned by the caller until
+ *        fsal_proxy_rpc_wait returns.
+ * \param auth (input):
+ *        Credentials to be sent with the call.
+ * \param proc (input):
+ *        NFSv4 procedure (NFSPROC4_NULL or NFSPROC4_COMPOUND).
+ * \param xdr_args, args (input):
+ *        Arguments of the call and their XDR encoding function.
+ * \param xdr_res, res (input):
+ *        Where the result will be decoded, and its XDR decoding function.
+ *
+ * \return RPC_SUCCESS if the call was sent, RPC_CANTSEND if no connection
+ *         is usable, RPC_CANTENCODEARGS if the arguments cannot be encoded.
+ */
+enum clnt_stat fsal_proxy_rpc_submit(fsal_proxy_rpc_call_t * p_call,
+                                     AUTH * auth,
+                                     u_int proc,
+                                     xdrproc_t xdr_args,
+                                     caddr_t args, xdrproc_t xdr_res, caddr_t res)
+{
+  fsal_proxy_rpc_conn_t *p_conn;
+  struct rpc_msg call_msg;
+  XDR xdrs;
+  char *buff;
+  unsigned int size;
+  unsigned int len;
+  unsigned int generation;
+  u_int32_t net_int;
+  int sock;
+  int rc;
+
+  /* encode the call, the xid is filled in once the connection is known */
+  size = xdr_sizeof(xdr_args, args) + FSAL_PROXY_RPC_HEADER_MAXLEN;
+  if((buff = (char *)Mem_Alloc(size)) == NULL)
+    return RPC_SYSTEMERROR;
+
+  memset(&call_msg, 0, sizeof(call_msg));
+  call_msg.rm_xid = 0;
+  call_msg.rm_direction = CALL;
+  call_msg.rm_call.cb_rpcvers = RPC_MSG_VERSION;
+  call_msg.rm_call.cb_prog = global_fsal_proxy_specific_info.srv_prognum;
+  call_msg.rm_call.cb_vers = FSAL_PROXY_NFS_V4;
+
+  xdrmem_create(&xdrs, buff + sizeof(net_int), size - sizeof(net_int), XDR_ENCODE);
+
+  if(!xdr_callhdr(&xdrs, &call_msg)
+     || !xdr_u_int(&xdrs, &proc) || !AUTH_MARSHALL(auth, &xdrs)
+     || !(*xdr_args) (&xdrs, args))
+    {
+      XDR_DESTROY(&xdrs);
+      Mem_Free(buff);
+      return RPC_CANTENCODEARGS;
+    }
+
+  len = XDR_GETPOS(&xdrs);
+  XDR_DESTROY(&xdrs);
+
+  net_int = htonl(FSAL_PROXY_RPC_LAST_FRAG | len);
+  memcpy(buff, &net_int, sizeof(net_int));
+  len += sizeof(net_int);
+
+  /* register the call before sending it, the reply may come back very fast */
+  if((p_conn = fsal_proxy_rpc_choose_conn()) == NULL)
+    {
+      Mem_Free(buff);
+      return RPC_CANTSEND;
+    }
+
+  P(p_conn->lock);
+
+  if(p_conn->sock < 0)
+    {
+      V(p_conn->lock);
+      Mem_Free(buff);
+      return RPC_CANTSEND;
+    }
+
+  p_call->xid = p_conn->next_xid++;
+  p_call->p_conn = p_conn;
+  p_call->state = FSAL_PROXY_RPC_CALL_PENDING;
+  p_call->status = RPC_SUCCESS;
+  p_call->auth = auth;
+  p_call->xdr_res = xdr_res;
+  p_call->res = res;
+  p_call->reply_buff = NULL;
+  p_call->reply_len = 0;
+  pthread_cond_init(&p_call->cond, NULL);
+
+  p_call->next = p_conn->pending[p_call->xid % FSAL_PROXY_RPC_XID_HASH];
+  p_conn->pending[p_call->xid % FSAL_PROXY_RPC_XID_HASH] = p_call;
+  p_conn->nb_pending += 1;
+  generation = p_conn->generation;
+
+  V(p_conn->lock);
+
+  net_int = htonl(p_call->xid);
+  memcpy(buff + sizeof(net_int), &net_int, sizeof(net_int));
+
+  /* the socket cannot be closed while send_lock is held */
+  P(p_conn->send_lock);
+
+  P(p_conn->lock);
+  sock = (p_conn->generation == generation) ? p_conn->sock : -1;
+  V(p_conn->lock);
+
+  rc = (sock >= 0) ? write_all(sock, buff, len) : -1;
+
+  /* let the receiver thread notice the broken connection */
+  if(rc != 0 && sock >= 0)
+    shutdown(sock, SHUT_RDWR);
+
+  V(p_conn->send_lock);
+
+  Mem_Free(buff);
+
+  if(rc != 0)
+    {
+      P(p_conn->lock);
+      fsal_proxy_rpc_unlink(p_conn, p_call);
+      V(p_conn->lock);
+
+      /* a reply may have raced with the failure */
+      if(p_call->reply_buff != NULL)
+        Mem_Free(p_call->reply_buff);
+      pthread_cond_destroy(&p_call->cond);
+
+      return RPC_CANTSEND;
+    }
+
+  return RPC_SUCCESS;
+}                               /* fsal_proxy_rpc_submit */
+
+/**
+ * fsal_proxy_rpc_wait:
+ * Waits for the reply of a call sent by fsal_proxy_rpc_submit and decodes it.
+ *
+ * \param p_call (input):
+ *        Completion object given to fsal_proxy_rpc_submit. Its auth field may be
+ *        reset to NULL after the submission when the AUTH does not live until the
+ *        reply (the verifier is then not checked).
+ * \param timeout (input):
+ *        How long to wait for the reply.
+ *
+ * \return the RPC status of the call.
+ */
+enum clnt_stat fsal_proxy_rpc_wait(fsal_proxy_rpc_call_t * p_call, struct timeval timeout)
+{
+  fsal_proxy_rpc_conn_t *p_conn = p_call->p_conn;
+  struct rpc_msg reply_msg;
+  struct timeval now;
+  struct timespec deadline;
+  enum clnt_stat status;
+  XDR xdrs;
+  int rc = 0;
+
+  gettimeofday(&now, NULL);
+  deadline.tv_sec = now.tv_sec + timeout.tv_sec;
+  deadline.tv_nsec = (now.tv_usec + timeout.tv_usec) * 1000;
+  if(deadline.tv_nsec >= 1000000000)
+    {
+      deadline.tv_sec += 1;
+      deadline.tv_nsec -= 1000000000;
+    }
+
+  P(p_conn->lock);
+
+  while(p_call->state == FSAL_PROXY_RPC_CALL_PENDING && rc != ETIMEDOUT)
+    rc = pthread_cond_timedwait(&p_call->cond, &p_conn->lock, &deadline);
+
+  if(p_call->state == FSAL_PROXY_RPC_CALL_PENDING)
+    {
+      /* a late reply will be dropped by the receiver */
+      fsal_proxy_rpc_unlink(p_conn, p_call);
+      p_call->state = FSAL_PROXY_RPC_CALL_FAILED;
+      p_call->status = RPC_TIMEDOUT;
+    }
+
+  V(p_conn->lock);
+
+  pthread_cond_destroy(&p_call->cond);
+
+  if(p_call->state == FSAL_PROXY_RPC_CALL_FAILED)
+    return p_call->status;
+
+  /* decode the reply, the results go directly to the caller's structure */
+  memset(&reply_msg, 0, sizeof(reply_msg));
+  reply_msg.acpted_rply.ar_verf = _null_auth;
+  reply_msg.acpted_rply.ar_results.where = p_call->res;
+  reply_msg.acpted_rply.ar_results.proc = p_call->xdr_res;
+
+  xdrmem_create(&xdrs, p_call->reply_buff, p_call->reply_len, XDR_DECODE);
+
+  if(!xdr_replymsg(&xdrs, &reply_msg))
+    status = RPC_CANTDECODERES;
+  else if(reply_msg.rm_reply.rp_stat != MSG_ACCEPTED)
+    status = (reply_msg.rjcted_rply.rj_stat == RPC_MISMATCH) ?
+        RPC_VERSMISMATCH : RPC_AUTHERROR;
+  else
+    {
+      switch (reply_msg.acpted_rply.ar_stat)
+        {
+        case SUCCESS:
+          status = (p_call->auth == NULL
+                    || AUTH_VALIDATE(p_call->auth, &reply_msg.acpted_rply.ar_verf)) ?
+              RPC_SUCCESS : RPC_AUTHERROR;
+          break;
+        case PROG_UNAVAIL:
+          status = RPC_PROGUNAVAIL;
+          break;
+        case PROG_MISMATCH:
+          status = RPC_PROGVERSMISMATCH;
+          break;
+        case PROC_UNAVAIL:
+          status = RPC_PROCUNAVAIL;
+          break;
+        case GARBAGE_ARGS:
+          status = RPC_CANTDECODEARGS;
+          break;
+        default:
+          status = RPC_SYSTEMERROR;
+          break;
+        }
+
+      if(reply_msg.acpted_rply.ar_verf.oa_base != NULL)
+        {
+          xdrs.x_op = XDR_FREE;
+          xdr_opaque_auth(&xdrs, &reply_msg.acpted_rply.ar_verf);
+        }
+    }
+
+  XDR_DESTROY(&xdrs);
+  Mem_Free(p_call->reply_buff);
+  p_call->reply_buff = NULL;
+
+  return status;
+}                               /* fsal_proxy_rpc_wait */
+
+/**
+ * fsal_proxy_rpc_abandon:
+ * Forgets a call sent by fsal_proxy_rpc_submit whose reply is no longer needed,
+ * instead of waiting for it. A reply that comes later is dropped by the receiver.
+ *
+ * \param p_call (input):
+ *        Completion object given to fsal_proxy_rpc_submit.
+ */
+void fsal_proxy_rpc_abandon(fsal_proxy_rpc_call_t * p_call)
+{
+  fsal_proxy_rpc_conn_t *p_conn = p_call->p_conn;
+
+  P(p_conn->lock);
+
+  if(p_call->state == FSAL_PROXY_RPC_CALL_PENDING)
+    fsal_proxy_rpc_unlink(p_conn, p_call);
+
+  V(p_conn->lock);
+
+  if(p_call->reply_buff != NULL)
+    {
+      Mem_Free(p_call->reply_buff);
+      p_call->reply_buff = NULL;
+    }
+  pthread_cond_destroy(&p_call->cond);
+}                               /* fsal_proxy_rpc_abandon */
+
+/**
+ * fsal_proxy_rpc_call:
+ * Synchronous call through the pipelined client: the calling thread only
+ * blocks on its own reply, other threads keep using the same connections.
+ *
+ * \return the RPC status of the call (see fsal_proxy_rpc_submit/fsal_proxy_rpc_wait).
+ */
+enum clnt_stat fsal_proxy_rpc_call(AUTH * auth,
+                                   u_int proc,
+                                   xdrproc_t xdr_args,
+                                   caddr_t args,
+                                   xdrproc_t xdr_res, caddr_t res, struct timeval timeout)
+{
+  fsal_proxy_rpc_call_t call;
+  enum clnt_stat status;
+
+  if(fsal_proxy_rpc_wait_connected(timeout))
+    return RPC_CANTSEND;
+
+  if((status = fsal_proxy_rpc_submit(&call, auth, proc, xdr_args, args,
+                                     xdr_res, res)) != RPC_SUCCESS)
+    return status;
+
+  return fsal_proxy_rpc_wait(&call, timeout);
+}                               /* fsal_proxy_rpc_call */
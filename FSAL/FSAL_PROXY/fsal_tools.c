@@ -508,6 +508,9 @@ fsal_status_t PROXYFSAL_SetDefault_FS_specific_parameter(fsal_parameter_t * out_
   out_parameter->fs_specific_info.srv_sendsize = FSAL_PROXY_SEND_BUFFER_SIZE;   /* Default Buffer Send Size    */
   out_parameter->fs_specific_info.srv_recvsize = FSAL_PROXY_RECV_BUFFER_SIZE;   /* Default Buffer Send Size    */
   out_parameter->fs_specific_info.use_privileged_client_port = FALSE;   /* No privileged port by default */
+  out_parameter->fs_specific_info.srv_nb_conn = FSAL_PROXY_NB_CONNECTIONS;       /* Shared upstream connections */
+  out_parameter->fs_specific_info.io_chunk_size = FSAL_PROXY_IO_CHUNK_SIZE;     /* Size of a READ/WRITE compound */
+  out_parameter->fs_specific_info.io_window = FSAL_PROXY_IO_WINDOW;     /* Compounds in flight per file */
 
   out_parameter->fs_specific_info.active_krb5 = FALSE;  /* No RPCSEC_GSS by default */
   strncpy(out_parameter->fs_specific_info.local_principal, "(no principal set)", MAXNAMLEN);    /* Principal is nfs@<host>  */
@@ -962,6 +965,47 @@ fsal_status_t PROXYFSAL_load_FS_specific_parameter_from_conf(config_file_t in_co
         {
           out_parameter->fs_specific_info.retry_sleeptime = (unsigned int)atoi(key_value);
         }
+      else if(!STRCMP(key_name, "NFS_Connections"))
+        {
+          /* 0 gives each thread its own rpc client, as with UDP or krb5 */
+          int nb_conn = s_read_int(key_value);
+
+          if(nb_conn < 0)
+            {
+              LogCrit(COMPONENT_CONFIG,
+                      "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: null or positive integer expected.",
+                      key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.srv_nb_conn = (unsigned int)nb_conn;
+        }
+      else if(!STRCMP(key_name, "IO_Chunk_Size"))
+        {
+          int chunk_size = s_read_int(key_value);
+
+          if(chunk_size <= 0)
+            {
+              LogCrit(COMPONENT_CONFIG,
+                      "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: positive integer expected.",
+                      key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.io_chunk_size = (unsigned int)chunk_size;
+        }
+      else if(!STRCMP(key_name, "IO_Window"))
+        {
+          /* 0 sends each read or write as a single compound */
+          int window = s_read_int(key_value);
+
+          if(window < 0)
+            {
+              LogCrit(COMPONENT_CONFIG,
+                      "FSAL LOAD PARAMETER: ERROR: Unexpected value for %s: null or positive integer expected.",
+                      key_name);
+              ReturnCode(ERR_FSAL_INVAL, 0);
+            }
+          out_parameter->fs_specific_info.io_window = (unsigned int)window;
+        }
 #ifdef _ALLOW_NFS_PROTO_CHOICE
       else if(!STRCMP(key_name, "NFS_Proto"))
         {
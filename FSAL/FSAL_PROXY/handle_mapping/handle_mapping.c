@@ -215,7 +215,7 @@ int handle_mapping_hash_add(hash_table_t * p_hash,
   buffval.pdata = (caddr_t) handle;
   buffval.len = sizeof(handle_pool_entry_t);
 
-  rc = HashTable_Test_And_Set(handle_map_hash, &buffkey, &buffval,
+  rc = HashTable_Test_And_Set(p_hash, &buffkey, &buffval,
                               HASHTABLE_SET_HOW_SET_NO_OVERWRITE);
 
   if(rc != HASHTABLE_SUCCESS)
@@ -238,6 +238,40 @@ int handle_mapping_hash_add(hash_table_t * p_hash,
   return HANDLEMAP_SUCCESS;
 }
 
+int handle_mapping_hash_del(hash_table_t * p_hash,
+                            uint64_t object_id, unsigned int handle_hash)
+{
+  int rc;
+  hash_buffer_t buffkey, stored_buffkey;
+  hash_buffer_t stored_buffval;
+
+  digest_pool_entry_t digest;
+
+  digest_pool_entry_t *p_stored_digest;
+  handle_pool_entry_t *p_stored_handle;
+
+  digest.nfs23_digest.object_id = object_id;
+  digest.nfs23_digest.handle_hash = handle_hash;
+
+  buffkey.pdata = (caddr_t) & digest;
+  buffkey.len = sizeof(digest_pool_entry_t);
+
+  rc = HashTable_Del(p_hash, &buffkey, &stored_buffkey, &stored_buffval);
+
+  if(rc != HASHTABLE_SUCCESS)
+    {
+      return HANDLEMAP_STALE;
+    }
+
+  p_stored_digest = (digest_pool_entry_t *) stored_buffkey.pdata;
+  p_stored_handle = (handle_pool_entry_t *) stored_buffval.pdata;
+
+  digest_free(p_stored_digest);
+  handle_free(p_stored_handle);
+
+  return HANDLEMAP_SUCCESS;
+}
+
 /**
  * Init handle mapping module.
  * Reloads the content of the mapping files it they exist,
@@ -307,6 +341,16 @@ int HandleMap_Init(const handle_map_param_t * p_param)
       return rc;
     }
 
+  /* convert the databases of older versions */
+
+  rc = handlemap_db_import_all(handle_map_hash);
+
+  if(rc)
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR %d importing older handle mapping databases", rc);
+      return rc;
+    }
+
   return HANDLEMAP_SUCCESS;
 }
 
@@ -381,33 +425,14 @@ int HandleMap_SetFH(nfs23_map_handle_t * p_in_nfs23_digest, fsal_handle_t * p_in
 int HandleMap_DelFH(nfs23_map_handle_t * p_in_nfs23_digest)
 {
   int rc;
-  hash_buffer_t buffkey, stored_buffkey;
-  hash_buffer_t stored_buffval;
-
-  digest_pool_entry_t digest;
-
-  digest_pool_entry_t *p_stored_digest;
-  handle_pool_entry_t *p_stored_handle;
 
   /* first, delete it from hash table */
 
-  digest.nfs23_digest = *p_in_nfs23_digest;
+  rc = handle_mapping_hash_del(handle_map_hash, p_in_nfs23_digest->object_id,
+                               p_in_nfs23_digest->handle_hash);
 
-  buffkey.pdata = (caddr_t) & digest;
-  buffkey.len = sizeof(digest_pool_entry_t);
-
-  rc = HashTable_Del(handle_map_hash, &buffkey, &stored_buffkey, &stored_buffval);
-
-  if(rc != HASHTABLE_SUCCESS)
-    {
-      return HANDLEMAP_STALE;
-    }
-
-  p_stored_digest = (digest_pool_entry_t *) stored_buffkey.pdata;
-  p_stored_handle = (handle_pool_entry_t *) stored_buffval.pdata;
-
-  digest_free(p_stored_digest);
-  handle_free(p_stored_handle);
+  if(rc != HANDLEMAP_SUCCESS)
+    return rc;
 
   /* then, submit the request to the database */
 
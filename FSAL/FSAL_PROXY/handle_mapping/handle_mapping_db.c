@@ -1,128 +1,81 @@
+/**
+ * \file handle_mapping_db.c
+ *
+ * \brief  Persistent storage of the handle map.
+ *
+ * The map is partitioned into several databases, each of them managed
+ * by a dedicated thread. A database is made of:
+ *  - an append-only log of checksummed insert/delete records.
+ *    The records submitted while the thread is writing are gathered
+ *    and written by a single write+fdatasync (group commit);
+ *  - a snapshot of the live entries, sorted by digest.
+ *    When the log grows larger than the snapshot, it is renamed
+ *    with OLD_FILE_SUFFIX, a new log is started, and the compaction
+ *    thread merges the old log into a new snapshot (written as
+ *    TMP_FILE_SUFFIX then renamed).
+ *
+ * At startup, all threads reload their database in parallel:
+ * snapshot, old log (if a compaction was interrupted), then log.
+ * Loading stops at the first truncated or corrupted record,
+ * and the log is truncated after its last valid record.
+ */
 #include "config.h"
 #include "handle_mapping.h"
 #include "handle_mapping_db.h"
 #include "handle_mapping_internal.h"
 #include "../fsal_internal.h"
 #include "stuff_alloc.h"
-#include <sqlite3.h>
+#include <stddef.h>
 #include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
 #include <dirent.h>
-#include <fnmatch.h>
 #include <pthread.h>
 
-/* sqlite check macros */
-
-#define CheckTable( _p_conn_, _code_, _msg_str_, _result_ ) do { \
- if ( (_code_) != SQLITE_OK ) \
-    {                                                                             \
-        LogCrit(COMPONENT_FSAL, "SQLite command failed in %s line %i", __FUNCTION__, __LINE__); \
-        LogCrit(COMPONENT_FSAL, "%s (%d)", (_msg_str_?_msg_str_:sqlite3_errmsg(_p_conn_)), _code_ ); \
-        if (_msg_str_) { sqlite3_free( _msg_str_); _msg_str_ = NULL; }     \
-        if (_result_) { sqlite3_free_table( _result_ ); _result_ = NULL; } \
-        return HANDLEMAP_DB_ERROR;  \
-    } \
-  } while (0)
-
-#define CheckCommand( _p_conn_, _code_, _msg_str_ ) do { \
-  if ( (_code_) != SQLITE_OK ) \
-    {                                                                             \
-        LogCrit(COMPONENT_FSAL, "SQLite command failed in %s line %i", __FUNCTION__, __LINE__); \
-        LogCrit(COMPONENT_FSAL, "%s (%d)", (_msg_str_?_msg_str_:sqlite3_errmsg(_p_conn_)), _code_ ); \
-        if (_msg_str_) {sqlite3_free( _msg_str_); _msg_str_ = NULL ; } \
-        return HANDLEMAP_DB_ERROR;  \
-    } \
-  } while (0)
-
-#define CheckPrepare( _p_conn_, _code_ ) do { \
-  if ( (_code_) != SQLITE_OK)                        \
-    {                                                                             \
-        LogCrit(COMPONENT_FSAL, "SQLite prepare statement failed in %s line %i", __FUNCTION__, __LINE__); \
-        LogCrit(COMPONENT_FSAL, "%s (%d)", sqlite3_errmsg( _p_conn_ ), _code_ ); \
-        return HANDLEMAP_DB_ERROR;  \
-    } \
-  } while (0)
-
-#define CheckBind( _p_conn_, _code_, _stmt_ ) do { \
-  if ( (_code_) != SQLITE_OK)                                                        \
-    {                                                                                \
-        LogCrit(COMPONENT_FSAL, "SQLite parameter binding failed in %s line %i", __FUNCTION__, __LINE__); \
-        LogCrit(COMPONENT_FSAL, "%s (%d)", sqlite3_errmsg( _p_conn_ ), _code_ ); \
-        sqlite3_clear_bindings( _stmt_ ); \
-        return HANDLEMAP_DB_ERROR;  \
-    }  \
-  } while (0)
-
-#define CheckStep( _p_conn_, _code_, _stmt_ ) do { \
-  if ( (_code_) != SQLITE_OK  && (_code_) != SQLITE_ROW && (_code_) != SQLITE_DONE ) \
-    {                                                                                \
-        LogCrit(COMPONENT_FSAL, "SQLite command failed in %s line %i", __FUNCTION__, __LINE__); \
-        LogCrit(COMPONENT_FSAL, "%s (%d)", sqlite3_errmsg( _p_conn_ ), _code_ ); \
-        sqlite3_reset( _stmt_ );    \
-        return HANDLEMAP_DB_ERROR;  \
-    }  \
-  } while (0)
-
-/* Type of DB operations */
-typedef enum
-{
-  LOAD = 1,
-  INSERT,
-  DELETE
-} db_op_type;
-
-/* DB operation arguments */
-typedef struct db_op_item__
-{
-  db_op_type op_type;
-
-  /* operation info */
-
-  union
-  {
-    struct
-    {
-      nfs23_map_handle_t nfs23_digest;
-      fsal_handle_t fsal_handle;
-    } fh_info;
-
-    hash_table_t *hash;
-  } op_arg;
-
-  /* for chained list */
-  struct db_op_item__ *p_next;
-
-} db_op_item_t;
-
-/* the queue for each DB flusher thread */
-typedef struct flusher_queue__
-{
-  /* the queue for high priority operations */
-  db_op_item_t *highprio_first;
-  db_op_item_t *highprio_last;
-
-  /* the queue for low priority operations */
-  db_op_item_t *lowprio_first;
-  db_op_item_t *lowprio_last;
+/* file headers */
 
-  /* number of operations pending */
-  unsigned int nb_waiting;
+#define LOG_MAGIC   "HMAPLOG1"
+#define SNAP_MAGIC  "HMAPSNP1"
+#define MAGIC_LEN   8
 
-  pthread_mutex_t queues_mutex;
+typedef struct db_file_header__
+{
+  char magic[MAGIC_LEN];
 
-  pthread_cond_t work_avail_condition;
-  pthread_cond_t work_done_condition;
+  /* size of the FSAL handles stored in the file */
+  uint32_t handle_size;
+
+  /* crc of the previous fields */
+  uint32_t crc;
+
+} db_file_header_t;
 
-  /* status (used for work_done_condition) */
-  enum
-  { NOT_READY, IDLE, WORKING, FINISHED } status;
+/* Type of DB records */
+#define RECORD_INSERT 1
+#define RECORD_DELETE 2
 
-} flusher_queue_t;
+/* DB record header, followed by handle_len bytes of FSAL handle */
+typedef struct db_record__
+{
+  /* crc of the end of the record (from op_type to the end of the handle) */
+  uint32_t crc;
+
+  uint32_t op_type;
+
+  uint64_t object_id;
+  uint32_t handle_hash;
+
+  /* sizeof(fsal_handle_t) for an insert, 0 for a delete */
+  uint32_t handle_len;
 
-#define LOAD_ALL_STATEMENT  0
-#define INSERT_STATEMENT    1
-#define DELETE_STATEMENT    2
+} db_record_t;
 
-#define STATEMENT_COUNT     3
+#define INSERT_RECORD_SIZE  (sizeof(db_record_t) + sizeof(fsal_handle_t))
+#define DELETE_RECORD_SIZE  (sizeof(db_record_t))
+
+/* size of the buffers used for loading and compacting databases */
+#define DB_IO_BUFF_SIZE     (1024*1024)
 
 /* thread info */
 typedef struct db_thread_info__
@@ -130,178 +83,816 @@ typedef struct db_thread_info__
   pthread_t thr_id;
   unsigned int thr_index;
 
-  flusher_queue_t work_queue;
+  pthread_mutex_t queues_mutex;
 
-  /* SQLite database connection */
-  sqlite3 *db_conn;
+  pthread_cond_t work_avail_condition;
+  pthread_cond_t work_done_condition;
 
-  /* prepared statement table */
-  sqlite3_stmt *prep_stmt[STATEMENT_COUNT];
+  /* records waiting for the next group commit */
+  char *pending_buff;
+  size_t pending_len;
 
-  /* this pool is accessed by submitter
-   * and by the db thread */
-  pthread_mutex_t pool_mutex;
-  db_op_item_t *dbop_pool;
+  /* number of operations pending */
+  unsigned int nb_waiting;
+
+  /* records being written by the thread */
+  char *commit_buff;
+
+  /* sequence numbers of the last submitted and synced records */
+  uint64_t last_submitted;
+  uint64_t last_committed;
+
+  /* reload request */
+  int load_requested;
+  hash_table_t *load_hash;
+  int loaded;
+
+  /* log file (only accessed by the db thread) */
+  int log_fd;
+  off_t log_size;
+
+  /* compaction state */
+  off_t snap_size;
+  int old_log;                  /* a renamed log must be merged into the snapshot */
+  int compacting;               /* a compaction is running (or has failed) */
+
+  /* statistics */
+  unsigned int nb_commits;
+  unsigned long long nb_records;
 
 } db_thread_info_t;
 
+/* buffered reader for db files */
+typedef struct db_reader__
+{
+  int fd;
+  char *buff;
+  size_t start;
+  size_t end;
+
+  /* file offset of the first unread byte */
+  off_t offset;
+
+  int eof;
+
+} db_reader_t;
+
+/* buffered writer for snapshots */
+typedef struct db_writer__
+{
+  int fd;
+  char *buff;
+  size_t len;
+
+  off_t size;
+
+} db_writer_t;
+
+/* a record of an old log, while it is merged */
+typedef struct compact_entry__
+{
+  uint64_t object_id;
+  unsigned int handle_hash;
+  unsigned int op_type;
+
+  /* position of the record in the log (and of its handle) */
+  unsigned int index;
+
+} compact_entry_t;
+
 static char dbmap_dir[MAXPATHLEN];
 static char db_tmpdir[MAXPATHLEN];
 static unsigned int nb_db_threads;
 static unsigned int nb_prealloc;
 static int synchronous;
 
-/* used for clean shutdown */
-static int do_terminate = FALSE;
+/* size of a group commit buffer */
+static size_t commit_buff_size;
 
 /* all information and context for threads */
 static db_thread_info_t db_thread[MAX_DB];
 
+/* compaction thread and its requests (a bit per db) */
+static pthread_t compact_thr_id;
+static pthread_mutex_t compact_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t compact_condition = PTHREAD_COND_INITIALIZER;
+static unsigned int compact_requests = 0;
+
+/* crc32 (IEEE 802.3) */
+
+static uint32_t crc_table[256];
+
+static void init_crc_table()
+{
+  uint32_t c;
+  unsigned int i, k;
+
+  for(i = 0; i < 256; i++)
+    {
+      c = i;
+      for(k = 0; k < 8; k++)
+        c = (c & 1) ? (0xEDB88320 ^ (c >> 1)) : (c >> 1);
+      crc_table[i] = c;
+    }
+}
+
+static uint32_t db_crc(const char *buff, size_t len)
+{
+  uint32_t c = 0xFFFFFFFF;
+  size_t i;
+
+  for(i = 0; i < len; i++)
+    c = crc_table[(c ^ (unsigned char)buff[i]) & 0xFF] ^ (c >> 8);
+
+  return c ^ 0xFFFFFFFF;
+}
+
+/* db file paths */
+
+static void db_file_path(char *path, const char *prefix, unsigned int index,
+                         const char *suffix)
+{
+  /* the length of dbmap_dir is checked by handlemap_db_init:
+   * an empty path only makes the following file operation fail */
+  if(snprintf(path, MAXPATHLEN, "%s/%s.%u%s", dbmap_dir, prefix, index, suffix)
+     >= MAXPATHLEN)
+    path[0] = '\0';
+}
+
+/* make the creation/renaming of db files persistent */
+static void sync_db_dir()
+{
+  int fd;
+
+  fd = open(dbmap_dir, O_RDONLY);
+
+  if(fd >= 0)
+    {
+      fsync(fd);
+      close(fd);
+    }
+}
+
+static int write_full(int fd, const char *buff, size_t len)
+{
+  ssize_t rc;
+
+  while(len > 0)
+    {
+      rc = write(fd, buff, len);
+
+      if(rc < 0)
+        {
+          if(errno == EINTR)
+            continue;
+          return -1;
+        }
+
+      buff += rc;
+      len -= rc;
+    }
+
+  return 0;
+}
+
+static void fill_file_header(db_file_header_t * p_hdr, const char *magic)
+{
+  memset(p_hdr, 0, sizeof(db_file_header_t));
+  memcpy(p_hdr->magic, magic, MAGIC_LEN);
+  p_hdr->handle_size = sizeof(fsal_handle_t);
+  p_hdr->crc = db_crc((char *)p_hdr, offsetof(db_file_header_t, crc));
+}
+
+static int check_file_header(db_file_header_t * p_hdr, const char *magic,
+                             const char *path)
+{
+  if(memcmp(p_hdr->magic, magic, MAGIC_LEN)
+     || p_hdr->crc != db_crc((char *)p_hdr, offsetof(db_file_header_t, crc)))
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: %s is not a valid handle map file", path);
+      return HANDLEMAP_DB_ERROR;
+    }
+
+  if(p_hdr->handle_size != sizeof(fsal_handle_t))
+    {
+      LogCrit(COMPONENT_FSAL,
+              "ERROR: %s contains handles of size %u (expected %u)",
+              path, p_hdr->handle_size, (unsigned int)sizeof(fsal_handle_t));
+      return HANDLEMAP_DB_ERROR;
+    }
+
+  return HANDLEMAP_SUCCESS;
+}
+
+/* build a record into buff and return its size */
+static size_t encode_record(char *buff, unsigned int op_type,
+                            nfs23_map_handle_t * p_nfs23_digest,
+                            fsal_handle_t * p_handle)
+{
+  db_record_t rec;
+  size_t size;
+
+  memset(&rec, 0, sizeof(db_record_t));
+
+  rec.op_type = op_type;
+  rec.object_id = p_nfs23_digest->object_id;
+  rec.handle_hash = p_nfs23_digest->handle_hash;
+  rec.handle_len = (op_type == RECORD_INSERT ? sizeof(fsal_handle_t) : 0);
+
+  size = sizeof(db_record_t) + rec.handle_len;
+
+  memcpy(buff, &rec, sizeof(db_record_t));
+  if(rec.handle_len)
+    memcpy(buff + sizeof(db_record_t), p_handle, sizeof(fsal_handle_t));
+
+  rec.crc = db_crc(buff + sizeof(uint32_t), size - sizeof(uint32_t));
+  memcpy(buff, &rec.crc, sizeof(uint32_t));
+
+  return size;
+}
+
+/**
+ * Open a db file for reading and check its header.
+ * A missing (or empty) file is read as an empty one (fd = -1).
+ */
+static int db_reader_open(db_reader_t * p_reader, const char *path, const char *magic)
+{
+  db_file_header_t hdr;
+  ssize_t rc;
+
+  memset(p_reader, 0, sizeof(db_reader_t));
+  p_reader->eof = TRUE;
+
+  p_reader->fd = open(path, O_RDONLY);
+
+  if(p_reader->fd < 0)
+    {
+      if(errno == ENOENT)
+        return HANDLEMAP_SUCCESS;
+
+      LogCrit(COMPONENT_FSAL, "ERROR: could not open %s: %s", path, strerror(errno));
+      return HANDLEMAP_SYSTEM_ERROR;
+    }
+
+  rc = read(p_reader->fd, &hdr, sizeof(db_file_header_t));
+
+  if(rc < (ssize_t) sizeof(db_file_header_t))
+    {
+      /* file creation was interrupted */
+      close(p_reader->fd);
+      p_reader->fd = -1;
+      return HANDLEMAP_SUCCESS;
+    }
+
+  if(check_file_header(&hdr, magic, path))
+    {
+      close(p_reader->fd);
+      p_reader->fd = -1;
+      return HANDLEMAP_DB_ERROR;
+    }
+
+  p_reader->buff = (char *)Mem_Alloc(DB_IO_BUFF_SIZE);
+
+  if(p_reader->buff == NULL)
+    {
+      close(p_reader->fd);
+      p_reader->fd = -1;
+      return HANDLEMAP_SYSTEM_ERROR;
+    }
+
+  p_reader->offset = sizeof(db_file_header_t);
+  p_reader->eof = FALSE;
+
+  return HANDLEMAP_SUCCESS;
+}
+
+static void db_reader_close(db_reader_t * p_reader)
+{
+  if(p_reader->fd >= 0)
+    close(p_reader->fd);
+
+  if(p_reader->buff)
+    Mem_Free(p_reader->buff);
+
+  p_reader->fd = -1;
+  p_reader->buff = NULL;
+}
+
+/* try to have 'needed' bytes in the buffer, return the available size */
+static size_t db_reader_fill(db_reader_t * p_reader, size_t needed)
+{
+  ssize_t rc;
+
+  if(p_reader->end - p_reader->start >= needed || p_reader->eof)
+    return p_reader->end - p_reader->start;
+
+  memmove(p_reader->buff, p_reader->buff + p_reader->start,
+          p_reader->end - p_reader->start);
+  p_reader->end -= p_reader->start;
+  p_reader->start = 0;
+
+  while(!p_reader->eof && p_reader->end < needed)
+    {
+      rc = read(p_reader->fd, p_reader->buff + p_reader->end,
+                DB_IO_BUFF_SIZE - p_reader->end);
+
+      if(rc < 0 && errno == EINTR)
+        continue;
+
+      if(rc <= 0)
+        {
+          if(rc < 0)
+            LogCrit(COMPONENT_FSAL, "ERROR reading handle map file: %s",
+                    strerror(errno));
+          p_reader->eof = TRUE;
+        }
+      else
+        p_reader->end += rc;
+    }
+
+  return p_reader->end;
+}
+
+/**
+ * Read the next record.
+ * \return TRUE if a record was read, FALSE at the end of valid data.
+ */
+static int db_reader_next(db_reader_t * p_reader, db_record_t * p_rec,
+                          fsal_handle_t * p_handle)
+{
+  size_t size;
+  char *rec_start;
+
+  if(p_reader->fd < 0)
+    return FALSE;
+
+  if(db_reader_fill(p_reader, sizeof(db_record_t)) < sizeof(db_record_t))
+    return FALSE;
+
+  memcpy(p_rec, p_reader->buff + p_reader->start, sizeof(db_record_t));
+
+  if(!((p_rec->op_type == RECORD_INSERT && p_rec->handle_len == sizeof(fsal_handle_t))
+       || (p_rec->op_type == RECORD_DELETE && p_rec->handle_len == 0)))
+    return FALSE;
+
+  size = sizeof(db_record_t) + p_rec->handle_len;
+
+  if(db_reader_fill(p_reader, size) < size)
+    return FALSE;
+
+  rec_start = p_reader->buff + p_reader->start;
+
+  if(p_rec->crc != db_crc(rec_start + sizeof(uint32_t), size - sizeof(uint32_t)))
+    return FALSE;
+
+  if(p_rec->handle_len)
+    memcpy(p_handle, rec_start + sizeof(db_record_t), sizeof(fsal_handle_t));
+
+  p_reader->start += size;
+  p_reader->offset += size;
+
+  return TRUE;
+}
+
+/* after db_reader_next returned FALSE: was the whole file valid ? */
+static int db_reader_complete(db_reader_t * p_reader)
+{
+  return (p_reader->fd < 0 || (p_reader->eof && p_reader->start == p_reader->end));
+}
+
+static int db_writer_open(db_writer_t * p_writer, const char *path, const char *magic)
+{
+  db_file_header_t hdr;
+
+  memset(p_writer, 0, sizeof(db_writer_t));
+
+  p_writer->fd = open(path, O_WRONLY | O_CREAT | O_TRUNC, 0644);
+
+  if(p_writer->fd < 0)
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: could not create %s: %s", path, strerror(errno));
+      return HANDLEMAP_SYSTEM_ERROR;
+    }
+
+  p_writer->buff = (char *)Mem_Alloc(DB_IO_BUFF_SIZE);
+
+  if(p_writer->buff == NULL)
+    {
+      close(p_writer->fd);
+      return HANDLEMAP_SYSTEM_ERROR;
+    }
+
+  fill_file_header(&hdr, magic);
+  memcpy(p_writer->buff, &hdr, sizeof(db_file_header_t));
+  p_writer->len = sizeof(db_file_header_t);
+
+  return HANDLEMAP_SUCCESS;
+}
+
+static int db_writer_flush(db_writer_t * p_writer)
+{
+  if(write_full(p_writer->fd, p_writer->buff, p_writer->len))
+    return HANDLEMAP_SYSTEM_ERROR;
+
+  p_writer->size += p_writer->len;
+  p_writer->len = 0;
+
+  return HANDLEMAP_SUCCESS;
+}
+
+static int db_writer_append(db_writer_t * p_writer, db_record_t * p_rec,
+                            fsal_handle_t * p_handle)
+{
+  nfs23_map_handle_t digest;
+
+  if(p_writer->len + INSERT_RECORD_SIZE > DB_IO_BUFF_SIZE)
+    if(db_writer_flush(p_writer))
+      return HANDLEMAP_SYSTEM_ERROR;
+
+  digest.object_id = p_rec->object_id;
+  digest.handle_hash = p_rec->handle_hash;
+
+  p_writer->len += encode_record(p_writer->buff + p_writer->len, p_rec->op_type,
+                                 &digest, p_handle);
+
+  return HANDLEMAP_SUCCESS;
+}
+
+/* write the end of the file and sync it */
+static int db_writer_close(db_writer_t * p_writer)
+{
+  int rc;
+
+  rc = db_writer_flush(p_writer);
+
+  if(rc == HANDLEMAP_SUCCESS && fsync(p_writer->fd))
+    rc = HANDLEMAP_SYSTEM_ERROR;
+
+  close(p_writer->fd);
+  Mem_Free(p_writer->buff);
+
+  return rc;
+}
+
+/**
+ * Open the log of a database for appending.
+ * It is created if it did not exist.
+ */
+static int open_log_file(db_thread_info_t * p_info)
+{
+  char log_file[MAXPATHLEN];
+  db_file_header_t hdr;
+  struct stat st;
+
+  db_file_path(log_file, DB_FILE_PREFIX, p_info->thr_index, "");
+
+  p_info->log_fd = open(log_file, O_RDWR | O_CREAT | O_APPEND, 0644);
+
+  if(p_info->log_fd < 0 || fstat(p_info->log_fd, &st))
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: could not open handle map log %s: %s",
+              log_file, strerror(errno));
+      return HANDLEMAP_DB_ERROR;
+    }
+
+  if(st.st_size < sizeof(db_file_header_t))
+    {
+      /* new log */
+      fill_file_header(&hdr, LOG_MAGIC);
+
+      if(ftruncate(p_info->log_fd, 0)
+         || write_full(p_info->log_fd, (char *)&hdr, sizeof(db_file_header_t))
+         || fdatasync(p_info->log_fd))
+        {
+          LogCrit(COMPONENT_FSAL, "ERROR: could not initialize handle map log %s: %s",
+                  log_file, strerror(errno));
+          close(p_info->log_fd);
+          return HANDLEMAP_DB_ERROR;
+        }
+
+      p_info->log_size = sizeof(db_file_header_t);
+    }
+  else
+    {
+      if(pread(p_info->log_fd, &hdr, sizeof(db_file_header_t), 0) !=
+         sizeof(db_file_header_t) || check_file_header(&hdr, LOG_MAGIC, log_file))
+        {
+          close(p_info->log_fd);
+          return HANDLEMAP_DB_ERROR;
+        }
+
+      p_info->log_size = st.st_size;
+    }
+
+  return HANDLEMAP_SUCCESS;
+}
+
 /* Initialize basic structures for a thread */
 static int init_db_thread_info(db_thread_info_t * p_thr_info)
 {
-  unsigned int i;
-
   if(!p_thr_info)
     return HANDLEMAP_INTERNAL_ERROR;
 
   memset(p_thr_info, 0, sizeof(db_thread_info_t));
 
-  p_thr_info->work_queue.highprio_first = NULL;
-  p_thr_info->work_queue.highprio_last = NULL;
-  p_thr_info->work_queue.lowprio_first = NULL;
-  p_thr_info->work_queue.lowprio_last = NULL;
-
-  p_thr_info->work_queue.nb_waiting = 0;
+  if(pthread_mutex_init(&p_thr_info->queues_mutex, NULL))
+    return HANDLEMAP_SYSTEM_ERROR;
 
-  if(pthread_mutex_init(&p_thr_info->work_queue.queues_mutex, NULL))
+  if(pthread_cond_init(&p_thr_info->work_avail_condition, NULL))
     return HANDLEMAP_SYSTEM_ERROR;
 
-  if(pthread_cond_init(&p_thr_info->work_queue.work_avail_condition, NULL))
+  if(pthread_cond_init(&p_thr_info->work_done_condition, NULL))
     return HANDLEMAP_SYSTEM_ERROR;
 
-  if(pthread_cond_init(&p_thr_info->work_queue.work_done_condition, NULL))
+  /* group commit buffers */
+
+  p_thr_info->pending_buff = (char *)Mem_Alloc(commit_buff_size);
+  p_thr_info->commit_buff = (char *)Mem_Alloc(commit_buff_size);
+
+  if(!p_thr_info->pending_buff || !p_thr_info->commit_buff)
     return HANDLEMAP_SYSTEM_ERROR;
 
-  /* init thread status */
-  p_thr_info->work_queue.status = NOT_READY;
+  p_thr_info->log_fd = -1;
+
+  return HANDLEMAP_SUCCESS;
+}
+
+/* insert or remove a record to/from the hash table */
+static void apply_record(hash_table_t * p_hash, db_record_t * p_rec,
+                         fsal_handle_t * p_handle)
+{
+  int rc;
+
+  if(p_hash == NULL)
+    return;
+
+  if(p_rec->op_type == RECORD_INSERT)
+    {
+      rc = handle_mapping_hash_add(p_hash, p_rec->object_id, p_rec->handle_hash,
+                                   p_handle);
+
+      if(rc == HANDLEMAP_EXISTS)
+        {
+          /* the last record for a digest wins */
+          handle_mapping_hash_del(p_hash, p_rec->object_id, p_rec->handle_hash);
+          rc = handle_mapping_hash_add(p_hash, p_rec->object_id, p_rec->handle_hash,
+                                       p_handle);
+        }
+
+      if(rc)
+        LogCrit(COMPONENT_FSAL,
+                "ERROR %d adding entry to hash table <object_id=%llu, FH_hash=%u>",
+                rc, (unsigned long long)p_rec->object_id, p_rec->handle_hash);
+    }
+  else
+    handle_mapping_hash_del(p_hash, p_rec->object_id, p_rec->handle_hash);
+}
+
+/**
+ * Replay the records of a db file to the hash table.
+ * *p_valid_end is set to the offset after the last valid record.
+ */
+static int load_db_file(const char *path, const char *magic, hash_table_t * p_hash,
+                        unsigned int *p_count, off_t * p_valid_end)
+{
+  db_reader_t reader;
+  db_record_t rec;
+  fsal_handle_t handle;
+  int rc;
+
+  rc = db_reader_open(&reader, path, magic);
+
+  if(rc)
+    return rc;
+
+  while(db_reader_next(&reader, &rec, &handle))
+    {
+      apply_record(p_hash, &rec, &handle);
+      (*p_count)++;
+    }
+
+  if(!db_reader_complete(&reader))
+    LogCrit(COMPONENT_FSAL,
+            "WARNING: truncated or corrupted record in %s at offset %llu: ignoring the end of the file",
+            path, (unsigned long long)reader.offset);
+
+  *p_valid_end = reader.offset;
+
+  db_reader_close(&reader);
+
+  return HANDLEMAP_SUCCESS;
+}
+
+static int db_load_operation(db_thread_info_t * p_info, hash_table_t * p_hash)
+{
+  char path[MAXPATHLEN];
+  struct stat st;
+  unsigned int nb_loaded = 0;
+  unsigned int nb_snap;
+  off_t valid_end;
+  int rc;
+  struct timeval t1;
+  struct timeval t2;
+  struct timeval tdiff;
+
+  gettimeofday(&t1, NULL);
+
+  /* a snapshot was being written when the server stopped */
+  db_file_path(path, SNAP_FILE_PREFIX, p_info->thr_index, TMP_FILE_SUFFIX);
+  unlink(path);
+
+  /* first, the snapshot */
+  db_file_path(path, SNAP_FILE_PREFIX, p_info->thr_index, "");
+
+  rc = load_db_file(path, SNAP_MAGIC, p_hash, &nb_loaded, &valid_end);
+  if(rc)
+    return rc;
+
+  nb_snap = nb_loaded;
+
+  P(p_info->queues_mutex);
+  p_info->snap_size = valid_end;
+  V(p_info->queues_mutex);
+
+  /* then, the log whose compaction was interrupted */
+  db_file_path(path, DB_FILE_PREFIX, p_info->thr_index, OLD_FILE_SUFFIX);
+
+  if(stat(path, &st) == 0)
+    {
+      rc = load_db_file(path, LOG_MAGIC, p_hash, &nb_loaded, &valid_end);
+      if(rc)
+        return rc;
+
+      P(p_info->queues_mutex);
+      p_info->old_log = TRUE;
+      V(p_info->queues_mutex);
+    }
+
+  /* and finally, the current log */
+  db_file_path(path, DB_FILE_PREFIX, p_info->thr_index, "");
+
+  rc = load_db_file(path, LOG_MAGIC, p_hash, &nb_loaded, &valid_end);
+  if(rc)
+    return rc;
+
+  /* new records must not be appended after garbage */
+  if(valid_end < p_info->log_size)
+    {
+      if(ftruncate(p_info->log_fd, valid_end))
+        {
+          LogCrit(COMPONENT_FSAL, "ERROR: could not truncate %s: %s",
+                  path, strerror(errno));
+          return HANDLEMAP_DB_ERROR;
+        }
+      p_info->log_size = valid_end;
+    }
+
+  /* print time and item count */
+
+  gettimeofday(&t2, NULL);
+  timersub(&t2, &t1, &tdiff);
 
-  p_thr_info->db_conn = NULL;
+  LogEvent(COMPONENT_FSAL, "Reloaded %u items (%u from snapshot) in %d.%06ds",
+           nb_loaded, nb_snap, (int)tdiff.tv_sec, (int)tdiff.tv_usec);
 
-  for(i = 0; i < STATEMENT_COUNT; i++)
-    p_thr_info->prep_stmt[i] = NULL;
+  return HANDLEMAP_SUCCESS;
 
-  /* init memory pool */
+}                               /* db_load_operation */
 
-  if(pthread_mutex_init(&p_thr_info->pool_mutex, NULL))
-    return HANDLEMAP_SYSTEM_ERROR;
+/* write a group of records to the log and sync it */
+static int db_commit_operation(db_thread_info_t * p_info, size_t len)
+{
+  if(write_full(p_info->log_fd, p_info->commit_buff, len)
+     || fdatasync(p_info->log_fd))
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR writing handle map log #%u: %s",
+              p_info->thr_index, strerror(errno));
+      return HANDLEMAP_DB_ERROR;
+    }
 
-  p_thr_info->dbop_pool = NULL;
+  p_info->log_size += len;
 
   return HANDLEMAP_SUCCESS;
 }
 
-/* Called by a thread to initialize its database access.
- * After this call:
- *  - database connection is established
- *  - schema is created
- *  - prepared statements are ready to be used
- */
-static int init_database_access(db_thread_info_t * p_thr_info)
+/* rename the log, and start a new one */
+static int db_rotate_log(db_thread_info_t * p_info)
 {
-  char db_file[MAXPATHLEN];
-  int rc;
-  char **result = NULL;
-  int rows, cols;
-  char *errmsg = NULL;
-  const char *unparsed;
+  char log_file[MAXPATHLEN];
+  char old_file[MAXPATHLEN];
 
-  /* first open the database file */
+  db_file_path(log_file, DB_FILE_PREFIX, p_info->thr_index, "");
+  db_file_path(old_file, DB_FILE_PREFIX, p_info->thr_index, OLD_FILE_SUFFIX);
 
-  snprintf(db_file, MAXPATHLEN, "%s/%s.%u", dbmap_dir, DB_FILE_PREFIX,
-           p_thr_info->thr_index);
+  if(rename(log_file, old_file))
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR renaming %s: %s", log_file, strerror(errno));
+      return HANDLEMAP_SYSTEM_ERROR;
+    }
 
-  rc = sqlite3_open(db_file, &p_thr_info->db_conn);
+  close(p_info->log_fd);
 
-  if(rc != 0)
+  if(open_log_file(p_info))
     {
-      if(p_thr_info->db_conn)
-        {
-          LogCrit(COMPONENT_FSAL,
-                  "ERROR: could not connect to SQLite3 database (file %s): %s",
-                  db_file, sqlite3_errmsg(p_thr_info->db_conn));
-          sqlite3_close(p_thr_info->db_conn);
-        }
-      else
-        {
-          LogCrit(COMPONENT_FSAL,
-                  "ERROR: could not connect to SQLite3 database (file %s): status=%d",
-                  db_file, rc);
-        }
+      /* go on with the old log */
+      rename(old_file, log_file);
+      p_info->log_fd = open(log_file, O_RDWR | O_APPEND);
       return HANDLEMAP_DB_ERROR;
     }
 
-  /* Now check, that the map table exists */
-  rc = sqlite3_get_table(p_thr_info->db_conn,
-                         "SELECT name FROM sqlite_master WHERE type = 'table' AND name = '"
-                         MAP_TABLE "'", &result, &rows, &cols, &errmsg);
+  sync_db_dir();
 
-  CheckTable(p_thr_info->db_conn, rc, errmsg, result);
+  P(p_info->queues_mutex);
+  p_info->old_log = TRUE;
+  V(p_info->queues_mutex);
 
-  /* no need for the result, just the number of rows returned */
-  sqlite3_free_table(result);
+  return HANDLEMAP_SUCCESS;
+}
 
-  if(rows != 1)
-    {
-      /* table must be created */
-      rc = sqlite3_exec(p_thr_info->db_conn,
-                        "CREATE TABLE " MAP_TABLE " ( "
-                        OBJID_FIELD "   BIGINT NOT NULL, "
-                        HASH_FIELD "    INT NOT NULL, "
-                        HANDLE_FIELD "  TEXT, "
-                        "PRIMARY KEY(" OBJID_FIELD ", " HASH_FIELD ") )",
-                        NULL, NULL, &errmsg);
+/* start a compaction if the log has become too large */
+static void db_check_compaction(db_thread_info_t * p_info)
+{
+  off_t threshold;
+  int start = FALSE;
 
-      CheckCommand(p_thr_info->db_conn, rc, errmsg);
+  P(p_info->queues_mutex);
 
-    }
+  threshold = p_info->snap_size;
+  if(threshold < HANDLEMAP_COMPACT_MIN_SIZE)
+    threshold = HANDLEMAP_COMPACT_MIN_SIZE;
 
-  /* Now, create prepared statements */
+  if(!p_info->compacting && (p_info->old_log || p_info->log_size >= threshold))
+    {
+      p_info->compacting = TRUE;
+      start = TRUE;
+    }
 
-  rc = sqlite3_prepare_v2(p_thr_info->db_conn,
-                          "SELECT " OBJID_FIELD "," HASH_FIELD "," HANDLE_FIELD " FROM "
-                          MAP_TABLE, -1, &(p_thr_info->prep_stmt[LOAD_ALL_STATEMENT]),
-                          &unparsed);
+  V(p_info->queues_mutex);
 
-  CheckPrepare(p_thr_info->db_conn, rc);
+  if(!start)
+    return;
 
-  rc = sqlite3_prepare_v2(p_thr_info->db_conn,
-                          "INSERT INTO " MAP_TABLE "(" OBJID_FIELD "," HASH_FIELD ","
-                          HANDLE_FIELD ") " "VALUES (?1, ?2, ?3 )", -1,
-                          &(p_thr_info->prep_stmt[INSERT_STATEMENT]), &unparsed);
+  /* old_log is only cleared by the compaction thread */
+  if(!p_info->old_log && db_rotate_log(p_info))
+    {
+      P(p_info->queues_mutex);
+      p_info->compacting = FALSE;
+      V(p_info->queues_mutex);
+      return;
+    }
 
-  CheckPrepare(p_thr_info->db_conn, rc);
+  P(compact_mutex);
+  compact_requests |= (1U << p_info->thr_index);
+  pthread_cond_signal(&compact_condition);
+  V(compact_mutex);
+}
 
-  rc = sqlite3_prepare_v2(p_thr_info->db_conn,
-                          "DELETE FROM " MAP_TABLE " WHERE " OBJID_FIELD "=?1 AND "
-                          HASH_FIELD "=?2", -1,
-                          &(p_thr_info->prep_stmt[DELETE_STATEMENT]), &unparsed);
+static int cmp_compact_entry(const void *p1, const void *p2)
+{
+  const compact_entry_t *e1 = (const compact_entry_t *)p1;
+  const compact_entry_t *e2 = (const compact_entry_t *)p2;
 
-  CheckPrepare(p_thr_info->db_conn, rc);
+  if(e1->object_id != e2->object_id)
+    return (e1->object_id < e2->object_id ? -1 : 1);
+  if(e1->handle_hash != e2->handle_hash)
+    return (e1->handle_hash < e2->handle_hash ? -1 : 1);
 
-  /* Everything is OK now ! */
-  return HANDLEMAP_SUCCESS;
+  /* keep log order for the same digest */
+  return (e1->index < e2->index ? -1 : (e1->index > e2->index ? 1 : 0));
+}
 
-}                               /* init_database_access */
+/* compare a (sorted) log entry to a snapshot record */
+static int cmp_entry_record(compact_entry_t * p_entry, db_record_t * p_rec)
+{
+  if(p_entry->object_id != p_rec->object_id)
+    return (p_entry->object_id < p_rec->object_id ? -1 : 1);
+  if(p_entry->handle_hash != p_rec->handle_hash)
+    return (p_entry->handle_hash < p_rec->handle_hash ? -1 : 1);
+  return 0;
+}
 
-static int db_load_operation(db_thread_info_t * p_info, hash_table_t * p_hash)
+/**
+ * Merge the old log of a database into its snapshot.
+ * The log is loaded and sorted in memory, then merged with the
+ * (sorted) snapshot into a new snapshot.
+ */
+static int db_compact_operation(db_thread_info_t * p_info)
 {
-  /* the object id to be inserted to hash table */
-  uint64_t object_id;
-  unsigned int handle_hash;
-  const char *fsal_handle_str;
-  fsal_handle_t fsal_handle;
-  unsigned int nb_loaded = 0;
+  char snap_file[MAXPATHLEN];
+  char tmp_file[MAXPATHLEN];
+  char old_file[MAXPATHLEN];
+  db_reader_t reader;
+  db_writer_t writer;
+  db_record_t rec;
+  db_record_t snap_rec;
+  fsal_handle_t snap_handle;
+  compact_entry_t *entries = NULL;
+  fsal_handle_t *handles = NULL;
+  unsigned int nb_entries = 0;
+  unsigned int max_entries = 0;
+  unsigned int nb_kept, nb_written = 0;
+  unsigned int i;
+  int has_snap;
   int rc;
   struct timeval t1;
   struct timeval t2;
@@ -309,166 +900,246 @@ static int db_load_operation(db_thread_info_t * p_info, hash_table_t * p_hash)
 
   gettimeofday(&t1, NULL);
 
-  rc = sqlite3_step(p_info->prep_stmt[LOAD_ALL_STATEMENT]);
-  CheckStep(p_info->db_conn, rc, p_info->prep_stmt[LOAD_ALL_STATEMENT]);
+  db_file_path(snap_file, SNAP_FILE_PREFIX, p_info->thr_index, "");
+  db_file_path(tmp_file, SNAP_FILE_PREFIX, p_info->thr_index, TMP_FILE_SUFFIX);
+  db_file_path(old_file, DB_FILE_PREFIX, p_info->thr_index, OLD_FILE_SUFFIX);
+
+  /* 1) load the old log */
 
-  /* something to read */
-  while(rc == SQLITE_ROW)
+  rc = db_reader_open(&reader, old_file, LOG_MAGIC);
+  if(rc)
+    return rc;
+
+  while(db_reader_next(&reader, &rec, &snap_handle))
     {
-      object_id = sqlite3_column_int64(p_info->prep_stmt[LOAD_ALL_STATEMENT], 0);
-      handle_hash = sqlite3_column_int(p_info->prep_stmt[LOAD_ALL_STATEMENT], 1);
-      fsal_handle_str = sqlite3_column_text(p_info->prep_stmt[LOAD_ALL_STATEMENT], 2);
+      if(nb_entries == max_entries)
+        {
+          compact_entry_t *new_entries;
+          fsal_handle_t *new_handles;
 
-      /* convert hexa string representation to binary data */
-      sscanHandle(&fsal_handle, fsal_handle_str);
+          max_entries = (max_entries ? 2 * max_entries : 4096);
 
-      /* now insert it to the hash table */
+          new_entries = (compact_entry_t *) Mem_Realloc(entries,
+                                                        max_entries *
+                                                        sizeof(compact_entry_t));
+          if(new_entries)
+            entries = new_entries;
 
-      rc = handle_mapping_hash_add(p_hash, object_id, handle_hash, &fsal_handle);
+          new_handles = (fsal_handle_t *) Mem_Realloc(handles,
+                                                      max_entries *
+                                                      sizeof(fsal_handle_t));
+          if(new_handles)
+            handles = new_handles;
 
-      if(rc == 0)
-        nb_loaded++;
-      else
-        LogCrit(COMPONENT_FSAL,
-                "ERROR %d adding entry to hash table <object_id=%llu, FH_hash=%u, FSAL_Handle=%s>",
-                (unsigned long long)object_id, handle_hash, fsal_handle_str);
+          if(!new_entries || !new_handles)
+            {
+              rc = HANDLEMAP_SYSTEM_ERROR;
+              goto out;
+            }
+        }
+
+      entries[nb_entries].object_id = rec.object_id;
+      entries[nb_entries].handle_hash = rec.handle_hash;
+      entries[nb_entries].op_type = rec.op_type;
+      entries[nb_entries].index = nb_entries;
 
-      rc = sqlite3_step(p_info->prep_stmt[LOAD_ALL_STATEMENT]);
-      CheckStep(p_info->db_conn, rc, p_info->prep_stmt[LOAD_ALL_STATEMENT]);
+      if(rec.op_type == RECORD_INSERT)
+        handles[nb_entries] = snap_handle;
 
+      nb_entries++;
     }
 
-  /* clear results */
-  sqlite3_reset(p_info->prep_stmt[LOAD_ALL_STATEMENT]);
+  db_reader_close(&reader);
 
-  /* print time and item count */
+  /* 2) sort it and only keep the last operation for each digest */
 
-  gettimeofday(&t2, NULL);
-  timersub(&t2, &t1, &tdiff);
+  qsort(entries, nb_entries, sizeof(compact_entry_t), cmp_compact_entry);
 
-  DLogEvent(COMPONENT_FSAL, "Reloaded %u items in %d.%06ds",
-            nb_loaded, (int)tdiff.tv_sec, (int)tdiff.tv_usec);
+  nb_kept = 0;
 
-  return HANDLEMAP_SUCCESS;
+  for(i = 0; i < nb_entries; i++)
+    {
+      if(i + 1 < nb_entries && entries[i].object_id == entries[i + 1].object_id
+         && entries[i].handle_hash == entries[i + 1].handle_hash)
+        continue;
 
-}                               /* db_load_operation */
+      entries[nb_kept++] = entries[i];
+    }
 
-static int db_insert_operation(db_thread_info_t * p_info,
-                               nfs23_map_handle_t * p_nfs23_digest,
-                               fsal_handle_t * p_handle)
-{
-  int rc;
-  char handle_str[2 * sizeof(fsal_handle_t) + 1];
+  /* 3) merge it with the current snapshot */
+
+  rc = db_reader_open(&reader, snap_file, SNAP_MAGIC);
+  if(rc)
+    goto out;
+
+  rc = db_writer_open(&writer, tmp_file, SNAP_MAGIC);
+  if(rc)
+    {
+      db_reader_close(&reader);
+      goto out;
+    }
 
-  rc = sqlite3_bind_int64(p_info->prep_stmt[INSERT_STATEMENT], 1,
-                          p_nfs23_digest->object_id);
-  CheckBind(p_info->db_conn, rc, p_info->prep_stmt[INSERT_STATEMENT]);
+  has_snap = db_reader_next(&reader, &snap_rec, &snap_handle);
+  i = 0;
 
-  rc = sqlite3_bind_int(p_info->prep_stmt[INSERT_STATEMENT], 2,
-                        p_nfs23_digest->handle_hash);
-  CheckBind(p_info->db_conn, rc, p_info->prep_stmt[INSERT_STATEMENT]);
+  while(rc == HANDLEMAP_SUCCESS && (has_snap || i < nb_kept))
+    {
+      if(i < nb_kept && (!has_snap || cmp_entry_record(&entries[i], &snap_rec) <= 0))
+        {
+          /* the log entry replaces the snapshot one */
+          if(has_snap && cmp_entry_record(&entries[i], &snap_rec) == 0)
+            has_snap = db_reader_next(&reader, &snap_rec, &snap_handle);
 
-  snprintHandle(handle_str, 2 * sizeof(fsal_handle_t) + 1, p_handle);
+          if(entries[i].op_type == RECORD_INSERT)
+            {
+              rec.op_type = RECORD_INSERT;
+              rec.object_id = entries[i].object_id;
+              rec.handle_hash = entries[i].handle_hash;
 
-  rc = sqlite3_bind_text(p_info->prep_stmt[INSERT_STATEMENT], 3, handle_str, -1,
-                         SQLITE_STATIC);
-  CheckBind(p_info->db_conn, rc, p_info->prep_stmt[INSERT_STATEMENT]);
+              rc = db_writer_append(&writer, &rec, &handles[entries[i].index]);
+              nb_written++;
+            }
 
-  rc = sqlite3_step(p_info->prep_stmt[INSERT_STATEMENT]);
-  CheckStep(p_info->db_conn, rc, p_info->prep_stmt[INSERT_STATEMENT]);
+          i++;
+        }
+      else
+        {
+          rc = db_writer_append(&writer, &snap_rec, &snap_handle);
+          nb_written++;
 
-  /* clear results */
-  sqlite3_reset(p_info->prep_stmt[INSERT_STATEMENT]);
+          has_snap = db_reader_next(&reader, &snap_rec, &snap_handle);
+        }
+    }
 
-  return HANDLEMAP_SUCCESS;
+  if(rc == HANDLEMAP_SUCCESS && !db_reader_complete(&reader))
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: corrupted record in %s at offset %llu",
+              snap_file, (unsigned long long)reader.offset);
+      rc = HANDLEMAP_DB_ERROR;
+    }
 
-}                               /* db_insert_operation */
+  db_reader_close(&reader);
 
-static int db_delete_operation(db_thread_info_t * p_info,
-                               nfs23_map_handle_t * p_nfs23_digest)
-{
-  int rc;
+  if(db_writer_close(&writer) && rc == HANDLEMAP_SUCCESS)
+    rc = HANDLEMAP_SYSTEM_ERROR;
+
+  if(rc)
+    {
+      unlink(tmp_file);
+      goto out;
+    }
+
+  /* 4) the new snapshot replaces the old one and the old log */
 
-  rc = sqlite3_bind_int64(p_info->prep_stmt[DELETE_STATEMENT], 1,
-                          p_nfs23_digest->object_id);
-  CheckBind(p_info->db_conn, rc, p_info->prep_stmt[DELETE_STATEMENT]);
+  if(rename(tmp_file, snap_file))
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR renaming %s: %s", tmp_file, strerror(errno));
+      unlink(tmp_file);
+      rc = HANDLEMAP_SYSTEM_ERROR;
+      goto out;
+    }
+
+  sync_db_dir();
+  unlink(old_file);
+
+  P(p_info->queues_mutex);
+  p_info->snap_size = writer.size;
+  p_info->old_log = FALSE;
+  V(p_info->queues_mutex);
 
-  rc = sqlite3_bind_int(p_info->prep_stmt[DELETE_STATEMENT], 2,
-                        p_nfs23_digest->handle_hash);
-  CheckBind(p_info->db_conn, rc, p_info->prep_stmt[DELETE_STATEMENT]);
+  gettimeofday(&t2, NULL);
+  timersub(&t2, &t1, &tdiff);
 
-  rc = sqlite3_step(p_info->prep_stmt[DELETE_STATEMENT]);
-  CheckStep(p_info->db_conn, rc, p_info->prep_stmt[DELETE_STATEMENT]);
+  LogEvent(COMPONENT_FSAL,
+           "Database #%u compacted: %u log records merged, %u entries in snapshot (%d.%06ds)",
+           p_info->thr_index, nb_entries, nb_written, (int)tdiff.tv_sec,
+           (int)tdiff.tv_usec);
 
-  /* clear results */
-  sqlite3_reset(p_info->prep_stmt[DELETE_STATEMENT]);
+ out:
+  if(entries)
+    Mem_Free(entries);
+  if(handles)
+    Mem_Free(handles);
 
-  return HANDLEMAP_SUCCESS;
+  return rc;
 
-}                               /* db_delete_operation */
+}                               /* db_compact_operation */
 
-/* push a task to the queue */
-static int dbop_push(flusher_queue_t * p_queue, db_op_item_t * p_op)
+static void *compaction_thread(void *arg)
 {
-  P(p_queue->queues_mutex);
+  unsigned int i;
+  int rc;
 
-  /* add an item at the end of the queue */
-  switch (p_op->op_type)
-    {
-    case LOAD:
-    case INSERT:
+  SetNameFunction("DB compaction");
 
-      /* high priority operations */
+#ifndef _NO_BUDDY_SYSTEM
 
-      p_op->p_next = NULL;
+  if((rc = BuddyInit(NULL)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_FSAL, "ERROR: Could not initialize memory manager");
+      exit(rc);
+    }
+#endif
 
-      if(p_queue->highprio_last == NULL)
-        {
-          /* first operation */
-          p_queue->highprio_first = p_op;
-          p_queue->highprio_last = p_op;
-        }
-      else
-        {
-          p_queue->highprio_last->p_next = p_op;
-          p_queue->highprio_last = p_op;
-        }
+  while(1)
+    {
+      P(compact_mutex);
 
-      p_queue->nb_waiting++;
+      while(compact_requests == 0)
+        pthread_cond_wait(&compact_condition, &compact_mutex);
 
-      break;
+      for(i = 0; !(compact_requests & (1U << i)); i++) ;
 
-    case DELETE:
+      compact_requests &= ~(1U << i);
 
-      /* low priority operation */
+      V(compact_mutex);
 
-      p_op->p_next = NULL;
+      rc = db_compact_operation(&db_thread[i]);
 
-      if(p_queue->lowprio_last == NULL)
-        {
-          /* first operation */
-          p_queue->lowprio_first = p_op;
-          p_queue->lowprio_last = p_op;
-        }
-      else
+      if(rc)
         {
-          p_queue->lowprio_last->p_next = p_op;
-          p_queue->lowprio_last = p_op;
+          /* the log keeps on growing, but nothing is lost */
+          LogCrit(COMPONENT_FSAL,
+                  "ERROR %d compacting handle map database #%u: compaction disabled for this database",
+                  rc, i);
+          continue;
         }
 
-      p_queue->nb_waiting++;
+      P(db_thread[i].queues_mutex);
+      db_thread[i].compacting = FALSE;
+      V(db_thread[i].queues_mutex);
+    }
+
+  return NULL;
+}
 
-      break;
+/* push a record to the group commit buffer of a db thread */
+static int dbop_push(db_thread_info_t * p_info, unsigned int op_type,
+                     nfs23_map_handle_t * p_nfs23_digest, fsal_handle_t * p_handle,
+                     uint64_t * p_seq)
+{
+  char record[INSERT_RECORD_SIZE];
+  size_t size;
 
-    default:
-      LogCrit(COMPONENT_FSAL,
-              "ERROR in dbop_push: Invalid operation type %d", p_op->op_type);
-    }
+  size = encode_record(record, op_type, p_nfs23_digest, p_handle);
+
+  P(p_info->queues_mutex);
+
+  /* wait for the thread to take the current group */
+  while(p_info->pending_len + size > commit_buff_size)
+    pthread_cond_wait(&p_info->work_done_condition, &p_info->queues_mutex);
+
+  memcpy(p_info->pending_buff + p_info->pending_len, record, size);
+  p_info->pending_len += size;
+  p_info->nb_waiting++;
+
+  *p_seq = ++p_info->last_submitted;
 
   /* there now some work available */
-  pthread_cond_signal(&p_queue->work_avail_condition);
+  pthread_cond_signal(&p_info->work_avail_condition);
 
-  V(p_queue->queues_mutex);
+  V(p_info->queues_mutex);
 
   return HANDLEMAP_SUCCESS;
 
@@ -478,7 +1149,11 @@ static void *database_worker_thread(void *arg)
 {
   db_thread_info_t *p_info = (db_thread_info_t *) arg;
   int rc;
-  db_op_item_t *to_be_done = NULL;
+  char *buff;
+  size_t len;
+  unsigned int nb;
+  uint64_t last;
+  hash_table_t *p_hash;
   char thread_name[256];
 
   /* initialize logging */
@@ -497,112 +1172,73 @@ static void *database_worker_thread(void *arg)
     }
 #endif
 
-  rc = init_database_access(p_info);
-
-  if(rc != HANDLEMAP_SUCCESS)
-    {
-      /* Failed init */
-      LogCrit(COMPONENT_FSAL, "ERROR: Database initialization error %d", rc);
-      exit(rc);
-    }
-
   /* main loop */
   while(1)
     {
-
-      /* Is "work done" or "work available" condition verified ? */
-
-      P(p_info->work_queue.queues_mutex);
+      P(p_info->queues_mutex);
 
       /* nothing to be done ? */
-      while(p_info->work_queue.highprio_first == NULL
-            && p_info->work_queue.lowprio_first == NULL)
+      while(!p_info->load_requested && p_info->pending_len == 0)
+        pthread_cond_wait(&p_info->work_avail_condition, &p_info->queues_mutex);
+
+      if(p_info->load_requested || !p_info->loaded)
         {
-          to_be_done = NULL;
-          p_info->work_queue.status = IDLE;
-          pthread_cond_signal(&p_info->work_queue.work_done_condition);
+          /* the log must be checked before appending to it */
+          p_hash = (p_info->load_requested ? p_info->load_hash : NULL);
+
+          V(p_info->queues_mutex);
+
+          rc = db_load_operation(p_info, p_hash);
 
-          /* if termination is requested, exit */
-          if(do_terminate)
+          if(rc != HANDLEMAP_SUCCESS)
             {
-              p_info->work_queue.status = FINISHED;
-              V(p_info->work_queue.queues_mutex);
-              return (void *)p_info;
+              LogCrit(COMPONENT_FSAL, "ERROR: Database load error %d", rc);
+              exit(rc);
             }
 
-          /* else, wait for something to do */
-          pthread_cond_wait(&p_info->work_queue.work_avail_condition,
-                            &p_info->work_queue.queues_mutex);
+          P(p_info->queues_mutex);
+          p_info->load_requested = FALSE;
+          p_info->loaded = TRUE;
+          pthread_cond_broadcast(&p_info->work_done_condition);
+          V(p_info->queues_mutex);
 
+          db_check_compaction(p_info);
+          continue;
         }
 
-      /* there is something to do : first check the highest priority list,
-       * then the lower priority.
-       */
+      /* take the whole group of pending records */
 
-      if(p_info->work_queue.highprio_first != NULL)
-        {
-          /* take the next item in the list */
-          to_be_done = p_info->work_queue.highprio_first;
-          p_info->work_queue.highprio_first = to_be_done->p_next;
-
-          /* still any entries in the list ? */
-          if(p_info->work_queue.highprio_first == NULL)
-            p_info->work_queue.highprio_last = NULL;
-          /* it it the last entry ? */
-          else if(p_info->work_queue.highprio_first->p_next == NULL)
-            p_info->work_queue.highprio_last = p_info->work_queue.highprio_first;
-
-          /* something to do */
-          p_info->work_queue.status = WORKING;
-        }
-      else if(p_info->work_queue.lowprio_first != NULL)
-        {
-          /* take the next item in the list */
-          to_be_done = p_info->work_queue.lowprio_first;
-          p_info->work_queue.lowprio_first = to_be_done->p_next;
-
-          /* still any entries in the list ? */
-          if(p_info->work_queue.lowprio_first == NULL)
-            p_info->work_queue.lowprio_last = NULL;
-          /* it it the last entry ? */
-          else if(p_info->work_queue.lowprio_first->p_next == NULL)
-            p_info->work_queue.lowprio_last = p_info->work_queue.lowprio_first;
-
-          /* something to do */
-          p_info->work_queue.status = WORKING;
-        }
+      buff = p_info->commit_buff;
+      p_info->commit_buff = p_info->pending_buff;
+      p_info->pending_buff = buff;
 
-      p_info->work_queue.nb_waiting--;
+      len = p_info->pending_len;
+      nb = p_info->nb_waiting;
+      last = p_info->last_submitted;
 
-      V(p_info->work_queue.queues_mutex);
+      p_info->pending_len = 0;
+      p_info->nb_waiting = 0;
 
-      /* PROCESS THE REQUEST */
+      /* room for new records */
+      pthread_cond_broadcast(&p_info->work_done_condition);
 
-      switch (to_be_done->op_type)
-        {
-        case LOAD:
-          db_load_operation(p_info, to_be_done->op_arg.hash);
-          break;
-
-        case INSERT:
-          db_insert_operation(p_info, &to_be_done->op_arg.fh_info.nfs23_digest,
-                              &to_be_done->op_arg.fh_info.fsal_handle);
-          break;
-
-        case DELETE:
-          db_delete_operation(p_info, &to_be_done->op_arg.fh_info.nfs23_digest);
-          break;
-
-        default:
-          LogCrit(COMPONENT_FSAL, "ERROR: Invalid operation type %d",
-                  to_be_done->op_type);
-        }
+      V(p_info->queues_mutex);
+
+      /* PROCESS THE GROUP */
+
+      db_commit_operation(p_info, len);
+
+      P(p_info->queues_mutex);
+
+      p_info->last_committed = last;
+      p_info->nb_commits++;
+      p_info->nb_records += nb;
+
+      pthread_cond_broadcast(&p_info->work_done_condition);
+
+      V(p_info->queues_mutex);
 
-      /* free the db operation item */
-      P(p_info->pool_mutex);
-      RELEASE_PREALLOC(to_be_done, p_info->dbop_pool, p_next);
-      V(p_info->pool_mutex);
+      db_check_compaction(p_info);
 
     }                           /* loop forever */
 
@@ -620,12 +1256,16 @@ int handlemap_db_count(const char *dir)
   struct dirent direntry;
   struct dirent *cookie;
   int rc;
-  char db_pattern[MAXPATHLEN];
+  unsigned int i;
+  const char *prefixes[] = { DB_FILE_PREFIX ".", SNAP_FILE_PREFIX "." };
+  char *end;
+  unsigned long index;
 
+  /* a bit for each db index found */
+  unsigned int found = 0;
   unsigned int count = 0;
   int end_of_dir = FALSE;
-
-  snprintf(db_pattern, MAXPATHLEN, "%s.*[0-9]", DB_FILE_PREFIX);
+  int obsolete = FALSE;
 
   dir_hdl = opendir(dir);
 
@@ -646,9 +1286,31 @@ int handlemap_db_count(const char *dir)
           if(!strcmp(".", direntry.d_name) || !strcmp("..", direntry.d_name))
             continue;
 
-          /* does it match the expected db pattern ? */
-          if(!fnmatch(db_pattern, direntry.d_name, FNM_PATHNAME))
-            count++;
+          /* databases of older versions must be converted first */
+          if(!strncmp(direntry.d_name, SQLITE_FILE_PREFIX ".",
+                      strlen(SQLITE_FILE_PREFIX ".")))
+            {
+              LogCrit(COMPONENT_FSAL,
+                      "ERROR: %s/%s is an obsolete SQLite handle map database. Dump it with: sqlite3 -separator ' ' %s/%s \"SELECT ObjectId, HandleHash, FSALHandle FROM HandleMap\" > %s/%s.%s then move it out of %s",
+                      dir, direntry.d_name, dir, direntry.d_name, dir,
+                      IMPORT_FILE_PREFIX,
+                      direntry.d_name + strlen(SQLITE_FILE_PREFIX "."), dir);
+              obsolete = TRUE;
+            }
+
+          /* does it match one of the db files ? */
+          for(i = 0; i < 2; i++)
+            {
+              if(strncmp(direntry.d_name, prefixes[i], strlen(prefixes[i])))
+                continue;
+
+              index = strtoul(direntry.d_name + strlen(prefixes[i]), &end, 10);
+
+              if(end != direntry.d_name + strlen(prefixes[i]) && index < MAX_DB
+                 && (*end == '\0' || !strcmp(end, OLD_FILE_SUFFIX)
+                     || !strcmp(end, TMP_FILE_SUFFIX)))
+                found |= (1U << index);
+            }
 
         }
       else if(rc == 0 && cookie == NULL)
@@ -676,6 +1338,13 @@ int handlemap_db_count(const char *dir)
 
   closedir(dir_hdl);
 
+  if(obsolete)
+    return -HANDLEMAP_DB_ERROR;
+
+  for(i = 0; i < MAX_DB; i++)
+    if(found & (1U << i))
+      count++;
+
   return count;
 
 }                               /* handlemap_db_count */
@@ -693,9 +1362,8 @@ unsigned int select_db_queue(const nfs23_map_handle_t * p_nfs23_digest)
 /**
  * Initialize databases access
  * - init DB queues
+ * - open (or create) the logs
  * - start threads
- * - establish DB connections
- * - create db schema if it was empty
  */
 int handlemap_db_init(const char *db_dir,
                       const char *tmp_dir,
@@ -707,18 +1375,28 @@ int handlemap_db_init(const char *db_dir,
 
   /* first, save the parameters */
 
-  strncpy(dbmap_dir, db_dir, MAXPATHLEN);
-  strncpy(db_tmpdir, tmp_dir, MAXPATHLEN);
+  if(strlen(db_dir) + DB_FILE_NAME_MAX > MAXPATHLEN || strlen(tmp_dir) >= MAXPATHLEN)
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: handle map directory %s is too long", db_dir);
+      return HANDLEMAP_INVALID_PARAM;
+    }
+
+  strncpy(dbmap_dir, db_dir, MAXPATHLEN - 1);
+  dbmap_dir[MAXPATHLEN - 1] = '\0';
+  strncpy(db_tmpdir, tmp_dir, MAXPATHLEN - 1);
+  db_tmpdir[MAXPATHLEN - 1] = '\0';
 
-  if(db_count > MAX_DB)
+  if(db_count == 0 || db_count > MAX_DB)
     return HANDLEMAP_INVALID_PARAM;
 
   nb_db_threads = db_count;
-  nb_prealloc = nb_dbop_prealloc;
+  nb_prealloc = (nb_dbop_prealloc ? nb_dbop_prealloc : 1);
   synchronous = synchronous_insert;
-  /* set global database engine info */
 
-  sqlite3_temp_directory = db_tmpdir;
+  /* a group commit can hold nb_prealloc inserts */
+  commit_buff_size = nb_prealloc * INSERT_RECORD_SIZE;
+
+  init_crc_table();
 
   /* initialize structures for each thread and launch it */
 
@@ -730,32 +1408,37 @@ int handlemap_db_init(const char *db_dir,
 
       db_thread[i].thr_index = i;
 
+      rc = open_log_file(&db_thread[i]);
+      if(rc)
+        return rc;
+
       rc = pthread_create(&db_thread[i].thr_id, NULL, database_worker_thread,
                           &db_thread[i]);
       if(rc)
         return HANDLEMAP_SYSTEM_ERROR;
     }
 
+  sync_db_dir();
+
+  rc = pthread_create(&compact_thr_id, NULL, compaction_thread, NULL);
+  if(rc)
+    return HANDLEMAP_SYSTEM_ERROR;
+
   /* I'm ready to serve, my Lord ! */
   return HANDLEMAP_SUCCESS;
 }
 
-/* wait that a thread has done all its jobs */
+/* wait that a thread has written all the records submitted */
 static void wait_thread_jobs_finished(db_thread_info_t * p_thr_info)
 {
 
-  P(p_thr_info->work_queue.queues_mutex);
+  P(p_thr_info->queues_mutex);
 
-  /* wait until the thread has no more tasks in its queue
-   * and it is no more working
-   */
-  while(p_thr_info->work_queue.highprio_first != NULL
-        || p_thr_info->work_queue.lowprio_first != NULL
-        || p_thr_info->work_queue.status == WORKING)
-    pthread_cond_wait(&p_thr_info->work_queue.work_done_condition,
-                      &p_thr_info->work_queue.queues_mutex);
+  while(p_thr_info->load_requested
+        || p_thr_info->last_committed != p_thr_info->last_submitted)
+    pthread_cond_wait(&p_thr_info->work_done_condition, &p_thr_info->queues_mutex);
 
-  V(p_thr_info->work_queue.queues_mutex);
+  V(p_thr_info->queues_mutex);
 
 }
 
@@ -768,30 +1451,18 @@ static void wait_thread_jobs_finished(db_thread_info_t * p_thr_info)
 int handlemap_db_reaload_all(hash_table_t * target_hash)
 {
   unsigned int i;
-  db_op_item_t *new_task;
-  int rc;
 
   /* give the job to all threads */
   for(i = 0; i < nb_db_threads; i++)
     {
-      /* get a new db operation  */
-      P(db_thread[i].pool_mutex);
-
-      GET_PREALLOC(new_task, db_thread[i].dbop_pool, nb_prealloc, db_op_item_t, p_next);
+      P(db_thread[i].queues_mutex);
 
-      V(db_thread[i].pool_mutex);
+      db_thread[i].load_requested = TRUE;
+      db_thread[i].load_hash = target_hash;
 
-      if(!new_task)
-        return HANDLEMAP_SYSTEM_ERROR;
-
-      /* can you fill it ? */
-      new_task->op_type = LOAD;
-      new_task->op_arg.hash = target_hash;
+      pthread_cond_signal(&db_thread[i].work_avail_condition);
 
-      rc = dbop_push(&db_thread[i].work_queue, new_task);
-
-      if(rc)
-        return rc;
+      V(db_thread[i].queues_mutex);
     }
 
   /* wait for all threads to finish their job */
@@ -805,84 +1476,177 @@ int handlemap_db_reaload_all(hash_table_t * target_hash)
 
 }                               /* handlemap_db_reaload_all */
 
+/* insert the entries of a text dump of an older SQLite database */
+static int import_db_file(const char *path, hash_table_t * p_hash,
+                          unsigned int *p_count)
+{
+  FILE *file;
+  char line[64 + 2 * sizeof(fsal_handle_t)];
+  unsigned long long object_id;
+  unsigned int handle_hash;
+  nfs23_map_handle_t digest;
+  fsal_handle_t handle;
+  unsigned int line_nb = 0;
+  int offset;
+  int rc;
+
+  file = fopen(path, "r");
+
+  if(file == NULL)
+    {
+      LogCrit(COMPONENT_FSAL, "ERROR: could not open %s: %s", path, strerror(errno));
+      return HANDLEMAP_SYSTEM_ERROR;
+    }
+
+  while(fgets(line, sizeof(line), file) != NULL)
+    {
+      line_nb++;
+
+      /* <object_id> <handle_hash> <handle in hexa> */
+      if(sscanf(line, "%llu %u %n", &object_id, &handle_hash, &offset) != 2
+         || sscanHandle(&handle, line + offset) < 0)
+        {
+          LogCrit(COMPONENT_FSAL, "ERROR: invalid entry at line %u of %s",
+                  line_nb, path);
+          fclose(file);
+          return HANDLEMAP_DB_ERROR;
+        }
+
+      digest.object_id = object_id;
+      digest.handle_hash = handle_hash;
+
+      /* the databases may already contain a newer entry
+       * if a previous import was interrupted */
+      if(p_hash != NULL)
+        {
+          rc = handle_mapping_hash_add(p_hash, digest.object_id, digest.handle_hash,
+                                       &handle);
+          if(rc == HANDLEMAP_EXISTS)
+            continue;
+          else if(rc)
+            {
+              fclose(file);
+              return rc;
+            }
+        }
+
+      rc = handlemap_db_insert(&digest, &handle);
+
+      if(rc)
+        {
+          fclose(file);
+          return rc;
+        }
+
+      (*p_count)++;
+    }
+
+  fclose(file);
+
+  return HANDLEMAP_SUCCESS;
+}
+
 /**
- * Submit a db 'insert' request.
- * The request is inserted in the appropriate db queue.
+ * Insert the entries of the text dumps of older SQLite databases
+ * to the databases and to the hash table.
+ * The dumps are renamed once their entries are synced,
+ * so they are only imported once.
  */
-int handlemap_db_insert(nfs23_map_handle_t * p_in_nfs23_digest,
-                        fsal_handle_t * p_in_handle)
+int handlemap_db_import_all(hash_table_t * target_hash)
 {
+  char path[MAXPATHLEN];
+  char done_path[MAXPATHLEN];
+  struct stat st;
   unsigned int i;
-  db_op_item_t *new_task;
+  unsigned int nb_imported;
   int rc;
 
-  if(!synchronous)
+  for(i = 0; i < MAX_DB; i++)
     {
-      /* which thread is going to handle this inode ? */
+      db_file_path(path, IMPORT_FILE_PREFIX, i, "");
 
-      i = select_db_queue(p_in_nfs23_digest);
+      if(stat(path, &st) != 0)
+        continue;
 
-      /* get a new db operation  */
-      P(db_thread[i].pool_mutex);
+      nb_imported = 0;
 
-      GET_PREALLOC(new_task, db_thread[i].dbop_pool, nb_prealloc, db_op_item_t, p_next);
+      rc = import_db_file(path, target_hash, &nb_imported);
 
-      V(db_thread[i].pool_mutex);
+      if(rc)
+        return rc;
 
-      if(!new_task)
-        return HANDLEMAP_SYSTEM_ERROR;
+      handlemap_db_flush();
+
+      db_file_path(done_path, IMPORT_FILE_PREFIX, i, IMPORTED_FILE_SUFFIX);
 
-      /* fill the task info */
-      new_task->op_type = INSERT;
-      new_task->op_arg.fh_info.nfs23_digest = *p_in_nfs23_digest;
-      new_task->op_arg.fh_info.fsal_handle = *p_in_handle;
+      if(rename(path, done_path))
+        {
+          LogCrit(COMPONENT_FSAL, "ERROR: could not rename %s to %s: %s",
+                  path, done_path, strerror(errno));
+          return HANDLEMAP_SYSTEM_ERROR;
+        }
 
-      rc = dbop_push(&db_thread[i].work_queue, new_task);
+      sync_db_dir();
 
-      if(rc)
-        return rc;
+      LogEvent(COMPONENT_FSAL, "%u handle map entries imported from %s",
+               nb_imported, path);
     }
-  /* else: @todo not supported yet */
 
   return HANDLEMAP_SUCCESS;
 
-}
+}                               /* handlemap_db_import_all */
 
 /**
- * Submit a db 'delete' request.
+ * Submit a db 'insert' request.
  * The request is inserted in the appropriate db queue.
- * (always asynchronous)
  */
-int handlemap_db_delete(nfs23_map_handle_t * p_in_nfs23_digest)
+int handlemap_db_insert(nfs23_map_handle_t * p_in_nfs23_digest,
+                        fsal_handle_t * p_in_handle)
 {
   unsigned int i;
-  db_op_item_t *new_task;
+  uint64_t seq;
   int rc;
 
   /* which thread is going to handle this inode ? */
 
   i = select_db_queue(p_in_nfs23_digest);
 
-  /* get a new db operation  */
-  P(db_thread[i].pool_mutex);
+  rc = dbop_push(&db_thread[i], RECORD_INSERT, p_in_nfs23_digest, p_in_handle, &seq);
 
-  GET_PREALLOC(new_task, db_thread[i].dbop_pool, nb_prealloc, db_op_item_t, p_next);
+  if(rc)
+    return rc;
 
-  V(db_thread[i].pool_mutex);
+  if(synchronous)
+    {
+      /* wait for the group commit */
+      P(db_thread[i].queues_mutex);
 
-  if(!new_task)
-    return HANDLEMAP_SYSTEM_ERROR;
+      while(db_thread[i].last_committed < seq)
+        pthread_cond_wait(&db_thread[i].work_done_condition,
+                          &db_thread[i].queues_mutex);
 
-  /* fill the task info */
-  new_task->op_type = DELETE;
-  new_task->op_arg.fh_info.nfs23_digest = *p_in_nfs23_digest;
+      V(db_thread[i].queues_mutex);
+    }
 
-  rc = dbop_push(&db_thread[i].work_queue, new_task);
+  return HANDLEMAP_SUCCESS;
 
-  if(rc)
-    return rc;
+}
 
-  return HANDLEMAP_SUCCESS;
+/**
+ * Submit a db 'delete' request.
+ * The request is inserted in the appropriate db queue.
+ * (always asynchronous)
+ */
+int handlemap_db_delete(nfs23_map_handle_t * p_in_nfs23_digest)
+{
+  unsigned int i;
+  uint64_t seq;
+
+  /* which thread is going to handle this inode ? */
+
+  i = select_db_queue(p_in_nfs23_digest);
+
+  return dbop_push(&db_thread[i], RECORD_DELETE, p_in_nfs23_digest, NULL, &seq);
 
 }
 
@@ -897,10 +1661,12 @@ int handlemap_db_flush()
   struct timeval t2;
   struct timeval tdiff;
   unsigned int to_sync = 0;
+  unsigned int nb_commits = 0;
+  unsigned long long nb_records = 0;
 
   for(i = 0; i < nb_db_threads; i++)
     {
-      to_sync += db_thread[i].work_queue.nb_waiting;
+      to_sync += db_thread[i].nb_waiting;
     }
 
   LogEvent(COMPONENT_FSAL,
@@ -914,14 +1680,18 @@ int handlemap_db_flush()
   for(i = 0; i < nb_db_threads; i++)
     {
       wait_thread_jobs_finished(&db_thread[i]);
+
+      nb_commits += db_thread[i].nb_commits;
+      nb_records += db_thread[i].nb_records;
     }
 
   gettimeofday(&t2, NULL);
 
   timersub(&t2, &t1, &tdiff);
 
-  LogEvent(COMPONENT_FSAL, "Database synchronized in %d.%06ds",
-           (int)tdiff.tv_sec, (int)tdiff.tv_usec);
+  LogEvent(COMPONENT_FSAL,
+           "Database synchronized in %d.%06ds (%llu records written in %u group commits)",
+           (int)tdiff.tv_sec, (int)tdiff.tv_usec, nb_records, nb_commits);
 
   return HANDLEMAP_SUCCESS;
 
@@ -4,13 +4,42 @@
 #include "handle_mapping.h"
 #include "HashTable.h"
 
-#define DB_FILE_PREFIX "handlemap.sqlite"
+/* Each database is made of an append-only log of insert/delete records
+ * (DB_FILE_PREFIX.<n>) and of a compacted snapshot of the entries
+ * it contained at the time of the last compaction (SNAP_FILE_PREFIX.<n>).
+ */
+#define DB_FILE_PREFIX    "handlemap.log"
+#define SNAP_FILE_PREFIX  "handlemap.snap"
+
+/* suffixes of the files used during a compaction */
+#define OLD_FILE_SUFFIX   ".old"
+#define TMP_FILE_SUFFIX   ".tmp"
+
+/* Older versions stored the map in SQLite databases (SQLITE_FILE_PREFIX.<n>).
+ * They are not read any more, and the server refuses to start while
+ * they are present. To migrate, dump each of them as text into
+ * the same directory, then move the SQLite files away:
+ *
+ *   sqlite3 -separator ' ' handlemap.sqlite.<n> \
+ *     "SELECT ObjectId, HandleHash, FSALHandle FROM HandleMap" > handlemap.import.<n>
+ *
+ * At startup, the entries of each IMPORT_FILE_PREFIX.<n> file are inserted
+ * to the new databases (whatever their count is), and the file is renamed
+ * with IMPORTED_FILE_SUFFIX once they are synced.
+ */
+#define SQLITE_FILE_PREFIX  "handlemap.sqlite"
+#define IMPORT_FILE_PREFIX  "handlemap.import"
+#define IMPORTED_FILE_SUFFIX ".done"
+
+/* room left after the database directory for "/<prefix>.<n><suffix>" */
+#define DB_FILE_NAME_MAX  32
 
-/* Database definition */
-#define MAP_TABLE      "HandleMap"
-#define OBJID_FIELD    "ObjectId"
-#define HASH_FIELD     "HandleHash"
-#define HANDLE_FIELD   "FSALHandle"
+/* the log is merged into the snapshot when it becomes larger
+ * than the snapshot, and at least this size.
+ */
+#ifndef HANDLEMAP_COMPACT_MIN_SIZE
+#define HANDLEMAP_COMPACT_MIN_SIZE  (16*1024*1024)
+#endif
 
 #define MAX_DB  32
 
@@ -23,8 +52,9 @@ int handlemap_db_count(const char *dir);
 
 /**
  * Initialize databases access
- * (init DB queues, start threads, establish DB connections,
- * and create db schema if it was empty).
+ * (init DB queues, start threads, open the log files,
+ * and create them if they did not exist).
+ * nb_dbop_prealloc is the number of records of a group commit.
  */
 int handlemap_db_init(const char *db_dir,
                       const char *tmp_dir,
@@ -33,15 +63,25 @@ int handlemap_db_init(const char *db_dir,
 
 /**
  * Gives the order to each DB thread to reload
- * the content of its database and insert it
- * to the hash table.
+ * the content of its database (snapshot, then log)
+ * and insert it to the hash table (if not NULL).
+ * The databases are loaded in parallel.
  * The function blocks until all threads have loaded their data.
  */
 int handlemap_db_reaload_all(hash_table_t * target_hash);
 
+/**
+ * Insert the entries of the text dumps of older SQLite databases
+ * to the databases and to the hash table (if not NULL).
+ * Entries that are already in the hash table are kept.
+ * Must be called after handlemap_db_reaload_all.
+ */
+int handlemap_db_import_all(hash_table_t * target_hash);
+
 /**
  * Submit a db 'insert' request.
  * The request is inserted in the appropriate db queue.
+ * In synchronous mode, wait for its group commit.
  */
 int handlemap_db_insert(nfs23_map_handle_t * p_in_nfs23_digest,
                         fsal_handle_t * p_in_handle);
@@ -55,7 +95,7 @@ int handlemap_db_delete(nfs23_map_handle_t * p_in_nfs23_digest);
 
 /**
  * Wait for all queues to be empty
- * and all current DB request to be done.
+ * and all current DB request to be written and synced.
  */
 int handlemap_db_flush();
 
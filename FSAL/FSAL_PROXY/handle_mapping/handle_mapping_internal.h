@@ -8,4 +8,7 @@ int handle_mapping_hash_add(hash_table_t * p_hash,
                             uint64_t object_id,
                             unsigned int handle_hash, fsal_handle_t * p_handle);
 
+int handle_mapping_hash_del(hash_table_t * p_hash,
+                            uint64_t object_id, unsigned int handle_hash);
+
 #endif
@@ -2,18 +2,179 @@
 #include "handle_mapping_db.h"
 #include "stuff_alloc.h"
 #include <sys/time.h>
+#include <pthread.h>
+#include <unistd.h>
 
-int main(int argc, char **argv)
+/* Throughput benchmark of the handle map databases:
+ * - reload of the existing databases (run it twice with -k to measure it),
+ * - inserts and deletes submitted by several threads,
+ *   with and without the final flush (group commits).
+ */
+
+static unsigned int nb_handles = 10000;
+static unsigned int nb_submitters = 1;
+static time_t now;
+
+typedef enum
 {
+  BENCH_INSERT,
+  BENCH_DELETE
+} bench_op_t;
+
+typedef struct submitter_arg__
+{
+  pthread_t thr_id;
+  unsigned int first;
+  unsigned int last;
+  bench_op_t op;
+  int rc;
+} submitter_arg_t;
+
+static void make_digest(unsigned int i, nfs23_map_handle_t * p_digest)
+{
+  p_digest->object_id = 12345 + i;
+  p_digest->handle_hash = (1999 * i + now) % 479001599;
+}
+
+static void *submitter_thread(void *arg)
+{
+  submitter_arg_t *p_arg = (submitter_arg_t *) arg;
+  nfs23_map_handle_t nfs23_digest;
+  fsal_handle_t handle;
   unsigned int i;
+  int rc;
+
+#ifndef _NO_BUDDY_SYSTEM
+
+  if((rc = BuddyInit(NULL)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_FSAL, "ERROR: Could not initialize memory manager");
+      exit(rc);
+    }
+#endif
+
+  p_arg->rc = 0;
+
+  for(i = p_arg->first; i < p_arg->last; i++)
+    {
+      make_digest(i, &nfs23_digest);
+
+      if(p_arg->op == BENCH_INSERT)
+        {
+          memset(&handle, i, sizeof(fsal_handle_t));
+          rc = handlemap_db_insert(&nfs23_digest, &handle);
+        }
+      else
+        rc = handlemap_db_delete(&nfs23_digest);
+
+      if(rc)
+        {
+          p_arg->rc = rc;
+          break;
+        }
+    }
+
+  return NULL;
+}
+
+/* run an operation on all handles and print its throughput */
+static void run_bench(bench_op_t op, unsigned int count)
+{
+  submitter_arg_t args[nb_submitters];
   struct timeval tv1, tv2, tv3, tvdiff;
-  int count, rc;
+  unsigned int i;
+  double t_submit, t_total;
+  const char *name = (op == BENCH_INSERT ? "inserted" : "deleted");
+
+  gettimeofday(&tv1, NULL);
+
+  for(i = 0; i < nb_submitters; i++)
+    {
+      args[i].first = (unsigned long long)nb_handles * i / nb_submitters;
+      args[i].last = (unsigned long long)nb_handles * (i + 1) / nb_submitters;
+      args[i].op = op;
+
+      if(pthread_create(&args[i].thr_id, NULL, submitter_thread, &args[i]))
+        {
+          LogTest("Error creating submitter thread");
+          exit(1);
+        }
+    }
+
+  for(i = 0; i < nb_submitters; i++)
+    {
+      pthread_join(args[i].thr_id, NULL);
+
+      if(args[i].rc)
+        {
+          LogTest("Error %d submitting operation", args[i].rc);
+          exit(args[i].rc);
+        }
+    }
+
+  gettimeofday(&tv2, NULL);
+
+  handlemap_db_flush();
+
+  gettimeofday(&tv3, NULL);
+
+  timersub(&tv2, &tv1, &tvdiff);
+  t_submit = tvdiff.tv_sec + tvdiff.tv_usec / 1000000.0;
+
+  LogTest("%u submitters %s %u handles in %d.%06ds (%.0f op/s)", nb_submitters,
+          name, nb_handles, (int)tvdiff.tv_sec, (int)tvdiff.tv_usec,
+          t_submit > 0 ? nb_handles / t_submit : 0.0);
+
+  timersub(&tv3, &tv1, &tvdiff);
+  t_total = tvdiff.tv_sec + tvdiff.tv_usec / 1000000.0;
+
+  LogTest("Total time with %u db threads (including flush): %d.%06ds (%.0f op/s)",
+          count, (int)tvdiff.tv_sec, (int)tvdiff.tv_usec,
+          t_total > 0 ? nb_handles / t_total : 0.0);
+}
+
+int main(int argc, char **argv)
+{
+  struct timeval tv1, tv2, tvdiff;
+  int count, rc, c;
   char *dir;
-  time_t now;
+  int synchronous = FALSE;
+  int keep = FALSE;
+
+  /* Init logging */
+  SetNamePgm("test_handle_mapping_db");
+  SetDefaultLogging("TEST");
+  SetNameFunction("main");
+  SetNameHost("localhost");
+  InitLogging();
+
+  while((c = getopt(argc, argv, "n:t:sk")) != -1)
+    {
+      switch (c)
+        {
+        case 'n':
+          nb_handles = atoi(optarg);
+          break;
+        case 't':
+          nb_submitters = atoi(optarg);
+          break;
+        case 's':
+          synchronous = TRUE;
+          break;
+        case 'k':
+          keep = TRUE;
+          break;
+        default:
+          optind = argc;
+        }
+    }
 
-  if(argc != 3 || (count = atoi(argv[2])) == 0)
+  if(argc - optind != 2 || (count = atoi(argv[optind + 1])) == 0
+     || nb_handles == 0 || nb_submitters == 0)
     {
-      LogTest("usage: test_handle_mapping <db_dir> <db_count>");
+      LogTest
+          ("usage: test_handle_mapping_db [-n <nb_handles>] [-t <nb_submitters>] [-s(ynchronous)] [-k(eep handles)] <db_dir> <db_count>");
       exit(1);
     }
 #ifndef _NO_BUDDY_SYSTEM
@@ -26,13 +187,7 @@ int main(int argc, char **argv)
     }
 #endif
 
-  dir = argv[1];
-
-  /* Init logging */
-  SetNamePgm("test_handle_mapping");
-  SetNameFileLog("/dev/tty");
-  SetNameFunction("main");
-  SetNameHost("localhost");
+  dir = argv[optind];
 
   /* count databases */
 
@@ -45,79 +200,36 @@ int main(int argc, char **argv)
       LogTest("Warning: incompatible thread count %d <> database count %d", count, rc);
     }
 
-  rc = handlemap_db_init(dir, "/tmp", count, 1024, FALSE);
+  rc = handlemap_db_init(dir, "/tmp", count, 1024, synchronous);
 
   LogTest("handlemap_db_init() = %d", rc);
   if(rc)
     exit(rc);
 
+  gettimeofday(&tv1, NULL);
+
   rc = handlemap_db_reaload_all(NULL);
 
-  LogTest("handlemap_db_reaload_all() = %d", rc);
+  gettimeofday(&tv2, NULL);
+  timersub(&tv2, &tv1, &tvdiff);
+
+  LogTest("handlemap_db_reaload_all() = %d in %d.%06ds with %u threads", rc,
+          (int)tvdiff.tv_sec, (int)tvdiff.tv_usec, count);
   if(rc)
     exit(rc);
 
-  gettimeofday(&tv1, NULL);
-
   /* Now insert a set of handles */
 
   now = time(NULL);
 
-  for(i = 0; i < 10000; i++)
-    {
-      nfs23_map_handle_t nfs23_digest;
-      fsal_handle_t handle;
+  run_bench(BENCH_INSERT, count);
 
-      memset(&handle, i, sizeof(fsal_handle_t));
-      nfs23_digest.object_id = 12345 + i;
-      nfs23_digest.handle_hash = (1999 * i + now) % 479001599;
-
-      rc = handlemap_db_insert(&nfs23_digest, &handle);
-      if(rc)
-        exit(rc);
-    }
-
-  gettimeofday(&tv2, NULL);
-
-  timersub(&tv2, &tv1, &tvdiff);
-
-  LogTest("%u threads inserted 10000 handles in %d.%06ds", count, (int)tvdiff.tv_sec,
-          (int)tvdiff.tv_usec);
-
-  rc = handlemap_db_flush();
-
-  gettimeofday(&tv3, NULL);
-
-  timersub(&tv3, &tv1, &tvdiff);
-  LogTest("Total time with %u threads (including flush): %d.%06ds", count,
-          (int)tvdiff.tv_sec, (int)tvdiff.tv_usec);
+  if(keep)
+    exit(0);
 
   LogTest("Now, delete operations");
 
-  for(i = 0; i < 10000; i++)
-    {
-      nfs23_map_handle_t nfs23_digest;
-
-      nfs23_digest.object_id = 12345 + i;
-      nfs23_digest.handle_hash = (1999 * i + now) % 479001599;
-
-      rc = handlemap_db_delete(&nfs23_digest);
-      if(rc)
-        exit(rc);
-    }
-
-  gettimeofday(&tv2, NULL);
-  timersub(&tv2, &tv3, &tvdiff);
-
-  LogTest("%u threads deleted 10000 handles in %d.%06ds", count, (int)tvdiff.tv_sec,
-          (int)tvdiff.tv_usec);
-
-  rc = handlemap_db_flush();
-
-  gettimeofday(&tv1, NULL);
-  timersub(&tv1, &tv3, &tvdiff);
-  LogTest("Delete time with %u threads (including flush): %d.%06ds", count,
-          (int)tvdiff.tv_sec, (int)tvdiff.tv_usec);
+  run_bench(BENCH_DELETE, count);
 
   exit(0);
 
@@ -178,6 +178,30 @@ cache_content_entry_t *cache_content_new_entry(cache_entry_t * pentry_inode,
       return NULL;
     }
 
+  if((status = cache_content_create_name(pfc_pentry->local_fs_entry.cache_path_dirty,
+                                         CACHE_CONTENT_DIRTY_FILE,
+                                         pcontext,
+                                         pentry_inode, pclient)) != CACHE_CONTENT_SUCCESS)
+    {
+      RELEASE_PREALLOC(pfc_pentry, pclient->pool_entry, next_alloc);
+
+      *pstatus = CACHE_CONTENT_ENTRY_EXISTS;
+
+      /* stat */
+      pclient->stat.func_stats.nb_err_retryable[CACHE_CONTENT_NEW_ENTRY] += 1;
+
+      LogEvent(COMPONENT_CACHE_CONTENT,
+                        "cache_content_new_entry: entry's dirty blocks pathname could not be created");
+
+      return NULL;
+    }
+
+  /* A renewed entry forgets its blocks, an entry from the pool has no bitmaps */
+  if(how == RENEW_ENTRY)
+    cache_content_blocks_release(pfc_pentry);
+  else
+    memset(&pfc_pentry->local_fs_entry.block_map, 0, sizeof(cache_content_block_map_t));
+
   LogDebug(COMPONENT_CACHE_CONTENT,
                     "added file content cache entry: Data=%s Index=%s",
                     pfc_pentry->local_fs_entry.cache_path_data,
@@ -242,6 +266,29 @@ cache_content_entry_t *cache_content_new_entry(cache_entry_t * pentry_inode,
     }
 
   /* if( how == ADD_ENTRY || how == RENEW_ENTRY ) */
+  /* Until the refresh, the data file is the whole content of the file */
+  if(how == RECOVER_ENTRY)
+    status = cache_content_blocks_recover(pfc_pentry);
+  else
+    status = cache_content_blocks_init(pfc_pentry, 0);
+
+  if(status != CACHE_CONTENT_SUCCESS)
+    {
+      cache_content_blocks_release(pfc_pentry);
+      RELEASE_PREALLOC(pfc_pentry, pclient->pool_entry, next_alloc);
+
+      *pstatus = status;
+
+      LogEvent(COMPONENT_CACHE_CONTENT,
+                        "cache_content_new_entry: dirty blocks of the entry could not be set, status=%u",
+                        status);
+
+      /* stat */
+      pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_NEW_ENTRY] += 1;
+
+      return NULL;
+    }
+
   /* Cache the data from FSAL if there are some */
   /* Add the entry to the related cache inode entry */
   pentry_inode->object.file.pentry_content = pfc_pentry;
@@ -258,6 +305,7 @@ cache_content_entry_t *cache_content_new_entry(cache_entry_t * pentry_inode,
 
       if(status != CACHE_CONTENT_SUCCESS)
         {
+          cache_content_blocks_release(pfc_pentry);
           RELEASE_PREALLOC(pfc_pentry, pclient->pool_entry, next_alloc);
 
           *pstatus = status;
@@ -0,0 +1,941 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    cache_content_blocks.c
+ * \brief   Management of the file content cache: tracking of the fetched and dirty blocks.
+ *
+ * cache_content_blocks.c : Management of the file content cache, tracking of the blocks.
+ *
+ * The data file of an entry is created sparse, with the size of the file in the FSAL. A block
+ * is read from the FSAL the first time it is accessed (a write needs only the blocks it
+ * covers partially), and the blocks which are written are marked as dirty. A flush writes
+ * the dirty blocks only, with FSAL_write.
+ *
+ * The bitmap of the dirty blocks is mirrored in the dirty file, beside the data file: after
+ * a crash, the blocks which were not fetched are holes in the data file and must not be
+ * copied back to the FSAL.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif                          /* _SOLARIS */
+
+#include "fsal.h"
+#include "LRU_List.h"
+#include "log_macros.h"
+#include "HashData.h"
+#include "HashTable.h"
+#include "cache_inode.h"
+#include "cache_content.h"
+#include "stuff_alloc.h"
+
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <sys/param.h>
+#include <errno.h>
+#include <string.h>
+
+#define BLOCK_ISSET( bitmap, i ) ( ( bitmap )[( i ) >> 3] &  ( 1 << ( ( i ) & 7 ) ) )
+#define BLOCK_SET( bitmap, i )   ( ( bitmap )[( i ) >> 3] |= ( 1 << ( ( i ) & 7 ) ) )
+#define BLOCK_CLR( bitmap, i )   ( ( bitmap )[( i ) >> 3] &= ~( 1 << ( ( i ) & 7 ) ) )
+
+#define BITMAP_LEN( nb_blocks ) ( ( ( nb_blocks ) + 7 ) >> 3 )
+
+/**
+ *
+ * cache_content_blocks_grow: makes the bitmaps of an entry describe at least nb_blocks blocks.
+ *
+ * @param pmap      [INOUT] the block map of the entry.
+ * @param nb_blocks [IN]    the number of blocks.
+ *
+ * @return 0 if successful, -1 otherwise.
+ *
+ */
+static int cache_content_blocks_grow(cache_content_block_map_t * pmap,
+                                     unsigned int nb_blocks)
+{
+  unsigned char *dirty;
+  unsigned char *valid;
+  unsigned int new_nb_blocks;
+  size_t old_len;
+
+  if(nb_blocks <= pmap->nb_blocks)
+    return 0;
+
+  /* Appending files grow by small steps, do not realloc at each of them */
+  new_nb_blocks = 2 * pmap->nb_blocks;
+  if(new_nb_blocks < nb_blocks)
+    new_nb_blocks = nb_blocks;
+
+  old_len = BITMAP_LEN(pmap->nb_blocks);
+
+  if((dirty = (unsigned char *)Mem_Realloc(pmap->dirty, BITMAP_LEN(new_nb_blocks))) == NULL)
+    return -1;
+  pmap->dirty = dirty;
+
+  if((valid = (unsigned char *)Mem_Realloc(pmap->valid, BITMAP_LEN(new_nb_blocks))) == NULL)
+    return -1;
+  pmap->valid = valid;
+
+  memset(dirty + old_len, 0, BITMAP_LEN(new_nb_blocks) - old_len);
+  memset(valid + old_len, 0, BITMAP_LEN(new_nb_blocks) - old_len);
+  pmap->nb_blocks = new_nb_blocks;
+
+  return 0;
+}                               /* cache_content_blocks_grow */
+
+/**
+ *
+ * cache_content_write_dirty_file: updates the dirty file of an entry.
+ *
+ * @param path    [IN] path to the dirty file.
+ * @param pheader [IN] the header to be written, NULL if unchanged.
+ * @param bitmap  [IN] the bitmap of the dirty blocks.
+ * @param from    [IN] first byte of the bitmap to be written.
+ * @param to      [IN] end of the bytes of the bitmap to be written.
+ * @param cut     [IN] should the file be truncated after the byte 'to' ?
+ *
+ * @return 0 if successful, -1 otherwise (errno is set).
+ *
+ */
+static int cache_content_write_dirty_file(char *path,
+                                          cache_content_dirty_header_t * pheader,
+                                          unsigned char *bitmap,
+                                          size_t from, size_t to, fsal_boolean_t cut)
+{
+  int fd;
+  int errsv;
+
+  if((fd = open(path, pheader != NULL ? O_WRONLY | O_CREAT : O_WRONLY, 0750)) == -1)
+    return -1;
+
+  if(pheader != NULL
+     && pwrite(fd, pheader, sizeof(cache_content_dirty_header_t), 0)
+     != sizeof(cache_content_dirty_header_t))
+    goto error;
+
+  if(to > from
+     && pwrite(fd, bitmap + from, to - from,
+               sizeof(cache_content_dirty_header_t) + from) != (ssize_t) (to - from))
+    goto error;
+
+  if(cut && ftruncate(fd, sizeof(cache_content_dirty_header_t) + to) != 0)
+    goto error;
+
+  close(fd);
+  return 0;
+
+ error:
+  errsv = (errno != 0) ? errno : EIO;
+  close(fd);
+  errno = errsv;
+  return -1;
+}                               /* cache_content_write_dirty_file */
+
+/**
+ *
+ * cache_content_write_blocks: writes the dirty blocks of a data file to the FSAL.
+ *
+ * @param pfsal_handle [IN]  the handle of the file in the FSAL.
+ * @param pcontext     [IN]  fsal credentials for the operation.
+ * @param local_fd     [IN]  the data file, opened for reading.
+ * @param pheader      [IN]  the truncation to be applied first.
+ * @param dirty        [IN]  the bitmap of the dirty blocks.
+ * @param nb_blocks    [IN]  the number of blocks in the bitmap.
+ * @param pflushed     [OUT] the number of bytes written.
+ *
+ * @return the status of the FSAL operations, ERR_FSAL_IO for a local error.
+ *
+ */
+static fsal_status_t cache_content_write_blocks(fsal_handle_t * pfsal_handle,
+                                                fsal_op_context_t * pcontext,
+                                                int local_fd,
+                                                cache_content_dirty_header_t * pheader,
+                                                unsigned char *dirty,
+                                                unsigned int nb_blocks,
+                                                fsal_size_t * pflushed)
+{
+  fsal_status_t fsal_status;
+  fsal_status_t close_status;
+  fsal_file_t fsal_fd;
+  fsal_seek_t seek;
+  fsal_size_t written;
+  fsal_size_t done;
+  struct stat buffstat;
+  caddr_t buffer;
+  unsigned int first;
+  unsigned int last;
+  off_t start;
+  off_t end;
+  ssize_t rc;
+
+  *pflushed = 0;
+
+  fsal_status.major = ERR_FSAL_NO_ERROR;
+  fsal_status.minor = 0;
+
+  if(fstat(local_fd, &buffstat) == -1)
+    {
+      fsal_status.major = ERR_FSAL_IO;
+      fsal_status.minor = errno;
+      return fsal_status;
+    }
+
+  /* Nothing to do if no block was written */
+  for(first = 0; first < BITMAP_LEN(nb_blocks); first++)
+    if(dirty[first] != 0)
+      break;
+
+  if(first == BITMAP_LEN(nb_blocks) && !pheader->truncated)
+    return fsal_status;
+
+  if((buffer = Mem_Alloc(CACHE_CONTENT_BLOCK_IO_MAX * CACHE_CONTENT_BLOCK_SIZE)) == NULL)
+    {
+      fsal_status.major = ERR_FSAL_NOMEM;
+      return fsal_status;
+    }
+
+  fsal_status = FSAL_open(pfsal_handle, pcontext, FSAL_O_WRONLY, &fsal_fd, NULL);
+  if(FSAL_IS_ERROR(fsal_status))
+    {
+      Mem_Free(buffer);
+      return fsal_status;
+    }
+
+  /* The data beyond the truncation must not come back when the file grows again */
+  if(pheader->truncated)
+    fsal_status = FSAL_truncate(pfsal_handle, pcontext,
+                                (fsal_size_t) pheader->truncate_size, &fsal_fd, NULL);
+
+  for(first = 0; !FSAL_IS_ERROR(fsal_status) && first < nb_blocks; first = last)
+    {
+      if(!BLOCK_ISSET(dirty, first))
+        {
+          last = first + 1;
+          continue;
+        }
+
+      /* Gather the contiguous dirty blocks in a single write */
+      for(last = first + 1;
+          last < nb_blocks && last - first < CACHE_CONTENT_BLOCK_IO_MAX
+          && BLOCK_ISSET(dirty, last); last++) ;
+
+      start = (off_t) first * CACHE_CONTENT_BLOCK_SIZE;
+      end = (off_t) last * CACHE_CONTENT_BLOCK_SIZE;
+      if(end > buffstat.st_size)
+        end = buffstat.st_size;
+      if(start >= end)
+        break;
+
+      if((rc = pread(local_fd, buffer, end - start, start)) != end - start)
+        {
+          fsal_status.major = ERR_FSAL_IO;
+          fsal_status.minor = (rc == -1) ? errno : 0;
+          break;
+        }
+
+      for(done = 0; done < (fsal_size_t) rc; done += written)
+        {
+          seek.whence = FSAL_SEEK_SET;
+          seek.offset = start + done;
+
+          fsal_status = FSAL_write(&fsal_fd, &seek, rc - done, buffer + done, &written);
+          if(FSAL_IS_ERROR(fsal_status))
+            break;
+
+          if(written == 0)
+            {
+              fsal_status.major = ERR_FSAL_IO;
+              fsal_status.minor = 0;
+              break;
+            }
+        }
+
+      *pflushed += done;
+    }
+
+  /* A file truncated then extended ends with a hole, which is never dirty */
+  if(!FSAL_IS_ERROR(fsal_status) && pheader->truncated
+     && (u_int64_t) buffstat.st_size > pheader->truncate_size)
+    fsal_status = FSAL_truncate(pfsal_handle, pcontext,
+                                (fsal_size_t) buffstat.st_size, &fsal_fd, NULL);
+
+  close_status = FSAL_close(&fsal_fd);
+  if(!FSAL_IS_ERROR(fsal_status))
+    fsal_status = close_status;
+
+  Mem_Free(buffer);
+
+  return fsal_status;
+}                               /* cache_content_write_blocks */
+
+/**
+ *
+ * cache_content_blocks_release: frees the bitmaps of an entry.
+ *
+ * @param pentry [INOUT] entry in file content layer.
+ *
+ * @return nothing (void function).
+ *
+ */
+void cache_content_blocks_release(cache_content_entry_t * pentry)
+{
+  cache_content_block_map_t *pmap = &pentry->local_fs_entry.block_map;
+
+  if(pmap->dirty != NULL)
+    Mem_Free(pmap->dirty);
+
+  if(pmap->valid != NULL)
+    Mem_Free(pmap->valid);
+
+  memset(pmap, 0, sizeof(cache_content_block_map_t));
+}                               /* cache_content_blocks_release */
+
+/**
+ *
+ * cache_content_blocks_init: starts the tracking of the blocks of an entry.
+ *
+ * Starts the tracking of the blocks of an entry whose data file was just truncated to the size
+ * of the file in the FSAL: none of its blocks was fetched nor written.
+ *
+ * @param pentry      [INOUT] entry in file content layer.
+ * @param fetch_limit [IN]    the blocks beyond this offset are never fetched from the FSAL.
+ *
+ * @return CACHE_CONTENT_SUCCESS if successful, CACHE_CONTENT_LOCAL_CACHE_ERROR otherwise.
+ *
+ */
+cache_content_status_t cache_content_blocks_init(cache_content_entry_t * pentry,
+                                                 off_t fetch_limit)
+{
+  cache_content_block_map_t *pmap = &pentry->local_fs_entry.block_map;
+
+  cache_content_blocks_release(pentry);
+
+  pmap->header.magic = CACHE_CONTENT_DIRTY_MAGIC;
+  pmap->header.block_size = CACHE_CONTENT_BLOCK_SIZE;
+
+#ifdef _CACHE_CONTENT_WHOLE_FILE
+  /* The whole file was copied to the data file, and will be copied back */
+  pmap->fetch_limit = 0;
+  pmap->flush_all = TRUE;
+
+  if(unlink(pentry->local_fs_entry.cache_path_dirty) != 0 && errno != ENOENT)
+    {
+      LogMajor(COMPONENT_CACHE_CONTENT,
+               "cache_content_blocks_init: can't unlink %s, errno=%u(%s)",
+               pentry->local_fs_entry.cache_path_dirty, errno, strerror(errno));
+      return CACHE_CONTENT_LOCAL_CACHE_ERROR;
+    }
+#else
+  pmap->fetch_limit = fetch_limit;
+  pmap->flush_all = FALSE;
+
+  if(cache_content_write_dirty_file(pentry->local_fs_entry.cache_path_dirty,
+                                    &pmap->header, NULL, 0, 0, TRUE) != 0)
+    {
+      LogMajor(COMPONENT_CACHE_CONTENT,
+               "cache_content_blocks_init: can't write %s, errno=%u(%s)",
+               pentry->local_fs_entry.cache_path_dirty, errno, strerror(errno));
+      return CACHE_CONTENT_LOCAL_CACHE_ERROR;
+    }
+#endif
+
+  return CACHE_CONTENT_SUCCESS;
+}                               /* cache_content_blocks_init */
+
+/**
+ *
+ * cache_content_blocks_recover: reloads the dirty blocks of an entry after a crash.
+ *
+ * The blocks which are not dirty are fetched again from the FSAL when accessed. An entry
+ * without dirty file was cached as a whole: it will be flushed as a whole.
+ *
+ * @param pentry [INOUT] entry in file content layer.
+ *
+ * @return CACHE_CONTENT_SUCCESS if successful, an error otherwise.
+ *
+ */
+cache_content_status_t cache_content_blocks_recover(cache_content_entry_t * pentry)
+{
+  cache_content_block_map_t *pmap = &pentry->local_fs_entry.block_map;
+  struct stat buffstat;
+  size_t len;
+  int fd;
+
+  cache_content_blocks_release(pentry);
+
+  if((fd = open(pentry->local_fs_entry.cache_path_dirty, O_RDONLY)) == -1)
+    {
+      if(errno != ENOENT)
+        return CACHE_CONTENT_LOCAL_CACHE_ERROR;
+
+      pmap->flush_all = TRUE;
+      return CACHE_CONTENT_SUCCESS;
+    }
+
+  if(fstat(fd, &buffstat) != 0
+     || buffstat.st_size < (off_t) sizeof(cache_content_dirty_header_t)
+     || read(fd, &pmap->header, sizeof(cache_content_dirty_header_t))
+     != sizeof(cache_content_dirty_header_t)
+     || pmap->header.magic != CACHE_CONTENT_DIRTY_MAGIC
+     || pmap->header.block_size != CACHE_CONTENT_BLOCK_SIZE)
+    {
+      close(fd);
+      LogCrit(COMPONENT_CACHE_CONTENT, "Dirty blocks file %s is corrupted",
+              pentry->local_fs_entry.cache_path_dirty);
+      return CACHE_CONTENT_LOCAL_CACHE_ERROR;
+    }
+
+  len = buffstat.st_size - sizeof(cache_content_dirty_header_t);
+
+  if(cache_content_blocks_grow(pmap, len * 8) != 0)
+    {
+      close(fd);
+      return CACHE_CONTENT_MALLOC_ERROR;
+    }
+
+  if(len > 0 && read(fd, pmap->dirty, len) != (ssize_t) len)
+    {
+      close(fd);
+      return CACHE_CONTENT_LOCAL_CACHE_ERROR;
+    }
+
+  close(fd);
+
+  /* The content of the dirty blocks is in the data file, the other ones are in the FSAL */
+  if(len > 0)
+    memcpy(pmap->valid, pmap->dirty, len);
+
+  if(stat(pentry->local_fs_entry.cache_path_data, &buffstat) != 0)
+    return CACHE_CONTENT_LOCAL_CACHE_ERROR;
+
+  pmap->fetch_limit = buffstat.st_size;
+  if(pmap->header.truncated && (off_t) pmap->header.truncate_size < pmap->fetch_limit)
+    pmap->fetch_limit = (off_t) pmap->header.truncate_size;
+
+  return CACHE_CONTENT_SUCCESS;
+}                               /* cache_content_blocks_recover */
+
+/**
+ *
+ * cache_content_block_needed: tells if a block must be fetched before an IO.
+ *
+ * @param pmap          [IN] the block map of the entry.
+ * @param block         [IN] the block.
+ * @param read_or_write [IN] the direction of the IO.
+ * @param offset        [IN] the beginning of the IO.
+ * @param end           [IN] the end of the IO.
+ *
+ * @return TRUE if the block is to be fetched, FALSE otherwise.
+ *
+ */
+static fsal_boolean_t cache_content_block_needed(cache_content_block_map_t * pmap,
+                                                 unsigned int block,
+                                                 cache_content_io_direction_t read_or_write,
+                                                 off_t offset, off_t end)
+{
+  off_t start = (off_t) block * CACHE_CONTENT_BLOCK_SIZE;
+
+  if(start >= pmap->fetch_limit || BLOCK_ISSET(pmap->valid, block))
+    return FALSE;
+
+  /* A block that is overwritten completely is not read */
+  if(read_or_write == CACHE_CONTENT_WRITE
+     && start >= offset && start + CACHE_CONTENT_BLOCK_SIZE <= end)
+    return FALSE;
+
+  return TRUE;
+}                               /* cache_content_block_needed */
+
+/**
+ *
+ * cache_content_blocks_fetch: reads from the FSAL the blocks needed by an IO.
+ *
+ * The data file must be opened (see cache_content_open). A read needs all the blocks in
+ * its range, a write needs only the blocks it covers partially.
+ *
+ * @param pentry        [INOUT] entry in file content layer.
+ * @param read_or_write [IN]    the direction of the IO.
+ * @param offset        [IN]    the beginning of the IO.
+ * @param length        [IN]    the size of the IO.
+ * @param pcontext      [IN]    fsal credentials for the operation.
+ * @param pstatus       [OUT]   returned status.
+ *
+ * @return CACHE_CONTENT_SUCCESS if successful, an error otherwise.
+ *
+ */
+cache_content_status_t cache_content_blocks_fetch(cache_content_entry_t * pentry,
+                                                  cache_content_io_direction_t read_or_write,
+                                                  off_t offset,
+                                                  size_t length,
+                                                  fsal_op_context_t * pcontext,
+                                                  cache_content_status_t * pstatus)
+{
+  cache_content_block_map_t *pmap = &pentry->local_fs_entry.block_map;
+  fsal_handle_t *pfsal_handle = NULL;
+  cache_inode_status_t cache_inode_status;
+  fsal_status_t fsal_status;
+  fsal_file_t fsal_fd;
+  fsal_boolean_t opened = FALSE;
+  fsal_boolean_t eof;
+  fsal_seek_t seek;
+  fsal_size_t read_amount;
+  fsal_size_t done;
+  caddr_t buffer = NULL;
+  unsigned int block;
+  unsigned int next;
+  unsigned int last;
+  off_t end;
+  off_t start;
+  off_t stop;
+
+  *pstatus = CACHE_CONTENT_SUCCESS;
+
+  if(length == 0)
+    return *pstatus;
+
+  end = offset + length;
+  block = offset / CACHE_CONTENT_BLOCK_SIZE;
+  last = (end - 1) / CACHE_CONTENT_BLOCK_SIZE;
+
+  /* An append may still need the end of the last block of the file */
+  if((off_t) block * CACHE_CONTENT_BLOCK_SIZE >= pmap->fetch_limit)
+    return *pstatus;
+
+  if(cache_content_blocks_grow(pmap, last + 1) != 0)
+    {
+      *pstatus = CACHE_CONTENT_MALLOC_ERROR;
+      return *pstatus;
+    }
+
+  for(; block <= last; block = next)
+    {
+      next = block + 1;
+
+      if(!cache_content_block_needed(pmap, block, read_or_write, offset, end))
+        continue;
+
+      while(next <= last && next - block < CACHE_CONTENT_BLOCK_IO_MAX
+            && cache_content_block_needed(pmap, next, read_or_write, offset, end))
+        next++;
+
+      if(!opened)
+        {
+          if((pfsal_handle =
+              cache_inode_get_fsal_handle(pentry->pentry_inode,
+                                          &cache_inode_status)) == NULL)
+            {
+              *pstatus = CACHE_CONTENT_BAD_CACHE_INODE_ENTRY;
+              break;
+            }
+
+          if((buffer =
+              Mem_Alloc(CACHE_CONTENT_BLOCK_IO_MAX * CACHE_CONTENT_BLOCK_SIZE)) == NULL)
+            {
+              *pstatus = CACHE_CONTENT_MALLOC_ERROR;
+              break;
+            }
+
+          fsal_status = FSAL_open(pfsal_handle, pcontext, FSAL_O_RDONLY, &fsal_fd, NULL);
+          if(FSAL_IS_ERROR(fsal_status))
+            {
+              LogMajor(COMPONENT_CACHE_CONTENT,
+                       "Error %d,%d from FSAL_open when fetching blocks of %s",
+                       fsal_status.major, fsal_status.minor,
+                       pentry->local_fs_entry.cache_path_data);
+              *pstatus = CACHE_CONTENT_FSAL_ERROR;
+              break;
+            }
+
+          opened = TRUE;
+        }
+
+      start = (off_t) block * CACHE_CONTENT_BLOCK_SIZE;
+      stop = (off_t) next * CACHE_CONTENT_BLOCK_SIZE;
+      if(stop > pmap->fetch_limit)
+        stop = pmap->fetch_limit;
+
+      for(done = 0; done < (fsal_size_t) (stop - start); done += read_amount)
+        {
+          seek.whence = FSAL_SEEK_SET;
+          seek.offset = start + done;
+
+          fsal_status = FSAL_read(&fsal_fd, &seek, (stop - start) - done, buffer + done,
+                                  &read_amount, &eof);
+          if(FSAL_IS_ERROR(fsal_status))
+            {
+              LogMajor(COMPONENT_CACHE_CONTENT,
+                       "Error %d,%d from FSAL_read when fetching blocks of %s",
+                       fsal_status.major, fsal_status.minor,
+                       pentry->local_fs_entry.cache_path_data);
+              *pstatus = CACHE_CONTENT_FSAL_ERROR;
+              break;
+            }
+
+          /* The file is shorter in the FSAL: the rest of the blocks is a hole */
+          if(eof || read_amount == 0)
+            {
+              done += read_amount;
+              break;
+            }
+        }
+
+      if(*pstatus != CACHE_CONTENT_SUCCESS)
+        break;
+
+      if(done > 0
+         && pwrite(pentry->local_fs_entry.opened_file.local_fd, buffer, done,
+                   start) != (ssize_t) done)
+        {
+          LogMajor(COMPONENT_CACHE_CONTENT,
+                   "Can't write fetched blocks to %s, errno=%u(%s)",
+                   pentry->local_fs_entry.cache_path_data, errno, strerror(errno));
+          *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
+          break;
+        }
+
+      LogFullDebug(COMPONENT_CACHE_CONTENT,
+                   "Fetched blocks %u to %u (%llu bytes) of %s", block, next - 1,
+                   (unsigned long long)done, pentry->local_fs_entry.cache_path_data);
+
+      for(; block < next; block++)
+        BLOCK_SET(pmap->valid, block);
+    }
+
+  if(opened)
+    FSAL_close(&fsal_fd);
+
+  if(buffer != NULL)
+    Mem_Free(buffer);
+
+  return *pstatus;
+}                               /* cache_content_blocks_fetch */
+
+/**
+ *
+ * cache_content_blocks_set_dirty: marks the blocks of a write as dirty.
+ *
+ * @param pentry  [INOUT] entry in file content layer.
+ * @param offset  [IN]    the beginning of the write.
+ * @param length  [IN]    the size of the write.
+ * @param pstatus [OUT]   returned status.
+ *
+ * @return CACHE_CONTENT_SUCCESS if successful, an error otherwise.
+ *
+ */
+cache_content_status_t cache_content_blocks_set_dirty(cache_content_entry_t * pentry,
+                                                      off_t offset, size_t length,
+                                                      cache_content_status_t * pstatus)
+{
+  cache_content_block_map_t *pmap = &pentry->local_fs_entry.block_map;
+  unsigned int block;
+  unsigned int last;
+  size_t from = 0;
+  size_t to = 0;
+
+  *pstatus = CACHE_CONTENT_SUCCESS;
+
+  if(length == 0 || pmap->flush_all)
+    return *pstatus;
+
+  block = offset / CACHE_CONTENT_BLOCK_SIZE;
+  last = (offset + length - 1) / CACHE_CONTENT_BLOCK_SIZE;
+
+  if(cache_content_blocks_grow(pmap, last + 1) != 0)
+    {
+      *pstatus = CACHE_CONTENT_MALLOC_ERROR;
+      return *pstatus;
+    }
+
+  for(; block <= last; block++)
+    {
+      BLOCK_SET(pmap->valid, block);
+
+      if(BLOCK_ISSET(pmap->dirty, block))
+        continue;
+
+      BLOCK_SET(pmap->dirty, block);
+
+      /* Keep the range of bytes of the bitmap which changed */
+      if(to == 0)
+        from = block >> 3;
+      to = (block >> 3) + 1;
+    }
+
+  /* The dirty file is only written when a block becomes dirty */
+  if(to != 0
+     && cache_content_write_dirty_file(pentry->local_fs_entry.cache_path_dirty, NULL,
+                                       pmap->dirty, from, to, FALSE) != 0)
+    {
+      LogMajor(COMPONENT_CACHE_CONTENT,
+               "Can't write dirty blocks to %s, errno=%u(%s)",
+               pentry->local_fs_entry.cache_path_dirty, errno, strerror(errno));
+      *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
+    }
+
+  return *pstatus;
+}                               /* cache_content_blocks_set_dirty */
+
+/**
+ *
+ * cache_content_blocks_truncate: updates the blocks of an entry after a truncate.
+ *
+ * @param pentry  [INOUT] entry in file content layer.
+ * @param length  [IN]    the new size of the data file.
+ * @param pstatus [OUT]   returned status.
+ *
+ * @return CACHE_CONTENT_SUCCESS if successful, an error otherwise.
+ *
+ */
+cache_content_status_t cache_content_blocks_truncate(cache_content_entry_t * pentry,
+                                                     off_t length,
+                                                     cache_content_status_t * pstatus)
+{
+  cache_content_block_map_t *pmap = &pentry->local_fs_entry.block_map;
+  unsigned int block;
+  unsigned int nb_blocks;
+
+  *pstatus = CACHE_CONTENT_SUCCESS;
+
+  if(pmap->flush_all)
+    return *pstatus;
+
+  /* The FSAL still has the data beyond the truncation, until the next flush */
+  if(length < pmap->fetch_limit)
+    pmap->fetch_limit = length;
+
+  if(!pmap->header.truncated || (u_int64_t) length < pmap->header.truncate_size)
+    {
+      pmap->header.truncated = TRUE;
+      pmap->header.truncate_size = (u_int64_t) length;
+    }
+
+  /* The blocks beyond the new end of the file are not dirty any more */
+  nb_blocks = (length + CACHE_CONTENT_BLOCK_SIZE - 1) / CACHE_CONTENT_BLOCK_SIZE;
+
+  for(block = nb_blocks; block < pmap->nb_blocks && (block & 7) != 0; block++)
+    BLOCK_CLR(pmap->dirty, block);
+
+  if(block < pmap->nb_blocks)
+    memset(pmap->dirty + (block >> 3), 0,
+           BITMAP_LEN(pmap->nb_blocks) - (block >> 3));
+
+  if(nb_blocks > pmap->nb_blocks)
+    nb_blocks = pmap->nb_blocks;
+
+  if(cache_content_write_dirty_file(pentry->local_fs_entry.cache_path_dirty,
+                                    &pmap->header, pmap->dirty, 0,
+                                    BITMAP_LEN(nb_blocks), TRUE) != 0)
+    {
+      LogMajor(COMPONENT_CACHE_CONTENT,
+               "Can't write dirty blocks to %s, errno=%u(%s)",
+               pentry->local_fs_entry.cache_path_dirty, errno, strerror(errno));
+      *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
+    }
+
+  return *pstatus;
+}                               /* cache_content_blocks_truncate */
+
+/**
+ *
+ * cache_content_blocks_flush: writes the dirty blocks of an entry to the FSAL.
+ *
+ * @param pentry   [INOUT] entry in file content layer.
+ * @param pcontext [IN]    fsal credentials for the operation.
+ * @param pflushed [OUT]   the number of bytes written to the FSAL.
+ * @param pstatus  [OUT]   returned status.
+ *
+ * @return CACHE_CONTENT_SUCCESS if successful, an error otherwise.
+ *
+ */
+cache_content_status_t cache_content_blocks_flush(cache_content_entry_t * pentry,
+                                                  fsal_op_context_t * pcontext,
+                                                  fsal_size_t * pflushed,
+                                                  cache_content_status_t * pstatus)
+{
+  cache_content_block_map_t *pmap = &pentry->local_fs_entry.block_map;
+  fsal_handle_t *pfsal_handle = NULL;
+  cache_inode_status_t cache_inode_status;
+  fsal_status_t fsal_status;
+  int local_fd;
+
+  *pstatus = CACHE_CONTENT_SUCCESS;
+  *pflushed = 0;
+
+  if((pfsal_handle =
+      cache_inode_get_fsal_handle(pentry->pentry_inode, &cache_inode_status)) == NULL)
+    {
+      *pstatus = CACHE_CONTENT_BAD_CACHE_INODE_ENTRY;
+      return *pstatus;
+    }
+
+  if((local_fd = open(pentry->local_fs_entry.cache_path_data, O_RDONLY)) == -1)
+    {
+      *pstatus = (errno == ENOENT) ? CACHE_CONTENT_LOCAL_CACHE_NOT_FOUND
+          : CACHE_CONTENT_LOCAL_CACHE_ERROR;
+      return *pstatus;
+    }
+
+  fsal_status = cache_content_write_blocks(pfsal_handle, pcontext, local_fd,
+                                           &pmap->header, pmap->dirty, pmap->nb_blocks,
+                                           pflushed);
+  close(local_fd);
+
+  if(FSAL_IS_ERROR(fsal_status))
+    {
+      LogMajor(COMPONENT_CACHE_CONTENT,
+               "Error %d,%d when flushing the dirty blocks of %s", fsal_status.major,
+               fsal_status.minor, pentry->local_fs_entry.cache_path_data);
+      *pstatus = CACHE_CONTENT_FSAL_ERROR;
+      return *pstatus;
+    }
+
+  if(pmap->dirty != NULL)
+    memset(pmap->dirty, 0, BITMAP_LEN(pmap->nb_blocks));
+
+  pmap->header.truncated = FALSE;
+  pmap->header.truncate_size = 0;
+
+  if(cache_content_write_dirty_file(pentry->local_fs_entry.cache_path_dirty,
+                                    &pmap->header, NULL, 0, 0, TRUE) != 0)
+    {
+      LogMajor(COMPONENT_CACHE_CONTENT,
+               "Can't write dirty blocks to %s, errno=%u(%s)",
+               pentry->local_fs_entry.cache_path_dirty, errno, strerror(errno));
+      *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
+    }
+
+  return *pstatus;
+}                               /* cache_content_blocks_flush */
+
+/**
+ *
+ * cache_content_flush_dirty_file: writes the dirty blocks of a data file to the FSAL.
+ *
+ * This is used for the files in the data cache which have no entry in memory.
+ *
+ * @param pfsal_handle [IN]  the handle of the file in the FSAL.
+ * @param pcontext     [IN]  fsal credentials for the operation.
+ * @param datapath     [IN]  path to the data file.
+ * @param dirtypath    [IN]  path to the dirty file.
+ * @param pflushed     [OUT] the number of bytes written to the FSAL.
+ *
+ * @return the status of the FSAL operations, ERR_FSAL_IO for a local error.
+ *
+ */
+fsal_status_t cache_content_flush_dirty_file(fsal_handle_t * pfsal_handle,
+                                             fsal_op_context_t * pcontext,
+                                             char *datapath, char *dirtypath,
+                                             fsal_size_t * pflushed)
+{
+  cache_content_dirty_header_t header;
+  fsal_status_t fsal_status;
+  struct stat buffstat;
+  unsigned char *dirty = NULL;
+  size_t len = 0;
+  int local_fd;
+  int fd;
+
+  *pflushed = 0;
+
+  fsal_status.major = ERR_FSAL_IO;
+  fsal_status.minor = 0;
+
+  if((fd = open(dirtypath, O_RDONLY)) == -1)
+    {
+      fsal_status.minor = errno;
+      return fsal_status;
+    }
+
+  if(fstat(fd, &buffstat) != 0
+     || buffstat.st_size < (off_t) sizeof(cache_content_dirty_header_t)
+     || read(fd, &header, sizeof(header)) != sizeof(header)
+     || header.magic != CACHE_CONTENT_DIRTY_MAGIC
+     || header.block_size != CACHE_CONTENT_BLOCK_SIZE)
+    {
+      close(fd);
+      LogCrit(COMPONENT_CACHE_CONTENT, "Dirty blocks file %s is corrupted", dirtypath);
+      return fsal_status;
+    }
+
+  len = buffstat.st_size - sizeof(cache_content_dirty_header_t);
+
+  if(len > 0)
+    {
+      if((dirty = (unsigned char *)Mem_Alloc(len)) == NULL)
+        {
+          close(fd);
+          fsal_status.major = ERR_FSAL_NOMEM;
+          return fsal_status;
+        }
+
+      if(read(fd, dirty, len) != (ssize_t) len)
+        {
+          fsal_status.minor = errno;
+          close(fd);
+          Mem_Free(dirty);
+          return fsal_status;
+        }
+    }
+
+  close(fd);
+
+  if((local_fd = open(datapath, O_RDONLY)) == -1)
+    {
+      fsal_status.minor = errno;
+      if(dirty != NULL)
+        Mem_Free(dirty);
+      return fsal_status;
+    }
+
+  fsal_status = cache_content_write_blocks(pfsal_handle, pcontext, local_fd, &header,
+                                           dirty, len * 8, pflushed);
+  close(local_fd);
+
+  if(dirty != NULL)
+    Mem_Free(dirty);
+
+  if(FSAL_IS_ERROR(fsal_status))
+    return fsal_status;
+
+  /* The file is clean now */
+  header.truncated = FALSE;
+  header.truncate_size = 0;
+
+  if(cache_content_write_dirty_file(dirtypath, &header, NULL, 0, 0, TRUE) != 0)
+    {
+      fsal_status.major = ERR_FSAL_IO;
+      fsal_status.minor = errno;
+    }
+
+  return fsal_status;
+}                               /* cache_content_flush_dirty_file */
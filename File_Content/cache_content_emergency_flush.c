@@ -123,6 +123,8 @@ cache_content_status_t cache_content_emergency_flush(char *cachedir,
   int inum;
   char indexpath[MAXPATHLEN];
   char datapath[MAXPATHLEN];
+  char dirtypath[MAXPATHLEN];
+  fsal_size_t flushed;
   fsal_path_t fsal_path;
   fsal_mdsize_t strsize = MAXPATHLEN + 1;
   struct stat buffstat;
@@ -239,6 +241,7 @@ cache_content_status_t cache_content_emergency_flush(char *cachedir,
           fclose(stream);
 
           cache_content_get_datapath(cachedir, inum, datapath);
+          cache_content_get_dirtypath(cachedir, inum, dirtypath);
 
           /* Stat the data file to now if it is eligible or not */
           if(stat(datapath, &buffstat) == -1)
@@ -295,8 +298,13 @@ cache_content_status_t cache_content_emergency_flush(char *cachedir,
 #else
           if(!FSAL_IS_ERROR(fsal_status))
             {
-              fsal_status = FSAL_rcp(&fsal_handle,
-                                     pcontext, &fsal_path, FSAL_RCP_LOCAL_TO_FS);
+              /* The blocks which were never fetched are holes, only the dirty ones are flushed */
+              if(access(dirtypath, F_OK) == 0)
+                fsal_status = cache_content_flush_dirty_file(&fsal_handle, pcontext,
+                                                             datapath, dirtypath, &flushed);
+              else
+                fsal_status = FSAL_rcp(&fsal_handle,
+                                       pcontext, &fsal_path, FSAL_RCP_LOCAL_TO_FS);
             }
 #endif
 
@@ -328,6 +336,14 @@ cache_content_status_t cache_content_emergency_flush(char *cachedir,
                                  errno, strerror(errno));
                       return CACHE_CONTENT_LOCAL_CACHE_ERROR;
                     }
+
+                  /* Remove the dirty blocks file, if any */
+                  if(unlink(dirtypath) && errno != ENOENT)
+                    {
+                      LogCrit(COMPONENT_CACHE_CONTENT,"Can't unlink dirty blocks %s, errno=%u(%s)", dirtypath,
+                                 errno, strerror(errno));
+                      return CACHE_CONTENT_LOCAL_CACHE_ERROR;
+                    }
                 }
               else
                 {
@@ -365,6 +381,14 @@ cache_content_status_t cache_content_emergency_flush(char *cachedir,
                                  errno, strerror(errno));
                       return CACHE_CONTENT_LOCAL_CACHE_ERROR;
                     }
+
+                  /* Remove the dirty blocks file, if any */
+                  if(unlink(dirtypath) && errno != ENOENT)
+                    {
+                      LogCrit(COMPONENT_CACHE_CONTENT,"Can't unlink dirty blocks %s, errno=%u(%s)", dirtypath,
+                                 errno, strerror(errno));
+                      return CACHE_CONTENT_LOCAL_CACHE_ERROR;
+                    }
                   break;
 
                 case CACHE_CONTENT_FLUSH_SYNC_ONLY:
@@ -62,6 +62,8 @@
  * cache_content_flush: Flushes the content of a file in the local cache to the FSAL data. 
  *
  * Flushes the content of a file in the local cache to the FSAL data. 
+ * Only the blocks written since the last flush are sent to the FSAL, unless the blocks of the entry
+ * are not tracked (see cache_content_blocks.c): then the whole file is copied.
  * This routine should be called only from the cache_inode layer. 
  *
  * No lock management is done in this layer: the related pentry in the cache inode layer is 
@@ -85,6 +87,7 @@ cache_content_status_t cache_content_flush(cache_content_entry_t * pentry,
   fsal_status_t fsal_status;
   cache_inode_status_t cache_inode_status;
   fsal_path_t local_path;
+  fsal_size_t flushed;
   cache_entry_t *pentry_inode = NULL;
 
   /* Get the related cache inode entry */
@@ -112,54 +115,75 @@ cache_content_status_t cache_content_flush(cache_content_entry_t * pentry,
   /* Lock related Cache Inode pentry to avoid concurrency while read/write operation */
   P_w(&pentry->pentry_inode->lock);
 
-  /* Convert the path to FSAL path */
-  fsal_status =
-      FSAL_str2path(pentry->local_fs_entry.cache_path_data, MAXPATHLEN, &local_path);
-
-  if(FSAL_IS_ERROR(fsal_status))
+  if(!pentry->local_fs_entry.block_map.flush_all)
     {
-      *pstatus = CACHE_CONTENT_FSAL_ERROR;
+      /* Write only the blocks modified since the last flush */
+      if(cache_content_blocks_flush(pentry, pcontext, &flushed, pstatus) !=
+         CACHE_CONTENT_SUCCESS)
+        {
+          /* Unlock related Cache Inode pentry */
+          V_w(&pentry->pentry_inode->lock);
 
-      /* Unlock related Cache Inode pentry */
-      V_w(&pentry->pentry_inode->lock);
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_FLUSH] += 1;
 
-      /* stat */
-      pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_FLUSH] += 1;
+          return *pstatus;
+        }
 
-      return *pstatus;
+      LogFullDebug(COMPONENT_CACHE_CONTENT, "Flushed %llu bytes of %s",
+                   (unsigned long long)flushed, pentry->local_fs_entry.cache_path_data);
     }
+  else
+    {
+      /* Convert the path to FSAL path */
+      fsal_status =
+          FSAL_str2path(pentry->local_fs_entry.cache_path_data, MAXPATHLEN, &local_path);
+
+      if(FSAL_IS_ERROR(fsal_status))
+        {
+          *pstatus = CACHE_CONTENT_FSAL_ERROR;
+
+          /* Unlock related Cache Inode pentry */
+          V_w(&pentry->pentry_inode->lock);
+
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_FLUSH] += 1;
+
+          return *pstatus;
+        }
 #if ( defined( _USE_PROXY ) && defined( _BY_NAME) )
-  fsal_status =
-      FSAL_rcp_by_name(&
-                       (pentry_inode->object.file.pentry_parent_open->object.dir_begin.
-                        handle), pentry_inode->object.file.pname, pcontext, &local_path,
-                       FSAL_RCP_LOCAL_TO_FS);
+      fsal_status =
+          FSAL_rcp_by_name(&
+                           (pentry_inode->object.file.pentry_parent_open->object.dir_begin.
+                            handle), pentry_inode->object.file.pname, pcontext, &local_path,
+                           FSAL_RCP_LOCAL_TO_FS);
 #else
-  /* Write the data from the local data file to the fs file */
-  fsal_status = FSAL_rcp(pfsal_handle, pcontext, &local_path, FSAL_RCP_LOCAL_TO_FS);
+      /* Write the data from the local data file to the fs file */
+      fsal_status = FSAL_rcp(pfsal_handle, pcontext, &local_path, FSAL_RCP_LOCAL_TO_FS);
 #endif
 
-  if(FSAL_IS_ERROR(fsal_status))
-    {
+      if(FSAL_IS_ERROR(fsal_status))
+        {
 #if ( defined( _USE_PROXY ) && defined( _BY_NAME) )
-      LogMajor(COMPONENT_CACHE_CONTENT, 
-                        "Error %d,%d from FSAL_rcp_by_name when flushing file",
-                        fsal_status.major, fsal_status.minor);
+          LogMajor(COMPONENT_CACHE_CONTENT, 
+                            "Error %d,%d from FSAL_rcp_by_name when flushing file",
+                            fsal_status.major, fsal_status.minor);
 #else
-      LogMajor(COMPONENT_CACHE_CONTENT,
-                        "Error %d,%d from FSAL_rcp when flushing file", fsal_status.major,
-                        fsal_status.minor);
+          LogMajor(COMPONENT_CACHE_CONTENT,
+                            "Error %d,%d from FSAL_rcp when flushing file", fsal_status.major,
+                            fsal_status.minor);
 #endif
 
-      /* Unlock related Cache Inode pentry */
-      V_w(&pentry->pentry_inode->lock);
+          /* Unlock related Cache Inode pentry */
+          V_w(&pentry->pentry_inode->lock);
 
-      *pstatus = CACHE_CONTENT_FSAL_ERROR;
+          *pstatus = CACHE_CONTENT_FSAL_ERROR;
 
-      /* stat */
-      pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_FLUSH] += 1;
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_FLUSH] += 1;
 
-      return *pstatus;
+          return *pstatus;
+        }
     }
 
   /* To delete or not to delete ? That is the question ... */
@@ -188,6 +212,18 @@ cache_content_status_t cache_content_flush(cache_content_entry_t * pentry,
           *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
           return *pstatus;
         }
+
+      /* Remove the dirty blocks file from the data cache */
+      if(unlink(pentry->local_fs_entry.cache_path_dirty) && errno != ENOENT)
+        {
+          /* Unlock related Cache Inode pentry */
+          V_w(&pentry->pentry_inode->lock);
+
+          LogCrit(COMPONENT_CACHE_CONTENT, "Can't unlink flushed dirty blocks %s, errno=%u(%s)",
+                     pentry->local_fs_entry.cache_path_dirty, errno, strerror(errno));
+          *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
+          return *pstatus;
+        }
     }
 
   /* Unlock related Cache Inode pentry */
@@ -208,6 +244,7 @@ cache_content_status_t cache_content_flush(cache_content_entry_t * pentry,
  * cache_content_refresh: Refreshes the whole content of a file in the local cache to the FSAL data. 
  *
  * Refreshes the whole content of a file in the local cache to the FSAL data.
+ * The data file is only resized: its blocks are read from the FSAL when they are accessed.
  * This routine should be called only from the cache_inode layer. 
  *
  * No lock management is done in this layer: the related pentry in the cache inode layer is 
@@ -233,6 +270,10 @@ cache_content_status_t cache_content_refresh(cache_content_entry_t * pentry,
   cache_entry_t *pentry_inode = NULL;
   fsal_path_t local_path;
   struct stat buffstat;
+#ifndef _CACHE_CONTENT_WHOLE_FILE
+  fsal_attrib_list_t fsal_attr;
+#endif
+  off_t fetch_limit;
 
   *pstatus = CACHE_CONTENT_SUCCESS;
 
@@ -307,6 +348,7 @@ cache_content_status_t cache_content_refresh(cache_content_entry_t * pentry,
     }
   else
     {
+#ifdef _CACHE_CONTENT_WHOLE_FILE
 #if ( defined( _USE_PROXY ) && defined( _BY_NAME) )
       fsal_status =
           FSAL_rcp_by_name(&
@@ -339,6 +381,56 @@ cache_content_status_t cache_content_refresh(cache_content_entry_t * pentry,
           return *pstatus;
         }
 
+      fetch_limit = 0;
+#else
+      /* Only the size is read now, the blocks are read from the FSAL when accessed */
+      fsal_attr.asked_attributes = FSAL_ATTR_SIZE;
+      fsal_status = FSAL_getattrs(pfsal_handle, pcontext, &fsal_attr);
+
+      if(FSAL_IS_ERROR(fsal_status))
+        {
+          *pstatus = CACHE_CONTENT_FSAL_ERROR;
+
+          LogMajor(COMPONENT_CACHE_CONTENT,
+                            "FSAL_getattrs failed for %s: fsal_status.major=%u fsal_status.minor=%u",
+                            pentry->local_fs_entry.cache_path_data, fsal_status.major,
+                            fsal_status.minor);
+
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_REFRESH] += 1;
+
+          return *pstatus;
+        }
+
+      /* Drop the former content, the data file is a hole as large as the file */
+      if(truncate(pentry->local_fs_entry.cache_path_data, 0) != 0 ||
+         truncate(pentry->local_fs_entry.cache_path_data, (off_t) fsal_attr.filesize) != 0)
+        {
+          *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
+
+          LogMajor(COMPONENT_CACHE_CONTENT,
+                            "cache_content_refresh: can't truncate %s, errno=%u(%s)",
+                            pentry->local_fs_entry.cache_path_data, errno, strerror(errno));
+
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_REFRESH] += 1;
+
+          return *pstatus;
+        }
+
+      fetch_limit = (off_t) fsal_attr.filesize;
+#endif
+
+      if(cache_content_blocks_init(pentry, fetch_limit) != CACHE_CONTENT_SUCCESS)
+        {
+          *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
+
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[CACHE_CONTENT_REFRESH] += 1;
+
+          return *pstatus;
+        }
+
       /* Exit the function with no error */
       pclient->stat.func_stats.nb_success[CACHE_CONTENT_REFRESH] += 1;
 
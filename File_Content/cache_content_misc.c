@@ -172,6 +172,11 @@ cache_content_status_t cache_content_create_name(char *path,
                (unsigned long long)fileid4);
       break;
 
+    case CACHE_CONTENT_DIRTY_FILE:
+      snprintf(path, MAXPATHLEN, "%s/node=%llx.dirty", entrydir,
+               (unsigned long long)fileid4);
+      break;
+
     case CACHE_CONTENT_DIR:
       snprintf(path, MAXPATHLEN, "%s/export_id=%d", pclient->cache_dir, 0);
       break;
@@ -270,6 +275,32 @@ int cache_content_get_datapath(char *basepath, u_int64_t inum, char *datapath)
   return 0;
 }                               /* cache_content_get_datapath */
 
+/**
+ *
+ * cache_content_get_dirtypath :
+ * recovers the path for the dirty blocks of a file of a specified inum.
+ *
+ * @param basepath  [IN] path to the root of the directory in the cache for the related export entry
+ * @param inum      [IN] inode number for the file.
+ * @param dirtypath [OUT] the absolute path of the file (must be at least a MAXPATHLEN length string).
+ *
+ * @return 0 if OK, or -1 is failed.
+ *
+ */
+
+int cache_content_get_dirtypath(char *basepath, u_int64_t inum, char *dirtypath)
+{
+  short hash_val;
+
+  hash_val = HashFileID4(inum);
+
+  snprintf(dirtypath, MAXPATHLEN, "%s/%02hhX/%02hhX/node=%llx.dirty", basepath,
+           (char)((hash_val) & 0xFF),
+           (char)((hash_val >> 8) & 0xFF), (unsigned long long)inum);
+
+  return 0;
+}                               /* cache_content_get_dirtypath */
+
 /**
  *
  * cache_content_recover_size: recovers the size of a data cached file. 
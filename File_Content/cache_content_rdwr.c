@@ -222,8 +222,6 @@ cache_content_status_t cache_content_rdwr(cache_content_entry_t * pentry,
   size_t iosize_before;
   ssize_t iosize_after;
   struct stat buffstat;
-  int rc;
-  char c;
 
   *pstatus = CACHE_CONTENT_SUCCESS;
 
@@ -317,7 +315,17 @@ cache_content_status_t cache_content_rdwr(cache_content_entry_t * pentry,
   switch (read_or_write)
     {
     case CACHE_CONTENT_READ:
-      /* The file content was completely read before the IO. The read operation is fully done locally */
+      /* Get the blocks of the IO which were not read from the FSAL yet */
+      if(cache_content_blocks_fetch(pentry, CACHE_CONTENT_READ, offset, iosize_before,
+                                    pcontext, pstatus) != CACHE_CONTENT_SUCCESS)
+        {
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[statindex] += 1;
+
+          return *pstatus;
+        }
+
+      /* The read operation is now fully done locally */
       if((iosize_after =
           pread(pentry->local_fs_entry.opened_file.local_fd, buffer, iosize_before,
                 offset)) == -1)
@@ -337,21 +345,20 @@ cache_content_status_t cache_content_rdwr(cache_content_entry_t * pentry,
           return *pstatus;
         }
 
-      /* Get the eof */
-      if(iosize_after == 0)
-        *p_fsal_eof = TRUE;
-      else
-        {
-          rc = pread(pentry->local_fs_entry.opened_file.local_fd, &c, 1,
-                     offset + iosize_before);
-          if(rc == 0)
-            *p_fsal_eof = TRUE;
-          else
-            *p_fsal_eof = FALSE;
-        }
+      /* The eof is known from the size of the local file, once it is stat'ed below */
       break;
 
     case CACHE_CONTENT_WRITE:
+      /* The blocks partially overwritten must be read from the FSAL first */
+      if(cache_content_blocks_fetch(pentry, CACHE_CONTENT_WRITE, offset, iosize_before,
+                                    pcontext, pstatus) != CACHE_CONTENT_SUCCESS)
+        {
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[statindex] += 1;
+
+          return *pstatus;
+        }
+
       /* The io is done on the cache before being flushed to the FSAL */
       if((iosize_after =
           pwrite(pentry->local_fs_entry.opened_file.local_fd, buffer, iosize_before,
@@ -364,6 +371,16 @@ cache_content_status_t cache_content_rdwr(cache_content_entry_t * pentry,
           return *pstatus;
         }
 
+      /* Only the dirty blocks will be flushed */
+      if(cache_content_blocks_set_dirty(pentry, offset, iosize_after, pstatus) !=
+         CACHE_CONTENT_SUCCESS)
+        {
+          /* stat */
+          pclient->stat.func_stats.nb_err_unrecover[statindex] += 1;
+
+          return *pstatus;
+        }
+
       if((cache_content_status =
           cache_content_valid(pentry, CACHE_CONTENT_OP_SET,
                               pclient)) != CACHE_CONTENT_SUCCESS)
@@ -392,6 +409,10 @@ cache_content_status_t cache_content_rdwr(cache_content_entry_t * pentry,
     {
       if(pbuffstat != NULL)
         *pbuffstat = buffstat;
+
+      /* Get the eof */
+      if(read_or_write == CACHE_CONTENT_READ)
+        *p_fsal_eof = (iosize_after == 0 || offset + iosize_after >= buffstat.st_size);
     }
 
   return *pstatus;
@@ -96,8 +96,8 @@ cache_content_status_t cache_content_release_entry(cache_content_entry_t * pentr
       pentry->local_fs_entry.opened_file.last_op = 0;
     }
 
-  /* Finally puts the entry back to entry pool for future use */
-  RELEASE_PREALLOC(pentry, pclient->pool_entry, next_alloc);
+  /* Free the bitmaps of the blocks */
+  cache_content_blocks_release(pentry);
 
   /* Remove the index file */
   if(unlink(pentry->local_fs_entry.cache_path_index) != 0)
@@ -118,5 +118,17 @@ cache_content_status_t cache_content_release_entry(cache_content_entry_t * pentr
                           pentry->local_fs_entry.cache_path_data, errno, strerror(errno));
     }
 
+  /* Remove the dirty blocks file */
+  if(unlink(pentry->local_fs_entry.cache_path_dirty) != 0)
+    {
+      if(errno != ENOENT)
+        LogEvent(COMPONENT_CACHE_CONTENT,
+                          "cache_content_release_entry: error when unlinking dirty blocks file %s, errno = ( %d, '%s' )",
+                          pentry->local_fs_entry.cache_path_dirty, errno, strerror(errno));
+    }
+
+  /* Finally puts the entry back to entry pool for future use */
+  RELEASE_PREALLOC(pentry, pclient->pool_entry, next_alloc);
+
   return *pstatus;
 }                               /* cache_content_release_entry */
@@ -77,6 +77,8 @@ cache_content_status_t cache_content_truncate(cache_content_entry_t * pentry,
       /* Sets the error */
       *pstatus = CACHE_CONTENT_LOCAL_CACHE_ERROR;
     }
+  else
+    cache_content_blocks_truncate(pentry, (off_t) length, pstatus);
 
   return *pstatus;
 }                               /* cache_content_truncate */
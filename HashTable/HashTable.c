@@ -465,6 +465,22 @@ hash_table_t *HashTable_Init(hash_parameter_t hparam)
 
   /* we have to keep the discriminant values */
   ht->parameter = hparam;
+  ht->concurrent = NULL;
+
+  /* The concurrent mode manages its own chains and locks */
+  if(hparam.flags & HASHTABLE_FLAG_CONCURRENT)
+    {
+      ht->stat_dynamic = NULL;
+      ht->array_rbt = NULL;
+      ht->array_lock = NULL;
+      ht->node_prealloc = NULL;
+      ht->pdata_prealloc = NULL;
+
+      if(HashTable_Concurrent_Init(ht) != HASHTABLE_SUCCESS)
+        return NULL;
+
+      return ht;
+    }
 
   if(pthread_mutexattr_init(&mutexattr) != 0)
     return NULL;
@@ -581,6 +597,9 @@ int HashTable_Test_And_Set(hash_table_t * ht, hash_buffer_t * buffkey,
   else if(buffval == NULL)
     return HASHTABLE_ERROR_INVALID_ARGUMENT;
 
+  if(ht->concurrent != NULL)
+    return HashTable_Concurrent_Test_And_Set(ht, buffkey, buffval, how);
+
   /* Find the RB Tree to be used */
   hashval = (*(ht->parameter.hash_func_key)) (&ht->parameter, buffkey);
   tete_rbt = &(ht->array_rbt[hashval]);
@@ -712,6 +731,9 @@ int HashTable_Get(hash_table_t * ht, hash_buffer_t * buffkey, hash_buffer_t * bu
   if(ht == NULL || buffkey == NULL || buffval == NULL)
     return HASHTABLE_ERROR_INVALID_ARGUMENT;
 
+  if(ht->concurrent != NULL)
+    return HashTable_Concurrent_Get(ht, buffkey, buffval);
+
   /* Find the RB Tree to be processed */
   hashval = (*(ht->parameter.hash_func_key)) (&ht->parameter, buffkey);
   tete_rbt = &(ht->array_rbt[hashval]);
@@ -775,6 +797,9 @@ int HashTable_Del(hash_table_t * ht, hash_buffer_t * buffkey,
   if(ht == NULL || buffkey == NULL)
     return HASHTABLE_ERROR_INVALID_ARGUMENT;
 
+  if(ht->concurrent != NULL)
+    return HashTable_Concurrent_Del(ht, buffkey, p_usedbuffkey, p_usedbuffdata);
+
   /* Find the RB Tree to be processed */
   hashval = (*(ht->parameter.hash_func_key)) (&ht->parameter, buffkey);
 
@@ -846,6 +871,12 @@ void HashTable_GetStats(hash_table_t * ht, hash_stat_t * hstat)
   if(ht == NULL || hstat == NULL)
     return;
 
+  if(ht->concurrent != NULL)
+    {
+      HashTable_Concurrent_GetStats(ht, hstat);
+      return;
+    }
+
   /* Firt, copy the dynamic values */
   memcpy(&(hstat->dynamic), ht->stat_dynamic, sizeof(hash_stat_dynamic_t));
 
@@ -925,6 +956,9 @@ unsigned int HashTable_GetSize(hash_table_t * ht)
   if(ht == NULL)
     return HASHTABLE_ERROR_INVALID_ARGUMENT;
 
+  if(ht->concurrent != NULL)
+    return HashTable_Concurrent_GetSize(ht);
+
   for(i = 0; i < ht->parameter.index_size; i++)
     nb_entries += ht->stat_dynamic[i].nb_entries;
 
@@ -962,6 +996,12 @@ void HashTable_Log(log_components_t component, hash_table_t * ht)
   if(ht == NULL)
     return;
 
+  if(ht->concurrent != NULL)
+    {
+      HashTable_Concurrent_Log(component, ht);
+      return;
+    }
+
   LogFullDebug(COMPONENT_HASHTABLE,
       "The hash has %d nodes (this number MUST be a prime integer for performance's issues)\n",
        ht->parameter.index_size);
@@ -0,0 +1,903 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    HashTable_concurrent.c
+ * \brief   Concurrent mode for the hash tables (HASHTABLE_FLAG_CONCURRENT).
+ *
+ * HashTable_concurrent.c : hash tables whose readers never take a lock.
+ *
+ * The table is an array of singly linked chains. Writers serialize on a
+ * small array of striped mutexes (all the keys of a chain belong to the same
+ * stripe), readers walk the chains without any lock. A writer never modifies
+ * a node that has been published: a new node is fully built before being
+ * linked, an overwrite links a copy in place of the old node, and unlinked
+ * nodes are only freed after a grace period, once every reader that could
+ * still see them has left the table.
+ *
+ * Grace periods use two reader counters per slot (a slot is chosen from the
+ * reader's thread id, to spread the counters over several cache lines). A
+ * reader increments the counter of the current phase, the reclaimer flips
+ * the phase and waits for the counters of the previous phase to drop to zero.
+ *
+ * When a stripe gets too loaded, the whole array is rebuilt twice as large:
+ * all stripes are locked, the chains are copied into a new array which is
+ * then published, and the old array and its nodes are reclaimed after a
+ * grace period. Readers keep on walking the old chains in the meantime.
+ *
+ * As the keys and values belong to the caller, a key given to HashTable_Del
+ * may still be read by a concurrent HashTable_Get comparing keys. Callers
+ * must not recycle a deleted key buffer for another key in the same table
+ * before a reader could have finished with it (in practice, the buffers are
+ * released to the BuddyMalloc allocator which keeps them mapped).
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "BuddyMalloc.h"
+#include "HashTable.h"
+#include "stuff_alloc.h"
+#include "log_macros.h"
+
+#ifndef TRUE
+#define TRUE 1
+#endif
+
+#ifndef FALSE
+#define FALSE 0
+#endif
+
+/* Number of writer locks, MUST be a power of 2 */
+#define HASH_CONC_NB_STRIPES      64
+
+/* Number of reader counter slots, MUST be a power of 2 */
+#define HASH_CONC_NB_READER_SLOTS 32
+
+/* A stripe triggers a resize when it holds more than this number of entries per bucket */
+#define HASH_CONC_MAX_LOAD        2
+
+/* Number of retired nodes that triggers a reclaim */
+#define HASH_CONC_RECLAIM_BATCH   128
+
+#define HASH_CONC_CACHE_LINE      64
+
+/* Memory barrier and plain atomic loads/stores used by the lock-free readers */
+#define HASH_CONC_BARRIER()       __sync_synchronize()
+#define HASH_CONC_LOAD( p )       ( *( (volatile typeof( p ) *) &( p ) ) )
+#define HASH_CONC_STORE( p, v )   do { HASH_CONC_BARRIER() ; \
+                                       *( (volatile typeof( p ) *) &( p ) ) = ( v ) ; } while( 0 )
+
+typedef struct hash_conc_node__
+{
+  struct hash_conc_node__ *next;        /**< Next node in the chain */
+  unsigned long long hashval;           /**< Full hash of the key */
+  hash_data_t data;                     /**< The (key,val) couple */
+  struct hash_conc_node__ *next_retired;        /**< Link in the list of nodes waiting for a grace period */
+} hash_conc_node_t;
+
+typedef struct hash_conc_array__
+{
+  unsigned long size;                   /**< Number of chains, a power of 2 */
+  hash_conc_node_t **chains;            /**< The chains themselves */
+  struct hash_conc_array__ *next_retired;       /**< Link in the list of arrays waiting for a grace period */
+} hash_conc_array_t;
+
+typedef struct hash_conc_stripe__
+{
+  pthread_mutex_t lock;                 /**< Serializes the writers of the chains of this stripe */
+  unsigned int nb_entries;              /**< Entries in the chains of this stripe */
+  hash_stat_dynamic_t stat;             /**< Writers' statistics (protected by lock) */
+} __attribute__ ((aligned(HASH_CONC_CACHE_LINE))) hash_conc_stripe_t;
+
+typedef struct hash_conc_reader__
+{
+  volatile unsigned int active[2];      /**< Readers inside the table, per grace phase */
+  unsigned int nb_get_ok;               /**< Readers' statistics, updated atomically */
+  unsigned int nb_get_notfound;
+  unsigned int nb_test_ok;
+  unsigned int nb_test_notfound;
+} __attribute__ ((aligned(HASH_CONC_CACHE_LINE))) hash_conc_reader_t;
+
+typedef struct hash_concurrent__
+{
+  hash_conc_array_t *array;             /**< Current array, replaced when the table grows */
+  hash_conc_stripe_t stripes[HASH_CONC_NB_STRIPES];
+  hash_conc_reader_t readers[HASH_CONC_NB_READER_SLOTS];
+  volatile unsigned int grace_phase;    /**< Phase new readers register in */
+  pthread_mutex_t resize_lock;          /**< Only one resize at a time */
+  pthread_mutex_t reclaim_lock;         /**< Only one grace period at a time */
+  hash_conc_node_t *retired_nodes;      /**< Unlinked nodes, freed after a grace period */
+  hash_conc_array_t *retired_arrays;    /**< Replaced arrays, freed after a grace period */
+  unsigned int nb_retired;
+  unsigned int nb_resize;
+} hash_concurrent_t;
+
+/**
+ * @defgroup HashTableConcurrentInternalFunctions
+ *@{
+ */
+
+/**
+ *
+ * hash_conc_fullhash: computes the 64 bits hash value used to place a key.
+ *
+ * Both user provided hash functions are mixed together, this does not depend on the number of chains
+ * so that an entry can be moved to a larger array.
+ *
+ */
+static unsigned long long hash_conc_fullhash(hash_table_t * ht, hash_buffer_t * buffkey)
+{
+  unsigned long long h;
+
+  h = (unsigned long long)(*(ht->parameter.hash_func_key)) (&ht->parameter, buffkey);
+  h = (h << 32) ^ (unsigned long long)(*(ht->parameter.hash_func_rbt)) (&ht->parameter,
+                                                                         buffkey);
+
+  /* 64 bits finalizer, spreads the entropy of the user hash on the low bits */
+  h ^= h >> 33;
+  h *= 0xff51afd7ed558ccdULL;
+  h ^= h >> 33;
+  h *= 0xc4ceb9fe1a85ec53ULL;
+  h ^= h >> 33;
+
+  return h;
+}                               /* hash_conc_fullhash */
+
+/* The stripe only depends on the low bits of the hash, which are also the low bits of the chain index */
+static inline hash_conc_stripe_t *hash_conc_stripe(hash_concurrent_t * hc,
+                                                   unsigned long long hashval)
+{
+  return &hc->stripes[hashval & (HASH_CONC_NB_STRIPES - 1)];
+}                               /* hash_conc_stripe */
+
+static inline hash_conc_reader_t *hash_conc_reader_slot(hash_concurrent_t * hc)
+{
+  unsigned long id = (unsigned long)pthread_self();
+
+  /* pthread_t are addresses of thread descriptors, drop the always identical low bits */
+  id = (id >> 12) * 2654435761UL;
+
+  return &hc->readers[(id >> 8) & (HASH_CONC_NB_READER_SLOTS - 1)];
+}                               /* hash_conc_reader_slot */
+
+/**
+ *
+ * hash_conc_read_enter: registers the calling thread as a reader of the table.
+ *
+ * @return the grace phase to be given back to hash_conc_read_exit.
+ *
+ */
+static unsigned int hash_conc_read_enter(hash_concurrent_t * hc, hash_conc_reader_t * slot)
+{
+  unsigned int phase;
+
+  for(;;)
+    {
+      phase = hc->grace_phase;
+      __sync_fetch_and_add(&slot->active[phase], 1);
+
+      /* If the phase changed meanwhile, the reclaimer may not wait for us: register again */
+      if(phase == hc->grace_phase)
+        return phase;
+
+      __sync_fetch_and_sub(&slot->active[phase], 1);
+    }
+}                               /* hash_conc_read_enter */
+
+static inline void hash_conc_read_exit(hash_conc_reader_t * slot, unsigned int phase)
+{
+  __sync_fetch_and_sub(&slot->active[phase], 1);
+}                               /* hash_conc_read_exit */
+
+/**
+ *
+ * hash_conc_retire_node: queues a node which is no more reachable, to be freed after a grace period.
+ *
+ */
+static void hash_conc_retire_node(hash_concurrent_t * hc, hash_conc_node_t * pnode)
+{
+  hash_conc_node_t *head;
+
+  do
+    {
+      head = hc->retired_nodes;
+      pnode->next_retired = head;
+    }
+  while(!__sync_bool_compare_and_swap(&hc->retired_nodes, head, pnode));
+
+  __sync_fetch_and_add(&hc->nb_retired, 1);
+}                               /* hash_conc_retire_node */
+
+static void hash_conc_retire_array(hash_concurrent_t * hc, hash_conc_array_t * parray)
+{
+  hash_conc_array_t *head;
+
+  do
+    {
+      head = hc->retired_arrays;
+      parray->next_retired = head;
+    }
+  while(!__sync_bool_compare_and_swap(&hc->retired_arrays, head, parray));
+}                               /* hash_conc_retire_array */
+
+/**
+ *
+ * hash_conc_reclaim: frees the retired nodes and arrays once all readers that could see them are gone.
+ *
+ * Must not be called with a stripe lock held (this would only delay the writers, readers never wait).
+ *
+ * @param hc the concurrent part of the table.
+ * @param force if FALSE, do nothing unless enough nodes are waiting.
+ *
+ */
+static void hash_conc_reclaim(hash_concurrent_t * hc, int force)
+{
+  hash_conc_node_t *pnode;
+  hash_conc_node_t *pnext;
+  hash_conc_array_t *parray;
+  hash_conc_array_t *pnextarray;
+  unsigned int old_phase;
+  unsigned int i;
+
+  if(!force && hc->nb_retired < HASH_CONC_RECLAIM_BATCH)
+    return;
+
+  if(force)
+    pthread_mutex_lock(&hc->reclaim_lock);
+  else if(pthread_mutex_trylock(&hc->reclaim_lock) != 0)
+    return;                     /* somebody else is reclaiming */
+
+  /* Only what was retired before the phase flip can be freed after waiting */
+  pnode = __sync_lock_test_and_set(&hc->retired_nodes, NULL);
+  parray = __sync_lock_test_and_set(&hc->retired_arrays, NULL);
+
+  if(pnode == NULL && parray == NULL)
+    {
+      pthread_mutex_unlock(&hc->reclaim_lock);
+      return;
+    }
+
+  old_phase = hc->grace_phase;
+  HASH_CONC_BARRIER();
+  hc->grace_phase = old_phase ^ 1;
+  HASH_CONC_BARRIER();
+
+  for(i = 0; i < HASH_CONC_NB_READER_SLOTS; i++)
+    while(hc->readers[i].active[old_phase] != 0)
+      sched_yield();
+
+  for(; pnode != NULL; pnode = pnext)
+    {
+      pnext = pnode->next_retired;
+      Mem_Free(pnode);
+      __sync_fetch_and_sub(&hc->nb_retired, 1);
+    }
+
+  for(; parray != NULL; parray = pnextarray)
+    {
+      pnextarray = parray->next_retired;
+      Mem_Free(parray->chains);
+      Mem_Free(parray);
+    }
+
+  pthread_mutex_unlock(&hc->reclaim_lock);
+}                               /* hash_conc_reclaim */
+
+static hash_conc_array_t *hash_conc_alloc_array(unsigned long size)
+{
+  hash_conc_array_t *parray;
+
+  if((parray = (hash_conc_array_t *) Mem_Alloc(sizeof(hash_conc_array_t))) == NULL)
+    return NULL;
+
+  if((parray->chains =
+      (hash_conc_node_t **) Mem_Alloc(sizeof(hash_conc_node_t *) * size)) == NULL)
+    {
+      Mem_Free(parray);
+      return NULL;
+    }
+
+  memset(parray->chains, 0, sizeof(hash_conc_node_t *) * size);
+  parray->size = size;
+  parray->next_retired = NULL;
+
+  return parray;
+}                               /* hash_conc_alloc_array */
+
+/**
+ *
+ * hash_conc_grow: rebuilds the table with twice as much chains.
+ *
+ * All the writers are stopped during the copy, readers are not.
+ *
+ * @param ht the hashtable to be used.
+ * @param old_size the size seen by the caller when it decided to grow the table.
+ *
+ */
+static void hash_conc_grow(hash_table_t * ht, unsigned long old_size)
+{
+  hash_concurrent_t *hc = ht->concurrent;
+  hash_conc_array_t *old_array;
+  hash_conc_array_t *new_array;
+  hash_conc_node_t *pnode;
+  hash_conc_node_t *pcopy;
+  hash_conc_node_t *pnext;
+  unsigned long i;
+  unsigned long idx;
+  int failed = FALSE;
+
+  /* Another thread is already growing the table */
+  if(pthread_mutex_trylock(&hc->resize_lock) != 0)
+    return;
+
+  for(i = 0; i < HASH_CONC_NB_STRIPES; i++)
+    pthread_mutex_lock(&hc->stripes[i].lock);
+
+  old_array = hc->array;
+
+  /* The table was grown since the caller looked at it */
+  if(old_array->size != old_size)
+    goto out;
+
+  if((new_array = hash_conc_alloc_array(old_size * 2)) == NULL)
+    goto out;
+
+#ifdef _DEBUG_MEMLEAKS
+  /* For debugging memory leaks */
+  BuddySetDebugLabel("hash_conc_node_t");
+#endif
+
+  /* Readers may be walking the old chains: copy the nodes instead of moving them */
+  for(i = 0; i < old_size && !failed; i++)
+    for(pnode = old_array->chains[i]; pnode != NULL; pnode = pnode->next)
+      {
+        if((pcopy = (hash_conc_node_t *) Mem_Alloc(sizeof(hash_conc_node_t))) == NULL)
+          {
+            failed = TRUE;
+            break;
+          }
+
+        *pcopy = *pnode;
+        idx = pnode->hashval & (new_array->size - 1);
+        pcopy->next = new_array->chains[idx];
+        new_array->chains[idx] = pcopy;
+      }
+
+#ifdef _DEBUG_MEMLEAKS
+  /* For debugging memory leaks */
+  BuddySetDebugLabel("N/A");
+#endif
+
+  if(failed)
+    {
+      /* Nothing was published, the copies can be freed right now */
+      for(i = 0; i < new_array->size; i++)
+        while((pnode = new_array->chains[i]) != NULL)
+          {
+            new_array->chains[i] = pnode->next;
+            Mem_Free(pnode);
+          }
+      Mem_Free(new_array->chains);
+      Mem_Free(new_array);
+
+      LogCrit(COMPONENT_HASHTABLE,
+              "HashTable: could not grow concurrent table from %lu chains, keeping it",
+              old_size);
+      goto out;
+    }
+
+  HASH_CONC_STORE(hc->array, new_array);
+  hc->nb_resize += 1;
+
+  /* A retired node may be freed at once by another thread's reclaim, do not touch it afterwards */
+  for(i = 0; i < old_size; i++)
+    for(pnode = old_array->chains[i]; pnode != NULL; pnode = pnext)
+      {
+        pnext = pnode->next;
+        hash_conc_retire_node(hc, pnode);
+      }
+  hash_conc_retire_array(hc, old_array);
+
+  LogDebug(COMPONENT_HASHTABLE, "HashTable: concurrent table grown to %lu chains",
+           new_array->size);
+
+ out:
+  for(i = 0; i < HASH_CONC_NB_STRIPES; i++)
+    pthread_mutex_unlock(&hc->stripes[i].lock);
+
+  pthread_mutex_unlock(&hc->resize_lock);
+
+  hash_conc_reclaim(hc, TRUE);
+}                               /* hash_conc_grow */
+
+/**
+ *
+ * hash_conc_locate: looks for a key in a chain.
+ *
+ * May be called without any lock, inside a read section.
+ *
+ * @param ht the hashtable to be used.
+ * @param parray the array to look into.
+ * @param buffkey the key to look for.
+ * @param hashval the full hash of the key.
+ * @param pppprev if not NULL, will point to the link pointing to the found node.
+ *
+ * @return the node found or NULL.
+ *
+ */
+static hash_conc_node_t *hash_conc_locate(hash_table_t * ht, hash_conc_array_t * parray,
+                                          hash_buffer_t * buffkey,
+                                          unsigned long long hashval,
+                                          hash_conc_node_t *** pppprev)
+{
+  hash_conc_node_t **ppprev;
+  hash_conc_node_t *pnode;
+
+  ppprev = &parray->chains[hashval & (parray->size - 1)];
+
+  while((pnode = HASH_CONC_LOAD(*ppprev)) != NULL)
+    {
+      /* compare_key returns 0 if keys are identical */
+      if(pnode->hashval == hashval
+         && !ht->parameter.compare_key(buffkey, &pnode->data.buffkey))
+        {
+          if(pppprev != NULL)
+            *pppprev = ppprev;
+          return pnode;
+        }
+
+      ppprev = &pnode->next;
+    }
+
+  return NULL;
+}                               /* hash_conc_locate */
+
+/*}@ */
+
+/**
+ * @defgroup HashTableConcurrentFunctions
+ *@{
+ */
+
+/**
+ *
+ * HashTable_Concurrent_Init: sets up the concurrent part of a table.
+ *
+ * The initial number of chains is index_size rounded up to a power of 2 (and at least the number of stripes).
+ *
+ * @param ht the hashtable being initialized by HashTable_Init.
+ *
+ * @return HASHTABLE_SUCCESS if successfull, HASHTABLE_INSERT_MALLOC_ERROR otherwise.
+ *
+ */
+int HashTable_Concurrent_Init(hash_table_t * ht)
+{
+  hash_concurrent_t *hc;
+  unsigned long size = HASH_CONC_NB_STRIPES;
+  unsigned int i;
+
+  while(size < ht->parameter.index_size)
+    size <<= 1;
+
+  if((hc = (hash_concurrent_t *) Mem_Alloc(sizeof(hash_concurrent_t))) == NULL)
+    return HASHTABLE_INSERT_MALLOC_ERROR;
+
+  memset(hc, 0, sizeof(hash_concurrent_t));
+
+  if((hc->array = hash_conc_alloc_array(size)) == NULL)
+    {
+      Mem_Free(hc);
+      return HASHTABLE_INSERT_MALLOC_ERROR;
+    }
+
+  for(i = 0; i < HASH_CONC_NB_STRIPES; i++)
+    if(pthread_mutex_init(&hc->stripes[i].lock, NULL) != 0)
+      goto free_stripes;
+
+  if(pthread_mutex_init(&hc->resize_lock, NULL) != 0)
+    goto free_stripes;
+
+  if(pthread_mutex_init(&hc->reclaim_lock, NULL) != 0)
+    {
+      pthread_mutex_destroy(&hc->resize_lock);
+      goto free_stripes;
+    }
+
+  ht->concurrent = hc;
+
+  return HASHTABLE_SUCCESS;
+
+ free_stripes:
+  /* i is the number of stripe locks that were initialized */
+  while(i > 0)
+    pthread_mutex_destroy(&hc->stripes[--i].lock);
+
+  Mem_Free(hc->array->chains);
+  Mem_Free(hc->array);
+  Mem_Free(hc);
+
+  return HASHTABLE_INSERT_MALLOC_ERROR;
+}                               /* HashTable_Concurrent_Init */
+
+/**
+ *
+ * HashTable_Concurrent_Test_And_Set: concurrent mode version of HashTable_Test_And_Set.
+ *
+ * HASHTABLE_SET_HOW_TEST_ONLY is served without taking any lock.
+ *
+ * @see HashTable_Test_And_Set
+ *
+ */
+int HashTable_Concurrent_Test_And_Set(hash_table_t * ht, hash_buffer_t * buffkey,
+                                      hash_buffer_t * buffval, hashtable_set_how_t how)
+{
+  hash_concurrent_t *hc = ht->concurrent;
+  hash_conc_stripe_t *stripe;
+  hash_conc_reader_t *slot;
+  hash_conc_array_t *parray;
+  hash_conc_node_t *pnode;
+  hash_conc_node_t *pnew;
+  hash_conc_node_t **ppprev;
+  unsigned long long hashval;
+  unsigned long size = 0;
+  unsigned int phase;
+  int grow = FALSE;
+
+  hashval = hash_conc_fullhash(ht, buffkey);
+
+  if(how == HASHTABLE_SET_HOW_TEST_ONLY)
+    {
+      slot = hash_conc_reader_slot(hc);
+      phase = hash_conc_read_enter(hc, slot);
+
+      pnode = hash_conc_locate(ht, HASH_CONC_LOAD(hc->array), buffkey, hashval, NULL);
+
+      hash_conc_read_exit(slot, phase);
+
+      if(pnode == NULL)
+        {
+          __sync_fetch_and_add(&slot->nb_test_notfound, 1);
+          return HASHTABLE_ERROR_NO_SUCH_KEY;
+        }
+
+      __sync_fetch_and_add(&slot->nb_test_ok, 1);
+      return HASHTABLE_SUCCESS;
+    }
+
+  /* The new node is built out of the lock */
+#ifdef _DEBUG_MEMLEAKS
+  /* For debugging memory leaks */
+  BuddySetDebugLabel("hash_conc_node_t");
+#endif
+  pnew = (hash_conc_node_t *) Mem_Alloc(sizeof(hash_conc_node_t));
+#ifdef _DEBUG_MEMLEAKS
+  /* For debugging memory leaks */
+  BuddySetDebugLabel("N/A");
+#endif
+
+  stripe = hash_conc_stripe(hc, hashval);
+
+  if(pnew == NULL)
+    {
+      pthread_mutex_lock(&stripe->lock);
+      stripe->stat.err.nb_set += 1;
+      pthread_mutex_unlock(&stripe->lock);
+      return HASHTABLE_INSERT_MALLOC_ERROR;
+    }
+
+  memset(pnew, 0, sizeof(hash_conc_node_t));
+  pnew->hashval = hashval;
+  pnew->data.buffkey.pdata = buffkey->pdata;
+  pnew->data.buffkey.len = buffkey->len;
+  pnew->data.buffval.pdata = buffval->pdata;
+  pnew->data.buffval.len = buffval->len;
+
+  pthread_mutex_lock(&stripe->lock);
+
+  /* The array can only be replaced by a writer holding all the stripes */
+  parray = hc->array;
+
+  if((pnode = hash_conc_locate(ht, parray, buffkey, hashval, &ppprev)) != NULL)
+    {
+      if(how == HASHTABLE_SET_HOW_SET_NO_OVERWRITE)
+        {
+          stripe->stat.err.nb_test += 1;
+          pthread_mutex_unlock(&stripe->lock);
+          Mem_Free(pnew);
+          return HASHTABLE_ERROR_KEY_ALREADY_EXISTS;
+        }
+
+      /* Readers may be reading pnode, replace it by a copy instead of updating it */
+      pnew->next = pnode->next;
+      HASH_CONC_STORE(*ppprev, pnew);
+      hash_conc_retire_node(hc, pnode);
+
+      LogFullDebug(COMPONENT_HASHTABLE, "Ecrasement d'une ancienne entree (k=%p,v=%p)\n",
+                   buffkey->pdata, buffval->pdata);
+    }
+  else
+    {
+      ppprev = &parray->chains[hashval & (parray->size - 1)];
+      pnew->next = *ppprev;
+      HASH_CONC_STORE(*ppprev, pnew);
+
+      stripe->nb_entries += 1;
+
+      if(stripe->nb_entries >
+         (parray->size / HASH_CONC_NB_STRIPES) * HASH_CONC_MAX_LOAD)
+        {
+          grow = TRUE;
+          size = parray->size;
+        }
+
+      stripe->stat.nb_entries += 1;
+
+      LogFullDebug(COMPONENT_HASHTABLE, "Creation d'une nouvelle entree (k=%p,v=%p)\n",
+                   buffkey->pdata, buffval->pdata);
+    }
+
+  stripe->stat.ok.nb_set += 1;
+
+  pthread_mutex_unlock(&stripe->lock);
+
+  if(grow)
+    hash_conc_grow(ht, size);
+  else
+    hash_conc_reclaim(hc, FALSE);
+
+  return HASHTABLE_SUCCESS;
+}                               /* HashTable_Concurrent_Test_And_Set */
+
+/**
+ *
+ * HashTable_Concurrent_Get: concurrent mode version of HashTable_Get, takes no lock.
+ *
+ * @see HashTable_Get
+ *
+ */
+int HashTable_Concurrent_Get(hash_table_t * ht, hash_buffer_t * buffkey,
+                             hash_buffer_t * buffval)
+{
+  hash_concurrent_t *hc = ht->concurrent;
+  hash_conc_reader_t *slot;
+  hash_conc_node_t *pnode;
+  unsigned long long hashval;
+  unsigned int phase;
+
+  hashval = hash_conc_fullhash(ht, buffkey);
+
+  slot = hash_conc_reader_slot(hc);
+  phase = hash_conc_read_enter(hc, slot);
+
+  if((pnode = hash_conc_locate(ht, HASH_CONC_LOAD(hc->array), buffkey, hashval, NULL))
+     == NULL)
+    {
+      hash_conc_read_exit(slot, phase);
+      __sync_fetch_and_add(&slot->nb_get_notfound, 1);
+      return HASHTABLE_ERROR_NO_SUCH_KEY;
+    }
+
+  /* A published node is never modified, its content is consistent */
+  buffval->pdata = pnode->data.buffval.pdata;
+  buffval->len = pnode->data.buffval.len;
+
+  hash_conc_read_exit(slot, phase);
+  __sync_fetch_and_add(&slot->nb_get_ok, 1);
+
+  return HASHTABLE_SUCCESS;
+}                               /* HashTable_Concurrent_Get */
+
+/**
+ *
+ * HashTable_Concurrent_Del: concurrent mode version of HashTable_Del.
+ *
+ * @see HashTable_Del
+ *
+ */
+int HashTable_Concurrent_Del(hash_table_t * ht, hash_buffer_t * buffkey,
+                             hash_buffer_t * p_usedbuffkey, hash_buffer_t * p_usedbuffdata)
+{
+  hash_concurrent_t *hc = ht->concurrent;
+  hash_conc_stripe_t *stripe;
+  hash_conc_node_t *pnode;
+  hash_conc_node_t **ppprev;
+  unsigned long long hashval;
+
+  hashval = hash_conc_fullhash(ht, buffkey);
+  stripe = hash_conc_stripe(hc, hashval);
+
+  pthread_mutex_lock(&stripe->lock);
+
+  if((pnode = hash_conc_locate(ht, hc->array, buffkey, hashval, &ppprev)) == NULL)
+    {
+      stripe->stat.notfound.nb_del += 1;
+      pthread_mutex_unlock(&stripe->lock);
+      return HASHTABLE_ERROR_NO_SUCH_KEY;
+    }
+
+  /* Return the key buffer back to the end user if pusedbuffkey isn't NULL */
+  if(p_usedbuffkey != NULL)
+    *p_usedbuffkey = pnode->data.buffkey;
+
+  if(p_usedbuffdata != NULL)
+    *p_usedbuffdata = pnode->data.buffval;
+
+  /* Readers already in the chain can still go through pnode, its next pointer is kept */
+  HASH_CONC_STORE(*ppprev, pnode->next);
+  hash_conc_retire_node(hc, pnode);
+
+  stripe->nb_entries -= 1;
+  stripe->stat.nb_entries -= 1;
+  stripe->stat.ok.nb_del += 1;
+
+  pthread_mutex_unlock(&stripe->lock);
+
+  hash_conc_reclaim(hc, FALSE);
+
+  return HASHTABLE_SUCCESS;
+}                               /* HashTable_Concurrent_Del */
+
+/**
+ *
+ * HashTable_Concurrent_GetStats: concurrent mode version of HashTable_GetStats.
+ *
+ * The computed statistics are about the chains lengths rather than rbt sizes.
+ *
+ * @see HashTable_GetStats
+ *
+ */
+void HashTable_Concurrent_GetStats(hash_table_t * ht, hash_stat_t * hstat)
+{
+  hash_concurrent_t *hc = ht->concurrent;
+  hash_conc_reader_t *slot;
+  hash_conc_array_t *parray;
+  hash_conc_node_t *pnode;
+  hash_stat_dynamic_t *pstat;
+  unsigned int phase;
+  unsigned int len;
+  unsigned long i;
+
+  memset(hstat, 0, sizeof(hash_stat_t));
+
+  for(i = 0; i < HASH_CONC_NB_STRIPES; i++)
+    {
+      pstat = &hc->stripes[i].stat;
+
+      hstat->dynamic.nb_entries += pstat->nb_entries;
+
+      hstat->dynamic.ok.nb_set += pstat->ok.nb_set;
+      hstat->dynamic.ok.nb_del += pstat->ok.nb_del;
+
+      hstat->dynamic.err.nb_set += pstat->err.nb_set;
+      hstat->dynamic.err.nb_test += pstat->err.nb_test;
+
+      hstat->dynamic.notfound.nb_del += pstat->notfound.nb_del;
+    }
+
+  for(i = 0; i < HASH_CONC_NB_READER_SLOTS; i++)
+    {
+      hstat->dynamic.ok.nb_get += hc->readers[i].nb_get_ok;
+      hstat->dynamic.notfound.nb_get += hc->readers[i].nb_get_notfound;
+      hstat->dynamic.ok.nb_test += hc->readers[i].nb_test_ok;
+      hstat->dynamic.notfound.nb_test += hc->readers[i].nb_test_notfound;
+    }
+
+  hstat->computed.min_rbt_num_node = 1 << 31;
+
+  slot = hash_conc_reader_slot(hc);
+  phase = hash_conc_read_enter(hc, slot);
+
+  parray = HASH_CONC_LOAD(hc->array);
+
+  for(i = 0; i < parray->size; i++)
+    {
+      len = 0;
+      for(pnode = HASH_CONC_LOAD(parray->chains[i]); pnode != NULL;
+          pnode = HASH_CONC_LOAD(pnode->next))
+        len += 1;
+
+      if(len > hstat->computed.max_rbt_num_node)
+        hstat->computed.max_rbt_num_node = len;
+
+      if(len < hstat->computed.min_rbt_num_node)
+        hstat->computed.min_rbt_num_node = len;
+
+      hstat->computed.average_rbt_num_node += len;
+    }
+
+  hstat->computed.average_rbt_num_node /= parray->size;
+
+  hash_conc_read_exit(slot, phase);
+}                               /* HashTable_Concurrent_GetStats */
+
+/**
+ *
+ * HashTable_Concurrent_GetSize: concurrent mode version of HashTable_GetSize.
+ *
+ * @see HashTable_GetSize
+ *
+ */
+unsigned int HashTable_Concurrent_GetSize(hash_table_t * ht)
+{
+  unsigned int i = 0;
+  unsigned int nb_entries = 0;
+
+  for(i = 0; i < HASH_CONC_NB_STRIPES; i++)
+    nb_entries += ht->concurrent->stripes[i].nb_entries;
+
+  return nb_entries;
+}                               /* HashTable_Concurrent_GetSize */
+
+/**
+ *
+ * HashTable_Concurrent_Log: concurrent mode version of HashTable_Log.
+ *
+ * @see HashTable_Log
+ *
+ */
+void HashTable_Concurrent_Log(log_components_t component, hash_table_t * ht)
+{
+  hash_concurrent_t *hc = ht->concurrent;
+  hash_conc_reader_t *slot;
+  hash_conc_array_t *parray;
+  hash_conc_node_t *pnode;
+  char dispkey[HASHTABLE_DISPLAY_STRLEN];
+  char dispval[HASHTABLE_DISPLAY_STRLEN];
+  unsigned int phase;
+  unsigned long i;
+
+  slot = hash_conc_reader_slot(hc);
+  phase = hash_conc_read_enter(hc, slot);
+
+  parray = HASH_CONC_LOAD(hc->array);
+
+  LogFullDebug(COMPONENT_HASHTABLE,
+               "The concurrent hash has %lu chains, it was grown %u times\n",
+               parray->size, hc->nb_resize);
+
+  LogFullDebug(COMPONENT_HASHTABLE, "The hash contains %u entries\n",
+               HashTable_Concurrent_GetSize(ht));
+
+  for(i = 0; i < parray->size; i++)
+    for(pnode = HASH_CONC_LOAD(parray->chains[i]); pnode != NULL;
+        pnode = HASH_CONC_LOAD(pnode->next))
+      {
+        ht->parameter.key_to_str(&(pnode->data.buffkey), dispkey);
+        ht->parameter.val_to_str(&(pnode->data.buffval), dispval);
+
+        LogFullDebug(component, "%s => %s; chain=%lu hashval=%llx\n ", dispkey, dispval,
+                     i, pnode->hashval);
+      }
+
+  hash_conc_read_exit(slot, phase);
+}                               /* HashTable_Concurrent_Log */
+
+/* @} */
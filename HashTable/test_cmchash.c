@@ -149,6 +149,7 @@ int main(int argc, char *argv[])
   hparam.compare_key = compare_string_buffer;
   hparam.key_to_str = display_buff;
   hparam.val_to_str = display_buff;
+  hparam.flags = HASHTABLE_FLAG_NONE;
 
   BuddyInit(NULL);
 
@@ -0,0 +1,310 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ *
+ * Test of the concurrent mode of the hash tables (HASHTABLE_FLAG_CONCURRENT):
+ * readers look up a stable set of keys while writers keep on adding,
+ * overwriting and removing other keys, making the table grow.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "BuddyMalloc.h"
+#include "HashTable.h"
+#include "MesureTemps.h"
+#include "log_macros.h"
+
+#define MAXTEST 20000           /* keys [0,STABLE) are never removed, the others are updated by the writers */
+#define STABLE 5000
+#define STRSIZE 16
+#define PRIME 17                /* small on purpose, the table has to grow */
+#define NB_READERS 4
+#define NB_WRITERS 2
+#define NB_READ_ITER 400000
+#define NB_WRITE_LOOPS 20
+
+hash_table_t *ht = NULL;
+char strkey[MAXTEST][STRSIZE];
+char strval[MAXTEST][STRSIZE];
+char strval_ovr[MAXTEST][STRSIZE];
+int nb_errors = 0;
+
+int compare_string_buffer(hash_buffer_t * buff1, hash_buffer_t * buff2)
+{
+  return strcmp(buff1->pdata, buff2->pdata);
+}
+
+int display_buff(hash_buffer_t * pbuff, char *str)
+{
+  return snprintf(str, HASHTABLE_DISPLAY_STRLEN, "%s", (char *)pbuff->pdata);
+}
+
+unsigned long simple_hash_func(hash_parameter_t * p_hparam, hash_buffer_t * buffclef);
+unsigned long rbt_hash_func(hash_parameter_t * p_hparam, hash_buffer_t * buffclef);
+
+static void set_buffers(int i, char *val, hash_buffer_t * pkey, hash_buffer_t * pval)
+{
+  pkey->pdata = strkey[i];
+  pkey->len = strlen(strkey[i]);
+
+  if(pval != NULL)
+    {
+      pval->pdata = val;
+      pval->len = strlen(val);
+    }
+}
+
+void *reader(void *arg)
+{
+  hash_buffer_t buffkey;
+  hash_buffer_t buffval;
+  unsigned int seed = (unsigned int)(long)arg;
+  int i, n, rc;
+
+  BuddyInit(NULL);
+
+  for(n = 0; n < NB_READ_ITER; n++)
+    {
+      i = rand_r(&seed) % MAXTEST;
+      set_buffers(i, NULL, &buffkey, NULL);
+
+      rc = HashTable_Get(ht, &buffkey, &buffval);
+
+      if(i < STABLE)
+        {
+          if(rc != HASHTABLE_SUCCESS || buffval.pdata != strval[i])
+            {
+              LogTest("Reader: stable key %s not found or bad value (rc=%d)", strkey[i], rc);
+              __sync_fetch_and_add(&nb_errors, 1);
+            }
+        }
+      else if(rc == HASHTABLE_SUCCESS && buffval.pdata != strval[i]
+              && buffval.pdata != strval_ovr[i])
+        {
+          LogTest("Reader: key %s has a value that was never set", strkey[i]);
+          __sync_fetch_and_add(&nb_errors, 1);
+        }
+    }
+
+  return NULL;
+}                               /* reader */
+
+void *writer(void *arg)
+{
+  hash_buffer_t buffkey;
+  hash_buffer_t buffval;
+  long num = (long)arg;
+  int i, loop, rc;
+
+  BuddyInit(NULL);
+
+  /* Each writer owns the keys i such that i % NB_WRITERS == num */
+  for(loop = 0; loop < NB_WRITE_LOOPS; loop++)
+    for(i = STABLE + num; i < MAXTEST; i += NB_WRITERS)
+      {
+        set_buffers(i, strval[i], &buffkey, &buffval);
+        if((rc = HashTable_Test_And_Set(ht, &buffkey, &buffval,
+                                        HASHTABLE_SET_HOW_SET_NO_OVERWRITE)) !=
+           HASHTABLE_SUCCESS)
+          {
+            LogTest("Writer: could not add %s (rc=%d)", strkey[i], rc);
+            __sync_fetch_and_add(&nb_errors, 1);
+          }
+
+        set_buffers(i, strval_ovr[i], &buffkey, &buffval);
+        if((rc = HashTable_Set(ht, &buffkey, &buffval)) != HASHTABLE_SUCCESS)
+          {
+            LogTest("Writer: could not overwrite %s (rc=%d)", strkey[i], rc);
+            __sync_fetch_and_add(&nb_errors, 1);
+          }
+
+        /* Keep the keys in the table after the last loop */
+        if(loop == NB_WRITE_LOOPS - 1)
+          continue;
+
+        set_buffers(i, NULL, &buffkey, NULL);
+        if((rc = HashTable_Del(ht, &buffkey, NULL, NULL)) != HASHTABLE_SUCCESS)
+          {
+            LogTest("Writer: could not remove %s (rc=%d)", strkey[i], rc);
+            __sync_fetch_and_add(&nb_errors, 1);
+          }
+      }
+
+  return NULL;
+}                               /* writer */
+
+int main(int argc, char *argv[])
+{
+  SetDefaultLogging("TEST");
+  SetNamePgm("test_libcmc_concurrent");
+
+  hash_parameter_t hparam;
+  hash_buffer_t buffkey;
+  hash_buffer_t buffval;
+  hash_stat_t statistiques;
+  pthread_t thr_readers[NB_READERS];
+  pthread_t thr_writers[NB_WRITERS];
+  struct Temps debut, fin;
+  long i;
+  int rc;
+
+  hparam.index_size = PRIME;
+  hparam.alphabet_length = 10;
+  hparam.nb_node_prealloc = 0;
+  hparam.hash_func_key = simple_hash_func;
+  hparam.hash_func_rbt = rbt_hash_func;
+  hparam.compare_key = compare_string_buffer;
+  hparam.key_to_str = display_buff;
+  hparam.val_to_str = display_buff;
+  hparam.flags = HASHTABLE_FLAG_CONCURRENT;
+
+  BuddyInit(NULL);
+
+  if((ht = HashTable_Init(hparam)) == NULL)
+    {
+      LogTest("Test FAILED: Bad init");
+      exit(1);
+    }
+
+  for(i = 0; i < MAXTEST; i++)
+    {
+      sprintf(strkey[i], "%ld", i);
+      sprintf(strval[i], "%ld", i * 10);
+      sprintf(strval_ovr[i], "%ld", i * 10 + 1);
+    }
+
+  /* Single threaded sanity checks */
+  for(i = 0; i < STABLE; i++)
+    {
+      set_buffers(i, strval_ovr[i], &buffkey, &buffval);
+      if(HashTable_Set(ht, &buffkey, &buffval) != HASHTABLE_SUCCESS)
+        {
+          LogTest("Test FAILED: could not add key %s", strkey[i]);
+          exit(1);
+        }
+    }
+
+  for(i = 0; i < STABLE; i++)
+    {
+      set_buffers(i, strval[i], &buffkey, &buffval);
+
+      if(HashTable_Test_And_Set(ht, &buffkey, &buffval, HASHTABLE_SET_HOW_SET_NO_OVERWRITE)
+         != HASHTABLE_ERROR_KEY_ALREADY_EXISTS)
+        {
+          LogTest("Test FAILED: key %s was overwritten with SET_NO_OVERWRITE", strkey[i]);
+          exit(1);
+        }
+
+      if(HashTable_Set(ht, &buffkey, &buffval) != HASHTABLE_SUCCESS
+         || HashTable_Get(ht, &buffkey, &buffval) != HASHTABLE_SUCCESS
+         || buffval.pdata != strval[i])
+        {
+          LogTest("Test FAILED: key %s was not overwritten", strkey[i]);
+          exit(1);
+        }
+    }
+
+  set_buffers(STABLE, strval[STABLE], &buffkey, &buffval);
+  if(HashTable_Test_And_Set(ht, &buffkey, &buffval, HASHTABLE_SET_HOW_TEST_ONLY) !=
+     HASHTABLE_ERROR_NO_SUCH_KEY
+     || HashTable_Del(ht, &buffkey, NULL, NULL) != HASHTABLE_ERROR_NO_SUCH_KEY)
+    {
+      LogTest("Test FAILED: found a key that was never added");
+      exit(1);
+    }
+
+  if(HashTable_GetSize(ht) != STABLE)
+    {
+      LogTest("Test FAILED: %u entries instead of %d", HashTable_GetSize(ht), STABLE);
+      exit(1);
+    }
+
+  LogTest("Single threaded checks are ok, starting %d readers and %d writers",
+          NB_READERS, NB_WRITERS);
+
+  MesureTemps(&debut, NULL);
+
+  for(i = 0; i < NB_WRITERS; i++)
+    if((rc = pthread_create(&thr_writers[i], NULL, writer, (void *)i)) != 0)
+      {
+        LogTest("Test FAILED: pthread_create: Error %d", rc);
+        exit(1);
+      }
+
+  for(i = 0; i < NB_READERS; i++)
+    if((rc = pthread_create(&thr_readers[i], NULL, reader, (void *)(i + 1))) != 0)
+      {
+        LogTest("Test FAILED: pthread_create: Error %d", rc);
+        exit(1);
+      }
+
+  for(i = 0; i < NB_READERS; i++)
+    pthread_join(thr_readers[i], NULL);
+
+  for(i = 0; i < NB_WRITERS; i++)
+    pthread_join(thr_writers[i], NULL);
+
+  MesureTemps(&fin, &debut);
+  LogTest("%d lookups and %d updates in %s", NB_READERS * NB_READ_ITER,
+          NB_WRITE_LOOPS * (MAXTEST - STABLE) * 3, ConvertiTempsChaine(fin, NULL));
+
+  HashTable_GetStats(ht, &statistiques);
+  LogTest("Statistics: entries=%u, ok get=%u, not found get=%u, max chain=%u, avg chain=%u",
+          statistiques.dynamic.nb_entries, statistiques.dynamic.ok.nb_get,
+          statistiques.dynamic.notfound.nb_get, statistiques.computed.max_rbt_num_node,
+          statistiques.computed.average_rbt_num_node);
+
+  if(nb_errors != 0)
+    {
+      LogTest("Test FAILED: %d errors", nb_errors);
+      exit(1);
+    }
+
+  if(HashTable_GetSize(ht) != MAXTEST || statistiques.dynamic.nb_entries != MAXTEST)
+    {
+      LogTest("Test FAILED: %u entries instead of %d", HashTable_GetSize(ht), MAXTEST);
+      exit(1);
+    }
+
+  for(i = 0; i < MAXTEST; i++)
+    {
+      set_buffers(i, NULL, &buffkey, NULL);
+      if(HashTable_Get(ht, &buffkey, &buffval) != HASHTABLE_SUCCESS
+         || buffval.pdata != (i < STABLE ? strval[i] : strval_ovr[i]))
+        {
+          LogTest("Test FAILED: bad final value for key %s", strkey[i]);
+          exit(1);
+        }
+    }
+
+  LogTest("-----------------------------------------");
+  LogTest("Test succeeded: all tests pass successfully");
+
+  exit(0);
+}
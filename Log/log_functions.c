@@ -44,6 +44,7 @@
 #include <string.h>
 #include <signal.h>
 #include <libgen.h>
+#include <sys/uio.h>
 
 #include "log_macros.h"
 //#include "nfs_core.h"
@@ -79,6 +80,10 @@ typedef struct ThreadLogContext_t
 
   char nom_fonction[STR_LEN];
 
+  /* Date of the last message, only formatted again when the second changes */
+  time_t date_time;
+  char date_str[MAX_STR_LEN];
+
 } ThreadLogContext_t;
 
 /* threads keys */
@@ -92,6 +97,40 @@ static pthread_once_t once_key = PTHREAD_ONCE_INIT;
       DisplayLogComponentLevel(COMPONENT_LOG, NIV_NULL, "LOG: " format, ## args ); \
   } while (0)
 
+/*
+ * Asynchronous logging.
+ *
+ * Once the writer thread is started, messages for FILELOG, STDERRLOG and
+ * STDOUTLOG are formatted in the calling thread and copied in a bounded
+ * ring. Producers reserve a slot with a compare and swap on the head, the
+ * sequence number of each slot tells whether it is free or published, so
+ * no lock is taken on the logging path. The writer thread drains the
+ * ring in order and gathers consecutive records going to the same
+ * destination in a single writev. When the ring is full, the message is
+ * dropped and counted.
+ */
+
+#define LOG_RING_SIZE        1024       /* must be a power of two */
+#define LOG_RING_BATCH       64
+#define LOG_WRITER_IDLE      1000       /* usec slept when the ring is empty */
+#define LOG_FLUSH_TIMEOUT    1000       /* number of LOG_WRITER_IDLE waited on flush */
+
+typedef struct log_record_t
+{
+  volatile unsigned long seq;
+  int log_type;
+  log_components_t component;
+  size_t len;
+  char text[STR_LEN_TXT];
+} log_record_t;
+
+static log_record_t *log_ring = NULL;
+static volatile unsigned long log_ring_head = 0;
+static volatile unsigned long log_ring_tail = 0;
+static volatile unsigned long log_dropped = 0;
+static volatile int log_writer_running = 0;
+static pthread_t log_writer_thrid;
+
 #ifdef _DONT_HAVE_LOCALTIME_R
 
 /* Localtime is not reentrant...
@@ -170,6 +209,8 @@ static ThreadLogContext_t *Log_GetThreadContext(int ok_errors)
 
       /* inits thread structures */
       p_current_thread_vars->nom_fonction[0] = '\0';
+      p_current_thread_vars->date_time = (time_t) - 1;
+      p_current_thread_vars->date_str[0] = '\0';
 
       /* set the specific value */
       pthread_setspecific(thread_key, (void *)p_current_thread_vars);
@@ -394,24 +435,48 @@ void InitLogging()
  * Une fonction d'affichage tout a fait generique
  */
 
+static void DisplayLogDate(char *date_str, time_t tm)
+{
+  struct tm the_date;
+
+  Localtime_r(&tm, &the_date);
+
+  snprintf(date_str, MAX_STR_LEN, "%.2d/%.2d/%.4d %.2d:%.2d:%.2d epoch=%ld",
+           the_date.tm_mday, the_date.tm_mon + 1, 1900 + the_date.tm_year,
+           the_date.tm_hour, the_date.tm_min, the_date.tm_sec, tm);
+}                               /* DisplayLogDate */
+
 static void DisplayLogString_valist(char *buff_dest, log_components_t component, char *format, va_list arguments)
 {
   char texte[STR_LEN_TXT];
-  struct tm the_date;
+  char date_str[MAX_STR_LEN];
+  char *pdate = date_str;
   time_t tm;
-  const char *function = Log_GetThreadFunction(component != COMPONENT_LOG_EMERG);
+  ThreadLogContext_t *context = Log_GetThreadContext(component != COMPONENT_LOG_EMERG);
+  const char *function = (context == NULL) ? emergency : context->nom_fonction;
 
   tm = time(NULL);
-  Localtime_r(&tm, &the_date);
+
+  /* The date is kept per thread, Localtime_r is only called once a second */
+  if(context != NULL)
+    {
+      if(context->date_time != tm)
+        {
+          DisplayLogDate(context->date_str, tm);
+          context->date_time = tm;
+        }
+      pdate = context->date_str;
+    }
+  else
+    DisplayLogDate(date_str, tm);
 
   /* Ecriture sur le fichier choisi */
   log_vsnprintf(texte, STR_LEN_TXT, format, arguments);
 
-  snprintf(buff_dest, STR_LEN_TXT, "%.2d/%.2d/%.4d %.2d:%.2d:%.2d epoch=%ld : %s : %s-%d[%s] :%s\n",
-           the_date.tm_mday, the_date.tm_mon + 1, 1900 + the_date.tm_year,
-           the_date.tm_hour, the_date.tm_min, the_date.tm_sec, tm, nom_host,
-           nom_programme, getpid(), function,
-           texte);
+  /* A message too long for the record is cut, the record still ends the line */
+  if(snprintf(buff_dest, STR_LEN_TXT, "%s : %s : %s-%d[%s] :%s\n",
+              pdate, nom_host, nom_programme, getpid(), function, texte) >= STR_LEN_TXT)
+    buff_dest[STR_LEN_TXT - 2] = '\n';
 }                               /* DisplayLogString_valist */
 
 static int DisplayLogSyslog_valist(log_components_t component, int level, char * format, va_list arguments)
@@ -532,6 +597,240 @@ static int DisplayLogPath_valist(char *path, log_components_t component, char *f
   return SUCCES;
 }                               /* DisplayLogPath_valist */
 
+/*
+ * Copies a formatted message in the ring, to be written by the writer thread.
+ * The message is dropped if the ring is full.
+ */
+static int DisplayLogRing_valist(int log_type, log_components_t component, char *format, va_list arguments)
+{
+  char tampon[STR_LEN_TXT];
+  log_record_t *precord;
+  unsigned long pos;
+  long dif;
+
+  DisplayLogString_valist(tampon, component, format, arguments);
+
+  /* Reserve a slot */
+  pos = log_ring_head;
+  for(;;)
+    {
+      precord = &log_ring[pos & (LOG_RING_SIZE - 1)];
+      dif = (long)precord->seq - (long)pos;
+
+      if(dif == 0)
+        {
+          if(__sync_bool_compare_and_swap(&log_ring_head, pos, pos + 1))
+            break;
+        }
+      else if(dif < 0)
+        {
+          /* The writer is late: drop the message */
+          __sync_fetch_and_add(&log_dropped, 1);
+          return ERR_FAILURE;
+        }
+
+      pos = log_ring_head;
+    }
+
+  precord->log_type = log_type;
+  precord->component = component;
+  precord->len = strlen(tampon);
+  memcpy(precord->text, tampon, precord->len);
+
+  /* Publish the record */
+  __sync_synchronize();
+  precord->seq = pos + 1;
+
+  return SUCCES;
+}                               /* DisplayLogRing_valist */
+
+static int SameLogDestination(log_record_t * precord1, log_record_t * precord2)
+{
+  if(precord1->log_type != precord2->log_type)
+    return 0;
+
+  if(precord1->log_type != FILELOG || precord1->component == precord2->component)
+    return 1;
+
+  return !strcmp(LogComponents[precord1->component].comp_log_file,
+                 LogComponents[precord2->component].comp_log_file);
+}                               /* SameLogDestination */
+
+static void WriteLogBatch(log_record_t * pfirst, struct iovec *iov, int nb_iov)
+{
+  char *path;
+  int fd;
+
+  switch (pfirst->log_type)
+    {
+    case STDERRLOG:
+      writev(fileno(stderr), iov, nb_iov);
+      break;
+
+    case STDOUTLOG:
+      writev(fileno(stdout), iov, nb_iov);
+      break;
+
+    case FILELOG:
+      /* The file is opened once per batch, so that log rotation still works */
+      path = LogComponents[pfirst->component].comp_log_file;
+
+      if((fd = open(path, O_WRONLY | O_APPEND | O_CREAT, masque_log)) == -1)
+        {
+          fprintf(stderr, "Error %s : %s : status %d on file %s message was:\n%.*s\n",
+                  tab_systeme_err[ERR_FICHIER_LOG].label,
+                  tab_systeme_err[ERR_FICHIER_LOG].msg, errno, path,
+                  (int)pfirst->len, pfirst->text);
+          break;
+        }
+
+#ifdef _LOCK_LOG
+      {
+        struct flock lock_file;
+
+        lock_file.l_type = F_WRLCK;
+        lock_file.l_whence = SEEK_SET;
+        lock_file.l_start = 0;
+        lock_file.l_len = 0;
+
+        if(fcntl(fd, F_SETLKW, (char *)&lock_file) != -1)
+          {
+            writev(fd, iov, nb_iov);
+
+            lock_file.l_type = F_UNLCK;
+            fcntl(fd, F_SETLKW, (char *)&lock_file);
+          }
+      }
+#else
+      writev(fd, iov, nb_iov);
+#endif
+      close(fd);
+      break;
+    }
+}                               /* WriteLogBatch */
+
+/*
+ * The writer thread: drains the ring in order, by batches of records going
+ * to the same destination.
+ */
+static void *LogWriterThread(void *arg)
+{
+  struct iovec iov[LOG_RING_BATCH];
+  log_record_t *pfirst = NULL;
+  log_record_t *precord;
+  unsigned long dropped_reported = 0;
+  unsigned long dropped;
+  int nb, i;
+
+  SetNameFunction("log_writer");
+
+  for(;;)
+    {
+      for(nb = 0; nb < LOG_RING_BATCH; nb++)
+        {
+          precord = &log_ring[(log_ring_tail + nb) & (LOG_RING_SIZE - 1)];
+
+          if(precord->seq != log_ring_tail + nb + 1)
+            break;
+
+          if(nb == 0)
+            pfirst = precord;
+          else if(!SameLogDestination(pfirst, precord))
+            break;
+
+          iov[nb].iov_base = precord->text;
+          iov[nb].iov_len = precord->len;
+        }
+
+      if(nb == 0)
+        {
+          /* Nothing to write, report the dropped messages if any */
+          dropped = log_dropped;
+          if(dropped != dropped_reported)
+            {
+              LogMajor(COMPONENT_LOG, "%lu log messages were dropped, the log ring was full",
+                       dropped - dropped_reported);
+              dropped_reported = dropped;
+              continue;
+            }
+
+          usleep(LOG_WRITER_IDLE);
+          continue;
+        }
+
+      /* Do not read the records before their sequence numbers */
+      __sync_synchronize();
+
+      WriteLogBatch(pfirst, iov, nb);
+
+      /* Give the slots back to the producers */
+      __sync_synchronize();
+      for(i = 0; i < nb; i++)
+        log_ring[(log_ring_tail + i) & (LOG_RING_SIZE - 1)].seq =
+            log_ring_tail + i + LOG_RING_SIZE;
+
+      log_ring_tail += nb;
+    }
+
+  return NULL;
+}                               /* LogWriterThread */
+
+/*
+ * Waits for the writer thread to write the messages already in the ring.
+ */
+void FlushLogWriter(void)
+{
+  int i;
+
+  if(!log_writer_running)
+    return;
+
+  for(i = 0; i < LOG_FLUSH_TIMEOUT && log_ring_tail != log_ring_head; i++)
+    usleep(LOG_WRITER_IDLE);
+}                               /* FlushLogWriter */
+
+/*
+ * Starts the writer thread, FILELOG, STDERRLOG and STDOUTLOG messages are
+ * then written asynchronously. Messages still in the ring are flushed at exit.
+ */
+int StartLogWriter(void)
+{
+  unsigned long i;
+  int rc;
+
+  if(log_writer_running)
+    return 0;
+
+  if((log_ring = (log_record_t *) malloc(LOG_RING_SIZE * sizeof(log_record_t))) == NULL)
+    {
+      errno = ENOMEM;
+      return -1;
+    }
+
+  for(i = 0; i < LOG_RING_SIZE; i++)
+    log_ring[i].seq = i;
+
+  log_ring_head = 0;
+  log_ring_tail = 0;
+
+  if((rc = pthread_create(&log_writer_thrid, NULL, LogWriterThread, NULL)) != 0)
+    {
+      free(log_ring);
+      log_ring = NULL;
+      errno = rc;
+      return -1;
+    }
+
+  pthread_detach(log_writer_thrid);
+
+  __sync_synchronize();
+  log_writer_running = 1;
+
+  atexit(FlushLogWriter);
+
+  return 0;
+}                               /* StartLogWriter */
+
 /*
  *
  * Les routines de gestions des messages d'erreur
@@ -1511,6 +1810,17 @@ int DisplayLogComponentLevel(log_components_t component, int level, char *format
 
   va_start(arguments, format);
 
+  if(log_writer_running &&
+     (LogComponents[component].comp_log_type == FILELOG ||
+      LogComponents[component].comp_log_type == STDERRLOG ||
+      LogComponents[component].comp_log_type == STDOUTLOG))
+    {
+      rc = DisplayLogRing_valist(LogComponents[component].comp_log_type, component,
+                                 format, arguments);
+      va_end(arguments);
+      return rc;
+    }
+
   switch(LogComponents[component].comp_log_type)
     {
     case SYSLOG:
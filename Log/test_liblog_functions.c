@@ -487,7 +487,7 @@ void *run_MT_Tests(void *arg)
   return NULL ;
 }
 
-static char usage[] = "usage:\n\ttest_liblog STD|MT\n";
+static char usage[] = "usage:\n\ttest_liblog STD|MT|ASYNC\n";
 
 #define NB_THREADS 20
 
@@ -522,9 +522,9 @@ int main(int argc, char *argv[])
           run_Tests(TRUE,  "monothread", str, file);
         }
 
-      /* TEST 1 multithread */
+      /* TEST 1 multithread, ASYNC goes through the log writer thread */
 
-      else if(!strcmp(argv[1], "MT"))
+      else if(!strcmp(argv[1], "MT") || !strcmp(argv[1], "ASYNC"))
         {
 
           /* multithread test */
@@ -537,6 +537,13 @@ int main(int argc, char *argv[])
           SetNameHost("localhost");
           SetDefaultLogging("STDOUT");
           InitLogging();
+
+          if(!strcmp(argv[1], "ASYNC") && StartLogWriter() != 0)
+            {
+              fprintf(stderr, "StartLogWriter failed: errno=%d\n", errno);
+              return 1;
+            }
+
           AddFamilyError(ERR_POSIX, "POSIX Errors", tab_systeme_status);
           LogTest("AddFamilyError = %d", AddFamilyError(ERR_DUMMY, "Family Dummy", tab_test_err));
           LogTest("The family which was added is %s", ReturnNameFamilyError(ERR_DUMMY));
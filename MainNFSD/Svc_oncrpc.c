@@ -14,6 +14,7 @@ typedef unsigned long u_long;
 
 #include   <sys/errno.h>
 #include   "stuff_alloc.h"
+#include   "nfs_rpc_epoll.h"
 
 #include   <rpc/rpc.h>
 #include   <rpc/auth.h>
@@ -24,7 +25,7 @@ typedef unsigned long u_long;
 #define __FDS_BITS(set) ((set)->fds_bits)
 #endif
 
-SVCXPRT *Xports[FD_SETSIZE];
+SVCXPRT *Xports[XPRT_TABLE_SIZE];
 
 #define NULL_SVC ((struct svc_callout *)0)
 #define	RQCRED_SIZE	400     /* this size is excessive */
@@ -73,9 +74,10 @@ void Xprt_register(SVCXPRT * xprt)
   register int sock = xprt->xp_sock;
 #endif
 
+  if(sock < XPRT_TABLE_SIZE)
+    Xports[sock] = xprt;
   if(sock < FD_SETSIZE)
     {
-      Xports[sock] = xprt;
       FD_SET(sock, &Svc_fdset);
       mysvc_maxfd = max(mysvc_maxfd, sock);
 
@@ -94,7 +96,9 @@ void Xprt_unregister(SVCXPRT * xprt)
   register int sock = xprt->xp_sock;
 #endif
 
-  if((sock < FD_SETSIZE) && (Xports[sock] == xprt))
+  if((sock >= FD_SETSIZE) && (sock < XPRT_TABLE_SIZE) && (Xports[sock] == xprt))
+    Xports[sock] = (SVCXPRT *) 0;
+  else if((sock < FD_SETSIZE) && (Xports[sock] == xprt))
     {
       Xports[sock] = (SVCXPRT *) 0;
 
@@ -32,10 +32,15 @@ typedef unsigned int u_int32_t;
 
 #include   <sys/socket.h>
 #include   <sys/poll.h>
+#include   <sys/uio.h>
+#include   <netinet/in.h>
 #include   <errno.h>
+#include   <fcntl.h>
 #include   <pthread.h>
 
 #include   "log_macros.h"
+#include   "xdr_zerocopy.h"
+#include   "nfs_rpc_epoll.h"
 
 #ifndef MAX
 #define MAX(a, b)     ((a > b) ? a : b)
@@ -104,8 +109,28 @@ struct tcp_conn
   u_long x_id;
   XDR xdrs;
   char verf_body[MAX_AUTH_BYTES];
+  u_int sendsize;
+#ifdef _USE_EPOLL
+  nfs_rpc_record_buffer_t record;       /* what was read from the non blocking socket */
+#endif
 };
 
+/* Size of the reply buffer when the transport uses the system default */
+#define TCP_REPLY_DEFAULT_SIZE 65536
+
+/* Record mark, header pieces, data and padding of each segment */
+#define TCP_REPLY_MAX_IOV (2 + 3 * XDR_ZEROCOPY_MAX_SEGMENTS)
+
+/* Replies are encoded in a buffer of the worker thread */
+typedef struct tcp_reply_buffer__
+{
+  u_int size;
+  char *buff;
+} tcp_reply_buffer_t;
+
+static pthread_key_t reply_buffer_key;
+static pthread_once_t reply_buffer_once = PTHREAD_ONCE_INIT;
+
 /*
  * Usage:
  *	xprt = svctcp_create(sock, send_buf_size, recv_buf_size);
@@ -214,6 +239,10 @@ static SVCXPRT *Makefd_xprt(int fd, u_int sendsize, u_int recvsize)
       goto done;
     }
   cd->strm_stat = XPRT_IDLE;
+  cd->sendsize = (sendsize != 0) ? sendsize : TCP_REPLY_DEFAULT_SIZE;
+#ifdef _USE_EPOLL
+  memset(&(cd->record), 0, sizeof(nfs_rpc_record_buffer_t));
+#endif
   xdrrec_create(&(cd->xdrs), sendsize, recvsize, (caddr_t) xprt, Readtcp, Writetcp);
   xprt->xp_p2 = NULL;
   xprt->xp_p1 = (caddr_t) cd;
@@ -271,6 +300,7 @@ void print_xdrrec_fbtbc(char *tag, SVCXPRT * xprt)
 
 void *rpc_tcp_socket_manager_thread(void *Arg);
 extern fd_set Svc_fdset;
+int nfs_rpc_epoll_add(int sock);
 
 static bool_t Rendezvous_request(register SVCXPRT * xprt)
 {
@@ -278,10 +308,10 @@ static bool_t Rendezvous_request(register SVCXPRT * xprt)
   struct tcp_rendezvous *r;
   struct sockaddr_in addr;
   unsigned long len;
-
+#ifndef _USE_EPOLL
   pthread_attr_t attr_thr;
   pthread_t sockmgr_thrid;
-  int rc = 0;
+#endif
 
   r = (struct tcp_rendezvous *)xprt->xp_p1;
  again:
@@ -307,6 +337,15 @@ static bool_t Rendezvous_request(register SVCXPRT * xprt)
   memcpy(&(xprt->xp_raddr), &addr, sizeof(addr));
   xprt->xp_addrlen = len;
 
+#ifdef _USE_EPOLL
+  /* The connection is watched by the event threads, which must never wait on it */
+  if(xprt->xp_sock < FD_SETSIZE)
+    FD_CLR(xprt->xp_sock, &Svc_fdset);
+
+  if(fcntl(xprt->xp_sock, F_SETFL, fcntl(xprt->xp_sock, F_GETFL) | O_NONBLOCK) != 0
+     || nfs_rpc_epoll_add(xprt->xp_sock) != 0)
+    SVC_DESTROY(xprt);
+#else
   /* Spawns a new thread to handle the connection */
   pthread_attr_init(&attr_thr);
   pthread_attr_setscope(&attr_thr, PTHREAD_SCOPE_SYSTEM);
@@ -321,9 +360,8 @@ static bool_t Rendezvous_request(register SVCXPRT * xprt)
     return FALSE;
   etat_xprt[xprt->xp_fd] = 0;
 
-  if((rc =
-      pthread_create(&sockmgr_thrid, &attr_thr, rpc_tcp_socket_manager_thread,
-                     (void *)((unsigned long)xprt->xp_fd))) != 0)
+  if(pthread_create(&sockmgr_thrid, &attr_thr, rpc_tcp_socket_manager_thread,
+                    (void *)((unsigned long)xprt->xp_fd)) != 0)
     return FALSE;
 #else
   FD_CLR(xprt->xp_sock, &Svc_fdset);
@@ -334,12 +372,12 @@ static bool_t Rendezvous_request(register SVCXPRT * xprt)
     return FALSE;
   etat_xprt[xprt->xp_sock] = 0;
 
-  if((rc =
-      pthread_create(&sockmgr_thrid, &attr_thr, rpc_tcp_socket_manager_thread,
-                     (void *)((unsigned long)xprt->xp_sock))) != 0)
+  if(pthread_create(&sockmgr_thrid, &attr_thr, rpc_tcp_socket_manager_thread,
+                    (void *)((unsigned long)xprt->xp_sock)) != 0)
     return FALSE;
 
 #endif
+#endif                          /* _USE_EPOLL */
 
   return (FALSE);               /* there is never an rpc msg to be processed */
 }
@@ -369,12 +407,54 @@ static void Svctcp_destroy(register SVCXPRT * xprt)
     {
       /* an actual connection socket */
       XDR_DESTROY(&(cd->xdrs));
+#ifdef _USE_EPOLL
+      nfs_rpc_record_free(&(cd->record));
+#endif
     }
 
   Mem_Free((caddr_t) cd);
   Mem_Free((caddr_t) xprt);
 }
 
+#ifdef _USE_EPOLL
+/*
+ * fills the record buffer of a connection from its non blocking socket.
+ * Called by the event threads when the socket is readable.
+ */
+int Xprt_fill_record(SVCXPRT * xprt)
+{
+  struct tcp_conn *cd;
+  int rc;
+
+  /* only the connected sockets are buffered */
+  if(xprt->xp_ops != &Svctcp_op)
+    return NFS_RPC_RECORD_READY;
+
+  cd = (struct tcp_conn *)(xprt->xp_p1);
+  rc = nfs_rpc_record_fill(xprt->xp_sock, &(cd->record));
+
+  if(rc == NFS_RPC_RECORD_DEAD)
+    cd->strm_stat = XPRT_DIED;
+
+  return rc;
+}
+
+/*
+ * reads data from the record buffer of the connection.
+ * Only complete records are buffered, so this never waits for the client.
+ * Reading past them is fatal and the connection is closed.
+ */
+int Readtcp(register SVCXPRT * xprt, caddr_t buf, register int len)
+{
+  register struct tcp_conn *cd = (struct tcp_conn *)(xprt->xp_p1);
+
+  if((len = nfs_rpc_record_read(&(cd->record), buf, len)) > 0)
+    return (len);
+
+  cd->strm_stat = XPRT_DIED;
+  return (-1);
+}
+#else
 /*
  * reads data from the tcp conection.
  * any error is fatal and the connection is closed.
@@ -440,6 +520,33 @@ int Readtcp(register SVCXPRT * xprt, caddr_t buf, register int len)
   ((struct tcp_conn *)(xprt->xp_p1))->strm_stat = XPRT_DIED;
   return (-1);
 }
+#endif                          /* _USE_EPOLL */
+
+/*
+ * waits until the socket can be written again.
+ * This only happens with the non blocking sockets of the event threads.
+ * A timeout after 35 seconds is fatal for the connection.
+ */
+static int Waittcp(register SVCXPRT * xprt)
+{
+  struct pollfd pollfd;
+
+  if(errno != EAGAIN && errno != EWOULDBLOCK)
+    return (-1);
+
+#ifdef _FREEBSD
+  pollfd.fd = xprt->xp_fd;
+#else
+  pollfd.fd = xprt->xp_sock;
+#endif
+  pollfd.events = POLLOUT;
+
+  while(poll(&pollfd, 1, 35 * 1000) < 0)
+    if(errno != EINTR)
+      return (-1);
+
+  return ((pollfd.revents & POLLOUT) ? 0 : -1);
+}
 
 /*
  * writes data to the tcp connection.
@@ -461,6 +568,10 @@ int Writetcp(register SVCXPRT * xprt, caddr_t buf, int len)
 #endif
       if(i < 0)
         {
+          i = 0;
+          if(errno == EINTR || Waittcp(xprt) == 0)
+            continue;
+
           ((struct tcp_conn *)(xprt->xp_p1))->strm_stat = XPRT_DIED;
           return (-1);
         }
@@ -468,6 +579,178 @@ int Writetcp(register SVCXPRT * xprt, caddr_t buf, int len)
   return (len);
 }
 
+/*
+ * writes a set of buffers to the tcp connection.
+ * Any error is fatal and the connection is closed.
+ */
+static int Writevtcp(register SVCXPRT * xprt, struct iovec *iov, int iovcnt)
+{
+  ssize_t i;
+
+  while(iovcnt > 0)
+    {
+#ifdef _FREEBSD
+      i = writev(xprt->xp_fd, iov, iovcnt);
+#else
+      i = writev(xprt->xp_sock, iov, iovcnt);
+#endif
+      if(i < 0)
+        {
+          if(errno == EINTR || Waittcp(xprt) == 0)
+            continue;
+
+          ((struct tcp_conn *)(xprt->xp_p1))->strm_stat = XPRT_DIED;
+          return (-1);
+        }
+
+      /* Skip what was written */
+      while(iovcnt > 0 && (size_t) i >= iov->iov_len)
+        {
+          i -= iov->iov_len;
+          iov++;
+          iovcnt--;
+        }
+
+      if(iovcnt > 0)
+        {
+          iov->iov_base = (char *)iov->iov_base + i;
+          iov->iov_len -= i;
+        }
+    }
+
+  return (0);
+}
+
+static void Reply_buffer_init_keys(void)
+{
+  if(pthread_key_create(&reply_buffer_key, NULL) == -1)
+    LogCrit(COMPONENT_DISPATCH, "Svctcp: pthread_key_create returned %d", errno);
+}
+
+/*
+ * Returns the reply buffer of the current thread, at least size bytes long.
+ */
+static char *Reply_buffer_get(u_int size)
+{
+  tcp_reply_buffer_t *preply_buffer;
+
+  if(pthread_once(&reply_buffer_once, Reply_buffer_init_keys) != 0)
+    return NULL;
+
+  if((preply_buffer = (tcp_reply_buffer_t *) pthread_getspecific(reply_buffer_key)) == NULL)
+    {
+      if((preply_buffer =
+          (tcp_reply_buffer_t *) Mem_Alloc(sizeof(tcp_reply_buffer_t))) == NULL)
+        return NULL;
+
+      preply_buffer->size = 0;
+      preply_buffer->buff = NULL;
+
+      pthread_setspecific(reply_buffer_key, (void *)preply_buffer);
+    }
+
+  if(preply_buffer->size < size)
+    {
+      if(preply_buffer->buff != NULL)
+        Mem_Free(preply_buffer->buff);
+
+      if((preply_buffer->buff = (char *)Mem_Alloc(size)) == NULL)
+        {
+          preply_buffer->size = 0;
+          return NULL;
+        }
+
+      preply_buffer->size = size;
+    }
+
+  return preply_buffer->buff;
+}
+
+/*
+ * Encodes a reply in memory and sends it as a single record with writev:
+ * the opaque data referenced by the results (READ payloads) are sent from
+ * their own buffers and are never copied.
+ *
+ * Returns 0 if the reply was sent, -1 if the connection died, and 1 if the
+ * reply did not fit in the reply buffer and must go through the stream.
+ */
+static int Svctcp_reply_zerocopy(SVCXPRT * xprt, struct rpc_msg *msg,
+                                 xdrproc_t xdr_proc, caddr_t xdr_where)
+{
+  register struct tcp_conn *cd = (struct tcp_conn *)(xprt->xp_p1);
+  static char zero_pad[BYTES_PER_XDR_UNIT] = { 0, 0, 0, 0 };
+  struct iovec iov[TCP_REPLY_MAX_IOV];
+  xdr_zerocopy_t zerocopy;
+  xdr_zerocopy_segment_t *psegment;
+  XDR xdrs_mem;
+  char *buff;
+  u_int len, prev, pad, total, i;
+  u_int32_t record_mark;
+  int iovcnt;
+  bool_t encoded;
+
+  if((buff = Reply_buffer_get(cd->sendsize)) == NULL)
+    return (1);
+
+  xdrmem_create(&xdrs_mem, buff, cd->sendsize, XDR_ENCODE);
+
+  xdr_zerocopy_begin(&zerocopy, &xdrs_mem);
+  encoded = xdr_replymsg(&xdrs_mem, msg) &&
+      SVCAUTH_WRAP(NULL, &xdrs_mem, xdr_proc, xdr_where);
+  xdr_zerocopy_end();
+
+  if(!encoded)
+    return (1);
+
+  len = XDR_GETPOS(&xdrs_mem);
+
+  /* The encoded header is cut where the referenced data go */
+  iovcnt = 1;
+  total = len;
+  prev = 0;
+
+  for(i = 0; i < zerocopy.nb_segments; i++)
+    {
+      psegment = &zerocopy.segments[i];
+
+      if(psegment->offset > prev)
+        {
+          iov[iovcnt].iov_base = buff + prev;
+          iov[iovcnt].iov_len = psegment->offset - prev;
+          iovcnt++;
+        }
+
+      iov[iovcnt].iov_base = psegment->data;
+      iov[iovcnt].iov_len = psegment->len;
+      iovcnt++;
+
+      pad = RNDUP(psegment->len) - psegment->len;
+      if(pad > 0)
+        {
+          iov[iovcnt].iov_base = zero_pad;
+          iov[iovcnt].iov_len = pad;
+          iovcnt++;
+        }
+
+      total += psegment->len + pad;
+      prev = psegment->offset;
+    }
+
+  if(len > prev)
+    {
+      iov[iovcnt].iov_base = buff + prev;
+      iov[iovcnt].iov_len = len - prev;
+      iovcnt++;
+    }
+
+  /* The whole reply is the last (and only) fragment of the record */
+  record_mark = htonl(0x80000000 | total);
+  iov[0].iov_base = &record_mark;
+  iov[0].iov_len = sizeof(record_mark);
+
+  return Writevtcp(xprt, iov, iovcnt);
+}
+
 static enum xprt_stat Svctcp_stat(SVCXPRT * xprt)
 {
   register struct tcp_conn *cd = (struct tcp_conn *)(xprt->xp_p1);
@@ -476,6 +759,10 @@ static enum xprt_stat Svctcp_stat(SVCXPRT * xprt)
     return (XPRT_DIED);
   if(!xdrrec_eof(&(cd->xdrs)))
     return (XPRT_MOREREQS);
+#ifdef _USE_EPOLL
+  if(nfs_rpc_record_pending(&(cd->record)))
+    return (XPRT_MOREREQS);
+#endif
   return (XPRT_IDLE);
 }
 
@@ -527,6 +814,19 @@ static bool_t Svctcp_reply(SVCXPRT * xprt, register struct rpc_msg *msg)
       msg->acpted_rply.ar_results.proc = (xdrproc_t) xdr_void;
       msg->acpted_rply.ar_results.where = NULL;
 
+      switch (Svctcp_reply_zerocopy(xprt, msg, xdr_proc, xdr_where))
+        {
+        case 0:
+          return (TRUE);
+
+        case -1:
+          return (FALSE);
+
+        default:
+          /* Too big for the reply buffer, use the stream */
+          break;
+        }
+
       if(!xdr_replymsg(xdrs, msg) || !SVCAUTH_WRAP(NULL, xdrs, xdr_proc, xdr_where))
         return (FALSE);
     }
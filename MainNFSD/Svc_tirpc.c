@@ -56,6 +56,7 @@
 #include <Rpc_com_tirpc.h>
 #include "stuff_alloc.h"
 #include "RW_Lock.h"
+#include "nfs_rpc_epoll.h"
 
 #define	RQCRED_SIZE	400     /* this size is excessive */
 
@@ -66,7 +67,7 @@
 
 /* public data : */
 fd_set Svc_fdset;
-SVCXPRT *Xports[FD_SETSIZE];
+SVCXPRT *Xports[XPRT_TABLE_SIZE];
 
 extern rw_lock_t Svc_lock;
 extern rw_lock_t Svc_fd_lock;
@@ -103,9 +104,10 @@ SVCXPRT *xprt;
   sock = xprt->xp_fd;
 
   P_w(&Svc_fd_lock);
+  if(sock < XPRT_TABLE_SIZE)
+    Xports[sock] = xprt;
   if(sock < FD_SETSIZE)
     {
-      Xports[sock] = xprt;
       FD_SET(sock, &Svc_fdset);
       svc_maxfd = max(svc_maxfd, sock);
     }
@@ -138,7 +140,9 @@ bool_t dolock;
   if(dolock)
     P_w(&Svc_fd_lock);
 
-  if((sock < FD_SETSIZE) && (Xports[sock] == xprt))
+  if((sock >= FD_SETSIZE) && (sock < XPRT_TABLE_SIZE) && (Xports[sock] == xprt))
+    Xports[sock] = NULL;
+  else if((sock < FD_SETSIZE) && (Xports[sock] == xprt))
     {
       Xports[sock] = NULL;
       FD_CLR(sock, &Svc_fdset);
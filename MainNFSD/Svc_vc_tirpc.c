@@ -70,6 +70,7 @@
 #include <Rpc_com_tirpc.h>
 #include "stuff_alloc.h"
 #include "RW_Lock.h"
+#include "nfs_rpc_epoll.h"
 #include <pthread.h>
 
 int getpeereid(int s, uid_t * euid, gid_t * egid);
@@ -78,13 +79,14 @@ pthread_mutex_t mutex_cond_xprt[FD_SETSIZE];
 pthread_cond_t condvar_xprt[FD_SETSIZE];
 int etat_xprt[FD_SETSIZE];
 
-extern SVCXPRT **Xports;
+extern SVCXPRT *Xports[XPRT_TABLE_SIZE];
 extern rw_lock_t Svc_fd_lock;
 extern fd_set Svc_fdset;
 
 extern void Xprt_register(SVCXPRT *);
 extern void Xprt_unregister(SVCXPRT *);
 extern void *rpc_tcp_socket_manager_thread(void *Arg);
+extern int nfs_rpc_epoll_add(int sock);
 
 static SVCXPRT *Makefd_xprt(int, u_int, u_int);
 static bool_t Rendezvous_request(SVCXPRT *, struct rpc_msg *);
@@ -121,6 +123,9 @@ struct cf_conn
   int maxrec;
   bool_t nonblock;
   struct timeval last_recv_time;
+#ifdef _USE_EPOLL
+  nfs_rpc_record_buffer_t record;       /* what was read from the non blocking socket */
+#endif
 };
 
 static void map_ipv4_to_ipv6(sin, sin6)
@@ -319,6 +324,9 @@ u_int recvsize;
       goto done;
     }
   cd->strm_stat = XPRT_IDLE;
+#ifdef _USE_EPOLL
+  memset(&(cd->record), 0, sizeof(nfs_rpc_record_buffer_t));
+#endif
   xdrrec_create(&(cd->xdrs), sendsize, recvsize, xprt, Read_vc, Write_vc);
   xprt->xp_p1 = cd;
   xprt->xp_verf.oa_base = cd->verf_body;
@@ -346,10 +354,10 @@ struct rpc_msg *msg;
   struct __rpc_sockinfo si;
   SVCXPRT *newxprt;
   fd_set cleanfds;
-
+#ifndef _USE_EPOLL
   pthread_attr_t attr_thr;
   pthread_t sockmgr_thrid;
-  int rc = 0;
+#endif
 
   assert(xprt != NULL);
   assert(msg != NULL);
@@ -417,6 +425,10 @@ struct rpc_msg *msg;
   cd->sendsize = r->sendsize;
   cd->maxrec = r->maxrec;
 
+#ifdef _USE_EPOLL
+  /* The event threads buffer the records themselves */
+  cd->maxrec = 0;
+#endif
   if(cd->maxrec != 0)
     {
       flags = fcntl(sock, F_GETFL, 0);
@@ -433,6 +445,15 @@ struct rpc_msg *msg;
     cd->nonblock = FALSE;
   gettimeofday(&cd->last_recv_time, NULL);
 
+#ifdef _USE_EPOLL
+  /* The connection is watched by the event threads, which must never wait on it */
+  if(newxprt->xp_fd < FD_SETSIZE)
+    FD_CLR(newxprt->xp_fd, &Svc_fdset);
+
+  if(fcntl(sock, F_SETFL, fcntl(sock, F_GETFL) | O_NONBLOCK) != 0
+     || nfs_rpc_epoll_add(newxprt->xp_fd) != 0)
+    SVC_DESTROY(newxprt);
+#else
   /* Spawns a new thread to handle the connection */
   pthread_attr_init(&attr_thr);
   pthread_attr_setscope(&attr_thr, PTHREAD_SCOPE_SYSTEM);
@@ -448,10 +469,10 @@ struct rpc_msg *msg;
 
   etat_xprt[newxprt->xp_fd] = 0;
 
-  if((rc =
-      pthread_create(&sockmgr_thrid, &attr_thr, rpc_tcp_socket_manager_thread,
-                     (void *)(newxprt->xp_fd))) != 0)
+  if(pthread_create(&sockmgr_thrid, &attr_thr, rpc_tcp_socket_manager_thread,
+                    (void *)(newxprt->xp_fd)) != 0)
     return FALSE;
+#endif                          /* _USE_EPOLL */
 
   return (FALSE);               /* there is never an rpc msg to be processed */
 }
@@ -493,6 +514,9 @@ SVCXPRT *xprt;
     {
       /* an actual connection socket */
       XDR_DESTROY(&(cd->xdrs));
+#ifdef _USE_EPOLL
+      nfs_rpc_record_free(&(cd->record));
+#endif
       Mem_Free(cd);
     }
   if(xprt->xp_rtaddr.buf)
@@ -538,6 +562,56 @@ void *in;
   return (TRUE);
 }
 
+#ifdef _USE_EPOLL
+/*
+ * fills the record buffer of a connection from its non blocking socket.
+ * Called by the event threads when the socket is readable.
+ */
+int Xprt_fill_record(SVCXPRT * xprt)
+{
+  struct cf_conn *cd;
+  int rc;
+
+  /* only the connected sockets are buffered */
+  if(xprt->xp_ops->xp_recv != Svc_vc_recv)
+    return NFS_RPC_RECORD_READY;
+
+  cd = (struct cf_conn *)xprt->xp_p1;
+  rc = nfs_rpc_record_fill(xprt->xp_fd, &(cd->record));
+
+  if(rc == NFS_RPC_RECORD_DEAD)
+    cd->strm_stat = XPRT_DIED;
+  else
+    gettimeofday(&cd->last_recv_time, NULL);
+
+  return rc;
+}
+
+/*
+ * reads data from the record buffer of the connection.
+ * Only complete records are buffered, so this never waits for the client.
+ * Reading past them is fatal and the connection is closed.
+ */
+static int Read_vc(xprtp, buf, len)
+void *xprtp;
+void *buf;
+int len;
+{
+  SVCXPRT *xprt;
+  struct cf_conn *cfp;
+
+  xprt = (SVCXPRT *) xprtp;
+  assert(xprt != NULL);
+
+  cfp = (struct cf_conn *)xprt->xp_p1;
+
+  if((len = nfs_rpc_record_read(&(cfp->record), buf, len)) > 0)
+    return (len);
+
+  cfp->strm_stat = XPRT_DIED;
+  return (-1);
+}
+#else
 /*
  * reads data from the tcp or uip connection.
  * any error is fatal and the connection is closed.
@@ -607,6 +681,31 @@ int len;
   ((struct cf_conn *)(xprt->xp_p1))->strm_stat = XPRT_DIED;
   return (-1);
 }
+#endif                          /* _USE_EPOLL */
+
+#ifdef _USE_EPOLL
+/*
+ * waits until the non blocking socket of the event threads can be written again.
+ * A timeout after 35 seconds is fatal for the connection.
+ */
+static int Wait_vc(SVCXPRT * xprt)
+{
+  struct pollfd pollfd;
+
+  if(errno != EAGAIN && errno != EWOULDBLOCK)
+    return (-1);
+
+  pollfd.fd = xprt->xp_fd;
+  pollfd.events = POLLOUT;
+  pollfd.revents = 0;
+
+  while(poll(&pollfd, 1, 35 * 1000) < 0)
+    if(errno != EINTR)
+      return (-1);
+
+  return ((pollfd.revents & POLLOUT) ? 0 : -1);
+}
+#endif                          /* _USE_EPOLL */
 
 /*
  * writes data to the tcp connection.
@@ -635,6 +734,11 @@ int len;
       i = write(xprt->xp_fd, buf, (size_t) cnt);
       if(i < 0)
         {
+#ifdef _USE_EPOLL
+          i = 0;
+          if(errno == EINTR || Wait_vc(xprt) == 0)
+            continue;
+#endif
           if(errno != EAGAIN || !cd->nonblock)
             {
               cd->strm_stat = XPRT_DIED;
@@ -675,6 +779,10 @@ SVCXPRT *xprt;
     return (XPRT_DIED);
   if(!xdrrec_eof(&(cd->xdrs)))
     return (XPRT_MOREREQS);
+#ifdef _USE_EPOLL
+  if(nfs_rpc_record_pending(&(cd->record)))
+    return (XPRT_MOREREQS);
+#endif
   return (XPRT_IDLE);
 }
 
@@ -51,6 +51,8 @@
 #include <arpa/inet.h>
 #include <string.h>
 #include <pthread.h>
+#include <errno.h>
+#include <unistd.h>             /* for having sysconf */
 #include <fcntl.h>
 #include <sys/file.h>           /* for having FNDELAY */
 #include <pwd.h>
@@ -93,8 +95,131 @@ extern nfs_function_desc_t nlm4_func_desc[];
 extern nfs_function_desc_t rquota1_func_desc[];
 extern nfs_function_desc_t rquota2_func_desc[];
 #endif                          /* _USE_QUOTA */
-/* Structure used for duplicated request cache */
-hash_table_t *ht_dupreq;
+/* Duplicate request cache, split in shards (one per CPU by default) */
+static dupreq_shard_t *dupreq_shards = NULL;
+static unsigned int dupreq_nb_shards = 0;
+static hash_parameter_t dupreq_hparam;
+
+/* Key of the request currently managed by each thread (see get_rpc_xid) */
+static pthread_key_t dupreq_thread_key;
+static pthread_once_t dupreq_once_key = PTHREAD_ONCE_INIT;
+
+/* Init of pthread_keys */
+static void dupreq_init_keys(void)
+{
+  if(pthread_key_create(&dupreq_thread_key, NULL) == -1)
+    LogCrit(COMPONENT_DUPREQ, "NFS DUPREQ: pthread_key_create returned %d", errno);
+}                               /* dupreq_init_keys */
+
+/**
+ *
+ * dupreq_thread_context: gets the key of the request managed by the current thread.
+ *
+ * @return a pointer to the thread specific key, NULL if it could not be allocated.
+ *
+ */
+static dupreq_key_t *dupreq_thread_context(void)
+{
+  dupreq_key_t *pkey;
+
+  if(pthread_once(&dupreq_once_key, dupreq_init_keys) != 0)
+    return NULL;
+
+  if((pkey = (dupreq_key_t *) pthread_getspecific(dupreq_thread_key)) == NULL)
+    {
+      if((pkey = (dupreq_key_t *) Mem_Alloc(sizeof(dupreq_key_t))) == NULL)
+        return NULL;
+
+      memset((char *)pkey, 0, sizeof(dupreq_key_t));
+      pthread_setspecific(dupreq_thread_key, (void *)pkey);
+    }
+
+  return pkey;
+}                               /* dupreq_thread_context */
+
+/**
+ *
+ * dupreq_checksum: computes a FNV-1a checksum on a buffer.
+ *
+ * @param buff [IN] the buffer to checksum
+ * @param len [IN] its length
+ *
+ * @return the checksum.
+ *
+ */
+static unsigned int dupreq_checksum(const unsigned char *buff, unsigned int len)
+{
+  unsigned int sum = 2166136261U;
+  unsigned int i;
+
+  for(i = 0; i < len; i++)
+    {
+      sum ^= buff[i];
+      sum *= 16777619U;
+    }
+
+  return sum;
+}                               /* dupreq_checksum */
+
+/**
+ *
+ * dupreq_set_key: builds the dupreq key of a request, without the checksum.
+ *
+ * The key is made of the xid, the program/version/procedure triplet and the caller's
+ * address and port, so that xids reused by different clients do not collide.
+ *
+ * @param reqp [IN] the request
+ * @param xid [IN] the request's xid
+ * @param pkey [OUT] the resulting key
+ *
+ * @return nothing (void function)
+ *
+ */
+static void dupreq_set_key(struct svc_req *reqp, long xid, dupreq_key_t * pkey)
+{
+  struct sockaddr *psa;
+#ifdef _USE_TIRPC
+  struct netbuf *pnetbuf;
+#endif
+
+  /* The whole key is compared and hashed, including the padding */
+  memset((char *)pkey, 0, sizeof(dupreq_key_t));
+
+  pkey->xid = xid;
+  pkey->rq_prog = reqp->rq_prog;
+  pkey->rq_vers = reqp->rq_vers;
+  pkey->rq_proc = reqp->rq_proc;
+
+#ifdef _USE_TIRPC
+  pnetbuf = svc_getrpccaller(reqp->rq_xprt);
+  psa = (pnetbuf != NULL) ? (struct sockaddr *)pnetbuf->buf : NULL;
+#else
+  psa = (struct sockaddr *)svc_getcaller(reqp->rq_xprt);
+#endif
+
+  if(psa == NULL)
+    return;
+
+  pkey->family = psa->sa_family;
+
+  switch (psa->sa_family)
+    {
+    case AF_INET:
+      pkey->port = ((struct sockaddr_in *)psa)->sin_port;
+      memcpy(pkey->addr, (char *)&((struct sockaddr_in *)psa)->sin_addr,
+             sizeof(struct in_addr));
+      break;
+
+    case AF_INET6:
+      pkey->port = ((struct sockaddr_in6 *)psa)->sin6_port;
+      memcpy(pkey->addr, (char *)&((struct sockaddr_in6 *)psa)->sin6_addr,
+             sizeof(struct in6_addr));
+      break;
+
+    default:
+      break;
+    }
+}                               /* dupreq_set_key */
 
 /**
  * 
@@ -106,6 +231,10 @@ hash_table_t *ht_dupreq;
  * ONC RPC protocol definitions, and used internally by the ONC layers. Since I need to know the xid
  * the structures are defined here.
  *
+ * As a side effect, the full dupreq key of the request (caller, procedure and checksum of the
+ * call) is kept for the current thread: nfs_dupreq_get and nfs_dupreq_add only receive the xid,
+ * and the UDP receive buffer holding the call is overwritten by the reply before nfs_dupreq_add.
+ *
  *  @param reqp A pointer to the request to be examined.
  *
  *  @return the found xid.
@@ -123,7 +252,12 @@ unsigned int get_rpc_xid(struct svc_req *reqp)
   struct udp_private2__
   {                             /* kept in xprt->xp_p2 */
     int up_unused;
+#ifdef _USE_GSSRPC
+    uint32_t up_xid;
+#else
     u_long up_xid;
+#endif
+    XDR up_xdrs;                /* decoding stream on the receive buffer */
   };
 
   struct tcp_conn2__
@@ -135,6 +269,9 @@ unsigned int get_rpc_xid(struct svc_req *reqp)
   };
 
   unsigned int Xid;
+  dupreq_key_t *pkey;
+  u_int pos;
+  u_int start;
 
   /* Map the xp1 and xp2 field to the udp and tcp private structures */
   struct tcp_conn2__ *ptcpxp = (struct tcp_conn2__ *)(reqp->rq_xprt->xp_p1);
@@ -146,6 +283,28 @@ unsigned int get_rpc_xid(struct svc_req *reqp)
   else
     Xid = ptcpxp->x_id;         /* TCP XID */
 
+  if((pkey = dupreq_thread_context()) == NULL)
+    return Xid;
+
+  /* Once the reply is encoded, the receive buffer no longer holds the call:
+   * keep the key computed while the request was decoded */
+  if(reqp->rq_xprt->xp_p2 != NULL && pudpxp->up_xdrs.x_op != XDR_DECODE
+     && pkey->xid == (long)Xid)
+    return Xid;
+
+  dupreq_set_key(reqp, (long)Xid, pkey);
+
+  /* With UDP, the whole call is in the receive buffer (xp_p1). Checksum its tail,
+   * which holds the arguments decoded so far. TCP record streams do not keep the
+   * call around, the checksum is 0 and the key relies on xid/caller/procedure */
+  if(reqp->rq_xprt->xp_p2 != NULL && reqp->rq_xprt->xp_p1 != NULL)
+    {
+      pos = XDR_GETPOS(&pudpxp->up_xdrs);
+      start = (pos > DUPREQ_CHECKSUM_LEN) ? pos - DUPREQ_CHECKSUM_LEN : 0;
+      pkey->checksum =
+          dupreq_checksum((unsigned char *)reqp->rq_xprt->xp_p1 + start, pos - start);
+    }
+
   return Xid;
 }                               /* get_rpc_xid */
 
@@ -169,107 +328,86 @@ int print_entry_dupreq(LRU_data_t data, char *str)
 
 /**
  *
- * clean_entry_dupreq: cleans an entry in the dupreq cache.
- *
- * cleans an entry in the dupreq cache.
+ * dupreq_free_result: frees the reply kept in a dupreq entry.
  *
- * @param pentry [INOUT] entry to be cleaned. 
- * @param addparam [IN] additional parameter used for cleaning.
+ * @param pdupreq [INOUT] entry whose reply is to be freed.
  *
- * @return 0 if ok, other values mean an error.
+ * @return nothing (void function)
  *
  */
-int clean_entry_dupreq(LRU_entry_t * pentry, void *addparam)
+static void dupreq_free_result(dupreq_entry_t * pdupreq)
 {
-  hash_buffer_t buffkey;
-  nfs_function_desc_t funcdesc;
-  dupreq_entry_t **dupreq_pool = (dupreq_entry_t **) addparam;
-  dupreq_entry_t *pdupreq = (dupreq_entry_t *) (pentry->buffdata.pdata);
-  int rc;
-
-  /* Removing entry in the hash */
-  buffkey.pdata = (caddr_t) pdupreq->xid;
-  buffkey.len = 0;
-
-  LogDebug(COMPONENT_DUPREQ, "NFS DUPREQ: Garbage collection on xid=%u", pdupreq->xid);
-
-  rc = HashTable_Del(ht_dupreq, &buffkey, NULL, NULL);
-
-  /* if hashtable no such key => dupreq garbaged by another thread */
-  if(rc != HASHTABLE_SUCCESS && rc != HASHTABLE_ERROR_NO_SUCH_KEY)
-    return 1;                   /* Error while cleaning */
-  else if(rc == HASHTABLE_ERROR_NO_SUCH_KEY)
-    return 0;                   /* don't free the dupreq twice */
+  nfs_function_desc_t funcdesc = nfs2_func_desc[0];     /* free function for PROC_NULL does nothing */
 
   /* Locate the function descriptor associated with this cached request */
-  if(pdupreq->rq_prog == nfs_param.core_param.nfs_program)
+  if(pdupreq->key.rq_prog == nfs_param.core_param.nfs_program)
     {
-      switch (pdupreq->rq_vers)
+      switch (pdupreq->key.rq_vers)
         {
         case NFS_V2:
-          funcdesc = nfs2_func_desc[pdupreq->rq_proc];
+          funcdesc = nfs2_func_desc[pdupreq->key.rq_proc];
           break;
 
         case NFS_V3:
-          funcdesc = nfs3_func_desc[pdupreq->rq_proc];
+          funcdesc = nfs3_func_desc[pdupreq->key.rq_proc];
           break;
 
         case NFS_V4:
-          funcdesc = nfs4_func_desc[pdupreq->rq_proc];
+          funcdesc = nfs4_func_desc[pdupreq->key.rq_proc];
           break;
 
         default:
           /* We should never go there (this situation is filtered in nfs_rpc_getreq) */
           LogMajor(COMPONENT_DUPREQ, "NFS DUPREQ: NFS Protocol version %d unknown in dupreq_gc",
-                   pdupreq->rq_vers);
+                   pdupreq->key.rq_vers);
           funcdesc = nfs2_func_desc[0]; /* free function for PROC_NULL does nothing */
           break;
         }
     }
-  else if(pdupreq->rq_prog == nfs_param.core_param.mnt_program)
+  else if(pdupreq->key.rq_prog == nfs_param.core_param.mnt_program)
     {
-      switch (pdupreq->rq_vers)
+      switch (pdupreq->key.rq_vers)
         {
         case MOUNT_V1:
-          funcdesc = mnt1_func_desc[pdupreq->rq_proc];
+          funcdesc = mnt1_func_desc[pdupreq->key.rq_proc];
           break;
 
         case MOUNT_V3:
-          funcdesc = mnt3_func_desc[pdupreq->rq_proc];
+          funcdesc = mnt3_func_desc[pdupreq->key.rq_proc];
           break;
 
         default:
           /* We should never go there (this situation is filtered in nfs_rpc_getreq) */
           LogMajor(COMPONENT_DUPREQ, "NFS DUPREQ: MOUNT Protocol version %d unknown in dupreq_gc",
-                   pdupreq->rq_vers);
+                   pdupreq->key.rq_vers);
           break;
 
         }                       /* switch( pdupreq->vers ) */
     }
 #ifdef _USE_NLM
-  else if(pdupreq->rq_prog == nfs_param.core_param.nlm_program)
+  else if(pdupreq->key.rq_prog == nfs_param.core_param.nlm_program)
     {
 
-      switch (pdupreq->rq_vers)
+      switch (pdupreq->key.rq_vers)
         {
         case NLM4_VERS:
-          funcdesc = nlm4_func_desc[pdupreq->rq_proc];
+          funcdesc = nlm4_func_desc[pdupreq->key.rq_proc];
           break;
         }                       /* switch( pdupreq->vers ) */
     }
 #endif                          /* _USE_NLM */
 #ifdef _USE_QUOTA
-  else if(pdupreq->rq_prog == nfs_param.core_param.rquota_program)
+  else if(pdupreq->key.rq_prog == nfs_param.core_param.rquota_program)
     {
 
-      switch (pdupreq->rq_vers)
+      switch (pdupreq->key.rq_vers)
         {
         case RQUOTAVERS:
-          funcdesc = rquota1_func_desc[pdupreq->rq_proc];
+          funcdesc = rquota1_func_desc[pdupreq->key.rq_proc];
           break;
 
         case EXT_RQUOTAVERS:
-          funcdesc = rquota2_func_desc[pdupreq->rq_proc];
+          funcdesc = rquota2_func_desc[pdupreq->key.rq_proc];
           break;
 
         }                       /* switch( pdupreq->vers ) */
@@ -278,67 +416,66 @@ int clean_entry_dupreq(LRU_entry_t * pentry, void *addparam)
   else
     {
       /* We should never go there (this situation is filtered in nfs_rpc_getreq) */
-      LogMajor(COMPONENT_DUPREQ, "NFS DUPREQ: protocol %d is not managed", pdupreq->rq_prog);
+      LogMajor(COMPONENT_DUPREQ, "NFS DUPREQ: protocol %d is not managed", pdupreq->key.rq_prog);
     }
 
   /* Call the free function */
   funcdesc.free_function(&(pdupreq->res_nfs));
+}                               /* dupreq_free_result */
 
-  /* Send the entry back to the pool */
-  RELEASE_PREALLOC(pdupreq, *dupreq_pool, next_alloc);
-
-  return 0;
-}                               /* clean_entry_dupreq */
+/**
+ *
+ * dupreq_key_hash: computes the hash value of a dupreq key.
+ *
+ * @param pkey [IN] the key
+ *
+ * @return the hash value.
+ *
+ */
+static unsigned long dupreq_key_hash(dupreq_key_t * pkey)
+{
+  return (unsigned long)dupreq_checksum((unsigned char *)pkey, sizeof(dupreq_key_t));
+}                               /* dupreq_key_hash */
 
 /**
  *
- *  dupreq_rbt_hash_func: computes the hash value for the entry in dupreq cache.
+ *  dupreq_value_hash_func: computes the hash value for the entry in dupreq cache.
  * 
- * Computes the hash value for the entry in dupreq cache. In fact, it just use the Xid modulo the hash array size.
- * This function is called internal in the HasTable_* function
+ * Computes the bucket of an entry within its shard, from the hash of the whole key
+ * (xid, caller and procedure) modulo the number of buckets.
  *
  * @param hparam [IN] hash table parameter.
- * @param buffcleff[in] pointer to the hash key buffer
+ * @param buffcleff[in] pointer to the hash key buffer (a dupreq_key_t)
  *
  * @return the computed hash value.
  *
- * @see HashTable_Init
- *
  */
 unsigned long dupreq_value_hash_func(hash_parameter_t * p_hparam,
                                      hash_buffer_t * buffclef)
 {
-  return (unsigned long)(buffclef->pdata) % p_hparam->index_size;
+  return dupreq_key_hash((dupreq_key_t *) buffclef->pdata) % p_hparam->index_size;
 }                               /*  dupreq_value_hash_func */
 
 /**
  *
- *  dupreq_rbt_hash_func: computes the rbt value for the entry in dupreq cache.
+ *  dupreq_rbt_hash_func: computes the full hash value for the entry in dupreq cache.
  * 
- * Computes the rbt value for the entry in dupreq cache. In fact, it just use the Xid 
- * itself (which is an unsigned integer) as the rbt value.
- * This function is called internal in the HasTable_* function
+ * Computes the hash of the whole key, its low order bits select the shard.
  *
  * @param hparam [IN] hash table parameter.
- * @param buffcleff[in] pointer to the hash key buffer
- *
- * @return the computed rbt value.
+ * @param buffcleff[in] pointer to the hash key buffer (a dupreq_key_t)
  *
- * @see HashTable_Init
+ * @return the computed value.
  *
  */
 unsigned long dupreq_rbt_hash_func(hash_parameter_t * p_hparam, hash_buffer_t * buffclef)
 {
-  /* We use the Xid as the rbt value */
-  return (unsigned long)(buffclef->pdata);
+  return dupreq_key_hash((dupreq_key_t *) buffclef->pdata);
 }                               /* dupreq_rbt_hash_func */
 
 /**
  *
- * compare_xid: compares the xid stored in the key buffers.
- *
- * compare the xid stored in the key buffers. This function is to be used as 'compare_key' field in 
- * the hashtable storing the nfs duplicated requests. 
+ * compare_xid: compares the dupreq keys stored in the key buffers.
  *
  * @param buff1 [IN] first key
  * @param buff2 [IN] second key
@@ -348,17 +485,12 @@ unsigned long dupreq_rbt_hash_func(hash_parameter_t * p_hparam, hash_buffer_t *
  */
 int compare_xid(hash_buffer_t * buff1, hash_buffer_t * buff2)
 {
-  long xid1 = (long)(buff1->pdata);
-  long xid2 = (long)(buff2->pdata);
-  return (xid1 == xid2) ? 0 : 1;
+  return memcmp(buff1->pdata, buff2->pdata, sizeof(dupreq_key_t)) ? 1 : 0;
 }                               /* compare_xid */
 
 /**
  *
- * display_xid: displays the xid stored in the buffer.
- *
- * displays the xid stored in the buffer. This function is to be used as 'key_to_str' field in 
- * the hashtable storing the nfs duplicated requests. 
+ * display_xid: displays the dupreq key stored in the buffer.
  *
  * @param buff1 [IN]  buffer to display
  * @param buff2 [OUT] output string
@@ -368,16 +500,194 @@ int compare_xid(hash_buffer_t * buff1, hash_buffer_t * buff2)
  */
 int display_xid(hash_buffer_t * pbuff, char *str)
 {
-  long xid = (long)(pbuff->pdata);
+  dupreq_key_t *pkey = (dupreq_key_t *) pbuff->pdata;
 
-  return sprintf(str, "%lX", xid);
-}
+  return sprintf(str, "xid=%lX prog=%lu vers=%lu proc=%lu port=%u sum=%08X",
+                 pkey->xid, pkey->rq_prog, pkey->rq_vers, pkey->rq_proc,
+                 ntohs(pkey->port), pkey->checksum);
+}                               /* display_xid */
+
+/**
+ *
+ * dupreq_current_key: gets the key of the request being managed by the thread.
+ *
+ * @param xid [IN] the xid of the request
+ * @param ptr_req [IN] the request, used to rebuild the key if needed, may be NULL
+ * @param pkey [OUT] the resulting key
+ *
+ * @return TRUE if a key was found, FALSE otherwise.
+ *
+ */
+static int dupreq_current_key(long xid, struct svc_req *ptr_req, dupreq_key_t * pkey)
+{
+  dupreq_key_t *pcurrent = dupreq_thread_context();
+
+  if(pcurrent != NULL && pcurrent->xid == xid)
+    {
+      *pkey = *pcurrent;
+      return TRUE;
+    }
+
+  if(ptr_req == NULL)
+    return FALSE;
+
+  /* get_rpc_xid was not called for this request, the checksum is not available */
+  dupreq_set_key(ptr_req, xid, pkey);
+
+  return TRUE;
+}                               /* dupreq_current_key */
 
 /**
  *
- * nfs_Init_dupreq: Init the hashtable and LRU for duplicate request cache
+ * dupreq_lru_unlink: removes an entry from the LRU list of its shard. The shard's lock is held.
+ *
+ * @param pshard [INOUT] the shard
+ * @param pdupreq [INOUT] the entry to be removed
  *
- * Perform all the required initialization for hashtable and LRU for duplicate request cache
+ * @return nothing (void function)
+ *
+ */
+static void dupreq_lru_unlink(dupreq_shard_t * pshard, dupreq_entry_t * pdupreq)
+{
+  if(pdupreq->lru_prev != NULL)
+    pdupreq->lru_prev->lru_next = pdupreq->lru_next;
+  else
+    pshard->lru_head = pdupreq->lru_next;
+
+  if(pdupreq->lru_next != NULL)
+    pdupreq->lru_next->lru_prev = pdupreq->lru_prev;
+  else
+    pshard->lru_tail = pdupreq->lru_prev;
+
+  pdupreq->lru_prev = NULL;
+  pdupreq->lru_next = NULL;
+}                               /* dupreq_lru_unlink */
+
+/**
+ *
+ * dupreq_shard_unlink: removes an entry from its shard. The shard's lock is held.
+ *
+ * @param pshard [INOUT] the shard
+ * @param pdupreq [INOUT] the entry to be removed
+ *
+ * @return nothing (void function)
+ *
+ */
+static void dupreq_shard_unlink(dupreq_shard_t * pshard, dupreq_entry_t * pdupreq)
+{
+  dupreq_entry_t **ppentry;
+
+  for(ppentry = &pshard->buckets[pdupreq->hash % dupreq_hparam.index_size];
+      *ppentry != NULL; ppentry = &(*ppentry)->hash_next)
+    if(*ppentry == pdupreq)
+      {
+        *ppentry = pdupreq->hash_next;
+        break;
+      }
+
+  dupreq_lru_unlink(pshard, pdupreq);
+  pdupreq->hash_next = NULL;
+
+  pshard->nb_entries -= 1;
+}                               /* dupreq_shard_unlink */
+
+/**
+ *
+ * dupreq_shard_append: makes an entry the most recent of its shard. The shard's lock is held.
+ *
+ * @param pshard [INOUT] the shard
+ * @param pdupreq [INOUT] the entry, not linked in the LRU list
+ *
+ * @return nothing (void function)
+ *
+ */
+static void dupreq_shard_append(dupreq_shard_t * pshard, dupreq_entry_t * pdupreq)
+{
+  pdupreq->lru_next = NULL;
+  pdupreq->lru_prev = pshard->lru_tail;
+
+  if(pshard->lru_tail != NULL)
+    pshard->lru_tail->lru_next = pdupreq;
+  else
+    pshard->lru_head = pdupreq;
+
+  pshard->lru_tail = pdupreq;
+}                               /* dupreq_shard_append */
+
+/**
+ *
+ * dupreq_shard_evict: reclaims the oldest entries of a shard. The shard's lock is held.
+ *
+ * Entries are reclaimed from the oldest one until the shard is below its size bound,
+ * then at most DUPREQ_EVICT_BATCH expired entries are reclaimed, so that the cost
+ * of the garbage collection is spread over the insertions.
+ *
+ * @param pshard [INOUT] the shard
+ * @param now [IN] the current time
+ * @param ppevicted [INOUT] list (chained by hash_next) the reclaimed entries are added to
+ *
+ * @return nothing (void function)
+ *
+ */
+static void dupreq_shard_evict(dupreq_shard_t * pshard, time_t now,
+                               dupreq_entry_t ** ppevicted)
+{
+  dupreq_entry_t *pdupreq;
+  unsigned int nb_expired = 0;
+
+  while((pdupreq = pshard->lru_head) != NULL)
+    {
+      if(pshard->max_entries == 0 || pshard->nb_entries < pshard->max_entries)
+        {
+          if(nb_expired >= DUPREQ_EVICT_BATCH
+             || now - pdupreq->timestamp <= nfs_param.core_param.expiration_dupreq)
+            break;
+
+          nb_expired += 1;
+        }
+
+      LogFullDebug(COMPONENT_DUPREQ, "NFS DUPREQ: Garbage collection on xid=%lu",
+                   pdupreq->key.xid);
+
+      dupreq_shard_unlink(pshard, pdupreq);
+      pshard->stat.ok.nb_del += 1;
+
+      pdupreq->hash_next = *ppevicted;
+      *ppevicted = pdupreq;
+    }
+}                               /* dupreq_shard_evict */
+
+/**
+ *
+ * dupreq_release_list: frees the replies of evicted entries and gives them back to a pool.
+ *
+ * @param pevicted [INOUT] list of entries chained by hash_next
+ * @param p_dupreq_pool [INOUT] the pool the entries are released to
+ *
+ * @return nothing (void function)
+ *
+ */
+static void dupreq_release_list(dupreq_entry_t * pevicted,
+                                dupreq_entry_t ** p_dupreq_pool)
+{
+  dupreq_entry_t *pnext;
+
+  for(; pevicted != NULL; pevicted = pnext)
+    {
+      pnext = pevicted->hash_next;
+
+      dupreq_free_result(pevicted);
+
+      /* Send the entry back to the pool */
+      RELEASE_PREALLOC(pevicted, *p_dupreq_pool, next_alloc);
+    }
+}                               /* dupreq_release_list */
+
+/**
+ *
+ * nfs_Init_dupreq: Init the duplicate request cache
+ *
+ * Perform all the required initialization for the shards of the duplicate request cache
  * 
  * @param param [IN] parameter used to init the duplicate request cache
  *
@@ -386,12 +696,69 @@ int display_xid(hash_buffer_t * pbuff, char *str)
  */
 int nfs_Init_dupreq(nfs_rpc_dupreq_parameter_t param)
 {
-  if((ht_dupreq = HashTable_Init(param.hash_param)) == NULL)
+  unsigned int nb_shards;
+  unsigned int i;
+  long nb_cpu;
+
+  dupreq_hparam = param.hash_param;
+
+  if(dupreq_hparam.index_size == 0)
     {
-      LogCrit(COMPONENT_DUPREQ, "NFS DUPREQ: Cannot init the duplicate request hash table");
+      LogCrit(COMPONENT_DUPREQ, "NFS DUPREQ: Bad index size for the duplicate request cache");
       return -1;
     }
 
+  if((nb_shards = param.nb_shards) == 0)
+    {
+      nb_cpu = sysconf(_SC_NPROCESSORS_ONLN);
+      nb_shards = (nb_cpu > 0) ? (unsigned int)nb_cpu : 1;
+    }
+
+  if(nb_shards > DUPREQ_MAX_SHARDS)
+    nb_shards = DUPREQ_MAX_SHARDS;
+
+  /* The shard is selected by masking the hash value */
+  for(dupreq_nb_shards = 1; dupreq_nb_shards < nb_shards; dupreq_nb_shards <<= 1) ;
+
+  if((dupreq_shards =
+      (dupreq_shard_t *) Mem_Alloc(dupreq_nb_shards * sizeof(dupreq_shard_t))) == NULL)
+    {
+      LogCrit(COMPONENT_DUPREQ, "NFS DUPREQ: Cannot init the duplicate request cache");
+      return -1;
+    }
+
+  memset((char *)dupreq_shards, 0, dupreq_nb_shards * sizeof(dupreq_shard_t));
+
+  for(i = 0; i < dupreq_nb_shards; i++)
+    {
+      if(pthread_mutex_init(&dupreq_shards[i].lock, NULL) != 0)
+        return -1;
+
+      if((dupreq_shards[i].buckets =
+          (dupreq_entry_t **) Mem_Alloc(dupreq_hparam.index_size *
+                                        sizeof(dupreq_entry_t *))) == NULL)
+        {
+          LogCrit(COMPONENT_DUPREQ,
+                  "NFS DUPREQ: Cannot init the duplicate request cache");
+          return -1;
+        }
+
+      memset((char *)dupreq_shards[i].buckets, 0,
+             dupreq_hparam.index_size * sizeof(dupreq_entry_t *));
+
+      /* 0 means no size bound, entries only expire */
+      if(param.max_entries != 0)
+        {
+          dupreq_shards[i].max_entries = param.max_entries / dupreq_nb_shards;
+          if(dupreq_shards[i].max_entries == 0)
+            dupreq_shards[i].max_entries = 1;
+        }
+    }
+
+  LogEvent(COMPONENT_DUPREQ,
+           "NFS DUPREQ: duplicate request cache has %u shards of %u buckets, max %u entries",
+           dupreq_nb_shards, dupreq_hparam.index_size, param.max_entries);
+
   return DUPREQ_SUCCESS;
 }                               /* nfs_Init_dupreq */
 
@@ -399,10 +766,15 @@ int nfs_Init_dupreq(nfs_rpc_dupreq_parameter_t param)
  *
  * nfs_dupreq_add: adds an entry in the duplicate requests cache.
  *
- * Adds an entry in the duplicate requests cache.
+ * Adds an entry in the duplicate requests cache. The entry is keyed by the xid, the caller
+ * and the procedure of the request, and a checksum of the call (see get_rpc_xid). Old
+ * entries of the same shard are reclaimed here, there is no separate garbage collection.
  *
  * @param xid [IN] the transfer id to be used as key
  * @param pnfsreq [IN] the request pointer to cache
+ * @param p_res_nfs [IN] the reply to cache
+ * @param lru_dupreq [IN] unused, entries are tracked in the shards
+ * @param p_dupreq_pool [INOUT] pool the entries are allocated from and released to
  *
  * @return DUPREQ_SUCCESS if successfull\n.
  * @return DUPREQ_INSERT_MALLOC_ERROR if an error occured during the insertion process.
@@ -414,11 +786,11 @@ int nfs_dupreq_add(long xid,
                    nfs_res_t * p_res_nfs,
                    LRU_list_t * lru_dupreq, dupreq_entry_t ** p_dupreq_pool)
 {
-  hash_buffer_t buffkey;
-  hash_buffer_t buffdata;
   dupreq_entry_t *pdupreq = NULL;
-  LRU_entry_t *pentry = NULL;
-  LRU_status_t lru_status;
+  dupreq_entry_t *pentry = NULL;
+  dupreq_entry_t *pevicted = NULL;
+  dupreq_entry_t **pbucket;
+  dupreq_shard_t *pshard;
 
 #ifdef _DEBUG_MEMLEAKS
   /* For debugging memory leaks */
@@ -438,32 +810,43 @@ int nfs_dupreq_add(long xid,
   BuddySetDebugLabel("N/A");
 #endif
 
-  /* I have to keep an integer as key, I wil use the pointer buffkey->pdata for this, 
-   * this also means that buffkey->len will be 0 */
-  buffkey.pdata = (caddr_t) xid;
-  buffkey.len = 0;
-
   /* I build the data with the request pointer that should be in state 'IN USE' */
-  pdupreq->xid = xid;
+  dupreq_current_key(xid, ptr_req, &pdupreq->key);
+  pdupreq->hash = dupreq_key_hash(&pdupreq->key);
   pdupreq->res_nfs = *p_res_nfs;
-  pdupreq->rq_prog = ptr_req->rq_prog;
-  pdupreq->rq_vers = ptr_req->rq_vers;
-  pdupreq->rq_proc = ptr_req->rq_proc;
   pdupreq->timestamp = time(NULL);
+  pdupreq->lru_prev = NULL;
+  pdupreq->lru_next = NULL;
 
-  buffdata.pdata = (caddr_t) pdupreq;
-  buffdata.len = sizeof(dupreq_entry_t);
+  pshard = &dupreq_shards[pdupreq->hash & (dupreq_nb_shards - 1)];
+  pbucket = &pshard->buckets[pdupreq->hash % dupreq_hparam.index_size];
 
-  if(HashTable_Set(ht_dupreq, &buffkey, &buffdata) != HASHTABLE_SUCCESS)
-    return DUPREQ_INSERT_MALLOC_ERROR;
+  P(pshard->lock);
 
-  /* Add it to lru list */
-  if((pentry = LRU_new_entry(lru_dupreq, &lru_status)) == NULL)
-    return DUPREQ_INSERT_MALLOC_ERROR;
+  /* A reply previously cached for the same request is replaced */
+  for(pentry = *pbucket; pentry != NULL; pentry = pentry->hash_next)
+    if(!memcmp((char *)&pentry->key, (char *)&pdupreq->key, sizeof(dupreq_key_t)))
+      {
+        dupreq_shard_unlink(pshard, pentry);
+        pentry->hash_next = pevicted;
+        pevicted = pentry;
+        break;
+      }
+
+  dupreq_shard_evict(pshard, pdupreq->timestamp, &pevicted);
+
+  pdupreq->hash_next = *pbucket;
+  *pbucket = pdupreq;
+  dupreq_shard_append(pshard, pdupreq);
+
+  pshard->nb_entries += 1;
+  pshard->stat.nb_entries = pshard->nb_entries;
+  pshard->stat.ok.nb_set += 1;
 
-  /* I keep track of the xid too */
-  pentry->buffdata.pdata = (caddr_t) pdupreq;
-  pentry->buffdata.len = sizeof(dupreq_entry_t);
+  V(pshard->lock);
+
+  /* The replies are freed out of the shard's lock */
+  dupreq_release_list(pevicted, p_dupreq_pool);
 
   return DUPREQ_SUCCESS;
 }                               /* nfs_dupreq_add */
@@ -472,7 +855,8 @@ int nfs_dupreq_add(long xid,
  *
  * nfs_dupreq_get: Tries to get a duplicated requests for dupreq cache
  *
- * Tries to get a duplicated requests for dupreq cache. 
+ * Tries to get a duplicated requests for dupreq cache. The caller and the checksum
+ * completing the key are the ones kept by get_rpc_xid for the current thread.
  * 
  * @param xid [IN] the transfer id we are looking for
  * @param pstatus [OUT] the pointer to the status for the operation
@@ -482,70 +866,107 @@ int nfs_dupreq_add(long xid,
  */
 nfs_res_t nfs_dupreq_get(long xid, int *pstatus)
 {
-  hash_buffer_t buffkey;
-  hash_buffer_t buffval;
+  dupreq_key_t key;
+  dupreq_entry_t *pdupreq;
+  dupreq_shard_t *pshard;
+  unsigned long hash;
   nfs_res_t res_nfs;
 
-  buffkey.pdata = (caddr_t) xid;
-  buffkey.len = 0;
+  *pstatus = DUPREQ_NOT_FOUND;
+
+  if(!dupreq_current_key(xid, NULL, &key))
+    {
+      LogDebug(COMPONENT_DUPREQ, "NFS DUPREQ: No key known for xid=%lu", xid);
+      return res_nfs;
+    }
+
+  hash = dupreq_key_hash(&key);
+  pshard = &dupreq_shards[hash & (dupreq_nb_shards - 1)];
+
+  P(pshard->lock);
+
+  for(pdupreq = pshard->buckets[hash % dupreq_hparam.index_size];
+      pdupreq != NULL; pdupreq = pdupreq->hash_next)
+    if(pdupreq->hash == hash
+       && !memcmp((char *)&pdupreq->key, (char *)&key, sizeof(dupreq_key_t)))
+      break;
 
-  if(HashTable_Get(ht_dupreq, &buffkey, &buffval) == HASHTABLE_SUCCESS)
+  if(pdupreq != NULL)
     {
-      /* reset timestamp */
-      ((dupreq_entry_t *) buffval.pdata)->timestamp = time(NULL);
+      /* reset timestamp, the entry becomes the most recent of its shard */
+      pdupreq->timestamp = time(NULL);
+      dupreq_lru_unlink(pshard, pdupreq);
+      dupreq_shard_append(pshard, pdupreq);
 
+      res_nfs = pdupreq->res_nfs;
+      pshard->stat.ok.nb_get += 1;
       *pstatus = DUPREQ_SUCCESS;
-      res_nfs = ((dupreq_entry_t *) buffval.pdata)->res_nfs;
-      LogDebug(COMPONENT_DUPREQ, "NFS DUPREQ: Hit in the dupreq cache for xid=%u", xid);
     }
   else
-    {
-      *pstatus = DUPREQ_NOT_FOUND;
-    }
-  return res_nfs;
-}                               /* nfs_dupreq_get */
-
-/**
- *
- * nfs_dupreq_gc_function: Tests is an entry in dupreq cache is to be set invalid (has expired).
- *
- * Tests is an entry in dupreq cache is to be set invalid (has expired).
- *
- * @param pentry [IN] pointer to the entry to test
- *
- * @return 1 if entry must be set invalid, 0 if not.
- *
- * @see LRU_invalidate_by_function
- * @see LRU_gc_invalid
- *
- */
-int nfs_dupreq_gc_function(LRU_entry_t * pentry, void *addparam)
-{
-  dupreq_entry_t *pdupreq = NULL;
+    pshard->stat.notfound.nb_get += 1;
 
-  pdupreq = (dupreq_entry_t *) (pentry->buffdata.pdata);
+  V(pshard->lock);
 
-  /* Test if entry is expired */
-  if(time(NULL) - pdupreq->timestamp > nfs_param.core_param.expiration_dupreq)
-    return LRU_LIST_SET_INVALID;
+  if(*pstatus == DUPREQ_SUCCESS)
+    LogDebug(COMPONENT_DUPREQ, "NFS DUPREQ: Hit in the dupreq cache for xid=%lu", xid);
 
-  return LRU_LIST_DO_NOT_SET_INVALID;
-}                               /* nfs_dupreq_fc_function */
+  return res_nfs;
+}                               /* nfs_dupreq_get */
 
 /**
  *
- * nfs_dupreq_get_stats: gets the hash table statistics for the duplicate requests.
+ * nfs_dupreq_get_stats: gets the statistics for the duplicate requests.
  *
- * Gets the hash table statistics for the duplicate requests.
+ * Gets the statistics for the duplicate requests, summed over the shards. The computed
+ * part reports the length of the buckets' chains.
  *
  * @param phstat [OUT] pointer to the resulting stats.
  *
  * @return nothing (void function)
  *
- * @see HashTable_GetStats
- *
  */
 void nfs_dupreq_get_stats(hash_stat_t * phstat)
 {
-  HashTable_GetStats(ht_dupreq, phstat);
+  dupreq_shard_t *pshard;
+  dupreq_entry_t *pdupreq;
+  unsigned int i;
+  unsigned int j;
+  unsigned int len;
+
+  memset((char *)phstat, 0, sizeof(hash_stat_t));
+
+  if(dupreq_shards == NULL)
+    return;
+
+  phstat->computed.min_rbt_num_node = (unsigned int)-1;
+
+  for(i = 0; i < dupreq_nb_shards; i++)
+    {
+      pshard = &dupreq_shards[i];
+
+      P(pshard->lock);
+
+      phstat->dynamic.nb_entries += pshard->nb_entries;
+      phstat->dynamic.ok.nb_set += pshard->stat.ok.nb_set;
+      phstat->dynamic.ok.nb_get += pshard->stat.ok.nb_get;
+      phstat->dynamic.ok.nb_del += pshard->stat.ok.nb_del;
+      phstat->dynamic.notfound.nb_get += pshard->stat.notfound.nb_get;
+
+      for(j = 0; j < dupreq_hparam.index_size; j++)
+        {
+          for(len = 0, pdupreq = pshard->buckets[j]; pdupreq != NULL;
+              pdupreq = pdupreq->hash_next)
+            len += 1;
+
+          if(len < phstat->computed.min_rbt_num_node)
+            phstat->computed.min_rbt_num_node = len;
+          if(len > phstat->computed.max_rbt_num_node)
+            phstat->computed.max_rbt_num_node = len;
+        }
+
+      V(pshard->lock);
+    }
+
+  phstat->computed.average_rbt_num_node =
+      phstat->dynamic.nb_entries / (dupreq_nb_shards * dupreq_hparam.index_size);
 }                               /* nfs_dupreq_get_stats */
@@ -101,6 +101,9 @@ pthread_t rpc_dispatcher_thrid;
 pthread_t stat_thrid;
 pthread_t admin_thrid;
 pthread_t fcc_gc_thrid;
+pthread_t unstable_flush_thrid;
+pthread_t journal_thrid;
+pthread_t uploader_thrid;
 
 char config_path[MAXPATHLEN];
 
@@ -174,6 +177,7 @@ int nfs_print_param_config(nfs_parameter_t * p_nfs_param)
   printf("\tNFS_Program = %u ;\n", p_nfs_param->core_param.nfs_program);
   printf("\tMNT_Program = %u ;\n", p_nfs_param->core_param.mnt_program);
   printf("\tNb_Worker = %u ; \n", p_nfs_param->core_param.nb_worker);
+  printf("\tNb_Event_Thread = %u ; \n", p_nfs_param->core_param.nb_event_thread);
   printf("\tNb_MaxConcurrentGC = %u ; \n", p_nfs_param->core_param.nb_max_concurrent_gc);
   printf("\tDupReq_Expiration = %lu ; \n", p_nfs_param->core_param.expiration_dupreq);
   printf("\tCore_Dump_Size = %ld ; \n", p_nfs_param->core_param.core_dump_size);
@@ -207,6 +211,37 @@ int nfs_print_param_config(nfs_parameter_t * p_nfs_param)
   printf("NFS_Worker_Param\n{\n");
   printf("}\n\n");
 
+  printf("NFS_Journal\n{\n");
+  if(p_nfs_param->journal_param.enable)
+    printf("\tEnable = TRUE ; \n");
+  else
+    printf("\tEnable = FALSE ;\n");
+  printf("\tDirectory = %s ; \n", p_nfs_param->journal_param.directory);
+  printf("\tSegment_Size = %u ; \n", p_nfs_param->journal_param.segment_size);
+  printf("\tRing_Size = %u ; \n", p_nfs_param->journal_param.ring_size);
+  printf("\tPath_Cache_Size = %u ; \n", p_nfs_param->journal_param.path_cache_size);
+  if(p_nfs_param->journal_param.sync)
+    printf("\tSync = TRUE ; \n");
+  else
+    printf("\tSync = FALSE ;\n");
+  printf("}\n\n");
+
+  printf("NFS_Uploader\n{\n");
+  if(p_nfs_param->uploader_param.enable)
+    printf("\tEnable = TRUE ; \n");
+  else
+    printf("\tEnable = FALSE ;\n");
+  printf("\tHost = %s ; \n", p_nfs_param->uploader_param.host);
+  printf("\tPort = %u ; \n", p_nfs_param->uploader_param.port);
+  printf("\tBucket = %s ; \n", p_nfs_param->uploader_param.bucket);
+  printf("\tNb_Connections = %u ; \n", p_nfs_param->uploader_param.nb_connections);
+  printf("\tPart_Size = %u ; \n", p_nfs_param->uploader_param.part_size);
+  printf("\tMax_Retries = %u ; \n", p_nfs_param->uploader_param.max_retries);
+  printf("\tRetry_Delay = %u ; \n", p_nfs_param->uploader_param.retry_delay);
+  printf("\tScan_Period = %u ; \n", p_nfs_param->uploader_param.scan_period);
+  printf("\tTimeout = %u ; \n", p_nfs_param->uploader_param.timeout);
+  printf("}\n\n");
+
   return 0;
 }                               /* nfs_print_param_config */
 
@@ -220,6 +255,7 @@ int nfs_set_param_default(nfs_parameter_t * p_nfs_param)
 
   /* Core parameters */
   p_nfs_param->core_param.nb_worker = NB_WORKER_THREAD_DEFAULT;
+  p_nfs_param->core_param.nb_event_thread = NB_EVENT_THREAD_DEFAULT;
   p_nfs_param->core_param.nb_max_concurrent_gc = NB_MAX_CONCURRENT_GC;
   p_nfs_param->core_param.expiration_dupreq = DUPREQ_EXPIRATION;
   p_nfs_param->core_param.nfs_port = NFS_PORT;
@@ -242,14 +278,33 @@ int nfs_set_param_default(nfs_parameter_t * p_nfs_param)
   p_nfs_param->core_param.dump_stats_per_client = 0;
   strncpy(p_nfs_param->core_param.stats_per_client_directory, "/tmp", MAXPATHLEN);
 
-  /* Worker parameters : LRU */
+  /* Worker parameters : size of the pending request queues */
   p_nfs_param->worker_param.lru_param.nb_entry_prealloc = NB_PREALLOC_LRU_WORKER;
-  p_nfs_param->worker_param.lru_param.clean_entry = clean_pending_request;
-  p_nfs_param->worker_param.lru_param.entry_to_str = print_pending_request;
+
+  /* Journal parameters */
+  p_nfs_param->journal_param.enable = TRUE;
+  strncpy(p_nfs_param->journal_param.directory, NFS_JOURNAL_DIRECTORY_DEFAULT, MAXPATHLEN);
+  p_nfs_param->journal_param.segment_size = NFS_JOURNAL_SEGMENT_SIZE_DEFAULT;
+  p_nfs_param->journal_param.ring_size = NFS_JOURNAL_RING_SIZE_DEFAULT;
+  p_nfs_param->journal_param.path_cache_size = NFS_JOURNAL_PATH_CACHE_DEFAULT;
+  p_nfs_param->journal_param.sync = TRUE;
+
+  /* Uploader parameters */
+  p_nfs_param->uploader_param.enable = FALSE;
+  strncpy(p_nfs_param->uploader_param.host, NFS_UPLOADER_HOST_DEFAULT, MAXHOSTNAMELEN);
+  p_nfs_param->uploader_param.port = NFS_UPLOADER_PORT_DEFAULT;
+  strncpy(p_nfs_param->uploader_param.bucket, NFS_UPLOADER_BUCKET_DEFAULT, MAXNAMLEN);
+  p_nfs_param->uploader_param.authorization[0] = '\0';
+  p_nfs_param->uploader_param.nb_connections = NFS_UPLOADER_NB_CONNECTIONS_DEFAULT;
+  p_nfs_param->uploader_param.part_size = NFS_UPLOADER_PART_SIZE_DEFAULT;
+  p_nfs_param->uploader_param.max_retries = NFS_UPLOADER_MAX_RETRIES_DEFAULT;
+  p_nfs_param->uploader_param.retry_delay = NFS_UPLOADER_RETRY_DELAY_DEFAULT;
+  p_nfs_param->uploader_param.scan_period = NFS_UPLOADER_SCAN_PERIOD_DEFAULT;
+  p_nfs_param->uploader_param.timeout = NFS_UPLOADER_TIMEOUT_DEFAULT;
 
   /* Worker parameters : LRU dupreq */
   p_nfs_param->worker_param.lru_dupreq.nb_entry_prealloc = NB_PREALLOC_LRU_DUPREQ;
-  p_nfs_param->worker_param.lru_dupreq.clean_entry = clean_entry_dupreq;
+  p_nfs_param->worker_param.lru_dupreq.clean_entry = NULL;
   p_nfs_param->worker_param.lru_dupreq.entry_to_str = print_entry_dupreq;
 
   /* Worker parameters : GC */
@@ -296,6 +351,8 @@ int nfs_set_param_default(nfs_parameter_t * p_nfs_param)
   p_nfs_param->dupreq_param.hash_param.compare_key = compare_xid;
   p_nfs_param->dupreq_param.hash_param.key_to_str = display_xid;
   p_nfs_param->dupreq_param.hash_param.val_to_str = display_xid;
+  p_nfs_param->dupreq_param.nb_shards = 0;     /* one per CPU */
+  p_nfs_param->dupreq_param.max_entries = DUPREQ_MAX_ENTRIES;
 
   /*  Worker parameters : IP/name hash table */
   p_nfs_param->ip_name_param.hash_param.index_size = PRIME_IP_NAME;
@@ -473,6 +530,12 @@ int nfs_set_param_default(nfs_parameter_t * p_nfs_param)
   p_nfs_param->cache_layers_param.gcpol.run_interval = 3600;    /* 1h */
   p_nfs_param->cache_layers_param.gcpol.nb_call_before_gc = 1000;
 
+  /* Cache inode parameters : Readahead */
+  p_nfs_param->cache_layers_param.readahead_param.nb_threads = 4;
+  p_nfs_param->cache_layers_param.readahead_param.max_memory = 64 * 1024 * 1024;
+  p_nfs_param->cache_layers_param.readahead_param.min_window = 128 * 1024;
+  p_nfs_param->cache_layers_param.readahead_param.max_window = 4 * 1024 * 1024;
+
   /* Cache inode client parameters */
   p_nfs_param->cache_layers_param.cache_inode_client_param.lru_param.nb_entry_prealloc =
       2048;
@@ -487,6 +550,7 @@ int nfs_set_param_default(nfs_parameter_t * p_nfs_param)
   p_nfs_param->cache_layers_param.cache_inode_client_param.grace_period_link = 0;
   p_nfs_param->cache_layers_param.cache_inode_client_param.grace_period_attr = 0;
   p_nfs_param->cache_layers_param.cache_inode_client_param.grace_period_dirent = 0;
+  p_nfs_param->cache_layers_param.cache_inode_client_param.grace_period_negative = 0;
   p_nfs_param->cache_layers_param.cache_inode_client_param.use_test_access = 1;
   p_nfs_param->cache_layers_param.cache_inode_client_param.getattr_dir_invalidation = 0;
   p_nfs_param->cache_layers_param.cache_inode_client_param.attrmask =
@@ -746,6 +810,40 @@ int nfs_set_param_from_conf(nfs_parameter_t * p_nfs_param,
                         "duplicate request hash table configuration read from config file");
     }
 
+  /* Journal of the modifications */
+  if((rc = nfs_read_journal_conf(config_struct, &p_nfs_param->journal_param)) < 0)
+    {
+      LogCrit(COMPONENT_INIT, "Error while parsing journal configuration");
+      return -1;
+    }
+  else
+    {
+      /* No such stanza in configuration file */
+      if(rc == 1)
+        LogDebug(COMPONENT_INIT,
+		 "No journal configuration found in config file, using default");
+      else
+        LogDebug(COMPONENT_INIT,
+                        "journal configuration read from config file");
+    }
+
+  /* Upload of the journal */
+  if((rc = nfs_read_uploader_conf(config_struct, &p_nfs_param->uploader_param)) < 0)
+    {
+      LogCrit(COMPONENT_INIT, "Error while parsing uploader configuration");
+      return -1;
+    }
+  else
+    {
+      /* No such stanza in configuration file */
+      if(rc == 1)
+        LogDebug(COMPONENT_INIT,
+                 "No uploader configuration found in config file, using default");
+      else
+        LogDebug(COMPONENT_INIT,
+                        "uploader configuration read from config file");
+    }
+
   /* Worker paramters: ip/name hash table and expiration for each entry */
   if((rc = nfs_read_ip_name_conf(config_struct, &p_nfs_param->ip_name_param)) < 0)
     {
@@ -949,6 +1047,26 @@ int nfs_set_param_from_conf(nfs_parameter_t * p_nfs_param,
     LogDebug(COMPONENT_INIT,
                     "Cache Inode Garbage Collection Policy configuration read from config file");
 
+  /* Cache inode parameters : Readahead */
+  if((cache_inode_status =
+      cache_inode_read_conf_readahead_parameter(config_struct,
+                                                &p_nfs_param->cache_layers_param.
+                                                readahead_param)) != CACHE_INODE_SUCCESS)
+    {
+      if(cache_inode_status == CACHE_INODE_NOT_FOUND)
+        LogDebug
+            (COMPONENT_INIT, "No Cache Inode Readahead configuration found, using default");
+      else
+        {
+          LogCrit
+              (COMPONENT_INIT, "Error while parsing Cache Inode Readahead configuration");
+          return -1;
+        }
+    }
+  else
+    LogDebug(COMPONENT_INIT,
+                    "Cache Inode Readahead configuration read from config file");
+
   /* Cache inode client parameters */
   if((cache_inode_status = cache_inode_read_conf_client_parameter(config_struct,
                                                                   &p_nfs_param->
@@ -1073,6 +1191,50 @@ int nfs_check_param_consistency(nfs_parameter_t * p_nfs_param)
       return 1;
     }
 
+#ifdef _USE_EPOLL
+  if(p_nfs_param->core_param.nb_event_thread <= 0 ||
+     p_nfs_param->core_param.nb_event_thread > NB_MAX_EVENT_THREAD)
+    {
+      LogCrit(COMPONENT_INIT, "BAD PARAMETER: number of event threads must be between 1 and %d",
+                 NB_MAX_EVENT_THREAD);
+      return 1;
+    }
+#endif
+
+  if(p_nfs_param->journal_param.enable &&
+     (p_nfs_param->journal_param.ring_size == 0 ||
+      p_nfs_param->journal_param.path_cache_size == 0))
+    {
+      LogCrit(COMPONENT_INIT,
+              "BAD PARAMETER (NFS_Journal): Ring_Size and Path_Cache_Size must not be 0");
+      return 1;
+    }
+
+  if(p_nfs_param->uploader_param.enable)
+    {
+      if(!p_nfs_param->journal_param.enable)
+        {
+          LogCrit(COMPONENT_INIT,
+                  "BAD PARAMETER (NFS_Uploader): the uploader needs NFS_Journal to be enabled");
+          return 1;
+        }
+
+      if(p_nfs_param->uploader_param.nb_connections == 0
+         || p_nfs_param->uploader_param.part_size == 0
+         || p_nfs_param->uploader_param.scan_period == 0)
+        {
+          LogCrit(COMPONENT_INIT,
+                  "BAD PARAMETER (NFS_Uploader): Nb_Connections, Part_Size and Scan_Period must not be 0");
+          return 1;
+        }
+
+      /* Only worth a warning: S3 stand-ins may accept smaller parts */
+      if(p_nfs_param->uploader_param.part_size < NFS_UPLOADER_PART_SIZE_MIN)
+        LogEvent(COMPONENT_INIT,
+                 "NFS_Uploader: Part_Size is below %u, S3 will refuse the multipart uploads",
+                 NFS_UPLOADER_PART_SIZE_MIN);
+    }
+
   if(p_nfs_param->worker_param.nb_before_gc <
      p_nfs_param->worker_param.lru_param.nb_entry_prealloc / 2)
     {
@@ -1138,6 +1300,8 @@ void nfs_reset_stats(void)
       workers_data[i].cache_inode_client.stat.nb_gc_lru_active = 0;
       workers_data[i].cache_inode_client.stat.nb_gc_lru_total = 0;
       workers_data[i].cache_inode_client.stat.nb_call_total = 0;
+      workers_data[i].cache_inode_client.stat.nb_negative_hit = 0;
+      workers_data[i].cache_inode_client.stat.nb_negative_miss = 0;
 
       for(j = 0; j < CACHE_INODE_NB_COMMAND; j++)
         {
@@ -1164,6 +1328,8 @@ void nfs_reset_stats(void)
           workers_data[i].stats.stat_req.stat_req_mnt1[j].total = 0;
           workers_data[i].stats.stat_req.stat_req_mnt1[j].success = 0;
           workers_data[i].stats.stat_req.stat_req_mnt1[j].dropped = 0;
+          memset(&workers_data[i].stats.stat_req.stat_req_mnt1[j].latency_histogram, 0,
+                 sizeof(nfs_latency_histogram_t));
 
         }
 
@@ -1172,6 +1338,8 @@ void nfs_reset_stats(void)
           workers_data[i].stats.stat_req.stat_req_mnt3[j].total = 0;
           workers_data[i].stats.stat_req.stat_req_mnt3[j].success = 0;
           workers_data[i].stats.stat_req.stat_req_mnt3[j].dropped = 0;
+          memset(&workers_data[i].stats.stat_req.stat_req_mnt3[j].latency_histogram, 0,
+                 sizeof(nfs_latency_histogram_t));
         }
 
       for(j = 0; j < NFS_V2_NB_COMMAND; j++)
@@ -1179,6 +1347,8 @@ void nfs_reset_stats(void)
           workers_data[i].stats.stat_req.stat_req_nfs2[j].total = 0;
           workers_data[i].stats.stat_req.stat_req_nfs2[j].success = 0;
           workers_data[i].stats.stat_req.stat_req_nfs2[j].dropped = 0;
+          memset(&workers_data[i].stats.stat_req.stat_req_nfs2[j].latency_histogram, 0,
+                 sizeof(nfs_latency_histogram_t));
         }
 
       for(j = 0; j < NFS_V3_NB_COMMAND; j++)
@@ -1186,6 +1356,8 @@ void nfs_reset_stats(void)
           workers_data[i].stats.stat_req.stat_req_nfs3[j].total = 0;
           workers_data[i].stats.stat_req.stat_req_nfs3[j].success = 0;
           workers_data[i].stats.stat_req.stat_req_nfs3[j].dropped = 0;
+          memset(&workers_data[i].stats.stat_req.stat_req_nfs3[j].latency_histogram, 0,
+                 sizeof(nfs_latency_histogram_t));
         }
 
       for(j = 0; j < NFS_V4_NB_COMMAND; j++)
@@ -1193,6 +1365,8 @@ void nfs_reset_stats(void)
           workers_data[i].stats.stat_req.stat_req_nfs4[j].total = 0;
           workers_data[i].stats.stat_req.stat_req_nfs4[j].success = 0;
           workers_data[i].stats.stat_req.stat_req_nfs4[j].dropped = 0;
+          memset(&workers_data[i].stats.stat_req.stat_req_nfs4[j].latency_histogram, 0,
+                 sizeof(nfs_latency_histogram_t));
         }
 
       for(j = 0; j < NFS_V40_NB_OPERATION; j++)
@@ -1200,6 +1374,8 @@ void nfs_reset_stats(void)
           workers_data[i].stats.stat_req.stat_op_nfs40[j].total = 0;
           workers_data[i].stats.stat_req.stat_op_nfs40[j].success = 0;
           workers_data[i].stats.stat_req.stat_op_nfs40[j].failed = 0;
+          memset(&workers_data[i].stats.stat_req.stat_op_nfs40[j].latency_histogram, 0,
+                 sizeof(nfs_latency_histogram_t));
         }
 
       for(j = 0; j < NFS_V41_NB_OPERATION; j++)
@@ -1207,6 +1383,8 @@ void nfs_reset_stats(void)
           workers_data[i].stats.stat_req.stat_op_nfs41[j].total = 0;
           workers_data[i].stats.stat_req.stat_op_nfs41[j].success = 0;
           workers_data[i].stats.stat_req.stat_op_nfs41[j].failed = 0;
+          memset(&workers_data[i].stats.stat_req.stat_op_nfs41[j].latency_histogram, 0,
+                 sizeof(nfs_latency_histogram_t));
         }
 
       workers_data[i].stats.last_stat_update = 0;
@@ -1238,6 +1416,23 @@ static void nfs_Start_threads(nfs_parameter_t * pnfs_param)
   if(pthread_attr_setstacksize(&attr_thr, THREAD_STACK_SIZE) != 0)
     LogDebug(COMPONENT_INIT, "can't set pthread's stack size");
 
+  /* Starting the log writer thread, messages are written asynchronously from now */
+  if(StartLogWriter() != 0)
+    {
+      LogError(COMPONENT_INIT, ERR_SYS, ERR_PTHREAD_CREATE, errno);
+      exit(1);
+    }
+  LogEvent(COMPONENT_INIT, "log writer thread was started successfully");
+
+  /* Starting the readahead threads */
+  if((rc = cache_inode_readahead_init(pnfs_param->cache_layers_param.readahead_param)) != 0)
+    {
+      LogError(COMPONENT_INIT, ERR_SYS, ERR_PTHREAD_CREATE, rc);
+      exit(1);
+    }
+  LogEvent(COMPONENT_INIT, "%u readahead threads were started successfully",
+           pnfs_param->cache_layers_param.readahead_param.nb_threads);
+
   /* Starting all of the worker thread */
   for(i = 0; i < pnfs_param->core_param.nb_worker; i++)
     {
@@ -1288,6 +1483,40 @@ static void nfs_Start_threads(nfs_parameter_t * pnfs_param)
     }
   LogEvent(COMPONENT_INIT, "file content gc thread was started successfully");
 
+  /* Starting the thread that flushes the unstable writes of the idle files */
+  if((rc =
+      pthread_create(&unstable_flush_thrid, &attr_thr, unstable_flush_thread,
+                     (void *)NULL)) != 0)
+    {
+      LogError(COMPONENT_INIT, ERR_SYS, ERR_PTHREAD_CREATE, rc);
+      exit(1);
+    }
+  LogEvent(COMPONENT_INIT, "unstable flush thread was started successfully");
+
+  /* Starting the journal thread */
+  if(pnfs_param->journal_param.enable)
+    {
+      if((rc =
+          pthread_create(&journal_thrid, &attr_thr, nfs_journal_thread, (void *)NULL)) != 0)
+        {
+          LogError(COMPONENT_INIT, ERR_SYS, ERR_PTHREAD_CREATE, rc);
+          exit(1);
+        }
+      LogEvent(COMPONENT_INIT, "journal thread was started successfully");
+    }
+
+  /* Starting the uploader thread */
+  if(pnfs_param->uploader_param.enable)
+    {
+      if((rc =
+          pthread_create(&uploader_thrid, &attr_thr, nfs_uploader_thread, (void *)NULL)) != 0)
+        {
+          LogError(COMPONENT_INIT, ERR_SYS, ERR_PTHREAD_CREATE, rc);
+          exit(1);
+        }
+      LogEvent(COMPONENT_INIT, "uploader thread was started successfully");
+    }
+
 }                               /* nfs_Start_threads */
 
 /**
@@ -1468,6 +1697,25 @@ static void nfs_Init(const nfs_start_info_t * p_start_info)
 
   LogDebug(COMPONENT_INIT, "Initializing workers data structure");
 
+  if(nfs_rpc_queue_init() != 0)
+    {
+      LogCrit(COMPONENT_INIT, "NFS_INIT: Error while initializing the request queues");
+      exit(1);
+    }
+
+  if(nfs_journal_init(&nfs_param.journal_param, nfs_param.core_param.nb_worker) != 0)
+    {
+      LogCrit(COMPONENT_INIT, "NFS_INIT: Error while initializing the journal");
+      exit(1);
+    }
+
+  if(nfs_uploader_init(&nfs_param.uploader_param, nfs_param.journal_param.directory,
+                       &nfs_param.buddy_param_admin) != 0)
+    {
+      LogCrit(COMPONENT_INIT, "NFS_INIT: Error while initializing the uploader");
+      exit(1);
+    }
+
   for(i = 0; i < nfs_param.core_param.nb_worker; i++)
     {
       /* Fill in workers fields (semaphores and other stangenesses */
@@ -1772,6 +2020,8 @@ int nfs_start(nfs_parameter_t * p_nfs_param, nfs_start_info_t * p_start_info)
   fsal_status_t fsal_status;
   fsal_op_context_t fsal_context;
   unsigned int i;
+  struct timeval verifier_time;
+  uint32_t verifier[2];
 
 #if 0
   /* Will remain as long as all FSAL are not yet in new format */
@@ -1895,12 +2145,18 @@ int nfs_start(nfs_parameter_t * p_nfs_param, nfs_start_info_t * p_start_info)
   /* Set the server's boot time */
   ServerBootTime = time(NULL);
 
-  /* Set the write verifiers */
+  /* Set the write verifiers. They must change at each restart, since the unstable
+   * data not yet committed are lost then: the clients will write them again.
+   * The boot time alone is the same for two restarts within a second. */
+  gettimeofday(&verifier_time, NULL);
+  verifier[0] = (uint32_t) verifier_time.tv_sec;
+  verifier[1] = (uint32_t) verifier_time.tv_usec ^ ((uint32_t) getpid() << 20);
+
   memset(NFS3_write_verifier, 0, sizeof(writeverf3));
-  memcpy(NFS3_write_verifier, &ServerBootTime, sizeof(time_t));
+  memcpy(NFS3_write_verifier, verifier, sizeof(writeverf3));
 
   memset(NFS4_write_verifier, 0, sizeof(verifier4));
-  memcpy(NFS4_write_verifier, &ServerBootTime, sizeof(time_t));
+  memcpy(NFS4_write_verifier, verifier, sizeof(verifier4));
 
   /* Initialize all layers and service threads */
   nfs_Init(p_start_info);
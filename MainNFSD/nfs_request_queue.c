@@ -0,0 +1,424 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_request_queue.c
+ * \brief   Queues of pending requests between the dispatcher and the workers.
+ *
+ * nfs_request_queue.c : Queues of pending requests between the dispatcher and the workers.
+ *
+ * Each worker has a bounded lock-free queue (a ring of cells tagged with a sequence number,
+ * any thread can push or pop). The dispatcher pushes the requests to the workers' queues in a
+ * round robin way. A worker pops its own queue first, then steals from the queues of the
+ * other workers, so that a worker stuck in a slow FSAL call does not delay its backlog.
+ * A worker sleeps on its condition variable only when no queue has a request for it.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <pthread.h>
+#include <sched.h>
+#include "HashData.h"
+#include "HashTable.h"
+
+#if defined( _USE_TIRPC )
+#include <rpc/rpc.h>
+#elif defined( _USE_GSSRPC )
+#include <gssapi/gssapi.h>
+#include <gssrpc/rpc.h>
+#include <gssrpc/svc.h>
+#include <gssrpc/pmap_clnt.h>
+#else
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/pmap_clnt.h>
+#endif
+
+#include "log_macros.h"
+#include "stuff_alloc.h"
+#include "nfs_core.h"
+
+#define NFS_REQUEST_QUEUE_MIN_SIZE 16
+
+extern nfs_worker_data_t *workers_data;
+extern nfs_parameter_t nfs_param;
+
+#ifndef _NO_MOUNT_LIST
+/* The mount requests are processed by worker #0 only, they can't be stolen */
+static nfs_request_queue_t mount_queue;
+#endif
+
+/* Number of workers sleeping on their condition variable */
+static volatile unsigned int nb_sleeping_workers = 0;
+
+/**
+ * nfs_request_queue_init: initializes a queue of requests.
+ *
+ * @param pqueue the queue to be initialized.
+ * @param size the minimum number of requests that can be queued (rounded to a power of 2).
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_request_queue_init(nfs_request_queue_t * pqueue, unsigned int size)
+{
+  unsigned int nb_cells = NFS_REQUEST_QUEUE_MIN_SIZE;
+  unsigned int i;
+
+  while(nb_cells < size)
+    nb_cells <<= 1;
+
+  if((pqueue->cells =
+      (nfs_request_queue_cell_t *) Mem_Alloc(nb_cells *
+                                             sizeof(nfs_request_queue_cell_t))) == NULL)
+    return -1;
+
+  for(i = 0; i < nb_cells; i++)
+    {
+      pqueue->cells[i].sequence = i;
+      pqueue->cells[i].preq = NULL;
+    }
+
+  pqueue->mask = nb_cells - 1;
+  pqueue->head = 0;
+  pqueue->tail = 0;
+
+  return 0;
+}                               /* nfs_request_queue_init */
+
+/**
+ * nfs_request_queue_push: queues a request.
+ *
+ * A cell can be filled when its sequence is equal to the tail, and is ready to be popped when
+ * its sequence is equal to the tail + 1.
+ *
+ * @param pqueue the queue.
+ * @param preq the request to be queued.
+ *
+ * @return 0 if successfull, -1 if the queue is full.
+ *
+ */
+int nfs_request_queue_push(nfs_request_queue_t * pqueue, nfs_request_data_t * preq)
+{
+  nfs_request_queue_cell_t *pcell;
+  unsigned int pos = pqueue->tail;
+  int diff;
+
+  while(TRUE)
+    {
+      pcell = &pqueue->cells[pos & pqueue->mask];
+      diff = (int)(pcell->sequence - pos);
+
+      if(diff == 0)
+        {
+          if(__sync_bool_compare_and_swap(&pqueue->tail, pos, pos + 1))
+            break;
+        }
+      else if(diff < 0)
+        return -1;              /* the cell was not popped yet: queue is full */
+
+      pos = pqueue->tail;
+    }
+
+  pcell->preq = preq;
+  __sync_synchronize();
+  pcell->sequence = pos + 1;
+
+  return 0;
+}                               /* nfs_request_queue_push */
+
+/**
+ * nfs_request_queue_pop: gets the oldest request of a queue.
+ *
+ * @param pqueue the queue.
+ *
+ * @return the request, or NULL if the queue is empty.
+ *
+ */
+nfs_request_data_t *nfs_request_queue_pop(nfs_request_queue_t * pqueue)
+{
+  nfs_request_queue_cell_t *pcell;
+  nfs_request_data_t *preq;
+  unsigned int pos = pqueue->head;
+  int diff;
+
+  while(TRUE)
+    {
+      pcell = &pqueue->cells[pos & pqueue->mask];
+      diff = (int)(pcell->sequence - (pos + 1));
+
+      if(diff == 0)
+        {
+          if(__sync_bool_compare_and_swap(&pqueue->head, pos, pos + 1))
+            break;
+        }
+      else if(diff < 0)
+        return NULL;            /* the cell was not filled yet: queue is empty */
+
+      pos = pqueue->head;
+    }
+
+  preq = pcell->preq;
+  __sync_synchronize();
+
+  /* The cell will be filled again on next round */
+  pcell->sequence = pos + pqueue->mask + 1;
+
+  return preq;
+}                               /* nfs_request_queue_pop */
+
+/**
+ * nfs_request_queue_length: number of requests in a queue (for stats only).
+ *
+ * @param pqueue the queue.
+ *
+ * @return the number of queued requests.
+ *
+ */
+unsigned int nfs_request_queue_length(nfs_request_queue_t * pqueue)
+{
+  unsigned int head = pqueue->head;
+  unsigned int tail = pqueue->tail;
+
+  return (tail - head <= pqueue->mask + 1) ? tail - head : 0;
+}                               /* nfs_request_queue_length */
+
+/**
+ * nfs_rpc_queue_init: initializes the queues that are not related to a worker.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_rpc_queue_init(void)
+{
+#ifndef _NO_MOUNT_LIST
+  if(nfs_request_queue_init(&mount_queue,
+                            nfs_param.worker_param.lru_param.nb_entry_prealloc) != 0)
+    return -1;
+#endif
+
+  return 0;
+}                               /* nfs_rpc_queue_init */
+
+/**
+ * nfs_rpc_wake_worker: wakes up a sleeping worker after a request was queued.
+ *
+ * The worker the request was queued to is preferred. If it is busy, another sleeping worker
+ * is awaken to steal the request.
+ *
+ * @param worker_index the worker the request was queued to.
+ * @param only_this_one the request can't be processed by another worker.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_rpc_wake_worker(unsigned int worker_index, int only_this_one)
+{
+  nfs_worker_data_t *pworker;
+  unsigned int i;
+
+  /* Pairs with the barrier in the worker, between setting 'sleeping' and checking the queues */
+  __sync_synchronize();
+
+  if(nb_sleeping_workers == 0)
+    return;
+
+  for(i = 0; i < nfs_param.core_param.nb_worker; i++)
+    {
+      pworker = &workers_data[(worker_index + i) % nfs_param.core_param.nb_worker];
+
+      if(pworker->sleeping)
+        {
+          P(pworker->mutex_req_condvar);
+          pthread_cond_signal(&(pworker->req_condvar));
+          V(pworker->mutex_req_condvar);
+          return;
+        }
+
+      if(only_this_one)
+        return;
+    }
+}                               /* nfs_rpc_wake_worker */
+
+/**
+ * nfs_rpc_queue_request: queues a request for the workers.
+ *
+ * The request is queued to the worker it was allocated for (see nfs_rpc_get_worker_index),
+ * or to the next one with room in its queue. If all the queues are full, the caller waits,
+ * which stops reading the sockets until the workers catch up.
+ *
+ * @param preq the request to be processed.
+ * @param mount_protocol_flag TRUE if the request must be processed by the mount worker.
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_rpc_queue_request(nfs_request_data_t * preq, int mount_protocol_flag)
+{
+  unsigned int nb_worker = nfs_param.core_param.nb_worker;
+  unsigned int worker_index;
+  unsigned int i;
+
+#ifndef _NO_MOUNT_LIST
+  if(mount_protocol_flag == TRUE)
+    {
+      while(nfs_request_queue_push(&mount_queue, preq) != 0)
+        sched_yield();
+
+      nfs_rpc_wake_worker(0, TRUE);
+      return;
+    }
+#endif
+
+  while(TRUE)
+    {
+      for(i = 0; i < nb_worker; i++)
+        {
+          worker_index = (preq->worker_index + i) % nb_worker;
+
+          if(nfs_request_queue_push(&workers_data[worker_index].request_queue, preq) == 0)
+            {
+              LogFullDebug(COMPONENT_DISPATCH, "Request queued to worker #%u", worker_index);
+              nfs_rpc_wake_worker(worker_index, FALSE);
+              return;
+            }
+        }
+
+      LogDebug(COMPONENT_DISPATCH, "All the request queues are full, waiting for the workers");
+      sched_yield();
+    }
+}                               /* nfs_rpc_queue_request */
+
+/**
+ * nfs_rpc_dequeue_request: gets a request to be processed by a worker.
+ *
+ * The worker processes the requests from its own queue first, then steals from the other ones.
+ *
+ * @param pworker the worker.
+ *
+ * @return the request, or NULL if there is nothing to do.
+ *
+ */
+nfs_request_data_t *nfs_rpc_dequeue_request(nfs_worker_data_t * pworker)
+{
+  unsigned int nb_worker = nfs_param.core_param.nb_worker;
+  nfs_request_data_t *preq;
+  unsigned int i;
+
+#ifndef _NO_MOUNT_LIST
+  if(pworker->index == 0 && (preq = nfs_request_queue_pop(&mount_queue)) != NULL)
+    return preq;
+#endif
+
+  for(i = 0; i < nb_worker; i++)
+    if((preq =
+        nfs_request_queue_pop(&workers_data[(pworker->index + i) % nb_worker].request_queue))
+       != NULL)
+      {
+        if(i != 0)
+          LogFullDebug(COMPONENT_DISPATCH, "NFS WORKER #%d: request stolen from worker #%u",
+                       pworker->index, (pworker->index + i) % nb_worker);
+        return preq;
+      }
+
+  return NULL;
+}                               /* nfs_rpc_dequeue_request */
+
+/**
+ * nfs_rpc_request_available: tells if a worker has something to do.
+ *
+ * @param pworker the worker.
+ *
+ * @return TRUE if a request can be dequeued by the worker, FALSE otherwise.
+ *
+ */
+int nfs_rpc_request_available(nfs_worker_data_t * pworker)
+{
+  unsigned int i;
+
+#ifndef _NO_MOUNT_LIST
+  if(pworker->index == 0 && nfs_request_queue_length(&mount_queue) != 0)
+    return TRUE;
+#endif
+
+  for(i = 0; i < nfs_param.core_param.nb_worker; i++)
+    if(nfs_request_queue_length(&workers_data[i].request_queue) != 0)
+      return TRUE;
+
+  return FALSE;
+}                               /* nfs_rpc_request_available */
+
+/**
+ * nfs_rpc_worker_sleep: blocks a worker until a request is queued.
+ *
+ * @param pworker the worker.
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_rpc_worker_sleep(nfs_worker_data_t * pworker)
+{
+  P(pworker->mutex_req_condvar);
+
+  pworker->sleeping = TRUE;
+  __sync_fetch_and_add(&nb_sleeping_workers, 1);
+
+  /* A request queued before 'sleeping' was set is seen here, one queued after
+   * finds the worker sleeping and signals it */
+  __sync_synchronize();
+
+  if(!nfs_rpc_request_available(pworker) && pworker->reparse_exports_in_progress == FALSE)
+    pthread_cond_wait(&(pworker->req_condvar), &(pworker->mutex_req_condvar));
+
+  __sync_fetch_and_sub(&nb_sleeping_workers, 1);
+  pworker->sleeping = FALSE;
+
+  V(pworker->mutex_req_condvar);
+}                               /* nfs_rpc_worker_sleep */
+
+/**
+ * nfs_rpc_release_request: gives a processed request back to its request pool.
+ *
+ * @param preq the request.
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_rpc_release_request(nfs_request_data_t * preq)
+{
+  nfs_worker_data_t *pworker = &workers_data[preq->worker_index];
+
+  P(pworker->request_pool_mutex);
+  RELEASE_PREALLOC(preq, pworker->request_pool, next_alloc);
+  V(pworker->request_pool_mutex);
+}                               /* nfs_rpc_release_request */
@@ -109,11 +109,10 @@ void socket_setoptions(int socketFd);
 extern fd_set Svc_fdset;
 extern nfs_worker_data_t *workers_data;
 extern nfs_parameter_t nfs_param;
-extern SVCXPRT *Xports[FD_SETSIZE];     /* The one from RPCSEC_GSS library */
+extern SVCXPRT *Xports[XPRT_TABLE_SIZE];     /* The one from RPCSEC_GSS library */
 #ifdef _RPCSEC_GS_64_INSTALLED
 struct svc_rpc_gss_data **TabGssData;
 #endif
-extern hash_table_t *ht_dupreq; /* duplicate request hash */
 
 extern pthread_mutex_t mutex_cond_xprt[FD_SETSIZE];
 extern pthread_cond_t condvar_xprt[FD_SETSIZE];
@@ -1534,56 +1533,6 @@ int nfs_Init_svc()
   return 0;
 }                               /* nfs_Init_svc */
 
-/**
- * Selects the smallest request queue,
- * whome the worker is ready and is not garbagging.
- */
-static unsigned int select_worker_queue()
-{
-#define NO_VALUE_CHOOSEN  1000000
-  unsigned int worker_index = NO_VALUE_CHOOSEN;
-  unsigned int min_number_pending = NO_VALUE_CHOOSEN;
-
-  unsigned int i;
-  static unsigned int last;
-  unsigned int cpt = 0;
-
-  do
-    {
-
-      /* chose the smallest queue */
-
-      for(i = (last + 1) % nfs_param.core_param.nb_worker, cpt = 0;
-          cpt < nfs_param.core_param.nb_worker;
-          cpt++, i = (i + 1) % nfs_param.core_param.nb_worker)
-        {
-          /* Choose only fully initialized workers and that does not gc */
-
-          if((workers_data[i].gc_in_progress == FALSE)
-             && (workers_data[i].is_ready == TRUE))
-            {
-              if(workers_data[i].pending_request->nb_entry < min_number_pending)
-                {
-                  worker_index = i;
-                  min_number_pending = workers_data[i].pending_request->nb_entry;
-                }
-            }
-          else if(!workers_data[i].is_ready)
-            LogFullDebug(COMPONENT_DISPATCH, "worker thread #%u is not ready", i);
-          else if(workers_data[i].gc_in_progress)
-            LogFullDebug(COMPONENT_DISPATCH,
-                         "worker thread #%u is doing garbage collection", i);
-        }
-
-    }
-  while(worker_index == NO_VALUE_CHOOSEN);
-
-  last = worker_index;
-
-  return worker_index;
-
-}                               /* select_worker_queue */
-
 /**
  *
  * nfs_rpc_get_worker_index: Returns the index of the worker to be used
@@ -1595,372 +1544,329 @@ static unsigned int select_worker_queue()
  */
 int nfs_rpc_get_worker_index(int mount_protocol_flag)
 {
-  int worker_index = -1;
+  static unsigned int next_worker = 0;
 
 #ifndef _NO_MOUNT_LIST
   if(mount_protocol_flag == TRUE)
-    worker_index = 0;           /* worker #0 is dedicated to mount protocol */
-  else
-    worker_index = select_worker_queue();
-#else
-  /* choose a worker depending on its queue length */
-  worker_index = select_worker_queue();
+    return 0;                   /* worker #0 is dedicated to mount protocol */
 #endif
 
-  return worker_index;
+  /* Round robin: the queues are balanced by the workers stealing from each other */
+  return __sync_fetch_and_add(&next_worker, 1) % nfs_param.core_param.nb_worker;
 }                               /* nfs_rpc_get_worker_index */
 
 /**
- * nfs_rpc_getreq: Do half of the work done by svc_getreqset.
+ * nfs_rpc_getreq_xprt: gets a request from a socket with input waiting.
  *
- * This function wait for an incoming ONC message by waiting on a 'select' statement. Then getting a request
- * it perform the authentication and extracts the RPC message for the related socket. It then find the less busy
- * worker (the one with the shortest pending queue) and put the msg in this queue.
- * 
- * @param readfds File Descriptor Set related to the socket used for RPC management.
- * 
- * @return Nothing (void function), but calls svcerr_* function to notify the client when an error occures. 
+ * Performs the SVC_RECV on the socket, then puts the msg in the queue of the next worker
+ * (see nfs_rpc_queue_request).
+ *
+ * @param xprt the transport related to the socket.
+ * @param sock the socket with input waiting.
+ *
+ * @return NFS_RPC_XPRT_BUSY if a request was queued from a connected TCP client: the worker
+ *         releases the socket once the request is replied. NFS_RPC_XPRT_DEAD if the client
+ *         disappeared (the transport is destroyed). NFS_RPC_XPRT_IDLE otherwise.
  *
  */
-void nfs_rpc_getreq(fd_set * readfds, nfs_parameter_t * pnfs_para)
+int nfs_rpc_getreq_xprt(SVCXPRT * xprt, int sock)
 {
   enum xprt_stat stat;
   struct rpc_msg *pmsg;
   struct svc_req *preq;
-  register SVCXPRT *xprt;
-  register int bit;
-  register long mask, *maskp;
-  register int sock;
   char *cred_area;
   struct sockaddr_in *pdead_caller = NULL;
   char dead_caller[MAXNAMLEN];
 
-  LRU_entry_t *pentry = NULL;
-  LRU_status_t status;
   nfs_request_data_t *pnfsreq = NULL;
   int worker_index;
   int mount_flag = FALSE;
+  int connected = FALSE;
+  int rc = NFS_RPC_XPRT_IDLE;
 
-  /* portable access to fds_bits field */
-  maskp = __FDS_BITS(readfds);
+  /* A few thread manage only mount protocol, check for this */
+  if((nfs_param.worker_param.nfs_svc_data.socket_mnt_udp == sock) ||
+     (nfs_param.worker_param.nfs_svc_data.socket_mnt_tcp == sock))
+    mount_flag = TRUE;
+  else
+    mount_flag = FALSE;
 
-  for(sock = 0; sock < FD_SETSIZE; sock += NFDBITS)
+  /* Get a worker to do the job */
+  if((worker_index = nfs_rpc_get_worker_index(mount_flag)) < 0)
     {
-      for(mask = *maskp++; bit = ffs(mask); mask ^= (1 << (bit - 1)))
-        {
-          /* sock has input waiting */
-          xprt = Xports[sock + bit - 1];
-          if(xprt == NULL)
-            {
-              /* But do we control sock? */
-              LogCrit(COMPONENT_DISPATCH,
-                      "CRITICAL ERROR: Incoherency found in Xports array");
-              continue;
-            }
-
-          /* A few thread manage only mount protocol, check for this */
-          if((nfs_param.worker_param.nfs_svc_data.socket_mnt_udp == sock + bit - 1) ||
-             (nfs_param.worker_param.nfs_svc_data.socket_mnt_tcp == sock + bit - 1))
-            mount_flag = TRUE;
-          else
-            mount_flag = FALSE;
-
-          /* Get a worker to do the job */
-          if((worker_index = nfs_rpc_get_worker_index(mount_flag)) < 0)
-            {
-              LogCrit(COMPONENT_DISPATCH, "CRITICAL ERROR: Couldn't choose a worker ! Exiting...");
-              exit(1);
-            }
+      LogCrit(COMPONENT_DISPATCH, "CRITICAL ERROR: Couldn't choose a worker ! Exiting...");
+      exit(1);
+    }
 #if defined( _USE_TIRPC ) || defined( _FREEBSD )
-          LogFullDebug(COMPONENT_DISPATCH, "Use request from spool #%d, xprt->xp_sock=%d",
-                       worker_index, xprt->xp_fd);
+  LogFullDebug(COMPONENT_DISPATCH, "Use request from spool #%d, xprt->xp_sock=%d",
+               worker_index, xprt->xp_fd);
 #else
-          LogFullDebug(COMPONENT_DISPATCH, "Use request from spool #%d, xprt->xp_sock=%d",
-                       worker_index, xprt->xp_sock);
+  LogFullDebug(COMPONENT_DISPATCH, "Use request from spool #%d, xprt->xp_sock=%d",
+               worker_index, xprt->xp_sock);
 #endif
 
-          /* Get a pnfsreq from the worker's pool */
-          P(workers_data[worker_index].request_pool_mutex);
+  /* Get a pnfsreq from the worker's pool */
+  P(workers_data[worker_index].request_pool_mutex);
 
 #ifdef _DEBUG_MEMLEAKS
-          /* For debugging memory leaks */
-          BuddySetDebugLabel("nfs_request_data_t");
+  /* For debugging memory leaks */
+  BuddySetDebugLabel("nfs_request_data_t");
 #endif
 
-          GET_PREALLOC_CONSTRUCT(pnfsreq,
-                                 workers_data[worker_index].request_pool,
-                                 nfs_param.worker_param.nb_pending_prealloc,
-                                 nfs_request_data_t,
-                                 next_alloc, constructor_nfs_request_data_t);
+  GET_PREALLOC_CONSTRUCT(pnfsreq,
+                         workers_data[worker_index].request_pool,
+                         nfs_param.worker_param.nb_pending_prealloc,
+                         nfs_request_data_t,
+                         next_alloc, constructor_nfs_request_data_t);
 
 #ifdef _DEBUG_MEMLEAKS
-          /* For debugging memory leaks */
-          BuddySetDebugLabel("N/A");
+  /* For debugging memory leaks */
+  BuddySetDebugLabel("N/A");
 #endif
-          V(workers_data[worker_index].request_pool_mutex);
+  V(workers_data[worker_index].request_pool_mutex);
 
-          if(pnfsreq == NULL)
-            {
-              LogCrit(COMPONENT_DISPATCH,
-                      "CRITICAL ERROR: empty request pool for the chosen worker ! Exiting...");
-              exit(0);
-            }
+  if(pnfsreq == NULL)
+    {
+      LogCrit(COMPONENT_DISPATCH,
+              "CRITICAL ERROR: empty request pool for the chosen worker ! Exiting...");
+      exit(0);
+    }
 
-          /* Set up pointers */
-          cred_area = pnfsreq->cred_area;
-          preq = &(pnfsreq->req);
-          pmsg = &(pnfsreq->msg);
-
-          pmsg->rm_call.cb_cred.oa_base = cred_area;
-          pmsg->rm_call.cb_verf.oa_base = &(cred_area[MAX_AUTH_BYTES]);
-          preq->rq_clntcred = &(cred_area[2 * MAX_AUTH_BYTES]);
-
-          /*
-           * UDP RPCs are quite simple: everything comes to the same socket, so several SVCXPRT
-           * can be defined, one per tbuf to handle the stuff
-           * TCP RPCs are more complex:
-           *   - a unique SVCXPRT exists that deals with initial tcp rendez vous. It does the accept
-           *     with the client, but recv no message from the client. But SVC_RECV on it creates
-           *     a new SVCXPRT dedicated to the client. This specific SVXPRT is bound on TCPSocket
-           *
-           * while receiving something on the Svc_fdset, I must know if this is a UDP request,
-           * an initial TCP request or a TCP socket from an already connected client.
-           * This is how to distinguish the cases:
-           * UDP connections are bound to socket NFS_UDPSocket
-           * TCP initial connections are bound to socket NFS_TCPSocket
-           * all the other cases are requests from already connected TCP Clients
-           */
-
-          if(nfs_param.worker_param.nfs_svc_data.socket_nfs_udp == sock + bit - 1)
-            {
-              /* This is a regular UDP connection */
-              LogFullDebug(COMPONENT_DISPATCH, "A NFS UDP request");
-              pnfsreq->xprt = pnfsreq->nfs_udp_xprt;
-              pnfsreq->ipproto = IPPROTO_UDP;
+  /* The request goes back to this pool once processed, whatever the worker processing it */
+  pnfsreq->worker_index = worker_index;
 
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
-          else if(nfs_param.worker_param.nfs_svc_data.socket_mnt_udp == sock + bit - 1)
-            {
-              LogFullDebug(COMPONENT_DISPATCH, "A MOUNT UDP request");
-              pnfsreq->xprt = pnfsreq->mnt_udp_xprt;
-              pnfsreq->ipproto = IPPROTO_UDP;
+  /* Set up pointers */
+  cred_area = pnfsreq->cred_area;
+  preq = &(pnfsreq->req);
+  pmsg = &(pnfsreq->msg);
 
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
+  pmsg->rm_call.cb_cred.oa_base = cred_area;
+  pmsg->rm_call.cb_verf.oa_base = &(cred_area[MAX_AUTH_BYTES]);
+  preq->rq_clntcred = &(cred_area[2 * MAX_AUTH_BYTES]);
+
+  /*
+   * UDP RPCs are quite simple: everything comes to the same socket, so several SVCXPRT
+   * can be defined, one per tbuf to handle the stuff
+   * TCP RPCs are more complex:
+   *   - a unique SVCXPRT exists that deals with initial tcp rendez vous. It does the accept
+   *     with the client, but recv no message from the client. But SVC_RECV on it creates
+   *     a new SVCXPRT dedicated to the client. This specific SVXPRT is bound on TCPSocket
+   *
+   * while receiving something on the Svc_fdset, I must know if this is a UDP request,
+   * an initial TCP request or a TCP socket from an already connected client.
+   * This is how to distinguish the cases:
+   * UDP connections are bound to socket NFS_UDPSocket
+   * TCP initial connections are bound to socket NFS_TCPSocket
+   * all the other cases are requests from already connected TCP Clients
+   */
+
+  if(nfs_param.worker_param.nfs_svc_data.socket_nfs_udp == sock)
+    {
+      /* This is a regular UDP connection */
+      LogFullDebug(COMPONENT_DISPATCH, "A NFS UDP request");
+      pnfsreq->xprt = pnfsreq->nfs_udp_xprt;
+      pnfsreq->ipproto = IPPROTO_UDP;
+
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
+  else if(nfs_param.worker_param.nfs_svc_data.socket_mnt_udp == sock)
+    {
+      LogFullDebug(COMPONENT_DISPATCH, "A MOUNT UDP request");
+      pnfsreq->xprt = pnfsreq->mnt_udp_xprt;
+      pnfsreq->ipproto = IPPROTO_UDP;
+
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
 #ifdef _USE_NLM
-          else if(nfs_param.worker_param.nfs_svc_data.socket_nlm_udp == sock + bit - 1)
-            {
-              LogFullDebug(COMPONENT_DISPATCH, "A NLM UDP request");
-              pnfsreq->xprt = pnfsreq->nlm_udp_xprt;
-              pnfsreq->ipproto = IPPROTO_UDP;
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
+  else if(nfs_param.worker_param.nfs_svc_data.socket_nlm_udp == sock)
+    {
+      LogFullDebug(COMPONENT_DISPATCH, "A NLM UDP request");
+      pnfsreq->xprt = pnfsreq->nlm_udp_xprt;
+      pnfsreq->ipproto = IPPROTO_UDP;
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
 #endif                          /* _USE_NLM */
 #ifdef _USE_QUOTA
-          else if(nfs_param.worker_param.nfs_svc_data.socket_rquota_udp == sock + bit - 1)
-            {
-              LogFullDebug(COMPONENT_DISPATCH, "A RQUOTA UDP request");
-              pnfsreq->xprt = pnfsreq->rquota_udp_xprt;
-              pnfsreq->ipproto = IPPROTO_UDP;
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
+  else if(nfs_param.worker_param.nfs_svc_data.socket_rquota_udp == sock)
+    {
+      LogFullDebug(COMPONENT_DISPATCH, "A RQUOTA UDP request");
+      pnfsreq->xprt = pnfsreq->rquota_udp_xprt;
+      pnfsreq->ipproto = IPPROTO_UDP;
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
 #endif                          /* _USE_QUOTA */
-          else if(nfs_param.worker_param.nfs_svc_data.socket_nfs_tcp == sock + bit - 1)
-            {
-              /* 
-               * This is an initial tcp connection 
-               * There is no RPC message, this is only a TCP connect.
-               * In this case, the SVC_RECV does only produces a new connected socket (it does
-               * just a call to accept and FD_SET)
-               * there is no need of worker thread processing to be done
-               */
-              LogFullDebug(COMPONENT_DISPATCH,
-                           "An initial NFS TCP request from a new client");
-              pnfsreq->xprt = nfs_param.worker_param.nfs_svc_data.xprt_nfs_tcp;
-              pnfsreq->ipproto = IPPROTO_TCP;
-
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
-          else if(nfs_param.worker_param.nfs_svc_data.socket_mnt_tcp == sock + bit - 1)
-            {
-              LogFullDebug(COMPONENT_DISPATCH,
-                           "An initial MOUNT TCP request from a new client");
-              pnfsreq->xprt = nfs_param.worker_param.nfs_svc_data.xprt_mnt_tcp;
-              pnfsreq->ipproto = IPPROTO_TCP;
+  else if(nfs_param.worker_param.nfs_svc_data.socket_nfs_tcp == sock)
+    {
+      /* 
+       * This is an initial tcp connection 
+       * There is no RPC message, this is only a TCP connect.
+       * In this case, the SVC_RECV does only produces a new connected socket (it does
+       * just a call to accept and FD_SET)
+       * there is no need of worker thread processing to be done
+       */
+      LogFullDebug(COMPONENT_DISPATCH,
+                   "An initial NFS TCP request from a new client");
+      pnfsreq->xprt = nfs_param.worker_param.nfs_svc_data.xprt_nfs_tcp;
+      pnfsreq->ipproto = IPPROTO_TCP;
 
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
+  else if(nfs_param.worker_param.nfs_svc_data.socket_mnt_tcp == sock)
+    {
+      LogFullDebug(COMPONENT_DISPATCH,
+                   "An initial MOUNT TCP request from a new client");
+      pnfsreq->xprt = nfs_param.worker_param.nfs_svc_data.xprt_mnt_tcp;
+      pnfsreq->ipproto = IPPROTO_TCP;
+
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
 #ifdef _USE_NLM
-          else if(nfs_param.worker_param.nfs_svc_data.socket_nlm_tcp == sock + bit - 1)
-            {
-              LogFullDebug(COMPONENT_DISPATCH, "An initial NLM request from a new client");
-              pnfsreq->xprt = nfs_param.worker_param.nfs_svc_data.xprt_nlm_tcp;
-              pnfsreq->ipproto = IPPROTO_TCP;
+  else if(nfs_param.worker_param.nfs_svc_data.socket_nlm_tcp == sock)
+    {
+      LogFullDebug(COMPONENT_DISPATCH, "An initial NLM request from a new client");
+      pnfsreq->xprt = nfs_param.worker_param.nfs_svc_data.xprt_nlm_tcp;
+      pnfsreq->ipproto = IPPROTO_TCP;
 
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
 #endif                          /* _USE_NLM */
 #ifdef _USE_QUOTA
-          else if(nfs_param.worker_param.nfs_svc_data.socket_rquota_tcp == sock + bit - 1)
-            {
-              LogFullDebug(COMPONENT_DISPATCH,
-                           "An initial RQUOTA request from a new client");
-              pnfsreq->xprt = nfs_param.worker_param.nfs_svc_data.xprt_rquota_tcp;
-              pnfsreq->ipproto = IPPROTO_TCP;
+  else if(nfs_param.worker_param.nfs_svc_data.socket_rquota_tcp == sock)
+    {
+      LogFullDebug(COMPONENT_DISPATCH,
+                   "An initial RQUOTA request from a new client");
+      pnfsreq->xprt = nfs_param.worker_param.nfs_svc_data.xprt_rquota_tcp;
+      pnfsreq->ipproto = IPPROTO_TCP;
 
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
 #endif                          /* _USE_QUOTA */
-          else
-            {
-              /* This is a regular tcp request on an established connection, should be handle by a dedicated thread */
-              LogFullDebug(COMPONENT_DISPATCH,
-                           "A NFS TCP request from an already connected client");
-              pnfsreq->tcp_xprt = xprt;
-              pnfsreq->xprt = pnfsreq->tcp_xprt;
-              pnfsreq->ipproto = IPPROTO_TCP;
-
-              pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
-            }
-          LogFullDebug(COMPONENT_DISPATCH, "Status for SVC_RECV on socket %d is %d",
-                       sock + bit - 1, pnfsreq->status);
+  else
+    {
+      /* This is a regular tcp request on an established connection */
+      LogFullDebug(COMPONENT_DISPATCH,
+                   "A NFS TCP request from an already connected client");
+      connected = TRUE;
+      pnfsreq->tcp_xprt = xprt;
+      pnfsreq->xprt = pnfsreq->tcp_xprt;
+      pnfsreq->ipproto = IPPROTO_TCP;
 
-          /* If status is ok, the request will be processed by the related
-           * worker, otherwise, it should be released by being tagged as invalid*/
-          if(!pnfsreq->status)
-            {
-              /* RPC over TCP specific: RPC/UDP's xprt know only one state: XPRT_IDLE, because UDP is mostly
-               * a stateless protocol. With RPC/TCP, they can be XPRT_DIED especially when the client closes
-               * the peer's socket. We have to cope with this aspect in the next lines */
+      pnfsreq->status = SVC_RECV(pnfsreq->xprt, &(pnfsreq->msg));
+    }
+  LogFullDebug(COMPONENT_DISPATCH, "Status for SVC_RECV on socket %d is %d",
+               sock, pnfsreq->status);
 
-              stat = SVC_STAT(pnfsreq->xprt);
-              if(stat == XPRT_DIED)
-                {
+  /* If status is ok, the request will be processed by the related
+   * worker, otherwise, it should be released by being tagged as invalid*/
+  if(!pnfsreq->status)
+    {
+      /* RPC over TCP specific: RPC/UDP's xprt know only one state: XPRT_IDLE, because UDP is mostly
+       * a stateless protocol. With RPC/TCP, they can be XPRT_DIED especially when the client closes
+       * the peer's socket. We have to cope with this aspect in the next lines */
+
+      stat = SVC_STAT(pnfsreq->xprt);
+      if(stat == XPRT_DIED)
+        {
 #ifndef _USE_TIRPC
-                  if((pdead_caller = svc_getcaller(pnfsreq->xprt)) != NULL)
-                    {
-                      snprintf(dead_caller, MAXNAMLEN, "0x%x=%d.%d.%d.%d",
-                               ntohl(pdead_caller->sin_addr.s_addr),
-                               (ntohl(pdead_caller->sin_addr.s_addr) & 0xFF000000) >> 24,
-                               (ntohl(pdead_caller->sin_addr.s_addr) & 0x00FF0000) >> 16,
-                               (ntohl(pdead_caller->sin_addr.s_addr) & 0x0000FF00) >> 8,
-                               (ntohl(pdead_caller->sin_addr.s_addr) & 0x000000FF));
-                    }
-                  else
+          if((pdead_caller = svc_getcaller(pnfsreq->xprt)) != NULL)
+            {
+              snprintf(dead_caller, MAXNAMLEN, "0x%x=%d.%d.%d.%d",
+                       ntohl(pdead_caller->sin_addr.s_addr),
+                       (ntohl(pdead_caller->sin_addr.s_addr) & 0xFF000000) >> 24,
+                       (ntohl(pdead_caller->sin_addr.s_addr) & 0x00FF0000) >> 16,
+                       (ntohl(pdead_caller->sin_addr.s_addr) & 0x0000FF00) >> 8,
+                       (ntohl(pdead_caller->sin_addr.s_addr) & 0x000000FF));
+            }
+          else
 #endif                          /* _USE_TIRPC */
-                    strncpy(dead_caller, "unresolved", MAXNAMLEN);
+            strncpy(dead_caller, "unresolved", MAXNAMLEN);
 
 #if defined( _USE_TIRPC ) || defined( _FREEBSD )
-                  LogEvent(COMPONENT_DISPATCH, "A client disappeared... socket=%d, addr=%s",
-                             pnfsreq->xprt->xp_fd, dead_caller);
-                  if(Xports[pnfsreq->xprt->xp_fd] != NULL)
-                    SVC_DESTROY(Xports[pnfsreq->xprt->xp_fd]);
+          LogEvent(COMPONENT_DISPATCH, "A client disappeared... socket=%d, addr=%s",
+                     pnfsreq->xprt->xp_fd, dead_caller);
+          if(Xports[pnfsreq->xprt->xp_fd] != NULL)
+            SVC_DESTROY(Xports[pnfsreq->xprt->xp_fd]);
 #else
-                  LogEvent(COMPONENT_DISPATCH, "A client disappeared... socket=%d, addr=%s",
-                             pnfsreq->xprt->xp_sock, dead_caller);
-                  if(Xports[pnfsreq->xprt->xp_sock] != NULL)
-                    SVC_DESTROY(Xports[pnfsreq->xprt->xp_sock]);
+          LogEvent(COMPONENT_DISPATCH, "A client disappeared... socket=%d, addr=%s",
+                     pnfsreq->xprt->xp_sock, dead_caller);
+          if(Xports[pnfsreq->xprt->xp_sock] != NULL)
+            SVC_DESTROY(Xports[pnfsreq->xprt->xp_sock]);
 #endif
 
-                  P(workers_data[worker_index].request_pool_mutex);
-                  RELEASE_PREALLOC(pnfsreq, workers_data[worker_index].request_pool,
-                                   next_alloc);
-                  V(workers_data[worker_index].request_pool_mutex);
-
-                }
-              else if(stat == XPRT_MOREREQS)
-                {
-                  LogDebug(COMPONENT_DISPATCH,
-                           "Client on socket %d has status XPRT_MOREREQS",
+          rc = NFS_RPC_XPRT_DEAD;
+        }
+      else if(stat == XPRT_MOREREQS)
+        {
+          LogDebug(COMPONENT_DISPATCH,
+                   "Client on socket %d has status XPRT_MOREREQS",
 #if defined( _USE_TIRPC ) || defined( _FREEBSD )
-                                  pnfsreq->xprt->xp_fd);
+                          pnfsreq->xprt->xp_fd);
 #else
-                                  pnfsreq->xprt->xp_sock);
+                          pnfsreq->xprt->xp_sock);
 #endif
-                }
-
-              /* Release the entry */
-              LogFullDebug(COMPONENT_DISPATCH,
-                           "NFS DISPATCH: Invalidating entry with xprt_stat=%d", stat);
-              workers_data[worker_index].passcounter += 1;
-            }
-          else
-            {
-              /* This should be used for UDP requests only, TCP request have dedicted management threads */
-              LogFullDebug(COMPONENT_DISPATCH, "Awaking thread #%d", worker_index);
-
-              P(workers_data[worker_index].mutex_req_condvar);
-              P(workers_data[worker_index].request_pool_mutex);
-
-              if((pentry =
-                  LRU_new_entry(workers_data[worker_index].pending_request,
-                                &status)) == NULL)
-                {
-                  V(workers_data[worker_index].mutex_req_condvar);
-                  V(workers_data[worker_index].request_pool_mutex);
-                  LogMajor(COMPONENT_DISPATCH,
-                           "Error while inserting pending request to Thread #%d... exiting",
-                           worker_index);
-                  exit(1);
-                }
-              pentry->buffdata.pdata = (caddr_t) pnfsreq;
-              pentry->buffdata.len = sizeof(*pnfsreq);
-
-              if(pthread_cond_signal(&(workers_data[worker_index].req_condvar)) == -1)
-                {
-                  V(workers_data[worker_index].mutex_req_condvar);
-                  V(workers_data[worker_index].request_pool_mutex);
-                  LogCrit(COMPONENT_DISPATCH, "NFS DISPATCH: Cond signal failed for thr#%d , errno = %d",
-                             worker_index, errno);
-                  exit(1);
-                }
-              V(workers_data[worker_index].mutex_req_condvar);
-              V(workers_data[worker_index].request_pool_mutex);
-            }
         }
-    }
-}                               /* nfs_rpc_getreq */
 
-/**
- *
- * clean_pending_request: cleans an entry in a nfs request LRU,
- *
- * cleans an entry in a nfs request LRU.
- *
- * @param pentry [INOUT] entry to be cleaned. 
- * @param addparam [IN] additional parameter used for cleaning.
- *
- * @return 0 if ok, other values mean an error.
- *
- */
-int clean_pending_request(LRU_entry_t * pentry, void *addparam)
-{
-  nfs_request_data_t **preqnfspool = (nfs_request_data_t **) addparam;
-  nfs_request_data_t *preqnfs = (nfs_request_data_t *) (pentry->buffdata.pdata);
+      /* Release the entry */
+      LogFullDebug(COMPONENT_DISPATCH,
+                   "NFS DISPATCH: Invalidating entry with xprt_stat=%d", stat);
+      P(workers_data[worker_index].request_pool_mutex);
+      RELEASE_PREALLOC(pnfsreq, workers_data[worker_index].request_pool, next_alloc);
+      V(workers_data[worker_index].request_pool_mutex);
 
-  /* Send the entry back to the pool */
-  RELEASE_PREALLOC(preqnfs, *preqnfspool, next_alloc);
+      workers_data[worker_index].passcounter += 1;
+    }
+  else
+    {
+      nfs_rpc_queue_request(pnfsreq, mount_flag);
 
-  return 0;
-}                               /* clean_pending_request */
+      /* The next request on the connection will be read once this one is replied */
+      if(connected)
+        rc = NFS_RPC_XPRT_BUSY;
+    }
+
+  return rc;
+}                               /* nfs_rpc_getreq_xprt */
 
 /**
+ * nfs_rpc_getreq: Do half of the work done by svc_getreqset.
  *
- * print_pending_request: prints an entry related to a pending request in the LRU list.
+ * This function is called for each socket set by the 'select' statement of the dispatcher.
+ * It gets the related transport, then lets nfs_rpc_getreq_xprt extract the RPC message and put
+ * it in the queue of a worker.
  * 
- * prints an entry related to a pending request in the LRU list.
- *
- * @param data [IN] data stored in a LRU entry to be printed.
- * @param str [OUT] string used to store the result. 
- *
- * @return 0 if ok, other values mean an error.
+ * @param readfds File Descriptor Set related to the socket used for RPC management.
+ * 
+ * @return Nothing (void function), but calls svcerr_* function to notify the client when an error occures. 
  *
  */
-int print_pending_request(LRU_data_t data, char *str)
+void nfs_rpc_getreq(fd_set * readfds, nfs_parameter_t * pnfs_para)
 {
-  return snprintf(str, LRU_DISPLAY_STRLEN, "not implemented for now");
-}                               /* print_pending_request */
+  register SVCXPRT *xprt;
+  register int bit;
+  register long mask, *maskp;
+  register int sock;
+
+  /* portable access to fds_bits field */
+  maskp = __FDS_BITS(readfds);
+
+  for(sock = 0; sock < FD_SETSIZE; sock += NFDBITS)
+    {
+      for(mask = *maskp++; bit = ffs(mask); mask ^= (1 << (bit - 1)))
+        {
+          /* sock has input waiting */
+          xprt = Xports[sock + bit - 1];
+          if(xprt == NULL)
+            {
+              /* But do we control sock? */
+              LogCrit(COMPONENT_DISPATCH,
+                      "CRITICAL ERROR: Incoherency found in Xports array");
+              continue;
+            }
+
+          nfs_rpc_getreq_xprt(xprt, sock + bit - 1);
+        }
+    }
+}                               /* nfs_rpc_getreq */
 
 /**
  * nfs_rpc_dispatcher_svc_run: the same as svc_run.
@@ -2033,8 +1939,7 @@ void rpc_dispatcher_svc_run(nfs_parameter_t * pnfs_param)
 /**
  * rpc_dispatcher_thread: thread used for RPC dispatching.
  *
- * Thead used for RPC dispatching. It gets the requests and then spool it to one of the worker's LRU.
- * The worker chosen is the one with the smaller load (its LRU is the shorter one).
+ * Thead used for RPC dispatching. It gets the requests and then spool them to the workers' queues.
  * 
  * @param IndexArg the index for the worker thread (unused)
  * 
@@ -2063,7 +1968,12 @@ void *rpc_dispatcher_thread(void *Arg)
 
   LogDebug(COMPONENT_DISPATCH, "NFS DISPATCHER: my pthread id is %p", (caddr_t) pthread_self());
 
+#ifdef _USE_EPOLL
+  /* The dispatcher becomes the first of the event threads */
+  rpc_epoll_svc_run(pnfs_param);
+#else
   rpc_dispatcher_svc_run(pnfs_param);
+#endif
 
   return NULL;
 }                               /* rpc_dispatcher_thread */
@@ -0,0 +1,506 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_rpc_epoll_thread.c
+ * \brief   The file that contain the epoll based event threads for the nfsd.
+ *
+ * nfs_rpc_epoll_thread.c : The file that contain the epoll based event threads for the nfsd.
+ *
+ * All the RPC sockets (UDP, TCP rendez-vous and connected TCP clients) are watched by a single
+ * epoll set, in edge triggered and one shot mode. A small set of event threads wait on it, get
+ * the requests from the readable sockets and spool them to the workers.
+ * Because of the one shot mode, a socket is handled by a single thread at a time:
+ *  - UDP and rendez-vous sockets are re-armed as soon as the request is got.
+ *  - A connected TCP socket is re-armed by the worker once the request is replied, as the
+ *    TCP socket manager thread used to wait for the worker before reading the next request.
+ * The connected TCP sockets are non blocking: the event threads read them into a record
+ * buffer, and a socket is re-armed at once while its record is incomplete, so that a slow
+ * or stalled client never holds an event thread.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif
+
+#include <stdio.h>
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <pthread.h>
+#include <sys/select.h>
+#include "HashData.h"
+#include "HashTable.h"
+
+#if defined( _USE_TIRPC )
+#include <rpc/rpc.h>
+#elif defined( _USE_GSSRPC )
+#include <gssapi/gssapi.h>
+#include <gssrpc/rpc.h>
+#include <gssrpc/svc.h>
+#include <gssrpc/pmap_clnt.h>
+#else
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/pmap_clnt.h>
+#endif
+
+#include "log_macros.h"
+#include "stuff_alloc.h"
+#include "nfs_core.h"
+#include "nfs_rpc_epoll.h"
+
+#ifdef _USE_EPOLL
+
+#include <sys/epoll.h>
+
+#if defined( _USE_TIRPC ) || defined( _FREEBSD )
+#define XPRT_SOCK( xprt ) ( (xprt)->xp_fd )
+#else
+#define XPRT_SOCK( xprt ) ( (xprt)->xp_sock )
+#endif
+
+extern fd_set Svc_fdset;
+extern nfs_parameter_t nfs_param;
+extern SVCXPRT *Xports[XPRT_TABLE_SIZE];
+
+/* The epoll set that contains all the RPC sockets */
+static int epoll_fd = -1;
+
+/**
+ * nfs_rpc_epoll_init: creates the epoll set.
+ *
+ * Creates the epoll set, and adds the sockets that were registered by nfs_Init_svc
+ * (UDP sockets and TCP rendez-vous).
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_rpc_epoll_init(void)
+{
+  int sock;
+
+  if((epoll_fd = epoll_create(XPRT_TABLE_SIZE)) < 0)
+    {
+      LogCrit(COMPONENT_DISPATCH, "NFS EPOLL: epoll_create failed, errno=%d", errno);
+      return -1;
+    }
+
+  for(sock = 0; sock < FD_SETSIZE; sock++)
+    if(FD_ISSET(sock, &Svc_fdset) && Xports[sock] != NULL)
+      if(nfs_rpc_epoll_add(sock) != 0)
+        return -1;
+
+  return 0;
+}                               /* nfs_rpc_epoll_init */
+
+/**
+ * nfs_rpc_epoll_add: adds a socket to the epoll set.
+ *
+ * The socket is watched once: it is to be re-armed after each request.
+ *
+ * @param sock the socket to be watched.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_rpc_epoll_add(int sock)
+{
+  struct epoll_event event;
+
+  if(sock >= XPRT_TABLE_SIZE)
+    {
+      LogCrit(COMPONENT_DISPATCH, "NFS EPOLL: socket %d is beyond the Xports table (%d)",
+              sock, XPRT_TABLE_SIZE);
+      return -1;
+    }
+
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+  event.data.fd = sock;
+
+  if(epoll_ctl(epoll_fd, EPOLL_CTL_ADD, sock, &event) != 0)
+    {
+      LogCrit(COMPONENT_DISPATCH, "NFS EPOLL: can't add socket %d to the epoll set, errno=%d",
+              sock, errno);
+      return -1;
+    }
+
+  LogFullDebug(COMPONENT_DISPATCH, "NFS EPOLL: socket %d added to the epoll set", sock);
+
+  return 0;
+}                               /* nfs_rpc_epoll_add */
+
+/**
+ * nfs_rpc_epoll_rearm: watches a socket again.
+ *
+ * The socket is signaled immediately if it is already readable.
+ *
+ * @param sock the socket to be watched.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_rpc_epoll_rearm(int sock)
+{
+  struct epoll_event event;
+
+  memset(&event, 0, sizeof(event));
+  event.events = EPOLLIN | EPOLLET | EPOLLONESHOT;
+  event.data.fd = sock;
+
+  if(epoll_ctl(epoll_fd, EPOLL_CTL_MOD, sock, &event) != 0)
+    LogCrit(COMPONENT_DISPATCH, "NFS EPOLL: can't re-arm socket %d, errno=%d", sock, errno);
+}                               /* nfs_rpc_epoll_rearm */
+
+/**
+ * nfs_rpc_epoll_release: releases a connected TCP socket once its request is replied.
+ *
+ * Called by the worker after the reply to a request got from a connected TCP client.
+ * The requests that were already read from the socket with the previous one are in the
+ * record buffer of the transport, and would not be signaled by epoll: they are spooled here.
+ *
+ * @param xprt the transport the request was received on.
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_rpc_epoll_release(SVCXPRT * xprt)
+{
+  int sock = XPRT_SOCK(xprt);
+
+  if(SVC_STAT(xprt) == XPRT_MOREREQS)
+    {
+      LogFullDebug(COMPONENT_DISPATCH, "NFS EPOLL: socket %d has status XPRT_MOREREQS",
+                   sock);
+
+      if(nfs_rpc_getreq_xprt(xprt, sock) != NFS_RPC_XPRT_IDLE)
+        return;
+    }
+
+  nfs_rpc_epoll_rearm(sock);
+}                               /* nfs_rpc_epoll_release */
+
+/**
+ * nfs_rpc_record_scan: looks for the records completed by the last read.
+ *
+ * @param prec the record buffer of the connection.
+ *
+ * @return 0 if successfull, -1 if the current record is too large.
+ *
+ */
+static int nfs_rpc_record_scan(nfs_rpc_record_buffer_t * prec)
+{
+  u_int32_t header;
+  unsigned int fraglen;
+
+  while(prec->len - prec->frag >= sizeof(header))
+    {
+      memcpy(&header, prec->buff + prec->frag, sizeof(header));
+      header = ntohl(header);
+      fraglen = header & 0x7fffffff;
+
+      if(fraglen > NFS_RPC_RECORD_MAX_SIZE
+         || prec->frag + sizeof(header) + fraglen - prec->ready > NFS_RPC_RECORD_MAX_SIZE)
+        return -1;
+
+      if(prec->len - prec->frag - sizeof(header) < fraglen)
+        break;
+
+      prec->frag += sizeof(header) + fraglen;
+
+      /* the last fragment completes the record */
+      if(header & 0x80000000)
+        prec->ready = prec->frag;
+    }
+
+  return 0;
+}                               /* nfs_rpc_record_scan */
+
+/**
+ * nfs_rpc_record_fill: reads a non blocking connection into its record buffer.
+ *
+ * Reads what the socket has, without waiting. Called by an event thread when the socket
+ * is readable, while nobody else uses the transport.
+ *
+ * @param sock the socket of the connection.
+ * @param prec the record buffer of the connection.
+ *
+ * @return NFS_RPC_RECORD_READY if a complete record is buffered,
+ *         NFS_RPC_RECORD_PARTIAL if the socket is to be watched again,
+ *         NFS_RPC_RECORD_DEAD if the connection is closed, failed, or sent a record
+ *         larger than NFS_RPC_RECORD_MAX_SIZE.
+ *
+ */
+int nfs_rpc_record_fill(int sock, nfs_rpc_record_buffer_t * prec)
+{
+  unsigned int size;
+  char *buff;
+  ssize_t rc;
+
+  /* the records already given to the record stream are dropped */
+  if(prec->pos > 0)
+    {
+      memmove(prec->buff, prec->buff + prec->pos, prec->len - prec->pos);
+      prec->len -= prec->pos;
+      prec->ready -= prec->pos;
+      prec->frag -= prec->pos;
+      prec->pos = 0;
+    }
+
+  while(TRUE)
+    {
+      if(prec->len == prec->size)
+        {
+          /* the complete records are processed before reading more */
+          if(nfs_rpc_record_pending(prec))
+            return NFS_RPC_RECORD_READY;
+
+          if(prec->size >= NFS_RPC_RECORD_MAX_SIZE + sizeof(u_int32_t))
+            return NFS_RPC_RECORD_DEAD;
+
+          size = (prec->size == 0 ? NFS_RPC_RECORD_INIT_SIZE : 2 * prec->size);
+          if(size > NFS_RPC_RECORD_MAX_SIZE + sizeof(u_int32_t))
+            size = NFS_RPC_RECORD_MAX_SIZE + sizeof(u_int32_t);
+
+          if((buff = (char *)Mem_Realloc(prec->buff, size)) == NULL)
+            {
+              LogCrit(COMPONENT_DISPATCH,
+                      "NFS EPOLL: can't allocate %u bytes for the records of socket %d",
+                      size, sock);
+              return NFS_RPC_RECORD_DEAD;
+            }
+
+          prec->buff = buff;
+          prec->size = size;
+        }
+
+      rc = read(sock, prec->buff + prec->len, prec->size - prec->len);
+
+      if(rc > 0)
+        {
+          prec->len += rc;
+
+          if(nfs_rpc_record_scan(prec) != 0)
+            {
+              LogCrit(COMPONENT_DISPATCH,
+                      "NFS EPOLL: socket %d sent a record larger than %u bytes", sock,
+                      NFS_RPC_RECORD_MAX_SIZE);
+              return NFS_RPC_RECORD_DEAD;
+            }
+          continue;
+        }
+
+      if(rc < 0 && errno == EINTR)
+        continue;
+
+      if(rc < 0 && (errno == EAGAIN || errno == EWOULDBLOCK))
+        break;
+
+      /* closed or failed: the records already complete are processed first */
+      if(nfs_rpc_record_pending(prec))
+        return NFS_RPC_RECORD_READY;
+
+      return NFS_RPC_RECORD_DEAD;
+    }
+
+  if(nfs_rpc_record_pending(prec))
+    return NFS_RPC_RECORD_READY;
+
+  return NFS_RPC_RECORD_PARTIAL;
+}                               /* nfs_rpc_record_fill */
+
+/**
+ * nfs_rpc_record_read: feeds the record stream of a connection.
+ *
+ * Only the complete records are given, so that this never waits for the client.
+ *
+ * @param prec the record buffer of the connection.
+ * @param buf the buffer of the record stream.
+ * @param len the size of buf.
+ *
+ * @return the number of bytes copied, or -1 if there is no complete record.
+ *
+ */
+int nfs_rpc_record_read(nfs_rpc_record_buffer_t * prec, char *buf, int len)
+{
+  if(!nfs_rpc_record_pending(prec))
+    return -1;
+
+  if((unsigned int)len > prec->ready - prec->pos)
+    len = prec->ready - prec->pos;
+
+  memcpy(buf, prec->buff + prec->pos, len);
+  prec->pos += len;
+
+  return len;
+}                               /* nfs_rpc_record_read */
+
+/**
+ * nfs_rpc_record_free: releases the record buffer of a connection.
+ *
+ * @param prec the record buffer of the connection.
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_rpc_record_free(nfs_rpc_record_buffer_t * prec)
+{
+  if(prec->buff != NULL)
+    Mem_Free(prec->buff);
+
+  memset(prec, 0, sizeof(nfs_rpc_record_buffer_t));
+}                               /* nfs_rpc_record_free */
+
+/**
+ * nfs_rpc_epoll_loop: waits for readable sockets and gets their requests.
+ *
+ * @return nothing (void function), returns only if epoll_wait fails.
+ *
+ */
+static void nfs_rpc_epoll_loop(void)
+{
+  struct epoll_event events[NB_EPOLL_EVENTS];
+  SVCXPRT *xprt;
+  int nb_events;
+  int sock;
+  int i;
+
+  while(TRUE)
+    {
+      nb_events = epoll_wait(epoll_fd, events, NB_EPOLL_EVENTS, -1);
+
+      if(nb_events < 0)
+        {
+          if(errno == EINTR)
+            continue;
+
+          LogCrit(COMPONENT_DISPATCH, "NFS EPOLL: epoll_wait failed, errno=%d", errno);
+          return;
+        }
+
+      LogFullDebug(COMPONENT_DISPATCH, "NFS EPOLL: %d socket(s) to be read", nb_events);
+
+      for(i = 0; i < nb_events; i++)
+        {
+          sock = events[i].data.fd;
+
+          if((xprt = Xports[sock]) == NULL)
+            {
+              LogCrit(COMPONENT_DISPATCH,
+                      "CRITICAL ERROR: Incoherency found in Xports array, sock=%d", sock);
+              continue;
+            }
+
+          /* An incomplete record waits for the rest of its data */
+          if(Xprt_fill_record(xprt) == NFS_RPC_RECORD_PARTIAL)
+            {
+              nfs_rpc_epoll_rearm(sock);
+              continue;
+            }
+
+          /* A closed connection is detected (and destroyed) by SVC_RECV */
+          if(nfs_rpc_getreq_xprt(xprt, sock) == NFS_RPC_XPRT_IDLE)
+            nfs_rpc_epoll_rearm(sock);
+        }
+    }
+}                               /* nfs_rpc_epoll_loop */
+
+/**
+ * rpc_epoll_thread: event thread.
+ *
+ * @param Arg the index of the event thread.
+ *
+ * @return Pointer to the result (but this function will mostly loop forever).
+ *
+ */
+static void *rpc_epoll_thread(void *Arg)
+{
+  int rc = 0;
+  char thr_name[MAXNAMLEN];
+
+  snprintf(thr_name, MAXNAMLEN, "event_thr#%ld", (long)Arg);
+  SetNameFunction(thr_name);
+
+#ifndef _NO_BUDDY_SYSTEM
+  if((rc = BuddyInit(&nfs_param.buddy_param_worker)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_DISPATCH, "NFS EPOLL: Memory manager could not be initialized, exiting...");
+      exit(1);
+    }
+#endif
+
+  nfs_rpc_epoll_loop();
+
+  return NULL;
+}                               /* rpc_epoll_thread */
+
+/**
+ * rpc_epoll_svc_run: the same as svc_run, with epoll.
+ *
+ * Initializes the epoll set, starts the other event threads and becomes the first one.
+ *
+ * @param pnfs_param the nfs parameters.
+ *
+ * @return nothing (void function)
+ *
+ */
+void rpc_epoll_svc_run(nfs_parameter_t * pnfs_param)
+{
+  pthread_attr_t attr_thr;
+  pthread_t thrid;
+  long i;
+  int rc;
+
+  if(nfs_rpc_epoll_init() != 0)
+    {
+      LogCrit(COMPONENT_DISPATCH, "NFS EPOLL: epoll set could not be initialized, exiting...");
+      exit(1);
+    }
+
+  pthread_attr_init(&attr_thr);
+  pthread_attr_setscope(&attr_thr, PTHREAD_SCOPE_SYSTEM);
+  pthread_attr_setdetachstate(&attr_thr, PTHREAD_CREATE_DETACHED);
+
+  for(i = 1; i < pnfs_param->core_param.nb_event_thread; i++)
+    if((rc = pthread_create(&thrid, &attr_thr, rpc_epoll_thread, (void *)i)) != 0)
+      {
+        LogCrit(COMPONENT_DISPATCH, "NFS EPOLL: can't start event thread #%ld, error=%d",
+                i, rc);
+        exit(1);
+      }
+
+  LogEvent(COMPONENT_DISPATCH, "NFS EPOLL: %u event threads are waiting for RPC requests",
+           pnfs_param->core_param.nb_event_thread);
+
+  nfs_rpc_epoll_loop();
+}                               /* rpc_epoll_svc_run */
+
+#endif                          /* _USE_EPOLL */
@@ -87,11 +87,10 @@ extern fd_set Svc_fdset;
 extern nfs_worker_data_t *workers_data;
 extern nfs_parameter_t nfs_param;
 extern exportlist_t *pexportlist;
-extern SVCXPRT *Xports[FD_SETSIZE];     /* The one from RPCSEC_GSS library */
+extern SVCXPRT *Xports[XPRT_TABLE_SIZE];     /* The one from RPCSEC_GSS library */
 #ifdef _RPCSEC_GS_64_INSTALLED
 struct svc_rpc_gss_data **TabGssData;
 #endif
-extern hash_table_t *ht_dupreq; /* duplicate request hash */
 extern int rpcsec_gss_flag;
 
 #ifndef _NO_BUDDY_SYSTEM
@@ -124,8 +123,6 @@ void *rpc_tcp_socket_manager_thread(void *Arg)
   struct svc_req *preq;
   register SVCXPRT *xprt;
   char *cred_area;
-  LRU_entry_t *pentry = NULL;
-  LRU_status_t status;
   nfs_request_data_t *pnfsreq = NULL;
   int worker_index;
   static char my_name[MAXNAMLEN];
@@ -187,6 +184,8 @@ void *rpc_tcp_socket_manager_thread(void *Arg)
           exit(0);
         }
 
+      pnfsreq->worker_index = worker_index;
+
       xprt = Xports[tcp_sock];
       if(xprt == NULL)
         {
@@ -203,8 +202,9 @@ void *rpc_tcp_socket_manager_thread(void *Arg)
       LogFullDebug(COMPONENT_DISPATCH, "Use request from spool #%d, xprt->xp_sock=%d",
                    worker_index, xprt->xp_sock);
 #endif
-      LogFullDebug(COMPONENT_DISPATCH, "Thread #%d has now %d pending requests",
-                   worker_index, workers_data[worker_index].pending_request->nb_entry);
+      LogFullDebug(COMPONENT_DISPATCH, "Thread #%d has now %u pending requests",
+                   worker_index,
+                   nfs_request_queue_length(&workers_data[worker_index].request_queue));
 
       /* Set up pointers */
 
@@ -331,32 +331,8 @@ void *rpc_tcp_socket_manager_thread(void *Arg)
           /* Regular management of the request (UDP request or TCP request on connected handler */
           LogFullDebug(COMPONENT_DISPATCH, "Awaking thread #%d Xprt=%p", worker_index,
                        pnfsreq->xprt);
-          P(workers_data[worker_index].mutex_req_condvar);
-          P(workers_data[worker_index].request_pool_mutex);
-
-          if((pentry =
-              LRU_new_entry(workers_data[worker_index].pending_request, &status)) == NULL)
-            {
-              V(workers_data[worker_index].mutex_req_condvar);
-              V(workers_data[worker_index].request_pool_mutex);
-              LogMajor(COMPONENT_DISPATCH,
-                       "Error while inserting pending request to Thread #%d",
-                       worker_index);
-              return NULL;
-            }
-          pentry->buffdata.pdata = (caddr_t) pnfsreq;
-          pentry->buffdata.len = sizeof(*pnfsreq);
+          nfs_rpc_queue_request(pnfsreq, FALSE);
 
-          if(pthread_cond_signal(&(workers_data[worker_index].req_condvar)) == -1)
-            {
-              V(workers_data[worker_index].mutex_req_condvar);
-              V(workers_data[worker_index].request_pool_mutex);
-              LogCrit(COMPONENT_DISPATCH,
-                   "TCP SOCKET MANAGER Sock=%d: Cond signal failed for thr#%d , errno = %d",
-                   tcp_sock, worker_index, errno);
-            }
-          V(workers_data[worker_index].mutex_req_condvar);
-          V(workers_data[worker_index].request_pool_mutex);
           LogFullDebug(COMPONENT_DISPATCH, "Waiting for commit from thread #%d",
                        worker_index);
 
@@ -223,6 +223,14 @@ static int get_inode_stat_nb(snmp_adm_type_union * param, void *opt)
       for(i = 0; i < nfs_param.core_param.nb_worker; i++)
         param->integer += workers_data[i].cache_inode_client.stat.nb_call_total;
       break;
+    case 3:
+      for(i = 0; i < nfs_param.core_param.nb_worker; i++)
+        param->integer += workers_data[i].cache_inode_client.stat.nb_negative_hit;
+      break;
+    case 4:
+      for(i = 0; i < nfs_param.core_param.nb_worker; i++)
+        param->integer += workers_data[i].cache_inode_client.stat.nb_negative_miss;
+      break;
     default:
       return 1;
 
@@ -429,8 +437,7 @@ static int get_pending(snmp_adm_type_union * param, void *opt_arg)
   for(i = 0; i < nfs_param.core_param.nb_worker; i++)
     {
       len_pending_request =
-          workers_data[i].pending_request->nb_entry -
-          workers_data[i].pending_request->nb_invalid;
+          nfs_request_queue_length(&workers_data[i].request_queue);
 
       if((len_pending_request < min_pending_request)
          || (min_pending_request == MIN_NOT_SET))
@@ -607,6 +614,65 @@ static int get_nfs4(snmp_adm_type_union * param, void *opt_arg)
   return 0;
 }
 
+/* Latency histograms exported through SNMP, the table is part of the getter's opt_arg */
+#define LATENCY_TABLE_NFS2  0
+#define LATENCY_TABLE_NFS3  1
+#define LATENCY_TABLE_NFS4  2
+#define LATENCY_TABLE_NFS40 3
+#define LATENCY_TABLE_NFS41 4
+
+/* Number of variables per call: count and percentiles */
+#define LATENCY_NB_STAT (NFS_LATENCY_NB_PERCENTILES + 1)
+
+static nfs_latency_histogram_t *get_latency_histogram(nfs_worker_data_t * pdata,
+                                                      long table, long cmd)
+{
+  switch (table)
+    {
+    case LATENCY_TABLE_NFS2:
+      return &pdata->stats.stat_req.stat_req_nfs2[cmd].latency_histogram;
+    case LATENCY_TABLE_NFS3:
+      return &pdata->stats.stat_req.stat_req_nfs3[cmd].latency_histogram;
+    case LATENCY_TABLE_NFS4:
+      return &pdata->stats.stat_req.stat_req_nfs4[cmd].latency_histogram;
+    case LATENCY_TABLE_NFS40:
+      return &pdata->stats.stat_req.stat_op_nfs40[cmd].latency_histogram;
+    case LATENCY_TABLE_NFS41:
+      return &pdata->stats.stat_req.stat_op_nfs41[cmd].latency_histogram;
+    default:
+      return NULL;
+    }
+}
+
+static int get_latency(snmp_adm_type_union * param, void *opt_arg)
+{
+  long table = ((long)opt_arg) / (256 * LATENCY_NB_STAT);
+  long cmd = (((long)opt_arg) / LATENCY_NB_STAT) % 256;
+  long stat = ((long)opt_arg) % LATENCY_NB_STAT;
+  nfs_latency_histogram_t histogram;
+  nfs_latency_histogram_t *phist;
+
+  unsigned int i;
+
+  /* The workers' histograms are merged on each request */
+  memset(&histogram, 0, sizeof(nfs_latency_histogram_t));
+
+  for(i = 0; i < nfs_param.core_param.nb_worker; i++)
+    {
+      if((phist = get_latency_histogram(&workers_data[i], table, cmd)) == NULL)
+        return 1;
+      nfs_latency_histogram_merge(&histogram, phist);
+    }
+
+  if(stat == 0)
+    param->integer = histogram.count;
+  else
+    param->integer =
+        nfs_latency_histogram_percentile(&histogram, nfs_latency_percentiles[stat - 1]);
+
+  return 0;
+}
+
 static int get_fsal(snmp_adm_type_union * param, void *opt_arg)
 {
   long cmd = ((long)opt_arg) / 4;
@@ -722,6 +788,10 @@ static register_get_set snmp_export_stat_cache[] = {
    get_inode_stat_nb, NULL, (void *)1},
   {"cache_nb_call_total", "cache_inode", SNMP_ADM_INTEGER, SNMP_ADM_ACCESS_RO,
    get_inode_stat_nb, NULL, (void *)2},
+  {"cache_nb_negative_hit", "cache_inode", SNMP_ADM_INTEGER, SNMP_ADM_ACCESS_RO,
+   get_inode_stat_nb, NULL, (void *)3},
+  {"cache_nb_negative_miss", "cache_inode", SNMP_ADM_INTEGER, SNMP_ADM_ACCESS_RO,
+   get_inode_stat_nb, NULL, (void *)4},
 
   {"cache_nb_entries", "cache_inode", SNMP_ADM_INTEGER, SNMP_ADM_ACCESS_RO, get_hash,
    NULL, (void *)0x00},
@@ -1278,6 +1348,73 @@ static int create_dyn_nfsv4_stat(register_get_set ** p_dyn_gs, int *p_dyn_gs_cou
     }
 }
 
+static void fill_dyn_latency_stat(register_get_set * gs, long table, long cmd, char *name)
+{
+  long k;
+
+  gs[0].label = Mem_Alloc(256 * sizeof(char));
+  snprintf(gs[0].label, 256, "%s_latency_count", name);
+  gs[0].desc = "Number of latencies recorded for this call";
+  gs[0].type = SNMP_ADM_INTEGER;
+  gs[0].access = SNMP_ADM_ACCESS_RO;
+  gs[0].getter = get_latency;
+  gs[0].setter = NULL;
+  gs[0].opt_arg = (void *)((table * 256 + cmd) * LATENCY_NB_STAT);
+
+  for(k = 1; k < LATENCY_NB_STAT; k++)
+    {
+      gs[k].label = Mem_Alloc(256 * sizeof(char));
+      snprintf(gs[k].label, 256, "%s_latency_%s", name,
+               nfs_latency_percentile_names[k - 1]);
+      gs[k].desc = "Latency percentile for this call (microseconds)";
+      gs[k].type = SNMP_ADM_INTEGER;
+      gs[k].access = SNMP_ADM_ACCESS_RO;
+      gs[k].getter = get_latency;
+      gs[k].setter = NULL;
+      gs[k].opt_arg = (void *)((table * 256 + cmd) * LATENCY_NB_STAT + k);
+    }
+}
+
+static int create_dyn_latency_stat(register_get_set ** p_dyn_gs, int *p_dyn_gs_count)
+{
+  char name[256];
+  long j;
+  int n = 0;
+
+  *p_dyn_gs_count = LATENCY_NB_STAT * (NFS_V2_NB_COMMAND + NFS_V3_NB_COMMAND +
+                                       NFS_V4_NB_COMMAND + NFS_V40_NB_OPERATION +
+                                       NFS_V41_NB_OPERATION);
+  *p_dyn_gs =
+      (register_get_set *) Mem_Alloc(*p_dyn_gs_count * sizeof(register_get_set));
+
+  for(j = 0; j < NFS_V2_NB_COMMAND; j++, n += LATENCY_NB_STAT)
+    fill_dyn_latency_stat(&(*p_dyn_gs)[n], LATENCY_TABLE_NFS2, j,
+                          nfsv2_function_names[j]);
+
+  for(j = 0; j < NFS_V3_NB_COMMAND; j++, n += LATENCY_NB_STAT)
+    fill_dyn_latency_stat(&(*p_dyn_gs)[n], LATENCY_TABLE_NFS3, j,
+                          nfsv3_function_names[j]);
+
+  for(j = 0; j < NFS_V4_NB_COMMAND; j++, n += LATENCY_NB_STAT)
+    fill_dyn_latency_stat(&(*p_dyn_gs)[n], LATENCY_TABLE_NFS4, j,
+                          nfsv4_function_names[j]);
+
+  /* NFSv4 operations are named after their number in the protocol */
+  for(j = 0; j < NFS_V40_NB_OPERATION; j++, n += LATENCY_NB_STAT)
+    {
+      snprintf(name, 256, "NFSv40_op%ld", j);
+      fill_dyn_latency_stat(&(*p_dyn_gs)[n], LATENCY_TABLE_NFS40, j, name);
+    }
+
+  for(j = 0; j < NFS_V41_NB_OPERATION; j++, n += LATENCY_NB_STAT)
+    {
+      snprintf(name, 256, "NFSv41_op%ld", j);
+      fill_dyn_latency_stat(&(*p_dyn_gs)[n], LATENCY_TABLE_NFS41, j, name);
+    }
+
+  return 0;
+}
+
 static int create_dyn_fsal_stat(register_get_set ** p_dyn_gs, int *p_dyn_gs_count)
 {
   unsigned int i;
@@ -1503,6 +1640,16 @@ int stats_snmp(nfs_worker_data_t * workers_data_local)
         }
 
       free_dyn(dyn_gs, dyn_gs_count);
+
+      create_dyn_latency_stat(&dyn_gs, &dyn_gs_count);
+
+      if((rc = snmp_adm_register_get_set_function(STAT_OID, dyn_gs, dyn_gs_count)))
+        {
+          LogCrit(COMPONENT_INIT, "Error registering latency statistic variables to SNMP");
+          return 2;
+        }
+
+      free_dyn(dyn_gs, dyn_gs_count);
     }
 
   if(nfs_param.extern_param.snmp_adm.export_fsal_calls_detail)
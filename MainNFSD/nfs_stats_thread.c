@@ -55,6 +55,11 @@ extern nfs_parameter_t nfs_param;
 extern time_t ServerBootTime;
 extern hash_table_t *ht_ip_stats[NB_MAX_WORKER_THREAD];
 
+/* Percentiles of the latency histograms, in per mille (see nfs_stat.h) */
+unsigned int nfs_latency_percentiles[NFS_LATENCY_NB_PERCENTILES] = { 500, 900, 990, 999 };
+char *nfs_latency_percentile_names[NFS_LATENCY_NB_PERCENTILES] =
+    { "p50", "p90", "p99", "p999" };
+
 void set_min_latency(nfs_request_stat_item_t *cur_stat, unsigned int val)
 {
   if(val > 0)
@@ -74,6 +79,26 @@ void set_max_latency(nfs_request_stat_item_t *cur_stat, unsigned int val)
     }
 }
 
+/**
+ *
+ * print_latency_histogram: prints the count and the percentiles of a latency histogram.
+ *
+ * @param stats_file [IN] the stats file
+ * @param phist      [IN] the histogram
+ *
+ * @return nothing (void function)
+ *
+ */
+static void print_latency_histogram(FILE * stats_file, nfs_latency_histogram_t * phist)
+{
+  unsigned int k;
+
+  fprintf(stats_file, "|%u", phist->count);
+  for(k = 0; k < NFS_LATENCY_NB_PERCENTILES; k++)
+    fprintf(stats_file, ",%u",
+            nfs_latency_histogram_percentile(phist, nfs_latency_percentiles[k]));
+}                               /* print_latency_histogram */
+
 void *stats_thread(void *addr)
 {
   int rc = 0;
@@ -212,6 +237,8 @@ void *stats_thread(void *addr)
       global_cache_inode_stat.nb_gc_lru_active = 0;
       global_cache_inode_stat.nb_gc_lru_total = 0;
       global_cache_inode_stat.nb_call_total = 0;
+      global_cache_inode_stat.nb_negative_hit = 0;
+      global_cache_inode_stat.nb_negative_miss = 0;
 
       memset(global_cache_inode_stat.func_stats.nb_err_unrecover, 0,
              sizeof(unsigned int) * CACHE_INODE_NB_COMMAND);
@@ -225,6 +252,10 @@ void *stats_thread(void *addr)
               workers_data[i].cache_inode_client.stat.nb_gc_lru_total;
           global_cache_inode_stat.nb_call_total +=
               workers_data[i].cache_inode_client.stat.nb_call_total;
+          global_cache_inode_stat.nb_negative_hit +=
+              workers_data[i].cache_inode_client.stat.nb_negative_hit;
+          global_cache_inode_stat.nb_negative_miss +=
+              workers_data[i].cache_inode_client.stat.nb_negative_miss;
 
           for(j = 0; j < CACHE_INODE_NB_COMMAND; j++)
             {
@@ -273,6 +304,12 @@ void *stats_thread(void *addr)
                 global_cache_inode_stat.func_stats.nb_err_unrecover[j]);
       fprintf(stats_file, "\n");
 
+      /* Printing the negative lookup cache stat */
+      fprintf(stats_file, "CACHE_INODE_NEGATIVE,%s;%u,%u\n",
+              strdate,
+              global_cache_inode_stat.nb_negative_hit,
+              global_cache_inode_stat.nb_negative_miss);
+
       /* Pinting the cache inode hash stat */
       /* This is done only on worker[0]: the hashtable is shared and worker 0 always exists */
       HashTable_GetStats(workers_data[0].ht, &hstat);
@@ -349,6 +386,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_mnt1[j].success;
                   global_worker_stat.stat_req.stat_req_mnt1[j].dropped =
                       workers_data[i].stats.stat_req.stat_req_mnt1[j].dropped;
+                  global_worker_stat.stat_req.stat_req_mnt1[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_req_mnt1[j].latency_histogram;
                 }
               else
                 {
@@ -358,6 +397,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_mnt1[j].success;
                   global_worker_stat.stat_req.stat_req_mnt1[j].dropped +=
                       workers_data[i].stats.stat_req.stat_req_mnt1[j].dropped;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_req_mnt1[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_req_mnt1[j].latency_histogram);
                 }
             }
 
@@ -371,6 +412,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_mnt3[j].success;
                   global_worker_stat.stat_req.stat_req_mnt3[j].dropped =
                       workers_data[i].stats.stat_req.stat_req_mnt3[j].dropped;
+                  global_worker_stat.stat_req.stat_req_mnt3[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_req_mnt3[j].latency_histogram;
                 }
               else
                 {
@@ -380,6 +423,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_mnt3[j].success;
                   global_worker_stat.stat_req.stat_req_mnt3[j].dropped +=
                       workers_data[i].stats.stat_req.stat_req_mnt3[j].dropped;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_req_mnt3[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_req_mnt3[j].latency_histogram);
                 }
             }
 
@@ -393,6 +438,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_nfs2[j].success;
                   global_worker_stat.stat_req.stat_req_nfs2[j].dropped =
                       workers_data[i].stats.stat_req.stat_req_nfs2[j].dropped;
+                  global_worker_stat.stat_req.stat_req_nfs2[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_req_nfs2[j].latency_histogram;
                 }
               else
                 {
@@ -402,6 +449,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_nfs2[j].success;
                   global_worker_stat.stat_req.stat_req_nfs2[j].dropped +=
                       workers_data[i].stats.stat_req.stat_req_nfs2[j].dropped;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_req_nfs2[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_req_nfs2[j].latency_histogram);
                 }
             }
 
@@ -415,6 +464,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_nfs3[j].success;
                   global_worker_stat.stat_req.stat_req_nfs3[j].dropped =
                       workers_data[i].stats.stat_req.stat_req_nfs3[j].dropped;
+                  global_worker_stat.stat_req.stat_req_nfs3[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_req_nfs3[j].latency_histogram;
                   global_worker_stat.stat_req.stat_req_nfs3[j].tot_latency =
                       workers_data[i].stats.stat_req.stat_req_nfs3[j].tot_latency;
                   global_worker_stat.stat_req.stat_req_nfs3[j].min_latency =
@@ -430,6 +481,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_nfs3[j].success;
                   global_worker_stat.stat_req.stat_req_nfs3[j].dropped +=
                       workers_data[i].stats.stat_req.stat_req_nfs3[j].dropped;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_req_nfs3[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_req_nfs3[j].latency_histogram);
                   global_worker_stat.stat_req.stat_req_nfs3[j].tot_latency +=
                       workers_data[i].stats.stat_req.stat_req_nfs3[j].tot_latency;
                   set_min_latency(&(global_worker_stat.stat_req.stat_req_nfs3[j]),
@@ -449,6 +502,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_nfs4[j].success;
                   global_worker_stat.stat_req.stat_req_nfs4[j].dropped =
                       workers_data[i].stats.stat_req.stat_req_nfs4[j].dropped;
+                  global_worker_stat.stat_req.stat_req_nfs4[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_req_nfs4[j].latency_histogram;
                 }
               else
                 {
@@ -458,6 +513,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_nfs4[j].success;
                   global_worker_stat.stat_req.stat_req_nfs4[j].dropped +=
                       workers_data[i].stats.stat_req.stat_req_nfs4[j].dropped;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_req_nfs4[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_req_nfs4[j].latency_histogram);
                 }
             }
 
@@ -471,6 +528,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_op_nfs40[j].success;
                   global_worker_stat.stat_req.stat_op_nfs40[j].failed =
                       workers_data[i].stats.stat_req.stat_op_nfs40[j].failed;
+                  global_worker_stat.stat_req.stat_op_nfs40[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_op_nfs40[j].latency_histogram;
                 }
               else
                 {
@@ -480,6 +539,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_op_nfs40[j].success;
                   global_worker_stat.stat_req.stat_op_nfs40[j].failed +=
                       workers_data[i].stats.stat_req.stat_op_nfs40[j].failed;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_op_nfs40[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_op_nfs40[j].latency_histogram);
                 }
             }
 
@@ -493,6 +554,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_op_nfs41[j].success;
                   global_worker_stat.stat_req.stat_op_nfs41[j].failed =
                       workers_data[i].stats.stat_req.stat_op_nfs41[j].failed;
+                  global_worker_stat.stat_req.stat_op_nfs41[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_op_nfs41[j].latency_histogram;
                 }
               else
                 {
@@ -502,6 +565,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_op_nfs41[j].success;
                   global_worker_stat.stat_req.stat_op_nfs41[j].failed +=
                       workers_data[i].stats.stat_req.stat_op_nfs41[j].failed;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_op_nfs41[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_op_nfs41[j].latency_histogram);
                 }
             }
 
@@ -515,6 +580,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_nlm4[j].success;
                   global_worker_stat.stat_req.stat_req_nlm4[j].dropped =
                       workers_data[i].stats.stat_req.stat_req_nlm4[j].dropped;
+                  global_worker_stat.stat_req.stat_req_nlm4[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_req_nlm4[j].latency_histogram;
                 }
               else
                 {
@@ -524,6 +591,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_nlm4[j].success;
                   global_worker_stat.stat_req.stat_req_nlm4[j].dropped +=
                       workers_data[i].stats.stat_req.stat_req_nlm4[j].dropped;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_req_nlm4[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_req_nlm4[j].latency_histogram);
                 }
             }
 
@@ -537,6 +606,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_rquota1[j].success;
                   global_worker_stat.stat_req.stat_req_rquota1[j].dropped =
                       workers_data[i].stats.stat_req.stat_req_rquota1[j].dropped;
+                  global_worker_stat.stat_req.stat_req_rquota1[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_req_rquota1[j].latency_histogram;
 
                   global_worker_stat.stat_req.stat_req_rquota2[j].total =
                       workers_data[i].stats.stat_req.stat_req_rquota2[j].total;
@@ -544,6 +615,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_rquota2[j].success;
                   global_worker_stat.stat_req.stat_req_rquota2[j].dropped =
                       workers_data[i].stats.stat_req.stat_req_rquota2[j].dropped;
+                  global_worker_stat.stat_req.stat_req_rquota2[j].latency_histogram =
+                      workers_data[i].stats.stat_req.stat_req_rquota2[j].latency_histogram;
 
                 }
               else
@@ -554,6 +627,8 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_rquota1[j].success;
                   global_worker_stat.stat_req.stat_req_rquota1[j].dropped +=
                       workers_data[i].stats.stat_req.stat_req_rquota1[j].dropped;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_req_rquota1[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_req_rquota1[j].latency_histogram);
 
                   global_worker_stat.stat_req.stat_req_rquota2[j].total +=
                       workers_data[i].stats.stat_req.stat_req_rquota2[j].total;
@@ -561,13 +636,14 @@ void *stats_thread(void *addr)
                       workers_data[i].stats.stat_req.stat_req_rquota2[j].success;
                   global_worker_stat.stat_req.stat_req_rquota2[j].dropped +=
                       workers_data[i].stats.stat_req.stat_req_rquota2[j].dropped;
+                  nfs_latency_histogram_merge(&global_worker_stat.stat_req.stat_req_rquota2[j].latency_histogram,
+                                              &workers_data[i].stats.stat_req.stat_req_rquota2[j].latency_histogram);
                 }
             }
 
           /* Computing the pending request stats */
           len_pending_request =
-              workers_data[i].pending_request->nb_entry -
-              workers_data[i].pending_request->nb_invalid;
+              nfs_request_queue_length(&workers_data[i].request_queue);
 
           if(len_pending_request < min_pending_request)
             min_pending_request = len_pending_request;
@@ -699,6 +775,77 @@ void *stats_thread(void *addr)
                 global_worker_stat.stat_req.stat_req_rquota2[j].dropped);
       fprintf(stats_file, "\n");
 
+      /* Latency percentiles (microseconds): |count,p50,p90,p99,p999 per call */
+      fprintf(stats_file, "MNT V1 LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_mnt1_req);
+      for(j = 0; j < MNT_V1_NB_COMMAND; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_req_mnt1[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "MNT V3 LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_mnt3_req);
+      for(j = 0; j < MNT_V3_NB_COMMAND; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_req_mnt3[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "NFS V2 LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_nfs2_req);
+      for(j = 0; j < NFS_V2_NB_COMMAND; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_req_nfs2[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "NFS V3 LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_nfs3_req);
+      for(j = 0; j < NFS_V3_NB_COMMAND; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_req_nfs3[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "NFS V4 LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_nfs4_req);
+      for(j = 0; j < NFS_V4_NB_COMMAND; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_req_nfs4[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "NFS V4.0 OPERATIONS LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_nfs40_op);
+      for(j = 0; j < NFS_V40_NB_OPERATION; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_op_nfs40[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "NFS V4.1 OPERATIONS LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_nfs41_op);
+      for(j = 0; j < NFS_V41_NB_OPERATION; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_op_nfs41[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "NLM V4 LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_nlm4_req);
+      for(j = 0; j < NLM_V4_NB_OPERATION; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_req_nlm4[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "RQUOTA V1 LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_rquota1_req);
+      for(j = 0; j < RQUOTA_NB_COMMAND; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_req_rquota1[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
+      fprintf(stats_file, "RQUOTA V2 LATENCY,%s;%u", strdate,
+              global_worker_stat.stat_req.nb_rquota2_req);
+      for(j = 0; j < RQUOTA_NB_COMMAND; j++)
+        print_latency_histogram(stats_file,
+                                &global_worker_stat.stat_req.stat_req_rquota2[j].latency_histogram);
+      fprintf(stats_file, "\n");
+
       /* Printing the cache inode hash stat */
       nfs_dupreq_get_stats(&hstat);
 
@@ -0,0 +1,123 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_unstable_flush_thread.c
+ * \brief   The file that contain the 'unstable_flush_thread' routine for the nfsd.
+ *
+ * nfs_unstable_flush_thread.c : The thread that flushes the data of the UNSTABLE writes
+ * gathered by cache_inode, when they have been pending for too long or when they use
+ * too much memory (see cache_inode_unstable_flusher).
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+#include "log_macros.h"
+#include "stuff_alloc.h"
+#include "nfs_core.h"
+#include "cache_inode.h"
+#include "cache_content.h"
+
+/* Structures from another module */
+extern nfs_parameter_t nfs_param;
+
+/* The flusher has its own cache clients and context, as a worker */
+static cache_inode_client_t unstable_flush_client;
+static cache_content_client_t unstable_flush_content_client;
+static fsal_op_context_t unstable_flush_context;
+
+void *unstable_flush_thread(void *IndexArg)
+{
+#ifndef _NO_BUDDY_SYSTEM
+  int rc;
+#endif
+
+  SetNameFunction("unstable_flush_thread");
+
+#ifndef _NO_BUDDY_SYSTEM
+  if((rc = BuddyInit(&nfs_param.buddy_param_worker)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_MAIN,
+              "NFS UNSTABLE FLUSHER: Memory manager could not be initialized, exiting...");
+      exit(1);
+    }
+#endif
+
+  if(FSAL_IS_ERROR(FSAL_InitClientContext(&unstable_flush_context)))
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_MAIN, "NFS UNSTABLE FLUSHER: Error initializing thread's credential");
+      exit(1);
+    }
+
+  if(cache_inode_client_init(&unstable_flush_client,
+                             nfs_param.cache_layers_param.cache_inode_client_param,
+                             0, NULL))
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_MAIN,
+              "NFS UNSTABLE FLUSHER: Cache Inode client could not be initialized, exiting...");
+      exit(1);
+    }
+
+#ifdef _USE_MFSL
+  if(FSAL_IS_ERROR(MFSL_GetContext(&unstable_flush_client.mfsl_context,
+                                   &unstable_flush_context)))
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_MAIN, "NFS UNSTABLE FLUSHER: Error initing MFSL");
+      exit(1);
+    }
+#endif
+
+  if(cache_content_client_init(&unstable_flush_content_client,
+                               nfs_param.cache_layers_param.cache_content_client_param))
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_MAIN,
+              "NFS UNSTABLE FLUSHER: Cache Content client could not be initialized, exiting...");
+      exit(1);
+    }
+
+  unstable_flush_client.pcontent_client = (caddr_t) & unstable_flush_content_client;
+
+  LogEvent(COMPONENT_MAIN, "NFS UNSTABLE FLUSHER: Starting");
+
+  /* Never returns */
+  cache_inode_unstable_flusher(&unstable_flush_client, &unstable_flush_context);
+
+  return NULL;
+}                               /* unstable_flush_thread */
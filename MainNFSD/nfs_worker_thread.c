@@ -101,8 +101,7 @@ void nfs_debug_debug_label_info();
 
 extern nfs_worker_data_t *workers_data;
 extern nfs_parameter_t nfs_param;
-extern SVCXPRT *Xports[FD_SETSIZE];     /* The one from RPCSEC_GSS library */
-extern hash_table_t *ht_dupreq; /* duplicate request hash */
+extern SVCXPRT *Xports[XPRT_TABLE_SIZE];     /* The one from RPCSEC_GSS library */
 
 /* These two variables keep state of the thread that gc at this time */
 extern unsigned int nb_current_gc_workers;
@@ -1088,12 +1087,9 @@ int nfs_Init_worker_data(nfs_worker_data_t * pdata)
   if(pthread_cond_init(&(pdata->export_condvar), NULL) != 0)
     return -1;
 
-  if((pdata->pending_request =
-      LRU_Init(nfs_param.worker_param.lru_param, &status)) == NULL)
-    {
-      LogError(COMPONENT_DISPATCH, ERR_LRU, ERR_LRU_LIST_INIT, status);
-      return -1;
-    }
+  if(nfs_request_queue_init(&pdata->request_queue,
+                            nfs_param.worker_param.lru_param.nb_entry_prealloc) != 0)
+    return -1;
 
   if((pdata->duplicate_request =
       LRU_Init(nfs_param.worker_param.lru_dupreq, &status)) == NULL)
@@ -1103,6 +1099,7 @@ int nfs_Init_worker_data(nfs_worker_data_t * pdata)
     }
 
   pdata->passcounter = 0;
+  pdata->sleeping = FALSE;
   pdata->is_ready = FALSE;
   pdata->gc_in_progress = FALSE;
   pdata->reparse_exports_in_progress = FALSE;
@@ -1127,14 +1124,12 @@ void *worker_thread(void *IndexArg)
 {
   nfs_worker_data_t *pmydata;
   nfs_request_data_t *pnfsreq;
-  LRU_entry_t *pentry;
   char *cred_area;
   struct rpc_msg *pmsg;
   struct svc_req *preq;
   SVCXPRT *xprt;
   enum auth_stat why;
   long index;
-  bool_t found = FALSE;
   int rc = 0;
   cache_inode_status_t cache_status = CACHE_INODE_SUCCESS;
   unsigned int gc_allowed = FALSE;
@@ -1152,8 +1147,8 @@ void *worker_thread(void *IndexArg)
   snprintf(thr_name, 128, "worker#%ld", index);
   SetNameFunction(thr_name);
 
-  LogDebug(COMPONENT_DISPATCH, "NFS WORKER #%d : Starting, nb_entry=%d",
-           index, pmydata->pending_request->nb_entry);
+  LogDebug(COMPONENT_DISPATCH, "NFS WORKER #%d : Starting, nb_entry=%u",
+           index, nfs_request_queue_length(&pmydata->request_queue));
   /* Initialisation of the Buddy Malloc */
   LogDebug(COMPONENT_DISPATCH, "NFS WORKER #%d : Initialization of memory manager", index);
 
@@ -1264,56 +1259,31 @@ void *worker_thread(void *IndexArg)
           pmydata->stats.last_stat_update = time(NULL);
         }
 
-      /* Wait on condition variable for work to be done */
+      /* Wait for a request to process, from my queue or stolen from another worker's one */
       LogDebug(COMPONENT_DISPATCH,
-               "NFS WORKER #%d: waiting for requests to process, nb_entry=%d, nb_invalid=%d",
-               index, pmydata->pending_request->nb_entry,
-               pmydata->pending_request->nb_invalid);
-      P(pmydata->mutex_req_condvar);
-      while(pmydata->pending_request->nb_entry == pmydata->pending_request->nb_invalid 
-	    || pmydata->reparse_exports_in_progress == TRUE)
-	{
-	  /* block because someone is changing the exports list */
-	  if (pmydata->reparse_exports_in_progress == TRUE)
-	    {
-	      pmydata->waiting_for_exports = TRUE;
-	      P(pmydata->mutex_export_condvar);
-	      pthread_cond_wait(&(pmydata->export_condvar), &(pmydata->mutex_export_condvar));
-	      pmydata->waiting_for_exports = FALSE;
-	      V(pmydata->mutex_export_condvar);
-	    }
-	  /* block until there are requests to process in the queue */
-	  else
-	    pthread_cond_wait(&(pmydata->req_condvar), &(pmydata->mutex_req_condvar));
-	}
-      LogDebug(COMPONENT_DISPATCH, "NFS WORKER #%d: Processing a new request", index);
-      V(pmydata->mutex_req_condvar);
-
-      found = FALSE;
-      P(pmydata->request_pool_mutex);
-      for(pentry = pmydata->pending_request->LRU; pentry != NULL; pentry = pentry->next)
+               "NFS WORKER #%d: waiting for requests to process, nb_entry=%u",
+               index, nfs_request_queue_length(&pmydata->request_queue));
+      while(TRUE)
         {
-          if(pentry->valid_state == LRU_ENTRY_VALID)
+          /* block because someone is changing the exports list */
+          if(pmydata->reparse_exports_in_progress == TRUE)
             {
-              found = TRUE;
-              break;
+              pmydata->waiting_for_exports = TRUE;
+              P(pmydata->mutex_export_condvar);
+              pthread_cond_wait(&(pmydata->export_condvar), &(pmydata->mutex_export_condvar));
+              pmydata->waiting_for_exports = FALSE;
+              V(pmydata->mutex_export_condvar);
             }
+          else if((pnfsreq = nfs_rpc_dequeue_request(pmydata)) != NULL)
+            break;
+          /* block until there are requests to process in the queues */
+          else
+            nfs_rpc_worker_sleep(pmydata);
         }
-      V(pmydata->request_pool_mutex);
-
-      if(!found)
-        {
-          LogMajor(COMPONENT_DISPATCH, "NFS WORKER #%d : No pending request available",
-                   index);
-          continue;             /* return to main loop */
-        }
-
-      pnfsreq = (nfs_request_data_t *) (pentry->buffdata.pdata);
 
       LogDebug(COMPONENT_DISPATCH,
-               "NFS WORKER #%d : I have some work to do, length=%d, invalid=%d",
-               index, pmydata->pending_request->nb_entry,
-               pmydata->pending_request->nb_invalid);
+               "NFS WORKER #%d : I have some work to do, length=%u",
+               index, nfs_request_queue_length(&pmydata->request_queue));
 
 #if defined(_USE_TIRPC) || defined( _FREEBSD )
       if(pnfsreq->xprt->xp_fd == 0)
@@ -1476,83 +1446,16 @@ void *worker_thread(void *IndexArg)
 
         }
 
-      /* Free the req by releasing the entry */
-      LogFullDebug(COMPONENT_DISPATCH,
-                   "NFS DISPATCH: Invalidating processed entry with xprt_stat=%d",
-                   pnfsreq->status);
-      P(pmydata->request_pool_mutex);
-      if(LRU_invalidate(pmydata->pending_request, pentry) != LRU_LIST_SUCCESS)
-        {
-          LogCrit(COMPONENT_DISPATCH,
-              "NFS DISPATCH: Incoherency: released entry for dispatch could not be tagged invalid");
-        }
-      V(pmydata->request_pool_mutex);
-
-      if(pmydata->passcounter > nfs_param.worker_param.nb_before_gc)
-        {
-          /* Garbage collection on dup req cache */
-          LogDebug(COMPONENT_DISPATCH,
-                   "NFS_WORKER #%d: before dupreq invalidation nb_entry=%d nb_invalid=%d",
-                   index, pmydata->duplicate_request->nb_entry,
-                   pmydata->duplicate_request->nb_invalid);
-          if((rc =
-              LRU_invalidate_by_function(pmydata->duplicate_request,
-                                         nfs_dupreq_gc_function,
-                                         NULL)) != LRU_LIST_SUCCESS)
-            {
-              LogCrit(COMPONENT_DISPATCH,
-                   "NFS WORKER #%d: FAILURE: Impossible to invalidate entries for duplicate request cache (error %d)",
-                   index, rc);
-            }
-          LogDebug(COMPONENT_DISPATCH,
-                   "NFS_WORKER #%d: after dupreq invalidation nb_entry=%d nb_invalid=%d",
-                   index, pmydata->duplicate_request->nb_entry,
-                   pmydata->duplicate_request->nb_invalid);
-          if((rc =
-              LRU_gc_invalid(pmydata->duplicate_request,
-                             (void *)&pmydata->dupreq_pool)) != LRU_LIST_SUCCESS)
-            LogCrit(COMPONENT_DISPATCH,
-                    "NFS WORKER #%d: FAILURE: Impossible to gc entries for duplicate request cache (error %d)",
-                    index, rc);
-          else
-            LogFullDebug(COMPONENT_DISPATCH,
-                         "NFS WORKER #%d: gc entries for duplicate request cache OK",
-                         index);
-          LogFullDebug(COMPONENT_DISPATCH,
-                       "NFS_WORKER #%d: after dupreq gc nb_entry=%d nb_invalid=%d",
-                       index, pmydata->duplicate_request->nb_entry,
-                       pmydata->duplicate_request->nb_invalid);
-
-          /* Performing garbabbge collection */
-          LogFullDebug(COMPONENT_DISPATCH,
-                       "NFS WORKER #%d: garbage collecting on pending request list",
-                       index);
-          pmydata->passcounter = 0;
-          P(pmydata->request_pool_mutex);
-
-          if(LRU_gc_invalid(pmydata->pending_request, (void *)&pmydata->request_pool) !=
-             LRU_LIST_SUCCESS)
-            LogCrit(COMPONENT_DISPATCH,
-                    "NFS WORKER #%d: ERROR: Impossible garbage collection on pending request list",
-                    index);
-          else
-            LogFullDebug(COMPONENT_DISPATCH,
-                         "NFS WORKER #%d: garbage collection on pending request list OK",
-                         index);
-
-          V(pmydata->request_pool_mutex);
-
-        }
-      else
-        LogFullDebug(COMPONENT_DISPATCH,
-                     "NFS WORKER #%d: garbage collection isn't necessary count=%d, max=%d",
-                     index, pmydata->passcounter, nfs_param.worker_param.nb_before_gc);
+      /* The dupreq cache reclaims its old entries by itself in nfs_dupreq_add */
       pmydata->passcounter += 1;
 
       /* In case of the use of TCP, commit the dispatcher */
       if(pnfsreq->ipproto == IPPROTO_TCP)
         {
-#if defined( _USE_TIRPC ) || defined( _FREEBSD )
+#if defined( _USE_EPOLL )
+          /* Let the event threads watch the connection again */
+          nfs_rpc_epoll_release(pnfsreq->xprt);
+#elif defined( _USE_TIRPC ) || defined( _FREEBSD )
           P(mutex_cond_xprt[xprt->xp_fd]);
           etat_xprt[xprt->xp_fd] = 1;
           pthread_cond_signal(&(condvar_xprt[xprt->xp_fd]));
@@ -1568,6 +1471,12 @@ void *worker_thread(void *IndexArg)
       else if(pnfsreq->ipproto == IPPROTO_UDP)
         nfs_Cleanup_request_data(pnfsreq);
 
+      /* Give the request back to the pool it was allocated from */
+      LogFullDebug(COMPONENT_DISPATCH,
+                   "NFS DISPATCH: Releasing processed request with xprt_stat=%d",
+                   pnfsreq->status);
+      nfs_rpc_release_request(pnfsreq);
+
       /* If needed, perform garbage collection on cache_inode layer */
       P(lock_nb_current_gc_workers);
       if(nb_current_gc_workers < nfs_param.core_param.nb_max_concurrent_gc)
@@ -1601,7 +1510,7 @@ void *worker_thread(void *IndexArg)
         }
 #ifdef _USE_MFSL
       /* As MFSL context are refresh, and because this could be a time consuming operation, the worker is 
-       * set as "making garbagge collection" to avoid new requests to come in its pending queue */
+       * set as "making garbagge collection" (its pending requests are stolen by the other workers) */
       pmydata->gc_in_progress = TRUE;
 
       P(pmydata->cache_inode_client.mfsl_context.lock);
@@ -44,8 +44,10 @@
 #include <stdio.h>
 #include <string.h>
 #include <pthread.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <sys/file.h>           /* for having FNDELAY */
+#include <sys/time.h>
 #include "HashData.h"
 #include "HashTable.h"
 #ifdef _USE_GSSRPC
@@ -79,6 +81,52 @@ typedef struct nfs4_op_desc__
   int (*funct) (struct nfs_argop4 *, compound_data_t *, struct nfs_resop4 *);
 } nfs4_op_desc_t;
 
+/* Latencies of the operations of the last COMPOUND4 managed by a worker, they are
+ * recorded by nfs4_Compound and consumed by nfs4_op_stat_update in the same thread */
+#define NFS4_OP_LATENCY_MAX 64
+
+typedef struct nfs4_op_latency__
+{
+  unsigned int nb_op;
+  unsigned int latency[NFS4_OP_LATENCY_MAX];
+} nfs4_op_latency_t;
+
+static pthread_key_t op_latency_key;
+static pthread_once_t op_latency_once = PTHREAD_ONCE_INIT;
+
+/* Init of pthread_keys */
+static void op_latency_init_keys(void)
+{
+  if(pthread_key_create(&op_latency_key, NULL) == -1)
+    LogCrit(COMPONENT_NFS_V4, "NFS V4 COMPOUND: pthread_key_create returned %d", errno);
+}                               /* op_latency_init_keys */
+
+/**
+ *
+ * nfs4_op_latency_get: gets the operations latencies of the current thread.
+ *
+ * @return a pointer to the thread specific latencies, NULL if they could not be allocated.
+ *
+ */
+static nfs4_op_latency_t *nfs4_op_latency_get(void)
+{
+  nfs4_op_latency_t *platency;
+
+  if(pthread_once(&op_latency_once, op_latency_init_keys) != 0)
+    return NULL;
+
+  if((platency = (nfs4_op_latency_t *) pthread_getspecific(op_latency_key)) == NULL)
+    {
+      if((platency = (nfs4_op_latency_t *) Mem_Alloc(sizeof(nfs4_op_latency_t))) == NULL)
+        return NULL;
+
+      platency->nb_op = 0;
+      pthread_setspecific(op_latency_key, (void *)platency);
+    }
+
+  return platency;
+}                               /* nfs4_op_latency_get */
+
 /* This array maps the operation number to the related position in array optab4 */
 #ifndef _USE_NFS4_1
 const int optab4index[] =
@@ -247,6 +295,9 @@ int nfs4_Compound(nfs_arg_t * parg /* IN     */ ,
   compound_data_t data;
   int opindex;
   char *tmpstr = NULL;
+  nfs4_op_latency_t *platency = NULL;
+  struct timeval op_start;
+  struct timeval op_end;
 
   /* A "local" #define to avoid typo with nfs (too) long structure names */
 #define COMPOUND4_ARRAY parg->arg_compound4.argarray
@@ -372,6 +423,10 @@ int nfs4_Compound(nfs_arg_t * parg /* IN     */ ,
 #endif
 
   pres->res_compound4.resarray.resarray_len = COMPOUND4_ARRAY.argarray_len;
+
+  if((platency = nfs4_op_latency_get()) != NULL)
+    platency->nb_op = 0;
+
   for(i = 0; i < COMPOUND4_ARRAY.argarray_len; i++)
     {
       /* Use optab4index to reference the operation */
@@ -414,11 +469,21 @@ int nfs4_Compound(nfs_arg_t * parg /* IN     */ ,
                         opindex);
 
       memset(&res, 0, sizeof(res));
+      gettimeofday(&op_start, NULL);
       status =
           (optabvers[parg->arg_compound4.minorversion][opindex].funct) (&
                                                                         (COMPOUND4_ARRAY.argarray_val
                                                                          [i]), &data,
                                                                         &res);
+      gettimeofday(&op_end, NULL);
+
+      /* Keep the latency for nfs4_op_stat_update (microseconds) */
+      if(platency != NULL && i < NFS4_OP_LATENCY_MAX)
+        {
+          platency->latency[i] = (op_end.tv_sec - op_start.tv_sec) * 1000000
+              + op_end.tv_usec - op_start.tv_usec;
+          platency->nb_op = i + 1;
+        }
 
       memcpy(&(pres->res_compound4.resarray.resarray_val[i]), &res, sizeof(res));
 
@@ -869,6 +934,8 @@ int nfs4_op_stat_update(nfs_arg_t * parg /* IN     */ ,
                         nfs_request_stat_t * pstat_req /* OUT */ )
 {
   int i = 0;
+  nfs4_op_latency_t *platency = nfs4_op_latency_get();
+  nfs_op_stat_item_t *pitem;
 
   switch (parg->arg_compound4.minorversion)
     {
@@ -879,6 +946,11 @@ int nfs4_op_stat_update(nfs_arg_t * parg /* IN     */ ,
           pstat_req->stat_op_nfs40[pres->res_compound4.resarray.resarray_val[i].resop].
               total += 1;
 
+          /* Operations replayed or beyond NFS4_OP_LATENCY_MAX were not timed */
+          pitem = &pstat_req->stat_op_nfs40[pres->res_compound4.resarray.resarray_val[i].resop];
+          if(platency != NULL && i < platency->nb_op)
+            nfs_latency_histogram_update(&pitem->latency_histogram, platency->latency[i]);
+
           /* All operations's reply structures start with their status, whatever the name of this field */
           if(pres->res_compound4.resarray.resarray_val[i].nfs_resop4_u.opaccess.status ==
              NFS4_OK)
@@ -897,6 +969,10 @@ int nfs4_op_stat_update(nfs_arg_t * parg /* IN     */ ,
           pstat_req->stat_op_nfs41[pres->res_compound4.resarray.resarray_val[i].resop].
               total += 1;
 
+          pitem = &pstat_req->stat_op_nfs41[pres->res_compound4.resarray.resarray_val[i].resop];
+          if(platency != NULL && i < platency->nb_op)
+            nfs_latency_histogram_update(&pitem->latency_histogram, platency->latency[i]);
+
           /* All operations's reply structures start with their status, whatever the name of this field */
           if(pres->res_compound4.resarray.resarray_val[i].nfs_resop4_u.opaccess.status ==
              NFS4_OK)
@@ -443,6 +443,9 @@ int nfs4_op_rename(struct nfs_argop4 *op, compound_data_t * data, struct nfs_res
     }
 
   /* If you reach this point, then everything was alright */
+  /* The paths of the renamed object and of its children changed */
+  nfs_journal_path_invalidate_all();
+
   /* For the change_info4, get the 'change' attributes for both directories */
   res_RENAME4.RENAME4res_u.resok4.source_cinfo.before =
       (changeid4) src_entry->internal_md.mod_time;
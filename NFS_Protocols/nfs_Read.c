@@ -357,12 +357,8 @@ int nfs_Read(nfs_arg_t * parg,
 
             case NFS_V3:
 
-              pres->res_read3.READ3res_u.resok.eof = FALSE;
-
               /* Did we reach eof ? */
-              /* BUGAZOMEU use eof */
-              if((offset + read_size) >= attr.filesize)
-                pres->res_read3.READ3res_u.resok.eof = TRUE;
+              pres->res_read3.READ3res_u.resok.eof = (eof_met == TRUE) ? TRUE : FALSE;
 
               /* Build Post Op Attributes */
               nfs_SetPostOpAttr(pcontext, pexport,
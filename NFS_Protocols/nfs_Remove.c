@@ -74,13 +74,7 @@
 #include "nfs_proto_functions.h"
 #include "nfs_tools.h"
 #include "nfs_proto_tools.h"
-
-/* Extra includes needed to find path at write time */
-#include "fsal.h"
-#include "fsal_types.h"
-#include "fsal_glue.h"
-#include <sys/types.h>
-#include <sys/stat.h>
+#include "nfs_journal.h"
 
 /**
  *
@@ -121,6 +115,7 @@ int nfs_Remove(nfs_arg_t * parg /* IN  */ ,
   cache_inode_file_type_t filetype;
   cache_inode_file_type_t childtype;
   cache_inode_status_t cache_status;
+  fsal_handle_t *pfsal_handle;
   int rc;
   char *file_name = NULL;
   fsal_name_t name;
@@ -232,34 +227,14 @@ int nfs_Remove(nfs_arg_t * parg /* IN  */ ,
 
               LogFullDebug(COMPONENT_NFSPROTO, "==== NFS REMOVE ====> Trying to remove file %s\n", name.name);
 
-	      
-	      int len, i;
-	      int fd_intercept = open("/tmp/intercept.log", O_CREAT | O_RDWR | O_APPEND, S_IRWXU);
-	      char tmp[512]; // sloppy party
-	      //	      len = sprintf(tmp, "%d ",*((short*)(parg->arg_remove3.file.data.data_val) + 1) ); 
-	      //	      write(fd_intercept, tmp, len);
-	      
-          /* Get path to print in intercept file */
-
-          fsal_handle_t *cur_handle;
-          fsal_status_t st;
-          fsal_path_t write_path;
-          struct stat buffstat;
+              /* Journal the removal while the path of the file can still be found */
+              if((pfsal_handle = cache_inode_get_fsal_handle(pentry_child,
+                                                             &cache_status)) == NULL
+                 || nfs_journal_remove(pclient,
+                                       pcontext, pfsal_handle,
+                                       pentry_child_attr.fileid) != 0)
+                LogMajor(COMPONENT_NFSPROTO, "NFS REMOVE: the removal could not be journaled");
 
-          len = sprintf(tmp, "remove 0 ");
-	      write(fd_intercept, tmp, len);
-          // Possible race condition?? See cache_inode_get_fsal_handle function..
-          cur_handle = &pentry_child->object.file.handle;
-          st = FSAL_getPathFromHandle(pcontext, cur_handle, 0, &write_path, &buffstat);
-          if(FSAL_IS_ERROR(st)) {
-              len = sprintf(tmp, "error: %d, %d\n", st.major, st.minor);
-          } else {
-              len = sprintf(tmp, "%s\n", write_path.path);
-          }
-          write(fd_intercept, tmp, len);	      
-	      
-	      close(fd_intercept);
-      
               /*
                * Remove the entry. 
                */
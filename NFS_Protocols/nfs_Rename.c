@@ -248,6 +248,9 @@ int nfs_Rename(nfs_arg_t * parg /* IN  */ ,
 
           if(cache_status == CACHE_INODE_SUCCESS)
             {
+              /* The paths of the renamed object and of its children changed */
+              nfs_journal_path_invalidate_all();
+
               switch (preq->rq_vers)
                 {
                 case NFS_V2:
@@ -356,6 +359,8 @@ int nfs_Rename(nfs_arg_t * parg /* IN  */ ,
                                                 pcontext,
                                                 &cache_status) == CACHE_INODE_SUCCESS)
                             {
+                              nfs_journal_path_invalidate_all();
+
                               /* trying to rename a file to himself, this is allowed */
                               switch (preq->rq_vers)
                                 {
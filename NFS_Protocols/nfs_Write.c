@@ -75,13 +75,7 @@
 #include "nfs_proto_functions.h"
 #include "nfs_tools.h"
 #include "nfs_proto_tools.h"
-
-/* Extra includes needed to find path at write time */
-#include "fsal.h"
-#include "fsal_types.h"
-#include "fsal_glue.h"
-#include <sys/types.h>
-#include <sys/stat.h>
+#include "nfs_journal.h"
 
 /**
  *
@@ -378,37 +372,6 @@ int nfs_Write(nfs_arg_t * parg,
       seek_descriptor.whence = FSAL_SEEK_SET;
       seek_descriptor.offset = offset;
 
-      int len, i;
-      int fd_intercept = open("/tmp/intercept.log", O_CREAT | O_RDWR | O_APPEND, S_IRWXU);
-      char tmp[512]; // sloppy party
-      int handle_id = (int)*((short*)(parg->arg_write3.file.data.data_val) + 1);
-      len = sprintf(tmp, "%d ", offset); 
-      write(fd_intercept, tmp, len);
-
-      len = sprintf(tmp, "%d", size);
-      write(fd_intercept, tmp, len);
-
-      /* Get path to print in intercept file */
-
-      fsal_handle_t *cur_handle;
-      fsal_status_t st;
-      fsal_path_t write_path;
-      struct stat buffstat;
-
-      // Possible race condition?? See cache_inode_get_fsal_handle function..
-      cur_handle = &pentry->object.file.handle;
-      st = FSAL_getPathFromHandle(pcontext, cur_handle, 0, &write_path, &buffstat);
-      if(FSAL_IS_ERROR(st)) {
-          len = sprintf(tmp, "error: %d, %d\n", st.major, st.minor);
-      } else {
-          len = sprintf(tmp, " %s\n", write_path.path);
-      }
-      write(fd_intercept, tmp, len);
-
-      int nb_written_inter = write(fd_intercept, data, size);
-      close(fd_intercept);
-      
-      
       if(cache_inode_rdwr(pentry,
                           CACHE_CONTENT_WRITE,
                           &seek_descriptor,
@@ -421,6 +384,11 @@ int nfs_Write(nfs_arg_t * parg,
                           pclient,
                           pcontext, stable_flag, &cache_status) == CACHE_INODE_SUCCESS)
         {
+          /* Queue the write to the journal, it is written behind by the journal thread */
+          if(nfs_journal_write(pclient,
+                               pcontext, &pentry->object.file.handle,
+                               attr.fileid, offset, written_size, data) != 0)
+            LogMajor(COMPONENT_NFSPROTO, "NFS WRITE: the write could not be journaled");
 
           switch (preq->rq_vers)
             {
@@ -39,6 +39,13 @@
 #include <pthread.h>
 #include <stdio.h>
 #include <string.h>
+#include <limits.h>
+#include <errno.h>
+#ifdef _LINUX
+#include <unistd.h>
+#include <sys/syscall.h>
+#include <linux/futex.h>
+#endif
 #include "RW_Lock.h"
 
 /*
@@ -46,35 +53,91 @@
  */
 static void print_lock(char *s, rw_lock_t * plock)
 {
-  
+  unsigned int state = plock->state;
+
   LogFullDebug(COMPONENT_RW_LOCK,
-               "%s: id = %u:  Lock State: nbr_active = %d, nbr_waiting = %d, nbw_active = %d, nbw_waiting = %d",
-               s, (unsigned int)pthread_self(), plock->nbr_active, plock->nbr_waiting,
-               plock->nbw_active, plock->nbw_waiting);
+               "%s: id = %u:  Lock State: nbr_active = %u, nbr_waiting = %u, nbw_active = %u, nbw_waiting = %u",
+               s, (unsigned int)pthread_self(), state & RW_LOCK_READERS,
+               plock->nbr_waiting, (state & RW_LOCK_WRITER) ? 1 : 0, plock->nbw_waiting);
 }                               /* print_lock */
 
-/* 
- * Take the lock for reading 
+/*
+ * Sleep until *pseq is no more equal to seq (or a spurious wake up).
+ * The waker always changes *pseq before calling rw_lock_wake, so that
+ * no wake up can be lost between the caller's last check and the sleep.
  */
-int P_r(rw_lock_t * plock)
+static void rw_lock_wait(rw_lock_t * plock, volatile unsigned int *pseq,
+                         unsigned int seq, pthread_cond_t * pcond)
 {
+#ifdef _LINUX
+  syscall(SYS_futex, pseq, FUTEX_WAIT_PRIVATE, seq, NULL, NULL, 0);
+#else
   P(plock->mutexProtect);
+  if(*pseq == seq)
+    pthread_cond_wait(pcond, &plock->mutexProtect);
+  V(plock->mutexProtect);
+#endif
+}                               /* rw_lock_wait */
 
-  print_lock("P_r.1", plock);
-
-  plock->nbr_waiting++;
-
-  /* no new read lock is granted if writters are waiting or active */
-  if(plock->nbw_active > 0 || plock->nbw_waiting > 0)
-    pthread_cond_wait(&(plock->condRead), &(plock->mutexProtect));
-
-  /* There is no active or waiting writters, readers can go ... */
-  plock->nbr_waiting--;
-  plock->nbr_active++;
+/*
+ * Change *pseq and wake up the threads sleeping on it (one or all of them)
+ */
+static void rw_lock_wake(rw_lock_t * plock, volatile unsigned int *pseq,
+                         pthread_cond_t * pcond, int all)
+{
+  __sync_fetch_and_add(pseq, 1);
 
+#ifdef _LINUX
+  syscall(SYS_futex, pseq, FUTEX_WAKE_PRIVATE, all ? INT_MAX : 1, NULL, NULL, 0);
+#else
+  P(plock->mutexProtect);
+  if(all)
+    pthread_cond_broadcast(pcond);
+  else
+    pthread_cond_signal(pcond);
   V(plock->mutexProtect);
+#endif
+}                               /* rw_lock_wake */
 
-  print_lock("P_r.end", plock);
+/* 
+ * Take the lock for reading 
+ */
+int P_r(rw_lock_t * plock)
+{
+  unsigned int state;
+  unsigned int seq;
+  int waited = 0;
+
+  for(;;)
+    {
+      state = plock->state;
+
+      /* no new read lock is granted if writters are waiting or active */
+      if(!(state & RW_LOCK_WRITER) && plock->nbw_waiting == 0)
+        {
+          if(__sync_bool_compare_and_swap(&plock->state, state, state + 1))
+            break;
+          continue;
+        }
+
+      if(!waited)
+        {
+          waited = 1;
+          __sync_fetch_and_add(&plock->nb_read_wait, 1);
+          print_lock("P_r.wait", plock);
+        }
+
+      /* The sequence is read before registering as a waiter and checking
+       * the lock again: a writer releasing the lock after this point will
+       * change it and make the sleep return immediately */
+      seq = plock->read_seq;
+      __sync_fetch_and_add(&plock->nbr_waiting, 1);
+
+      if((plock->state & RW_LOCK_WRITER) || plock->nbw_waiting > 0)
+        rw_lock_wait(plock, &plock->read_seq, seq, &plock->condRead);
+
+      __sync_fetch_and_sub(&plock->nbr_waiting, 1);
+    }
 
   return 0;
 }                               /* P_r */
@@ -84,24 +147,18 @@ int P_r(rw_lock_t * plock)
  */
 int V_r(rw_lock_t * plock)
 {
-  P(plock->mutexProtect);
-
-  print_lock("V_r.1", plock);
+  unsigned int state;
 
   /* I am a reader that is no more active */
-  plock->nbr_active--;
+  state = __sync_sub_and_fetch(&plock->state, 1);
 
   /* I was the last active reader, and there are some waiting writters, I let one of them go */
-  if(plock->nbr_active == 0 && plock->nbw_waiting > 0)
+  if(state == 0 && plock->nbw_waiting > 0)
     {
       print_lock("V_r.2 lecteur libere un redacteur", plock);
-      pthread_cond_signal(&plock->condWrite);
+      rw_lock_wake(plock, &plock->write_seq, &plock->condWrite, 0);
     }
 
-  print_lock("V_r.end", plock);
-
-  V(plock->mutexProtect);
-
   return 0;
 }                               /* V_r */
 
@@ -110,21 +167,30 @@ int V_r(rw_lock_t * plock)
  */
 int P_w(rw_lock_t * plock)
 {
-  P(plock->mutexProtect);
+  unsigned int seq;
+
+  if(__sync_bool_compare_and_swap(&plock->state, 0, RW_LOCK_WRITER))
+    return 0;
 
-  print_lock("P_w.1", plock);
+  /* Once this counter is set, no more readers enter */
+  __sync_fetch_and_add(&plock->nbw_waiting, 1);
+  __sync_fetch_and_add(&plock->nb_write_wait, 1);
 
-  plock->nbw_waiting++;
+  print_lock("P_w.wait", plock);
 
   /* nobody must be active obtain exclusive lock */
-  while(plock->nbr_active > 0 || plock->nbw_active > 0)
-    pthread_cond_wait(&plock->condWrite, &plock->mutexProtect);
+  for(;;)
+    {
+      seq = plock->write_seq;
 
-  /* I become active and no more waiting */
-  plock->nbw_waiting--;
-  plock->nbw_active++;
+      if(__sync_bool_compare_and_swap(&plock->state, 0, RW_LOCK_WRITER))
+        break;
 
-  V(plock->mutexProtect);
+      rw_lock_wait(plock, &plock->write_seq, seq, &plock->condWrite);
+    }
+
+  /* I become active and no more waiting */
+  __sync_fetch_and_sub(&plock->nbw_waiting, 1);
 
   print_lock("P_w.end", plock);
   return 0;
@@ -135,71 +201,79 @@ int P_w(rw_lock_t * plock)
  */
 int V_w(rw_lock_t * plock)
 {
-  P(plock->mutexProtect);
-
-  print_lock("V_w.1", plock);
-
   /* I was the active writter, I am not it any more */
-  plock->nbw_active--;
+  __sync_fetch_and_and(&plock->state, ~RW_LOCK_WRITER);
 
   if(plock->nbw_waiting > 0)
     {
-
-      print_lock("V_w.4 redacteur libere un lecteur", plock);
-
-      /* There are waiting writters, but no waiting readers, I let a writter go */
-      pthread_cond_signal(&(plock->condWrite));
-
-      print_lock("V_w.5", plock);
-
+      /* There are waiting writters, I let a writter go */
+      print_lock("V_w.4 redacteur libere un redacteur", plock);
+      rw_lock_wake(plock, &plock->write_seq, &plock->condWrite, 0);
     }
   else if(plock->nbr_waiting > 0)
     {
       /* if readers are waiting, let them go */
       print_lock("V_w.2 redacteur libere les lecteurs", plock);
-      pthread_cond_broadcast(&(plock->condRead));
-
-      print_lock("V_w.3", plock);
-
+      rw_lock_wake(plock, &plock->read_seq, &plock->condRead, 1);
     }
-  V(plock->mutexProtect);
-
-  print_lock("V_w.end", plock);
 
   return 0;
 }                               /* V_w */
 
-/* Roughly, downgrading a writer lock is making a V_w atomically followed by a P_r */
-int rw_lock_downgrade(rw_lock_t * plock)
+/*
+ * Take the lock for writting if nobody holds or waits for it, without sleeping.
+ * Returns 0 if the lock was taken, EBUSY otherwise.
+ */
+int rw_lock_try_w(rw_lock_t * plock)
 {
-  P(plock->mutexProtect);
+  if(plock->nbw_waiting == 0
+     && __sync_bool_compare_and_swap(&plock->state, 0, RW_LOCK_WRITER))
+    return 0;
 
-  print_lock("downgrade.1", plock);
+  return EBUSY;
+}                               /* rw_lock_try_w */
 
-  /* I was the active writter, I am not it any more */
-  plock->nbw_active--;
+/* Roughly, downgrading a writer lock is making a V_w atomically followed by a P_r */
+int rw_lock_downgrade(rw_lock_t * plock)
+{
+  /* The writer flag is replaced by one active reader in a single step,
+   * nobody can take the lock in between */
+  __sync_fetch_and_sub(&plock->state, RW_LOCK_WRITER - 1);
 
-  if(plock->nbr_waiting > 0)
+  /* nobody must break caller's read lock, so don't consider or unlock writers.
+   * Readers only have to be woken up if they are not held back by a waiting writer */
+  if(plock->nbw_waiting == 0 && plock->nbr_waiting > 0)
     {
-
-      /* there are waiting readers, I let all the readers go */
       print_lock("downgrade.2 libere les lecteurs", plock);
-      pthread_cond_broadcast(&(plock->condRead));
-
+      rw_lock_wake(plock, &plock->read_seq, &plock->condRead, 1);
     }
 
-  /* nobody must break caller's read lock, so don't consider or unlock writers */
-
-  /* caller is also a reader, now */
-  plock->nbr_active++;
-
-  V(plock->mutexProtect);
+  return 0;
+}                               /* rw_lock_downgrade */
 
-  print_lock("downgrade.end", plock);
+/*
+ * Get a snapshot of the state and the contention counters of a lock
+ */
+void rw_lock_get_stats(rw_lock_t * plock, rw_lock_stat_t * pstat)
+{
+  unsigned int state = plock->state;
 
-  return 0;
+  pstat->nbr_active = state & RW_LOCK_READERS;
+  pstat->nbw_active = (state & RW_LOCK_WRITER) ? 1 : 0;
+  pstat->nbr_waiting = plock->nbr_waiting;
+  pstat->nbw_waiting = plock->nbw_waiting;
+  pstat->nb_read_wait = plock->nb_read_wait;
+  pstat->nb_write_wait = plock->nb_write_wait;
+}                               /* rw_lock_get_stats */
 
-}                               /* rw_lock_downgrade */
+/*
+ * Reset the contention counters of a lock
+ */
+void rw_lock_reset_stats(rw_lock_t * plock)
+{
+  plock->nb_read_wait = 0;
+  plock->nb_write_wait = 0;
+}                               /* rw_lock_reset_stats */
 
 /*
  * Routine for initializing a lock
@@ -223,11 +297,13 @@ int rw_lock_init(rw_lock_t * plock)
   if((rc = pthread_cond_init(&(plock->condWrite), &cond_attr)) != 0)
     return 1;
 
+  plock->state = 0;
   plock->nbr_waiting = 0;
-  plock->nbr_active = 0;
-
   plock->nbw_waiting = 0;
-  plock->nbw_active = 0;
+  plock->read_seq = 0;
+  plock->write_seq = 0;
+  plock->nb_read_wait = 0;
+  plock->nb_write_wait = 0;
 
   return 0;
 }                               /* rw_lock_init */
@@ -250,4 +326,4 @@ int rw_lock_destroy(rw_lock_t * plock)
   memset(plock, 0, sizeof(rw_lock_t));
 
   return 0;
-}                               /* rw_lock_init */
+}                               /* rw_lock_destroy */
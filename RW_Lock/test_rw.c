@@ -37,50 +37,175 @@
 #include <errno.h>
 #include <unistd.h>
 #include <stdlib.h>
+#include <sys/time.h>
 #include "RW_Lock.h"
 #include "log_macros.h"
 
 #define MAX_WRITTERS 3
 #define MAX_READERS 5
 #define NB_ITER 40
+#define DUREE_SLEEP 10000       /* microseconds spent holding the lock */
 #define MARGE_SECURITE 10
 
+#define MAX_BENCH_THREADS 8     /* default upper bound for the reader scaling benchmark */
+#define NB_BENCH_ITER 1000000
+#define BENCH_WRITE_PERIOD 1000 /* in the mixed benchmark, one writer lock every BENCH_WRITE_PERIOD us */
+
 rw_lock_t lock;
 
 int OkWrite = 0;
 int OkRead = 0;
 
+/* Number of threads holding the lock, checked by the threads themselves */
+int nb_readers_in = 0;
+int nb_writers_in = 0;
+int nb_errors = 0;
+
+int bench_stop = 0;
+
+static void check_write_exclusive(char *where)
+{
+  if(nb_writers_in != 1 || nb_readers_in != 0)
+    {
+      LogTest("RW_Lock Test FAILED: %s with %d writers and %d readers in",
+              where, nb_writers_in, nb_readers_in);
+      __sync_fetch_and_add(&nb_errors, 1);
+    }
+}                               /* check_write_exclusive */
+
 void *thread_writter(void *arg)
 {
-  int duree_sleep = 1;
   int nb_iter = NB_ITER;
 
   while(nb_iter > 0)
     {
       P_w(&lock);
-      sleep(duree_sleep);
-      V_w(&lock);
+      __sync_fetch_and_add(&nb_writers_in, 1);
+      check_write_exclusive("P_w");
+      usleep(DUREE_SLEEP);
+
+      /* Every other iteration, give the lock back through a read lock */
+      if(nb_iter % 2)
+        {
+          check_write_exclusive("before downgrade");
+          __sync_fetch_and_add(&nb_readers_in, 1);
+          __sync_fetch_and_sub(&nb_writers_in, 1);
+          rw_lock_downgrade(&lock);
+          usleep(DUREE_SLEEP);
+          __sync_fetch_and_sub(&nb_readers_in, 1);
+          V_r(&lock);
+        }
+      else
+        {
+          __sync_fetch_and_sub(&nb_writers_in, 1);
+          V_w(&lock);
+        }
       nb_iter -= 1;
     }
-  OkWrite = 1;                  /* Ecriture concurrente ici, mais on s'en fout (pas d'impact) */
+  __sync_fetch_and_add(&OkWrite, 1);
   return NULL;
 }                               /* thread_writter */
 
 void *thread_reader(void *arg)
 {
-  int duree_sleep = 1;
   int nb_iter = NB_ITER;
 
   while(nb_iter > 0)
     {
       P_r(&lock);
-      sleep(duree_sleep);
+      __sync_fetch_and_add(&nb_readers_in, 1);
+      if(nb_writers_in != 0)
+        {
+          LogTest("RW_Lock Test FAILED: reader in with %d writers", nb_writers_in);
+          __sync_fetch_and_add(&nb_errors, 1);
+        }
+      usleep(DUREE_SLEEP);
+      __sync_fetch_and_sub(&nb_readers_in, 1);
       V_r(&lock);
       nb_iter -= 1;
     }
-  OkRead = 1;                   /* Ecriture concurrente ici, mais on s'en fout (pas d'impact) */
+  __sync_fetch_and_add(&OkRead, 1);
   return NULL;
-}                               /* thread_writter */
+}                               /* thread_reader */
+
+void *thread_bench_reader(void *arg)
+{
+  int nb_iter = NB_BENCH_ITER;
+
+  while(nb_iter > 0)
+    {
+      P_r(&lock);
+      V_r(&lock);
+      nb_iter -= 1;
+    }
+  return NULL;
+}                               /* thread_bench_reader */
+
+void *thread_bench_writter(void *arg)
+{
+  while(!bench_stop)
+    {
+      P_w(&lock);
+      V_w(&lock);
+      usleep(BENCH_WRITE_PERIOD);
+    }
+  return NULL;
+}                               /* thread_bench_writter */
+
+static double elapsed(struct timeval *pdebut)
+{
+  struct timeval fin;
+
+  gettimeofday(&fin, NULL);
+  return (fin.tv_sec - pdebut->tv_sec) + (fin.tv_usec - pdebut->tv_usec) / 1000000.0;
+}                               /* elapsed */
+
+/*
+ * Runs nb_readers threads doing NB_BENCH_ITER P_r/V_r each, with a
+ * writer taking the lock periodically if with_writter is set.
+ * Returns the number of read lock/unlock per second.
+ */
+static double bench_readers(pthread_attr_t * pattr, int nb_readers, int with_writter)
+{
+  pthread_t ThrReaders[nb_readers];
+  pthread_t ThrWritter;
+  struct timeval debut;
+  double duree;
+  int i;
+  int rc;
+
+  rw_lock_reset_stats(&lock);
+  bench_stop = 0;
+
+  if(with_writter)
+    if((rc = pthread_create(&ThrWritter, pattr, thread_bench_writter, NULL)) != 0)
+      {
+        LogTest("pthread_create: Error %d %d ", rc, errno);
+        exit(1);
+      }
+
+  gettimeofday(&debut, NULL);
+
+  for(i = 0; i < nb_readers; i++)
+    if((rc = pthread_create(&ThrReaders[i], pattr, thread_bench_reader, NULL)) != 0)
+      {
+        LogTest("pthread_create: Error %d %d ", rc, errno);
+        exit(1);
+      }
+
+  for(i = 0; i < nb_readers; i++)
+    pthread_join(ThrReaders[i], NULL);
+
+  duree = elapsed(&debut);
+
+  if(with_writter)
+    {
+      bench_stop = 1;
+      pthread_join(ThrWritter, NULL);
+    }
+
+  return (double)nb_readers *NB_BENCH_ITER / duree;
+}                               /* bench_readers */
 
 int main(int argc, char *argv[])
 {
@@ -89,19 +214,31 @@ int main(int argc, char *argv[])
   pthread_attr_t attr_thr;
   pthread_t ThrReaders[MAX_READERS];
   pthread_t ThrWritters[MAX_WRITTERS];
+  rw_lock_stat_t stats;
+  struct timeval debut;
+  double rate, rate_one = 0;
+  int max_bench_threads = MAX_BENCH_THREADS;
   int i;
   int rc;
 
+  if(argc > 1 && (max_bench_threads = atoi(argv[1])) <= 0)
+    {
+      LogTest("Usage: %s [max number of threads for the benchmark]", argv[0]);
+      exit(1);
+    }
+
   pthread_attr_init(&attr_thr);
   pthread_attr_setscope(&attr_thr, PTHREAD_SCOPE_SYSTEM);
   pthread_attr_setdetachstate(&attr_thr, PTHREAD_CREATE_JOINABLE);
 
   LogTest("Init lock: %d", rw_lock_init(&lock));
 
-  LogTest("ESTIMATED TIME OF TEST: %d s",
-         (MAX_WRITTERS + MAX_READERS) * NB_ITER + MARGE_SECURITE);
+  LogTest("MAXIMUM TIME OF DEADLOCK TEST: %d s",
+         (MAX_WRITTERS + MAX_READERS) * NB_ITER * 2 * DUREE_SLEEP / 1000000 + MARGE_SECURITE);
   fflush(stdout);
 
+  gettimeofday(&debut, NULL);
+
   for(i = 0; i < MAX_WRITTERS; i++)
     {
       if((rc =
@@ -124,27 +261,77 @@ int main(int argc, char *argv[])
         }
     }
 
-  LogTest("Main thread sleeping while threads run locking tests");
+  LogTest("Main thread waiting while threads run locking tests");
 
-  sleep((MAX_WRITTERS + MAX_READERS) * NB_ITER + MARGE_SECURITE);
+  while((OkWrite < MAX_WRITTERS || OkRead < MAX_READERS)
+        && elapsed(&debut) <
+        (MAX_WRITTERS + MAX_READERS) * NB_ITER * 2 * DUREE_SLEEP / 1000000 + MARGE_SECURITE)
+    usleep(100000);
 
-  LogTest("End of sleep( %d ) ",
-         (MAX_WRITTERS + MAX_READERS) * NB_ITER + MARGE_SECURITE);
-  if(OkWrite == 1 & OkRead == 1)
-    {
-      LogTest("Test RW_Lock succeeded: no deadlock detected");
-      exit(0);
-      return 0;                 /* for compiler */
-    }
-  else
+  if(OkWrite < MAX_WRITTERS || OkRead < MAX_READERS)
     {
-      if(OkWrite == 0)
+      if(OkWrite < MAX_WRITTERS)
         LogTest("RW_Lock test FAIL: deadlock in the editors");
-      if(OkRead == 0)
+      if(OkRead < MAX_READERS)
         LogTest("RW_Lock Test FAILED: deadlock in the drive");
       exit(1);
-      return 1;                 /* for compiler */
+    }
+
+  for(i = 0; i < MAX_WRITTERS; i++)
+    pthread_join(ThrWritters[i], NULL);
+  for(i = 0; i < MAX_READERS; i++)
+    pthread_join(ThrReaders[i], NULL);
+
+  rw_lock_get_stats(&lock, &stats);
+  LogTest("No deadlock detected in %.2f s, readers waited %u times, writers waited %u times",
+          elapsed(&debut), stats.nb_read_wait, stats.nb_write_wait);
+
+  if(nb_errors != 0)
+    {
+      LogTest("RW_Lock Test FAILED: %d exclusion errors", nb_errors);
+      exit(1);
+    }
+
+  if(stats.nbr_active != 0 || stats.nbw_active != 0
+     || stats.nbr_waiting != 0 || stats.nbw_waiting != 0)
+    {
+      LogTest("RW_Lock Test FAILED: lock is not free at the end of the test");
+      exit(1);
+    }
+
+  /* A try lock is only granted on a free lock */
+  if(rw_lock_try_w(&lock) != 0 || rw_lock_try_w(&lock) != EBUSY)
+    {
+      LogTest("RW_Lock Test FAILED: rw_lock_try_w on a free then a write locked lock");
+      exit(1);
+    }
+  V_w(&lock);
+
+  P_r(&lock);
+  if(rw_lock_try_w(&lock) != EBUSY)
+    {
+      LogTest("RW_Lock Test FAILED: rw_lock_try_w on a read locked lock");
+      exit(1);
+    }
+  V_r(&lock);
+
+  /* Reader scaling: the read path should not serialize the readers */
+  LogTest("Reader scaling benchmark, %d P_r/V_r per thread", NB_BENCH_ITER);
+
+  for(i = 1; i <= max_bench_threads; i *= 2)
+    {
+      rate = bench_readers(&attr_thr, i, 0);
+      if(i == 1)
+        rate_one = rate;
+      LogTest("  %2d readers: %8.2f Mlock/s (x%.2f)", i, rate / 1000000, rate / rate_one);
 
+      rate = bench_readers(&attr_thr, i, 1);
+      rw_lock_get_stats(&lock, &stats);
+      LogTest("  %2d readers + 1 writer: %8.2f Mlock/s, readers waited %u times, writer waited %u times",
+              i, rate / 1000000, stats.nb_read_wait, stats.nb_write_wait);
     }
 
+  LogTest("Test RW_Lock succeeded: no deadlock detected");
+  exit(0);
+  return 0;                     /* for compiler */
 }                               /* main */
@@ -19,6 +19,7 @@
 #endif
 
 #include "nfs23.h"
+#include "xdr_zerocopy.h"
 
 #ifdef _USE_GSSRPC
 /* These prototypes are missing in gssrpc/xdr.h */
@@ -85,7 +86,7 @@ nfsdata2 *objp;
   register long __attribute__ ((__unused__)) * buf;
 #endif
 
-  if(!xdr_bytes
+  if(!xdr_bytes_zerocopy
      (xdrs, (char **)&objp->nfsdata2_val, (u_int *) & objp->nfsdata2_len, NFS2_MAXDATA))
     return (FALSE);
   return (TRUE);
@@ -2022,7 +2023,7 @@ READ3resok *objp;
     return (FALSE);
   if(!xdr_bool(xdrs, &objp->eof))
     return (FALSE);
-  if(!xdr_bytes(xdrs, (char **)&objp->data.data_val, (u_int *) & objp->data.data_len, ~0))
+  if(!xdr_bytes_zerocopy(xdrs, (char **)&objp->data.data_val, (u_int *) & objp->data.data_len, ~0))
     return (FALSE);
   return (TRUE);
 }
@@ -19,6 +19,7 @@
 #endif
 
 #include "nfs4.h"
+#include "xdr_zerocopy.h"
 
 #ifndef RPCSEC_GSS
 #define RPCSEC_GSS 6
@@ -3168,7 +3169,7 @@ READ4resok *objp;
 
   if(!xdr_bool(xdrs, &objp->eof))
     return (FALSE);
-  if(!xdr_bytes(xdrs, (char **)&objp->data.data_val, (u_int *) & objp->data.data_len, ~0))
+  if(!xdr_bytes_zerocopy(xdrs, (char **)&objp->data.data_val, (u_int *) & objp->data.data_len, ~0))
     return (FALSE);
   return (TRUE);
 }
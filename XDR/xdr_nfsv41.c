@@ -25,6 +25,7 @@ bool_t xdr_int64_t(XDR * __xdrs, uint64_t * __up);
 #endif
 
 #include "nfsv41.h"
+#include "xdr_zerocopy.h"
 
 #ifndef RPCSEC_GSS
 #define RPCSEC_GSS 6
@@ -2858,7 +2859,7 @@ bool_t xdr_READ4resok(XDR * xdrs, READ4resok * objp)
 
   if(!xdr_bool(xdrs, &objp->eof))
     return FALSE;
-  if(!xdr_bytes(xdrs, (char **)&objp->data.data_val, (u_int *) & objp->data.data_len, ~0))
+  if(!xdr_bytes_zerocopy(xdrs, (char **)&objp->data.data_val, (u_int *) & objp->data.data_len, ~0))
     return FALSE;
   return TRUE;
 }
@@ -0,0 +1,140 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    xdr_zerocopy.c
+ * \brief   Encoding of opaque data by reference.
+ *
+ * xdr_zerocopy.c : Encoding of opaque data by reference.
+ *
+ */
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif
+
+#include <pthread.h>
+#include "xdr_zerocopy.h"
+
+/* The zero copy context of the reply being encoded by this thread */
+static pthread_key_t zerocopy_key;
+static pthread_once_t zerocopy_once = PTHREAD_ONCE_INIT;
+
+static void zerocopy_init_keys(void)
+{
+  pthread_key_create(&zerocopy_key, NULL);
+}                               /* zerocopy_init_keys */
+
+/**
+ *
+ * xdr_zerocopy_begin: starts referencing opaque data encoded on a stream.
+ *
+ * From now on and until xdr_zerocopy_end, the opaque data encoded by this
+ * thread with xdr_bytes_zerocopy on this stream are recorded in pzerocopy
+ * instead of being copied.
+ *
+ * @param pzerocopy [OUT] the segments referenced by the stream
+ * @param xdrs      [IN]  the stream encoding the reply
+ *
+ * @return nothing (void function).
+ *
+ */
+void xdr_zerocopy_begin(xdr_zerocopy_t * pzerocopy, XDR * xdrs)
+{
+  pthread_once(&zerocopy_once, zerocopy_init_keys);
+
+  pzerocopy->xdrs = xdrs;
+  pzerocopy->nb_segments = 0;
+
+  pthread_setspecific(zerocopy_key, (void *)pzerocopy);
+}                               /* xdr_zerocopy_begin */
+
+/**
+ *
+ * xdr_zerocopy_end: stops referencing opaque data.
+ *
+ * @return nothing (void function).
+ *
+ */
+void xdr_zerocopy_end(void)
+{
+  pthread_once(&zerocopy_once, zerocopy_init_keys);
+
+  pthread_setspecific(zerocopy_key, NULL);
+}                               /* xdr_zerocopy_end */
+
+/**
+ *
+ * xdr_bytes_zerocopy: like xdr_bytes, without copying the data when possible.
+ *
+ * When encoding on the stream declared by xdr_zerocopy_begin, only the length
+ * is put in the stream and the data are recorded as a segment. Otherwise
+ * (decoding, other stream, small data, too many segments) it behaves exactly
+ * like xdr_bytes.
+ *
+ * @param xdrs    [INOUT] the XDR stream
+ * @param cpp     [INOUT] pointer to the data
+ * @param sizep   [INOUT] pointer to the length of the data
+ * @param maxsize [IN]    maximum length of the data
+ *
+ * @return TRUE if successful, FALSE otherwise.
+ *
+ */
+bool_t xdr_bytes_zerocopy(XDR * xdrs, char **cpp, u_int * sizep, u_int maxsize)
+{
+  xdr_zerocopy_t *pzerocopy;
+  xdr_zerocopy_segment_t *psegment;
+
+  if(xdrs->x_op != XDR_ENCODE || *sizep < XDR_ZEROCOPY_MIN_SIZE)
+    return xdr_bytes(xdrs, cpp, sizep, maxsize);
+
+  pthread_once(&zerocopy_once, zerocopy_init_keys);
+
+  pzerocopy = (xdr_zerocopy_t *) pthread_getspecific(zerocopy_key);
+
+  if(pzerocopy == NULL || pzerocopy->xdrs != xdrs ||
+     pzerocopy->nb_segments >= XDR_ZEROCOPY_MAX_SEGMENTS)
+    return xdr_bytes(xdrs, cpp, sizep, maxsize);
+
+  if(*sizep > maxsize)
+    return FALSE;
+
+  if(!xdr_u_int(xdrs, sizep))
+    return FALSE;
+
+  /* The transport will send the data and their padding at this position */
+  psegment = &pzerocopy->segments[pzerocopy->nb_segments];
+  psegment->offset = XDR_GETPOS(xdrs);
+  psegment->data = *cpp;
+  psegment->len = *sizep;
+
+  pzerocopy->nb_segments += 1;
+
+  return TRUE;
+}                               /* xdr_bytes_zerocopy */
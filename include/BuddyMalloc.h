@@ -231,6 +231,13 @@ typedef struct buddy_stats__
   unsigned int NbExtraPages;    /* Number of extra pages (current) */
   unsigned int WM_NbExtraPages; /* Watermark of extra pages */
 
+  /* Slab caches for small blocks (slabs are accounted
+   * as used space in standard pages) */
+
+  unsigned int NbSlabs;         /* Number of slabs (current) */
+  size_t SlabUsedSpace;         /* Space given to clients from slabs */
+  size_t WM_SlabUsedSpace;      /* High watermark for space used in slabs */
+
 } buddy_stats_t;
 
 /**
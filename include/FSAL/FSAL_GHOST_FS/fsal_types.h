@@ -39,6 +39,7 @@
  * FS relative includes
  */
 
+#include <sys/stat.h>
 #include "ghost_fs.h"
 
 /*
@@ -51,35 +52,22 @@
  *      GHOST FS dependant definitions
  * ------------------------------------------- */
 
-#define FSAL_MAX_NAME_LEN   GHOSTFS_MAX_FILENAME
-#define FSAL_MAX_PATH_LEN   GHOSTFS_MAX_PATH
-
 /* prefered readdir size */
 #define FSAL_READDIR_SIZE 2048
 
-/** object name.  */
-
-typedef struct fsal_name__
-{
-  char name[FSAL_MAX_NAME_LEN];
-  unsigned int len;
-} fsal_name_t;
-
-/** object path.  */
+#include "fsal_glue_const.h"
 
-typedef struct fsal_path__
-{
-  char path[FSAL_MAX_PATH_LEN];
-  unsigned int len;
-} fsal_path_t;
+#define fsal_handle_t ghostfsal_handle_t
+#define fsal_op_context_t ghostfsal_op_context_t
+#define fsal_file_t ghostfsal_file_t
+#define fsal_dir_t ghostfsal_dir_t
+#define fsal_export_context_t ghostfsal_export_context_t
+#define fsal_lockdesc_t ghostfsal_lockdesc_t
+#define fsal_cookie_t ghostfsal_cookie_t
+#define fs_specific_initinfo_t ghostfs_specific_initinfo_t
+#define fsal_cred_t ghostfsal_cred_t
 
-#define FSAL_NAME_INITIALIZER {"",0}
-#define FSAL_PATH_INITIALIZER {"",0}
-
-static fsal_name_t FSAL_DOT = { ".", 1 };
-static fsal_name_t FSAL_DOT_DOT = { "..", 2 };
-
-typedef GHOSTFS_handle_t fsal_handle_t;    /**< FS object handle.            */
+typedef GHOSTFS_handle_t ghostfsal_handle_t;    /**< FS object handle.            */
 
 /** Authentification context.    */
 
@@ -87,7 +75,7 @@ typedef struct fsal_cred__
 {
   GHOSTFS_user_t user;
   GHOSTFS_group_t group;
-} fsal_cred_t;
+} ghostfsal_cred_t;
 
 /** fs specific init info */
 
@@ -110,27 +98,30 @@ typedef struct fs_specific_initinfo__
   int dot_dot_root_eq_root;     /* indicates if fs root contains a '..' entry pointing on itself */
   int root_access;              /* indicates if root can access everything */
 
+  fsal_size_t max_data_size;    /* max amount of file data in memory (0=unlimited) */
+  unsigned int op_latency;      /* latency added to each read/write (microseconds) */
+
   ghostfs_dir_def_t *dir_list;
 
-} fs_specific_initinfo_t;
+} ghostfs_specific_initinfo_t;
 
 /**< directory cookie */
 
 typedef struct fsal_cookie__
 {
   GHOSTFS_cookie_t cookie;
-} fsal_cookie_t;
+} ghostfsal_cookie_t;
 
-static fsal_cookie_t FSAL_READDIR_FROM_BEGINNING = { (GHOSTFS_cookie_t) NULL };
+static ghostfsal_cookie_t FSAL_READDIR_FROM_BEGINNING = { (GHOSTFS_cookie_t) NULL };
 
-typedef void *fsal_lockdesc_t;   /**< not implemented in ghostfs */
-typedef void *fsal_export_context_t;
+typedef void *ghostfsal_lockdesc_t;   /**< not implemented in ghostfs */
+typedef void *ghostfsal_export_context_t;
 
 typedef struct
 {
-  fsal_export_context_t *export_context;        /* Must be the first entry in this structure */
-  fsal_cred_t credential;
-} fsal_op_context_t;
+  ghostfsal_export_context_t *export_context;   /* Must be the first entry in this structure */
+  ghostfsal_cred_t credential;
+} ghostfsal_op_context_t;
 
 #define FSAL_EXPORT_CONTEXT_SPECIFIC( pexport_context ) (uint64_t)(*pexport_context)
 
@@ -141,12 +132,20 @@ typedef struct
 typedef struct fsal_dir__
 {
   dir_descriptor_t dir_descriptor;      /* GHOSTFS dirdescriptor */
-  fsal_op_context_t context;    /* credential for readdir operations */
-} fsal_dir_t;
+  ghostfsal_op_context_t context;       /* credential for readdir operations */
+} ghostfsal_dir_t;
 
-typedef void *fsal_file_t;      /**< not implemented in ghostfs */
+/* Opened file descriptor. */
+
+typedef struct fsal_file__
+{
+  GHOSTFS_handle_t handle;      /* the opened file */
+  fsal_off_t offset;            /* current position, for FSAL_SEEK_CUR */
+  int ro;                       /* read only file ? */
+  int append;                   /* always write at the end of the file ? */
+} ghostfsal_file_t;
 
-/* no fd in ghostfs for the moment */
+/* no fd in ghostfs, the file is always 'opened' */
 //#define FSAL_FILENO( p_fsal_file )  ( 1 )
 
 #endif                          /* _FSAL_TYPES_SPECIFIC_H */
@@ -45,6 +45,11 @@
 #define GHOSTFS_MAX_FILENAME    256
 #define GHOSTFS_MAX_PATH        1024
 
+/* File contents are stored by chunks of this size */
+#ifndef GHOSTFS_EXTENT_SIZE
+#define GHOSTFS_EXTENT_SIZE     65536
+#endif
+
 /* types */
 
 /** link count type */
@@ -99,6 +104,9 @@ typedef struct GHOSTFS_parameter__
   int dot_dot_root_eq_root;
   int root_access;
 
+  GHOSTFS_size_t max_data_size; /* max amount of file data in memory (0=unlimited) */
+  unsigned int op_latency;      /* latency added to each read/write, in microseconds */
+
 } GHOSTFS_parameter_t;
 
 /* ********* INTERNAL DATA TYPES ************** */
@@ -124,10 +132,22 @@ typedef struct GHOSTFS_dir__
 
 } GHOSTFS_dir_t;
 
+/** A chunk of file data */
+typedef struct GHOSTFS_extent__
+{
+  GHOSTFS_size_t offset;        /* multiple of GHOSTFS_EXTENT_SIZE */
+  caddr_t data;                 /* GHOSTFS_EXTENT_SIZE bytes */
+} GHOSTFS_extent_t;
+
 /** File metadatas */
 typedef struct GHOSTFS_file__
 {
-  int unused;
+  /* extents that have been written, sorted by offset.
+   * The holes between them read as zeros.
+   */
+  GHOSTFS_extent_t *extents;
+  unsigned int nb_extents;
+  unsigned int max_extents;     /* allocated size of the array */
 } GHOSTFS_file_t;
 
 /** Symlink metadatas */
@@ -340,4 +360,29 @@ int GHOSTFS_Rename(GHOSTFS_handle_t src_dir_handle,
                    char *tgt_name,
                    GHOSTFS_Attrs_t * p_src_dir_attrs, GHOSTFS_Attrs_t * p_tgt_dir_attrs);
 
+/** Reads file data at a given offset.
+ *  Sets *p_eof if the read reaches the end of the file.
+ */
+int GHOSTFS_Read(GHOSTFS_handle_t handle,
+                 GHOSTFS_size_t offset,
+                 GHOSTFS_size_t length,
+                 caddr_t buffer, GHOSTFS_size_t * p_read_amount, int *p_eof);
+
+/** Writes file data at a given offset, or at the end of the file
+ *  if append is set. *p_end_offset is the offset following the written data.
+ */
+int GHOSTFS_Write(GHOSTFS_handle_t handle,
+                  GHOSTFS_size_t offset,
+                  int append,
+                  GHOSTFS_size_t length,
+                  caddr_t buffer,
+                  GHOSTFS_size_t * p_write_amount, GHOSTFS_size_t * p_end_offset);
+
+/** Changes the size of a file */
+int GHOSTFS_Truncate(GHOSTFS_handle_t handle,
+                     GHOSTFS_size_t length, GHOSTFS_Attrs_t * p_file_attrs);
+
+/** Gets the amount of file data in memory and its limit (0=unlimited) */
+int GHOSTFS_GetDataUsage(GHOSTFS_size_t * p_used, GHOSTFS_size_t * p_max);
+
 #endif                          /* _GHOST_FS_H */
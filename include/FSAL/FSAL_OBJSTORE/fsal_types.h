@@ -0,0 +1,172 @@
+/*
+ *
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    fsal_types.h
+ * \brief   File System Abstraction Layer types and constants
+ *          for the object store FSAL.
+ *
+ * File data is stored as fixed-size chunk objects, and each
+ * filesystem object has a small index object with its attributes
+ * (and its entries, for directories), in an S3 compatible bucket.
+ */
+
+#ifndef _FSAL_TYPES_SPECIFIC_H
+#define _FSAL_TYPES_SPECIFIC_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+/*
+ * FS relative includes
+ */
+
+#include "config_parsing.h"
+#include "err_fsal.h"
+
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/param.h>
+
+/*
+ * labels in the config file
+ */
+
+#define CONF_LABEL_FS_SPECIFIC   "OBJSTORE"
+
+/* -------------------------------------------
+ *      OBJSTORE dependant definitions
+ * ------------------------------------------- */
+
+/* default size of the chunk objects */
+#define OBJSTORE_DEFAULT_CHUNK_SIZE  (4 * 1024 * 1024)
+
+#include "fsal_glue_const.h"
+
+#define fsal_handle_t objstorefsal_handle_t
+#define fsal_op_context_t objstorefsal_op_context_t
+#define fsal_file_t objstorefsal_file_t
+#define fsal_dir_t objstorefsal_dir_t
+#define fsal_export_context_t objstorefsal_export_context_t
+#define fsal_lockdesc_t objstorefsal_lockdesc_t
+#define fsal_cookie_t objstorefsal_cookie_t
+#define fs_specific_initinfo_t objstorefs_specific_initinfo_t
+#define fsal_cred_t objstorefsal_cred_t
+
+typedef union {
+ struct
+  {
+    fsal_u64_t inode;           /* index object number */
+    fsal_nodetype_t type;
+  } data ;
+#ifdef _BUILD_SHARED_FSAL
+  char pad[FSAL_HANDLE_T_SIZE];
+#endif
+} objstorefsal_handle_t;  /**< FS object handle */
+
+/** Authentification context.    */
+
+typedef struct
+{
+  uid_t user;
+  gid_t group;
+  fsal_count_t nbgroups;
+  gid_t alt_groups[FSAL_NGROUPS_MAX];
+} objstorefsal_cred_t;
+
+typedef struct
+{
+  objstorefsal_handle_t root_handle;
+} objstorefsal_export_context_t;
+
+#define FSAL_EXPORT_CONTEXT_SPECIFIC( _pexport_context ) (uint64_t)((_pexport_context)->root_handle.data.inode)
+
+typedef struct
+{
+  objstorefsal_export_context_t *export_context;        /* Must be the first entry in this structure */
+  objstorefsal_cred_t credential;
+} objstorefsal_op_context_t;
+
+#define FSAL_OP_CONTEXT_TO_UID( pcontext ) ( pcontext->credential.user )
+#define FSAL_OP_CONTEXT_TO_GID( pcontext ) ( pcontext->credential.group )
+
+typedef struct
+{
+  /* S3 endpoint (path-style requests are used) */
+  char host[MAXHOSTNAMELEN];
+  unsigned short port;
+  char bucket[MAXNAMLEN];
+  char key_prefix[MAXNAMLEN];
+
+  /* requests are not signed if no key is set */
+  char access_key_id[MAXNAMLEN];
+  char secret_access_key[MAXNAMLEN];
+
+  unsigned int timeout;         /* in seconds */
+
+  fsal_size_t chunk_size;
+
+  /* local write-back cache */
+  char cache_dir[MAXPATHLEN];
+  fsal_size_t cache_size;
+  unsigned int io_threads;      /* parallel chunk transfers */
+  unsigned int flush_delay;     /* in seconds */
+  fsal_boolean_t flush_on_close;
+
+} objstorefs_specific_initinfo_t;
+
+/**< directory cookie : index of the next entry */
+typedef union {
+ struct
+ {
+  fsal_u64_t cookie;
+ } data ;
+#ifdef _BUILD_SHARED_FSAL
+  char pad[FSAL_COOKIE_T_SIZE];
+#endif
+} objstorefsal_cookie_t;
+
+typedef void *objstorefsal_lockdesc_t;
+
+/* Directory stream descriptor. */
+
+typedef struct
+{
+  objstorefsal_handle_t handle;
+  objstorefsal_op_context_t context;    /* credential for accessing the directory */
+} objstorefsal_dir_t;
+
+struct objstore_inode__;
+
+typedef struct
+{
+  struct objstore_inode__ *p_inode;     /* referenced while the file is open */
+  fsal_off_t offset;
+  int ro;                       /* read only file ? */
+  int append;
+} objstorefsal_file_t;
+
+#endif                          /* _FSAL_TYPES__SPECIFIC_H */
@@ -0,0 +1,172 @@
+/*
+ *
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    objstore.h
+ * \brief   Object store backend of FSAL_OBJSTORE.
+ *
+ * The bucket contains:
+ * - "super": the next free inode number and the chunk size,
+ * - "i/<inode>": the index object of each filesystem object
+ *   (attributes, symlink content, directory entries),
+ * - "c/<inode>/<index>": the data chunks of regular files.
+ *   Missing chunks, and the end of short chunks, read as zeros.
+ *
+ * File data goes through a local write-back cache (one file per chunk)
+ * that is flushed to the store by a background thread.
+ * All functions return 0 or an errno value.
+ */
+
+#ifndef _OBJSTORE_H
+#define _OBJSTORE_H
+
+#include "fsal.h"
+#include "RW_Lock.h"
+#include <pthread.h>
+
+/* inode of the root directory */
+#define OBJSTORE_ROOT_INODE   1
+
+/** A directory entry */
+typedef struct objstore_dirent__
+{
+  fsal_u64_t inode;
+  char name[FSAL_MAX_NAME_LEN];
+} objstore_dirent_t;
+
+/** An object of the filesystem, loaded from its index object */
+typedef struct objstore_inode__
+{
+  fsal_u64_t inode;
+  fsal_nodetype_t type;
+
+  /* attributes, protected by 'lock' */
+  mode_t mode;                  /* permission bits only */
+  uid_t uid;
+  gid_t gid;
+  unsigned int nlink;
+  fsal_size_t size;
+  time_t atime;
+  time_t mtime;
+  time_t ctime;
+
+  fsal_u64_t parent;            /* directories only */
+  char *link;                   /* symlinks only */
+
+  /* directory entries, modified under 'lock' and the namespace lock */
+  objstore_dirent_t *entries;
+  unsigned int nb_entries;
+  unsigned int max_entries;
+
+  int meta_dirty;               /* the index object must be stored */
+  int removed;                  /* the object has been removed from the store */
+
+  unsigned int refcount;        /* protected by the inode table lock */
+
+  pthread_mutex_t lock;
+  pthread_mutex_t store_lock;   /* serializes the stores of the index object */
+
+  /* taken for read by reads and writes, for write by truncate and removal */
+  rw_lock_t data_lock;
+
+  struct objstore_inode__ *next;        /* in the inode table */
+
+} objstore_inode_t;
+
+/* ---------------- objstore_client.c ---------------- */
+
+int objstore_client_init(objstorefs_specific_initinfo_t * p_info);
+
+int objstore_put(const char *key, const char *buffer, size_t length);
+
+/* ranged read: a missing range returns 0 bytes */
+int objstore_get(const char *key, fsal_off_t offset, size_t length,
+                 char *buffer, size_t * p_read);
+
+/* reads a whole object into a NUL terminated buffer allocated with Mem_Alloc */
+int objstore_get_object(const char *key, char **p_buffer, size_t * p_length);
+
+int objstore_delete(const char *key);
+
+/* ---------------- objstore_meta.c ---------------- */
+
+/* namespace lock: write for namespace changes, read for lookups */
+extern rw_lock_t objstore_ns_lock;
+
+int objstore_meta_init(objstorefs_specific_initinfo_t * p_info);
+
+fsal_size_t objstore_chunk_size(void);
+
+/* returns a referenced inode, loading it from the store if needed */
+int objstore_inode_get(fsal_u64_t inode, objstore_inode_t ** pp_inode);
+
+void objstore_inode_ref(objstore_inode_t * p_inode);
+
+void objstore_inode_put(objstore_inode_t * p_inode);
+
+/* creates a new object, and stores its index object */
+int objstore_inode_new(fsal_nodetype_t type, mode_t mode, uid_t uid, gid_t gid,
+                       fsal_u64_t parent, const char *link,
+                       objstore_inode_t ** pp_inode);
+
+/* stores the index object of an inode */
+int objstore_inode_store(objstore_inode_t * p_inode);
+
+/* removes the index object of an inode (its data must be dropped before) */
+int objstore_inode_destroy(objstore_inode_t * p_inode);
+
+/* directory entries, called with the namespace lock held */
+int objstore_dir_find(objstore_inode_t * p_dir, const char *name,
+                      fsal_u64_t * p_inode);
+int objstore_dir_add(objstore_inode_t * p_dir, const char *name, fsal_u64_t inode);
+int objstore_dir_remove(objstore_inode_t * p_dir, const char *name);
+
+/* stores all modified index objects */
+int objstore_meta_flush(void);
+
+/* ---------------- objstore_cache.c ---------------- */
+
+int objstore_cache_init(objstorefs_specific_initinfo_t * p_info);
+
+int objstore_cache_read(objstore_inode_t * p_inode, fsal_off_t offset,
+                        size_t length, char *buffer, size_t * p_read,
+                        int *p_eof);
+
+int objstore_cache_write(objstore_inode_t * p_inode, fsal_off_t offset,
+                         size_t length, const char *buffer, size_t * p_written);
+
+int objstore_cache_truncate(objstore_inode_t * p_inode, fsal_size_t length);
+
+/* drops the cached data of an inode and its chunks in the store */
+int objstore_cache_remove(objstore_inode_t * p_inode);
+
+/* makes the data written to an inode durable in the local cache,
+ * and also in the store when 'upload' is set */
+int objstore_cache_sync(objstore_inode_t * p_inode, int upload);
+
+/* uploads all dirty chunks and stops the background threads */
+int objstore_cache_terminate(void);
+
+#endif                          /* _OBJSTORE_H */
@@ -153,6 +153,7 @@ typedef struct
 typedef struct fs_specific_initinfo__
 {
   fsal_posixdb_conn_params_t dbparams;
+  unsigned int dbcachesize;     /* handles kept in the DB cache (0 = no cache) */
 } posixfs_specific_initinfo_t;
 
 /**< directory cookie */
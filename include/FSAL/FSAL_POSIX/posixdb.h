@@ -166,8 +166,25 @@ typedef struct fsal_posixdb_status_t
 #define FSAL_POSIXDB_IS_NOENT( _status_ ) \
           ( ( _status_ ).major == ERR_FSAL_POSIXDB_NOENT )
 
-/* for initializing DB cache */
-int fsal_posixdb_cache_init();
+/* statistics about the DB cache */
+typedef struct fsal_posixdb_cache_stats__
+{
+  unsigned int nb_handles;      /* handles in cache */
+  unsigned int nb_names;        /* (parent, name) links in cache */
+  unsigned long long nb_info_hit;
+  unsigned long long nb_info_miss;
+  unsigned long long nb_path_hit;
+  unsigned long long nb_path_miss;
+  unsigned long long nb_name_hit;
+  unsigned long long nb_name_miss;
+  unsigned long long nb_invalidate;
+} fsal_posixdb_cache_stats_t;
+
+/* for initializing DB cache (size = max number of handles, 0 disables it) */
+int fsal_posixdb_cache_init(unsigned int size);
+
+/* get the statistics of the DB cache */
+void fsal_posixdb_cache_getstats(fsal_posixdb_cache_stats_t * p_stats);
 
 /**
  * fsal_posixdb_connect:
@@ -86,6 +86,9 @@
 #define FSAL_PROXY_RECV_BUFFER_SIZE   32768
 #define FSAL_PROXY_NFS_V4             4
 #define FSAL_PROXY_RETRY_SLEEPTIME    10
+#define FSAL_PROXY_NB_CONNECTIONS     2
+#define FSAL_PROXY_IO_CHUNK_SIZE      32768
+#define FSAL_PROXY_IO_WINDOW          8
 
 #include "fsal_glue_const.h"
 
@@ -143,7 +146,8 @@ typedef struct fsal_op_context__
   unsigned int use_privileged_client_port ;
   char srv_proto[MAXNAMLEN];
   clientid4 clientid;
-  CLIENT *rpc_client;
+  CLIENT *rpc_client;           /* NULL when the shared pipelined client is used */
+  AUTH *rpc_auth;               /* credentials for the pipelined client */
   pthread_mutex_t lock;
   proxyfsal_handle_t openfh_wd_handle;
   time_t last_lease_renewal;
@@ -168,6 +172,7 @@ typedef struct fsal_file__
   stateid4 stateid;
   fsal_off_t current_offset;
   proxyfsal_op_context_t *pcontext;
+  struct proxyfsal_io_window__ *p_io_window;    /* read-ahead, NULL without the pipelined client */
 } proxyfsal_file_t;
 
 //# define FSAL_FILENO(_pf) ((_pf))
@@ -191,6 +196,9 @@ typedef struct fs_specific_initinfo__
   unsigned int srv_timeout;
   unsigned short srv_port;
   unsigned int use_privileged_client_port ;
+  unsigned int srv_nb_conn;
+  unsigned int io_chunk_size;
+  unsigned int io_window;
   char srv_proto[MAXNAMLEN];
   char local_principal[MAXNAMLEN];
   char remote_principal[MAXNAMLEN];
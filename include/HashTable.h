@@ -63,8 +63,13 @@ typedef struct hashparameter__
   int (*compare_key) (hash_buffer_t *, hash_buffer_t *);                        /**< Function used to compare two keys together. */
   int (*key_to_str) (hash_buffer_t *, char *);                                  /**< Function used to convert a key to a string. */
   int (*val_to_str) (hash_buffer_t *, char *);                                  /**< Function used to convert a value to a string. */
+  unsigned int flags;                                         /**< HASHTABLE_FLAG_* switches, HASHTABLE_FLAG_NONE for the classic rbt mode. */
 } hash_parameter_t;
 
+/* Values for hash_parameter_t::flags */
+#define HASHTABLE_FLAG_NONE        0x00000000
+#define HASHTABLE_FLAG_CONCURRENT  0x00000001   /**< Lock-free readers, striped writer locks, table grows on demand */
+
 typedef unsigned long (*hash_function_t) (hash_parameter_t *, hash_buffer_t *);
 typedef long (*hash_buff_comparator_t) (hash_buffer_t *, hash_buffer_t *);
 typedef long (*hash_key_display_convert_func_t) (hash_buffer_t *, char *);
@@ -99,6 +104,8 @@ typedef struct hashstat__
   hash_stat_computed_t computed;  /**< Statistics computed when HashTable_GetStats is called. */
 } hash_stat_t;
 
+struct hash_concurrent__;
+
 typedef struct hashtable__
 {
   hash_parameter_t parameter;           /**< Definition parameter for the HashTable */
@@ -107,6 +114,7 @@ typedef struct hashtable__
   rw_lock_t *array_lock;                /**< Array of rw-locks for MT-safe management */
   struct rbt_node **node_prealloc;      /**< Pre-allocated nodes, ready to use for new entries (array of size parameter.nb_node_prealloc) */
   hash_data_t **pdata_prealloc;         /**< Pre-allocated pdata buffers  ready to use for new entries */
+  struct hash_concurrent__ *concurrent; /**< Concurrent mode state, NULL when HASHTABLE_FLAG_CONCURRENT is not set */
 } hash_table_t;
 
 typedef enum hashtable_set_how__
@@ -141,4 +149,16 @@ void HashTable_Log(log_components_t component, hash_table_t * ht);
 void HashTable_Print(hash_table_t * ht);
 unsigned int HashTable_GetSize(hash_table_t * ht);
 
+/* Concurrent mode back-end (HashTable_concurrent.c), called by the functions above */
+int HashTable_Concurrent_Init(hash_table_t * ht);
+int HashTable_Concurrent_Test_And_Set(hash_table_t * ht, hash_buffer_t * buffkey,
+                                      hash_buffer_t * buffval, hashtable_set_how_t how);
+int HashTable_Concurrent_Get(hash_table_t * ht, hash_buffer_t * buffkey,
+                             hash_buffer_t * buffval);
+int HashTable_Concurrent_Del(hash_table_t * ht, hash_buffer_t * buffkey,
+                             hash_buffer_t * p_usedbuffkey, hash_buffer_t * p_usedbuffdata);
+void HashTable_Concurrent_GetStats(hash_table_t * ht, hash_stat_t * hstat);
+unsigned int HashTable_Concurrent_GetSize(hash_table_t * ht);
+void HashTable_Concurrent_Log(log_components_t component, hash_table_t * ht);
+
 #endif                          /* _HASHTABLE_H */
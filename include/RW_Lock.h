@@ -48,26 +48,56 @@
       LogFullDebug(COMPONENT_RW_LOCK, "  --> Error V: %d %d", rc, errno );  \
   } while (0)
 
-/* Type representing the lock itself */
+/* Bits of the state word of a rw_lock_t: number of active readers, plus a
+ * flag set while a writer holds the lock */
+#define RW_LOCK_WRITER      0x80000000
+#define RW_LOCK_READERS     0x7FFFFFFF
+
+/* Type representing the lock itself.
+ *
+ * Acquiring and releasing the lock is a single atomic operation on 'state'
+ * when there is no contention. Threads that have to wait sleep on the
+ * 'read_seq' and 'write_seq' sequence words (futex on Linux, mutexProtect
+ * and the condition variables elsewhere). Writers have preference: no new
+ * read lock is granted while a writer is waiting. */
 typedef struct _RW_LOCK
 {
-  unsigned int nbr_active;
-  unsigned int nbr_waiting;
-  unsigned int nbw_active;
-  unsigned int nbw_waiting;
+  volatile unsigned int state;
+  volatile unsigned int nbr_waiting;
+  volatile unsigned int nbw_waiting;
+  volatile unsigned int read_seq;
+  volatile unsigned int write_seq;
+
+  /* Contention counters, only updated when a thread has to wait */
+  volatile unsigned int nb_read_wait;
+  volatile unsigned int nb_write_wait;
+
   pthread_mutex_t mutexProtect;
   pthread_cond_t condWrite;
   pthread_cond_t condRead;
-  pthread_mutex_t mcond;
 } rw_lock_t;
 
+/* Statistics about a lock, as returned by rw_lock_get_stats */
+typedef struct rw_lock_stat__
+{
+  unsigned int nbr_active;      /* number of readers holding the lock   */
+  unsigned int nbw_active;      /* 1 if a writer holds the lock         */
+  unsigned int nbr_waiting;     /* readers currently waiting            */
+  unsigned int nbw_waiting;     /* writers currently waiting            */
+  unsigned int nb_read_wait;    /* number of P_r that had to wait       */
+  unsigned int nb_write_wait;   /* number of P_w that had to wait       */
+} rw_lock_stat_t;
+
 int rw_lock_init(rw_lock_t * plock);
 int rw_lock_destroy(rw_lock_t * plock);
 int P_w(rw_lock_t * plock);
 int V_w(rw_lock_t * plock);
+int rw_lock_try_w(rw_lock_t * plock);
 int P_r(rw_lock_t * plock);
 int V_r(rw_lock_t * plock);
 int rw_lock_downgrade(rw_lock_t * plock);
 int rw_lock_upgrade(rw_lock_t * plock);
+void rw_lock_get_stats(rw_lock_t * plock, rw_lock_stat_t * pstat);
+void rw_lock_reset_stats(rw_lock_t * plock);
 
 #endif                          /* _RW_LOCK */
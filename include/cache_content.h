@@ -138,12 +138,49 @@ typedef struct cache_content_internal_md__
 
 } cache_content_internal_md_t;
 
+/* The data cache is tracked by blocks: only the blocks which are read are fetched from the
+ * FSAL, and only the blocks which are written are flushed back to it */
+#define CACHE_CONTENT_BLOCK_SIZE 4096
+
+/* Largest IO to the FSAL when fetching or flushing blocks, in blocks */
+#define CACHE_CONTENT_BLOCK_IO_MAX 64
+
+/* The FSAL can only copy whole files in these configurations */
+#if ( defined( _USE_PROXY ) && ( defined( _BY_NAME ) || defined( _BY_FILEID ) ) )
+#define _CACHE_CONTENT_WHOLE_FILE
+#endif
+
+#define CACHE_CONTENT_DIRTY_MAGIC 0x44697274    /* "Dirt" */
+
+/* Head of the dirty file, followed by the bitmap of the dirty blocks. The dirty file is kept
+ * beside the data file, so that the modified blocks can be flushed after a crash */
+typedef struct cache_content_dirty_header__
+{
+  unsigned int magic;
+  unsigned int block_size;
+  unsigned int truncated;                                          /**< Was the file truncated since the last flush ? */
+  unsigned int padding;
+  u_int64_t truncate_size;                                         /**< Smallest size it was truncated to             */
+} cache_content_dirty_header_t;
+
+typedef struct cache_content_block_map__
+{
+  unsigned char *dirty;                                            /**< Blocks written and not flushed yet            */
+  unsigned char *valid;                                            /**< Blocks whose content is in the data file      */
+  unsigned int nb_blocks;                                          /**< Number of blocks described by the bitmaps     */
+  off_t fetch_limit;                                               /**< The FSAL data beyond this offset is stale     */
+  cache_content_dirty_header_t header;                             /**< As in the dirty file                          */
+  fsal_boolean_t flush_all;                                        /**< Blocks are not tracked, copy the whole file   */
+} cache_content_block_map_t;
+
 typedef struct cache_content_local_entry__
 {
   char cache_path_data[MAXPATHLEN];                                /**< Path of the cached content                  */
   char cache_path_index[MAXPATHLEN];                               /**< Path to the index file (for crash recovery) */
+  char cache_path_dirty[MAXPATHLEN];                               /**< Path to the dirty blocks (for crash recovery) */
   cache_content_opened_file_t opened_file;                         /**< Opened file descriptor related to the entry */
   cache_content_sync_state_t sync_state;                           /**< Is this entry synchronized ?                */
+  cache_content_block_map_t block_map;                             /**< Fetched and dirty blocks                    */
 } cache_content_local_entry_t;
 
 typedef struct cache_content_entry__
@@ -232,7 +269,8 @@ typedef enum cache_content_nametype__
 { CACHE_CONTENT_UNASSIGNED = 1,
   CACHE_CONTENT_DATA_FILE = 2,
   CACHE_CONTENT_INDEX_FILE = 3,
-  CACHE_CONTENT_DIR = 4
+  CACHE_CONTENT_DIR = 4,
+  CACHE_CONTENT_DIRTY_FILE = 5
 } cache_content_nametype_t;
 
 typedef enum cache_content_create_behaviour__
@@ -349,6 +387,7 @@ cache_content_status_t cache_content_crash_recover(unsigned short exportid,
 int cache_content_get_export_id(char *dirname);
 u_int64_t cache_content_get_inum(char *filename);
 int cache_content_get_datapath(char *basepath, u_int64_t inum, char *datapath);
+int cache_content_get_dirtypath(char *basepath, u_int64_t inum, char *dirtypath);
 off_t cache_content_recover_size(char *basepath, u_int64_t inum);
 
 cache_inode_status_t cache_content_error_convert(cache_content_status_t status);
@@ -406,4 +445,36 @@ cache_content_status_t cache_content_test_cached(cache_entry_t * pentry_inode,
                                                  cache_content_status_t * pstatus);
 off_t cache_content_get_cached_size(cache_content_entry_t * pentry);
 
+void cache_content_blocks_release(cache_content_entry_t * pentry);
+
+cache_content_status_t cache_content_blocks_init(cache_content_entry_t * pentry,
+                                                 off_t fetch_limit);
+
+cache_content_status_t cache_content_blocks_recover(cache_content_entry_t * pentry);
+
+cache_content_status_t cache_content_blocks_fetch(cache_content_entry_t * pentry,
+                                                  cache_content_io_direction_t read_or_write,
+                                                  off_t offset,
+                                                  size_t length,
+                                                  fsal_op_context_t * pcontext,
+                                                  cache_content_status_t * pstatus);
+
+cache_content_status_t cache_content_blocks_set_dirty(cache_content_entry_t * pentry,
+                                                      off_t offset, size_t length,
+                                                      cache_content_status_t * pstatus);
+
+cache_content_status_t cache_content_blocks_truncate(cache_content_entry_t * pentry,
+                                                     off_t length,
+                                                     cache_content_status_t * pstatus);
+
+cache_content_status_t cache_content_blocks_flush(cache_content_entry_t * pentry,
+                                                  fsal_op_context_t * pcontext,
+                                                  fsal_size_t * pflushed,
+                                                  cache_content_status_t * pstatus);
+
+fsal_status_t cache_content_flush_dirty_file(fsal_handle_t * pfsal_handle,
+                                             fsal_op_context_t * pcontext,
+                                             char *datapath, char *dirtypath,
+                                             fsal_size_t * pflushed);
+
 #endif                          /* _CACHE_CONTENT_H */
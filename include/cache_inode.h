@@ -93,12 +93,24 @@
 #define CHILDREN_ARRAY_SIZE 16
 #define NB_CHUNCK_READDIR 4     /* Should be equal to FSAL_READDIR_SIZE divided by CHILDREN_ARRAY_SIZE */
 
+/* Write gathering of UNSTABLE writes: pending data are flushed to the FSAL when a file holds
+ * more than CACHE_INODE_UNSTABLE_BUFFERSIZE bytes or CACHE_INODE_UNSTABLE_MAX_EXTENTS extents,
+ * when all the files hold more than CACHE_INODE_UNSTABLE_TOTALSIZE bytes, or when the oldest
+ * pending write of a file is older than CACHE_INODE_UNSTABLE_DELAY seconds. The last two are
+ * handled by the flusher thread, which looks for such files every
+ * CACHE_INODE_UNSTABLE_FLUSHER_PERIOD seconds */
 #define CACHE_INODE_UNSTABLE_BUFFERSIZE 100*1024*1024
+#define CACHE_INODE_UNSTABLE_MAX_EXTENTS 256
+#define CACHE_INODE_UNSTABLE_TOTALSIZE 1024*1024*1024
+#define CACHE_INODE_UNSTABLE_DELAY 30
+#define CACHE_INODE_UNSTABLE_FLUSHSIZE 1024*1024      /* Size and alignment of the flush IOs */
+#define CACHE_INODE_UNSTABLE_FLUSHER_PERIOD 1
 #define DIR_ENTRY_NAMLEN 1024
 
 #define CACHE_INODE_TIME( pentry ) (pentry->internal_md.read_time > pentry->internal_md.mod_time)?pentry->internal_md.read_time:pentry->internal_md.mod_time
 
 #define CONF_LABEL_CACHE_INODE_GCPOL  "CacheInode_GC_Policy"
+#define CONF_LABEL_CACHE_INODE_READAHEAD "CacheInode_Readahead"
 #define CONF_LABEL_CACHE_INODE_CLIENT "CacheInode_Client"
 #define CONF_LABEL_CACHE_INODE_HASH   "CacheInode_Hash"
 
@@ -179,6 +191,8 @@ typedef struct cache_inode_stat__
 {
   unsigned int nb_gc_lru_active;        /**< Number of active entries in Garbagge collecting list */
   unsigned int nb_gc_lru_total;         /**< Total mumber of entries in Garbagge collecting list  */
+  unsigned int nb_negative_hit;         /**< Lookups answered by a negative dirent                */
+  unsigned int nb_negative_miss;        /**< Lookups of an unknown name sent to the FSAL          */
 
   struct func_inode_stats__
   {
@@ -209,6 +223,7 @@ typedef struct cache_inode_client_parameter__
   time_t grace_period_attr;                            /**< Cached attributes grace period                   */
   time_t grace_period_link;                            /**< Cached link grace period                         */
   time_t grace_period_dirent;                          /**< Cached dirent grace period                       */
+  time_t grace_period_negative;                        /**< Negative dirent lifetime, 0 disables them        */
   unsigned int getattr_dir_invalidation;               /**< Use getattr as cookie for directory invalidation */
   unsigned int use_test_access;                        /**< Is FSAL_test_access to be used ?                 */
   unsigned int max_fd_per_thread;                      /**< Max fd open per client                           */
@@ -225,6 +240,75 @@ typedef struct cache_inode_opened_file__
   time_t last_op;
 } cache_inode_opened_file_t;
 
+/* FSAL_read/FSAL_write of these FSALs are positional (pread/pwrite) and may be called
+ * by several threads at once on the same fd: cache_inode_rdwr then does the stable IOs
+ * on an opened file with the entry only read locked. FSAL_PROXY qualifies only when
+ * it uses its pipelined client, this is checked on the fd. */
+#if !defined(_USE_MFSL) && (defined(_USE_GPFS) || defined(_USE_XFS) || defined(_USE_LUSTRE) \
+    || defined(_USE_PROXY) || (defined(_USE_POSIX) && !defined(_FSAL_POSIX_USE_STREAM)))
+#define _USE_SHARED_FSAL_IO
+#endif
+
+typedef struct cache_inode_readahead_param__
+{
+  unsigned int nb_threads;                             /**< Number of readahead threads, 0 disables readahead */
+  fsal_size_t max_memory;                              /**< Memory used by the readahead buffers of all files */
+  fsal_size_t min_window;                              /**< Data read ahead for a stream just detected        */
+  fsal_size_t max_window;                              /**< Maximum data read ahead for a stream              */
+} cache_inode_readahead_param_t;
+
+/* Data are read ahead after this number of sequential reads in a row */
+#define CACHE_INODE_READAHEAD_TRIGGER 2
+
+/* States of a readahead buffer */
+#define CACHE_INODE_READAHEAD_QUEUED     1
+#define CACHE_INODE_READAHEAD_INPROGRESS 2
+#define CACHE_INODE_READAHEAD_READY      3
+#define CACHE_INODE_READAHEAD_FAILED     4
+#define CACHE_INODE_READAHEAD_CANCELLED  5
+
+/* A sequential stream of an entry. Its buffers are all read by the same readahead
+ * thread, through a file descriptor opened by this thread on the first of them and
+ * closed by it once the stream is retired and its buffers are gone. */
+typedef struct cache_inode_readahead_stream__
+{
+  fsal_file_t fd;
+  int opened;                                          /**< TRUE once fd is opened             */
+  int owner;                                           /**< Index of the thread reading it, -1 */
+  unsigned int refcount;                               /**< The entry and the buffers          */
+  struct cache_inode_readahead_stream__ *next_closed;  /**< Next stream to be closed by owner  */
+} cache_inode_readahead_stream_t;
+
+/* A buffer read ahead by the readahead threads. They never use the entry: the
+ * buffer carries the handle and the credentials to read the file with. */
+typedef struct cache_inode_readahead_buffer__
+{
+  cache_inode_readahead_stream_t *stream;
+  fsal_handle_t handle;
+  fsal_export_context_t *export_context;
+  fsal_uid_t uid;
+  fsal_gid_t gid;
+  uint64_t offset;
+  fsal_size_t length;                                  /**< Size to be read                    */
+  fsal_size_t read_size;                               /**< Size actually read                 */
+  fsal_boolean_t eof;
+  int state;
+  caddr_t data;
+  struct cache_inode_readahead_buffer__ *next;         /**< Next buffer of the file            */
+  struct cache_inode_readahead_buffer__ *next_queued;  /**< Next buffer waiting for a thread   */
+} cache_inode_readahead_buffer_t;
+
+/* Access pattern of a file, and its buffers read ahead */
+typedef struct cache_inode_readahead__
+{
+  uint64_t next_offset;                                /**< Offset of the next sequential read */
+  unsigned int nb_sequential;                          /**< Number of sequential reads in a row*/
+  fsal_size_t window;                                  /**< Size of the data to read ahead     */
+  uint64_t ahead_offset;                               /**< End of the data being read ahead   */
+  cache_inode_readahead_buffer_t *buffers;             /**< Sorted by offset                   */
+  cache_inode_readahead_stream_t *stream;              /**< Stream the buffers are read for    */
+} cache_inode_readahead_t;
+
 typedef enum cache_inode_file_type__
 { UNASSIGNED = 1,
   REGULAR_FILE = 2,
@@ -331,13 +415,62 @@ typedef struct cache_inode_layout__
 #endif
 } cache_inode_layout_t;
 
-typedef struct cache_inode_unstable_data__
+/* A range of pending unstable data. The buffer may be larger than the data, so that
+ * sequential writes are appended without reallocating it each time. */
+typedef struct cache_inode_unstable_extent__
 {
-  caddr_t buffer;
   uint64_t offset;
-  uint32_t length;
+  fsal_size_t length;                           /**< Size of the data                   */
+  fsal_size_t size;                             /**< Allocated size of the buffer       */
+  caddr_t buffer;
+  struct cache_inode_unstable_extent__ *next;
+} cache_inode_unstable_extent_t;
+
+typedef struct cache_inode_unstable_data__
+{
+  cache_inode_unstable_extent_t *extents;       /**< Sorted by offset, never overlapping or adjacent */
+  unsigned int nb_extents;
+  fsal_size_t size;                             /**< Memory used by the buffers         */
+  time_t oldest;                                /**< Time of the oldest pending write   */
+  cache_inode_status_t flush_status;            /**< Error of a flush not yet reported  */
+  fsal_export_context_t *export_context;        /**< Credentials of the last write,     */
+  fsal_uid_t uid;                               /**< used by the flusher thread         */
+  fsal_gid_t gid;
+  int flushing;                                 /**< The flusher thread is writing them */
+  struct cache_entry__ *next_dirty;             /**< Entries with pending data, oldest  */
+  struct cache_entry__ *prev_dirty;             /**< first                              */
 } cache_inode_unstable_data_t;
 
+/* Name index of a cached directory: maps the name of a dirent to its slot in
+ * the dir_chain (DIR_BEGINNING + DIR_CONTINUE). A node is only a hint, the
+ * slot is always checked (active and same name) before being used. */
+typedef struct cache_inode_dirent_index_node__
+{
+  unsigned int hashval;                                  /**< Hash of the name of the dirent         */
+  unsigned int slot;                                     /**< Position in the dir_entries array      */
+  struct cache_entry__ *pdir_chain;                      /**< DIR_BEGINNING or DIR_CONTINUE          */
+  struct cache_inode_dirent_index_node__ *next;          /**< Next node in the bucket                */
+} cache_inode_dirent_index_node_t;
+
+typedef struct cache_inode_dirent_index__
+{
+  cache_inode_dirent_index_node_t **buckets;             /**< Array of buckets, NULL if index empty  */
+  unsigned int size;                                     /**< Number of buckets (a power of 2)       */
+  unsigned int nb_entries;                               /**< Number of nodes in the index           */
+} cache_inode_dirent_index_t;
+
+/* Name known not to exist in a directory (the FSAL lookup returned NOT_FOUND).
+ * It is trusted until it expires or an entry with this name is added. */
+#define CACHE_INODE_NEGATIVE_MAX_PER_DIR 256
+
+typedef struct cache_inode_negative_dirent__
+{
+  unsigned int hashval;                                  /**< Hash of the name                       */
+  time_t expire;                                         /**< Epoch time when it is no more trusted  */
+  fsal_name_t name;                                      /**< The missing name                       */
+  struct cache_inode_negative_dirent__ *next;            /**< Next one, most recently used first     */
+} cache_inode_negative_dirent_t;
+
 typedef struct cache_entry__
 {
   union cache_inode_fsobj__
@@ -352,6 +485,7 @@ typedef struct cache_entry__
       fsal_attrib_list_t attributes;                                 /**< The FSAL Attributes                                  */
       void *pentry_content;                                          /**< Entry in file content cache (NULL if not cached)     */
       cache_inode_opened_file_t open_fd;                             /**< Cached fsal_file_t for optimized access              */
+      cache_inode_readahead_t readahead;                             /**< Access pattern and data read ahead                   */
       void *pstate_head;                                             /**< Pointer used for the head of the state chain         */
       void *pstate_tail;                                             /**< Current pointer for the state chain                  */
       cache_inode_unstable_data_t unstable_data;                     /**< Unstable data, for use with WRITE/COMMIT             */
@@ -373,6 +507,9 @@ typedef struct cache_entry__
       unsigned int nbdircont;                   /**< Number of DIR_CONT associated with the DIR_BEGIN        */
       cache_inode_flag_t has_been_readdir;      /**< True if a full readdir was performed on the directory   */
       char *referral;                           /**< NULL is not a referral, is not this a 'referral string' */
+      cache_inode_dirent_index_t name_index;    /**< Index of the names in the whole dir_chain               */
+      cache_inode_negative_dirent_t *negative;  /**< Names known not to exist in the directory               */
+      unsigned int nbnegative;                  /**< Number of negative dirents                              */
 
       struct cache_inode_dir_data__
       {
@@ -506,6 +643,7 @@ typedef struct cache_inode_client__
   time_t grace_period_attr;                                        /**< Cached attributes grace period                           */
   time_t grace_period_link;                                        /**< Cached link grace period                                 */
   time_t grace_period_dirent;                                      /**< Cached directory entries grace period                    */
+  time_t grace_period_negative;                                    /**< Negative directory entries lifetime, 0 disables them     */
   unsigned int use_test_access;                                    /**< Is FSAL_test_access to be used instead of FSAL_access    */
   unsigned int getattr_dir_invalidation;                           /**< Use getattr as cookie for directory invalidation         */
   unsigned int call_since_last_gc;                                 /**< Number of call to cache_inode since the last gc run      */
@@ -785,6 +923,25 @@ cache_entry_t *cache_inode_operate_cached_dirent(cache_entry_t * pentry_parent,
                                                  cache_inode_dirent_op_t dirent_op,
                                                  cache_inode_status_t * pstatus);
 
+void cache_inode_dirent_index_init(cache_entry_t * pdir_begin);
+void cache_inode_dirent_index_release(cache_entry_t * pdir_begin);
+void cache_inode_dirent_index_forget_dircont(cache_entry_t * pdir_cont);
+cache_entry_t *cache_inode_dirent_index_lookup(cache_entry_t * pentry_parent,
+                                               fsal_name_t * pname,
+                                               cache_entry_t ** ppdir_chain,
+                                               unsigned int *pslot);
+
+void cache_inode_negative_dirent_init(cache_entry_t * pdir_begin);
+void cache_inode_negative_dirent_release(cache_entry_t * pdir_begin);
+int cache_inode_negative_dirent_lookup(cache_entry_t * pentry_parent,
+                                       fsal_name_t * pname,
+                                       cache_inode_client_t * pclient);
+void cache_inode_negative_dirent_add(cache_entry_t * pentry_parent,
+                                     fsal_name_t * pname,
+                                     cache_inode_client_t * pclient);
+void cache_inode_negative_dirent_forget(cache_entry_t * pentry_parent,
+                                        fsal_name_t * pname);
+
 cache_inode_status_t cache_inode_remove_cached_dirent(cache_entry_t * pentry_parent,
                                                       fsal_name_t * pname,
                                                       hash_table_t * ht,
@@ -890,6 +1047,36 @@ cache_inode_status_t cache_inode_commit(cache_entry_t * pentry,
                                         fsal_op_context_t * pcontext,
                                         cache_inode_status_t * pstatus);
 
+cache_inode_status_t cache_inode_unstable_add(cache_entry_t * pentry,
+                                              uint64_t offset,
+                                              fsal_size_t size,
+                                              caddr_t buffer,
+                                              fsal_op_context_t * pcontext,
+                                              int *pflush_needed);
+
+cache_inode_status_t cache_inode_unstable_forget(cache_entry_t * pentry,
+                                                 uint64_t offset, fsal_size_t size);
+
+int cache_inode_unstable_read(cache_entry_t * pentry,
+                              uint64_t offset,
+                              fsal_size_t io_size, fsal_size_t * pio_size, caddr_t buffer);
+
+uint64_t cache_inode_unstable_end(cache_entry_t * pentry);
+
+void cache_inode_unstable_filesize(cache_entry_t * pentry);
+
+void cache_inode_unstable_release(cache_entry_t * pentry);
+
+cache_inode_status_t cache_inode_unstable_flush(cache_entry_t * pentry,
+                                                uint64_t offset,
+                                                fsal_size_t count,
+                                                cache_inode_client_t * pclient,
+                                                fsal_op_context_t * pcontext,
+                                                cache_inode_status_t * pstatus);
+
+void cache_inode_unstable_flusher(cache_inode_client_t * pclient,
+                                  fsal_op_context_t * pcontext);
+
 cache_inode_status_t cache_inode_readdir_populate(cache_entry_t * pentry_dir,
                                                   hash_table_t * ht,
                                                   cache_inode_client_t * pclient,
@@ -1007,6 +1194,29 @@ void cache_inode_print_conf_client_parameter(FILE * output,
 
 void cache_inode_print_conf_gc_policy(FILE * output, cache_inode_gc_policy_t gcpolicy);
 
+cache_inode_status_t cache_inode_read_conf_readahead_parameter(config_file_t in_config,
+                                                               cache_inode_readahead_param_t *
+                                                               pparam);
+
+void cache_inode_print_conf_readahead_parameter(FILE * output,
+                                                cache_inode_readahead_param_t param);
+
+int cache_inode_readahead_init(cache_inode_readahead_param_t param);
+
+int cache_inode_readahead_get(cache_entry_t * pentry,
+                              uint64_t offset,
+                              fsal_size_t io_size,
+                              fsal_size_t * pio_size,
+                              caddr_t buffer, fsal_boolean_t * p_fsal_eof);
+
+void cache_inode_readahead_track(cache_entry_t * pentry,
+                                 uint64_t offset,
+                                 fsal_size_t read_size,
+                                 fsal_boolean_t eof,
+                                 int hit, fsal_op_context_t * pcontext);
+
+void cache_inode_readahead_invalidate(cache_entry_t * pentry);
+
 cache_inode_status_t cache_inode_dump_content(char *path, cache_entry_t * pentry);
 
 cache_inode_status_t cache_inode_reload_content(char *path, cache_entry_t * pentry);
@@ -61,6 +61,9 @@ static family_error_t __attribute((__unused__)) tab_errstatus_GHOSTFS[] =
 #define ERR_GHOSTFS_NOTEMPTY   23
   {
   ERR_GHOSTFS_NOTEMPTY, "ERR_GHOSTFS_NOTEMPTY", "Directory is not empty"},
+#define ERR_GHOSTFS_NOSPC   28
+  {
+  ERR_GHOSTFS_NOSPC, "ERR_GHOSTFS_NOSPC", "No space left for file data"},
 #define ERR_GHOSTFS_INTERNAL 1001
   {
   ERR_GHOSTFS_INTERNAL, "ERR_GHOSTFS_INTERNAL", "GhostFS internal error"},
@@ -244,6 +244,8 @@ static const fsal_name_t FSAL_DOT_DOT = { "..", 2 };
 #include "FSAL/FSAL_GPFS/fsal_types.h"
 #elif defined ( _USE_ZFS )
 #include "FSAL/FSAL_ZFS/fsal_types.h"
+#elif defined ( _USE_OBJSTORE )
+#include "FSAL/FSAL_OBJSTORE/fsal_types.h"
 #elif defined ( _USE_TEMPLATE ) /* <- place here your own define */
 #include "FSAL/FSAL_TEMPLATE/fsal_types.h"
 #else                           /* no _USE_<filesystem> flag ! */
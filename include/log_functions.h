@@ -460,6 +460,9 @@ char *ReturnNameFamilyError(int num_family);
 
 void InitLogging();        /* not thread safe */
 
+int StartLogWriter(void);  /* not thread safe */
+void FlushLogWriter(void);
+
 void SetLevelDebug(int level_to_set);    /* not thread safe */
 
 int ReturnLevelAscii(const char *LevelEnAscii);
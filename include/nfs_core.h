@@ -72,6 +72,9 @@
 #include "mount.h"
 #include "nfs_proto_functions.h"
 #include "nfs_dupreq.h"
+#include "nfs_rpc_epoll.h"
+#include "nfs_journal.h"
+#include "nfs_uploader.h"
 #include "err_LRU_List.h"
 #include "err_HashTable.h"
 #include "err_rpc.h"
@@ -94,9 +97,10 @@
 #define NB_MAX_PENDING_REQUEST 30
 #define NB_PREALLOC_LRU_WORKER 100
 #define NB_REQUEST_BEFORE_GC 50
-#define PRIME_DUPREQ 17         /* has to be a prime number */
+#define PRIME_DUPREQ 1021       /* has to be a prime number, buckets per dupreq shard */
 #define PRIME_ID_MAPPER 17      /* has to be a prime number */
 #define DUPREQ_EXPIRATION 180
+#define DUPREQ_MAX_ENTRIES 16384
 #define NB_PREALLOC_HASH_DUPREQ 100
 #define NB_PREALLOC_LRU_DUPREQ 100
 #define NB_PREALLOC_GC_DUPREQ 100
@@ -253,7 +257,9 @@ typedef struct nfs_worker_param__
 
 typedef struct nfs_rpc_dupreq_param__
 {
-  hash_parameter_t hash_param;
+  hash_parameter_t hash_param;  /* index_size is the number of buckets per shard */
+  unsigned int nb_shards;       /* 0 means one shard per online CPU */
+  unsigned int max_entries;     /* bound on the cached replies, all shards together */
 } nfs_rpc_dupreq_parameter_t;
 
 typedef struct nfs_cache_layer_parameter__
@@ -262,6 +268,7 @@ typedef struct nfs_cache_layer_parameter__
   cache_inode_client_parameter_t cache_inode_client_param;
   cache_content_client_parameter_t cache_content_client_param;
   cache_inode_gc_policy_t gcpol;
+  cache_inode_readahead_param_t readahead_param;
   cache_content_gc_policy_t dcgcpol;
 } nfs_cache_layers_parameter_t;
 
@@ -277,6 +284,7 @@ typedef struct nfs_core_param__
   unsigned int nlm_program;
   unsigned int rquota_program;
   unsigned int nb_worker;
+  unsigned int nb_event_thread;
   unsigned int nb_max_concurrent_gc;
   long core_dump_size;
   int nb_max_fd;
@@ -379,6 +387,8 @@ typedef struct nfs_param__
   nfs_cache_layers_parameter_t cache_layers_param;
   fsal_parameter_t fsal_param;
   external_tools_parameter_t extern_param;
+  nfs_journal_parameter_t journal_param;
+  nfs_uploader_parameter_t uploader_param;
 
   /* list of exports declared in config file */
   exportlist_t *pexportlist;
@@ -431,9 +441,26 @@ typedef struct nfs_request_data__
   char cred_area[2 * MAX_AUTH_BYTES + RQCRED_SIZE];
   int status;
   nfs_res_t res_nfs;
+  unsigned int worker_index;    /* worker whose request pool the request comes from */
   struct nfs_request_data__ *next_alloc;
 } nfs_request_data_t;
 
+/* Bounded lock-free queue of pending requests. Any thread can push or pop requests, which
+ * lets an idle worker steal the requests queued to a busy one. */
+typedef struct nfs_request_queue_cell__
+{
+  volatile unsigned int sequence;
+  nfs_request_data_t *preq;
+} nfs_request_queue_cell_t;
+
+typedef struct nfs_request_queue__
+{
+  nfs_request_queue_cell_t *cells;
+  unsigned int mask;
+  volatile unsigned int head;   /* next cell to be popped */
+  volatile unsigned int tail;   /* next cell to be pushed */
+} nfs_request_queue_t;
+
 typedef struct nfs_client_id__
 {
   char client_name[MAXNAMLEN];
@@ -464,7 +491,7 @@ typedef enum idmap_type__
 typedef struct nfs_worker_data__
 {
   int index;
-  LRU_list_t *pending_request;
+  nfs_request_queue_t request_queue;
   LRU_list_t *duplicate_request;
   nfs_request_data_t *request_pool;
   dupreq_entry_t *dupreq_pool;
@@ -476,9 +503,10 @@ typedef struct nfs_worker_data__
   hash_table_t *ht_ip_stats;
   pthread_mutex_t request_pool_mutex;
 
-  /* Used for blocking when request queue is empty. */
+  /* Used for blocking when there is no request to process, or steal. */
   pthread_cond_t req_condvar;
   pthread_mutex_t mutex_req_condvar;
+  volatile unsigned int sleeping;
 
   /* Used for blocking when the export list is being replaced. */
   bool_t waiting_for_exports;
@@ -523,11 +551,32 @@ typedef struct nfs_flush_thread_data__
  */
 void *worker_thread(void *IndexArg);
 void *rpc_dispatcher_thread(void *arg);
+int nfs_rpc_getreq_xprt(SVCXPRT * xprt, int sock);
+int nfs_rpc_get_worker_index(int mount_protocol_flag);
+
+int nfs_request_queue_init(nfs_request_queue_t * pqueue, unsigned int size);
+int nfs_request_queue_push(nfs_request_queue_t * pqueue, nfs_request_data_t * preq);
+nfs_request_data_t *nfs_request_queue_pop(nfs_request_queue_t * pqueue);
+unsigned int nfs_request_queue_length(nfs_request_queue_t * pqueue);
+int nfs_rpc_queue_init(void);
+void nfs_rpc_queue_request(nfs_request_data_t * preq, int mount_protocol_flag);
+nfs_request_data_t *nfs_rpc_dequeue_request(nfs_worker_data_t * pworker);
+int nfs_rpc_request_available(nfs_worker_data_t * pworker);
+void nfs_rpc_worker_sleep(nfs_worker_data_t * pworker);
+void nfs_rpc_release_request(nfs_request_data_t * preq);
+#ifdef _USE_EPOLL
+int nfs_rpc_epoll_init(void);
+int nfs_rpc_epoll_add(int sock);
+void nfs_rpc_epoll_release(SVCXPRT * xprt);
+void rpc_epoll_svc_run(nfs_parameter_t * pnfs_param);
+int Xprt_fill_record(SVCXPRT * xprt);
+#endif
 void *admin_thread(void *arg);
 void *stats_thread(void *IndexArg);
 int stats_snmp(nfs_worker_data_t * workers_data_local);
 void *file_content_gc_thread(void *IndexArg);
 void *nfs_file_content_flush_thread(void *flush_data_arg);
+void *unstable_flush_thread(void *IndexArg);
 
 int nfs_Init_svc(void);
 int nfs_Init_admin_data(nfs_admin_data_t * pdata);
@@ -574,10 +623,6 @@ int display_xid(hash_buffer_t * pbuff, char *str);
 int compare_xid(hash_buffer_t * buff1, hash_buffer_t * buff2);
 
 int print_entry_dupreq(LRU_data_t data, char *str);
-int clean_entry_dupreq(LRU_entry_t * pentry, void *addparam);
-
-int clean_pending_request(LRU_entry_t * pentry, void *addparam);
-int print_pending_request(LRU_data_t data, char *str);
 
 #ifdef _USE_GSSRPC
 int log_sperror_gss(char *outmsg, char *tag, OM_uint32 maj_stat, OM_uint32 min_stat);
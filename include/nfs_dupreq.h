@@ -56,6 +56,8 @@ typedef unsigned long u_long;
 #endif
 #endif                          /* _SOLARIS */
 
+#include <pthread.h>
+
 #include "HashData.h"
 #include "HashTable.h"
 #include "nfs_core.h"
@@ -64,23 +66,55 @@ typedef unsigned long u_long;
 #include "fsal.h"
 #include "nfs_tools.h"
 
-typedef struct dupreq_entry__
+/* Number of trailing bytes of the call checksummed into the key */
+#define DUPREQ_CHECKSUM_LEN 256
+
+/* Maximum number of expired entries reclaimed by a single insertion */
+#define DUPREQ_EVICT_BATCH 8
+
+/* Upper bound for the automatic number of shards */
+#define DUPREQ_MAX_SHARDS 64
+
+typedef struct dupreq_key__
 {
   long xid;
-  nfs_res_t res_nfs;
   u_long rq_prog;               /* service program number        */
   u_long rq_vers;               /* service protocol version      */
   u_long rq_proc;
+  unsigned short family;        /* caller's address family       */
+  unsigned short port;          /* caller's port (network order) */
+  unsigned char addr[16];       /* caller's IPv4 or IPv6 address */
+  unsigned int checksum;        /* checksum of the call's tail, 0 if not available */
+} dupreq_key_t;
+
+typedef struct dupreq_entry__
+{
+  dupreq_key_t key;
+  unsigned long hash;           /* dupreq_rbt_hash_func of the key */
+  nfs_res_t res_nfs;
   time_t timestamp;
+  struct dupreq_entry__ *hash_next;     /* next entry in the same bucket      */
+  struct dupreq_entry__ *lru_prev;      /* older entry in the shard           */
+  struct dupreq_entry__ *lru_next;      /* more recent entry in the shard     */
   struct dupreq_entry__ *next_alloc;
 } dupreq_entry_t;
 
+typedef struct dupreq_shard__
+{
+  pthread_mutex_t lock;
+  dupreq_entry_t **buckets;     /* hash_param.index_size chains             */
+  dupreq_entry_t *lru_head;     /* oldest entry, first one to be evicted    */
+  dupreq_entry_t *lru_tail;     /* most recently added or hit entry         */
+  unsigned int nb_entries;
+  unsigned int max_entries;
+  hash_stat_dynamic_t stat;
+} dupreq_shard_t;
+
 unsigned int get_rpc_xid(struct svc_req *reqp);
 
 int compare_xid(hash_buffer_t * buff1, hash_buffer_t * buff2);
+int display_xid(hash_buffer_t * pbuff, char *str);
 int print_entry_dupreq(LRU_data_t data, char *str);
-int clean_entry_dupreq(LRU_entry_t * pentry, void *addparam);
-int nfs_dupreq_gc_function(LRU_entry_t * pentry, void *addparam);
 
 nfs_res_t nfs_dupreq_get(long xid, int *pstatus);
 
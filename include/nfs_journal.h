@@ -0,0 +1,114 @@
+/*
+ *
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_journal.h
+ * \brief   Write-behind journal of the modifications made by the NFS clients.
+ *
+ * nfs_journal.h : Write-behind journal of the modifications made by the NFS clients.
+ *
+ * The workers queue the WRITE and REMOVE operations in a per worker ring. A dedicated
+ * writer thread appends them to segmented log files (<Directory>/journal.<number>),
+ * a batch at a time with a single writev and fsync. The journal is read back by the
+ * cloud uploader.
+ *
+ * A segment is a sequence of records. Each record is a nfs_journal_record_t header, followed
+ * by path_length bytes of path (not nul terminated) and length bytes of data. The checksum
+ * is the Adler-32 of the header (with checksum set to 0), the path and the data.
+ * All the fields are in host byte order.
+ *
+ */
+
+#ifndef _NFS_JOURNAL_H
+#define _NFS_JOURNAL_H
+
+#include <stdint.h>
+#include <sys/param.h>
+#include "fsal.h"
+#include "cache_inode.h"
+#include "config_parsing.h"
+
+#define CONF_LABEL_NFS_JOURNAL "NFS_Journal"
+
+#define NFS_JOURNAL_MAGIC  0x4a4e4c31   /* "JNL1" */
+
+/* Record types */
+#define NFS_JOURNAL_WRITE  1
+#define NFS_JOURNAL_REMOVE 2
+
+/* Segment file names */
+#define NFS_JOURNAL_SEGMENT_PREFIX "journal."
+#define NFS_JOURNAL_SEGMENT_FORMAT "%s/journal.%08u"
+#define NFS_JOURNAL_SEGMENT_NAME_MAX 20 /* "/journal." and up to 10 digits */
+
+/* Default values */
+#define NFS_JOURNAL_DIRECTORY_DEFAULT    "/tmp/intercept"
+#define NFS_JOURNAL_SEGMENT_SIZE_DEFAULT (64 * 1024 * 1024)
+#define NFS_JOURNAL_RING_SIZE_DEFAULT    1024
+#define NFS_JOURNAL_PATH_CACHE_DEFAULT   4099
+
+/* Max number of records written by a single writev */
+#define NFS_JOURNAL_MAX_BATCH 256
+
+typedef struct nfs_journal_record__
+{
+  uint32_t magic;               /* NFS_JOURNAL_MAGIC */
+  uint32_t type;                /* NFS_JOURNAL_WRITE or NFS_JOURNAL_REMOVE */
+  uint64_t fileid;
+  uint64_t offset;
+  uint32_t length;              /* length of the data, following the path */
+  uint32_t path_length;         /* length of the path, following the header */
+  uint32_t checksum;
+  uint32_t padding;
+} nfs_journal_record_t;
+
+typedef struct nfs_journal_parameter__
+{
+  int enable;
+  char directory[MAXPATHLEN];
+  unsigned int segment_size;    /* a new segment is started beyond this size */
+  unsigned int ring_size;       /* records queued per worker before it waits for the writer */
+  unsigned int path_cache_size; /* slots of the handle to path cache */
+  int sync;                     /* fsync each batch */
+} nfs_journal_parameter_t;
+
+int nfs_read_journal_conf(config_file_t in_config, nfs_journal_parameter_t * pparam);
+
+int nfs_journal_init(nfs_journal_parameter_t * pparam, unsigned int nb_worker);
+void *nfs_journal_thread(void *Arg);
+
+int nfs_journal_write(cache_inode_client_t * pclient,
+                      fsal_op_context_t * pcontext,
+                      fsal_handle_t * phandle,
+                      uint64_t fileid, uint64_t offset, uint32_t length, caddr_t data);
+int nfs_journal_remove(cache_inode_client_t * pclient,
+                       fsal_op_context_t * pcontext,
+                       fsal_handle_t * phandle, uint64_t fileid);
+void nfs_journal_path_invalidate_all(void);
+
+uint32_t nfs_journal_adler32(uint32_t adler, const unsigned char *buf, size_t len);
+ssize_t nfs_journal_parse_record(caddr_t buffer, size_t size, nfs_journal_record_t * precord);
+
+#endif                          /* _NFS_JOURNAL_H */
@@ -0,0 +1,105 @@
+/*
+ *
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_rpc_epoll.h
+ * \brief   Definitions for the epoll based management of the RPC sockets.
+ *
+ * nfs_rpc_epoll.h : Definitions for the epoll based management of the RPC sockets.
+ *
+ * With epoll, a small set of event threads wait for the sockets to be readable,
+ * receive the requests and spool them to the workers. This replaces the select()
+ * of the dispatcher (limited to FD_SETSIZE sockets) and the per connection
+ * TCP socket manager threads.
+ *
+ */
+
+#ifndef _NFS_RPC_EPOLL_H
+#define _NFS_RPC_EPOLL_H
+
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <sys/select.h>
+
+/* epoll is Linux specific, and the gssrpc transports are not handled */
+#if defined( _LINUX ) && !defined( _USE_GSSRPC ) && !defined( _NO_EPOLL )
+#define _USE_EPOLL
+#endif
+
+/* Size of the Xports table, which is indexed by the sockets */
+#ifdef _USE_EPOLL
+#define XPRT_TABLE_SIZE 65536
+#else
+#define XPRT_TABLE_SIZE FD_SETSIZE
+#endif
+
+#define NB_EVENT_THREAD_DEFAULT 2
+#define NB_MAX_EVENT_THREAD     32
+
+/* Number of events got by a single epoll_wait */
+#define NB_EPOLL_EVENTS 64
+
+/* Status of a transport after a request was got from it */
+#define NFS_RPC_XPRT_IDLE 0     /* can be watched again */
+#define NFS_RPC_XPRT_BUSY 1     /* a request is being processed, the worker will release it */
+#define NFS_RPC_XPRT_DEAD 2     /* the client disappeared, the transport is destroyed */
+
+/* Initial and maximum sizes of the record buffer of a connection */
+#define NFS_RPC_RECORD_INIT_SIZE 65536
+#define NFS_RPC_RECORD_MAX_SIZE  (4 * 1024 * 1024)
+
+/* Status of a connection after its socket was read */
+#define NFS_RPC_RECORD_READY   0        /* a complete record is buffered */
+#define NFS_RPC_RECORD_PARTIAL 1        /* the socket must be watched again */
+#define NFS_RPC_RECORD_DEAD    2        /* the client disappeared (or sent a record too large) */
+
+/**
+ * The data received on a connected TCP socket.
+ *
+ * The sockets of the clients are non blocking: the event threads read them into
+ * this buffer, and the record stream of the transport is only fed with complete
+ * records, so that getting a request never waits for the client.
+ */
+typedef struct nfs_rpc_record_buffer__
+{
+  char *buff;
+  unsigned int size;            /* allocated size */
+  unsigned int len;             /* bytes received */
+  unsigned int pos;             /* bytes handed to the record stream */
+  unsigned int ready;           /* end of the last complete record */
+  unsigned int frag;            /* next fragment header to be checked */
+} nfs_rpc_record_buffer_t;
+
+#define nfs_rpc_record_pending( prec ) ( (prec)->ready > (prec)->pos )
+
+#ifdef _USE_EPOLL
+int nfs_rpc_record_fill(int sock, nfs_rpc_record_buffer_t * prec);
+int nfs_rpc_record_read(nfs_rpc_record_buffer_t * prec, char *buf, int len);
+void nfs_rpc_record_free(nfs_rpc_record_buffer_t * prec);
+#endif
+
+#endif                          /* _NFS_RPC_EPOLL_H */
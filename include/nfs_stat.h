@@ -108,11 +108,30 @@ typedef enum nfs_stat_type__
 /* we support only upto NLMPROC4_UNLOCK */
 #define NLM_V4_NB_OPERATION 5
 
+/* Log-linear latency histograms (in microseconds): values below NFS_LATENCY_SUB_COUNT
+ * have their own bucket, then each power of two is split in NFS_LATENCY_SUB_COUNT
+ * linear buckets, which bounds the relative error to 1/NFS_LATENCY_SUB_COUNT */
+#define NFS_LATENCY_SUB_BITS 3
+#define NFS_LATENCY_SUB_COUNT (1 << NFS_LATENCY_SUB_BITS)
+#define NFS_LATENCY_NB_BUCKETS ((32 - NFS_LATENCY_SUB_BITS + 1) * NFS_LATENCY_SUB_COUNT)
+
+/* Percentiles reported by the stats thread and the SNMP interface, in per mille */
+#define NFS_LATENCY_NB_PERCENTILES 4
+extern unsigned int nfs_latency_percentiles[NFS_LATENCY_NB_PERCENTILES];
+extern char *nfs_latency_percentile_names[NFS_LATENCY_NB_PERCENTILES];
+
+typedef struct nfs_latency_histogram__
+{
+  unsigned int count;
+  unsigned int bucket[NFS_LATENCY_NB_BUCKETS];
+} nfs_latency_histogram_t;
+
 typedef struct nfs_op_stat_item__
 {
   unsigned int total;
   unsigned int success;
   unsigned int failed;
+  nfs_latency_histogram_t latency_histogram;
 } nfs_op_stat_item_t;
 
 typedef struct nfs_request_stat_item__
@@ -123,6 +142,7 @@ typedef struct nfs_request_stat_item__
   unsigned int tot_latency;
   unsigned int min_latency;
   unsigned int max_latency;
+  nfs_latency_histogram_t latency_histogram;
 } nfs_request_stat_item_t;
 
 typedef struct nfs_request_stat__
@@ -158,4 +178,10 @@ void nfs_stat_update(nfs_stat_type_t type,
                      nfs_request_stat_t * pstat_req, struct svc_req *preq,
                      nfs_request_latency_stat_t * lstat_req);
 
+void nfs_latency_histogram_update(nfs_latency_histogram_t * phist, unsigned int latency);
+void nfs_latency_histogram_merge(nfs_latency_histogram_t * pdest,
+                                 nfs_latency_histogram_t * psrc);
+unsigned int nfs_latency_histogram_percentile(nfs_latency_histogram_t * phist,
+                                              unsigned int per_mille);
+
 #endif                          /* _NFS_STAT_H */
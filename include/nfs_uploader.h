@@ -0,0 +1,108 @@
+/*
+ *
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_uploader.h
+ * \brief   Upload of the journal to an object store.
+ *
+ * nfs_uploader.h : Upload of the journal to an object store.
+ *
+ * The uploader reads back the segments of the journal (see nfs_journal.h) and mirrors the
+ * modified files to a bucket of an object store speaking the S3 REST protocol (path style
+ * requests: /<bucket>/<path of the file>). The records of a segment are coalesced per file,
+ * so that each modified file is uploaded once per segment, by a pool of connections.
+ * Files larger than Part_Size are sent by a multipart upload, whose parts are sent in
+ * parallel. A failed request is retried, with a growing delay.
+ *
+ */
+
+#ifndef _NFS_UPLOADER_H
+#define _NFS_UPLOADER_H
+
+#include <stdint.h>
+#include <sys/param.h>
+#include <netdb.h>              /* for having MAXHOSTNAMELEN */
+#include "config_parsing.h"
+#include "BuddyMalloc.h"
+
+#define CONF_LABEL_NFS_UPLOADER "NFS_Uploader"
+
+/* Progress of the uploader, in the journal directory */
+#define NFS_UPLOADER_STATE_FILE "uploader.state"
+
+/* Default values */
+#define NFS_UPLOADER_HOST_DEFAULT           "127.0.0.1"
+#define NFS_UPLOADER_PORT_DEFAULT           80
+#define NFS_UPLOADER_BUCKET_DEFAULT         "ganesha"
+#define NFS_UPLOADER_NB_CONNECTIONS_DEFAULT 8
+#define NFS_UPLOADER_PART_SIZE_DEFAULT      (8 * 1024 * 1024)
+#define NFS_UPLOADER_MAX_RETRIES_DEFAULT    5
+#define NFS_UPLOADER_RETRY_DELAY_DEFAULT    1
+#define NFS_UPLOADER_SCAN_PERIOD_DEFAULT    5
+#define NFS_UPLOADER_TIMEOUT_DEFAULT        60
+
+/* The smallest part accepted by S3 (but for the last one) */
+#define NFS_UPLOADER_PART_SIZE_MIN (5 * 1024 * 1024)
+
+#define NFS_UPLOADER_AUTHORIZATION_LEN 1024
+
+typedef struct nfs_uploader_parameter__
+{
+  int enable;
+  char host[MAXHOSTNAMELEN];
+  unsigned short port;
+  char bucket[MAXNAMLEN];
+  char authorization[NFS_UPLOADER_AUTHORIZATION_LEN];   /* sent as is in an Authorization header (e.g. an OAuth2 "Bearer <token>"), if not empty */
+  unsigned int nb_connections;  /* number of requests in flight */
+  unsigned int part_size;       /* larger files are sent by a multipart upload */
+  unsigned int max_retries;
+  unsigned int retry_delay;     /* in seconds, doubled at each retry */
+  unsigned int scan_period;     /* in seconds, between two scans of an idle journal */
+  unsigned int timeout;         /* in seconds, for a send or a receive */
+} nfs_uploader_parameter_t;
+
+typedef struct nfs_uploader_stat__
+{
+  unsigned long long nb_records;
+  unsigned long long nb_files;
+  unsigned long long nb_puts;
+  unsigned long long nb_parts;
+  unsigned long long nb_deletes;
+  unsigned long long nb_gets;
+  unsigned long long nb_retries;
+  unsigned long long nb_failures;
+  unsigned long long nb_bytes;
+} nfs_uploader_stat_t;
+
+int nfs_read_uploader_conf(config_file_t in_config, nfs_uploader_parameter_t * pparam);
+
+int nfs_uploader_init(nfs_uploader_parameter_t * pparam,
+                      char *journal_directory, buddy_parameter_t * pbuddy_param);
+int nfs_uploader_start(void);
+int nfs_uploader_run(void);
+void *nfs_uploader_thread(void *Arg);
+void nfs_uploader_get_stats(nfs_uploader_stat_t * pstat);
+
+#endif                          /* _NFS_UPLOADER_H */
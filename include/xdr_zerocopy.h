@@ -0,0 +1,75 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    xdr_zerocopy.h
+ * \brief   Encoding of opaque data by reference.
+ *
+ * xdr_zerocopy.h : Encoding of opaque data by reference.
+ *
+ * A transport that can send a reply as several pieces (with writev) declares
+ * its encoding stream with xdr_zerocopy_begin. The opaque data encoded by
+ * xdr_bytes_zerocopy on this stream are then not copied: only their length
+ * goes in the stream, and the transport inserts the data (and their XDR
+ * padding) at the recorded positions when it sends the reply.
+ *
+ */
+
+#ifndef _XDR_ZEROCOPY_H
+#define _XDR_ZEROCOPY_H
+
+#ifdef _USE_GSSRPC
+#include <gssrpc/types.h>
+#include <gssrpc/rpc.h>
+#else
+#include <rpc/types.h>
+#include <rpc/rpc.h>
+#endif
+
+/* Maximum number of opaque data referenced by a single reply */
+#define XDR_ZEROCOPY_MAX_SEGMENTS 16
+
+/* Smaller opaque data are copied in the stream as usual */
+#define XDR_ZEROCOPY_MIN_SIZE     1024
+
+typedef struct xdr_zerocopy_segment__
+{
+  u_int offset;                 /* position in the stream where the data go */
+  caddr_t data;
+  u_int len;                    /* length of the data, without padding      */
+} xdr_zerocopy_segment_t;
+
+typedef struct xdr_zerocopy__
+{
+  XDR *xdrs;                    /* stream encoding the reply */
+  unsigned int nb_segments;
+  xdr_zerocopy_segment_t segments[XDR_ZEROCOPY_MAX_SEGMENTS];
+} xdr_zerocopy_t;
+
+void xdr_zerocopy_begin(xdr_zerocopy_t * pzerocopy, XDR * xdrs);
+void xdr_zerocopy_end(void);
+bool_t xdr_bytes_zerocopy(XDR * xdrs, char **cpp, u_int * sizep, u_int maxsize);
+
+#endif                          /* _XDR_ZEROCOPY_H */
@@ -0,0 +1,794 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_journal.c
+ * \brief   The write-behind journal of the modifications made by the NFS clients.
+ *
+ * nfs_journal.c : The write-behind journal of the modifications made by the NFS clients.
+ *
+ * Each worker owns a ring of records (one producer, the worker, and one consumer, the
+ * journal thread). A record is built in a single buffer (header, path and a copy of the data,
+ * as the request buffers are reused once the reply is sent), so that a batch of records is
+ * appended to the current segment by a single writev, then made stable by a single fsync.
+ *
+ * The path of a file is got from its handle through the FSAL (a database lookup with
+ * FSAL_POSIX). It is kept in a direct mapped cache indexed by the handle. A rename may change
+ * the path of many files: it makes the whole cache obsolete by bumping its generation.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <sched.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <limits.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include "HashData.h"
+#include "HashTable.h"
+
+#ifdef _USE_GSSRPC
+#include <gssrpc/rpc.h>
+#include <gssrpc/svc.h>
+#include <gssrpc/pmap_clnt.h>
+#else
+#include <rpc/rpc.h>
+#include <rpc/svc.h>
+#include <rpc/pmap_clnt.h>
+#endif
+
+#include "log_macros.h"
+#include "stuff_alloc.h"
+#include "nfs_core.h"
+#include "nfs_journal.h"
+
+/* Used for polynomial hashing of the handles in the path cache */
+#define NFS_JOURNAL_PATH_ALPHABET_LEN 10
+
+/* A queued record, written as is (header, path, then data) */
+typedef struct nfs_journal_entry__
+{
+  nfs_journal_record_t record;
+  char payload[1];
+} nfs_journal_entry_t;
+
+#define NFS_JOURNAL_ENTRY_SIZE( path_len, data_len ) \
+  ( sizeof( nfs_journal_record_t ) + (path_len) + (data_len) )
+
+/* Ring between a worker and the journal thread */
+typedef struct nfs_journal_ring__
+{
+  nfs_journal_entry_t **entries;
+  unsigned int mask;
+  volatile unsigned int head;   /* next entry to be written, moved by the journal thread */
+  volatile unsigned int tail;   /* next entry to be queued, moved by the worker */
+} nfs_journal_ring_t;
+
+/* Slot of the handle to path cache */
+typedef struct nfs_journal_path_slot__
+{
+  pthread_mutex_t lock;
+  int valid;
+  unsigned int generation;
+  fsal_handle_t handle;
+  unsigned int path_length;
+  char *path;
+} nfs_journal_path_slot_t;
+
+typedef struct nfs_journal_stat__
+{
+  unsigned long long nb_records;
+  unsigned long long nb_bytes;
+  unsigned long long nb_batches;
+  unsigned long long nb_sync;
+  unsigned long long nb_ring_full;
+  unsigned long long nb_path_cache_hit;
+  unsigned long long nb_path_cache_miss;
+} nfs_journal_stat_t;
+
+extern nfs_parameter_t nfs_param;
+
+static nfs_journal_parameter_t journal_param;
+static nfs_journal_ring_t *journal_rings = NULL;
+static unsigned int journal_nb_rings = 0;
+
+static nfs_journal_path_slot_t *journal_path_cache = NULL;
+static volatile unsigned int journal_path_generation = 0;
+
+/* The journal thread sleeps on this condition when all the rings are empty */
+static pthread_mutex_t journal_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t journal_condvar = PTHREAD_COND_INITIALIZER;
+static volatile unsigned int journal_sleeping = FALSE;
+
+/* Current segment (managed by the journal thread only) */
+static int journal_fd = -1;
+static unsigned int journal_segment = 0;
+static unsigned long long journal_segment_offset = 0;
+
+static nfs_journal_stat_t journal_stat;
+
+/**
+ * nfs_journal_open_segment: opens the next segment of the journal.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_journal_open_segment(void)
+{
+  char segment_path[MAXPATHLEN];
+
+  journal_segment += 1;
+  if(snprintf(segment_path, MAXPATHLEN, NFS_JOURNAL_SEGMENT_FORMAT,
+              journal_param.directory, journal_segment) >= MAXPATHLEN)
+    {
+      LogCrit(COMPONENT_MAIN, "NFS JOURNAL: path of segment %u is too long",
+              journal_segment);
+      return -1;
+    }
+
+  if((journal_fd = open(segment_path, O_CREAT | O_WRONLY | O_APPEND, S_IRUSR | S_IWUSR)) < 0)
+    {
+      LogCrit(COMPONENT_MAIN, "NFS JOURNAL: can't open segment %s, errno=%d",
+              segment_path, errno);
+      return -1;
+    }
+
+  journal_segment_offset = 0;
+
+  LogEvent(COMPONENT_MAIN, "NFS JOURNAL: now writing to segment %s", segment_path);
+
+  return 0;
+}                               /* nfs_journal_open_segment */
+
+/**
+ * nfs_journal_close_segment: makes the current segment stable and closes it.
+ *
+ * Once closed, a segment is never written again and can be processed by the uploader.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_journal_close_segment(void)
+{
+  if(journal_fd < 0)
+    return;
+
+  if(fsync(journal_fd) != 0)
+    LogCrit(COMPONENT_MAIN, "NFS JOURNAL: fsync of segment #%u failed, errno=%d",
+            journal_segment, errno);
+
+  close(journal_fd);
+  journal_fd = -1;
+
+  LogDebug(COMPONENT_MAIN,
+           "NFS JOURNAL: segment #%u closed, records=%llu bytes=%llu batches=%llu ring_full=%llu path_cache hit=%llu miss=%llu",
+           journal_segment, journal_stat.nb_records, journal_stat.nb_bytes,
+           journal_stat.nb_batches, journal_stat.nb_ring_full,
+           journal_stat.nb_path_cache_hit, journal_stat.nb_path_cache_miss);
+}                               /* nfs_journal_close_segment */
+
+/**
+ * nfs_journal_init: initializes the journal.
+ *
+ * Creates the rings and the path cache, and finds the number of the last segment already
+ * in the journal directory, so that a restarted server never appends to an old segment.
+ *
+ * @param pparam the journal parameters.
+ * @param nb_worker the number of workers (one ring per worker).
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_journal_init(nfs_journal_parameter_t * pparam, unsigned int nb_worker)
+{
+  unsigned int ring_size = 1;
+  unsigned int segment;
+  unsigned int i;
+  struct dirent *dirent;
+  DIR *dir;
+
+  journal_param = *pparam;
+  memset(&journal_stat, 0, sizeof(journal_stat));
+
+  if(!journal_param.enable)
+    return 0;
+
+  if(mkdir(journal_param.directory, S_IRWXU) != 0 && errno != EEXIST)
+    {
+      LogCrit(COMPONENT_INIT, "NFS JOURNAL: can't create directory %s, errno=%d",
+              journal_param.directory, errno);
+      return -1;
+    }
+
+  if((dir = opendir(journal_param.directory)) == NULL)
+    {
+      LogCrit(COMPONENT_INIT, "NFS JOURNAL: can't open directory %s, errno=%d",
+              journal_param.directory, errno);
+      return -1;
+    }
+
+  journal_segment = 0;
+  while((dirent = readdir(dir)) != NULL)
+    if(sscanf(dirent->d_name, NFS_JOURNAL_SEGMENT_PREFIX "%u", &segment) == 1
+       && segment > journal_segment)
+      journal_segment = segment;
+  closedir(dir);
+
+  /* Rings */
+  while(ring_size < journal_param.ring_size)
+    ring_size <<= 1;
+
+  if((journal_rings =
+      (nfs_journal_ring_t *) Mem_Alloc(nb_worker * sizeof(nfs_journal_ring_t))) == NULL)
+    return -1;
+
+  for(i = 0; i < nb_worker; i++)
+    {
+      if((journal_rings[i].entries =
+          (nfs_journal_entry_t **) Mem_Alloc(ring_size * sizeof(nfs_journal_entry_t *))) ==
+         NULL)
+        return -1;
+
+      journal_rings[i].mask = ring_size - 1;
+      journal_rings[i].head = 0;
+      journal_rings[i].tail = 0;
+    }
+  journal_nb_rings = nb_worker;
+
+  /* Path cache */
+  if((journal_path_cache =
+      (nfs_journal_path_slot_t *) Mem_Alloc(journal_param.path_cache_size *
+                                            sizeof(nfs_journal_path_slot_t))) == NULL)
+    return -1;
+
+  for(i = 0; i < journal_param.path_cache_size; i++)
+    {
+      if(pthread_mutex_init(&journal_path_cache[i].lock, NULL) != 0)
+        return -1;
+
+      journal_path_cache[i].valid = FALSE;
+      journal_path_cache[i].path = NULL;
+      journal_path_cache[i].path_length = 0;
+    }
+
+  LogEvent(COMPONENT_INIT,
+           "NFS JOURNAL: journal in %s, last segment #%u, %u rings of %u records",
+           journal_param.directory, journal_segment, nb_worker, ring_size);
+
+  return 0;
+}                               /* nfs_journal_init */
+
+/**
+ * nfs_journal_path_slot: gets the slot of the path cache for a handle.
+ *
+ * @param phandle the handle.
+ *
+ * @return the slot.
+ *
+ */
+static nfs_journal_path_slot_t *nfs_journal_path_slot(fsal_handle_t * phandle)
+{
+  return &journal_path_cache[FSAL_Handle_to_HashIndex(phandle, 0,
+                                                      NFS_JOURNAL_PATH_ALPHABET_LEN,
+                                                      journal_param.path_cache_size)];
+}                               /* nfs_journal_path_slot */
+
+/**
+ * nfs_journal_get_path: gets the path of an object, from the cache or from the FSAL.
+ *
+ * @param pcontext the FSAL context of the caller.
+ * @param phandle the handle of the object.
+ * @param ppath [OUT] the path.
+ *
+ * @return the length of the path, 0 if it could not be found.
+ *
+ */
+static unsigned int nfs_journal_get_path(fsal_op_context_t * pcontext,
+                                         fsal_handle_t * phandle, fsal_path_t * ppath)
+{
+  nfs_journal_path_slot_t *pslot = nfs_journal_path_slot(phandle);
+  unsigned int generation = journal_path_generation;
+  unsigned int path_length = 0;
+  fsal_status_t fsal_status;
+  struct stat buffstat;
+
+  P(pslot->lock);
+  if(pslot->valid && pslot->generation == generation
+     && !FSAL_handlecmp(&pslot->handle, phandle, &fsal_status))
+    {
+      path_length = pslot->path_length;
+      memcpy(ppath->path, pslot->path, path_length);
+    }
+  V(pslot->lock);
+
+  if(path_length != 0)
+    {
+      __sync_fetch_and_add(&journal_stat.nb_path_cache_hit, 1);
+      return path_length;
+    }
+
+  __sync_fetch_and_add(&journal_stat.nb_path_cache_miss, 1);
+
+  fsal_status = FSAL_getPathFromHandle(pcontext, phandle, 0, ppath, &buffstat);
+  if(FSAL_IS_ERROR(fsal_status))
+    {
+      LogMajor(COMPONENT_MAIN, "NFS JOURNAL: can't get the path of an object, error=(%d,%d)",
+               fsal_status.major, fsal_status.minor);
+      return 0;
+    }
+
+  path_length = strnlen(ppath->path, FSAL_MAX_PATH_LEN);
+
+  /* Cache it, unless a rename happened meanwhile */
+  P(pslot->lock);
+  if(journal_path_generation == generation)
+    {
+      if(pslot->path_length < path_length)
+        {
+          if(pslot->path != NULL)
+            Mem_Free(pslot->path);
+          pslot->path = (char *)Mem_Alloc(path_length);
+        }
+
+      if(pslot->path != NULL)
+        {
+          memcpy(pslot->path, ppath->path, path_length);
+          pslot->path_length = path_length;
+          pslot->handle = *phandle;
+          pslot->generation = generation;
+          pslot->valid = TRUE;
+        }
+      else
+        {
+          pslot->path_length = 0;
+          pslot->valid = FALSE;
+        }
+    }
+  V(pslot->lock);
+
+  return path_length;
+}                               /* nfs_journal_get_path */
+
+/**
+ * nfs_journal_path_invalidate: removes an object from the path cache.
+ *
+ * @param phandle the handle of the object.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_journal_path_invalidate(fsal_handle_t * phandle)
+{
+  nfs_journal_path_slot_t *pslot = nfs_journal_path_slot(phandle);
+  fsal_status_t fsal_status;
+
+  P(pslot->lock);
+  if(pslot->valid && !FSAL_handlecmp(&pslot->handle, phandle, &fsal_status))
+    pslot->valid = FALSE;
+  V(pslot->lock);
+}                               /* nfs_journal_path_invalidate */
+
+/**
+ * nfs_journal_path_invalidate_all: makes all the cached paths obsolete.
+ *
+ * To be called when an object is renamed: the paths of all the objects below it change.
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_journal_path_invalidate_all(void)
+{
+  if(!journal_param.enable)
+    return;
+
+  __sync_fetch_and_add(&journal_path_generation, 1);
+}                               /* nfs_journal_path_invalidate_all */
+
+/**
+ * nfs_journal_queue: queues a record to the ring of a worker.
+ *
+ * When the ring is full, the worker waits for the journal thread to catch up.
+ *
+ * @param pclient the cache inode client of the worker.
+ * @param pentry the record.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_journal_queue(cache_inode_client_t * pclient, nfs_journal_entry_t * pentry)
+{
+  nfs_journal_ring_t *pring =
+      &journal_rings[((nfs_worker_data_t *) pclient->pworker)->index];
+  unsigned int tail = pring->tail;
+
+  if(tail - pring->head > pring->mask)
+    {
+      __sync_fetch_and_add(&journal_stat.nb_ring_full, 1);
+
+      while(tail - pring->head > pring->mask)
+        {
+          P(journal_mutex);
+          pthread_cond_signal(&journal_condvar);
+          V(journal_mutex);
+          sched_yield();
+        }
+    }
+
+  pring->entries[tail & pring->mask] = pentry;
+  __sync_synchronize();
+  pring->tail = tail + 1;
+
+  /* Pairs with the barrier of the journal thread, between setting 'journal_sleeping'
+   * and checking the rings */
+  __sync_synchronize();
+
+  if(journal_sleeping)
+    {
+      P(journal_mutex);
+      pthread_cond_signal(&journal_condvar);
+      V(journal_mutex);
+    }
+}                               /* nfs_journal_queue */
+
+/**
+ * nfs_journal_build: builds a record.
+ *
+ * @param type NFS_JOURNAL_WRITE or NFS_JOURNAL_REMOVE.
+ * @param pcontext the FSAL context of the caller.
+ * @param phandle the handle of the object.
+ * @param fileid the fileid of the object.
+ * @param offset the offset of the data.
+ * @param length the length of the data.
+ * @param data the data (copied).
+ *
+ * @return the record, NULL if it could not be allocated.
+ *
+ */
+static nfs_journal_entry_t *nfs_journal_build(uint32_t type,
+                                              fsal_op_context_t * pcontext,
+                                              fsal_handle_t * phandle,
+                                              uint64_t fileid,
+                                              uint64_t offset,
+                                              uint32_t length, caddr_t data)
+{
+  nfs_journal_entry_t *pentry;
+  fsal_path_t path;
+  unsigned int path_length;
+  uint32_t checksum;
+
+  /* A record is journaled even if the path is unknown, the uploader reports it */
+  path_length = nfs_journal_get_path(pcontext, phandle, &path);
+
+  if((pentry =
+      (nfs_journal_entry_t *) Mem_Alloc(NFS_JOURNAL_ENTRY_SIZE(path_length, length))) ==
+     NULL)
+    {
+      LogCrit(COMPONENT_MAIN, "NFS JOURNAL: can't allocate a record of %u bytes",
+              (unsigned int)NFS_JOURNAL_ENTRY_SIZE(path_length, length));
+      return NULL;
+    }
+
+  pentry->record.magic = NFS_JOURNAL_MAGIC;
+  pentry->record.type = type;
+  pentry->record.fileid = fileid;
+  pentry->record.offset = offset;
+  pentry->record.length = length;
+  pentry->record.path_length = path_length;
+  pentry->record.checksum = 0;
+  pentry->record.padding = 0;
+
+  memcpy(pentry->payload, path.path, path_length);
+  if(length != 0)
+    memcpy(pentry->payload + path_length, data, length);
+
+  /* The checksum is computed by the worker, not to serialize it in the journal thread */
+  checksum = nfs_journal_adler32(1, (unsigned char *)pentry,
+                                 NFS_JOURNAL_ENTRY_SIZE(path_length, length));
+  pentry->record.checksum = checksum;
+
+  return pentry;
+}                               /* nfs_journal_build */
+
+/**
+ * nfs_journal_write: journals a write to a file.
+ *
+ * @param pclient the cache inode client of the calling worker.
+ * @param pcontext the FSAL context of the caller.
+ * @param phandle the handle of the file.
+ * @param fileid the fileid of the file.
+ * @param offset the offset of the write.
+ * @param length the length of the write.
+ * @param data the written data.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_journal_write(cache_inode_client_t * pclient,
+                      fsal_op_context_t * pcontext,
+                      fsal_handle_t * phandle,
+                      uint64_t fileid, uint64_t offset, uint32_t length, caddr_t data)
+{
+  nfs_journal_entry_t *pentry;
+
+  if(!journal_param.enable)
+    return 0;
+
+  if((pentry = nfs_journal_build(NFS_JOURNAL_WRITE, pcontext, phandle,
+                                 fileid, offset, length, data)) == NULL)
+    return -1;
+
+  nfs_journal_queue(pclient, pentry);
+
+  return 0;
+}                               /* nfs_journal_write */
+
+/**
+ * nfs_journal_remove: journals the removal of a file.
+ *
+ * To be called before the file is removed, as its path is got from its handle.
+ *
+ * @param pclient the cache inode client of the calling worker.
+ * @param pcontext the FSAL context of the caller.
+ * @param phandle the handle of the file.
+ * @param fileid the fileid of the file.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_journal_remove(cache_inode_client_t * pclient,
+                       fsal_op_context_t * pcontext,
+                       fsal_handle_t * phandle, uint64_t fileid)
+{
+  nfs_journal_entry_t *pentry;
+
+  if(!journal_param.enable)
+    return 0;
+
+  pentry = nfs_journal_build(NFS_JOURNAL_REMOVE, pcontext, phandle, fileid, 0, 0, NULL);
+
+  nfs_journal_path_invalidate(phandle);
+
+  if(pentry == NULL)
+    return -1;
+
+  nfs_journal_queue(pclient, pentry);
+
+  return 0;
+}                               /* nfs_journal_remove */
+
+/**
+ * nfs_journal_collect: gets a batch of records from the rings.
+ *
+ * @param batch [OUT] the records.
+ * @param iov [OUT] the related buffers, for writev.
+ *
+ * @return the number of records in the batch.
+ *
+ */
+static unsigned int nfs_journal_collect(nfs_journal_entry_t ** batch, struct iovec *iov)
+{
+  static unsigned int first_ring = 0;
+  nfs_journal_ring_t *pring;
+  unsigned int nb = 0;
+  unsigned int head;
+  unsigned int i;
+
+  /* Start with another ring each time, so that a busy worker can't starve the others */
+  first_ring = (first_ring + 1) % journal_nb_rings;
+
+  for(i = 0; i < journal_nb_rings && nb < NFS_JOURNAL_MAX_BATCH; i++)
+    {
+      pring = &journal_rings[(first_ring + i) % journal_nb_rings];
+
+      for(head = pring->head; head != pring->tail && nb < NFS_JOURNAL_MAX_BATCH; head++)
+        {
+          __sync_synchronize();
+          batch[nb] = pring->entries[head & pring->mask];
+          iov[nb].iov_base = (char *)batch[nb];
+          iov[nb].iov_len = NFS_JOURNAL_ENTRY_SIZE(batch[nb]->record.path_length,
+                                                   batch[nb]->record.length);
+          nb += 1;
+        }
+
+      /* The records stay in memory until they are written, only the slots are given back */
+      pring->head = head;
+    }
+
+  return nb;
+}                               /* nfs_journal_collect */
+
+/**
+ * nfs_journal_writev: writes a batch of records to the current segment.
+ *
+ * @param iov the buffers.
+ * @param nb the number of buffers.
+ *
+ * @return the number of bytes written, -1 if an error occured.
+ *
+ */
+static ssize_t nfs_journal_writev(struct iovec *iov, unsigned int nb)
+{
+  ssize_t total = 0;
+  ssize_t written;
+
+  while(nb > 0)
+    {
+      if((written = writev(journal_fd, iov, nb)) < 0)
+        {
+          if(errno == EINTR)
+            continue;
+          return -1;
+        }
+
+      total += written;
+
+      /* Partial write: skip what was written */
+      while(nb > 0 && (size_t) written >= iov->iov_len)
+        {
+          written -= iov->iov_len;
+          iov++;
+          nb--;
+        }
+
+      if(nb > 0)
+        {
+          iov->iov_base = (char *)iov->iov_base + written;
+          iov->iov_len -= written;
+        }
+    }
+
+  return total;
+}                               /* nfs_journal_writev */
+
+/**
+ * nfs_journal_wait: waits for records to be queued.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_journal_wait(void)
+{
+  struct timeval now;
+  struct timespec timeout;
+  unsigned int i;
+  int empty = TRUE;
+
+  P(journal_mutex);
+
+  journal_sleeping = TRUE;
+  __sync_synchronize();
+
+  for(i = 0; i < journal_nb_rings; i++)
+    if(journal_rings[i].head != journal_rings[i].tail)
+      empty = FALSE;
+
+  if(empty)
+    {
+      /* Wake up from time to time, in case a signal was missed */
+      gettimeofday(&now, NULL);
+      timeout.tv_sec = now.tv_sec + 1;
+      timeout.tv_nsec = now.tv_usec * 1000;
+      pthread_cond_timedwait(&journal_condvar, &journal_mutex, &timeout);
+    }
+
+  journal_sleeping = FALSE;
+
+  V(journal_mutex);
+}                               /* nfs_journal_wait */
+
+/**
+ * nfs_journal_thread: the thread writing the journal.
+ *
+ * @param Arg (unused)
+ *
+ * @return Pointer to the result (but this function will mostly loop forever).
+ *
+ */
+void *nfs_journal_thread(void *Arg)
+{
+  nfs_journal_entry_t *batch[NFS_JOURNAL_MAX_BATCH];
+  struct iovec iov[NFS_JOURNAL_MAX_BATCH];
+  unsigned int nb;
+  unsigned int i;
+  ssize_t written;
+  int rc;
+
+  SetNameFunction("journal");
+
+  if(!journal_param.enable)
+    return NULL;
+
+#ifndef _NO_BUDDY_SYSTEM
+  if((rc = BuddyInit(&nfs_param.buddy_param_admin)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_MAIN, "NFS JOURNAL: Memory manager could not be initialized, exiting...");
+      exit(1);
+    }
+#endif
+
+  if(nfs_journal_open_segment() != 0)
+    exit(1);
+
+  while(TRUE)
+    {
+      if((nb = nfs_journal_collect(batch, iov)) == 0)
+        {
+          nfs_journal_wait();
+          continue;
+        }
+
+      if((written = nfs_journal_writev(iov, nb)) < 0)
+        {
+          LogCrit(COMPONENT_MAIN, "NFS JOURNAL: write to segment #%u failed, errno=%d",
+                  journal_segment, errno);
+          exit(1);
+        }
+
+      /* Group commit: a single fsync for the whole batch */
+      if(journal_param.sync)
+        {
+          if(fdatasync(journal_fd) != 0)
+            LogCrit(COMPONENT_MAIN, "NFS JOURNAL: fdatasync of segment #%u failed, errno=%d",
+                    journal_segment, errno);
+          journal_stat.nb_sync += 1;
+        }
+
+      for(i = 0; i < nb; i++)
+        Mem_Free(batch[i]);
+
+      journal_stat.nb_records += nb;
+      journal_stat.nb_bytes += written;
+      journal_stat.nb_batches += 1;
+      journal_segment_offset += written;
+
+      LogFullDebug(COMPONENT_MAIN, "NFS JOURNAL: %u records (%lld bytes) written to segment #%u",
+                   nb, (long long)written, journal_segment);
+
+      if(journal_segment_offset >= journal_param.segment_size)
+        {
+          nfs_journal_close_segment();
+          if(nfs_journal_open_segment() != 0)
+            exit(1);
+        }
+    }
+
+  return NULL;
+}                               /* nfs_journal_thread */
@@ -0,0 +1,127 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_journal_record.c
+ * \brief   Encoding of the records of the journal.
+ *
+ * nfs_journal_record.c : Encoding of the records of the journal, shared by the journal
+ * thread which writes them and the uploader which reads them back.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif
+
+#include <string.h>
+#include <sys/types.h>
+#include "nfs_journal.h"
+
+/**
+ * nfs_journal_adler32: computes an Adler-32 checksum.
+ *
+ * @param adler the checksum of the previous buffers, 1 for the first one.
+ * @param buf the buffer.
+ * @param len the length of the buffer.
+ *
+ * @return the checksum.
+ *
+ */
+uint32_t nfs_journal_adler32(uint32_t adler, const unsigned char *buf, size_t len)
+{
+  uint32_t a = adler & 0xffff;
+  uint32_t b = (adler >> 16) & 0xffff;
+  size_t chunk;
+
+  while(len > 0)
+    {
+      /* 5552 is the largest chunk that can't overflow b before the modulo */
+      chunk = len < 5552 ? len : 5552;
+      len -= chunk;
+
+      while(chunk-- > 0)
+        {
+          a += *buf++;
+          b += a;
+        }
+
+      a %= 65521;
+      b %= 65521;
+    }
+
+  return (b << 16) | a;
+}                               /* nfs_journal_adler32 */
+
+/**
+ * nfs_journal_parse_record: checks the record at the beginning of a buffer.
+ *
+ * The records are not aligned in a segment: the header is copied to precord. The path and
+ * the data of the record follow the header in the buffer.
+ *
+ * @param buffer the buffer.
+ * @param size the size of the buffer.
+ * @param precord [OUT] the header of the record.
+ *
+ * @return the size of the record, 0 if the buffer ends before the end of the record,
+ * -1 if the record is corrupted.
+ *
+ */
+ssize_t nfs_journal_parse_record(caddr_t buffer, size_t size, nfs_journal_record_t * precord)
+{
+  nfs_journal_record_t header;
+  size_t record_size;
+  uint32_t checksum;
+
+  if(size < sizeof(nfs_journal_record_t))
+    return 0;
+
+  memcpy(precord, buffer, sizeof(nfs_journal_record_t));
+
+  if(precord->magic != NFS_JOURNAL_MAGIC)
+    return -1;
+
+  record_size = sizeof(nfs_journal_record_t) + (size_t) precord->path_length
+      + (size_t) precord->length;
+
+  if(size < record_size)
+    return 0;
+
+  /* The checksum was computed with the checksum field set to 0 */
+  header = *precord;
+  header.checksum = 0;
+  checksum = nfs_journal_adler32(1, (unsigned char *)&header, sizeof(header));
+  checksum = nfs_journal_adler32(checksum,
+                                 (unsigned char *)buffer + sizeof(nfs_journal_record_t),
+                                 record_size - sizeof(nfs_journal_record_t));
+
+  if(checksum != precord->checksum)
+    return -1;
+
+  return (ssize_t) record_size;
+}                               /* nfs_journal_parse_record */
@@ -269,6 +269,10 @@ int nfs_read_core_conf(config_file_t in_config, nfs_core_parameter_t * pparam)
         {
           pparam->nb_worker = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Nb_Event_Thread"))
+        {
+          pparam->nb_event_thread = atoi(key_value);
+        }
       else if(!strcasecmp(key_name, "Nb_MaxConcurrentGC"))
         {
           pparam->nb_max_concurrent_gc = atoi(key_value);
@@ -369,6 +373,216 @@ int nfs_read_core_conf(config_file_t in_config, nfs_core_parameter_t * pparam)
   return 0;
 }                               /* nfs_read_core_conf */
 
+/**
+ *
+ * nfs_read_journal_conf: reads the configuration for the journal of the modifications.
+ * 
+ * Reads the configuration for the journal of the modifications.
+ * 
+ * @param in_config [IN] configuration file handle
+ * @param pparam [OUT] read parameters
+ *
+ * @return 0 if ok,  -1 if not, 1 is stanza is not there.
+ *
+ */
+int nfs_read_journal_conf(config_file_t in_config, nfs_journal_parameter_t * pparam)
+{
+  int var_max;
+  int var_index;
+  int err;
+  char *key_name;
+  char *key_value;
+  config_item_t block;
+
+  /* Is the config tree initialized ? */
+  if(in_config == NULL || pparam == NULL)
+    return -1;
+
+  /* Get the config BLOCK */
+  if((block = config_FindItemByName(in_config, CONF_LABEL_NFS_JOURNAL)) == NULL)
+    {
+      /* LogCrit(COMPONENT_CONFIG, "Cannot read item \"%s\" from configuration file\n", CONF_LABEL_NFS_JOURNAL ) ; */
+      return 1;
+    }
+  else if(config_ItemType(block) != CONFIG_ITEM_BLOCK)
+    {
+      /* Expected to be a block */
+      return 1;
+    }
+
+  var_max = config_GetNbItems(block);
+
+  for(var_index = 0; var_index < var_max; var_index++)
+    {
+      config_item_t item;
+
+      item = config_GetItemByIndex(block, var_index);
+
+      /* Get key's name */
+      if((err = config_GetKeyValue(item, &key_name, &key_value)) != 0)
+        {
+          LogCrit(COMPONENT_CONFIG,
+                  "Error reading key[%d] from section \"%s\" of configuration file.\n",
+                  var_index, CONF_LABEL_NFS_JOURNAL);
+          return -1;
+        }
+
+      if(!strcasecmp(key_name, "Enable"))
+        {
+          pparam->enable = StrToBoolean(key_value);
+        }
+      else if(!strcasecmp(key_name, "Directory"))
+        {
+          /* the directory must leave room for the names of the segments */
+          if(strlen(key_value) + NFS_JOURNAL_SEGMENT_NAME_MAX > MAXPATHLEN)
+            {
+              LogCrit(COMPONENT_CONFIG, "Directory %s is too long (item %s)\n",
+                      key_value, CONF_LABEL_NFS_JOURNAL);
+              return -1;
+            }
+          strncpy(pparam->directory, key_value, MAXPATHLEN);
+        }
+      else if(!strcasecmp(key_name, "Segment_Size"))
+        {
+          pparam->segment_size = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Ring_Size"))
+        {
+          pparam->ring_size = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Path_Cache_Size"))
+        {
+          pparam->path_cache_size = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Sync"))
+        {
+          pparam->sync = StrToBoolean(key_value);
+        }
+      else
+        {
+          LogCrit(COMPONENT_CONFIG,
+                  "Unknown or unsettable key: %s (item %s)\n",
+                  key_name, CONF_LABEL_NFS_JOURNAL);
+          return -1;
+        }
+    }
+
+  return 0;
+}                               /* nfs_read_journal_conf */
+
+/**
+ *
+ * nfs_read_uploader_conf: reads the configuration for the upload of the journal.
+ * 
+ * Reads the configuration for the upload of the journal to an object store.
+ * 
+ * @param in_config [IN] configuration file handle
+ * @param pparam [OUT] read parameters
+ *
+ * @return 0 if ok,  -1 if not, 1 is stanza is not there.
+ *
+ */
+int nfs_read_uploader_conf(config_file_t in_config, nfs_uploader_parameter_t * pparam)
+{
+  int var_max;
+  int var_index;
+  int err;
+  char *key_name;
+  char *key_value;
+  config_item_t block;
+
+  /* Is the config tree initialized ? */
+  if(in_config == NULL || pparam == NULL)
+    return -1;
+
+  /* Get the config BLOCK */
+  if((block = config_FindItemByName(in_config, CONF_LABEL_NFS_UPLOADER)) == NULL)
+    {
+      /* LogCrit(COMPONENT_CONFIG, "Cannot read item \"%s\" from configuration file\n", CONF_LABEL_NFS_UPLOADER ) ; */
+      return 1;
+    }
+  else if(config_ItemType(block) != CONFIG_ITEM_BLOCK)
+    {
+      /* Expected to be a block */
+      return 1;
+    }
+
+  var_max = config_GetNbItems(block);
+
+  for(var_index = 0; var_index < var_max; var_index++)
+    {
+      config_item_t item;
+
+      item = config_GetItemByIndex(block, var_index);
+
+      /* Get key's name */
+      if((err = config_GetKeyValue(item, &key_name, &key_value)) != 0)
+        {
+          LogCrit(COMPONENT_CONFIG,
+                  "Error reading key[%d] from section \"%s\" of configuration file.\n",
+                  var_index, CONF_LABEL_NFS_UPLOADER);
+          return -1;
+        }
+
+      if(!strcasecmp(key_name, "Enable"))
+        {
+          pparam->enable = StrToBoolean(key_value);
+        }
+      else if(!strcasecmp(key_name, "Host"))
+        {
+          strncpy(pparam->host, key_value, sizeof(pparam->host) - 1);
+          pparam->host[sizeof(pparam->host) - 1] = '\0';
+        }
+      else if(!strcasecmp(key_name, "Port"))
+        {
+          pparam->port = (unsigned short)atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Bucket"))
+        {
+          strncpy(pparam->bucket, key_value, sizeof(pparam->bucket) - 1);
+          pparam->bucket[sizeof(pparam->bucket) - 1] = '\0';
+        }
+      else if(!strcasecmp(key_name, "Authorization"))
+        {
+          strncpy(pparam->authorization, key_value, sizeof(pparam->authorization) - 1);
+          pparam->authorization[sizeof(pparam->authorization) - 1] = '\0';
+        }
+      else if(!strcasecmp(key_name, "Nb_Connections"))
+        {
+          pparam->nb_connections = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Part_Size"))
+        {
+          pparam->part_size = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Max_Retries"))
+        {
+          pparam->max_retries = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Retry_Delay"))
+        {
+          pparam->retry_delay = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Scan_Period"))
+        {
+          pparam->scan_period = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Timeout"))
+        {
+          pparam->timeout = atoi(key_value);
+        }
+      else
+        {
+          LogCrit(COMPONENT_CONFIG,
+                  "Unknown or unsettable key: %s (item %s)\n",
+                  key_name, CONF_LABEL_NFS_UPLOADER);
+          return -1;
+        }
+    }
+
+  return 0;
+}                               /* nfs_read_uploader_conf */
+
 /**
  *
  * nfs_read_dupreq_hash_conf: reads the configuration for the hash in Duplicate Request layer.
@@ -436,6 +650,14 @@ int nfs_read_dupreq_hash_conf(config_file_t in_config,
         {
           pparam->hash_param.nb_node_prealloc = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Nb_Shards"))
+        {
+          pparam->nb_shards = atoi(key_value);
+        }
+      else if(!strcasecmp(key_name, "Max_Entries"))
+        {
+          pparam->max_entries = atoi(key_value);
+        }
       else
         {
           LogCrit(COMPONENT_CONFIG,
@@ -514,6 +736,13 @@ int nfs_read_ip_name_conf(config_file_t in_config, nfs_ip_name_parameter_t * ppa
         {
           pparam->hash_param.nb_node_prealloc = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Concurrent_Mode"))
+        {
+          if(StrToBoolean(key_value))
+            pparam->hash_param.flags |= HASHTABLE_FLAG_CONCURRENT;
+          else
+            pparam->hash_param.flags &= ~HASHTABLE_FLAG_CONCURRENT;
+        }
       else if(!strcasecmp(key_name, "Expiration_Time"))
         {
           pparam->expiration_time = atoi(key_value);
@@ -595,6 +824,20 @@ int nfs_read_client_id_conf(config_file_t in_config, nfs_client_id_parameter_t *
         {
           pparam->hash_param.nb_node_prealloc = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Concurrent_Mode"))
+        {
+          /* The reverse table follows the same mode */
+          if(StrToBoolean(key_value))
+            {
+              pparam->hash_param.flags |= HASHTABLE_FLAG_CONCURRENT;
+              pparam->hash_param_reverse.flags |= HASHTABLE_FLAG_CONCURRENT;
+            }
+          else
+            {
+              pparam->hash_param.flags &= ~HASHTABLE_FLAG_CONCURRENT;
+              pparam->hash_param_reverse.flags &= ~HASHTABLE_FLAG_CONCURRENT;
+            }
+        }
       else
         {
           LogCrit(COMPONENT_CONFIG,
@@ -668,6 +911,13 @@ int nfs_read_state_id_conf(config_file_t in_config, nfs_state_id_parameter_t * p
         {
           pparam->hash_param.nb_node_prealloc = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Concurrent_Mode"))
+        {
+          if(StrToBoolean(key_value))
+            pparam->hash_param.flags |= HASHTABLE_FLAG_CONCURRENT;
+          else
+            pparam->hash_param.flags &= ~HASHTABLE_FLAG_CONCURRENT;
+        }
       else
         {
           LogCrit(COMPONENT_CONFIG,
@@ -731,6 +981,13 @@ int nfs_read_session_id_conf(config_file_t in_config, nfs_session_id_parameter_t
         {
           pparam->hash_param.nb_node_prealloc = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Concurrent_Mode"))
+        {
+          if(StrToBoolean(key_value))
+            pparam->hash_param.flags |= HASHTABLE_FLAG_CONCURRENT;
+          else
+            pparam->hash_param.flags &= ~HASHTABLE_FLAG_CONCURRENT;
+        }
       else
         {
           LogCrit(COMPONENT_CONFIG,
@@ -1012,6 +1269,13 @@ int nfs_read_uidmap_conf(config_file_t in_config, nfs_idmap_cache_parameter_t *
         {
           pparam->hash_param.nb_node_prealloc = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Concurrent_Mode"))
+        {
+          if(StrToBoolean(key_value))
+            pparam->hash_param.flags |= HASHTABLE_FLAG_CONCURRENT;
+          else
+            pparam->hash_param.flags &= ~HASHTABLE_FLAG_CONCURRENT;
+        }
       else if(!strcasecmp(key_name, "Map"))
         {
           strncpy(pparam->mapfile, key_value, MAXPATHLEN);
@@ -1094,6 +1358,13 @@ int nfs_read_gidmap_conf(config_file_t in_config, nfs_idmap_cache_parameter_t *
         {
           pparam->hash_param.nb_node_prealloc = atoi(key_value);
         }
+      else if(!strcasecmp(key_name, "Concurrent_Mode"))
+        {
+          if(StrToBoolean(key_value))
+            pparam->hash_param.flags |= HASHTABLE_FLAG_CONCURRENT;
+          else
+            pparam->hash_param.flags &= ~HASHTABLE_FLAG_CONCURRENT;
+        }
       else if(!strcasecmp(key_name, "Map"))
         {
           strncpy(pparam->mapfile, key_value, MAXPATHLEN);
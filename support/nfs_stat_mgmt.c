@@ -218,6 +218,8 @@ void nfs_stat_update(nfs_stat_type_t type,
       pitem->min_latency = lstat_req->latency;
     }
 
+  nfs_latency_histogram_update(&pitem->latency_histogram, lstat_req->latency);
+
   /* Update total, min and max latency */
   pitem->tot_latency += lstat_req->latency;
   if(lstat_req->latency > pitem->max_latency)
@@ -250,3 +252,127 @@ void nfs_stat_update(nfs_stat_type_t type,
   return;
 
 }                               /* nfs_stat_update */
+
+/**
+ *
+ * nfs_latency_histogram_index: computes the bucket of a latency.
+ *
+ * @param latency [IN] the latency, in microseconds
+ *
+ * @return the index of the bucket holding this latency.
+ *
+ */
+static unsigned int nfs_latency_histogram_index(unsigned int latency)
+{
+  unsigned int msb = 0;
+
+  if(latency < NFS_LATENCY_SUB_COUNT)
+    return latency;
+
+  /* Position of the most significant bit */
+  while((latency >> msb) > 1)
+    msb += 1;
+
+  /* Power of two, then linear position within it */
+  return (msb - NFS_LATENCY_SUB_BITS + 1) * NFS_LATENCY_SUB_COUNT
+      + ((latency >> (msb - NFS_LATENCY_SUB_BITS)) - NFS_LATENCY_SUB_COUNT);
+}                               /* nfs_latency_histogram_index */
+
+/**
+ *
+ * nfs_latency_histogram_bound: computes the highest latency of a bucket.
+ *
+ * @param index [IN] the index of the bucket
+ *
+ * @return the highest latency, in microseconds, held by this bucket.
+ *
+ */
+static unsigned int nfs_latency_histogram_bound(unsigned int index)
+{
+  unsigned int shift;
+  unsigned int sub;
+
+  if(index < NFS_LATENCY_SUB_COUNT)
+    return index;
+
+  shift = index / NFS_LATENCY_SUB_COUNT - 1;
+  sub = index % NFS_LATENCY_SUB_COUNT + NFS_LATENCY_SUB_COUNT;
+
+  return ((sub + 1) << shift) - 1;
+}                               /* nfs_latency_histogram_bound */
+
+/**
+ *
+ * nfs_latency_histogram_update: records a latency in a histogram.
+ *
+ * A histogram is only updated by the worker owning it, the stats thread and the
+ * SNMP interface read it without locking.
+ *
+ * @param phist   [INOUT] the histogram
+ * @param latency [IN]    the latency, in microseconds
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_latency_histogram_update(nfs_latency_histogram_t * phist, unsigned int latency)
+{
+  phist->bucket[nfs_latency_histogram_index(latency)] += 1;
+  phist->count += 1;
+}                               /* nfs_latency_histogram_update */
+
+/**
+ *
+ * nfs_latency_histogram_merge: adds a histogram to another one.
+ *
+ * @param pdest [INOUT] the histogram to be updated
+ * @param psrc  [IN]    the histogram to be added
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_latency_histogram_merge(nfs_latency_histogram_t * pdest,
+                                 nfs_latency_histogram_t * psrc)
+{
+  unsigned int i;
+
+  for(i = 0; i < NFS_LATENCY_NB_BUCKETS; i++)
+    pdest->bucket[i] += psrc->bucket[i];
+
+  pdest->count += psrc->count;
+}                               /* nfs_latency_histogram_merge */
+
+/**
+ *
+ * nfs_latency_histogram_percentile: computes a percentile of a histogram.
+ *
+ * @param phist     [IN] the histogram
+ * @param per_mille [IN] the percentile, in per mille (990 for p99)
+ *
+ * @return the upper bound of the bucket holding this percentile, 0 if the histogram is empty.
+ *
+ */
+unsigned int nfs_latency_histogram_percentile(nfs_latency_histogram_t * phist,
+                                              unsigned int per_mille)
+{
+  unsigned long long rank;
+  unsigned long long seen = 0;
+  unsigned int i;
+
+  if(phist->count == 0)
+    return 0;
+
+  /* Rank of the sample, rounded up so that p100 is the maximum */
+  rank = ((unsigned long long)phist->count * per_mille + 999) / 1000;
+  if(rank == 0)
+    rank = 1;
+
+  for(i = 0; i < NFS_LATENCY_NB_BUCKETS; i++)
+    {
+      seen += phist->bucket[i];
+      if(seen >= rank)
+        return nfs_latency_histogram_bound(i);
+    }
+
+  /* The buckets were updated after count was read */
+  return nfs_latency_histogram_bound(NFS_LATENCY_NB_BUCKETS - 1);
+}                               /* nfs_latency_histogram_percentile */
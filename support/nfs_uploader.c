@@ -0,0 +1,1778 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ */
+
+/**
+ * \file    nfs_uploader.c
+ * \brief   Upload of the journal to an object store.
+ *
+ * nfs_uploader.c : Upload of the journal to an object store.
+ *
+ * The uploader thread maps the segments of the journal one after the other, starting where it
+ * stopped the last time (this is kept in <Directory>/uploader.state). The records of a
+ * segment are gathered per path: the writes to a file become a list of extents (pointing into
+ * the mapped segment), a removal drops the previous extents. Each modified file is then queued
+ * to a pool of threads, each of them owning a persistent HTTP/1.1 connection to the object
+ * store.
+ *
+ * The object of a file is its whole content: the extents are applied to the current content of
+ * the object, which is downloaded first unless the extents cover it all (which is checked with
+ * a HEAD request). Small objects are sent by a single PUT, larger ones by a multipart upload
+ * whose parts are queued to the pool too, so that a single large file uses all the
+ * connections. The last part to be sent completes the upload.
+ *
+ * A segment is done once all its files are uploaded. A closed segment (a newer one exists) is
+ * then removed. If a file could not be uploaded after all the retries, the segment is
+ * processed again at the next scan (the uploads are idempotent).
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#ifdef _SOLARIS
+#include "solaris_port.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <ctype.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <dirent.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/time.h>
+#include <sys/uio.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <netdb.h>
+
+#include "log_macros.h"
+#include "stuff_alloc.h"
+#include "nfs_journal.h"
+#include "nfs_uploader.h"
+
+/* Size of the receive buffer of a connection, the response headers must fit in it */
+#define NFS_UPLOADER_BUFFER_SIZE 16384
+
+/* Size of the headers of a request */
+#define NFS_UPLOADER_HEADER_SIZE 4096
+
+#define NFS_UPLOADER_ETAG_LEN      128
+#define NFS_UPLOADER_UPLOAD_ID_LEN 1024
+
+/* Buckets of the table of the files of a segment */
+#define NFS_UPLOADER_HASH_SIZE 4096
+
+/* Longest delay between two retries, in seconds */
+#define NFS_UPLOADER_RETRY_DELAY_MAX 60
+
+/* Statuses worth a retry: server errors, timeouts and throttling */
+#define NFS_UPLOADER_RETRYABLE( status ) \
+  ( (status) >= 500 || (status) == 408 || (status) == 429 )
+
+typedef struct nfs_uploader_connection__
+{
+  int fd;                       /* -1 when not connected */
+  size_t start;                 /* received bytes not parsed yet are in buffer[start..end[ */
+  size_t end;
+  char buffer[NFS_UPLOADER_BUFFER_SIZE];
+} nfs_uploader_connection_t;
+
+typedef struct nfs_uploader_response__
+{
+  int status;
+  int keep_alive;
+  int has_length;
+  unsigned long long content_length;
+  char etag[NFS_UPLOADER_ETAG_LEN];
+  caddr_t body;                 /* nul terminated, NULL if empty */
+  size_t body_length;
+} nfs_uploader_response_t;
+
+typedef struct nfs_uploader_extent__
+{
+  uint64_t offset;
+  uint32_t length;
+  caddr_t data;                 /* in the mapped segment */
+} nfs_uploader_extent_t;
+
+/* A file modified in the segment being uploaded */
+typedef struct nfs_uploader_file__
+{
+  struct nfs_uploader_file__ *next_hash;
+  struct nfs_uploader_file__ *next;
+  caddr_t path;                 /* in the mapped segment, not nul terminated */
+  unsigned int path_length;
+  char *key;                    /* the name of the object, URI encoded */
+  int removed;                  /* the previous content of the object does not matter */
+  nfs_uploader_extent_t *extents;       /* in the order of the journal */
+  unsigned int nb_extents;
+  unsigned int max_extents;
+  uint64_t size;                /* end of the furthest extent */
+
+  /* Multipart upload */
+  caddr_t image;
+  uint64_t image_size;
+  char upload_id[NFS_UPLOADER_UPLOAD_ID_LEN];
+  unsigned int nb_parts;
+  char (*etags)[NFS_UPLOADER_ETAG_LEN];
+  volatile unsigned int parts_left;
+  volatile int failed;
+} nfs_uploader_file_t;
+
+/* Work for the connection threads: a file, or a part of a multipart upload */
+typedef struct nfs_uploader_job__
+{
+  struct nfs_uploader_job__ *next;
+  nfs_uploader_file_t *pfile;
+  unsigned int part;            /* 0 for the file, from 1 for a part */
+} nfs_uploader_job_t;
+
+static nfs_uploader_parameter_t uploader_param;
+static char uploader_directory[MAXPATHLEN];
+static buddy_parameter_t *uploader_buddy_param = NULL;
+
+/* Where to start from in the journal */
+static unsigned int uploader_segment = 0;
+static unsigned long long uploader_offset = 0;
+
+/* The queue of the connection threads */
+static pthread_mutex_t uploader_mutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t uploader_job_condvar = PTHREAD_COND_INITIALIZER;
+static pthread_cond_t uploader_done_condvar = PTHREAD_COND_INITIALIZER;
+static nfs_uploader_job_t *uploader_first_job = NULL;
+static nfs_uploader_job_t *uploader_last_job = NULL;
+
+/* Files of the current segment not uploaded yet, and the ones that could not be */
+static unsigned int uploader_pending = 0;
+static unsigned int uploader_failed = 0;
+
+static nfs_uploader_stat_t uploader_stat;
+
+/**
+ * nfs_uploader_close: closes a connection to the object store.
+ *
+ * @param pconn the connection.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_uploader_close(nfs_uploader_connection_t * pconn)
+{
+  if(pconn->fd >= 0)
+    close(pconn->fd);
+
+  pconn->fd = -1;
+  pconn->start = 0;
+  pconn->end = 0;
+}                               /* nfs_uploader_close */
+
+/**
+ * nfs_uploader_connect: opens a connection to the object store.
+ *
+ * @param pconn the connection.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_connect(nfs_uploader_connection_t * pconn)
+{
+  struct addrinfo hints;
+  struct addrinfo *res;
+  struct addrinfo *pai;
+  struct timeval timeout;
+  char port[16];
+  int one = 1;
+  int rc;
+
+  memset(&hints, 0, sizeof(hints));
+  hints.ai_family = AF_UNSPEC;
+  hints.ai_socktype = SOCK_STREAM;
+  snprintf(port, sizeof(port), "%u", uploader_param.port);
+
+  if((rc = getaddrinfo(uploader_param.host, port, &hints, &res)) != 0)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: can't resolve %s: %s",
+               uploader_param.host, gai_strerror(rc));
+      return -1;
+    }
+
+  timeout.tv_sec = uploader_param.timeout;
+  timeout.tv_usec = 0;
+
+  for(pai = res; pai != NULL; pai = pai->ai_next)
+    {
+      if((pconn->fd = socket(pai->ai_family, pai->ai_socktype, pai->ai_protocol)) < 0)
+        continue;
+
+      setsockopt(pconn->fd, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+      setsockopt(pconn->fd, SOL_SOCKET, SO_SNDTIMEO, &timeout, sizeof(timeout));
+      setsockopt(pconn->fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+
+      if(connect(pconn->fd, pai->ai_addr, pai->ai_addrlen) == 0)
+        break;
+
+      close(pconn->fd);
+      pconn->fd = -1;
+    }
+
+  freeaddrinfo(res);
+
+  if(pconn->fd < 0)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: can't connect to %s:%u, errno=%d",
+               uploader_param.host, uploader_param.port, errno);
+      return -1;
+    }
+
+  pconn->start = 0;
+  pconn->end = 0;
+
+  return 0;
+}                               /* nfs_uploader_connect */
+
+/**
+ * nfs_uploader_send: sends a buffer list on a connection.
+ *
+ * @param pconn the connection.
+ * @param iov the buffers.
+ * @param nb the number of buffers.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_send(nfs_uploader_connection_t * pconn, struct iovec *iov,
+                             unsigned int nb)
+{
+  struct msghdr msg;
+  ssize_t sent;
+
+  while(nb > 0)
+    {
+      memset(&msg, 0, sizeof(msg));
+      msg.msg_iov = iov;
+      msg.msg_iovlen = nb;
+
+      /* No SIGPIPE if the object store closed the connection */
+      if((sent = sendmsg(pconn->fd, &msg, MSG_NOSIGNAL)) < 0)
+        {
+          if(errno == EINTR)
+            continue;
+          return -1;
+        }
+
+      /* Partial send: skip what was sent */
+      while(nb > 0 && (size_t) sent >= iov->iov_len)
+        {
+          sent -= iov->iov_len;
+          iov++;
+          nb--;
+        }
+
+      if(nb > 0)
+        {
+          iov->iov_base = (char *)iov->iov_base + sent;
+          iov->iov_len -= sent;
+        }
+    }
+
+  return 0;
+}                               /* nfs_uploader_send */
+
+/**
+ * nfs_uploader_fill: receives more bytes in the buffer of a connection.
+ *
+ * @param pconn the connection.
+ *
+ * @return the number of bytes received, 0 if the connection was closed, -1 if an error occured.
+ *
+ */
+static ssize_t nfs_uploader_fill(nfs_uploader_connection_t * pconn)
+{
+  ssize_t received;
+
+  /* Move the bytes not parsed yet to the beginning of the buffer */
+  if(pconn->start > 0)
+    {
+      memmove(pconn->buffer, pconn->buffer + pconn->start, pconn->end - pconn->start);
+      pconn->end -= pconn->start;
+      pconn->start = 0;
+    }
+
+  if(pconn->end == NFS_UPLOADER_BUFFER_SIZE)
+    return -1;
+
+  do
+    received = recv(pconn->fd, pconn->buffer + pconn->end,
+                    NFS_UPLOADER_BUFFER_SIZE - pconn->end, 0);
+  while(received < 0 && errno == EINTR);
+
+  if(received > 0)
+    pconn->end += received;
+
+  return received;
+}                               /* nfs_uploader_fill */
+
+/**
+ * nfs_uploader_read_line: receives a line (ended by CRLF).
+ *
+ * @param pconn the connection.
+ *
+ * @return the line, without its CRLF, or NULL if an error occured. The line is in the buffer
+ * of the connection: it is valid until the next receive.
+ *
+ */
+static char *nfs_uploader_read_line(nfs_uploader_connection_t * pconn)
+{
+  char *line;
+  char *eol;
+
+  while(TRUE)
+    {
+      line = pconn->buffer + pconn->start;
+      if((eol = memchr(line, '\n', pconn->end - pconn->start)) != NULL)
+        {
+          pconn->start = eol + 1 - pconn->buffer;
+          if(eol > line && eol[-1] == '\r')
+            eol--;
+          *eol = '\0';
+          return line;
+        }
+
+      if(nfs_uploader_fill(pconn) <= 0)
+        return NULL;
+    }
+}                               /* nfs_uploader_read_line */
+
+/**
+ * nfs_uploader_read_body: receives a part of the body of a response.
+ *
+ * @param pconn the connection.
+ * @param presponse the response, whose body grows.
+ * @param length the number of bytes to receive, 0 to receive until the connection is closed.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_read_body(nfs_uploader_connection_t * pconn,
+                                  nfs_uploader_response_t * presponse, size_t length)
+{
+  int until_close = (length == 0);
+  caddr_t body;
+  size_t count;
+  ssize_t received;
+
+  do
+    {
+      /* Until the connection is closed, the body grows a buffer at a time */
+      count = until_close ? NFS_UPLOADER_BUFFER_SIZE : length;
+
+      if((body = (caddr_t) Mem_Realloc(presponse->body,
+                                       presponse->body_length + count + 1)) == NULL)
+        return -1;
+      presponse->body = body;
+
+      /* First what is already in the buffer of the connection */
+      if(pconn->end - pconn->start < count)
+        count = pconn->end - pconn->start;
+      memcpy(body + presponse->body_length, pconn->buffer + pconn->start, count);
+      pconn->start += count;
+      presponse->body_length += count;
+      if(!until_close)
+        length -= count;
+
+      /* Then directly into the body */
+      while(length > 0 || (until_close && count == 0))
+        {
+          received = recv(pconn->fd, body + presponse->body_length,
+                          until_close ? NFS_UPLOADER_BUFFER_SIZE : length, 0);
+          if(received < 0 && errno == EINTR)
+            continue;
+          if(received == 0 && until_close)
+            {
+              presponse->body[presponse->body_length] = '\0';
+              return 0;
+            }
+          if(received <= 0)
+            return -1;
+
+          presponse->body_length += received;
+          if(!until_close)
+            length -= received;
+          else
+            break;
+        }
+    }
+  while(until_close);
+
+  presponse->body[presponse->body_length] = '\0';
+
+  return 0;
+}                               /* nfs_uploader_read_body */
+
+/**
+ * nfs_uploader_read_response: receives the response to a request.
+ *
+ * @param pconn the connection.
+ * @param method the method of the request.
+ * @param presponse [OUT] the response.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_read_response(nfs_uploader_connection_t * pconn, const char *method,
+                                      nfs_uploader_response_t * presponse)
+{
+  int chunked = FALSE;
+  unsigned long chunk;
+  int minor;
+  char *line;
+  char *value;
+  char *end;
+
+  if((line = nfs_uploader_read_line(pconn)) == NULL)
+    return -1;
+
+  if(sscanf(line, "HTTP/1.%d %d", &minor, &presponse->status) != 2)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: bad status line \"%s\"", line);
+      return -1;
+    }
+  presponse->keep_alive = (minor >= 1);
+
+  /* Headers */
+  while((line = nfs_uploader_read_line(pconn)) != NULL && *line != '\0')
+    {
+      if((value = strchr(line, ':')) == NULL)
+        continue;
+      *value++ = '\0';
+      while(*value == ' ' || *value == '\t')
+        value++;
+
+      if(!strcasecmp(line, "Content-Length"))
+        {
+          presponse->content_length = strtoull(value, NULL, 10);
+          presponse->has_length = TRUE;
+        }
+      else if(!strcasecmp(line, "Transfer-Encoding"))
+        chunked = (strstr(value, "chunked") != NULL);
+      else if(!strcasecmp(line, "Connection"))
+        {
+          if(!strcasecmp(value, "close"))
+            presponse->keep_alive = FALSE;
+          else if(!strcasecmp(value, "keep-alive"))
+            presponse->keep_alive = TRUE;
+        }
+      else if(!strcasecmp(line, "ETag"))
+        strncpy(presponse->etag, value, NFS_UPLOADER_ETAG_LEN - 1);
+    }
+
+  if(line == NULL)
+    return -1;
+
+  /* Responses without a body */
+  if(!strcmp(method, "HEAD") || presponse->status == 204 || presponse->status == 304
+     || presponse->status < 200)
+    return 0;
+
+  if(chunked)
+    {
+      while(TRUE)
+        {
+          if((line = nfs_uploader_read_line(pconn)) == NULL)
+            return -1;
+          chunk = strtoul(line, &end, 16);
+          if(end == line)
+            return -1;
+
+          if(chunk == 0)
+            break;
+
+          if(nfs_uploader_read_body(pconn, presponse, chunk) != 0)
+            return -1;
+
+          /* CRLF after the chunk */
+          if((line = nfs_uploader_read_line(pconn)) == NULL)
+            return -1;
+        }
+
+      /* Trailer */
+      while((line = nfs_uploader_read_line(pconn)) != NULL && *line != '\0') ;
+
+      return (line == NULL) ? -1 : 0;
+    }
+
+  if(presponse->has_length)
+    {
+      if(presponse->content_length == 0)
+        return 0;
+      return nfs_uploader_read_body(pconn, presponse, presponse->content_length);
+    }
+
+  /* The body ends with the connection */
+  presponse->keep_alive = FALSE;
+  return nfs_uploader_read_body(pconn, presponse, 0);
+}                               /* nfs_uploader_read_response */
+
+/**
+ * nfs_uploader_free_response: releases the body of a response.
+ *
+ * @param presponse the response.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_uploader_free_response(nfs_uploader_response_t * presponse)
+{
+  if(presponse->body != NULL)
+    Mem_Free(presponse->body);
+
+  presponse->body = NULL;
+  presponse->body_length = 0;
+}                               /* nfs_uploader_free_response */
+
+/**
+ * nfs_uploader_http: sends a request and receives its response, once.
+ *
+ * @param pconn the connection (opened if needed).
+ * @param method the method.
+ * @param key the name of the object.
+ * @param query the query string (with its '?'), or "".
+ * @param body the body of the request.
+ * @param body_length the length of the body.
+ * @param presponse [OUT] the response.
+ *
+ * @return 0 if successfull, -1 otherwise (the connection is then closed).
+ *
+ */
+static int nfs_uploader_http(nfs_uploader_connection_t * pconn,
+                             const char *method, const char *key, const char *query,
+                             caddr_t body, size_t body_length,
+                             nfs_uploader_response_t * presponse)
+{
+  char header[NFS_UPLOADER_HEADER_SIZE];
+  struct iovec iov[2];
+  int len;
+
+  memset(presponse, 0, sizeof(nfs_uploader_response_t));
+
+  if(pconn->fd < 0 && nfs_uploader_connect(pconn) != 0)
+    return -1;
+
+  len = snprintf(header, NFS_UPLOADER_HEADER_SIZE,
+                 "%s /%s/%s%s HTTP/1.1\r\n"
+                 "Host: %s:%u\r\n"
+                 "Content-Length: %llu\r\n"
+                 "%s%s%s"
+                 "\r\n",
+                 method, uploader_param.bucket, key, query,
+                 uploader_param.host, uploader_param.port,
+                 (unsigned long long)body_length,
+                 uploader_param.authorization[0] != '\0' ? "Authorization: " : "",
+                 uploader_param.authorization,
+                 uploader_param.authorization[0] != '\0' ? "\r\n" : "");
+
+  if(len >= NFS_UPLOADER_HEADER_SIZE)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: request for %s is too long", key);
+      return -1;
+    }
+
+  iov[0].iov_base = header;
+  iov[0].iov_len = len;
+  iov[1].iov_base = body;
+  iov[1].iov_len = body_length;
+
+  if(nfs_uploader_send(pconn, iov, body_length > 0 ? 2 : 1) != 0
+     || nfs_uploader_read_response(pconn, method, presponse) != 0)
+    {
+      LogDebug(COMPONENT_MAIN, "NFS UPLOADER: %s %s%s failed, errno=%d",
+               method, key, query, errno);
+      nfs_uploader_free_response(presponse);
+      nfs_uploader_close(pconn);
+      return -1;
+    }
+
+  if(!presponse->keep_alive)
+    nfs_uploader_close(pconn);
+
+  LogFullDebug(COMPONENT_MAIN, "NFS UPLOADER: %s %s%s (%llu bytes) -> %d",
+               method, key, query, (unsigned long long)body_length, presponse->status);
+
+  return 0;
+}                               /* nfs_uploader_http */
+
+/**
+ * nfs_uploader_request: sends a request until it gets a final response.
+ *
+ * Transport errors, server errors and throttling are retried, with a delay doubled each time.
+ *
+ * @param pconn the connection.
+ * @param method the method.
+ * @param key the name of the object.
+ * @param query the query string (with its '?'), or "".
+ * @param body the body of the request.
+ * @param body_length the length of the body.
+ * @param presponse [OUT] the response, to be released by nfs_uploader_free_response.
+ *
+ * @return 0 if a final response was got (its status is to be checked by the caller),
+ * -1 otherwise.
+ *
+ */
+static int nfs_uploader_request(nfs_uploader_connection_t * pconn,
+                                const char *method, const char *key, const char *query,
+                                caddr_t body, size_t body_length,
+                                nfs_uploader_response_t * presponse)
+{
+  unsigned int retry;
+  unsigned int delay;
+  int reused;
+
+  for(retry = 0;; retry++)
+    {
+      reused = (pconn->fd >= 0);
+
+      if(nfs_uploader_http(pconn, method, key, query, body, body_length, presponse) == 0)
+        {
+          if(!NFS_UPLOADER_RETRYABLE(presponse->status))
+            return 0;
+
+          LogDebug(COMPONENT_MAIN, "NFS UPLOADER: %s %s%s got status %d",
+                   method, key, query, presponse->status);
+          nfs_uploader_free_response(presponse);
+        }
+      else if(reused)
+        {
+          /* The object store may have closed an idle connection: try a new one at once */
+          if(nfs_uploader_http(pconn, method, key, query, body, body_length, presponse) == 0)
+            {
+              if(!NFS_UPLOADER_RETRYABLE(presponse->status))
+                return 0;
+              nfs_uploader_free_response(presponse);
+            }
+        }
+
+      if(retry >= uploader_param.max_retries)
+        {
+          LogMajor(COMPONENT_MAIN, "NFS UPLOADER: %s %s%s failed after %u retries",
+                   method, key, query, retry);
+          return -1;
+        }
+
+      __sync_fetch_and_add(&uploader_stat.nb_retries, 1);
+
+      delay = uploader_param.retry_delay << (retry < 16 ? retry : 16);
+      if(delay > NFS_UPLOADER_RETRY_DELAY_MAX)
+        delay = NFS_UPLOADER_RETRY_DELAY_MAX;
+      if(delay > 0)
+        sleep(delay);
+    }
+}                               /* nfs_uploader_request */
+
+/**
+ * nfs_uploader_encode: URI encodes a string.
+ *
+ * @param str the string.
+ * @param len its length.
+ * @param keep_slash TRUE if the '/' are not to be encoded (in a path).
+ *
+ * @return the encoded string (to be freed by Mem_Free), NULL if it could not be allocated.
+ *
+ */
+static char *nfs_uploader_encode(const char *str, size_t len, int keep_slash)
+{
+  static const char hex[] = "0123456789ABCDEF";
+  unsigned char c;
+  char *encoded;
+  char *p;
+
+  if((encoded = (char *)Mem_Alloc(3 * len + 1)) == NULL)
+    return NULL;
+
+  for(p = encoded; len > 0; str++, len--)
+    {
+      c = (unsigned char)*str;
+      if(isalnum(c) || (c == '/' && keep_slash) || c == '-' || c == '_' || c == '.' || c == '~')
+        *p++ = c;
+      else
+        {
+          *p++ = '%';
+          *p++ = hex[c >> 4];
+          *p++ = hex[c & 0xf];
+        }
+    }
+  *p = '\0';
+
+  return encoded;
+}                               /* nfs_uploader_encode */
+
+/**
+ * nfs_uploader_cmp_extent: compares two extents by offset (for qsort).
+ */
+static int nfs_uploader_cmp_extent(const void *a, const void *b)
+{
+  const nfs_uploader_extent_t *pa = (const nfs_uploader_extent_t *)a;
+  const nfs_uploader_extent_t *pb = (const nfs_uploader_extent_t *)b;
+
+  if(pa->offset < pb->offset)
+    return -1;
+  return (pa->offset > pb->offset) ? 1 : 0;
+}                               /* nfs_uploader_cmp_extent */
+
+/**
+ * nfs_uploader_covered: tells if the extents of a file cover it from 0 to its size.
+ *
+ * @param pfile the file.
+ *
+ * @return TRUE if they do, FALSE otherwise.
+ *
+ */
+static int nfs_uploader_covered(nfs_uploader_file_t * pfile)
+{
+  nfs_uploader_extent_t *sorted;
+  uint64_t end = 0;
+  unsigned int i;
+
+  if((sorted =
+      (nfs_uploader_extent_t *) Mem_Alloc(pfile->nb_extents *
+                                          sizeof(nfs_uploader_extent_t))) == NULL)
+    return FALSE;
+
+  memcpy(sorted, pfile->extents, pfile->nb_extents * sizeof(nfs_uploader_extent_t));
+  qsort(sorted, pfile->nb_extents, sizeof(nfs_uploader_extent_t), nfs_uploader_cmp_extent);
+
+  for(i = 0; i < pfile->nb_extents && sorted[i].offset <= end; i++)
+    if(sorted[i].offset + sorted[i].length > end)
+      end = sorted[i].offset + sorted[i].length;
+
+  Mem_Free(sorted);
+
+  return (end >= pfile->size);
+}                               /* nfs_uploader_covered */
+
+/**
+ * nfs_uploader_build_image: builds the new content of the object of a file.
+ *
+ * @param pconn the connection, to get the current content of the object.
+ * @param pfile the file, whose image and image_size are set.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_build_image(nfs_uploader_connection_t * pconn,
+                                    nfs_uploader_file_t * pfile)
+{
+  nfs_uploader_response_t response;
+  int need_content = !pfile->removed;
+  caddr_t image = NULL;
+  uint64_t image_size = 0;
+  unsigned int i;
+
+  /* No need to download the object if the file was fully rewritten, and has not shrunk */
+  if(need_content && nfs_uploader_covered(pfile))
+    {
+      if(nfs_uploader_request(pconn, "HEAD", pfile->key, "", NULL, 0, &response) != 0)
+        return -1;
+      nfs_uploader_free_response(&response);
+
+      if(response.status == 404
+         || (response.status == 200 && response.has_length
+             && response.content_length <= pfile->size))
+        need_content = FALSE;
+    }
+
+  if(need_content)
+    {
+      __sync_fetch_and_add(&uploader_stat.nb_gets, 1);
+
+      if(nfs_uploader_request(pconn, "GET", pfile->key, "", NULL, 0, &response) != 0)
+        return -1;
+
+      if(response.status == 200)
+        {
+          image = response.body;
+          image_size = response.body_length;
+        }
+      else
+        {
+          nfs_uploader_free_response(&response);
+          if(response.status != 404)
+            {
+              LogMajor(COMPONENT_MAIN, "NFS UPLOADER: GET %s got status %d",
+                       pfile->key, response.status);
+              return -1;
+            }
+        }
+    }
+
+  /* The object grows to the furthest extent, the holes are zeroed */
+  if(image == NULL || image_size < pfile->size)
+    {
+      caddr_t grown;
+
+      if((grown = (caddr_t) Mem_Realloc(image, pfile->size + 1)) == NULL)
+        {
+          if(image != NULL)
+            Mem_Free(image);
+          LogCrit(COMPONENT_MAIN, "NFS UPLOADER: can't allocate %llu bytes for %s",
+                  (unsigned long long)pfile->size, pfile->key);
+          return -1;
+        }
+      memset(grown + image_size, 0, pfile->size - image_size);
+      image = grown;
+      image_size = pfile->size;
+    }
+
+  /* Apply the writes, in the order they were made */
+  for(i = 0; i < pfile->nb_extents; i++)
+    memcpy(image + pfile->extents[i].offset, pfile->extents[i].data,
+           pfile->extents[i].length);
+
+  pfile->image = image;
+  pfile->image_size = image_size;
+
+  return 0;
+}                               /* nfs_uploader_build_image */
+
+/**
+ * nfs_uploader_queue: queues a job to the connection threads.
+ *
+ * @param pfile the file.
+ * @param part 0 for the whole file, else the number of a part.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_queue(nfs_uploader_file_t * pfile, unsigned int part)
+{
+  nfs_uploader_job_t *pjob;
+
+  if((pjob = (nfs_uploader_job_t *) Mem_Alloc(sizeof(nfs_uploader_job_t))) == NULL)
+    return -1;
+
+  pjob->next = NULL;
+  pjob->pfile = pfile;
+  pjob->part = part;
+
+  P(uploader_mutex);
+  if(uploader_last_job == NULL)
+    uploader_first_job = pjob;
+  else
+    uploader_last_job->next = pjob;
+  uploader_last_job = pjob;
+  pthread_cond_signal(&uploader_job_condvar);
+  V(uploader_mutex);
+
+  return 0;
+}                               /* nfs_uploader_queue */
+
+/**
+ * nfs_uploader_done: a file of the current segment is done.
+ *
+ * @param pfile the file.
+ * @param rc 0 if it was uploaded, -1 otherwise.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_uploader_done(nfs_uploader_file_t * pfile, int rc)
+{
+  if(pfile->image != NULL)
+    Mem_Free(pfile->image);
+  pfile->image = NULL;
+
+  if(rc != 0)
+    __sync_fetch_and_add(&uploader_stat.nb_failures, 1);
+
+  P(uploader_mutex);
+  uploader_pending -= 1;
+  if(rc != 0)
+    uploader_failed += 1;
+  if(uploader_pending == 0)
+    pthread_cond_signal(&uploader_done_condvar);
+  V(uploader_mutex);
+}                               /* nfs_uploader_done */
+
+/**
+ * nfs_uploader_put: sends a whole object by a single PUT.
+ *
+ * @param pconn the connection.
+ * @param pfile the file.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_put(nfs_uploader_connection_t * pconn, nfs_uploader_file_t * pfile)
+{
+  nfs_uploader_response_t response;
+
+  __sync_fetch_and_add(&uploader_stat.nb_puts, 1);
+
+  if(nfs_uploader_request(pconn, "PUT", pfile->key, "", pfile->image, pfile->image_size,
+                          &response) != 0)
+    return -1;
+  nfs_uploader_free_response(&response);
+
+  if(response.status != 200)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: PUT %s got status %d",
+               pfile->key, response.status);
+      return -1;
+    }
+
+  __sync_fetch_and_add(&uploader_stat.nb_bytes, pfile->image_size);
+
+  return 0;
+}                               /* nfs_uploader_put */
+
+/**
+ * nfs_uploader_delete: removes an object.
+ *
+ * @param pconn the connection.
+ * @param pfile the file.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_delete(nfs_uploader_connection_t * pconn,
+                               nfs_uploader_file_t * pfile)
+{
+  nfs_uploader_response_t response;
+
+  __sync_fetch_and_add(&uploader_stat.nb_deletes, 1);
+
+  if(nfs_uploader_request(pconn, "DELETE", pfile->key, "", NULL, 0, &response) != 0)
+    return -1;
+  nfs_uploader_free_response(&response);
+
+  /* The object may never have been uploaded */
+  if(response.status != 200 && response.status != 204 && response.status != 404)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: DELETE %s got status %d",
+               pfile->key, response.status);
+      return -1;
+    }
+
+  return 0;
+}                               /* nfs_uploader_delete */
+
+/**
+ * nfs_uploader_initiate: starts the multipart upload of an object, and queues its parts.
+ *
+ * @param pconn the connection.
+ * @param pfile the file.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_initiate(nfs_uploader_connection_t * pconn,
+                                 nfs_uploader_file_t * pfile)
+{
+  nfs_uploader_response_t response;
+  char *upload_id;
+  char *begin;
+  char *end;
+  unsigned int part;
+
+  if(nfs_uploader_request(pconn, "POST", pfile->key, "?uploads", NULL, 0, &response) != 0)
+    return -1;
+
+  if(response.status != 200 || response.body == NULL
+     || (begin = strstr(response.body, "<UploadId>")) == NULL
+     || (end = strstr(begin, "</UploadId>")) == NULL)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: multipart upload of %s not started, status %d",
+               pfile->key, response.status);
+      nfs_uploader_free_response(&response);
+      return -1;
+    }
+
+  begin += strlen("<UploadId>");
+  upload_id = nfs_uploader_encode(begin, end - begin, FALSE);
+  nfs_uploader_free_response(&response);
+
+  if(upload_id == NULL || strlen(upload_id) >= NFS_UPLOADER_UPLOAD_ID_LEN)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: bad upload id for %s", pfile->key);
+      if(upload_id != NULL)
+        Mem_Free(upload_id);
+      return -1;
+    }
+
+  strcpy(pfile->upload_id, upload_id);
+  Mem_Free(upload_id);
+
+  pfile->nb_parts = (pfile->image_size + uploader_param.part_size - 1) /
+      uploader_param.part_size;
+  if((pfile->etags =
+      (char (*)[NFS_UPLOADER_ETAG_LEN])Mem_Alloc(pfile->nb_parts *
+                                                 NFS_UPLOADER_ETAG_LEN)) == NULL)
+    return -1;
+
+  pfile->failed = FALSE;
+  pfile->parts_left = pfile->nb_parts;
+  __sync_synchronize();
+
+  for(part = 1; part <= pfile->nb_parts; part++)
+    if(nfs_uploader_queue(pfile, part) != 0)
+      {
+        /* The parts not queued fail */
+        pfile->failed = TRUE;
+        if(__sync_sub_and_fetch(&pfile->parts_left, pfile->nb_parts - part + 1) == 0)
+          {
+            Mem_Free(pfile->etags);
+            pfile->etags = NULL;
+            return -1;
+          }
+        break;
+      }
+
+  return 0;
+}                               /* nfs_uploader_initiate */
+
+/**
+ * nfs_uploader_complete: completes (or aborts, if a part failed) a multipart upload.
+ *
+ * @param pconn the connection.
+ * @param pfile the file.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_complete(nfs_uploader_connection_t * pconn,
+                                 nfs_uploader_file_t * pfile)
+{
+  nfs_uploader_response_t response;
+  char query[NFS_UPLOADER_UPLOAD_ID_LEN + 16];
+  char *body;
+  size_t body_size;
+  size_t len;
+  unsigned int part;
+  int rc = -1;
+
+  snprintf(query, sizeof(query), "?uploadId=%s", pfile->upload_id);
+
+  if(pfile->failed)
+    {
+      if(nfs_uploader_request(pconn, "DELETE", pfile->key, query, NULL, 0, &response) == 0)
+        nfs_uploader_free_response(&response);
+      return -1;
+    }
+
+  body_size = 64 + pfile->nb_parts * (64 + NFS_UPLOADER_ETAG_LEN);
+  if((body = (char *)Mem_Alloc(body_size)) == NULL)
+    return -1;
+
+  len = snprintf(body, body_size, "<CompleteMultipartUpload>");
+  for(part = 1; part <= pfile->nb_parts; part++)
+    len += snprintf(body + len, body_size - len,
+                    "<Part><PartNumber>%u</PartNumber><ETag>%s</ETag></Part>",
+                    part, pfile->etags[part - 1]);
+  len += snprintf(body + len, body_size - len, "</CompleteMultipartUpload>");
+
+  if(nfs_uploader_request(pconn, "POST", pfile->key, query, body, len, &response) == 0)
+    {
+      /* S3 may report an error in the body of a 200 */
+      if(response.status == 200
+         && (response.body == NULL || strstr(response.body, "<Error>") == NULL))
+        rc = 0;
+      else
+        LogMajor(COMPONENT_MAIN, "NFS UPLOADER: multipart upload of %s not completed, status %d",
+                 pfile->key, response.status);
+      nfs_uploader_free_response(&response);
+    }
+
+  Mem_Free(body);
+
+  return rc;
+}                               /* nfs_uploader_complete */
+
+/**
+ * nfs_uploader_put_part: sends a part of a multipart upload.
+ *
+ * The last part sent completes the upload.
+ *
+ * @param pconn the connection.
+ * @param pfile the file.
+ * @param part the number of the part (from 1).
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_uploader_put_part(nfs_uploader_connection_t * pconn,
+                                  nfs_uploader_file_t * pfile, unsigned int part)
+{
+  nfs_uploader_response_t response;
+  char query[NFS_UPLOADER_UPLOAD_ID_LEN + 64];
+  uint64_t offset = (uint64_t) (part - 1) * uploader_param.part_size;
+  uint64_t length = pfile->image_size - offset;
+  int rc;
+
+  if(length > uploader_param.part_size)
+    length = uploader_param.part_size;
+
+  if(!pfile->failed)
+    {
+      __sync_fetch_and_add(&uploader_stat.nb_parts, 1);
+
+      snprintf(query, sizeof(query), "?partNumber=%u&uploadId=%s", part, pfile->upload_id);
+
+      if(nfs_uploader_request(pconn, "PUT", pfile->key, query,
+                              pfile->image + offset, length, &response) != 0)
+        pfile->failed = TRUE;
+      else
+        {
+          nfs_uploader_free_response(&response);
+
+          if(response.status != 200 || response.etag[0] == '\0')
+            {
+              LogMajor(COMPONENT_MAIN, "NFS UPLOADER: part %u of %s got status %d",
+                       part, pfile->key, response.status);
+              pfile->failed = TRUE;
+            }
+          else
+            {
+              strcpy(pfile->etags[part - 1], response.etag);
+              __sync_fetch_and_add(&uploader_stat.nb_bytes, length);
+            }
+        }
+    }
+
+  if(__sync_sub_and_fetch(&pfile->parts_left, 1) != 0)
+    return;
+
+  /* The last part */
+  rc = nfs_uploader_complete(pconn, pfile);
+
+  Mem_Free(pfile->etags);
+  pfile->etags = NULL;
+
+  nfs_uploader_done(pfile, rc);
+}                               /* nfs_uploader_put_part */
+
+/**
+ * nfs_uploader_upload: uploads a file.
+ *
+ * @param pconn the connection.
+ * @param pfile the file.
+ *
+ * @return nothing (void function)
+ *
+ */
+static void nfs_uploader_upload(nfs_uploader_connection_t * pconn, nfs_uploader_file_t * pfile)
+{
+  int rc;
+
+  __sync_fetch_and_add(&uploader_stat.nb_files, 1);
+
+  /* Removed, and not written again */
+  if(pfile->removed && pfile->nb_extents == 0)
+    {
+      nfs_uploader_done(pfile, nfs_uploader_delete(pconn, pfile));
+      return;
+    }
+
+  if(nfs_uploader_build_image(pconn, pfile) != 0)
+    {
+      nfs_uploader_done(pfile, -1);
+      return;
+    }
+
+  if(pfile->image_size <= uploader_param.part_size)
+    rc = nfs_uploader_put(pconn, pfile);
+  else if((rc = nfs_uploader_initiate(pconn, pfile)) == 0)
+    return;                     /* the last part calls nfs_uploader_done */
+
+  nfs_uploader_done(pfile, rc);
+}                               /* nfs_uploader_upload */
+
+/**
+ * nfs_uploader_connection_thread: a thread of the pool of connections.
+ *
+ * @param Arg (unused)
+ *
+ * @return Pointer to the result (but this function will mostly loop forever).
+ *
+ */
+static void *nfs_uploader_connection_thread(void *Arg)
+{
+  nfs_uploader_connection_t *pconn;
+  nfs_uploader_job_t *pjob;
+  int rc;
+
+  SetNameFunction("uploader_conn");
+
+#ifndef _NO_BUDDY_SYSTEM
+  if((rc = BuddyInit(uploader_buddy_param)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_MAIN, "NFS UPLOADER: Memory manager could not be initialized, exiting...");
+      exit(1);
+    }
+#endif
+
+  if((pconn = (nfs_uploader_connection_t *) Mem_Alloc(sizeof(nfs_uploader_connection_t))) ==
+     NULL)
+    {
+      LogCrit(COMPONENT_MAIN, "NFS UPLOADER: can't allocate a connection, exiting...");
+      exit(1);
+    }
+  pconn->fd = -1;
+  pconn->start = 0;
+  pconn->end = 0;
+
+  while(TRUE)
+    {
+      P(uploader_mutex);
+      while(uploader_first_job == NULL)
+        pthread_cond_wait(&uploader_job_condvar, &uploader_mutex);
+
+      pjob = uploader_first_job;
+      if((uploader_first_job = pjob->next) == NULL)
+        uploader_last_job = NULL;
+      V(uploader_mutex);
+
+      if(pjob->part == 0)
+        nfs_uploader_upload(pconn, pjob->pfile);
+      else
+        nfs_uploader_put_part(pconn, pjob->pfile, pjob->part);
+
+      Mem_Free(pjob);
+    }
+
+  return NULL;
+}                               /* nfs_uploader_connection_thread */
+
+/**
+ * nfs_uploader_save_state: records where to start from in the journal.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_save_state(void)
+{
+  char path[MAXPATHLEN];
+  char tmp_path[MAXPATHLEN];
+  FILE *file;
+
+  if(snprintf(path, MAXPATHLEN, "%s/%s", uploader_directory,
+              NFS_UPLOADER_STATE_FILE) >= MAXPATHLEN
+     || snprintf(tmp_path, MAXPATHLEN, "%s.tmp", path) >= MAXPATHLEN)
+    return -1;
+
+  if((file = fopen(tmp_path, "w")) == NULL)
+    return -1;
+
+  fprintf(file, "%u %llu\n", uploader_segment, uploader_offset);
+
+  if(fflush(file) != 0 || fsync(fileno(file)) != 0)
+    {
+      fclose(file);
+      return -1;
+    }
+  fclose(file);
+
+  /* Replaced atomically */
+  return rename(tmp_path, path);
+}                               /* nfs_uploader_save_state */
+
+/**
+ * nfs_uploader_add_record: adds a record to the files of the segment.
+ *
+ * @param hash the table of the files of the segment.
+ * @param ppfirst the list of the files of the segment (first).
+ * @param pplast the list of the files of the segment (last).
+ * @param precord the header of the record.
+ * @param payload the path and data of the record.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+static int nfs_uploader_add_record(nfs_uploader_file_t ** hash,
+                                   nfs_uploader_file_t ** ppfirst,
+                                   nfs_uploader_file_t ** pplast,
+                                   nfs_journal_record_t * precord, caddr_t payload)
+{
+  nfs_uploader_file_t *pfile;
+  nfs_uploader_extent_t *extents;
+  unsigned int bucket = 5381;
+  unsigned int i;
+  caddr_t path = payload;
+  unsigned int path_length = precord->path_length;
+
+  /* Skip the '/' at the beginning: they are not part of the name of an object */
+  while(path_length > 0 && *path == '/')
+    {
+      path++;
+      path_length--;
+    }
+
+  if(path_length == 0)
+    {
+      LogMajor(COMPONENT_MAIN, "NFS UPLOADER: no path for fileid %llu, record skipped",
+               (unsigned long long)precord->fileid);
+      return 0;
+    }
+
+  for(i = 0; i < path_length; i++)
+    bucket = bucket * 33 + (unsigned char)path[i];
+  bucket %= NFS_UPLOADER_HASH_SIZE;
+
+  for(pfile = hash[bucket]; pfile != NULL; pfile = pfile->next_hash)
+    if(pfile->path_length == path_length && !memcmp(pfile->path, path, path_length))
+      break;
+
+  if(pfile == NULL)
+    {
+      if((pfile = (nfs_uploader_file_t *) Mem_Alloc(sizeof(nfs_uploader_file_t))) == NULL)
+        return -1;
+
+      memset(pfile, 0, sizeof(nfs_uploader_file_t));
+      pfile->path = path;
+      pfile->path_length = path_length;
+      if((pfile->key = nfs_uploader_encode(path, path_length, TRUE)) == NULL)
+        {
+          Mem_Free(pfile);
+          return -1;
+        }
+
+      pfile->next_hash = hash[bucket];
+      hash[bucket] = pfile;
+
+      if(*pplast == NULL)
+        *ppfirst = pfile;
+      else
+        (*pplast)->next = pfile;
+      *pplast = pfile;
+    }
+
+  if(precord->type == NFS_JOURNAL_REMOVE)
+    {
+      pfile->removed = TRUE;
+      pfile->nb_extents = 0;
+      pfile->size = 0;
+      return 0;
+    }
+
+  if(pfile->nb_extents == pfile->max_extents)
+    {
+      pfile->max_extents = (pfile->max_extents == 0) ? 8 : 2 * pfile->max_extents;
+      if((extents = (nfs_uploader_extent_t *) Mem_Realloc(pfile->extents,
+                                                          pfile->max_extents *
+                                                          sizeof(nfs_uploader_extent_t))) ==
+         NULL)
+        return -1;
+      pfile->extents = extents;
+    }
+
+  pfile->extents[pfile->nb_extents].offset = precord->offset;
+  pfile->extents[pfile->nb_extents].length = precord->length;
+  pfile->extents[pfile->nb_extents].data = payload + precord->path_length;
+  pfile->nb_extents += 1;
+
+  if(precord->offset + precord->length > pfile->size)
+    pfile->size = precord->offset + precord->length;
+
+  return 0;
+}                               /* nfs_uploader_add_record */
+
+/**
+ * nfs_uploader_process_segment: uploads the files modified in a segment.
+ *
+ * @param segment the number of the segment.
+ * @param closed TRUE if the segment will not be written anymore.
+ *
+ * @return the number of records uploaded, -1 if an error occured.
+ *
+ */
+static int nfs_uploader_process_segment(unsigned int segment, int closed)
+{
+  char segment_path[MAXPATHLEN];
+  nfs_uploader_file_t **hash = NULL;
+  nfs_uploader_file_t *first = NULL;
+  nfs_uploader_file_t *last = NULL;
+  nfs_uploader_file_t *pfile;
+  nfs_uploader_file_t *next;
+  nfs_journal_record_t record;
+  unsigned long long offset;
+  unsigned int nb_records = 0;
+  unsigned int nb_files = 0;
+  caddr_t map = MAP_FAILED;
+  struct stat buffstat;
+  ssize_t record_size = 0;
+  int rc = -1;
+  int fd;
+
+  if(snprintf(segment_path, MAXPATHLEN, NFS_JOURNAL_SEGMENT_FORMAT,
+              uploader_directory, segment) >= MAXPATHLEN)
+    {
+      LogCrit(COMPONENT_MAIN, "NFS UPLOADER: path of segment %u is too long", segment);
+      return -1;
+    }
+
+  offset = (segment == uploader_segment) ? uploader_offset : 0;
+
+  if((fd = open(segment_path, O_RDONLY)) < 0 || fstat(fd, &buffstat) != 0)
+    {
+      LogCrit(COMPONENT_MAIN, "NFS UPLOADER: can't open segment %s, errno=%d",
+              segment_path, errno);
+      if(fd >= 0)
+        close(fd);
+      return -1;
+    }
+
+  if((unsigned long long)buffstat.st_size > offset)
+    {
+      if((map = (caddr_t) mmap(NULL, buffstat.st_size, PROT_READ, MAP_PRIVATE, fd, 0)) ==
+         MAP_FAILED)
+        {
+          LogCrit(COMPONENT_MAIN, "NFS UPLOADER: can't map segment %s, errno=%d",
+                  segment_path, errno);
+          goto out;
+        }
+
+      if((hash = (nfs_uploader_file_t **) Mem_Calloc(NFS_UPLOADER_HASH_SIZE,
+                                                      sizeof(nfs_uploader_file_t *))) == NULL)
+        goto out;
+
+      /* Gather the records per file */
+      while(offset < (unsigned long long)buffstat.st_size)
+        {
+          record_size = nfs_journal_parse_record(map + offset, buffstat.st_size - offset,
+                                                 &record);
+          if(record_size <= 0)
+            break;
+
+          if(nfs_uploader_add_record(hash, &first, &last, &record,
+                                     map + offset + sizeof(nfs_journal_record_t)) != 0)
+            goto out;
+
+          nb_records += 1;
+          offset += record_size;
+        }
+
+      if(record_size < 0)
+        {
+          /* Nothing can be read beyond a corrupted record */
+          LogCrit(COMPONENT_MAIN,
+                  "NFS UPLOADER: corrupted record at offset %llu of segment %s, the rest of the segment is lost",
+                  offset, segment_path);
+          offset = buffstat.st_size;
+        }
+      else if(record_size == 0 && closed && offset < (unsigned long long)buffstat.st_size)
+        LogCrit(COMPONENT_MAIN, "NFS UPLOADER: segment %s is truncated at offset %llu",
+                segment_path, offset);
+
+      /* Upload the files */
+      for(pfile = first; pfile != NULL; pfile = pfile->next)
+        nb_files += 1;
+
+      P(uploader_mutex);
+      uploader_pending = nb_files;
+      uploader_failed = 0;
+      V(uploader_mutex);
+
+      for(pfile = first; pfile != NULL; pfile = pfile->next)
+        if(nfs_uploader_queue(pfile, 0) != 0)
+          nfs_uploader_done(pfile, -1);
+
+      P(uploader_mutex);
+      while(uploader_pending > 0)
+        pthread_cond_wait(&uploader_done_condvar, &uploader_mutex);
+      V(uploader_mutex);
+
+      if(uploader_failed > 0)
+        {
+          LogMajor(COMPONENT_MAIN,
+                   "NFS UPLOADER: %u of the %u files of segment %s could not be uploaded, will retry",
+                   uploader_failed, nb_files, segment_path);
+          goto out;
+        }
+
+      __sync_fetch_and_add(&uploader_stat.nb_records, nb_records);
+
+      LogDebug(COMPONENT_MAIN, "NFS UPLOADER: %u records of segment %s uploaded as %u files",
+               nb_records, segment_path, nb_files);
+    }
+
+  /* Move forward */
+  if(closed)
+    {
+      if(unlink(segment_path) != 0)
+        LogMajor(COMPONENT_MAIN, "NFS UPLOADER: can't remove segment %s, errno=%d",
+                 segment_path, errno);
+      uploader_segment = segment + 1;
+      uploader_offset = 0;
+    }
+  else
+    {
+      uploader_segment = segment;
+      uploader_offset = offset;
+    }
+
+  if(nfs_uploader_save_state() != 0)
+    LogMajor(COMPONENT_MAIN, "NFS UPLOADER: can't save the state in %s, errno=%d",
+             uploader_directory, errno);
+
+  rc = nb_records;
+
+ out:
+  for(pfile = first; pfile != NULL; pfile = next)
+    {
+      next = pfile->next;
+      if(pfile->extents != NULL)
+        Mem_Free(pfile->extents);
+      Mem_Free(pfile->key);
+      Mem_Free(pfile);
+    }
+
+  if(hash != NULL)
+    Mem_Free(hash);
+
+  if(map != MAP_FAILED)
+    munmap(map, buffstat.st_size);
+  close(fd);
+
+  return rc;
+}                               /* nfs_uploader_process_segment */
+
+/**
+ * nfs_uploader_next_segment: finds the next segment to be uploaded.
+ *
+ * @param psegment [OUT] the number of the segment.
+ * @param pclosed [OUT] TRUE if a newer segment exists.
+ *
+ * @return 0 if a segment was found, 1 if there is none, -1 if an error occured.
+ *
+ */
+static int nfs_uploader_next_segment(unsigned int *psegment, int *pclosed)
+{
+  struct dirent *dirent;
+  unsigned int segment;
+  int found = FALSE;
+  DIR *dir;
+
+  if((dir = opendir(uploader_directory)) == NULL)
+    {
+      LogCrit(COMPONENT_MAIN, "NFS UPLOADER: can't open directory %s, errno=%d",
+              uploader_directory, errno);
+      return -1;
+    }
+
+  *pclosed = FALSE;
+  while((dirent = readdir(dir)) != NULL)
+    {
+      if(sscanf(dirent->d_name, NFS_JOURNAL_SEGMENT_PREFIX "%u", &segment) != 1
+         || segment < uploader_segment)
+        continue;
+
+      if(!found || segment < *psegment)
+        {
+          if(found)
+            *pclosed = TRUE;
+          *psegment = segment;
+          found = TRUE;
+        }
+      else if(segment > *psegment)
+        *pclosed = TRUE;
+    }
+  closedir(dir);
+
+  return found ? 0 : 1;
+}                               /* nfs_uploader_next_segment */
+
+/**
+ * nfs_uploader_init: initializes the uploader.
+ *
+ * @param pparam the uploader parameters.
+ * @param journal_directory the directory of the journal.
+ * @param pbuddy_param the parameters of the memory manager of the uploader threads.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_uploader_init(nfs_uploader_parameter_t * pparam,
+                      char *journal_directory, buddy_parameter_t * pbuddy_param)
+{
+  char path[MAXPATHLEN];
+  FILE *file;
+
+  uploader_param = *pparam;
+  strncpy(uploader_directory, journal_directory, sizeof(uploader_directory) - 1);
+  uploader_directory[sizeof(uploader_directory) - 1] = '\0';
+  uploader_buddy_param = pbuddy_param;
+  memset(&uploader_stat, 0, sizeof(uploader_stat));
+
+  if(!uploader_param.enable)
+    return 0;
+
+  uploader_segment = 0;
+  uploader_offset = 0;
+
+  if(snprintf(path, MAXPATHLEN, "%s/%s", uploader_directory,
+              NFS_UPLOADER_STATE_FILE) >= MAXPATHLEN)
+    {
+      LogCrit(COMPONENT_INIT, "NFS UPLOADER: directory %s is too long", uploader_directory);
+      return -1;
+    }
+
+  if((file = fopen(path, "r")) != NULL)
+    {
+      if(fscanf(file, "%u %llu", &uploader_segment, &uploader_offset) != 2)
+        {
+          LogCrit(COMPONENT_INIT, "NFS UPLOADER: bad state in %s", path);
+          fclose(file);
+          return -1;
+        }
+      fclose(file);
+    }
+
+  LogEvent(COMPONENT_INIT,
+           "NFS UPLOADER: uploading %s to %s:%u/%s from segment #%u offset %llu, %u connections",
+           uploader_directory, uploader_param.host, uploader_param.port,
+           uploader_param.bucket, uploader_segment, uploader_offset,
+           uploader_param.nb_connections);
+
+  return 0;
+}                               /* nfs_uploader_init */
+
+/**
+ * nfs_uploader_start: starts the pool of connections.
+ *
+ * @return 0 if successfull, -1 otherwise.
+ *
+ */
+int nfs_uploader_start(void)
+{
+  pthread_attr_t attr_thr;
+  pthread_t thrid;
+  unsigned int i;
+  int rc;
+
+  pthread_attr_init(&attr_thr);
+  pthread_attr_setdetachstate(&attr_thr, PTHREAD_CREATE_DETACHED);
+
+  for(i = 0; i < uploader_param.nb_connections; i++)
+    if((rc = pthread_create(&thrid, &attr_thr, nfs_uploader_connection_thread, NULL)) != 0)
+      {
+        LogCrit(COMPONENT_MAIN, "NFS UPLOADER: can't create connection thread #%u, error=%d",
+                i, rc);
+        return -1;
+      }
+
+  return 0;
+}                               /* nfs_uploader_start */
+
+/**
+ * nfs_uploader_run: uploads what is in the journal.
+ *
+ * @return the number of records uploaded, -1 if an error occured.
+ *
+ */
+int nfs_uploader_run(void)
+{
+  unsigned int segment;
+  int nb_records = 0;
+  int closed;
+  int rc;
+
+  while((rc = nfs_uploader_next_segment(&segment, &closed)) == 0)
+    {
+      if((rc = nfs_uploader_process_segment(segment, closed)) < 0)
+        return -1;
+
+      nb_records += rc;
+
+      /* The current segment is done for now */
+      if(!closed)
+        break;
+    }
+
+  return (rc < 0) ? -1 : nb_records;
+}                               /* nfs_uploader_run */
+
+/**
+ * nfs_uploader_get_stats: gets the statistics of the uploader.
+ *
+ * @param pstat [OUT] the statistics.
+ *
+ * @return nothing (void function)
+ *
+ */
+void nfs_uploader_get_stats(nfs_uploader_stat_t * pstat)
+{
+  *pstat = uploader_stat;
+}                               /* nfs_uploader_get_stats */
+
+/**
+ * nfs_uploader_thread: the thread uploading the journal.
+ *
+ * @param Arg (unused)
+ *
+ * @return Pointer to the result (but this function will mostly loop forever).
+ *
+ */
+void *nfs_uploader_thread(void *Arg)
+{
+  int rc;
+
+  SetNameFunction("uploader");
+
+  if(!uploader_param.enable)
+    return NULL;
+
+#ifndef _NO_BUDDY_SYSTEM
+  if((rc = BuddyInit(uploader_buddy_param)) != BUDDY_SUCCESS)
+    {
+      /* Failed init */
+      LogCrit(COMPONENT_MAIN, "NFS UPLOADER: Memory manager could not be initialized, exiting...");
+      exit(1);
+    }
+#endif
+
+  if(nfs_uploader_start() != 0)
+    exit(1);
+
+  while(TRUE)
+    {
+      if((rc = nfs_uploader_run()) > 0)
+        LogDebug(COMPONENT_MAIN,
+                 "NFS UPLOADER: %d records uploaded, files=%llu puts=%llu parts=%llu deletes=%llu gets=%llu retries=%llu failures=%llu bytes=%llu",
+                 rc, uploader_stat.nb_files, uploader_stat.nb_puts, uploader_stat.nb_parts,
+                 uploader_stat.nb_deletes, uploader_stat.nb_gets, uploader_stat.nb_retries,
+                 uploader_stat.nb_failures, uploader_stat.nb_bytes);
+
+      /* Let the records accumulate in the current segment, so that they are coalesced */
+      sleep(uploader_param.scan_period);
+    }
+
+  return NULL;
+}                               /* nfs_uploader_thread */
@@ -0,0 +1,651 @@
+/*
+ * vim:expandtab:shiftwidth=8:tabstop=8:
+ *
+ * Copyright CEA/DAM/DIF  (2008)
+ * contributeur : Philippe DENIEL   philippe.deniel@cea.fr
+ *                Thomas LEIBOVICI  thomas.leibovici@cea.fr
+ *
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public
+ * License as published by the Free Software Foundation; either
+ * version 3 of the License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this library; if not, write to the Free Software
+ * Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301  USA
+ *
+ * ---------------------------------------
+ *
+ * Test of the uploader of the journal, against a local stand-in of an S3 object store
+ * (PUT, GET, HEAD, DELETE and multipart uploads, with path style requests). The stand-in
+ * fails some of the requests with a 503, and closes some of the connections, so that the
+ * retries are exercised.
+ *
+ */
+#ifdef HAVE_CONFIG_H
+#include "config.h"
+#endif
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <pthread.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/types.h>
+#include <sys/stat.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include "BuddyMalloc.h"
+#include "log_macros.h"
+#include "nfs_journal.h"
+#include "nfs_uploader.h"
+
+#define BUCKET "testbucket"
+#define PART_SIZE (64 * 1024)
+#define MAX_OBJECTS 64
+#define MAX_PARTS 64
+#define FAIL_EVERY 7            /* one request out of FAIL_EVERY gets a 503 */
+#define CLOSE_EVERY 5           /* one response out of CLOSE_EVERY closes the connection */
+
+/* The objects of the stand-in, and of the expected content of the bucket */
+typedef struct object__
+{
+  char key[MAXPATHLEN];
+  char *data;
+  size_t length;
+  int exists;
+} object_t;
+
+typedef struct store__
+{
+  object_t objects[MAX_OBJECTS];
+  object_t parts[MAX_PARTS];    /* of the pending multipart upload */
+  int upload_started;
+} store_t;
+
+static store_t server;
+static store_t expected;
+static pthread_mutex_t server_mutex = PTHREAD_MUTEX_INITIALIZER;
+static unsigned int nb_requests = 0;
+static unsigned int nb_multipart = 0;
+static int listen_fd;
+static char journal_dir[MAXPATHLEN];
+
+static object_t *find_object(store_t * pstore, const char *key, int create)
+{
+  int i;
+
+  for(i = 0; i < MAX_OBJECTS; i++)
+    if(pstore->objects[i].exists && !strcmp(pstore->objects[i].key, key))
+      return &pstore->objects[i];
+
+  if(!create)
+    return NULL;
+
+  for(i = 0; i < MAX_OBJECTS; i++)
+    if(!pstore->objects[i].exists)
+      {
+        strcpy(pstore->objects[i].key, key);
+        pstore->objects[i].data = NULL;
+        pstore->objects[i].length = 0;
+        pstore->objects[i].exists = TRUE;
+        return &pstore->objects[i];
+      }
+
+  return NULL;
+}                               /* find_object */
+
+static void set_object(store_t * pstore, const char *key, const char *data, size_t length)
+{
+  object_t *pobj = find_object(pstore, key, TRUE);
+
+  pobj->data = realloc(pobj->data, length + 1);
+  memcpy(pobj->data, data, length);
+  pobj->length = length;
+}                               /* set_object */
+
+static void delete_object(store_t * pstore, const char *key)
+{
+  object_t *pobj = find_object(pstore, key, FALSE);
+
+  if(pobj != NULL)
+    {
+      free(pobj->data);
+      pobj->exists = FALSE;
+    }
+}                               /* delete_object */
+
+/* Writes to the expected content, as the uploader should apply them */
+static void write_object(store_t * pstore, const char *key, size_t offset, const char *data,
+                         size_t length)
+{
+  object_t *pobj = find_object(pstore, key, TRUE);
+
+  if(offset + length > pobj->length)
+    {
+      pobj->data = realloc(pobj->data, offset + length);
+      memset(pobj->data + pobj->length, 0, offset + length - pobj->length);
+      pobj->length = offset + length;
+    }
+  memcpy(pobj->data + offset, data, length);
+}                               /* write_object */
+
+static int read_full(int fd, char *buf, size_t len)
+{
+  ssize_t rc;
+
+  while(len > 0)
+    {
+      if((rc = recv(fd, buf, len, 0)) <= 0)
+        return -1;
+      buf += rc;
+      len -= rc;
+    }
+  return 0;
+}                               /* read_full */
+
+/* Reads the request line and headers, byte by byte (no pipelining from the uploader) */
+static int read_head(int fd, char *head, size_t size)
+{
+  size_t len = 0;
+
+  while(len < size - 1)
+    {
+      if(recv(fd, head + len, 1, 0) != 1)
+        return -1;
+      len++;
+      if(len >= 4 && !memcmp(head + len - 4, "\r\n\r\n", 4))
+        {
+          head[len] = '\0';
+          return 0;
+        }
+    }
+  return -1;
+}                               /* read_head */
+
+static void reply(int fd, int status, const char *extra, const char *body, size_t length,
+                  int close_it)
+{
+  char head[1024];
+  int len;
+
+  len = snprintf(head, sizeof(head),
+                 "HTTP/1.1 %d X\r\nContent-Length: %llu\r\n%s%s\r\n",
+                 status, (unsigned long long)length, extra,
+                 close_it ? "Connection: close\r\n" : "");
+  send(fd, head, len, MSG_NOSIGNAL);
+  if(length > 0)
+    send(fd, body, length, MSG_NOSIGNAL);
+}                               /* reply */
+
+/* A connection to the stand-in */
+static void *server_connection(void *arg)
+{
+  int fd = (int)(long)arg;
+  char head[8192];
+  char method[16];
+  char target[MAXPATHLEN];
+  char key[MAXPATHLEN];
+  char etag[64];
+  char *query;
+  char *clen;
+  char *body;
+  char *p;
+  char *q;
+  size_t length;
+  unsigned int request;
+  unsigned int part;
+  object_t *pobj;
+  int close_it;
+
+  while(read_head(fd, head, sizeof(head)) == 0)
+    {
+      if(sscanf(head, "%15s %1023s", method, target) != 2)
+        break;
+
+      length = 0;
+      if((clen = strstr(head, "Content-Length: ")) != NULL)
+        length = strtoul(clen + strlen("Content-Length: "), NULL, 10);
+
+      body = malloc(length + 1);
+      if(read_full(fd, body, length) != 0)
+        {
+          free(body);
+          break;
+        }
+      body[length] = '\0';
+
+      /* Decode /bucket/key?query */
+      if((query = strchr(target, '?')) != NULL)
+        *query++ = '\0';
+      else
+        query = "";
+
+      if(strncmp(target, "/" BUCKET "/", strlen(BUCKET) + 2))
+        {
+          reply(fd, 404, "", NULL, 0, FALSE);
+          free(body);
+          continue;
+        }
+
+      for(p = target + strlen(BUCKET) + 2, q = key; *p != '\0'; q++)
+        {
+          if(*p == '%')
+            {
+              unsigned int c;
+              sscanf(p + 1, "%2x", &c);
+              *q = (char)c;
+              p += 3;
+            }
+          else
+            *q = *p++;
+        }
+      *q = '\0';
+
+      pthread_mutex_lock(&server_mutex);
+
+      request = ++nb_requests;
+      close_it = (request % CLOSE_EVERY == 0);
+
+      if(request % FAIL_EVERY == 0)
+        reply(fd, 503, "", "<Error>SlowDown</Error>", 23, close_it);
+      else if(!strcmp(method, "PUT") && !strncmp(query, "partNumber=", 11))
+        {
+          part = atoi(query + 11);
+          if(!server.upload_started || part == 0 || part > MAX_PARTS
+             || strstr(query, "uploadId=id%2Fone") == NULL)
+            reply(fd, 400, "", NULL, 0, close_it);
+          else
+            {
+              free(server.parts[part - 1].data);
+              server.parts[part - 1].data = body;
+              server.parts[part - 1].length = length;
+              server.parts[part - 1].exists = TRUE;
+              body = NULL;
+              snprintf(etag, sizeof(etag), "ETag: \"etag%u\"\r\n", part);
+              reply(fd, 200, etag, NULL, 0, close_it);
+            }
+        }
+      else if(!strcmp(method, "PUT"))
+        {
+          set_object(&server, key, body, length);
+          reply(fd, 200, "ETag: \"x\"\r\n", NULL, 0, close_it);
+        }
+      else if(!strcmp(method, "GET") || !strcmp(method, "HEAD"))
+        {
+          if((pobj = find_object(&server, key, FALSE)) == NULL)
+            reply(fd, 404, "", NULL, 0, close_it);
+          else if(!strcmp(method, "GET"))
+            reply(fd, 200, "", pobj->data, pobj->length, close_it);
+          else
+            {
+              /* The length of the object, but no body */
+              char head_reply[128];
+              int len = snprintf(head_reply, sizeof(head_reply),
+                                 "HTTP/1.1 200 OK\r\nContent-Length: %llu\r\n\r\n",
+                                 (unsigned long long)pobj->length);
+              send(fd, head_reply, len, MSG_NOSIGNAL);
+            }
+        }
+      else if(!strcmp(method, "DELETE") && !strncmp(query, "uploadId=", 9))
+        {
+          server.upload_started = FALSE;
+          reply(fd, 204, "", NULL, 0, close_it);
+        }
+      else if(!strcmp(method, "DELETE"))
+        {
+          delete_object(&server, key);
+          reply(fd, 204, "", NULL, 0, close_it);
+        }
+      else if(!strcmp(method, "POST") && !strcmp(query, "uploads"))
+        {
+          const char *xml =
+              "<InitiateMultipartUploadResult><UploadId>id/one</UploadId></InitiateMultipartUploadResult>";
+          for(part = 0; part < MAX_PARTS; part++)
+            server.parts[part].exists = FALSE;
+          server.upload_started = TRUE;
+          reply(fd, 200, "", xml, strlen(xml), close_it);
+        }
+      else if(!strcmp(method, "POST") && !strncmp(query, "uploadId=", 9))
+        {
+          /* Concatenate the parts listed, checking their ETags */
+          char *data = NULL;
+          size_t total = 0;
+          char expected_part[128];
+          int ok = server.upload_started;
+
+          for(part = 1, p = body; ok && (p = strstr(p, "<Part>")) != NULL; part++, p++)
+            {
+              snprintf(expected_part, sizeof(expected_part),
+                       "<Part><PartNumber>%u</PartNumber><ETag>\"etag%u\"</ETag></Part>",
+                       part, part);
+              if(strncmp(p, expected_part, strlen(expected_part))
+                 || !server.parts[part - 1].exists)
+                {
+                  ok = FALSE;
+                  break;
+                }
+              data = realloc(data, total + server.parts[part - 1].length + 1);
+              memcpy(data + total, server.parts[part - 1].data,
+                     server.parts[part - 1].length);
+              total += server.parts[part - 1].length;
+            }
+
+          if(ok)
+            {
+              set_object(&server, key, data, total);
+              server.upload_started = FALSE;
+              nb_multipart += 1;
+              reply(fd, 200, "", "<CompleteMultipartUploadResult/>", 32, close_it);
+            }
+          else
+            reply(fd, 400, "", NULL, 0, close_it);
+          free(data);
+        }
+      else
+        reply(fd, 400, "", NULL, 0, close_it);
+
+      pthread_mutex_unlock(&server_mutex);
+
+      free(body);
+      if(close_it)
+        break;
+    }
+
+  close(fd);
+  return NULL;
+}                               /* server_connection */
+
+static void *server_thread(void *arg)
+{
+  pthread_t thrid;
+  int fd;
+
+  while((fd = accept(listen_fd, NULL, NULL)) >= 0)
+    {
+      pthread_create(&thrid, NULL, server_connection, (void *)(long)fd);
+      pthread_detach(thrid);
+    }
+  return NULL;
+}                               /* server_thread */
+
+/* Appends a record to a segment of the journal */
+static void journal_record(int fd, uint32_t type, const char *path, uint64_t offset,
+                           const char *data, uint32_t length, int truncated)
+{
+  nfs_journal_record_t record;
+  uint32_t checksum;
+
+  record.magic = NFS_JOURNAL_MAGIC;
+  record.type = type;
+  record.fileid = 1;
+  record.offset = offset;
+  record.length = length;
+  record.path_length = strlen(path);
+  record.checksum = 0;
+  record.padding = 0;
+
+  checksum = nfs_journal_adler32(1, (unsigned char *)&record, sizeof(record));
+  checksum = nfs_journal_adler32(checksum, (unsigned char *)path, record.path_length);
+  checksum = nfs_journal_adler32(checksum, (unsigned char *)data, length);
+  record.checksum = checksum;
+
+  write(fd, &record, sizeof(record));
+  write(fd, path, record.path_length);
+  write(fd, data, truncated ? length / 2 : length);
+
+  if(type == NFS_JOURNAL_WRITE && !truncated)
+    write_object(&expected, path + 1, offset, data, length);
+  else if(type == NFS_JOURNAL_REMOVE)
+    delete_object(&expected, path + 1);
+}                               /* journal_record */
+
+static int open_segment(unsigned int segment)
+{
+  char path[MAXPATHLEN];
+  int fd;
+
+  snprintf(path, MAXPATHLEN, NFS_JOURNAL_SEGMENT_FORMAT, journal_dir, segment);
+  if((fd = open(path, O_CREAT | O_WRONLY | O_APPEND, S_IRUSR | S_IWUSR)) < 0)
+    {
+      LogTest("Test FAILED: can't open %s, errno=%d", path, errno);
+      exit(1);
+    }
+  return fd;
+}                               /* open_segment */
+
+static int segment_exists(unsigned int segment)
+{
+  char path[MAXPATHLEN];
+
+  snprintf(path, MAXPATHLEN, NFS_JOURNAL_SEGMENT_FORMAT, journal_dir, segment);
+  return access(path, F_OK) == 0;
+}                               /* segment_exists */
+
+/* Checks that the stand-in holds the expected objects */
+static void check_store(const char *step)
+{
+  object_t *pexp;
+  object_t *pobj;
+  int i;
+
+  pthread_mutex_lock(&server_mutex);
+  for(i = 0; i < MAX_OBJECTS; i++)
+    {
+      pexp = &expected.objects[i];
+      if(server.objects[i].exists && find_object(&expected, server.objects[i].key, FALSE)
+         == NULL)
+        {
+          LogTest("Test FAILED (%s): object %s should not exist", step,
+                  server.objects[i].key);
+          exit(1);
+        }
+
+      if(!pexp->exists)
+        continue;
+
+      if((pobj = find_object(&server, pexp->key, FALSE)) == NULL)
+        {
+          LogTest("Test FAILED (%s): object %s is missing", step, pexp->key);
+          exit(1);
+        }
+
+      if(pobj->length != pexp->length || memcmp(pobj->data, pexp->data, pexp->length))
+        {
+          LogTest("Test FAILED (%s): object %s has a wrong content (%llu bytes instead of %llu)",
+                  step, pexp->key, (unsigned long long)pobj->length,
+                  (unsigned long long)pexp->length);
+          exit(1);
+        }
+    }
+  pthread_mutex_unlock(&server_mutex);
+
+  LogTest("%s: the bucket is as expected", step);
+}                               /* check_store */
+
+int main(int argc, char *argv[])
+{
+  nfs_uploader_parameter_t param;
+  nfs_uploader_stat_t stat;
+  struct sockaddr_in addr;
+  socklen_t addrlen = sizeof(addr);
+  pthread_t thrid;
+  char *big;
+  char block[1000];
+  char path[MAXPATHLEN];
+  char state[64];
+  FILE *file;
+  int fd;
+  int rc;
+  int i;
+
+  SetDefaultLogging("TEST");
+  SetNamePgm("test_uploader");
+
+  BuddyInit(NULL);
+
+  /* The stand-in */
+  listen_fd = socket(AF_INET, SOCK_STREAM, 0);
+  memset(&addr, 0, sizeof(addr));
+  addr.sin_family = AF_INET;
+  addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  addr.sin_port = 0;
+  if(bind(listen_fd, (struct sockaddr *)&addr, sizeof(addr)) != 0
+     || listen(listen_fd, 16) != 0
+     || getsockname(listen_fd, (struct sockaddr *)&addr, &addrlen) != 0)
+    {
+      LogTest("Test FAILED: can't start the stand-in, errno=%d", errno);
+      exit(1);
+    }
+  pthread_create(&thrid, NULL, server_thread, NULL);
+
+  snprintf(journal_dir, MAXPATHLEN, "/tmp/test_uploader.%d", (int)getpid());
+  if(mkdir(journal_dir, S_IRWXU) != 0)
+    {
+      LogTest("Test FAILED: can't create %s, errno=%d", journal_dir, errno);
+      exit(1);
+    }
+
+  /* Objects already in the bucket */
+  set_object(&server, "old/removed", "obsolete", 8);
+  set_object(&expected, "old/removed", "obsolete", 8);
+  memset(block, 'x', sizeof(block));
+  set_object(&server, "old/patched", block, sizeof(block));
+  set_object(&expected, "old/patched", block, sizeof(block));
+  set_object(&server, "old/rewritten", block, sizeof(block));
+  set_object(&expected, "old/rewritten", block, sizeof(block));
+
+  /* Segment 1: closed */
+  fd = open_segment(1);
+  for(i = 0; i < 10; i++)
+    {
+      memset(block, 'a' + i, sizeof(block));
+      journal_record(fd, NFS_JOURNAL_WRITE, "/dir/seq", i * sizeof(block), block,
+                     sizeof(block), FALSE);
+      journal_record(fd, NFS_JOURNAL_WRITE, "/dir/with space&more", (9 - i) * 100, block,
+                     100, FALSE);
+    }
+  journal_record(fd, NFS_JOURNAL_WRITE, "/dir/gone", 0, block, 10, FALSE);
+  journal_record(fd, NFS_JOURNAL_REMOVE, "/dir/gone", 0, NULL, 0, FALSE);
+  journal_record(fd, NFS_JOURNAL_REMOVE, "/old/removed", 0, NULL, 0, FALSE);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/old/patched", 500, "patch", 5, FALSE);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/old/patched", 2000, "grown", 5, FALSE);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/old/rewritten", 0, "short", 5, FALSE);
+  journal_record(fd, NFS_JOURNAL_REMOVE, "/dir/recreated", 0, NULL, 0, FALSE);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/dir/recreated", 3, "new", 3, FALSE);
+
+  big = malloc(5 * PART_SIZE + 123);
+  for(i = 0; i < 5 * PART_SIZE + 123; i++)
+    big[i] = (char)(i * 7);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/dir/big", 0, big, 5 * PART_SIZE + 123, FALSE);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/dir/big", PART_SIZE - 2, "over a part", 11, FALSE);
+  close(fd);
+
+  /* Segment 2: the current one, ending with a record being written */
+  fd = open_segment(2);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/dir/seq", 10 * sizeof(block), "tail", 4, FALSE);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/dir/current", 0, "incomplete", 10, TRUE);
+  close(fd);
+
+  /* The uploader */
+  memset(&param, 0, sizeof(param));
+  param.enable = TRUE;
+  strcpy(param.host, "127.0.0.1");
+  param.port = ntohs(addr.sin_port);
+  strcpy(param.bucket, BUCKET);
+  param.nb_connections = 4;
+  param.part_size = PART_SIZE;
+  param.max_retries = 5;
+  param.retry_delay = 0;
+  param.scan_period = 1;
+  param.timeout = 10;
+
+  if(nfs_uploader_init(&param, journal_dir, NULL) != 0 || nfs_uploader_start() != 0)
+    {
+      LogTest("Test FAILED: can't start the uploader");
+      exit(1);
+    }
+
+  if((rc = nfs_uploader_run()) != 31)
+    {
+      LogTest("Test FAILED: %d records uploaded instead of 31", rc);
+      exit(1);
+    }
+
+  check_store("First run");
+
+  if(segment_exists(1) || !segment_exists(2))
+    {
+      LogTest("Test FAILED: segment 1 should be removed, not segment 2");
+      exit(1);
+    }
+
+  if(nb_multipart != 1)
+    {
+      LogTest("Test FAILED: %u multipart uploads instead of 1", nb_multipart);
+      exit(1);
+    }
+
+  /* Nothing new */
+  if((rc = nfs_uploader_run()) != 0)
+    {
+      LogTest("Test FAILED: %d records uploaded again", rc);
+      exit(1);
+    }
+
+  /* The record being written is complete, and the segment is closed */
+  snprintf(path, MAXPATHLEN, NFS_JOURNAL_SEGMENT_FORMAT, journal_dir, 2);
+  truncate(path, 0);
+  fd = open_segment(2);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/dir/seq", 10 * sizeof(block), "tail", 4, FALSE);
+  journal_record(fd, NFS_JOURNAL_WRITE, "/dir/current", 0, "incomplete", 10, FALSE);
+  close(fd);
+  close(open_segment(3));
+
+  if((rc = nfs_uploader_run()) != 1)
+    {
+      LogTest("Test FAILED: %d records uploaded instead of 1", rc);
+      exit(1);
+    }
+
+  check_store("Second run");
+
+  snprintf(path, MAXPATHLEN, "%s/%s", journal_dir, NFS_UPLOADER_STATE_FILE);
+  if(segment_exists(2) || (file = fopen(path, "r")) == NULL
+     || fgets(state, sizeof(state), file) == NULL || strcmp(state, "3 0\n"))
+    {
+      LogTest("Test FAILED: segment 2 should be removed, and the state be \"3 0\"");
+      exit(1);
+    }
+  fclose(file);
+
+  nfs_uploader_get_stats(&stat);
+  LogTest("files=%llu puts=%llu parts=%llu deletes=%llu gets=%llu retries=%llu failures=%llu bytes=%llu",
+          stat.nb_files, stat.nb_puts, stat.nb_parts, stat.nb_deletes, stat.nb_gets,
+          stat.nb_retries, stat.nb_failures, stat.nb_bytes);
+
+  if(stat.nb_retries == 0 || stat.nb_failures != 0 || stat.nb_gets != 3)
+    {
+      LogTest("Test FAILED: expected some retries, no failure and 3 GETs");
+      exit(1);
+    }
+
+  /* Clean up */
+  unlink(path);
+  snprintf(path, MAXPATHLEN, NFS_JOURNAL_SEGMENT_FORMAT, journal_dir, 3);
+  unlink(path);
+  rmdir(journal_dir);
+
+  LogTest("Test OK");
+
+  return 0;
+}